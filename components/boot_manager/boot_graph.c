@@ -0,0 +1,112 @@
+#include "boot_graph.h"
+
+#include <string.h>
+
+static uint32_t boot_graph_all_mask(size_t stage_cnt)
+{
+    return stage_cnt >= 32 ? UINT32_MAX : BOOT_STAGE_BIT(stage_cnt) - 1;
+}
+
+/* Order the stages like they would be done. Fails if some can never be done. */
+static bool boot_graph_is_acyclic(const uint32_t *deps, size_t stage_cnt)
+{
+    uint32_t all = boot_graph_all_mask(stage_cnt);
+    uint32_t done = 0;
+    while (done != all) {
+        uint32_t done_prev = done;
+        for (size_t i = 0; i < stage_cnt; ++i) {
+            if ((deps[i] & ~done) == 0) {
+                done |= BOOT_STAGE_BIT(i);
+            }
+        }
+        if (done == done_prev) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool boot_graph_init(boot_graph_t *graph, const uint32_t *deps, size_t stage_cnt)
+{
+    if (!graph || !deps || stage_cnt == 0 || stage_cnt > BOOT_GRAPH_MAX_STAGES) {
+        return false;
+    }
+    uint32_t all = boot_graph_all_mask(stage_cnt);
+    for (size_t i = 0; i < stage_cnt; ++i) {
+        if ((deps[i] & ~all) || (deps[i] & BOOT_STAGE_BIT(i))) {
+            return false;
+        }
+    }
+    if (!boot_graph_is_acyclic(deps, stage_cnt)) {
+        return false;
+    }
+
+    memset(graph, 0, sizeof(*graph));
+    graph->deps = deps;
+    graph->stage_cnt = stage_cnt;
+    return true;
+}
+
+int boot_graph_take_ready(boot_graph_t *graph)
+{
+    for (size_t i = 0; i < graph->stage_cnt; ++i) {
+        uint32_t bit = BOOT_STAGE_BIT(i);
+        if (graph->started & bit) {
+            continue;
+        }
+        if (graph->deps[i] & graph->failed) {
+            /* Skip it and let the loop skip its dependents too */
+            graph->started |= bit;
+            graph->done |= bit;
+            graph->failed |= bit;
+            i = (size_t)-1;
+            continue;
+        }
+        if ((graph->deps[i] & ~graph->done) == 0) {
+            graph->started |= bit;
+            return (int)i;
+        }
+    }
+    return BOOT_GRAPH_NONE;
+}
+
+void boot_graph_set_done(boot_graph_t *graph, int stage, bool ok)
+{
+    uint32_t bit = BOOT_STAGE_BIT(stage);
+    graph->done |= bit;
+    if (!ok) {
+        graph->failed |= bit;
+    }
+}
+
+bool boot_graph_is_finished(const boot_graph_t *graph)
+{
+    return graph->done == boot_graph_all_mask(graph->stage_cnt);
+}
+
+uint32_t boot_graph_simulate(const uint32_t *deps, size_t stage_cnt, const uint32_t *duration,
+                             uint32_t *start, uint32_t *end)
+{
+    boot_graph_t graph;
+    if (!boot_graph_init(&graph, deps, stage_cnt)) {
+        return 0;
+    }
+
+    /* The stages are taken in dependency order, so the ends of the dependencies are known */
+    uint32_t last = 0;
+    int stage;
+    while ((stage = boot_graph_take_ready(&graph)) != BOOT_GRAPH_NONE) {
+        start[stage] = 0;
+        for (size_t i = 0; i < stage_cnt; ++i) {
+            if ((deps[stage] & BOOT_STAGE_BIT(i)) && end[i] > start[stage]) {
+                start[stage] = end[i];
+            }
+        }
+        end[stage] = start[stage] + duration[stage];
+        if (end[stage] > last) {
+            last = end[stage];
+        }
+        boot_graph_set_done(&graph, stage, true);
+    }
+    return last;
+}
@@ -0,0 +1,124 @@
+#include "boot_manager.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+static const char *TAG = "boot";
+
+typedef struct {
+    boot_manager_stage_t *stage;
+    int index;
+    QueueHandle_t done_queue;
+} boot_manager_job_t;
+
+static void boot_manager_stage_task(void *arg)
+{
+    boot_manager_job_t *job = (boot_manager_job_t *)arg;
+    boot_manager_stage_t *stage = job->stage;
+
+    stage->start_us = esp_timer_get_time();
+    stage->err = stage->fn ? stage->fn(stage->ctx) : ESP_OK;
+    stage->end_us = esp_timer_get_time();
+
+    xQueueSend(job->done_queue, &job->index, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t boot_manager_start_stage(boot_manager_job_t *job)
+{
+    uint32_t stack_size = job->stage->stack_size ? job->stage->stack_size : BOOT_MANAGER_DEFAULT_STACK_SIZE;
+    if (xTaskCreate(boot_manager_stage_task, job->stage->name, stack_size, job,
+                    uxTaskPriorityGet(NULL), NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t boot_manager_run(boot_manager_stage_t *stages, size_t stage_cnt)
+{
+    if (!stages || stage_cnt == 0 || stage_cnt > BOOT_GRAPH_MAX_STAGES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t deps[BOOT_GRAPH_MAX_STAGES];
+    for (size_t i = 0; i < stage_cnt; ++i) {
+        deps[i] = stages[i].deps;
+        stages[i].start_us = 0;
+        stages[i].end_us = 0;
+        stages[i].err = ESP_ERR_INVALID_STATE;
+    }
+
+    boot_graph_t graph;
+    if (!boot_graph_init(&graph, deps, stage_cnt)) {
+        ESP_LOGE(TAG, "Unknown or circular stage dependencies");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    QueueHandle_t done_queue = xQueueCreate(stage_cnt, sizeof(int));
+    if (!done_queue) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* The stage tasks use the jobs, this function returns only when all of them are done */
+    boot_manager_job_t jobs[BOOT_GRAPH_MAX_STAGES];
+    esp_err_t result = ESP_OK;
+    size_t running = 0;
+    while (!boot_graph_is_finished(&graph)) {
+        int ready;
+        while ((ready = boot_graph_take_ready(&graph)) != BOOT_GRAPH_NONE) {
+            jobs[ready].stage = &stages[ready];
+            jobs[ready].index = ready;
+            jobs[ready].done_queue = done_queue;
+            esp_err_t err = boot_manager_start_stage(&jobs[ready]);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Can't start stage %s", stages[ready].name);
+                stages[ready].err = err;
+                boot_graph_set_done(&graph, ready, false);
+                if (result == ESP_OK) {
+                    result = err;
+                }
+                continue;
+            }
+            running++;
+        }
+
+        if (running == 0) {
+            /* Only skipped stages were left */
+            continue;
+        }
+
+        int done;
+        xQueueReceive(done_queue, &done, portMAX_DELAY);
+        running--;
+        if (stages[done].err != ESP_OK) {
+            ESP_LOGE(TAG, "Stage %s failed: %s", stages[done].name, esp_err_to_name(stages[done].err));
+            if (result == ESP_OK) {
+                result = stages[done].err;
+            }
+        }
+        boot_graph_set_done(&graph, done, stages[done].err == ESP_OK);
+    }
+
+    vQueueDelete(done_queue);
+    boot_manager_log_timeline(stages, stage_cnt);
+    return result;
+}
+
+void boot_manager_log_timeline(const boot_manager_stage_t *stages, size_t stage_cnt)
+{
+    ESP_LOGI(TAG, "Boot timeline (ms since reset):");
+    for (size_t i = 0; i < stage_cnt; ++i) {
+        const boot_manager_stage_t *stage = &stages[i];
+        if (stage->start_us == 0) {
+            ESP_LOGW(TAG, "  %-12s skipped", stage->name);
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-12s %6lld .. %6lld (%lld ms)%s", stage->name,
+                 stage->start_us / 1000, stage->end_us / 1000,
+                 (stage->end_us - stage->start_us) / 1000,
+                 stage->err == ESP_OK ? "" : " failed");
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Dependency graph of the boot stages.
+ * Plain C without ESP-IDF dependencies, so the ordering can be built and
+ * checked on the host with simulated stage durations.
+ */
+
+#define BOOT_GRAPH_MAX_STAGES 32
+#define BOOT_GRAPH_NONE       (-1)
+
+/** Bit of stage `i` in a dependency mask */
+#define BOOT_STAGE_BIT(i) (1UL << (i))
+
+typedef struct {
+    const uint32_t *deps;   /*!< deps[i]: mask of the stages stage `i` waits for */
+    size_t stage_cnt;
+    uint32_t started;
+    uint32_t done;
+    uint32_t failed;        /*!< Failed stages and the stages skipped because of them */
+} boot_graph_t;
+
+/**
+ * @brief Set up a graph. Fails on unknown dependencies and dependency cycles.
+ */
+bool boot_graph_init(boot_graph_t *graph, const uint32_t *deps, size_t stage_cnt);
+
+/**
+ * @brief Return a stage whose dependencies are done and mark it started.
+ *
+ * Stages depending on a failed stage are not returned but marked done and failed.
+ *
+ * @return Index of the stage or BOOT_GRAPH_NONE if no stage is ready now.
+ */
+int boot_graph_take_ready(boot_graph_t *graph);
+
+/**
+ * @brief Mark a started stage as finished.
+ */
+void boot_graph_set_done(boot_graph_t *graph, int stage, bool ok);
+
+/**
+ * @brief Whether every stage has finished or was skipped.
+ */
+bool boot_graph_is_finished(const boot_graph_t *graph);
+
+/**
+ * @brief Compute when the stages would run if every ready stage started at once.
+ *
+ * @param duration Duration of each stage in any time unit.
+ * @param start    Start time of each stage.
+ * @param end      End time of each stage.
+ * @return End time of the last stage, or 0 if the graph is invalid.
+ */
+uint32_t boot_graph_simulate(const uint32_t *deps, size_t stage_cnt, const uint32_t *duration,
+                             uint32_t *start, uint32_t *end);
+
+#ifdef __cplusplus
+}
+#endif
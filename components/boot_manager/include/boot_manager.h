@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "boot_graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_MANAGER_DEFAULT_STACK_SIZE 4096
+
+typedef esp_err_t (*boot_manager_stage_fn_t)(void *ctx);
+
+typedef struct {
+    const char *name;
+    boot_manager_stage_fn_t fn;
+    void *ctx;
+    uint32_t deps;          /*!< BOOT_STAGE_BIT() of the stages to wait for */
+    uint32_t stack_size;    /*!< Stack of the stage's task, 0: BOOT_MANAGER_DEFAULT_STACK_SIZE */
+
+    /* Set by boot_manager_run() */
+    int64_t start_us;       /*!< Time since reset */
+    int64_t end_us;
+    esp_err_t err;          /*!< ESP_ERR_INVALID_STATE if skipped because a dependency failed */
+} boot_manager_stage_t;
+
+/**
+ * @brief Run the boot stages and log the boot timeline.
+ *
+ * Each stage runs in its own task as soon as the stages it depends on are done,
+ * so independent stages run in parallel. Stages depending on a failed stage are skipped.
+ * Returns when all stages are done.
+ *
+ * @return ESP_OK, or the error of the first failed stage.
+ */
+esp_err_t boot_manager_run(boot_manager_stage_t *stages, size_t stage_cnt);
+
+/**
+ * @brief Log when each stage started and ended.
+ */
+void boot_manager_log_timeline(const boot_manager_stage_t *stages, size_t stage_cnt);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,282 @@
+/* Boot graph ordering, parallel stages and failure propagation, on fixed and random graphs */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "boot_graph.h"
+
+#define BIT BOOT_STAGE_BIT
+
+enum { PANEL, LVGL, FIRST_FRAME, TOUCH, UI, NVS, WIFI, MQTT, STAGE_CNT };
+
+static uint32_t seed = 1;
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) | (seed << 16);
+}
+
+/* The boot of the example: display and network chains side by side */
+static void boot_deps(uint32_t deps[STAGE_CNT])
+{
+    memset(deps, 0, STAGE_CNT * sizeof(deps[0]));
+    deps[LVGL] = BIT(PANEL);
+    deps[FIRST_FRAME] = BIT(LVGL);
+    deps[UI] = BIT(FIRST_FRAME) | BIT(TOUCH);
+    deps[WIFI] = BIT(NVS);
+    deps[MQTT] = BIT(WIFI);
+}
+
+/* An acyclic graph with the stages in random order */
+static size_t random_deps(uint32_t deps[BOOT_GRAPH_MAX_STAGES])
+{
+    size_t cnt = 1 + rnd() % BOOT_GRAPH_MAX_STAGES;
+    int order[BOOT_GRAPH_MAX_STAGES];
+    for (size_t i = 0; i < cnt; ++i) {
+        order[i] = (int)i;
+    }
+    for (size_t i = cnt - 1; i > 0; --i) {
+        size_t j = rnd() % (i + 1);
+        int tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    uint32_t density = rnd() % 8;
+    for (size_t i = 0; i < cnt; ++i) {
+        deps[order[i]] = 0;
+        for (size_t j = 0; j < i; ++j) {
+            if (rnd() % 16 < density) {
+                deps[order[i]] |= BIT(order[j]);
+            }
+        }
+    }
+    return cnt;
+}
+
+/* Stages that wait for `stage`, directly or not */
+static uint32_t dependents(const uint32_t *deps, size_t cnt, int stage)
+{
+    uint32_t mask = BIT(stage);
+    uint32_t prev;
+    do {
+        prev = mask;
+        for (size_t i = 0; i < cnt; ++i) {
+            if (deps[i] & mask) {
+                mask |= BIT(i);
+            }
+        }
+    } while (mask != prev);
+    return mask & ~BIT(stage);
+}
+
+/* Longest path ending with `stage` */
+static uint32_t critical_end(const uint32_t *deps, size_t cnt, const uint32_t *duration, int stage)
+{
+    uint32_t start = 0;
+    for (size_t i = 0; i < cnt; ++i) {
+        if (deps[stage] & BIT(i)) {
+            uint32_t end = critical_end(deps, cnt, duration, (int)i);
+            start = end > start ? end : start;
+        }
+    }
+    return start + duration[stage];
+}
+
+static void test_init(void)
+{
+    boot_graph_t graph;
+    uint32_t deps[BOOT_GRAPH_MAX_STAGES + 1] = { 0 };
+    assert(!boot_graph_init(&graph, deps, 0));
+    assert(!boot_graph_init(&graph, deps, BOOT_GRAPH_MAX_STAGES + 1));
+    assert(!boot_graph_init(NULL, deps, 1));
+    assert(!boot_graph_init(&graph, NULL, 1));
+
+    /* Unknown stage, itself, cycles */
+    deps[0] = BIT(2);
+    assert(!boot_graph_init(&graph, deps, 2));
+    deps[0] = BIT(0);
+    assert(!boot_graph_init(&graph, deps, 2));
+    deps[0] = BIT(1);
+    deps[1] = BIT(0);
+    assert(!boot_graph_init(&graph, deps, 2));
+    deps[0] = 0;
+    deps[1] = BIT(2);
+    deps[2] = BIT(3);
+    deps[3] = BIT(1);
+    assert(!boot_graph_init(&graph, deps, 4));
+
+    /* The longest chain: every stage after the one before */
+    for (int i = 0; i < BOOT_GRAPH_MAX_STAGES; ++i) {
+        deps[i] = i ? BIT(i - 1) : 0;
+    }
+    assert(boot_graph_init(&graph, deps, BOOT_GRAPH_MAX_STAGES));
+    for (int i = 0; i < BOOT_GRAPH_MAX_STAGES; ++i) {
+        assert(!boot_graph_is_finished(&graph));
+        assert(boot_graph_take_ready(&graph) == i);
+        assert(boot_graph_take_ready(&graph) == BOOT_GRAPH_NONE);
+        boot_graph_set_done(&graph, i, true);
+    }
+    assert(boot_graph_is_finished(&graph) && graph.failed == 0);
+}
+
+static void test_ordering(void)
+{
+    boot_graph_t graph;
+    /* Random graphs, stages finishing in random order: a stage starts only after its dependencies */
+    for (int round = 0; round < 2000; ++round) {
+        uint32_t rdeps[BOOT_GRAPH_MAX_STAGES];
+        size_t cnt = random_deps(rdeps);
+        assert(boot_graph_init(&graph, rdeps, cnt));
+        int running[BOOT_GRAPH_MAX_STAGES];
+        int running_cnt = 0;
+        uint32_t taken = 0;
+        while (!boot_graph_is_finished(&graph)) {
+            int stage;
+            while ((stage = boot_graph_take_ready(&graph)) != BOOT_GRAPH_NONE) {
+                assert((size_t)stage < cnt && !(taken & BIT(stage)));
+                assert((rdeps[stage] & ~graph.done) == 0);
+                taken |= BIT(stage);
+                running[running_cnt++] = stage;
+            }
+            /* Never stuck while the graph is unfinished */
+            assert(running_cnt > 0);
+            int i = (int)(rnd() % (uint32_t)running_cnt);
+            boot_graph_set_done(&graph, running[i], true);
+            running[i] = running[--running_cnt];
+        }
+        assert(running_cnt == 0 && taken == graph.done && graph.failed == 0);
+        assert(boot_graph_take_ready(&graph) == BOOT_GRAPH_NONE);
+    }
+}
+
+static void test_parallel(void)
+{
+    uint32_t deps[STAGE_CNT];
+    boot_deps(deps);
+    boot_graph_t graph;
+    assert(boot_graph_init(&graph, deps, STAGE_CNT));
+
+    /* The stages without dependencies start together */
+    uint32_t ready = 0;
+    int stage;
+    while ((stage = boot_graph_take_ready(&graph)) != BOOT_GRAPH_NONE) {
+        ready |= BIT(stage);
+    }
+    assert(ready == (BIT(PANEL) | BIT(TOUCH) | BIT(NVS)));
+    /* The display chain does not wait for the network */
+    boot_graph_set_done(&graph, PANEL, true);
+    assert(boot_graph_take_ready(&graph) == LVGL);
+    assert(boot_graph_take_ready(&graph) == BOOT_GRAPH_NONE);
+    boot_graph_set_done(&graph, NVS, true);
+    assert(boot_graph_take_ready(&graph) == WIFI);
+
+    /* The first frame after panel and LVGL, the end after the network chain */
+    uint32_t duration[STAGE_CNT] = {
+        [PANEL] = 150, [LVGL] = 20, [FIRST_FRAME] = 30, [TOUCH] = 15,
+        [UI] = 200, [NVS] = 40, [WIFI] = 300, [MQTT] = 50,
+    };
+    uint32_t start[STAGE_CNT];
+    uint32_t end[STAGE_CNT];
+    assert(boot_graph_simulate(deps, STAGE_CNT, duration, start, end) == 400);
+    assert(end[FIRST_FRAME] == 200);
+    assert(start[UI] == 200 && start[WIFI] == 40 && start[TOUCH] == 0);
+    uint32_t cycle[2] = { BIT(1), BIT(0) };
+    assert(boot_graph_simulate(cycle, 2, duration, start, end) == 0);
+
+    /* Random graphs: every stage starts when its last dependency ends */
+    for (int round = 0; round < 2000; ++round) {
+        uint32_t rdeps[BOOT_GRAPH_MAX_STAGES];
+        uint32_t rduration[BOOT_GRAPH_MAX_STAGES];
+        uint32_t rstart[BOOT_GRAPH_MAX_STAGES];
+        uint32_t rend[BOOT_GRAPH_MAX_STAGES];
+        size_t cnt = random_deps(rdeps);
+        for (size_t i = 0; i < cnt; ++i) {
+            rduration[i] = 1 + rnd() % 1000;
+        }
+        uint32_t last = boot_graph_simulate(rdeps, cnt, rduration, rstart, rend);
+        uint32_t expected_last = 0;
+        for (size_t i = 0; i < cnt; ++i) {
+            uint32_t expected_start = 0;
+            for (size_t j = 0; j < cnt; ++j) {
+                if ((rdeps[i] & BIT(j)) && rend[j] > expected_start) {
+                    expected_start = rend[j];
+                }
+            }
+            assert(rstart[i] == expected_start && rend[i] == rstart[i] + rduration[i]);
+            assert(rend[i] == critical_end(rdeps, cnt, rduration, (int)i));
+            expected_last = rend[i] > expected_last ? rend[i] : expected_last;
+        }
+        assert(last == expected_last);
+    }
+}
+
+static void test_failure(void)
+{
+    uint32_t deps[STAGE_CNT];
+    boot_deps(deps);
+    boot_graph_t graph;
+    assert(boot_graph_init(&graph, deps, STAGE_CNT));
+
+    /* No network: the display still comes up */
+    int stage;
+    while ((stage = boot_graph_take_ready(&graph)) != BOOT_GRAPH_NONE) {
+        boot_graph_set_done(&graph, stage, stage != NVS);
+    }
+    while ((stage = boot_graph_take_ready(&graph)) != BOOT_GRAPH_NONE) {
+        boot_graph_set_done(&graph, stage, true);
+    }
+    assert(boot_graph_is_finished(&graph));
+    assert(graph.failed == (BIT(NVS) | BIT(WIFI) | BIT(MQTT)));
+
+    /* Random graphs and failures: the dependents of a failed stage are skipped, the others run */
+    for (int round = 0; round < 2000; ++round) {
+        uint32_t rdeps[BOOT_GRAPH_MAX_STAGES];
+        size_t cnt = random_deps(rdeps);
+        assert(boot_graph_init(&graph, rdeps, cnt));
+        uint32_t fail = 0;
+        for (uint32_t n = rnd() % 3; n > 0; --n) {
+            fail |= BIT(rnd() % cnt);
+        }
+        uint32_t skipped = 0;
+        for (size_t i = 0; i < cnt; ++i) {
+            if (fail & BIT(i)) {
+                skipped |= dependents(rdeps, cnt, (int)i);
+            }
+        }
+
+        int running[BOOT_GRAPH_MAX_STAGES];
+        int running_cnt = 0;
+        uint32_t taken = 0;
+        while (!boot_graph_is_finished(&graph)) {
+            while ((stage = boot_graph_take_ready(&graph)) != BOOT_GRAPH_NONE) {
+                assert(!(skipped & BIT(stage)));
+                taken |= BIT(stage);
+                running[running_cnt++] = stage;
+            }
+            if (running_cnt == 0) {
+                /* Only skipped stages were left, all skipped at once */
+                assert(boot_graph_is_finished(&graph));
+                break;
+            }
+            int i = (int)(rnd() % (uint32_t)running_cnt);
+            boot_graph_set_done(&graph, running[i], !(fail & BIT(running[i])));
+            running[i] = running[--running_cnt];
+        }
+        uint32_t all = cnt == 32 ? UINT32_MAX : BIT(cnt) - 1;
+        assert(taken == (all & ~skipped));
+        assert(graph.failed == ((fail & taken) | skipped));
+    }
+}
+
+int main(void)
+{
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+    RUN(test_init);
+    RUN(test_ordering);
+    RUN(test_parallel);
+    RUN(test_failure);
+    return 0;
+}
@@ -294,6 +294,26 @@
 /*1: Draw random colored rectangles over the redrawn areas*/
 #define LV_USE_REFR_DEBUG 0
 
+/*1: Keep a grid of the children's coordinates in objects with many children.
+ *It speeds up finding the clicked object and the top object to redraw on crowded screens*/
+#define LV_USE_OBJ_SPATIAL_INDEX 0
+#if LV_USE_OBJ_SPATIAL_INDEX
+    /*Index the children only if an object has at least this many of them*/
+    #define LV_OBJ_SPATIAL_INDEX_MIN_CHILDREN 16
+#endif
+
+/*Number of children stored in the object itself before allocating an array for them.
+ *Saves an allocation for objects with only a few children*/
+#define LV_OBJ_CHILD_INLINE_CNT 0
+
+/*>0: Cache the files of the drivers with `cache_size > 0` in blocks shared by all open files
+ *instead of a single `cache_size` buffer for each file. The size of the cache in bytes*/
+#define LV_FS_CACHE_SIZE 0
+#if LV_FS_CACHE_SIZE
+    #define LV_FS_CACHE_BLOCK_SIZE 1024 /*Size of a block in bytes*/
+    #define LV_FS_CACHE_READ_AHEAD 4    /*Number of blocks to read at once if a file is read sequentially*/
+#endif
+
 /*Change the built in (v)snprintf functions*/
 #define LV_SPRINTF_CUSTOM 0
 #if LV_SPRINTF_CUSTOM
@@ -622,6 +642,7 @@
     #define LV_FS_POSIX_LETTER '\0'     /*Set an upper cased letter on which the drive will accessible (e.g. 'A')*/
     #define LV_FS_POSIX_PATH ""         /*Set the working directory. File/directory paths will be appended to it.*/
     #define LV_FS_POSIX_CACHE_SIZE 0    /*>0 to cache this number of bytes in lv_fs_read()*/
+    #define LV_FS_POSIX_MMAP 0          /*1: Map the files opened for reading into memory with mmap() and read them without copying*/
 #endif
 
 /*API for CreateFile, ReadFile, etc*/
@@ -648,13 +669,30 @@
 
 /*PNG decoder library*/
 #define LV_USE_PNG 0
+#if LV_USE_PNG
+    /*Decode non-interlaced images line by line with max. 32 kB + 2 lines of RAM instead of the whole image.
+     *Such images can't be rotated or zoomed.*/
+    #define LV_PNG_STREAM 0
+#endif
 
 /*BMP decoder library*/
 #define LV_USE_BMP 0
 
+/*Decoder of RLE compressed C array images (see scripts/img_to_rle.py)*/
+#define LV_USE_RLE 0
+
 /* JPG + split JPG decoder library.
  * Split JPG is a custom format optimized for embedded systems. */
 #define LV_USE_SJPG 0
+#if LV_USE_SJPG
+    /*Memory for the decoded fragments shared by all JPG and SJPG images [bytes].
+     *The least recently used fragments are freed when it's full. 0: keep only the last fragment of each opened image*/
+    #define LV_SJPG_CACHE_SIZE 0
+    /*1: decode the next fragment of SJPG images when LVGL is idle if the cache has free memory*/
+    #define LV_SJPG_PREFETCH 0
+    /*0: basic decoder for 8/16-bit MCUs; 1: use 32-bit shifts; 2: + table based Huffman decoding (+6 kB RAM)*/
+    #define LV_SJPG_FAST_DECODE 0
+#endif
 
 /*GIF decoder library*/
 #define LV_USE_GIF 0
@@ -684,6 +722,11 @@
 #if LV_USE_TINY_TTF
     /*Load TTF data from files*/
     #define LV_TINY_TTF_FILE_SUPPORT 0
+    /*Memory for the glyph atlas shared by all fonts and sizes [bytes].
+     *It caches the bitmaps, metrics and kerning of the glyphs. 0: each font has its own bitmap cache*/
+    #define LV_TINY_TTF_ATLAS_SIZE 0
+    /*The atlas is split into pages of this size [bytes]. The least recently used page is evicted when it's full*/
+    #define LV_TINY_TTF_ATLAS_PAGE_SIZE 8192
 #endif
 
 /*Rlottie library*/
@@ -710,6 +753,9 @@
 /*1: Enable grid navigation*/
 #define LV_USE_GRIDNAV 0
 
+/*1: Enable moving between screens by dragging them with a pointer*/
+#define LV_USE_PAGER 0
+
 /*1: Enable lv_obj fragment*/
 #define LV_USE_FRAGMENT 0
 
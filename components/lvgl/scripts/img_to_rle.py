@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+##################################################################
+# RLE image converter script version 1.0
+# Converts an image file or an uncompressed LVGL C array image
+# to a run-length encoded C array drawn by the `lv_rle` decoder
+# (LV_USE_RLE). See `src/extra/libs/rle/lv_rle.h` for the format.
+# Dependencies: (PYTHON-3), Pillow for image files
+##################################################################
+import argparse
+import os
+import re
+import struct
+import sys
+
+RLE_MAGIC = b"LVRL"
+RLE_FLAG_16_SWAP = 0x01
+RLE_MAX_CNT = 128
+
+# Values of `lv_img_cf_t`
+CF = {
+    "LV_IMG_CF_TRUE_COLOR": 4,
+    "LV_IMG_CF_TRUE_COLOR_ALPHA": 5,
+    "LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED": 6,
+    "LV_IMG_CF_ALPHA_8BIT": 14,
+}
+
+
+def px_size(cf, depth):
+    if cf == CF["LV_IMG_CF_ALPHA_8BIT"]:
+        return 1
+    size = max(depth, 8) // 8
+    if cf == CF["LV_IMG_CF_TRUE_COLOR_ALPHA"]:
+        size = 4 if depth == 32 else size + 1
+    return size
+
+
+def encode_line(line, size):
+    """Encode the pixels of a line into run and literal packets"""
+    px = [line[i:i + size] for i in range(0, len(line), size)]
+    out = bytearray()
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:RLE_MAX_CNT]
+            del literal[:RLE_MAX_CNT]
+            out.append(len(chunk) - 1)
+            for p in chunk:
+                out.extend(p)
+
+    i = 0
+    while i < len(px):
+        j = i + 1
+        while j < len(px) and j - i < RLE_MAX_CNT and px[j] == px[i]:
+            j += 1
+        if j - i >= 2:
+            flush_literal()
+            out.append(0x80 | (j - i - 1))
+            out += px[i]
+        else:
+            literal.append(px[i])
+        i = j
+
+    flush_literal()
+    return out
+
+
+def decode_line(data, size, w):
+    out = bytearray()
+    i = 0
+    while len(out) < w * size:
+        c = data[i]
+        cnt = (c & 0x7F) + 1
+        if c & 0x80:
+            out += data[i + 1:i + 1 + size] * cnt
+            i += 1 + size
+        else:
+            out += data[i + 1:i + 1 + cnt * size]
+            i += 1 + cnt * size
+    return out
+
+
+def encode(raw, w, h, cf, depth, swap):
+    size = px_size(cf, depth)
+    if len(raw) != w * h * size:
+        sys.exit("The data size (%d) doesn't match %dx%d pixels of %d bytes" % (len(raw), w, h, size))
+
+    lines = bytearray()
+    table = bytearray()
+    for y in range(h):
+        line = raw[y * w * size:(y + 1) * w * size]
+        enc = encode_line(line, size)
+        assert decode_line(enc, size, w) == line
+        table += struct.pack("<I", len(lines))
+        lines += enc
+
+    flags = RLE_FLAG_16_SWAP if depth == 16 and swap else 0
+    header = RLE_MAGIC + struct.pack("<BBBBI", cf, depth, flags, 0, len(raw))
+    return header + table + lines
+
+
+def read_c_array(path):
+    """Read the size, color format and data of an uncompressed LVGL C array image"""
+    src = open(path).read()
+    try:
+        w = int(re.search(r"\.header\.w\s*=\s*(\d+)", src).group(1))
+        h = int(re.search(r"\.header\.h\s*=\s*(\d+)", src).group(1))
+        cf_name = re.search(r"\.header\.cf\s*=\s*(LV_IMG_CF_\w+)", src).group(1)
+        name = re.search(r"const\s+lv_img_dsc_t\s+(\w+)", src).group(1)
+        body = re.search(r"uint8_t\s+\w+\[\]\s*=\s*\{(.*?)\};", src, re.S).group(1)
+    except AttributeError:
+        sys.exit("%s is not an LVGL C array image" % path)
+
+    if cf_name not in CF:
+        sys.exit("Unsupported color format: " + cf_name)
+    includes = re.findall(r"^#include\s+.*$", src, re.M)
+    raw = bytes(int(x, 16) for x in re.findall(r"0x([0-9a-fA-F]{2})", body))
+    return raw, w, h, CF[cf_name], name, includes
+
+
+def read_image(path, cf, depth, swap):
+    """Read an image file and convert its pixels to LVGL's format"""
+    from PIL import Image
+
+    im = Image.open(path).convert("RGBA")
+    w, h = im.size
+    raw = bytearray()
+    for r, g, b, a in im.getdata():
+        if cf == CF["LV_IMG_CF_ALPHA_8BIT"]:
+            raw.append(a)
+            continue
+
+        if depth == 32:
+            raw += bytes((b, g, r, 0xff))
+        elif depth == 16:
+            c = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+            raw += struct.pack(">H" if swap else "<H", c)
+        elif depth == 8:
+            raw.append((r & 0xe0) | ((g >> 3) & 0x1c) | (b >> 6))
+        else:
+            sys.exit("Unsupported color depth: %d" % depth)
+
+        if cf == CF["LV_IMG_CF_TRUE_COLOR_ALPHA"]:
+            if depth == 32:
+                raw[-1] = a
+            else:
+                raw.append(a)
+
+    name = os.path.splitext(os.path.basename(path))[0]
+    return bytes(raw), w, h, name
+
+
+def write_c_array(path, data, w, h, cf, name, includes, comment):
+    out = "// " + comment + "\n"
+    out += "\n".join(includes) + "\n\n"
+    out += "#ifndef LV_ATTRIBUTE_MEM_ALIGN\n#define LV_ATTRIBUTE_MEM_ALIGN\n#endif\n\n"
+    out += "const LV_ATTRIBUTE_MEM_ALIGN uint8_t " + name + "_data[] = {\n"
+    for i in range(0, len(data), 16):
+        out += "    " + ",".join("0x%02x" % b for b in data[i:i + 16]) + ",\n"
+    out += "};\n\n"
+    out += "const lv_img_dsc_t " + name + " = {\n"
+    out += "    .header.always_zero = 0,\n"
+    out += "    .header.w = %d,\n" % w
+    out += "    .header.h = %d,\n" % h
+    out += "    .data_size = sizeof(" + name + "_data),\n"
+    alpha = cf in (CF["LV_IMG_CF_TRUE_COLOR_ALPHA"], CF["LV_IMG_CF_ALPHA_8BIT"])
+    out += "    .header.cf = " + ("LV_IMG_CF_RAW_ALPHA" if alpha else "LV_IMG_CF_RAW") + ",\n"
+    out += "    .data = " + name + "_data\n"
+    out += "};\n"
+    open(path, "w").write(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert an image to an RLE compressed LVGL C array")
+    parser.add_argument("input", help="an image file (e.g. PNG) or an uncompressed LVGL C array (.c)")
+    parser.add_argument("-o", "--output", help="the C file to write (default: <name>_rle.c)")
+    parser.add_argument("--name", help="name of the lv_img_dsc_t variable (default: from the input)")
+    parser.add_argument("--color-depth", type=int, default=16, choices=(8, 16, 32),
+                        help="LV_COLOR_DEPTH of the pixels (default: 16)")
+    parser.add_argument("--swap", action="store_true", help="the pixels are for LV_COLOR_16_SWAP")
+    parser.add_argument("--cf", default="LV_IMG_CF_TRUE_COLOR_ALPHA", choices=sorted(CF),
+                        help="color format of image files (default: LV_IMG_CF_TRUE_COLOR_ALPHA)")
+    parser.add_argument("--include", action="append",
+                        help="header to include in the C file (default: lvgl.h or the includes of the C array)")
+    args = parser.parse_args()
+
+    if args.input.endswith(".c"):
+        raw, w, h, cf, name, includes = read_c_array(args.input)
+    else:
+        cf = CF[args.cf]
+        raw, w, h, name = read_image(args.input, cf, args.color_depth, args.swap)
+        includes = ['#include "lvgl.h"']
+
+    if args.name:
+        name = args.name
+    if args.include:
+        includes = ['#include "%s"' % i for i in args.include]
+    output = args.output or name + "_rle.c"
+
+    data = encode(raw, w, h, cf, args.color_depth, args.swap)
+    comment = "RLE compressed %dx%d image converted by lvgl/scripts/img_to_rle.py: %d bytes instead of %d" % \
+              (w, h, len(data), len(raw))
+    write_c_array(output, data, w, h, cf, name, includes, comment)
+
+    print("%s: %dx%d, %d -> %d bytes (%.1f%%), %d bytes saved" %
+          (output, w, h, len(raw), len(data), 100.0 * len(data) / len(raw), len(raw) - len(data)))
+
+
+if __name__ == "__main__":
+    main()
@@ -7,6 +7,7 @@ CSRCS += lv_obj_class.c
 CSRCS += lv_obj_draw.c
 CSRCS += lv_obj_pos.c
 CSRCS += lv_obj_scroll.c
+CSRCS += lv_obj_spatial_index.c
 CSRCS += lv_obj_style.c
 CSRCS += lv_obj_style_gen.c
 CSRCS += lv_obj_tree.c
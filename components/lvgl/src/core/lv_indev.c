@@ -312,6 +312,16 @@ lv_obj_t * lv_indev_search_obj(lv_obj_t * obj, lv_point_t * point)
     /*If the point is on this object or has overflow visible check its children too*/
     if(_lv_area_is_point_on(&obj->coords, &p_trans, 0) || lv_obj_has_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE)) {
         int32_t i;
+#if LV_USE_OBJ_SPATIAL_INDEX
+        /*Check only the children around the point*/
+        _lv_obj_spatial_iter_t iter;
+        _lv_obj_spatial_iter_init(obj, &p_trans, &iter);
+        while((i = _lv_obj_spatial_iter_next(&iter)) >= 0) {
+            lv_obj_t * child = obj->spec_attr->children[i];
+            found_p = lv_indev_search_obj(child, &p_trans);
+            if(found_p) return found_p;
+        }
+#else
         uint32_t child_cnt = lv_obj_get_child_cnt(obj);
 
         /*If a child matches use it*/
@@ -320,6 +330,7 @@ lv_obj_t * lv_indev_search_obj(lv_obj_t * obj, lv_point_t * point)
             found_p = lv_indev_search_obj(child, &p_trans);
             if(found_p) return found_p;
         }
+#endif
     }
 
     /*If not return earlier for a clicked child and this obj's hittest was ok use it
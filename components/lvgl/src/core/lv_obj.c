@@ -237,6 +237,10 @@ void lv_obj_add_flag(lv_obj_t * obj, lv_obj_flag_t f)
 
     obj->flags |= f;
 
+#if LV_USE_OBJ_SPATIAL_INDEX
+    if(f & LV_OBJ_FLAG_OVERFLOW_VISIBLE) _lv_obj_spatial_index_update_child(obj);
+#endif
+
     if(f & LV_OBJ_FLAG_HIDDEN) {
         if(lv_obj_has_state(obj, LV_STATE_FOCUSED)) {
             lv_group_t * group = lv_obj_get_group(obj);
@@ -277,6 +281,10 @@ void lv_obj_clear_flag(lv_obj_t * obj, lv_obj_flag_t f)
 
     obj->flags &= (~f);
 
+#if LV_USE_OBJ_SPATIAL_INDEX
+    if(f & LV_OBJ_FLAG_OVERFLOW_VISIBLE) _lv_obj_spatial_index_update_child(obj);
+#endif
+
     if(f & LV_OBJ_FLAG_HIDDEN) {
         lv_obj_invalidate(obj);
         if(lv_obj_is_layout_positioned(obj)) {
@@ -466,14 +474,14 @@ static void lv_obj_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
     if(group) lv_group_remove_obj(obj);
 
     if(obj->spec_attr) {
-        if(obj->spec_attr->children) {
-            lv_mem_free(obj->spec_attr->children);
-            obj->spec_attr->children = NULL;
-        }
+        _lv_obj_child_array_free(obj);
         if(obj->spec_attr->event_dsc) {
             lv_mem_free(obj->spec_attr->event_dsc);
             obj->spec_attr->event_dsc = NULL;
         }
+#if LV_USE_OBJ_SPATIAL_INDEX
+        _lv_obj_spatial_index_free(obj);
+#endif
 
         lv_mem_free(obj->spec_attr);
         obj->spec_attr = NULL;
@@ -142,6 +142,7 @@ typedef enum {
 #include "lv_obj_class.h"
 #include "lv_event.h"
 #include "lv_group.h"
+#include "lv_obj_spatial_index.h"
 
 /**
  * Make the base object's class publicly available.
@@ -155,9 +156,16 @@ extern const lv_obj_class_t lv_obj_class;
 typedef struct {
     struct _lv_obj_t ** children;       /**< Store the pointer of the children in an array.*/
     uint32_t child_cnt;                 /**< Number of children*/
+    uint32_t child_cap;                 /**< Number of children `children` has room for*/
+#if LV_OBJ_CHILD_INLINE_CNT
+    struct _lv_obj_t * child_inline[LV_OBJ_CHILD_INLINE_CNT]; /**< `children` points here if there are only a few*/
+#endif
     lv_group_t * group_p;
 
     struct _lv_event_dsc_t * event_dsc; /**< Dynamically allocated event callback and user data array*/
+#if LV_USE_OBJ_SPATIAL_INDEX
+    struct _lv_obj_spatial_index_t * spatial_index; /**< Grid of the children's coordinates*/
+#endif
     lv_point_t scroll;                  /**< The current X/Y scroll offset*/
 
     lv_coord_t ext_click_pad;           /**< Extra click padding in all direction*/
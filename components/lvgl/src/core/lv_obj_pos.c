@@ -191,6 +191,10 @@ bool lv_obj_refr_size(lv_obj_t * obj)
         obj->coords.x2 = obj->coords.x1 + w - 1;
     }
 
+#if LV_USE_OBJ_SPATIAL_INDEX
+    _lv_obj_spatial_index_update_child(obj);
+#endif
+
     /*Call the ancestor's event handler to the object with its new coordinates*/
     lv_event_send(obj, LV_EVENT_SIZE_CHANGED, &ori);
 
@@ -765,6 +769,10 @@ void lv_obj_move_to(lv_obj_t * obj, lv_coord_t x, lv_coord_t y)
 
     lv_obj_move_children_by(obj, diff.x, diff.y, false);
 
+#if LV_USE_OBJ_SPATIAL_INDEX
+    _lv_obj_spatial_index_update_child(obj);
+#endif
+
     /*Call the ancestor's event handler to the parent too*/
     if(parent) lv_event_send(parent, LV_EVENT_CHILD_CHANGED, obj);
 
@@ -781,11 +789,21 @@ void lv_obj_move_to(lv_obj_t * obj, lv_coord_t x, lv_coord_t y)
 
 void lv_obj_move_children_by(lv_obj_t * obj, lv_coord_t x_diff, lv_coord_t y_diff, bool ignore_floating)
 {
+#if LV_USE_OBJ_SPATIAL_INDEX
+    _lv_obj_spatial_index_move(obj, x_diff, y_diff);
+#endif
+
     uint32_t i;
     uint32_t child_cnt = lv_obj_get_child_cnt(obj);
     for(i = 0; i < child_cnt; i++) {
         lv_obj_t * child = obj->spec_attr->children[i];
-        if(ignore_floating && lv_obj_has_flag(child, LV_OBJ_FLAG_FLOATING)) continue;
+        if(ignore_floating && lv_obj_has_flag(child, LV_OBJ_FLAG_FLOATING)) {
+#if LV_USE_OBJ_SPATIAL_INDEX
+            /*The floating children stayed in place while the index was moved*/
+            _lv_obj_spatial_index_update_child(child);
+#endif
+            continue;
+        }
         child->coords.x1 += x_diff;
         child->coords.y1 += y_diff;
         child->coords.x2 += x_diff;
@@ -937,6 +955,10 @@ void lv_obj_set_ext_click_area(lv_obj_t * obj, lv_coord_t size)
 
     lv_obj_allocate_spec_attr(obj);
     obj->spec_attr->ext_click_pad = size;
+
+#if LV_USE_OBJ_SPATIAL_INDEX
+    _lv_obj_spatial_index_update_child(obj);
+#endif
 }
 
 void lv_obj_get_click_area(const lv_obj_t * obj, lv_area_t * area)
@@ -0,0 +1,449 @@
+/**
+ * @file lv_obj_spatial_index.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_obj.h"
+
+#if LV_USE_OBJ_SPATIAL_INDEX
+
+#include "../misc/lv_mem.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Aim for this many children in a grid cell*/
+#define CHILDREN_PER_CELL   4
+#define MAX_CELL_CNT        1024
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint32_t * ids;     /*Child indices in ascending order*/
+    uint32_t cnt;
+    uint32_t cap;
+} cell_t;
+
+typedef struct _lv_obj_spatial_index_t {
+    lv_area_t bounds;       /*Area covered by the grid. Children outside of it go to the edge cells*/
+    lv_point_t ofs;         /*Common movement of the children since the index was built*/
+    lv_coord_t cell_w;
+    lv_coord_t cell_h;
+    uint16_t col_cnt;
+    uint16_t row_cnt;
+    cell_t * cells;
+    lv_area_t * areas;      /*The indexed area of each child, relative to `ofs`*/
+    uint32_t * any_ids;     /*Children which can be hit outside of their area (ascending)*/
+    uint32_t any_cnt;
+    uint32_t child_cnt;     /*Number of children when the index was built*/
+    uint8_t dirty : 1;
+} _lv_obj_spatial_index_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static _lv_obj_spatial_index_t * get_index(lv_obj_t * obj);
+static bool index_build(lv_obj_t * obj, _lv_obj_spatial_index_t * idx);
+static void index_clear(_lv_obj_spatial_index_t * idx);
+static bool get_child_area(lv_obj_t * child, lv_area_t * area);
+static void get_cell_range(const _lv_obj_spatial_index_t * idx, const lv_area_t * area,
+                           uint32_t * c1, uint32_t * r1, uint32_t * c2, uint32_t * r2);
+static uint32_t find_pos(const uint32_t * ids, uint32_t cnt, uint32_t id);
+static bool cell_insert(cell_t * cell, uint32_t id);
+static void cell_remove(cell_t * cell, uint32_t id);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void _lv_obj_spatial_iter_init(lv_obj_t * obj, const lv_point_t * point, _lv_obj_spatial_iter_t * iter)
+{
+    lv_memset_00(iter, sizeof(_lv_obj_spatial_iter_t));
+
+    _lv_obj_spatial_index_t * idx = get_index(obj);
+    if(idx == NULL) {
+        iter->all_cnt = lv_obj_get_child_cnt(obj);
+        return;
+    }
+
+    lv_area_t p_area;
+    p_area.x1 = point->x - idx->ofs.x;
+    p_area.y1 = point->y - idx->ofs.y;
+    p_area.x2 = p_area.x1;
+    p_area.y2 = p_area.y1;
+
+    uint32_t c1, r1, c2, r2;
+    get_cell_range(idx, &p_area, &c1, &r1, &c2, &r2);
+    cell_t * cell = &idx->cells[r1 * idx->col_cnt + c1];
+    iter->cell_ids = cell->ids;
+    iter->cell_cnt = cell->cnt;
+    iter->any_ids = idx->any_ids;
+    iter->any_cnt = idx->any_cnt;
+}
+
+int32_t _lv_obj_spatial_iter_next(_lv_obj_spatial_iter_t * iter)
+{
+    if(iter->all_cnt > 0) {
+        iter->all_cnt--;
+        return (int32_t)iter->all_cnt;
+    }
+
+    if(iter->cell_cnt == 0 && iter->any_cnt == 0) return -1;
+
+    /*Merge the two ascending lists from their ends to get the top children first*/
+    if(iter->any_cnt == 0 ||
+       (iter->cell_cnt > 0 && iter->cell_ids[iter->cell_cnt - 1] > iter->any_ids[iter->any_cnt - 1])) {
+        iter->cell_cnt--;
+        return (int32_t)iter->cell_ids[iter->cell_cnt];
+    }
+    else {
+        iter->any_cnt--;
+        return (int32_t)iter->any_ids[iter->any_cnt];
+    }
+}
+
+void _lv_obj_spatial_index_invalidate(lv_obj_t * obj)
+{
+    if(obj == NULL || obj->spec_attr == NULL) return;
+    if(obj->spec_attr->spatial_index == NULL) return;
+
+    obj->spec_attr->spatial_index->dirty = 1;
+}
+
+void _lv_obj_spatial_index_update_child(lv_obj_t * child)
+{
+    lv_obj_t * parent = child->parent;
+    if(parent == NULL || parent->spec_attr == NULL) return;
+
+    _lv_obj_spatial_index_t * idx = parent->spec_attr->spatial_index;
+    if(idx == NULL || idx->dirty) return;
+
+    uint32_t id = lv_obj_get_index(child);
+    if(id >= idx->child_cnt) {
+        idx->dirty = 1;
+        return;
+    }
+
+    uint32_t any_pos = find_pos(idx->any_ids, idx->any_cnt, id);
+    bool was_any = any_pos < idx->any_cnt && idx->any_ids[any_pos] == id;
+
+    lv_area_t area;
+    bool bounded = get_child_area(child, &area);
+
+    /*Moving between the grid and the "any" list is rare, simply rebuild*/
+    if(bounded == was_any) {
+        idx->dirty = 1;
+        return;
+    }
+    if(!bounded) return;
+
+    lv_area_move(&area, -idx->ofs.x, -idx->ofs.y);
+
+    lv_area_t * area_old = &idx->areas[id];
+    uint32_t c1_old, r1_old, c2_old, r2_old;
+    uint32_t c1, r1, c2, r2;
+    get_cell_range(idx, area_old, &c1_old, &r1_old, &c2_old, &r2_old);
+    get_cell_range(idx, &area, &c1, &r1, &c2, &r2);
+
+    /*Most of the movements stay in the same cells*/
+    if(c1 == c1_old && r1 == r1_old && c2 == c2_old && r2 == r2_old &&
+       area_old->x1 <= area_old->x2 && area_old->y1 <= area_old->y2 &&
+       area.x1 <= area.x2 && area.y1 <= area.y2) {
+        lv_area_copy(area_old, &area);
+        return;
+    }
+
+    uint32_t c, r;
+    if(area_old->x1 <= area_old->x2 && area_old->y1 <= area_old->y2) {
+        for(r = r1_old; r <= r2_old; r++) {
+            for(c = c1_old; c <= c2_old; c++) {
+                cell_remove(&idx->cells[r * idx->col_cnt + c], id);
+            }
+        }
+    }
+
+    lv_area_copy(area_old, &area);
+    if(area.x1 > area.x2 || area.y1 > area.y2) return;
+
+    for(r = r1; r <= r2; r++) {
+        for(c = c1; c <= c2; c++) {
+            if(!cell_insert(&idx->cells[r * idx->col_cnt + c], id)) {
+                idx->dirty = 1;
+                return;
+            }
+        }
+    }
+}
+
+void _lv_obj_spatial_index_move(lv_obj_t * obj, lv_coord_t x_diff, lv_coord_t y_diff)
+{
+    if(obj->spec_attr == NULL) return;
+
+    _lv_obj_spatial_index_t * idx = obj->spec_attr->spatial_index;
+    if(idx == NULL) return;
+
+    idx->ofs.x += x_diff;
+    idx->ofs.y += y_diff;
+}
+
+void _lv_obj_spatial_index_free(lv_obj_t * obj)
+{
+    if(obj->spec_attr == NULL) return;
+
+    _lv_obj_spatial_index_t * idx = obj->spec_attr->spatial_index;
+    if(idx == NULL) return;
+
+    index_clear(idx);
+    lv_mem_free(idx);
+    obj->spec_attr->spatial_index = NULL;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Get the up-to-date index of an object. Create or rebuild it if required.
+ * @param obj       pointer to an object
+ * @return          pointer to the index or NULL if the children should be checked one by one
+ */
+static _lv_obj_spatial_index_t * get_index(lv_obj_t * obj)
+{
+    uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+    if(child_cnt < LV_OBJ_SPATIAL_INDEX_MIN_CHILDREN) {
+        _lv_obj_spatial_index_free(obj);
+        return NULL;
+    }
+
+    _lv_obj_spatial_index_t * idx = obj->spec_attr->spatial_index;
+    if(idx == NULL) {
+        idx = lv_mem_alloc(sizeof(_lv_obj_spatial_index_t));
+        LV_ASSERT_MALLOC(idx);
+        if(idx == NULL) return NULL;
+        lv_memset_00(idx, sizeof(_lv_obj_spatial_index_t));
+        idx->dirty = 1;
+        obj->spec_attr->spatial_index = idx;
+    }
+
+    if(idx->child_cnt != child_cnt) idx->dirty = 1;
+
+    if(idx->dirty) {
+        if(!index_build(obj, idx)) return NULL;
+    }
+
+    return idx;
+}
+
+static bool index_build(lv_obj_t * obj, _lv_obj_spatial_index_t * idx)
+{
+    index_clear(idx);
+
+    uint32_t child_cnt = obj->spec_attr->child_cnt;
+    idx->areas = lv_mem_alloc(child_cnt * sizeof(lv_area_t));
+    idx->any_ids = lv_mem_alloc(child_cnt * sizeof(uint32_t));
+    if(idx->areas == NULL || idx->any_ids == NULL) {
+        index_clear(idx);
+        return false;
+    }
+
+    uint32_t bounded_cnt = 0;
+    uint32_t i;
+    for(i = 0; i < child_cnt; i++) {
+        lv_obj_t * child = obj->spec_attr->children[i];
+        if(!get_child_area(child, &idx->areas[i])) {
+            idx->any_ids[idx->any_cnt] = i;
+            idx->any_cnt++;
+            continue;
+        }
+
+        if(bounded_cnt == 0) lv_area_copy(&idx->bounds, &idx->areas[i]);
+        else _lv_area_join(&idx->bounds, &idx->bounds, &idx->areas[i]);
+        bounded_cnt++;
+    }
+
+    if(bounded_cnt == 0) lv_area_set(&idx->bounds, 0, 0, 0, 0);
+
+    /*Split the bounds to roughly square cells*/
+    uint32_t cell_cnt = LV_CLAMP(1, bounded_cnt / CHILDREN_PER_CELL, MAX_CELL_CNT);
+    lv_coord_t w = LV_MAX(lv_area_get_width(&idx->bounds), 1);
+    lv_coord_t h = LV_MAX(lv_area_get_height(&idx->bounds), 1);
+    uint32_t col_cnt = 1;
+    uint32_t row_cnt = 1;
+    while(col_cnt * row_cnt < cell_cnt) {
+        if(w / (lv_coord_t)col_cnt >= h / (lv_coord_t)row_cnt) col_cnt++;
+        else row_cnt++;
+    }
+    idx->col_cnt = (uint16_t)col_cnt;
+    idx->row_cnt = (uint16_t)row_cnt;
+    idx->cell_w = LV_MAX((w + (lv_coord_t)col_cnt - 1) / (lv_coord_t)col_cnt, 1);
+    idx->cell_h = LV_MAX((h + (lv_coord_t)row_cnt - 1) / (lv_coord_t)row_cnt, 1);
+
+    idx->cells = lv_mem_alloc(col_cnt * row_cnt * sizeof(cell_t));
+    if(idx->cells == NULL) {
+        index_clear(idx);
+        return false;
+    }
+    lv_memset_00(idx->cells, col_cnt * row_cnt * sizeof(cell_t));
+
+    /*Count the children per cell first to allocate every cell only once*/
+    uint32_t c1, r1, c2, r2, c, r;
+    uint32_t any_i = 0;
+    for(i = 0; i < child_cnt; i++) {
+        if(any_i < idx->any_cnt && idx->any_ids[any_i] == i) {
+            any_i++;
+            continue;
+        }
+        get_cell_range(idx, &idx->areas[i], &c1, &r1, &c2, &r2);
+        for(r = r1; r <= r2; r++) {
+            for(c = c1; c <= c2; c++) {
+                idx->cells[r * col_cnt + c].cap++;
+            }
+        }
+    }
+
+    for(i = 0; i < col_cnt * row_cnt; i++) {
+        cell_t * cell = &idx->cells[i];
+        if(cell->cap == 0) continue;
+        cell->ids = lv_mem_alloc(cell->cap * sizeof(uint32_t));
+        if(cell->ids == NULL) {
+            index_clear(idx);
+            return false;
+        }
+    }
+
+    /*Adding the children in order keeps the cells sorted*/
+    any_i = 0;
+    for(i = 0; i < child_cnt; i++) {
+        if(any_i < idx->any_cnt && idx->any_ids[any_i] == i) {
+            any_i++;
+            continue;
+        }
+        get_cell_range(idx, &idx->areas[i], &c1, &r1, &c2, &r2);
+        for(r = r1; r <= r2; r++) {
+            for(c = c1; c <= c2; c++) {
+                cell_t * cell = &idx->cells[r * col_cnt + c];
+                cell->ids[cell->cnt] = i;
+                cell->cnt++;
+            }
+        }
+    }
+
+    idx->ofs.x = 0;
+    idx->ofs.y = 0;
+    idx->child_cnt = child_cnt;
+    idx->dirty = 0;
+
+    return true;
+}
+
+static void index_clear(_lv_obj_spatial_index_t * idx)
+{
+    if(idx->cells) {
+        uint32_t i;
+        for(i = 0; i < (uint32_t)idx->col_cnt * idx->row_cnt; i++) {
+            if(idx->cells[i].ids) lv_mem_free(idx->cells[i].ids);
+        }
+        lv_mem_free(idx->cells);
+    }
+    if(idx->areas) lv_mem_free(idx->areas);
+    if(idx->any_ids) lv_mem_free(idx->any_ids);
+
+    idx->cells = NULL;
+    idx->areas = NULL;
+    idx->any_ids = NULL;
+    idx->any_cnt = 0;
+    idx->col_cnt = 0;
+    idx->row_cnt = 0;
+    idx->child_cnt = 0;
+    idx->dirty = 1;
+}
+
+/**
+ * Get the area where a child or its children can be hit.
+ * @param child     pointer to a child
+ * @param area      store the area here
+ * @return          false if the child can be hit anywhere (e.g. its children can overflow or it's transformed)
+ */
+static bool get_child_area(lv_obj_t * child, lv_area_t * area)
+{
+    if(lv_obj_has_flag(child, LV_OBJ_FLAG_OVERFLOW_VISIBLE)) return false;
+    if(_lv_obj_get_layer_type(child) == LV_LAYER_TYPE_TRANSFORM) return false;
+
+    lv_obj_get_click_area(child, area);
+    return true;
+}
+
+static void get_cell_range(const _lv_obj_spatial_index_t * idx, const lv_area_t * area,
+                           uint32_t * c1, uint32_t * r1, uint32_t * c2, uint32_t * r2)
+{
+    /*Clamp to the edge cells to keep the children moved out of the bounds findable*/
+    lv_coord_t col_max = idx->col_cnt - 1;
+    lv_coord_t row_max = idx->row_cnt - 1;
+    *c1 = LV_CLAMP(0, (area->x1 - idx->bounds.x1) / idx->cell_w, col_max);
+    *c2 = LV_CLAMP(0, (area->x2 - idx->bounds.x1) / idx->cell_w, col_max);
+    *r1 = LV_CLAMP(0, (area->y1 - idx->bounds.y1) / idx->cell_h, row_max);
+    *r2 = LV_CLAMP(0, (area->y2 - idx->bounds.y1) / idx->cell_h, row_max);
+}
+
+/**
+ * Find the position of an id in an ascending list or where it should be inserted.
+ */
+static uint32_t find_pos(const uint32_t * ids, uint32_t cnt, uint32_t id)
+{
+    uint32_t lo = 0;
+    uint32_t hi = cnt;
+    while(lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if(ids[mid] < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static bool cell_insert(cell_t * cell, uint32_t id)
+{
+    uint32_t pos = find_pos(cell->ids, cell->cnt, id);
+    if(pos < cell->cnt && cell->ids[pos] == id) return true;
+
+    if(cell->cnt == cell->cap) {
+        uint32_t new_cap = cell->cap ? cell->cap * 2 : CHILDREN_PER_CELL;
+        uint32_t * new_ids = lv_mem_realloc(cell->ids, new_cap * sizeof(uint32_t));
+        if(new_ids == NULL) return false;
+        cell->ids = new_ids;
+        cell->cap = new_cap;
+    }
+
+    uint32_t i;
+    for(i = cell->cnt; i > pos; i--) {
+        cell->ids[i] = cell->ids[i - 1];
+    }
+    cell->ids[pos] = id;
+    cell->cnt++;
+    return true;
+}
+
+static void cell_remove(cell_t * cell, uint32_t id)
+{
+    uint32_t pos = find_pos(cell->ids, cell->cnt, id);
+    if(pos >= cell->cnt || cell->ids[pos] != id) return;
+
+    uint32_t i;
+    for(i = pos; i < cell->cnt - 1; i++) {
+        cell->ids[i] = cell->ids[i + 1];
+    }
+    cell->cnt--;
+}
+
+#endif /*LV_USE_OBJ_SPATIAL_INDEX*/
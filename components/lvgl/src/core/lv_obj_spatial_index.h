@@ -0,0 +1,103 @@
+/**
+ * @file lv_obj_spatial_index.h
+ *
+ */
+
+#ifndef LV_OBJ_SPATIAL_INDEX_H
+#define LV_OBJ_SPATIAL_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../lv_conf_internal.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../misc/lv_area.h"
+
+#if LV_USE_OBJ_SPATIAL_INDEX
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+struct _lv_obj_t;
+struct _lv_obj_spatial_index_t;
+
+/**
+ * Iterates the children of an object which might contain a point, from the top (last) child to the bottom.
+ * If the object has no index all children are iterated.
+ */
+typedef struct {
+    const uint32_t * cell_ids;  /**< Indices of the children in the point's grid cell (ascending)*/
+    const uint32_t * any_ids;   /**< Indices of the children which need to be checked everywhere (ascending)*/
+    uint32_t cell_cnt;
+    uint32_t any_cnt;
+    uint32_t all_cnt;           /**< Remaining children if there is no index*/
+} _lv_obj_spatial_iter_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Start iterating the children of an object which might contain a point.
+ * The index is (re)built here if required.
+ * @param obj       pointer to an object whose children should be iterated
+ * @param point     the point in the same coordinate system as the children's coordinates
+ * @param iter      pointer to an iterator to initialize
+ */
+void _lv_obj_spatial_iter_init(struct _lv_obj_t * obj, const lv_point_t * point, _lv_obj_spatial_iter_t * iter);
+
+/**
+ * Get the index of the next candidate child.
+ * @param iter      pointer to an initialized iterator
+ * @return          index of the child or -1 if there are no more candidates
+ */
+int32_t _lv_obj_spatial_iter_next(_lv_obj_spatial_iter_t * iter);
+
+/**
+ * Mark the index of an object to be rebuilt. Call it if children are added, removed or reordered.
+ * @param obj       pointer to an object (the parent of the changed children)
+ */
+void _lv_obj_spatial_index_invalidate(struct _lv_obj_t * obj);
+
+/**
+ * Update the position of a child in its parent's index after its coordinates or click area changed.
+ * @param child     pointer to a child object
+ */
+void _lv_obj_spatial_index_update_child(struct _lv_obj_t * child);
+
+/**
+ * Shift the index of an object as all of its children were moved by the same amount (e.g. scrolled)
+ * @param obj       pointer to an object
+ * @param x_diff    horizontal movement
+ * @param y_diff    vertical movement
+ */
+void _lv_obj_spatial_index_move(struct _lv_obj_t * obj, lv_coord_t x_diff, lv_coord_t y_diff);
+
+/**
+ * Free the index of an object.
+ * @param obj       pointer to an object
+ */
+void _lv_obj_spatial_index_free(struct _lv_obj_t * obj);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_USE_OBJ_SPATIAL_INDEX*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_OBJ_SPATIAL_INDEX_H*/
@@ -14,6 +14,7 @@
  *      DEFINES
  *********************/
 #define MY_CLASS &lv_obj_class
+#define TRANS_CHUNK_ITEM_CNT 8
 
 /**********************
  *      TYPEDEFS
@@ -25,6 +26,7 @@ typedef struct {
     lv_style_selector_t selector;
     lv_style_value_t start_value;
     lv_style_value_t end_value;
+    lv_ilist_node_t node;
 } trans_t;
 
 typedef enum {
@@ -70,7 +72,7 @@ static bool style_refr = true;
 
 void _lv_obj_style_init(void)
 {
-    _lv_ll_init(&LV_GC_ROOT(_lv_obj_style_trans_ll), sizeof(trans_t));
+    _lv_ilist_init(&LV_GC_ROOT(_lv_obj_style_trans_ll), sizeof(trans_t), offsetof(trans_t, node), TRANS_CHUNK_ITEM_CNT);
 }
 
 void lv_obj_add_style(lv_obj_t * obj, lv_style_t * style, lv_style_selector_t selector)
@@ -196,11 +198,18 @@ void lv_obj_refresh_style(lv_obj_t * obj, lv_style_selector_t selector, lv_style
     /*Cache the layer type*/
     if((part == LV_PART_ANY || part == LV_PART_MAIN) && is_layer_refr) {
         lv_layer_type_t layer_type = calculate_layer_type(obj);
+#if LV_USE_OBJ_SPATIAL_INDEX
+        lv_layer_type_t layer_type_prev = _lv_obj_get_layer_type(obj);
+#endif
         if(obj->spec_attr) obj->spec_attr->layer_type = layer_type;
         else if(layer_type != LV_LAYER_TYPE_NONE) {
             lv_obj_allocate_spec_attr(obj);
             obj->spec_attr->layer_type = layer_type;
         }
+#if LV_USE_OBJ_SPATIAL_INDEX
+        /*Transformed children can be hit outside of their coordinates*/
+        if(layer_type != layer_type_prev) _lv_obj_spatial_index_update_child(obj);
+#endif
     }
 
     if(prop == LV_STYLE_PROP_ANY || is_ext_draw) {
@@ -352,9 +361,10 @@ void _lv_obj_style_create_transition(lv_obj_t * obj, lv_part_t part, lv_state_t
         }
     }
 
-    tr = _lv_ll_ins_head(&LV_GC_ROOT(_lv_obj_style_trans_ll));
+    tr = _lv_ilist_alloc(&LV_GC_ROOT(_lv_obj_style_trans_ll));
     LV_ASSERT_MALLOC(tr);
     if(tr == NULL) return;
+    _lv_ilist_ins_head(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
     tr->start_value = v1;
     tr->end_value = v2;
     tr->obj = obj;
@@ -724,12 +734,12 @@ static bool trans_del(lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop, tran
     trans_t * tr;
     trans_t * tr_prev;
     bool removed = false;
-    tr = _lv_ll_get_tail(&LV_GC_ROOT(_lv_obj_style_trans_ll));
+    tr = _lv_ilist_get_tail(&LV_GC_ROOT(_lv_obj_style_trans_ll));
     while(tr != NULL) {
         if(tr == tr_limit) break;
 
         /*'tr' might be deleted, so get the next object while 'tr' is valid*/
-        tr_prev = _lv_ll_get_prev(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
+        tr_prev = _lv_ilist_get_prev(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
 
         if(tr->obj == obj && (part == tr->selector || part == LV_PART_ANY) && (prop == tr->prop || prop == LV_STYLE_PROP_ANY)) {
             /*Remove any transitioned properties from the trans. style
@@ -743,8 +753,8 @@ static bool trans_del(lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop, tran
 
             /*Free the transition descriptor too*/
             lv_anim_del(tr, NULL);
-            _lv_ll_remove(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
-            lv_mem_free(tr);
+            _lv_ilist_remove(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
+            _lv_ilist_free(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
             removed = true;
 
         }
@@ -849,7 +859,7 @@ static void trans_anim_ready_cb(lv_anim_t * a)
      *It allows changing it by normal styles*/
     bool running = false;
     trans_t * tr_i;
-    _LV_LL_READ(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr_i) {
+    _LV_ILIST_READ(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr_i) {
         if(tr_i != tr && tr_i->obj == tr->obj && tr_i->selector == tr->selector && tr_i->prop == tr->prop) {
             running = true;
             break;
@@ -860,8 +870,8 @@ static void trans_anim_ready_cb(lv_anim_t * a)
         uint32_t i;
         for(i = 0; i < obj->style_cnt; i++) {
             if(obj->styles[i].is_trans && obj->styles[i].selector == tr->selector) {
-                _lv_ll_remove(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
-                lv_mem_free(tr);
+                _lv_ilist_remove(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
+                _lv_ilist_free(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
 
                 _lv_obj_style_t * obj_style = &obj->styles[i];
                 lv_style_remove_prop(obj_style->style, prop);
@@ -18,6 +18,7 @@
  *      DEFINES
  *********************/
 #define MY_CLASS &lv_obj_class
+#define CHILD_ARRAY_MIN_CAP 4
 
 /**********************
  *      TYPEDEFS
@@ -29,6 +30,7 @@
 static void lv_obj_del_async_cb(void * obj);
 static void obj_del_core(lv_obj_t * obj);
 static lv_obj_tree_walk_res_t walk_core(lv_obj_t * obj, lv_obj_tree_walk_cb_t cb, void * user_data);
+static bool child_array_resize(lv_obj_t * obj, uint32_t new_cap);
 
 /**********************
  *  STATIC VARIABLES
@@ -145,28 +147,18 @@ void lv_obj_set_parent(lv_obj_t * obj, lv_obj_t * parent)
 
     lv_obj_t * old_parent = obj->parent;
     /*Remove the object from the old parent's child list*/
-    int32_t i;
-    for(i = lv_obj_get_index(obj); i <= (int32_t)lv_obj_get_child_cnt(old_parent) - 2; i++) {
-        old_parent->spec_attr->children[i] = old_parent->spec_attr->children[i + 1];
-    }
-    old_parent->spec_attr->child_cnt--;
-    if(old_parent->spec_attr->child_cnt) {
-        old_parent->spec_attr->children = lv_mem_realloc(old_parent->spec_attr->children,
-                                                         old_parent->spec_attr->child_cnt * (sizeof(lv_obj_t *)));
-    }
-    else {
-        lv_mem_free(old_parent->spec_attr->children);
-        old_parent->spec_attr->children = NULL;
-    }
+    _lv_obj_child_array_remove(old_parent, lv_obj_get_index(obj));
 
     /*Add the child to the new parent as the last (newest child)*/
-    parent->spec_attr->child_cnt++;
-    parent->spec_attr->children = lv_mem_realloc(parent->spec_attr->children,
-                                                 parent->spec_attr->child_cnt * (sizeof(lv_obj_t *)));
-    parent->spec_attr->children[lv_obj_get_child_cnt(parent) - 1] = obj;
+    _lv_obj_child_array_add(parent, obj);
 
     obj->parent = parent;
 
+#if LV_USE_OBJ_SPATIAL_INDEX
+    _lv_obj_spatial_index_invalidate(old_parent);
+    _lv_obj_spatial_index_invalidate(parent);
+#endif
+
     /*Notify the original parent because one of its children is lost*/
     lv_obj_scrollbar_invalidate(old_parent);
     lv_event_send(old_parent, LV_EVENT_CHILD_CHANGED, obj);
@@ -212,6 +204,9 @@ void lv_obj_move_to_index(lv_obj_t * obj, int32_t index)
     }
 
     parent->spec_attr->children[index] = obj;
+#if LV_USE_OBJ_SPATIAL_INDEX
+    _lv_obj_spatial_index_invalidate(parent);
+#endif
     lv_event_send(parent, LV_EVENT_CHILD_CHANGED, NULL);
     lv_obj_invalidate(parent);
 }
@@ -232,6 +227,10 @@ void lv_obj_swap(lv_obj_t * obj1, lv_obj_t * obj2)
 
     parent->spec_attr->children[index1] = obj2;
     parent2->spec_attr->children[index2] = obj1;
+#if LV_USE_OBJ_SPATIAL_INDEX
+    _lv_obj_spatial_index_invalidate(parent);
+    _lv_obj_spatial_index_invalidate(parent2);
+#endif
 
     lv_event_send(parent, LV_EVENT_CHILD_CHANGED, obj2);
     lv_event_send(parent, LV_EVENT_CHILD_CREATED, obj2);
@@ -337,10 +336,108 @@ void lv_obj_tree_walk(lv_obj_t * start_obj, lv_obj_tree_walk_cb_t cb, void * use
     walk_core(start_obj, cb, user_data);
 }
 
+bool _lv_obj_child_array_add(lv_obj_t * obj, lv_obj_t * child)
+{
+    _lv_obj_spec_attr_t * attr = obj->spec_attr;
+    if(attr->child_cnt >= attr->child_cap) {
+        /*Grow by 50% to make adding many children cheap*/
+        uint32_t new_cap = attr->child_cap + attr->child_cap / 2;
+        if(new_cap < CHILD_ARRAY_MIN_CAP) new_cap = CHILD_ARRAY_MIN_CAP;
+#if LV_OBJ_CHILD_INLINE_CNT
+        if(attr->child_cap < LV_OBJ_CHILD_INLINE_CNT) new_cap = LV_OBJ_CHILD_INLINE_CNT;
+#endif
+        if(!child_array_resize(obj, new_cap)) return false;
+    }
+
+    attr->children[attr->child_cnt] = child;
+    attr->child_cnt++;
+    return true;
+}
+
+void _lv_obj_child_array_remove(lv_obj_t * obj, uint32_t id)
+{
+    _lv_obj_spec_attr_t * attr = obj->spec_attr;
+    if(attr == NULL || id >= attr->child_cnt) return;
+
+    uint32_t i;
+    for(i = id; i < attr->child_cnt - 1; i++) {
+        attr->children[i] = attr->children[i + 1];
+    }
+    attr->child_cnt--;
+
+    if(attr->child_cnt == 0) {
+        _lv_obj_child_array_free(obj);
+    }
+#if LV_OBJ_CHILD_INLINE_CNT
+    else if(attr->child_cnt <= LV_OBJ_CHILD_INLINE_CNT && attr->children != attr->child_inline) {
+        child_array_resize(obj, LV_OBJ_CHILD_INLINE_CNT);
+    }
+#endif
+    /*Shrink only if much too large to not reallocate on every add/remove around a limit*/
+    else if(attr->child_cap > CHILD_ARRAY_MIN_CAP && attr->child_cnt < attr->child_cap / 4) {
+        child_array_resize(obj, attr->child_cap / 2);
+    }
+}
+
+void _lv_obj_child_array_free(lv_obj_t * obj)
+{
+    _lv_obj_spec_attr_t * attr = obj->spec_attr;
+    if(attr == NULL) return;
+
+#if LV_OBJ_CHILD_INLINE_CNT
+    if(attr->children != attr->child_inline) lv_mem_free(attr->children);
+#else
+    lv_mem_free(attr->children);
+#endif
+    attr->children = NULL;
+    attr->child_cnt = 0;
+    attr->child_cap = 0;
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
+/**
+ * Move the children to an array with room for `new_cap` children.
+ * Few children are stored in the object itself.
+ */
+static bool child_array_resize(lv_obj_t * obj, uint32_t new_cap)
+{
+    _lv_obj_spec_attr_t * attr = obj->spec_attr;
+    lv_obj_t ** old_array = attr->children;
+    bool old_inline = false;
+
+#if LV_OBJ_CHILD_INLINE_CNT
+    old_inline = old_array == attr->child_inline;
+    if(new_cap <= LV_OBJ_CHILD_INLINE_CNT) {
+        if(!old_inline) {
+            if(attr->child_cnt) lv_memcpy(attr->child_inline, old_array, attr->child_cnt * sizeof(lv_obj_t *));
+            lv_mem_free(old_array);
+            attr->children = attr->child_inline;
+        }
+        attr->child_cap = LV_OBJ_CHILD_INLINE_CNT;
+        return true;
+    }
+#endif
+
+    lv_obj_t ** new_array;
+    if(old_array == NULL || old_inline) {
+        new_array = lv_mem_alloc(new_cap * sizeof(lv_obj_t *));
+        if(new_array && attr->child_cnt) lv_memcpy(new_array, old_array, attr->child_cnt * sizeof(lv_obj_t *));
+    }
+    else {
+        new_array = lv_mem_realloc(old_array, new_cap * sizeof(lv_obj_t *));
+    }
+
+    LV_ASSERT_MALLOC(new_array);
+    if(new_array == NULL) return false;
+
+    attr->children = new_array;
+    attr->child_cap = new_cap;
+    return true;
+}
+
 static void lv_obj_del_async_cb(void * obj)
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
@@ -402,14 +499,10 @@ static void obj_del_core(lv_obj_t * obj)
     }
     /*Remove the object from the child list of its parent*/
     else {
-        uint32_t id = lv_obj_get_index(obj);
-        uint32_t i;
-        for(i = id; i < obj->parent->spec_attr->child_cnt - 1; i++) {
-            obj->parent->spec_attr->children[i] = obj->parent->spec_attr->children[i + 1];
-        }
-        obj->parent->spec_attr->child_cnt--;
-        obj->parent->spec_attr->children = lv_mem_realloc(obj->parent->spec_attr->children,
-                                                          obj->parent->spec_attr->child_cnt * sizeof(lv_obj_t *));
+        _lv_obj_child_array_remove(obj->parent, lv_obj_get_index(obj));
+#if LV_USE_OBJ_SPATIAL_INDEX
+        _lv_obj_spatial_index_invalidate(obj->parent);
+#endif
     }
 
     /*Free the object itself*/
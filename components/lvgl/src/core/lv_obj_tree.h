@@ -160,6 +160,29 @@ uint32_t lv_obj_get_index(const struct _lv_obj_t * obj);
  */
 void lv_obj_tree_walk(struct _lv_obj_t * start_obj, lv_obj_tree_walk_cb_t cb, void * user_data);
 
+/**
+ * Append a child to the child array of an object. Used internally when a child is created or moved.
+ * The array grows in steps and small arrays are stored in the object itself, see `LV_OBJ_CHILD_INLINE_CNT`.
+ * @param obj       pointer to an object with allocated `spec_attr`
+ * @param child     the new child
+ * @return          true: added; false: out of memory
+ */
+bool _lv_obj_child_array_add(struct _lv_obj_t * obj, struct _lv_obj_t * child);
+
+/**
+ * Remove a child from the child array of an object and shrink the array if it became much too large.
+ * Used internally when a child is deleted or moved.
+ * @param obj       pointer to an object
+ * @param id        index of the child to remove
+ */
+void _lv_obj_child_array_remove(struct _lv_obj_t * obj, uint32_t id);
+
+/**
+ * Free the child array of an object. Used internally when the object is deleted.
+ * @param obj       pointer to an object
+ */
+void _lv_obj_child_array_free(struct _lv_obj_t * obj);
+
 /**********************
  *      MACROS
  **********************/
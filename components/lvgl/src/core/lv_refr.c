@@ -820,8 +820,18 @@ static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj)
     if(info.res == LV_COVER_RES_MASKED) return NULL;
 
     int32_t i;
+#if LV_USE_OBJ_SPATIAL_INDEX
+    /*A child covering the area surely contains its top left corner*/
+    lv_point_t p;
+    p.x = area_p->x1;
+    p.y = area_p->y1;
+    _lv_obj_spatial_iter_t iter;
+    _lv_obj_spatial_iter_init(obj, &p, &iter);
+    while((i = _lv_obj_spatial_iter_next(&iter)) >= 0) {
+#else
     int32_t child_cnt = lv_obj_get_child_cnt(obj);
     for(i = child_cnt - 1; i >= 0; i--) {
+#endif
         lv_obj_t * child = obj->spec_attr->children[i];
         found_p = lv_refr_get_top_obj(area_p, child);
 
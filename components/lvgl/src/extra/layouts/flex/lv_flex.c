@@ -534,6 +534,9 @@ static void children_repos(lv_obj_t * cont, flex_t * f, int32_t item_first_id, i
             item->coords.y2 += diff_y;
             lv_obj_invalidate(item);
             lv_obj_move_children_by(item, diff_x, diff_y, false);
+#if LV_USE_OBJ_SPATIAL_INDEX
+            _lv_obj_spatial_index_update_child(item);
+#endif
         }
 
         if(!(f->row && rtl)) main_pos += area_get_main_size(&item->coords) + item_gap + place_gap;
@@ -688,6 +688,9 @@ static void item_repos(lv_obj_t * item, _lv_grid_calc_t * c, item_repos_hint_t *
         item->coords.y2 += diff_y;
         lv_obj_invalidate(item);
         lv_obj_move_children_by(item, diff_x, diff_y, false);
+#if LV_USE_OBJ_SPATIAL_INDEX
+        _lv_obj_spatial_index_update_child(item);
+#endif
     }
 }
 
@@ -19,6 +19,10 @@
 #else
     #include <windows.h>
 #endif
+#if LV_FS_POSIX_MMAP
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
 
 /*********************
  *      DEFINES
@@ -28,6 +32,10 @@
     #error "LV_FS_POSIX_LETTER must be an upper case ASCII letter"
 #endif
 
+#if LV_FS_POSIX_MMAP && defined(WIN32)
+    #error "LV_FS_POSIX_MMAP is not supported on Windows"
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -41,6 +49,10 @@ static lv_fs_res_t fs_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_
 static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw);
 static lv_fs_res_t fs_seek(lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence);
 static lv_fs_res_t fs_tell(lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+#if LV_FS_POSIX_MMAP
+    static const void * fs_mmap(lv_fs_drv_t * drv, void * file_p, uint32_t * size);
+    static void fs_munmap(lv_fs_drv_t * drv, void * file_p, const void * data, uint32_t size);
+#endif
 static void * fs_dir_open(lv_fs_drv_t * drv, const char * path);
 static lv_fs_res_t fs_dir_read(lv_fs_drv_t * drv, void * dir_p, char * fn);
 static lv_fs_res_t fs_dir_close(lv_fs_drv_t * drv, void * dir_p);
@@ -80,6 +92,10 @@ void lv_fs_posix_init(void)
     fs_drv.write_cb = fs_write;
     fs_drv.seek_cb = fs_seek;
     fs_drv.tell_cb = fs_tell;
+#if LV_FS_POSIX_MMAP
+    fs_drv.mmap_cb = fs_mmap;
+    fs_drv.munmap_cb = fs_munmap;
+#endif
 
     fs_drv.dir_close_cb = fs_dir_close;
     fs_drv.dir_open_cb = fs_dir_open;
@@ -196,6 +212,42 @@ static lv_fs_res_t fs_tell(lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
     return offset < 0 ? LV_FS_RES_FS_ERR : LV_FS_RES_OK;
 }
 
+#if LV_FS_POSIX_MMAP
+/**
+ * Map a whole file into memory
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p a file handle variable
+ * @param size store the size of the file here
+ * @return pointer to the content of the file or NULL if it can't be mapped (e.g. it's empty)
+ */
+static const void * fs_mmap(lv_fs_drv_t * drv, void * file_p, uint32_t * size)
+{
+    LV_UNUSED(drv);
+    struct stat st;
+    if(fstat((lv_uintptr_t)file_p, &st) != 0 || st.st_size <= 0 || (uint64_t)st.st_size > UINT32_MAX) return NULL;
+
+    void * data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, (lv_uintptr_t)file_p, 0);
+    if(data == MAP_FAILED) return NULL;
+
+    *size = st.st_size;
+    return data;
+}
+
+/**
+ * Unmap a file mapped by `fs_mmap`
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p a file handle variable
+ * @param data the mapped content
+ * @param size the mapped size
+ */
+static void fs_munmap(lv_fs_drv_t * drv, void * file_p, const void * data, uint32_t size)
+{
+    LV_UNUSED(drv);
+    LV_UNUSED(file_p);
+    munmap((void *)(lv_uintptr_t)data, size);
+}
+#endif /*LV_FS_POSIX_MMAP*/
+
 #ifdef WIN32
     static char next_fn[256];
 #endif
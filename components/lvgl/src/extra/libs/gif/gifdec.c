@@ -11,6 +11,15 @@
 #define MIN(A, B) ((A) < (B) ? (A) : (B))
 #define MAX(A, B) ((A) > (B) ? (A) : (B))
 
+/* Bytes of a canvas pixel (color and alpha). */
+#if LV_COLOR_DEPTH == 32
+#define CANVAS_PX_SIZE 4
+#elif LV_COLOR_DEPTH == 16
+#define CANVAS_PX_SIZE 3
+#elif LV_COLOR_DEPTH == 8 || LV_COLOR_DEPTH == 1
+#define CANVAS_PX_SIZE 2
+#endif
+
 typedef struct Entry {
     uint16_t length;
     uint16_t prefix;
@@ -523,6 +532,38 @@ render_frame_rect(gd_GIF *gif, uint8_t *buffer)
     }
 }
 
+/* Copy the canvas under the frame to the backup buffer or back. */
+static void
+copy_backup(gd_GIF *gif, bool restore)
+{
+    int j;
+    uint32_t line_size = gif->fw * CANVAS_PX_SIZE;
+    uint8_t *canvas = &gif->canvas[(gif->fy * gif->width + gif->fx) * CANVAS_PX_SIZE];
+    uint8_t *backup = gif->backup;
+    for (j = 0; j < gif->fh; j++) {
+        if (restore) memcpy(canvas, backup, line_size);
+        else memcpy(backup, canvas, line_size);
+        canvas += gif->width * CANVAS_PX_SIZE;
+        backup += line_size;
+    }
+}
+
+/* Save the canvas under a frame to restore it when the frame is disposed.
+ * Return false if there is not enough memory. */
+static bool
+save_backup(gd_GIF *gif)
+{
+    uint32_t size = gif->fw * gif->fh * CANVAS_PX_SIZE;
+    if (size > gif->backup_size) {
+        uint8_t *backup = lv_mem_realloc(gif->backup, size);
+        if (!backup) return false;
+        gif->backup = backup;
+        gif->backup_size = size;
+    }
+    copy_backup(gif, false);
+    return true;
+}
+
 static void
 dispose(gd_GIF *gif)
 {
@@ -561,11 +602,12 @@ dispose(gd_GIF *gif)
             i += gif->width;
         }
         break;
-    case 3: /* Restore to previous, i.e., don't update canvas.*/
+    case 3: /* Restore to previous, i.e., the canvas before the frame was rendered. */
+        copy_backup(gif, true);
         break;
     default:
-        /* Add frame non-transparent pixels to canvas. */
-        render_frame_rect(gif, gif->canvas);
+        /* Add frame non-transparent pixels to canvas if they were rendered elsewhere. */
+        if (!gif->frame_on_canvas) render_frame_rect(gif, gif->canvas);
     }
 }
 
@@ -574,6 +616,17 @@ int
 gd_get_frame(gd_GIF *gif)
 {
     char sep;
+    int ret;
+
+    /* The disposed area changes too, the new frame is added to it below. */
+    if (gif->gce.disposal == 2 || gif->gce.disposal == 3) {
+        gif->dx = gif->fx;
+        gif->dy = gif->fy;
+        gif->dw = gif->fw;
+        gif->dh = gif->fh;
+    } else {
+        gif->dw = gif->dh = 0;
+    }
 
     dispose(gif);
     f_gif_read(gif, &sep, 1);
@@ -581,7 +634,8 @@ gd_get_frame(gd_GIF *gif)
         if (sep == ';') {
             f_gif_seek(gif, gif->anim_start, LV_FS_SEEK_SET);
             if(gif->loop_count == 1 || gif->loop_count < 0) {
-                return 0;
+                ret = 0;
+                goto end;
             }
             else if(gif->loop_count > 1) {
                 gif->loop_count--;
@@ -589,12 +643,38 @@ gd_get_frame(gd_GIF *gif)
         }
         else if (sep == '!')
             read_ext(gif);
-        else return -1;
+        else {
+            ret = -1;
+            goto end;
+        }
         f_gif_read(gif, &sep, 1);
     }
-    if (read_image(gif) == -1)
-        return -1;
-    return 1;
+    gif->frame_on_canvas = 0;
+    if (read_image(gif) == -1) {
+        ret = -1;
+        goto end;
+    }
+    if (gif->gce.disposal == 3 && !save_backup(gif)) {
+        LV_LOG_WARN("not enough memory to restore the frame, it won't be disposed");
+        gif->gce.disposal = 1;
+    }
+    ret = 1;
+end:
+    /* Add the frame's area to the changed area */
+    if (gif->dw == 0 || gif->dh == 0) {
+        gif->dx = gif->fx;
+        gif->dy = gif->fy;
+        gif->dw = gif->fw;
+        gif->dh = gif->fh;
+    } else if (gif->fw && gif->fh) {
+        uint16_t x2 = MAX(gif->dx + gif->dw, gif->fx + gif->fw);
+        uint16_t y2 = MAX(gif->dy + gif->dh, gif->fy + gif->fh);
+        gif->dx = MIN(gif->dx, gif->fx);
+        gif->dy = MIN(gif->dy, gif->fy);
+        gif->dw = x2 - gif->dx;
+        gif->dh = y2 - gif->dy;
+    }
+    return ret;
 }
 
 void
@@ -610,6 +690,7 @@ gd_render_frame(gd_GIF *gif, uint8_t *buffer)
 //    }
 //    memcpy(buffer, gif->canvas, gif->width * gif->height * 3);
     render_frame_rect(gif, buffer);
+    if (buffer == gif->canvas) gif->frame_on_canvas = 1;
 }
 
 void
@@ -623,6 +704,7 @@ void
 gd_close_gif(gd_GIF *gif)
 {
     f_gif_close(gif);
+    lv_mem_free(gif->backup);
     lv_mem_free(gif);
 }
 
@@ -41,8 +41,14 @@ typedef struct gd_GIF {
     void (*comment)(struct gd_GIF *gif);
     void (*application)(struct gd_GIF *gif, char id[8], char auth[3]);
     uint16_t fx, fy, fw, fh;
+    /* Area of the canvas changed by the last frame (disposed and new pixels). */
+    uint16_t dx, dy, dw, dh;
     uint8_t bgindex;
+    uint8_t frame_on_canvas;
     uint8_t *canvas, *frame;
+    /* Canvas pixels under a frame with "restore to previous" disposal. */
+    uint8_t *backup;
+    uint32_t backup_size;
 } gd_GIF;
 
 gd_GIF * gd_open_gif_file(const char *fname);
@@ -27,6 +27,7 @@
 static void lv_gif_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
 static void lv_gif_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
 static void next_frame_task_cb(lv_timer_t * t);
+static void invalidate_frame_area(lv_obj_t * obj);
 
 /**********************
  *  STATIC VARIABLES
@@ -132,8 +133,6 @@ static void next_frame_task_cb(lv_timer_t * t)
 {
     lv_obj_t * obj = t->user_data;
     lv_gif_t * gifobj = (lv_gif_t *) obj;
-    uint32_t elaps = lv_tick_elaps(gifobj->last_call);
-    if(elaps < gifobj->gif->gce.delay * 10) return;
 
     gifobj->last_call = lv_tick_get();
 
@@ -147,8 +146,40 @@ static void next_frame_task_cb(lv_timer_t * t)
 
     gd_render_frame(gifobj->gif, (uint8_t *)gifobj->imgdsc.data);
 
+    /*Wake up only when the next frame is due instead of polling*/
+    lv_timer_set_period(t, LV_MAX(gifobj->gif->gce.delay * 10, 10));
+
     lv_img_cache_invalidate_src(lv_img_get_src(obj));
-    lv_obj_invalidate(obj);
+    invalidate_frame_area(obj);
+}
+
+/**
+ * Invalidate only the area changed by the last frame.
+ * It's possible only if the canvas is drawn once and untransformed, else the whole object is invalidated.
+ */
+static void invalidate_frame_area(lv_obj_t * obj)
+{
+    lv_gif_t * gifobj = (lv_gif_t *) obj;
+    lv_img_t * img = (lv_img_t *) obj;
+    gd_GIF * gif = gifobj->gif;
+
+    lv_area_t content;
+    lv_obj_get_content_coords(obj, &content);
+
+    if(img->angle != 0 || img->zoom != LV_IMG_ZOOM_NONE || img->offset.x != 0 || img->offset.y != 0 ||
+       lv_area_get_width(&content) > img->w || lv_area_get_height(&content) > img->h) {
+        lv_obj_invalidate(obj);
+        return;
+    }
+
+    if(gif->dw == 0 || gif->dh == 0) return;
+
+    lv_area_t a;
+    a.x1 = content.x1 + gif->dx;
+    a.y1 = content.y1 + gif->dy;
+    a.x2 = a.x1 + gif->dw - 1;
+    a.y2 = a.y1 + gif->dh - 1;
+    lv_obj_invalidate_area(obj, &a);
 }
 
 #endif /*LV_USE_GIF*/
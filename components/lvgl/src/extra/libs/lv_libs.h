@@ -14,6 +14,7 @@ extern "C" {
  *      INCLUDES
  *********************/
 #include "bmp/lv_bmp.h"
+#include "rle/lv_rle.h"
 #include "fsdrv/lv_fsdrv.h"
 #include "png/lv_png.h"
 #include "gif/lv_gif.h"
@@ -10,6 +10,7 @@
 #if LV_USE_PNG
 
 #include "lv_png.h"
+#include "lv_png_stream.h"
 #include "lodepng.h"
 #include <stdlib.h>
 
@@ -26,6 +27,10 @@
  **********************/
 static lv_res_t decoder_info(struct _lv_img_decoder_t * decoder, const void * src, lv_img_header_t * header);
 static lv_res_t decoder_open(lv_img_decoder_t * dec, lv_img_decoder_dsc_t * dsc);
+#if LV_PNG_STREAM
+static lv_res_t decoder_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc,
+                                  lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf);
+#endif
 static void decoder_close(lv_img_decoder_t * dec, lv_img_decoder_dsc_t * dsc);
 static void convert_color_depth(uint8_t * img, uint32_t px_cnt);
 
@@ -49,6 +54,9 @@ void lv_png_init(void)
     lv_img_decoder_t * dec = lv_img_decoder_create();
     lv_img_decoder_set_info_cb(dec, decoder_info);
     lv_img_decoder_set_open_cb(dec, decoder_open);
+#if LV_PNG_STREAM
+    lv_img_decoder_set_read_line_cb(dec, decoder_read_line);
+#endif
     lv_img_decoder_set_close_cb(dec, decoder_close);
 }
 
@@ -151,6 +159,19 @@ static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t *
 
     uint8_t * img_data = NULL;
 
+#if LV_PNG_STREAM
+    /*Decode the lines in `read_line` if possible. Interlaced images are decoded entirely below.*/
+    if(dsc->src_type == LV_IMG_SRC_VARIABLE ||
+       (dsc->src_type == LV_IMG_SRC_FILE && strcmp(lv_fs_get_ext(dsc->src), "png") == 0)) {
+        lv_png_stream_t * stream = lv_png_stream_open(dsc->src);
+        if(stream) {
+            dsc->img_data = NULL;
+            dsc->user_data = stream;
+            return LV_RES_OK;
+        }
+    }
+#endif
+
     /*If it's a PNG file...*/
     if(dsc->src_type == LV_IMG_SRC_FILE) {
         const char * fn = dsc->src;
@@ -213,12 +234,29 @@ static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t *
     return LV_RES_INV;    /*If not returned earlier then it failed*/
 }
 
+#if LV_PNG_STREAM
+static lv_res_t decoder_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc,
+                                  lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf)
+{
+    LV_UNUSED(decoder);
+
+    if(dsc->user_data == NULL) return LV_RES_INV;
+    return lv_png_stream_read_line(dsc->user_data, x, y, len, buf);
+}
+#endif
+
 /**
  * Free the allocated resources
  */
 static void decoder_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc)
 {
     LV_UNUSED(decoder); /*Unused*/
+#if LV_PNG_STREAM
+    if(dsc->user_data) {
+        lv_png_stream_close(dsc->user_data);
+        dsc->user_data = NULL;
+    }
+#endif
     if(dsc->img_data) {
         lv_mem_free((uint8_t *)dsc->img_data);
         dsc->img_data = NULL;
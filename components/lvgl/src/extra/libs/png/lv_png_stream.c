@@ -0,0 +1,913 @@
+/**
+ * @file lv_png_stream.c
+ * Decode non-interlaced PNG images line by line.
+ * The zlib stream of the IDAT chunks is inflated on demand with a sliding window,
+ * the lines are unfiltered into a ring of two lines and converted to the system's
+ * color format only for the requested pixels.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../../lvgl.h"
+#if LV_USE_PNG && LV_PNG_STREAM
+
+#include "lv_png_stream.h"
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define RING_LINES          2       /*The previous line is required to unfilter a line*/
+#define IN_BUF_SIZE         256     /*Read buffer of files*/
+#define FAST_BITS           9       /*Huffman codes up to this length are decoded with a single lookup*/
+#define FAST_MASK           ((1 << FAST_BITS) - 1)
+#define FAST_SYM_MASK       0x1FF
+
+#define COLOR_GRAY          0
+#define COLOR_RGB           2
+#define COLOR_PALETTE       3
+#define COLOR_GRAY_ALPHA    4
+#define COLOR_RGBA          6
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint16_t count[16];             /*Number of codes of each length*/
+    uint16_t symbol[288];           /*Symbols ordered by their codes*/
+    uint16_t fast[1 << FAST_BITS];  /*`len << 9 | symbol` indexed by the next bits, 0: longer code*/
+} huff_t;
+
+typedef enum {
+    INFLATE_BLOCK_HEADER,
+    INFLATE_STORED,
+    INFLATE_HUFFMAN,
+} inflate_state_t;
+
+struct _lv_png_stream_t {
+    /*Source*/
+    const uint8_t * data;           /*The PNG file in a C array or NULL if it's a file*/
+    uint32_t data_size;
+    lv_fs_file_t f;
+    uint32_t pos;                   /*Read position in `data` or the file*/
+    uint32_t first_idat_pos;        /*Position of the data of the first IDAT chunk*/
+    uint32_t first_idat_size;
+    uint32_t idat_left;             /*Data bytes left in the current IDAT chunk*/
+    bool idat_end;
+    uint16_t in_len;
+    uint16_t in_pos;
+    uint8_t in_buf[IN_BUF_SIZE];
+
+    /*Image*/
+    uint32_t w;
+    uint32_t h;
+    uint32_t stride;                /*Bytes in a line without the filter type*/
+    uint8_t depth;
+    uint8_t color_type;
+    uint8_t filter_bpp;             /*Bytes per complete pixel, at least 1*/
+    bool has_key;
+    uint16_t key[3];                /*Transparent gray or RGB color of the tRNS chunk*/
+    uint8_t palette[256][4];
+
+    /*Inflate*/
+    uint32_t bit_buf;
+    uint32_t bit_cnt;
+    uint32_t pad_cnt;               /*Zero bytes added after the end of the data*/
+    inflate_state_t state;
+    bool last_block;
+    uint32_t stored_left;
+    uint32_t copy_len;
+    uint32_t copy_dist;
+    uint32_t out_cnt;               /*Inflated bytes since the start*/
+    uint8_t * window;
+    uint32_t window_size;
+    uint32_t window_pos;
+    huff_t lit;
+    huff_t dist;
+
+    /*Lines*/
+    uint8_t * lines;                /*`RING_LINES` unfiltered lines*/
+    uint32_t next_y;                /*The line to decode next*/
+    uint32_t pass_cnt;
+};
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool parse_chunks(lv_png_stream_t * s);
+static bool rewind_stream(lv_png_stream_t * s);
+static bool decode_line(lv_png_stream_t * s);
+static void unfilter(uint8_t * line, const uint8_t * prev, uint32_t size, uint32_t bpp, uint8_t type);
+static void convert_line(const lv_png_stream_t * s, const uint8_t * line, uint32_t x, uint32_t len, uint8_t * buf);
+static bool inflate_read(lv_png_stream_t * s, uint8_t * out, uint32_t len);
+static bool read_block_header(lv_png_stream_t * s);
+static bool read_dynamic_tables(lv_png_stream_t * s);
+static bool huff_build(huff_t * h, const uint8_t * lens, uint32_t n);
+static int32_t huff_decode(lv_png_stream_t * s, const huff_t * h);
+static uint32_t get_bits(lv_png_stream_t * s, uint32_t n);
+static int32_t idat_byte(lv_png_stream_t * s);
+static bool src_read(lv_png_stream_t * s, uint8_t * buf, uint32_t len);
+static int32_t src_byte(lv_png_stream_t * s);
+static bool src_seek(lv_png_stream_t * s, uint32_t pos);
+static uint32_t read_u32_be(const uint8_t * p);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static const uint16_t len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_png_stream_t * lv_png_stream_open(const void * src)
+{
+    lv_img_src_t src_type = lv_img_src_get_type(src);
+    if(src_type != LV_IMG_SRC_FILE && src_type != LV_IMG_SRC_VARIABLE) return NULL;
+
+    lv_png_stream_t * s = lv_mem_alloc(sizeof(lv_png_stream_t));
+    LV_ASSERT_MALLOC(s);
+    if(s == NULL) return NULL;
+    lv_memset_00(s, sizeof(lv_png_stream_t));
+
+    if(src_type == LV_IMG_SRC_FILE) {
+        if(lv_fs_open(&s->f, src, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+            lv_mem_free(s);
+            return NULL;
+        }
+    }
+    else {
+        const lv_img_dsc_t * img_dsc = src;
+        if(img_dsc->data == NULL) {
+            lv_mem_free(s);
+            return NULL;
+        }
+        s->data = img_dsc->data;
+        s->data_size = img_dsc->data_size;
+    }
+
+    if(!parse_chunks(s)) {
+        lv_png_stream_close(s);
+        return NULL;
+    }
+
+    /*Read the zlib header to learn the size of the window*/
+    if(!rewind_stream(s)) {
+        lv_png_stream_close(s);
+        return NULL;
+    }
+
+    /*The window needs not be larger than the inflated data*/
+    uint32_t raw_size = s->h * (s->stride + 1);
+    while(s->window_size > 256 && s->window_size / 2 >= raw_size) s->window_size /= 2;
+
+    s->window = lv_mem_alloc(s->window_size + RING_LINES * s->stride);
+    LV_ASSERT_MALLOC(s->window);
+    if(s->window == NULL) {
+        lv_png_stream_close(s);
+        return NULL;
+    }
+    s->lines = s->window + s->window_size;
+
+    return s;
+}
+
+void lv_png_stream_get_size(const lv_png_stream_t * s, uint32_t * w, uint32_t * h)
+{
+    *w = s->w;
+    *h = s->h;
+}
+
+uint32_t lv_png_stream_get_mem_size(const lv_png_stream_t * s)
+{
+    return sizeof(lv_png_stream_t) + s->window_size + RING_LINES * s->stride;
+}
+
+lv_res_t lv_png_stream_read_line(lv_png_stream_t * s, lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf)
+{
+    if(x < 0 || y < 0 || len < 0 || (uint32_t)x + len > s->w || (uint32_t)y >= s->h) return LV_RES_INV;
+
+    /*The line is not in the ring anymore: start again from the first line*/
+    if((uint32_t)y + RING_LINES < s->next_y) {
+        if(!rewind_stream(s)) return LV_RES_INV;
+    }
+
+    while(s->next_y <= (uint32_t)y) {
+        if(!decode_line(s)) {
+            /*Decode from the first line next time instead of continuing from a broken state*/
+            s->next_y = UINT32_MAX - RING_LINES;
+            return LV_RES_INV;
+        }
+    }
+
+    convert_line(s, s->lines + (y % RING_LINES) * s->stride, x, len, buf);
+    return LV_RES_OK;
+}
+
+uint32_t lv_png_stream_get_pass_cnt(const lv_png_stream_t * s)
+{
+    return s->pass_cnt;
+}
+
+void lv_png_stream_close(lv_png_stream_t * s)
+{
+    if(s == NULL) return;
+
+    if(s->data == NULL) lv_fs_close(&s->f);
+    if(s->window) lv_mem_free(s->window);
+    lv_mem_free(s);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Read the header and the palette and find the first IDAT chunk
+ * @param s     pointer to an image whose source is opened
+ * @return      true: the image can be decoded line by line
+ */
+static bool parse_chunks(lv_png_stream_t * s)
+{
+    static const uint8_t magic[] = {0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a};
+    uint8_t buf[13];
+    if(!src_read(s, buf, 8) || memcmp(buf, magic, sizeof(magic))) return false;
+
+    bool ihdr = false;
+    while(1) {
+        if(!src_read(s, buf, 8)) return false;
+        uint32_t size = read_u32_be(buf);
+        const uint8_t * type = buf + 4;
+        uint32_t next_pos = s->pos + size + 4;          /*Skip the CRC too*/
+        if(next_pos < s->pos) return false;
+
+        if(memcmp(type, "IHDR", 4) == 0) {
+            if(size != 13 || !src_read(s, buf, 13)) return false;
+            s->w = read_u32_be(buf);
+            s->h = read_u32_be(buf + 4);
+            s->depth = buf[8];
+            s->color_type = buf[9];
+            if(buf[10] != 0 || buf[11] != 0) return false;  /*Unknown compression or filter method*/
+            if(buf[12] != 0) return false;                  /*Interlaced images can't be decoded line by line*/
+            if(s->w == 0 || s->h == 0 || s->w > (uint32_t)LV_COORD_MAX || s->h > (uint32_t)LV_COORD_MAX) return false;
+
+            uint32_t channels;
+            switch(s->color_type) {
+                case COLOR_GRAY:
+                    channels = 1;
+                    if(s->depth != 1 && s->depth != 2 && s->depth != 4 && s->depth != 8 && s->depth != 16) return false;
+                    break;
+                case COLOR_PALETTE:
+                    channels = 1;
+                    if(s->depth != 1 && s->depth != 2 && s->depth != 4 && s->depth != 8) return false;
+                    break;
+                case COLOR_RGB:
+                    channels = 3;
+                    break;
+                case COLOR_GRAY_ALPHA:
+                    channels = 2;
+                    break;
+                case COLOR_RGBA:
+                    channels = 4;
+                    break;
+                default:
+                    return false;
+            }
+            if(channels > 1 && s->depth != 8 && s->depth != 16) return false;
+
+            uint32_t bits = channels * s->depth;
+            s->stride = (s->w * bits + 7) / 8;
+            s->filter_bpp = bits >= 8 ? bits / 8 : 1;
+            ihdr = true;
+
+            /*All palette entries are opaque black unless defined*/
+            uint32_t i;
+            for(i = 0; i < 256; i++) s->palette[i][3] = 0xff;
+        }
+        else if(memcmp(type, "PLTE", 4) == 0) {
+            uint32_t i;
+            for(i = 0; i < size / 3 && i < 256; i++) {
+                if(!src_read(s, s->palette[i], 3)) return false;
+            }
+        }
+        else if(memcmp(type, "tRNS", 4) == 0) {
+            if(!ihdr) return false;
+            if(s->color_type == COLOR_PALETTE) {
+                uint32_t i;
+                for(i = 0; i < size && i < 256; i++) {
+                    if(!src_read(s, &s->palette[i][3], 1)) return false;
+                }
+            }
+            else if(s->color_type == COLOR_GRAY || s->color_type == COLOR_RGB) {
+                uint32_t cnt = s->color_type == COLOR_GRAY ? 1 : 3;
+                if(size != cnt * 2 || !src_read(s, buf, size)) return false;
+                uint32_t i;
+                for(i = 0; i < cnt; i++) s->key[i] = (buf[i * 2] << 8) | buf[i * 2 + 1];
+                s->has_key = true;
+            }
+        }
+        else if(memcmp(type, "IDAT", 4) == 0) {
+            if(!ihdr) return false;
+            s->first_idat_pos = s->pos;
+            s->first_idat_size = size;
+            return true;
+        }
+        else if(memcmp(type, "IEND", 4) == 0) {
+            return false;
+        }
+
+        if(!src_seek(s, next_pos)) return false;
+    }
+}
+
+/**
+ * Prepare to decode the first line
+ * @param s     pointer to an image
+ * @return      true: the zlib header is valid
+ */
+static bool rewind_stream(lv_png_stream_t * s)
+{
+    if(!src_seek(s, s->first_idat_pos)) return false;
+    s->idat_left = s->first_idat_size;
+    s->idat_end = false;
+
+    s->bit_buf = 0;
+    s->bit_cnt = 0;
+    s->pad_cnt = 0;
+    s->state = INFLATE_BLOCK_HEADER;
+    s->last_block = false;
+    s->copy_len = 0;
+    s->out_cnt = 0;
+    s->window_pos = 0;
+    s->next_y = 0;
+    s->pass_cnt++;
+
+    int32_t cmf = idat_byte(s);
+    int32_t flg = idat_byte(s);
+    if(cmf < 0 || flg < 0) return false;
+    if((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || (flg & 0x20) || ((cmf << 8) | flg) % 31) {
+        LV_LOG_WARN("invalid zlib header");
+        return false;
+    }
+
+    /*Distances can't be larger than the window declared in the header*/
+    if(s->window == NULL) s->window_size = 256U << (cmf >> 4);
+
+    return true;
+}
+
+/**
+ * Inflate and unfilter the next line into the ring
+ * @param s     pointer to an image
+ * @return      true: success
+ */
+static bool decode_line(lv_png_stream_t * s)
+{
+    uint8_t * line = s->lines + (s->next_y % RING_LINES) * s->stride;
+    const uint8_t * prev = s->next_y ? s->lines + ((s->next_y - 1) % RING_LINES) * s->stride : NULL;
+
+    uint8_t filter;
+    if(!inflate_read(s, &filter, 1)) return false;
+    if(!inflate_read(s, line, s->stride)) return false;
+    if(filter > 4) {
+        LV_LOG_WARN("invalid filter type: %d", filter);
+        return false;
+    }
+
+    unfilter(line, prev, s->stride, s->filter_bpp, filter);
+    s->next_y++;
+    return true;
+}
+
+static inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+    int32_t pa = LV_ABS((int32_t)b - c);
+    int32_t pb = LV_ABS((int32_t)a - c);
+    int32_t pc = LV_ABS((int32_t)a + b - c - c);
+    if(pa <= pb && pa <= pc) return a;
+    if(pb <= pc) return b;
+    return c;
+}
+
+/**
+ * Undo the filter of a line in place
+ * @param line      the filtered line
+ * @param prev      the previous unfiltered line or NULL for the first line
+ * @param size      bytes in a line
+ * @param bpp       bytes per complete pixel (at least 1)
+ * @param type      the filter type
+ */
+static void unfilter(uint8_t * line, const uint8_t * prev, uint32_t size, uint32_t bpp, uint8_t type)
+{
+    uint32_t i;
+    switch(type) {
+        case 1:     /*Sub*/
+            for(i = bpp; i < size; i++) line[i] += line[i - bpp];
+            break;
+        case 2:     /*Up*/
+            if(prev) {
+                for(i = 0; i < size; i++) line[i] += prev[i];
+            }
+            break;
+        case 3:     /*Average*/
+            if(prev) {
+                for(i = 0; i < bpp; i++) line[i] += prev[i] >> 1;
+                for(i = bpp; i < size; i++) line[i] += (line[i - bpp] + prev[i]) >> 1;
+            }
+            else {
+                for(i = bpp; i < size; i++) line[i] += line[i - bpp] >> 1;
+            }
+            break;
+        case 4:     /*Paeth*/
+            if(prev) {
+                for(i = 0; i < bpp; i++) line[i] += prev[i];
+                for(i = bpp; i < size; i++) line[i] += paeth(line[i - bpp], prev[i], prev[i - bpp]);
+            }
+            else {
+                for(i = bpp; i < size; i++) line[i] += line[i - bpp];
+            }
+            break;
+        default:    /*None*/
+            break;
+    }
+}
+
+static inline void set_px(uint8_t * buf, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+#if LV_COLOR_DEPTH == 32
+    lv_color32_t * c = (lv_color32_t *)buf;
+    c->ch.red = r;
+    c->ch.green = g;
+    c->ch.blue = b;
+    c->ch.alpha = a;
+#elif LV_COLOR_DEPTH == 16
+    lv_color_t c = lv_color_make(r, g, b);
+    buf[0] = c.full & 0xFF;
+    buf[1] = c.full >> 8;
+    buf[2] = a;
+#elif LV_COLOR_DEPTH == 8
+    lv_color_t c = lv_color_make(r, g, b);
+    buf[0] = c.full;
+    buf[1] = a;
+#elif LV_COLOR_DEPTH == 1
+    buf[0] = (r | g | b) > 128 ? 1 : 0;
+    buf[1] = a;
+#endif
+}
+
+/**
+ * Get a sample of a gray or palette image with less than 8 bits per pixel
+ */
+static inline uint8_t get_low_depth_sample(const uint8_t * line, uint32_t x, uint32_t depth)
+{
+    uint32_t bit = x * depth;
+    return (line[bit >> 3] >> (8 - depth - (bit & 0x7))) & ((1 << depth) - 1);
+}
+
+/**
+ * Convert a part of an unfiltered line to the system's color format with alpha byte
+ */
+static void convert_line(const lv_png_stream_t * s, const uint8_t * line, uint32_t x, uint32_t len, uint8_t * buf)
+{
+    uint32_t i;
+    uint32_t end = x + len;
+    uint32_t px_size = LV_IMG_PX_SIZE_ALPHA_BYTE;
+
+    if(s->color_type == COLOR_PALETTE) {
+        for(i = x; i < end; i++) {
+            uint8_t idx = s->depth == 8 ? line[i] : get_low_depth_sample(line, i, s->depth);
+            const uint8_t * c = s->palette[idx];
+            set_px(buf, c[0], c[1], c[2], c[3]);
+            buf += px_size;
+        }
+        return;
+    }
+
+    if(s->color_type == COLOR_GRAY) {
+        for(i = x; i < end; i++) {
+            uint16_t v;
+            uint8_t g;
+            if(s->depth == 16) {
+                v = (line[i * 2] << 8) | line[i * 2 + 1];
+                g = line[i * 2];
+            }
+            else if(s->depth == 8) {
+                v = line[i];
+                g = v;
+            }
+            else {
+                v = get_low_depth_sample(line, i, s->depth);
+                g = v * 255 / ((1 << s->depth) - 1);
+            }
+            set_px(buf, g, g, g, s->has_key && v == s->key[0] ? 0x00 : 0xff);
+            buf += px_size;
+        }
+        return;
+    }
+
+    /*8 or 16 bit samples: only their most significant byte is used*/
+    uint32_t sample = s->depth / 8;
+    const uint8_t * p = line + x * s->filter_bpp;
+    for(i = x; i < end; i++) {
+        switch(s->color_type) {
+            case COLOR_RGBA:
+                set_px(buf, p[0], p[sample], p[2 * sample], p[3 * sample]);
+                break;
+            case COLOR_GRAY_ALPHA:
+                set_px(buf, p[0], p[0], p[0], p[sample]);
+                break;
+            default: {  /*RGB*/
+                    uint8_t a = 0xff;
+                    if(s->has_key) {
+                        uint16_t r = sample == 2 ? (p[0] << 8) | p[1] : p[0];
+                        uint16_t g = sample == 2 ? (p[2] << 8) | p[3] : p[1];
+                        uint16_t b = sample == 2 ? (p[4] << 8) | p[5] : p[2];
+                        if(r == s->key[0] && g == s->key[1] && b == s->key[2]) a = 0x00;
+                    }
+                    set_px(buf, p[0], p[sample], p[2 * sample], a);
+                }
+                break;
+        }
+        p += s->filter_bpp;
+        buf += px_size;
+    }
+}
+
+/**
+ * Inflate the next bytes of the zlib stream
+ * @param s     pointer to an image
+ * @param out   store the bytes here
+ * @param len   number of bytes to inflate
+ * @return      true: success; false: the data is corrupted or ended
+ */
+static bool inflate_read(lv_png_stream_t * s, uint8_t * out, uint32_t len)
+{
+    uint8_t * window = s->window;
+    uint32_t mask = s->window_size - 1;
+
+    while(len) {
+        /*Continue copying a match*/
+        if(s->copy_len) {
+            uint32_t n = LV_MIN(s->copy_len, len);
+            uint32_t wpos = s->window_pos;
+            uint32_t rpos = wpos - s->copy_dist;
+            uint32_t i;
+            for(i = 0; i < n; i++) {
+                uint8_t b = window[(rpos + i) & mask];
+                window[(wpos + i) & mask] = b;
+                out[i] = b;
+            }
+            s->window_pos = (wpos + n) & mask;
+            s->copy_len -= n;
+            s->out_cnt += n;
+            out += n;
+            len -= n;
+            continue;
+        }
+
+        if(s->state == INFLATE_BLOCK_HEADER) {
+            if(s->last_block) return false;     /*More data was expected*/
+            if(!read_block_header(s)) return false;
+        }
+        else if(s->state == INFLATE_STORED) {
+            if(s->stored_left == 0) {
+                s->state = INFLATE_BLOCK_HEADER;
+                continue;
+            }
+            uint8_t b = get_bits(s, 8);
+            window[s->window_pos] = b;
+            s->window_pos = (s->window_pos + 1) & mask;
+            s->stored_left--;
+            s->out_cnt++;
+            *out = b;
+            out++;
+            len--;
+        }
+        else {
+            int32_t sym = huff_decode(s, &s->lit);
+            if(sym < 0) return false;
+            if(sym < 256) {
+                window[s->window_pos] = sym;
+                s->window_pos = (s->window_pos + 1) & mask;
+                s->out_cnt++;
+                *out = sym;
+                out++;
+                len--;
+            }
+            else if(sym == 256) {
+                s->state = INFLATE_BLOCK_HEADER;
+            }
+            else {
+                sym -= 257;
+                if(sym >= 29) return false;
+                s->copy_len = len_base[sym] + get_bits(s, len_extra[sym]);
+
+                sym = huff_decode(s, &s->dist);
+                if(sym < 0 || sym >= 30) return false;
+                s->copy_dist = dist_base[sym] + get_bits(s, dist_extra[sym]);
+                if(s->copy_dist > s->out_cnt || s->copy_dist > s->window_size) {
+                    LV_LOG_WARN("invalid distance: %" LV_PRIu32, s->copy_dist);
+                    return false;
+                }
+            }
+        }
+
+        /*Bits after the end of the data were used*/
+        if(s->pad_cnt * 8 > s->bit_cnt) return false;
+    }
+
+    return true;
+}
+
+static bool read_block_header(lv_png_stream_t * s)
+{
+    s->last_block = get_bits(s, 1);
+    uint32_t type = get_bits(s, 2);
+
+    if(type == 0) {
+        /*Stored block: skip to the byte boundary*/
+        get_bits(s, s->bit_cnt & 0x7);
+        uint32_t len = get_bits(s, 16);
+        uint32_t nlen = get_bits(s, 16);
+        if((len ^ 0xFFFF) != nlen) return false;
+        s->stored_left = len;
+        s->state = INFLATE_STORED;
+        return true;
+    }
+    else if(type == 1) {
+        uint8_t lens[288 + 30];
+        uint32_t i;
+        for(i = 0; i < 144; i++) lens[i] = 8;
+        for(; i < 256; i++) lens[i] = 9;
+        for(; i < 280; i++) lens[i] = 7;
+        for(; i < 288; i++) lens[i] = 8;
+        for(; i < 288 + 30; i++) lens[i] = 5;
+        huff_build(&s->lit, lens, 288);
+        huff_build(&s->dist, lens + 288, 30);
+        s->state = INFLATE_HUFFMAN;
+        return true;
+    }
+    else if(type == 2) {
+        if(!read_dynamic_tables(s)) return false;
+        s->state = INFLATE_HUFFMAN;
+        return true;
+    }
+
+    return false;
+}
+
+static bool read_dynamic_tables(lv_png_stream_t * s)
+{
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    uint8_t lens[288 + 32];
+
+    uint32_t nlen = get_bits(s, 5) + 257;
+    uint32_t ndist = get_bits(s, 5) + 1;
+    uint32_t ncode = get_bits(s, 4) + 4;
+    if(nlen > 286 || ndist > 30) return false;
+
+    /*The code of the code lengths. Build it in `dist` which is not used yet.*/
+    uint32_t i;
+    lv_memset_00(lens, 19);
+    for(i = 0; i < ncode; i++) lens[order[i]] = get_bits(s, 3);
+    if(!huff_build(&s->dist, lens, 19)) return false;
+
+    i = 0;
+    while(i < nlen + ndist) {
+        int32_t sym = huff_decode(s, &s->dist);
+        if(sym < 0) return false;
+        if(sym < 16) {
+            lens[i++] = sym;
+            continue;
+        }
+
+        uint8_t len = 0;
+        uint32_t rep;
+        if(sym == 16) {
+            if(i == 0) return false;
+            len = lens[i - 1];
+            rep = 3 + get_bits(s, 2);
+        }
+        else if(sym == 17) {
+            rep = 3 + get_bits(s, 3);
+        }
+        else {
+            rep = 11 + get_bits(s, 7);
+        }
+        if(i + rep > nlen + ndist) return false;
+        while(rep--) lens[i++] = len;
+    }
+
+    if(lens[256] == 0) return false;    /*No end of block code*/
+    if(s->pad_cnt * 8 > s->bit_cnt) return false;
+
+    return huff_build(&s->lit, lens, nlen) && huff_build(&s->dist, lens + nlen, ndist);
+}
+
+/**
+ * Build a canonical Huffman table from the lengths of the codes
+ * @param h     store the table here
+ * @param lens  length of the code of each symbol, 0: unused
+ * @param n     number of symbols
+ * @return      false: the lengths are over-subscribed
+ */
+static bool huff_build(huff_t * h, const uint8_t * lens, uint32_t n)
+{
+    uint16_t offs[16];
+    uint32_t sym;
+    uint32_t len;
+
+    lv_memset_00(h->count, sizeof(h->count));
+    for(sym = 0; sym < n; sym++) h->count[lens[sym]]++;
+    h->count[0] = 0;
+
+    int32_t left = 1;
+    for(len = 1; len < 16; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if(left < 0) return false;
+    }
+
+    offs[1] = 0;
+    for(len = 1; len < 15; len++) offs[len + 1] = offs[len] + h->count[len];
+    for(sym = 0; sym < n; sym++) {
+        if(lens[sym]) h->symbol[offs[lens[sym]]++] = sym;
+    }
+
+    /*Add the short codes to the lookup table. The bits of the codes are read in reversed order.*/
+    lv_memset_00(h->fast, sizeof(h->fast));
+    uint32_t code = 0;
+    uint32_t idx = 0;
+    for(len = 1; len <= FAST_BITS; len++) {
+        uint32_t i;
+        for(i = 0; i < h->count[len]; i++) {
+            uint32_t rev = 0;
+            uint32_t b;
+            for(b = 0; b < len; b++) rev |= ((code >> b) & 1) << (len - 1 - b);
+            for(; rev < (1 << FAST_BITS); rev += 1 << len) h->fast[rev] = (len << 9) | h->symbol[idx];
+            code++;
+            idx++;
+        }
+        code <<= 1;
+    }
+
+    return true;
+}
+
+static int32_t huff_decode(lv_png_stream_t * s, const huff_t * h)
+{
+    get_bits(s, 0);     /*Fill the bit buffer*/
+    uint16_t e = h->fast[s->bit_buf & FAST_MASK];
+    if(e) {
+        uint32_t len = e >> 9;
+        s->bit_buf >>= len;
+        s->bit_cnt -= len;
+        return e & FAST_SYM_MASK;
+    }
+
+    /*Longer codes: walk the canonical code bit by bit*/
+    int32_t code = 0;
+    int32_t first = 0;
+    int32_t index = 0;
+    uint32_t len;
+    for(len = 1; len < 16; len++) {
+        code |= get_bits(s, 1);
+        int32_t count = h->count[len];
+        if(code - count < first) return h->symbol[index + (code - first)];
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+/**
+ * Get the next bits of the zlib stream. The bit buffer is filled to at least 16 bits.
+ * After the end of the data zero bytes are added and counted in `pad_cnt`.
+ */
+static uint32_t get_bits(lv_png_stream_t * s, uint32_t n)
+{
+    while(s->bit_cnt < 16 || s->bit_cnt < n) {
+        int32_t b = idat_byte(s);
+        if(b < 0) {
+            b = 0;
+            s->pad_cnt++;
+        }
+        s->bit_buf |= (uint32_t)b << s->bit_cnt;
+        s->bit_cnt += 8;
+    }
+
+    uint32_t v = s->bit_buf & ((1UL << n) - 1);
+    s->bit_buf >>= n;
+    s->bit_cnt -= n;
+    return v;
+}
+
+/**
+ * Read the next byte of the zlib stream from the IDAT chunks
+ * @return      the byte or -1 at the end of the data
+ */
+static int32_t idat_byte(lv_png_stream_t * s)
+{
+    while(s->idat_left == 0) {
+        if(s->idat_end) return -1;
+
+        /*Skip the CRC and read the header of the next chunk*/
+        uint8_t buf[12];
+        if(!src_read(s, buf, 12) || memcmp(buf + 8, "IDAT", 4)) {
+            s->idat_end = true;
+            return -1;
+        }
+        s->idat_left = read_u32_be(buf + 4);
+    }
+
+    int32_t b = src_byte(s);
+    if(b < 0) {
+        s->idat_left = 0;
+        s->idat_end = true;
+        return -1;
+    }
+
+    s->idat_left--;
+    return b;
+}
+
+static bool src_read(lv_png_stream_t * s, uint8_t * buf, uint32_t len)
+{
+    while(len) {
+        int32_t b = src_byte(s);
+        if(b < 0) return false;
+        *buf = b;
+        buf++;
+        len--;
+    }
+    return true;
+}
+
+static inline int32_t src_byte(lv_png_stream_t * s)
+{
+    if(s->data) {
+        if(s->pos >= s->data_size) return -1;
+        return s->data[s->pos++];
+    }
+
+    if(s->in_pos >= s->in_len) {
+        uint32_t rn = 0;
+        lv_fs_read(&s->f, s->in_buf, IN_BUF_SIZE, &rn);
+        s->in_len = rn;
+        s->in_pos = 0;
+        if(rn == 0) return -1;
+    }
+    s->pos++;
+    return s->in_buf[s->in_pos++];
+}
+
+static bool src_seek(lv_png_stream_t * s, uint32_t pos)
+{
+    if(s->data) {
+        s->pos = pos;
+        return pos <= s->data_size;
+    }
+
+    /*Still in the read buffer?*/
+    uint32_t buf_start = s->pos - s->in_pos;
+    if(pos >= buf_start && pos <= buf_start + s->in_len) {
+        s->in_pos = pos - buf_start;
+        s->pos = pos;
+        return true;
+    }
+
+    s->in_len = 0;
+    s->in_pos = 0;
+    s->pos = pos;
+    return lv_fs_seek(&s->f, pos, LV_FS_SEEK_SET) == LV_FS_RES_OK;
+}
+
+static uint32_t read_u32_be(const uint8_t * p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+#endif /*LV_USE_PNG && LV_PNG_STREAM*/
@@ -0,0 +1,96 @@
+/**
+ * @file lv_png_stream.h
+ * Decode non-interlaced PNG images line by line with bounded memory.
+ */
+
+#ifndef LV_PNG_STREAM_H
+#define LV_PNG_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../../lv_conf_internal.h"
+#if LV_USE_PNG && LV_PNG_STREAM
+
+#include "../../../misc/lv_types.h"
+#include "../../../misc/lv_area.h"
+#include <stdint.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+struct _lv_png_stream_t;
+typedef struct _lv_png_stream_t lv_png_stream_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Open a PNG image for decoding it line by line.
+ * Only the inflate window (at most 32 kB) and two unfiltered lines are allocated,
+ * the whole image is never decoded into RAM.
+ * @param src       a file name or a pointer to an `lv_img_dsc_t` whose `data` is a PNG file
+ * @return          the opened image or NULL if `src` is not a PNG, it's interlaced or there is not enough memory
+ */
+lv_png_stream_t * lv_png_stream_open(const void * src);
+
+/**
+ * Get the size of an opened image
+ * @param stream    pointer to an opened image
+ * @param w         store the width here
+ * @param h         store the height here
+ */
+void lv_png_stream_get_size(const lv_png_stream_t * stream, uint32_t * w, uint32_t * h);
+
+/**
+ * Get the number of bytes allocated for an opened image
+ * @param stream    pointer to an opened image
+ * @return          the allocated size in bytes
+ */
+uint32_t lv_png_stream_get_mem_size(const lv_png_stream_t * stream);
+
+/**
+ * Decode a part of a line as ARGB pixels in the system's color depth (`LV_IMG_CF_TRUE_COLOR_ALPHA`).
+ * The lines are decoded in order: reading a line above the last two decoded lines starts decoding from the first line.
+ * @param stream    pointer to an opened image
+ * @param x         first pixel to decode
+ * @param y         the line to decode
+ * @param len       number of pixels to decode
+ * @param buf       store the pixels here (`len * LV_IMG_PX_SIZE_ALPHA_BYTE` bytes)
+ * @return          LV_RES_OK: success; LV_RES_INV: the area is out of the image or the data is corrupted
+ */
+lv_res_t lv_png_stream_read_line(lv_png_stream_t * stream, lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf);
+
+/**
+ * Get how many times an opened image was decoded from its first line
+ * @param stream    pointer to an opened image
+ * @return          number of decoding passes
+ */
+uint32_t lv_png_stream_get_pass_cnt(const lv_png_stream_t * stream);
+
+/**
+ * Close an image and free its memory
+ * @param stream    pointer to an opened image
+ */
+void lv_png_stream_close(lv_png_stream_t * stream);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_USE_PNG && LV_PNG_STREAM*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_PNG_STREAM_H*/
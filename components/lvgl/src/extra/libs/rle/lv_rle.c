@@ -0,0 +1,251 @@
+/**
+ * @file lv_rle.c
+ * Decoder of run-length encoded C array images.
+ * The lines are decoded on demand directly from the (flash) array without
+ * decompressing the whole image into RAM.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../../lvgl.h"
+#if LV_USE_RLE
+
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define RLE_OFS_CF          4
+#define RLE_OFS_DEPTH       5
+#define RLE_OFS_FLAGS       6
+#define RLE_OFS_RAW_SIZE    8
+
+#define RLE_PACKET_RUN      0x80
+#define RLE_PACKET_CNT_MASK 0x7F
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static lv_res_t decoder_info(lv_img_decoder_t * decoder, const void * src, lv_img_header_t * header);
+static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc);
+static lv_res_t decoder_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc,
+                                  lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf);
+static void decoder_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc);
+static uint32_t get_px_size(const uint8_t * data);
+static void fill_px(uint8_t * buf, const uint8_t * px, uint32_t px_size, uint32_t cnt);
+static uint32_t read_u32(const uint8_t * p);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_rle_stat_t rle_stat;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_rle_init(void)
+{
+    lv_img_decoder_t * dec = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(dec, decoder_info);
+    lv_img_decoder_set_open_cb(dec, decoder_open);
+    lv_img_decoder_set_read_line_cb(dec, decoder_read_line);
+    lv_img_decoder_set_close_cb(dec, decoder_close);
+}
+
+bool lv_rle_is_rle(const void * src)
+{
+    if(lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) return false;
+
+    const lv_img_dsc_t * dsc = src;
+    if(dsc->header.cf != LV_IMG_CF_RAW && dsc->header.cf != LV_IMG_CF_RAW_ALPHA) return false;
+    if(dsc->data == NULL || dsc->data_size < LV_RLE_HEADER_SIZE + 4 * (uint32_t)dsc->header.h) return false;
+
+    return memcmp(dsc->data, LV_RLE_MAGIC, 4) == 0;
+}
+
+uint32_t lv_rle_get_raw_size(const lv_img_dsc_t * dsc)
+{
+    if(!lv_rle_is_rle(dsc)) return 0;
+
+    return read_u32(dsc->data + RLE_OFS_RAW_SIZE);
+}
+
+lv_res_t lv_rle_read_line(const lv_img_dsc_t * dsc, lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf)
+{
+    if(!lv_rle_is_rle(dsc)) return LV_RES_INV;
+
+    uint32_t px_size = get_px_size(dsc->data);
+    if(px_size == 0) return LV_RES_INV;
+    if(x < 0 || y < 0 || len < 0 || x + len > dsc->header.w || y >= dsc->header.h) return LV_RES_INV;
+
+    const uint8_t * end = dsc->data + dsc->data_size;
+    const uint8_t * lines = dsc->data + LV_RLE_HEADER_SIZE + 4 * (uint32_t)dsc->header.h;
+    uint32_t line_ofs = read_u32(dsc->data + LV_RLE_HEADER_SIZE + 4 * (uint32_t)y);
+    if(line_ofs > (uint32_t)(end - lines)) return LV_RES_INV;
+
+    const uint8_t * line = lines + line_ofs;
+    const uint8_t * p = line;
+    uint32_t skip = x;
+    uint32_t left = len;
+    while(left) {
+        if(p >= end) return LV_RES_INV;
+
+        uint8_t c = *p;
+        p++;
+        bool run = c & RLE_PACKET_RUN;
+        uint32_t cnt = (c & RLE_PACKET_CNT_MASK) + 1;
+        uint32_t packet_size = run ? px_size : cnt * px_size;
+        if(packet_size > (uint32_t)(end - p)) return LV_RES_INV;
+
+        /*Skip the packets on the left of `x`*/
+        if(skip >= cnt) {
+            skip -= cnt;
+            p += packet_size;
+            continue;
+        }
+
+        uint32_t n = LV_MIN(cnt - skip, left);
+        if(run) fill_px(buf, p, px_size, n);
+        else lv_memcpy(buf, p + skip * px_size, n * px_size);
+
+        p += packet_size;
+        buf += n * px_size;
+        left -= n;
+        skip = 0;
+    }
+
+    rle_stat.line_cnt++;
+    rle_stat.px_cnt += len;
+    rle_stat.in_size += p - line;
+
+    return LV_RES_OK;
+}
+
+void lv_rle_get_stat(lv_rle_stat_t * stat)
+{
+    lv_memcpy_small(stat, &rle_stat, sizeof(lv_rle_stat_t));
+}
+
+void lv_rle_reset_stat(void)
+{
+    lv_memset_00(&rle_stat, sizeof(lv_rle_stat_t));
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static lv_res_t decoder_info(lv_img_decoder_t * decoder, const void * src, lv_img_header_t * header)
+{
+    LV_UNUSED(decoder);
+
+    if(!lv_rle_is_rle(src)) return LV_RES_INV;
+
+    const lv_img_dsc_t * dsc = src;
+    header->always_zero = 0;
+    header->w = dsc->header.w;
+    header->h = dsc->header.h;
+    header->cf = dsc->data[RLE_OFS_CF];
+
+    return LV_RES_OK;
+}
+
+static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc)
+{
+    LV_UNUSED(decoder);
+
+    if(!lv_rle_is_rle(dsc->src)) return LV_RES_INV;
+
+    const lv_img_dsc_t * img_dsc = dsc->src;
+    if(get_px_size(img_dsc->data) == 0) {
+        dsc->error_msg = "Color depth mismatch";
+        return LV_RES_INV;
+    }
+
+    /*Nothing to allocate: the lines are decoded from the array in `read_line`*/
+    dsc->img_data = NULL;
+    dsc->user_data = NULL;
+    rle_stat.open_cnt++;
+
+    return LV_RES_OK;
+}
+
+static lv_res_t decoder_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc,
+                                  lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf)
+{
+    LV_UNUSED(decoder);
+
+    return lv_rle_read_line(dsc->src, x, y, len, buf);
+}
+
+static void decoder_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc)
+{
+    LV_UNUSED(decoder);
+    LV_UNUSED(dsc);
+}
+
+/**
+ * Get the size of a pixel of an RLE image
+ * @param data      the data of an RLE image
+ * @return          the size in bytes or 0 if the image can't be drawn with this color depth
+ */
+static uint32_t get_px_size(const uint8_t * data)
+{
+    uint8_t depth = data[RLE_OFS_DEPTH];
+    bool swap = data[RLE_OFS_FLAGS] & LV_RLE_FLAG_16_SWAP;
+
+    if(depth != LV_COLOR_DEPTH || (depth == 16 && swap != LV_COLOR_16_SWAP)) {
+        LV_LOG_WARN("the image was converted for LV_COLOR_DEPTH %d%s", depth, swap ? " with LV_COLOR_16_SWAP" : "");
+        return 0;
+    }
+
+    switch(data[RLE_OFS_CF]) {
+        case LV_IMG_CF_TRUE_COLOR:
+        case LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED:
+            return LV_COLOR_SIZE / 8;
+        case LV_IMG_CF_TRUE_COLOR_ALPHA:
+            return LV_IMG_PX_SIZE_ALPHA_BYTE;
+        case LV_IMG_CF_ALPHA_8BIT:
+            return 1;
+        default:
+            LV_LOG_WARN("unsupported color format: %d", data[RLE_OFS_CF]);
+            return 0;
+    }
+}
+
+/**
+ * Repeat a pixel `cnt` times. Copy the already filled part to fill with few `memcpy`s.
+ */
+static void fill_px(uint8_t * buf, const uint8_t * px, uint32_t px_size, uint32_t cnt)
+{
+    if(px_size == 1) {
+        lv_memset(buf, px[0], cnt);
+        return;
+    }
+
+    lv_memcpy_small(buf, px, px_size);
+    uint32_t size = cnt * px_size;
+    uint32_t done = px_size;
+    while(done < size) {
+        uint32_t n = LV_MIN(done, size - done);
+        lv_memcpy(buf + done, buf, n);
+        done += n;
+    }
+}
+
+static uint32_t read_u32(const uint8_t * p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+#endif /*LV_USE_RLE*/
@@ -0,0 +1,113 @@
+/**
+ * @file lv_rle.h
+ *
+ */
+
+#ifndef LV_RLE_H
+#define LV_RLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../../lv_conf_internal.h"
+#if LV_USE_RLE
+
+#include "../../../draw/lv_img_buf.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Layout of the `data` of an RLE compressed `lv_img_dsc_t` (all numbers are little endian):
+ * - 4 bytes: `LV_RLE_MAGIC`
+ * - 1 byte:  color format of the decoded image (`LV_IMG_CF_TRUE_COLOR`, `LV_IMG_CF_TRUE_COLOR_ALPHA`,
+ *            `LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED` or `LV_IMG_CF_ALPHA_8BIT`)
+ * - 1 byte:  `LV_COLOR_DEPTH` the image was converted for
+ * - 1 byte:  flags, `LV_RLE_FLAG_16_SWAP` if converted for `LV_COLOR_16_SWAP`
+ * - 1 byte:  reserved
+ * - 4 bytes: size of the decoded image in bytes
+ * - 4 bytes for each line: offset of the line from the end of this table
+ * - the lines: packets starting with a control byte `c`.
+ *   If `c & 0x80` the next pixel is repeated `(c & 0x7F) + 1` times,
+ *   else `c + 1` pixels follow as they are.
+ * The pixels are stored in the same format as in the uncompressed image.
+ * The header's color format of the `lv_img_dsc_t` is `LV_IMG_CF_RAW_ALPHA` or `LV_IMG_CF_RAW`. */
+#define LV_RLE_MAGIC            "LVRL"
+#define LV_RLE_HEADER_SIZE      12
+#define LV_RLE_FLAG_16_SWAP     0x01
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**
+ * Statistics about decoding RLE images
+ */
+typedef struct {
+    uint32_t open_cnt;      /**< Number of times an image was opened (e.g. once per draw without image cache)*/
+    uint32_t line_cnt;      /**< Number of decoded lines*/
+    uint32_t px_cnt;        /**< Number of decoded pixels*/
+    uint32_t in_size;       /**< Compressed bytes processed (including the skipped part of the lines)*/
+} lv_rle_stat_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Register the decoder of RLE compressed images.
+ */
+void lv_rle_init(void);
+
+/**
+ * Tell whether an image source is an RLE compressed image
+ * @param src       pointer to an `lv_img_dsc_t`
+ * @return          true: `src` is RLE compressed
+ */
+bool lv_rle_is_rle(const void * src);
+
+/**
+ * Get the size of an RLE compressed image when decoded.
+ * The flash saved by compression is `lv_rle_get_raw_size(dsc) - dsc->data_size`.
+ * @param dsc       pointer to an RLE compressed image
+ * @return          the size in bytes, or 0 if `dsc` is not RLE compressed
+ */
+uint32_t lv_rle_get_raw_size(const lv_img_dsc_t * dsc);
+
+/**
+ * Decode a part of a line of an RLE compressed image
+ * @param dsc       pointer to an RLE compressed image
+ * @param x         first pixel to decode
+ * @param y         the line to decode
+ * @param len       number of pixels to decode
+ * @param buf       store the pixels here in the format of the uncompressed image
+ * @return          LV_RES_OK: success; LV_RES_INV: `dsc` is not RLE compressed or the area is out of the image
+ */
+lv_res_t lv_rle_read_line(const lv_img_dsc_t * dsc, lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t * buf);
+
+/**
+ * Get the statistics about decoding RLE images since the last `lv_rle_reset_stat()`
+ * @param stat      store the statistics here
+ */
+void lv_rle_get_stat(lv_rle_stat_t * stat);
+
+/**
+ * Clear the statistics about decoding RLE images
+ */
+void lv_rle_reset_stat(void);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_USE_RLE*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_RLE_H*/
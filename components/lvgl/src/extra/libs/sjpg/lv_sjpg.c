@@ -39,6 +39,13 @@
 /   We are using TJpgDec - Tiny JPEG Decompressor library from ELM-CHAN for decoding each split-jpeg fragments.
 /   The tjpgd.c and tjpgd.h is not modified and those are used as it is. So if any update comes for the tiny-jpeg,
 /   just replace those files with updated files.
+/
+/                   FRAGMENT CACHE
+/                   --------------
+/   The decoded fragments are kept in a cache shared by all images (LV_SJPG_CACHE_SIZE bytes) so that redrawing
+/   an image doesn't decode it again, even if the image was closed in the meantime. When the cache is full,
+/   the least recently used fragments are freed. A fragment which doesn't fit into the cache is decoded into
+/   the image's own buffer like a single fragment cache.
 /---------------------------------------------------------------------------------------------------------------------------------*/
 
 /*********************
@@ -55,7 +62,13 @@
 /*********************
  *      DEFINES
  *********************/
-#define TJPGD_WORKBUFF_SIZE             4096    //Recommended by TJPGD libray
+#if JD_FASTDECODE == 2
+    #define TJPGD_WORKBUFF_SIZE         (4096 + 6 * 1024)   //+ the fast huffman decode tables
+#else
+    #define TJPGD_WORKBUFF_SIZE         4096    //Recommended by TJPGD libray
+#endif
+
+#define SJPEG_CACHE_SLOT_CNT            32      //Max. number of cached fragments
 
 //NEVER EDIT THESE OFFSET VALUES
 #define SJPEG_VERSION_OFFSET            8
@@ -93,15 +106,29 @@ typedef struct {
     int sjpeg_y_res;
     int sjpeg_total_frames;
     int sjpeg_single_frame_height;
-    int sjpeg_cache_frame_index;
+    int sjpeg_cache_frame_index;        //the fragment of the last read line
     uint8_t ** frame_base_array;        //to save base address of each split frames upto sjpeg_total_frames.
     int * frame_base_offset;            //to save base offset for fseek
-    uint8_t * frame_cache;
+    uint8_t * frame_cache;              //own buffer for fragments not fitting into the shared cache
+    int cache_slot;                     //slot of `sjpeg_cache_frame_index` in the shared cache or -1
+    uint32_t cache_slot_gen;            //`gen` of the slot when it was used
+    const void * src;
+    lv_img_src_t src_type;
     uint8_t * workb;                    //JPG work buffer for jpeg library
     JDEC * tjpeg_jd;
     io_source_t io;
 } SJPEG;
 
+typedef struct {
+    void * src;                         //the `lv_img_dsc_t` or a copy of the file name, NULL: unused slot
+    lv_img_src_t src_type;
+    int frame_index;
+    uint8_t * buf;                      //the decoded fragment as `lv_color_t` pixels
+    uint32_t size;
+    uint32_t life;                      //the last use to find the least recently used fragment
+    uint32_t gen;                       //changes whenever the slot is freed
+} sjpeg_cache_slot_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -114,10 +141,33 @@ static size_t input_func(JDEC * jd, uint8_t * buff, size_t ndata);
 static int is_jpg(const uint8_t * raw_data, size_t len);
 static void lv_sjpg_cleanup(SJPEG * sjpeg);
 static void lv_sjpg_free(SJPEG * sjpeg);
+static const uint8_t * get_frame(SJPEG * sjpeg, int frame_index);
+static lv_res_t decode_frame(SJPEG * sjpeg, int frame_index, uint8_t * buf);
+static uint32_t get_frame_size(const SJPEG * sjpeg);
+static bool src_equal(const void * src, lv_img_src_t src_type, const sjpeg_cache_slot_t * slot);
+static sjpeg_cache_slot_t * cache_find(const void * src, lv_img_src_t src_type, int frame_index);
+static sjpeg_cache_slot_t * cache_add(const void * src, lv_img_src_t src_type, int frame_index, uint32_t size,
+                                      bool evict);
+static void cache_drop(sjpeg_cache_slot_t * slot);
+#if LV_SJPG_PREFETCH
+static void prefetch_request(const SJPEG * sjpeg, int frame_index);
+static void prefetch_timer_cb(lv_timer_t * t);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static sjpeg_cache_slot_t cache_slots[SJPEG_CACHE_SLOT_CNT];
+static uint32_t cache_size_max = LV_SJPG_CACHE_SIZE;
+static uint32_t cache_life;
+static lv_sjpg_stat_t sjpg_stat;
+
+#if LV_SJPG_PREFETCH
+static lv_timer_t * prefetch_timer;
+static void * prefetch_src;             //the `lv_img_dsc_t` or a copy of the file name
+static lv_img_src_t prefetch_src_type;
+static int prefetch_frame_index;
+#endif
 
 /**********************
  *      MACROS
@@ -133,6 +183,49 @@ void lv_split_jpeg_init(void)
     lv_img_decoder_set_open_cb(dec, decoder_open);
     lv_img_decoder_set_close_cb(dec, decoder_close);
     lv_img_decoder_set_read_line_cb(dec, decoder_read_line);
+
+#if LV_SJPG_PREFETCH
+    /*Decode the next fragment when LVGL is idle: after the refresh which needed the current one*/
+    prefetch_timer = lv_timer_create(prefetch_timer_cb, 0, NULL);
+    lv_timer_pause(prefetch_timer);
+#endif
+}
+
+void lv_sjpg_cache_set_size(uint32_t size)
+{
+    cache_size_max = size;
+
+    while(sjpg_stat.cache_size > cache_size_max) {
+        sjpeg_cache_slot_t * lru = NULL;
+        uint32_t i;
+        for(i = 0; i < SJPEG_CACHE_SLOT_CNT; i++) {
+            if(cache_slots[i].src && (lru == NULL || cache_slots[i].life < lru->life)) lru = &cache_slots[i];
+        }
+        if(lru == NULL) break;
+        cache_drop(lru);
+    }
+}
+
+void lv_sjpg_cache_invalidate_src(const void * src)
+{
+    lv_img_src_t src_type = src ? lv_img_src_get_type(src) : LV_IMG_SRC_UNKNOWN;
+    uint32_t i;
+    for(i = 0; i < SJPEG_CACHE_SLOT_CNT; i++) {
+        if(cache_slots[i].src == NULL) continue;
+        if(src == NULL || src_equal(src, src_type, &cache_slots[i])) cache_drop(&cache_slots[i]);
+    }
+}
+
+void lv_sjpg_get_stat(lv_sjpg_stat_t * stat)
+{
+    lv_memcpy_small(stat, &sjpg_stat, sizeof(lv_sjpg_stat_t));
+}
+
+void lv_sjpg_reset_stat(void)
+{
+    uint32_t cache_size = sjpg_stat.cache_size;
+    lv_memset_00(&sjpg_stat, sizeof(lv_sjpg_stat_t));
+    sjpg_stat.cache_size = cache_size;
 }
 
 /**********************
@@ -283,17 +376,18 @@ end:
 static int img_data_cb(JDEC * jd, void * data, JRECT * rect)
 {
     io_source_t * io = jd->device;
-    uint8_t * cache = io->img_cache_buff;
+    lv_color_t * cache = (lv_color_t *)io->img_cache_buff;
     const int xres = io->img_cache_x_res;
     uint8_t * buf = data;
-    const int INPUT_PIXEL_SIZE = 3;
     const int row_width = rect->right - rect->left + 1; // Row width in pixels.
-    const int row_size = row_width * INPUT_PIXEL_SIZE;  // Row size (bytes).
 
+    /*Convert the RGB888 pixels only once here so reading a line from the cache is a simple copy*/
     for(int y = rect->top; y <= rect->bottom; y++) {
-        int row_offset = y * xres * INPUT_PIXEL_SIZE + rect->left * INPUT_PIXEL_SIZE;
-        memcpy(cache + row_offset, buf, row_size);
-        buf += row_size;
+        lv_color_t * row = cache + y * xres + rect->left;
+        for(int x = 0; x < row_width; x++) {
+            row[x] = lv_color_make(buf[0], buf[1], buf[2]);
+            buf += 3;
+        }
     }
 
     return 1;
@@ -359,6 +453,8 @@ static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t *
             dsc->user_data = sjpeg;
             sjpeg->sjpeg_data = (uint8_t *)((lv_img_dsc_t *)(dsc->src))->data;
             sjpeg->sjpeg_data_size = ((lv_img_dsc_t *)(dsc->src))->data_size;
+            sjpeg->src = dsc->src;
+            sjpeg->src_type = dsc->src_type;
         }
 
         if(!strncmp((char *) sjpeg->sjpeg_data, "_SJPG__", strlen("_SJPG__"))) {
@@ -396,13 +492,7 @@ static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t *
                 sjpeg->frame_base_array[i] = sjpeg->frame_base_array[i - 1] + offset;
             }
             sjpeg->sjpeg_cache_frame_index = -1;
-            sjpeg->frame_cache = (void *)lv_mem_alloc(sjpeg->sjpeg_x_res * sjpeg->sjpeg_single_frame_height * 3/*2*/);
-            if(! sjpeg->frame_cache) {
-                lv_sjpg_cleanup(sjpeg);
-                sjpeg = NULL;
-                return LV_RES_INV;
-            }
-            sjpeg->io.img_cache_buff = sjpeg->frame_cache;
+            sjpeg->cache_slot = -1;
             sjpeg->io.img_cache_x_res = sjpeg->sjpeg_x_res;
             sjpeg->workb =   lv_mem_alloc(TJPGD_WORKBUFF_SIZE);
             if(! sjpeg->workb) {
@@ -459,14 +549,7 @@ static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t *
                 sjpeg->frame_base_array[0] = img_frame_base;
 
                 sjpeg->sjpeg_cache_frame_index = -1;
-                sjpeg->frame_cache = (void *)lv_mem_alloc(sjpeg->sjpeg_x_res * sjpeg->sjpeg_single_frame_height * 3);
-                if(! sjpeg->frame_cache) {
-                    lv_sjpg_cleanup(sjpeg);
-                    sjpeg = NULL;
-                    return LV_RES_INV;
-                }
-
-                sjpeg->io.img_cache_buff = sjpeg->frame_cache;
+                sjpeg->cache_slot = -1;
                 sjpeg->io.img_cache_x_res = sjpeg->sjpeg_x_res;
                 sjpeg->workb =   lv_mem_alloc(TJPGD_WORKBUFF_SIZE);
                 if(! sjpeg->workb) {
@@ -536,8 +619,8 @@ end:
                     memset(sjpeg, 0, sizeof(SJPEG));
 
                     dsc->user_data = sjpeg;
-                    sjpeg->sjpeg_data = (uint8_t *)((lv_img_dsc_t *)(dsc->src))->data;
-                    sjpeg->sjpeg_data_size = ((lv_img_dsc_t *)(dsc->src))->data_size;
+                    sjpeg->src = dsc->src;
+                    sjpeg->src_type = dsc->src_type;
                 }
                 data = buff;
                 data += 14;
@@ -577,14 +660,8 @@ end:
                     sjpeg->frame_base_offset[i] = sjpeg->frame_base_offset[i - 1] + offset;
                 }
 
-                sjpeg->sjpeg_cache_frame_index = -1; //INVALID AT BEGINNING for a forced compare mismatch at first time.
-                sjpeg->frame_cache = (void *)lv_mem_alloc(sjpeg->sjpeg_x_res * sjpeg->sjpeg_single_frame_height * 3);
-                if(! sjpeg->frame_cache) {
-                    lv_fs_close(&lv_file);
-                    lv_sjpg_cleanup(sjpeg);
-                    return LV_RES_INV;
-                }
-                sjpeg->io.img_cache_buff = sjpeg->frame_cache;
+                sjpeg->sjpeg_cache_frame_index = -1;
+                sjpeg->cache_slot = -1;
                 sjpeg->io.img_cache_x_res = sjpeg->sjpeg_x_res;
                 sjpeg->workb =   lv_mem_alloc(TJPGD_WORKBUFF_SIZE);
                 if(! sjpeg->workb) {
@@ -624,8 +701,8 @@ end:
 
                 memset(sjpeg, 0, sizeof(SJPEG));
                 dsc->user_data = sjpeg;
-                sjpeg->sjpeg_data = (uint8_t *)((lv_img_dsc_t *)(dsc->src))->data;
-                sjpeg->sjpeg_data_size = ((lv_img_dsc_t *)(dsc->src))->data_size;
+                sjpeg->src = dsc->src;
+                sjpeg->src_type = dsc->src_type;
             }
 
             uint8_t * workb_temp = lv_mem_alloc(TJPGD_WORKBUFF_SIZE);
@@ -666,14 +743,7 @@ end:
                 sjpeg->frame_base_offset[0] = img_frame_start_offset;
 
                 sjpeg->sjpeg_cache_frame_index = -1;
-                sjpeg->frame_cache = (void *)lv_mem_alloc(sjpeg->sjpeg_x_res * sjpeg->sjpeg_single_frame_height * 3);
-                if(! sjpeg->frame_cache) {
-                    lv_fs_close(&lv_file);
-                    lv_sjpg_cleanup(sjpeg);
-                    return LV_RES_INV;
-                }
-
-                sjpeg->io.img_cache_buff = sjpeg->frame_cache;
+                sjpeg->cache_slot = -1;
                 sjpeg->io.img_cache_x_res = sjpeg->sjpeg_x_res;
                 sjpeg->workb =   lv_mem_alloc(TJPGD_WORKBUFF_SIZE);
                 if(! sjpeg->workb) {
@@ -722,143 +792,16 @@ static lv_res_t decoder_read_line(lv_img_decoder_t * decoder, lv_img_decoder_dsc
                                   lv_coord_t len, uint8_t * buf)
 {
     LV_UNUSED(decoder);
-    if(dsc->src_type == LV_IMG_SRC_VARIABLE) {
-        SJPEG * sjpeg = (SJPEG *) dsc->user_data;
-        JRESULT rc;
-
-        int sjpeg_req_frame_index = y / sjpeg->sjpeg_single_frame_height;
-
-        /*If line not from cache, refresh cache */
-        if(sjpeg_req_frame_index != sjpeg->sjpeg_cache_frame_index) {
-            sjpeg->io.raw_sjpg_data = sjpeg->frame_base_array[ sjpeg_req_frame_index ];
-            if(sjpeg_req_frame_index == (sjpeg->sjpeg_total_frames - 1)) {
-                /*This is the last frame. */
-                const uint32_t frame_offset = (uint32_t)(sjpeg->io.raw_sjpg_data - sjpeg->sjpeg_data);
-                sjpeg->io.raw_sjpg_data_size = sjpeg->sjpeg_data_size - frame_offset;
-            }
-            else {
-                sjpeg->io.raw_sjpg_data_size =
-                    (uint32_t)(sjpeg->frame_base_array[sjpeg_req_frame_index + 1] - sjpeg->io.raw_sjpg_data);
-            }
-            sjpeg->io.raw_sjpg_data_next_read_pos = 0;
-            rc = jd_prepare(sjpeg->tjpeg_jd, input_func, sjpeg->workb, (size_t)TJPGD_WORKBUFF_SIZE, &(sjpeg->io));
-            if(rc != JDR_OK) return LV_RES_INV;
-            rc = jd_decomp(sjpeg->tjpeg_jd, img_data_cb, 0);
-            if(rc != JDR_OK) return LV_RES_INV;
-            sjpeg->sjpeg_cache_frame_index = sjpeg_req_frame_index;
-        }
-
-        int offset = 0;
-        uint8_t * cache = (uint8_t *)sjpeg->frame_cache + x * 3 + (y % sjpeg->sjpeg_single_frame_height) * sjpeg->sjpeg_x_res *
-                          3;
-
-#if  LV_COLOR_DEPTH == 32
-        for(int i = 0; i < len; i++) {
-            buf[offset + 3] = 0xff;
-            buf[offset + 2] = *cache++;
-            buf[offset + 1] = *cache++;
-            buf[offset + 0] = *cache++;
-            offset += 4;
-        }
-
-#elif  LV_COLOR_DEPTH == 16
-
-        for(int i = 0; i < len; i++) {
-            uint16_t col_16bit = (*cache++ & 0xf8) << 8;
-            col_16bit |= (*cache++ & 0xFC) << 3;
-            col_16bit |= (*cache++ >> 3);
-#if  LV_BIG_ENDIAN_SYSTEM == 1 || LV_COLOR_16_SWAP == 1
-            buf[offset++] = col_16bit >> 8;
-            buf[offset++] = col_16bit & 0xff;
-#else
-            buf[offset++] = col_16bit & 0xff;
-            buf[offset++] = col_16bit >> 8;
-#endif // LV_BIG_ENDIAN_SYSTEM
-        }
-
-#elif  LV_COLOR_DEPTH == 8
-
-        for(int i = 0; i < len; i++) {
-            uint8_t col_8bit = (*cache++ & 0xC0);
-            col_8bit |= (*cache++ & 0xe0) >> 2;
-            col_8bit |= (*cache++ & 0xe0) >> 5;
-            buf[offset++] = col_8bit;
-        }
-#else
-#error Unsupported LV_COLOR_DEPTH
-
-
-#endif // LV_COLOR_DEPTH
-        return LV_RES_OK;
-    }
-    else if(dsc->src_type == LV_IMG_SRC_FILE) {
-        SJPEG * sjpeg = (SJPEG *) dsc->user_data;
-        JRESULT rc;
-        int sjpeg_req_frame_index = y / sjpeg->sjpeg_single_frame_height;
-
-        lv_fs_file_t * lv_file_p = &(sjpeg->io.lv_file);
-        if(!lv_file_p) goto end;
-
-        /*If line not from cache, refresh cache */
-        if(sjpeg_req_frame_index != sjpeg->sjpeg_cache_frame_index) {
-            sjpeg->io.raw_sjpg_data_next_read_pos = (int)(sjpeg->frame_base_offset [ sjpeg_req_frame_index ]);
-            lv_fs_seek(&(sjpeg->io.lv_file), sjpeg->io.raw_sjpg_data_next_read_pos, LV_FS_SEEK_SET);
-
-            rc = jd_prepare(sjpeg->tjpeg_jd, input_func, sjpeg->workb, (size_t)TJPGD_WORKBUFF_SIZE, &(sjpeg->io));
-            if(rc != JDR_OK) return LV_RES_INV;
-
-            rc = jd_decomp(sjpeg->tjpeg_jd, img_data_cb, 0);
-            if(rc != JDR_OK) return LV_RES_INV;
-
-            sjpeg->sjpeg_cache_frame_index = sjpeg_req_frame_index;
-        }
-
-        int offset = 0;
-        uint8_t * cache = (uint8_t *)sjpeg->frame_cache + x * 3 + (y % sjpeg->sjpeg_single_frame_height) * sjpeg->sjpeg_x_res *
-                          3;
-
-#if LV_COLOR_DEPTH == 32
-        for(int i = 0; i < len; i++) {
-            buf[offset + 3] = 0xff;
-            buf[offset + 2] = *cache++;
-            buf[offset + 1] = *cache++;
-            buf[offset + 0] = *cache++;
-            offset += 4;
-        }
-#elif  LV_COLOR_DEPTH == 16
-
-        for(int i = 0; i < len; i++) {
-            uint16_t col_8bit = (*cache++ & 0xf8) << 8;
-            col_8bit |= (*cache++ & 0xFC) << 3;
-            col_8bit |= (*cache++ >> 3);
-#if  LV_BIG_ENDIAN_SYSTEM == 1 || LV_COLOR_16_SWAP == 1
-            buf[offset++] = col_8bit >> 8;
-            buf[offset++] = col_8bit & 0xff;
-#else
-            buf[offset++] = col_8bit & 0xff;
-            buf[offset++] = col_8bit >> 8;
-#endif // LV_BIG_ENDIAN_SYSTEM
-        }
-
-#elif  LV_COLOR_DEPTH == 8
-
-        for(int i = 0; i < len; i++) {
-            uint8_t col_8bit = (*cache++ & 0xC0);
-            col_8bit |= (*cache++ & 0xe0) >> 2;
-            col_8bit |= (*cache++ & 0xe0) >> 5;
-            buf[offset++] = col_8bit;
-        }
-
-#else
-#error Unsupported LV_COLOR_DEPTH
-
+    SJPEG * sjpeg = (SJPEG *) dsc->user_data;
+    if(!sjpeg) return LV_RES_INV;
+    if(x < 0 || len < 0 || x + len > sjpeg->sjpeg_x_res || y < 0 || y >= sjpeg->sjpeg_y_res) return LV_RES_INV;
 
-#endif // LV_COLOR_DEPTH
+    const uint8_t * frame = get_frame(sjpeg, y / sjpeg->sjpeg_single_frame_height);
+    if(!frame) return LV_RES_INV;
 
-        return LV_RES_OK;
-    }
-end:
-    return LV_RES_INV;
+    uint32_t px_ofs = (y % sjpeg->sjpeg_single_frame_height) * sjpeg->sjpeg_x_res + x;
+    lv_memcpy(buf, frame + px_ofs * sizeof(lv_color_t), len * sizeof(lv_color_t));
+    return LV_RES_OK;
 }
 
 /**
@@ -897,6 +840,253 @@ static int is_jpg(const uint8_t * raw_data, size_t len)
     return memcmp(jpg_signature, raw_data, sizeof(jpg_signature)) == 0;
 }
 
+/**
+ * Get a decoded fragment from the cache or decode it
+ * @param sjpeg         pointer to an opened image
+ * @param frame_index   index of the fragment
+ * @return              the pixels of the fragment as `lv_color_t` or NULL on error
+ */
+static const uint8_t * get_frame(SJPEG * sjpeg, int frame_index)
+{
+    /*Most of the time the line is in the same fragment as the previous one*/
+    if(frame_index == sjpeg->sjpeg_cache_frame_index) {
+        if(sjpeg->cache_slot < 0) return sjpeg->frame_cache;
+        sjpeg_cache_slot_t * slot = &cache_slots[sjpeg->cache_slot];
+        if(slot->gen == sjpeg->cache_slot_gen) return slot->buf;
+    }
+
+    uint32_t frame_size = get_frame_size(sjpeg);
+    if(frame_size <= cache_size_max) {
+        sjpeg_cache_slot_t * slot = cache_find(sjpeg->src, sjpeg->src_type, frame_index);
+        if(slot) {
+            sjpg_stat.hit_cnt++;
+        }
+        else {
+            slot = cache_add(sjpeg->src, sjpeg->src_type, frame_index, frame_size, true);
+            if(slot && decode_frame(sjpeg, frame_index, slot->buf) != LV_RES_OK) {
+                cache_drop(slot);
+                sjpeg->sjpeg_cache_frame_index = -1;
+                return NULL;
+            }
+#if LV_SJPG_PREFETCH
+            if(slot) prefetch_request(sjpeg, frame_index + 1);
+#endif
+        }
+
+        if(slot) {
+            slot->life = ++cache_life;
+            sjpeg->cache_slot = (int)(slot - cache_slots);
+            sjpeg->cache_slot_gen = slot->gen;
+            sjpeg->sjpeg_cache_frame_index = frame_index;
+            return slot->buf;
+        }
+        /*Not enough memory for the cache, use the image's own buffer*/
+    }
+
+    if(sjpeg->frame_cache == NULL) {
+        sjpeg->frame_cache = lv_mem_alloc(frame_size);
+        if(sjpeg->frame_cache == NULL) {
+            LV_LOG_WARN("couldn't allocate %d bytes for a fragment", (int)frame_size);
+            return NULL;
+        }
+    }
+
+    sjpeg->cache_slot = -1;
+    sjpeg->sjpeg_cache_frame_index = -1;
+    if(decode_frame(sjpeg, frame_index, sjpeg->frame_cache) != LV_RES_OK) return NULL;
+    sjpeg->sjpeg_cache_frame_index = frame_index;
+    return sjpeg->frame_cache;
+}
+
+static lv_res_t decode_frame(SJPEG * sjpeg, int frame_index, uint8_t * buf)
+{
+    if(frame_index < 0 || frame_index >= sjpeg->sjpeg_total_frames) return LV_RES_INV;
+
+    if(sjpeg->io.type == SJPEG_IO_SOURCE_C_ARRAY) {
+        sjpeg->io.raw_sjpg_data = sjpeg->frame_base_array[frame_index];
+        if(frame_index == (sjpeg->sjpeg_total_frames - 1)) {
+            /*This is the last frame. */
+            const uint32_t frame_offset = (uint32_t)(sjpeg->io.raw_sjpg_data - sjpeg->sjpeg_data);
+            sjpeg->io.raw_sjpg_data_size = sjpeg->sjpeg_data_size - frame_offset;
+        }
+        else {
+            sjpeg->io.raw_sjpg_data_size =
+                (uint32_t)(sjpeg->frame_base_array[frame_index + 1] - sjpeg->io.raw_sjpg_data);
+        }
+        sjpeg->io.raw_sjpg_data_next_read_pos = 0;
+    }
+    else {
+        sjpeg->io.raw_sjpg_data_next_read_pos = (int)(sjpeg->frame_base_offset[frame_index]);
+        lv_fs_seek(&(sjpeg->io.lv_file), sjpeg->io.raw_sjpg_data_next_read_pos, LV_FS_SEEK_SET);
+    }
+
+    sjpeg->io.img_cache_buff = buf;
+
+    uint32_t t = lv_tick_get();
+    JRESULT rc = jd_prepare(sjpeg->tjpeg_jd, input_func, sjpeg->workb, (size_t)TJPGD_WORKBUFF_SIZE, &(sjpeg->io));
+    if(rc == JDR_OK) rc = jd_decomp(sjpeg->tjpeg_jd, img_data_cb, 0);
+    if(rc != JDR_OK) {
+        LV_LOG_WARN("decoding fragment %d failed (%d)", frame_index, (int)rc);
+        return LV_RES_INV;
+    }
+    uint32_t elaps = lv_tick_elaps(t);
+
+    sjpg_stat.decode_cnt++;
+    sjpg_stat.decode_time += elaps;
+    if(elaps > sjpg_stat.decode_time_max) sjpg_stat.decode_time_max = elaps;
+    LV_LOG_TRACE("fragment %d decoded in %d ms", frame_index, (int)elaps);
+
+    return LV_RES_OK;
+}
+
+static uint32_t get_frame_size(const SJPEG * sjpeg)
+{
+    return (uint32_t)sjpeg->sjpeg_x_res * sjpeg->sjpeg_single_frame_height * sizeof(lv_color_t);
+}
+
+static bool src_equal(const void * src, lv_img_src_t src_type, const sjpeg_cache_slot_t * slot)
+{
+    if(src_type != slot->src_type) return false;
+    if(src_type == LV_IMG_SRC_FILE) return strcmp(src, slot->src) == 0;
+    return src == slot->src;
+}
+
+static sjpeg_cache_slot_t * cache_find(const void * src, lv_img_src_t src_type, int frame_index)
+{
+    uint32_t i;
+    for(i = 0; i < SJPEG_CACHE_SLOT_CNT; i++) {
+        sjpeg_cache_slot_t * slot = &cache_slots[i];
+        if(slot->src && slot->frame_index == frame_index && src_equal(src, src_type, slot)) return slot;
+    }
+    return NULL;
+}
+
+/**
+ * Allocate a slot and its buffer for a fragment
+ * @param evict     true: free the least recently used fragments if required; false: use only free memory
+ * @return          the slot or NULL if there is not enough memory
+ */
+static sjpeg_cache_slot_t * cache_add(const void * src, lv_img_src_t src_type, int frame_index, uint32_t size,
+                                      bool evict)
+{
+    sjpeg_cache_slot_t * free_slot;
+    while(1) {
+        free_slot = NULL;
+        sjpeg_cache_slot_t * lru = NULL;
+        uint32_t i;
+        for(i = 0; i < SJPEG_CACHE_SLOT_CNT; i++) {
+            sjpeg_cache_slot_t * slot = &cache_slots[i];
+            if(slot->src == NULL) {
+                if(free_slot == NULL) free_slot = slot;
+            }
+            else if(lru == NULL || slot->life < lru->life) {
+                lru = slot;
+            }
+        }
+
+        if(free_slot && sjpg_stat.cache_size + size <= cache_size_max) break;
+        if(!evict || lru == NULL) return NULL;
+        cache_drop(lru);
+    }
+
+    void * src_copy = (void *)src;
+    if(src_type == LV_IMG_SRC_FILE) {
+        size_t len = strlen(src) + 1;
+        src_copy = lv_mem_alloc(len);
+        if(src_copy == NULL) return NULL;
+        lv_memcpy(src_copy, src, len);
+    }
+
+    free_slot->buf = lv_mem_alloc(size);
+    if(free_slot->buf == NULL) {
+        if(src_type == LV_IMG_SRC_FILE) lv_mem_free(src_copy);
+        return NULL;
+    }
+
+    free_slot->src = src_copy;
+    free_slot->src_type = src_type;
+    free_slot->frame_index = frame_index;
+    free_slot->size = size;
+    free_slot->life = ++cache_life;
+    sjpg_stat.cache_size += size;
+    return free_slot;
+}
+
+static void cache_drop(sjpeg_cache_slot_t * slot)
+{
+    if(slot->src_type == LV_IMG_SRC_FILE) lv_mem_free(slot->src);
+    lv_mem_free(slot->buf);
+    sjpg_stat.cache_size -= slot->size;
+
+    slot->src = NULL;
+    slot->buf = NULL;
+    slot->size = 0;
+    slot->frame_index = -1;
+    slot->gen++;    /*Images still referring to this slot will look for their fragment again*/
+}
+
+#if LV_SJPG_PREFETCH
+
+/**
+ * Remember the next fragment of an image to decode it when LVGL is idle.
+ * Only SJPG images are prefetched and only into free memory of the cache.
+ */
+static void prefetch_request(const SJPEG * sjpeg, int frame_index)
+{
+    if(frame_index >= sjpeg->sjpeg_total_frames) return;
+    if(cache_find(sjpeg->src, sjpeg->src_type, frame_index)) return;
+
+    if(prefetch_src) {
+        if(prefetch_src_type == LV_IMG_SRC_FILE) lv_mem_free(prefetch_src);
+        prefetch_src = NULL;
+    }
+
+    if(sjpeg->src_type == LV_IMG_SRC_FILE) {
+        size_t len = strlen(sjpeg->src) + 1;
+        prefetch_src = lv_mem_alloc(len);
+        if(prefetch_src == NULL) return;
+        lv_memcpy(prefetch_src, sjpeg->src, len);
+    }
+    else {
+        prefetch_src = (void *)sjpeg->src;
+    }
+
+    prefetch_src_type = sjpeg->src_type;
+    prefetch_frame_index = frame_index;
+    lv_timer_resume(prefetch_timer);
+    lv_timer_ready(prefetch_timer);
+}
+
+static void prefetch_timer_cb(lv_timer_t * t)
+{
+    lv_timer_pause(t);
+    if(prefetch_src == NULL) return;
+
+    /*The image might be closed already, so open it again*/
+    lv_img_decoder_dsc_t dsc;
+    lv_memset_00(&dsc, sizeof(dsc));
+    dsc.src = prefetch_src;
+    dsc.src_type = prefetch_src_type;
+
+    if(decoder_open(NULL, &dsc) == LV_RES_OK) {
+        SJPEG * sjpeg = dsc.user_data;
+        uint32_t frame_size = get_frame_size(sjpeg);
+        if(cache_find(prefetch_src, prefetch_src_type, prefetch_frame_index) == NULL) {
+            sjpeg_cache_slot_t * slot = cache_add(prefetch_src, prefetch_src_type, prefetch_frame_index, frame_size, false);
+            if(slot) {
+                if(decode_frame(sjpeg, prefetch_frame_index, slot->buf) == LV_RES_OK) sjpg_stat.prefetch_cnt++;
+                else cache_drop(slot);
+            }
+        }
+        decoder_close(NULL, &dsc);
+    }
+
+    if(prefetch_src_type == LV_IMG_SRC_FILE) lv_mem_free(prefetch_src);
+    prefetch_src = NULL;
+}
+
+#endif /*LV_SJPG_PREFETCH*/
+
 static void lv_sjpg_free(SJPEG * sjpeg)
 {
     if(sjpeg->frame_cache) lv_mem_free(sjpeg->frame_cache);
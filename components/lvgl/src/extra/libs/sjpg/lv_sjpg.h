@@ -13,9 +13,12 @@ extern "C" {
 /*********************
  *      INCLUDES
  *********************/
+#include "../../../lv_conf_internal.h"
 
 #if LV_USE_SJPG
 
+#include <stdint.h>
+
 /*********************
  *      DEFINES
  *********************/
@@ -24,12 +27,48 @@ extern "C" {
  *      TYPEDEFS
  **********************/
 
+/**
+ * Statistics about decoding JPG and SJPG fragments
+ */
+typedef struct {
+    uint32_t decode_cnt;        /**< Number of decoded fragments (including the prefetched ones)*/
+    uint32_t prefetch_cnt;      /**< Number of fragments decoded in advance*/
+    uint32_t hit_cnt;           /**< Number of fragments found in the cache instead of decoding them again*/
+    uint32_t decode_time;       /**< Total time of decoding the fragments [ms]*/
+    uint32_t decode_time_max;   /**< Time of decoding the slowest fragment [ms]*/
+    uint32_t cache_size;        /**< Memory currently used by the cached fragments [bytes]*/
+} lv_sjpg_stat_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
 
 void lv_split_jpeg_init(void);
 
+/**
+ * Set the memory the decoded fragments of JPG and SJPG images can use.
+ * The least recently used fragments are freed if the new size is smaller than the current usage.
+ * @param size      size in bytes, 0: don't cache the fragments, only the last fragment of an opened image is kept
+ */
+void lv_sjpg_cache_set_size(uint32_t size);
+
+/**
+ * Free the cached fragments of an image, e.g. if the image file was changed
+ * @param src       pointer to an `lv_img_dsc_t` or a file name, NULL to free all fragments
+ */
+void lv_sjpg_cache_invalidate_src(const void * src);
+
+/**
+ * Get the statistics about decoding JPG and SJPG images since the last `lv_sjpg_reset_stat()`
+ * @param stat      store the statistics here
+ */
+void lv_sjpg_get_stat(lv_sjpg_stat_t * stat);
+
+/**
+ * Clear the statistics about decoding JPG and SJPG images
+ */
+void lv_sjpg_reset_stat(void);
+
 /**********************
  *      MACROS
  **********************/
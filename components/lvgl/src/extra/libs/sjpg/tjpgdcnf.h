@@ -24,7 +24,7 @@
 /  1: Enable
 */
 
-#define JD_FASTDECODE	0
+#define JD_FASTDECODE	LV_SJPG_FAST_DECODE
 /* Optimization level
 /  0: Basic optimization. Suitable for 8/16-bit MCUs.
 /  1: + 32-bit barrel shifter. Suitable for 32-bit MCUs.
@@ -4,6 +4,15 @@
 #include <stdio.h>
 #include "../../../misc/lv_lru.h"
 
+static lv_tiny_ttf_stat_t ttf_stat;
+
+/*Count the allocations of the rasterizer too*/
+static void * ttf_alloc(size_t size)
+{
+    ttf_stat.alloc_cnt++;
+    return lv_mem_alloc(size);
+}
+
 #define STB_RECT_PACK_IMPLEMENTATION
 #define STBRP_STATIC
 #define STBTT_STATIC
@@ -11,9 +20,9 @@
 #define STBTT_HEAP_FACTOR_SIZE_32 50
 #define STBTT_HEAP_FACTOR_SIZE_128 20
 #define STBTT_HEAP_FACTOR_SIZE_DEFAULT 10
-#define STBTT_malloc(x, u) ((void)(u), lv_mem_alloc(x))
+#define STBTT_malloc(x, u) ((void)(u), ttf_alloc(x))
 #define STBTT_free(x, u) ((void)(u), lv_mem_free(x))
-#define TTF_MALLOC(x) (lv_mem_alloc(x))
+#define TTF_MALLOC(x) (ttf_alloc(x))
 #define TTF_FREE(x) (lv_mem_free(x))
 
 #if LV_TINY_TTF_FILE_SUPPORT
@@ -74,7 +83,9 @@ typedef struct ttf_font_desc {
     float scale;
     int ascent;
     int descent;
-    lv_lru_t * bitmap_cache;
+    lv_coord_t font_size;
+    uint16_t face_id;           /*The font uses the glyph atlas if not 0*/
+    lv_lru_t * bitmap_cache;    /*The font's own cache if the atlas is not used*/
 } ttf_font_desc_t;
 
 typedef struct ttf_bitmap_cache_key {
@@ -82,6 +93,367 @@ typedef struct ttf_bitmap_cache_key {
     lv_coord_t line_height;
 } ttf_bitmap_cache_key_t;
 
+#if LV_TINY_TTF_ATLAS_SIZE
+/*The glyph atlas is shared by the fonts created from the same data or file (called face here), with any size.
+ *The bitmaps are stored packed, one after the other in the pages, as the glyphs are drawn from packed bitmaps.
+ *The least recently used page is evicted as a whole when the atlas is full.*/
+#define ATLAS_PAGE_CNT      LV_MAX(LV_TINY_TTF_ATLAS_SIZE / LV_TINY_TTF_ATLAS_PAGE_SIZE, 1)
+#define ATLAS_GLYPH_CNT     LV_MIN(LV_MAX(LV_TINY_TTF_ATLAS_SIZE / 128, 64), 0xFFFE)
+#define ATLAS_BUCKET_CNT    ATLAS_GLYPH_CNT
+#define ATLAS_KERN_CNT      (ATLAS_GLYPH_CNT * 2)
+#define ATLAS_NONE          0xFFFF
+
+typedef struct {
+    uint32_t letter;
+    uint16_t face_id;       /*0: unused entry*/
+    uint16_t font_size;
+    uint16_t next;          /*Next glyph in the hash bucket or in the free list*/
+    uint16_t page_next;     /*Next glyph on the same page or without bitmap*/
+    uint16_t page;          /*The page of the bitmap or ATLAS_NONE*/
+    uint16_t glyph_index;   /*0: the font has no glyph for the letter*/
+    uint16_t adv;           /*Advance width in font units*/
+    int16_t x1;             /*Bitmap box in px*/
+    int16_t y1;
+    int16_t x2;
+    int16_t y2;
+    uint32_t bitmap_ofs;    /*Start of the bitmap in the page*/
+} ttf_atlas_glyph_t;
+
+typedef struct {
+    uint16_t face_id;       /*0: unused entry*/
+    uint16_t glyph1;
+    uint16_t glyph2;
+    int16_t value;          /*In font units*/
+} ttf_atlas_kern_t;
+
+typedef struct {
+    uint8_t * buf;
+    uint32_t used;
+    uint32_t life;
+    uint16_t glyphs;        /*The first glyph on the page*/
+} ttf_atlas_page_t;
+
+typedef struct {
+    ttf_atlas_glyph_t glyphs[ATLAS_GLYPH_CNT];
+    uint16_t buckets[ATLAS_BUCKET_CNT];
+    ttf_atlas_kern_t kerns[ATLAS_KERN_CNT];
+    ttf_atlas_page_t pages[ATLAS_PAGE_CNT];
+    uint16_t free_glyphs;
+    uint16_t unplaced_glyphs;   /*The glyphs whose bitmaps are not rendered*/
+    uint16_t cur_page;          /*The new bitmaps are added to this page*/
+    uint32_t life;
+    uint8_t * large_bitmap;     /*For the glyphs larger than a page*/
+    uint32_t large_bitmap_size;
+} ttf_atlas_t;
+
+typedef struct ttf_face {
+    struct ttf_face * next;
+    const void * data;          /*NULL if the font is loaded from a file*/
+    uint16_t id;
+    uint16_t ref_cnt;
+    char path[];
+} ttf_face_t;
+
+static ttf_atlas_t * atlas;     /*Allocated while there is a font using it*/
+static ttf_face_t * faces;
+static uint16_t face_id_last;
+
+static bool atlas_init(void)
+{
+    atlas = TTF_MALLOC(sizeof(ttf_atlas_t));
+    if(atlas == NULL) return false;
+    lv_memset_00(atlas, sizeof(ttf_atlas_t));
+
+    uint32_t i;
+    for(i = 0; i < ATLAS_GLYPH_CNT; i++) atlas->glyphs[i].next = i + 1 < ATLAS_GLYPH_CNT ? i + 1 : ATLAS_NONE;
+    for(i = 0; i < ATLAS_BUCKET_CNT; i++) atlas->buckets[i] = ATLAS_NONE;
+    for(i = 0; i < ATLAS_PAGE_CNT; i++) atlas->pages[i].glyphs = ATLAS_NONE;
+    atlas->free_glyphs = 0;
+    atlas->unplaced_glyphs = ATLAS_NONE;
+    return true;
+}
+
+static void atlas_deinit(void)
+{
+    uint32_t i;
+    for(i = 0; i < ATLAS_PAGE_CNT; i++) {
+        if(atlas->pages[i].buf) TTF_FREE(atlas->pages[i].buf);
+    }
+    if(atlas->large_bitmap) TTF_FREE(atlas->large_bitmap);
+    TTF_FREE(atlas);
+    atlas = NULL;
+}
+
+static uint32_t atlas_hash(uint16_t face_id, uint16_t font_size, uint32_t letter)
+{
+    return (((letter ^ (uint32_t)face_id << 24) + font_size * 131U) * 2654435761U >> 12) % ATLAS_BUCKET_CNT;
+}
+
+static void atlas_list_remove(uint16_t * head, uint16_t id, bool page_list)
+{
+    while(*head != ATLAS_NONE) {
+        ttf_atlas_glyph_t * g = &atlas->glyphs[*head];
+        if(*head == id) {
+            *head = page_list ? g->page_next : g->next;
+            return;
+        }
+        head = page_list ? &g->page_next : &g->next;
+    }
+}
+
+static void atlas_glyph_free(uint16_t id)
+{
+    ttf_atlas_glyph_t * g = &atlas->glyphs[id];
+    atlas_list_remove(&atlas->buckets[atlas_hash(g->face_id, g->font_size, g->letter)], id, false);
+    if(g->page != ATLAS_NONE) atlas_list_remove(&atlas->pages[g->page].glyphs, id, true);
+    else atlas_list_remove(&atlas->unplaced_glyphs, id, true);
+
+    g->face_id = 0;
+    g->next = atlas->free_glyphs;
+    atlas->free_glyphs = id;
+}
+
+static void atlas_page_evict(uint16_t page_id)
+{
+    ttf_atlas_page_t * page = &atlas->pages[page_id];
+    while(page->glyphs != ATLAS_NONE) atlas_glyph_free(page->glyphs);
+    page->used = 0;
+    ttf_stat.evict_cnt++;
+}
+
+/*Find the least recently used page, optionally only among the pages having glyphs*/
+static uint16_t atlas_get_lru_page(bool with_glyphs)
+{
+    uint16_t lru = ATLAS_NONE;
+    uint16_t i;
+    for(i = 0; i < ATLAS_PAGE_CNT; i++) {
+        ttf_atlas_page_t * page = &atlas->pages[i];
+        if(page->buf == NULL || (with_glyphs && page->glyphs == ATLAS_NONE)) continue;
+        if(lru == ATLAS_NONE || page->life < atlas->pages[lru].life) lru = i;
+    }
+    return lru;
+}
+
+static uint16_t atlas_glyph_alloc(void)
+{
+    if(atlas->free_glyphs == ATLAS_NONE) {
+        uint16_t page_id = atlas_get_lru_page(true);
+        if(page_id != ATLAS_NONE) {
+            atlas_page_evict(page_id);
+        }
+        else {
+            while(atlas->unplaced_glyphs != ATLAS_NONE) atlas_glyph_free(atlas->unplaced_glyphs);
+        }
+    }
+
+    uint16_t id = atlas->free_glyphs;
+    atlas->free_glyphs = atlas->glyphs[id].next;
+    return id;
+}
+
+/*Get the glyph of a letter, computing its metrics if it's not cached*/
+static uint16_t atlas_get_glyph(ttf_font_desc_t * dsc, uint32_t letter)
+{
+    uint16_t * bucket = &atlas->buckets[atlas_hash(dsc->face_id, dsc->font_size, letter)];
+    uint16_t id;
+    for(id = *bucket; id != ATLAS_NONE; id = atlas->glyphs[id].next) {
+        ttf_atlas_glyph_t * g = &atlas->glyphs[id];
+        if(g->letter == letter && g->face_id == dsc->face_id && g->font_size == dsc->font_size) return id;
+    }
+
+    id = atlas_glyph_alloc();
+    ttf_atlas_glyph_t * g = &atlas->glyphs[id];
+    lv_memset_00(g, sizeof(ttf_atlas_glyph_t));
+    g->letter = letter;
+    g->face_id = dsc->face_id;
+    g->font_size = dsc->font_size;
+    g->page = ATLAS_NONE;
+
+    ttf_stat.metrics_cnt++;
+    g->glyph_index = stbtt_FindGlyphIndex(&dsc->info, (int)letter);
+    if(g->glyph_index) {
+        int x1, y1, x2, y2;
+        stbtt_GetGlyphBitmapBox(&dsc->info, g->glyph_index, dsc->scale, dsc->scale, &x1, &y1, &x2, &y2);
+        int advw, lsb;
+        stbtt_GetGlyphHMetrics(&dsc->info, g->glyph_index, &advw, &lsb);
+        g->adv = advw;
+        g->x1 = x1;
+        g->y1 = y1;
+        g->x2 = x2;
+        g->y2 = y2;
+    }
+
+    g->next = *bucket;
+    *bucket = id;
+    g->page_next = atlas->unplaced_glyphs;
+    atlas->unplaced_glyphs = id;
+    return id;
+}
+
+static bool atlas_kern_match(const ttf_atlas_kern_t * kern, uint16_t face_id, uint16_t glyph1, uint16_t glyph2)
+{
+    return kern->face_id == face_id && kern->glyph1 == glyph1 && kern->glyph2 == glyph2;
+}
+
+/*The kerning values are cached in 2 way sets with the most recently added value first*/
+static int atlas_get_kern(ttf_font_desc_t * dsc, uint16_t glyph1, uint16_t glyph2)
+{
+    uint32_t set = ((glyph1 * 31U + glyph2 + dsc->face_id * 131U) * 2654435761U >> 12) % (ATLAS_KERN_CNT / 2);
+    ttf_atlas_kern_t * kern = &atlas->kerns[set * 2];
+    if(atlas_kern_match(&kern[0], dsc->face_id, glyph1, glyph2)) return kern[0].value;
+    if(atlas_kern_match(&kern[1], dsc->face_id, glyph1, glyph2)) return kern[1].value;
+
+    ttf_stat.kern_cnt++;
+    kern[1] = kern[0];
+    kern[0].face_id = dsc->face_id;
+    kern[0].glyph1 = glyph1;
+    kern[0].glyph2 = glyph2;
+    kern[0].value = stbtt_GetGlyphKernAdvance(&dsc->info, glyph1, glyph2);
+    return kern[0].value;
+}
+
+/*Get a page with `size` free bytes, evicting the least recently used page if required*/
+static ttf_atlas_page_t * atlas_get_page(uint32_t size)
+{
+    ttf_atlas_page_t * page = &atlas->pages[atlas->cur_page];
+    if(page->buf && page->used + size <= LV_TINY_TTF_ATLAS_PAGE_SIZE) return page;
+
+    uint16_t i;
+    for(i = 0; i < ATLAS_PAGE_CNT; i++) {
+        if(atlas->pages[i].buf == NULL) {
+            atlas->pages[i].buf = TTF_MALLOC(LV_TINY_TTF_ATLAS_PAGE_SIZE);
+            if(atlas->pages[i].buf) {
+                atlas->cur_page = i;
+                return &atlas->pages[i];
+            }
+            break;
+        }
+    }
+
+    i = atlas_get_lru_page(false);
+    if(i == ATLAS_NONE) return NULL;
+    atlas_page_evict(i);
+    atlas->cur_page = i;
+    return &atlas->pages[i];
+}
+
+static const uint8_t * atlas_get_bitmap(ttf_font_desc_t * dsc, uint16_t id)
+{
+    ttf_atlas_glyph_t * g = &atlas->glyphs[id];
+    if(g->page != ATLAS_NONE) {
+        ttf_atlas_page_t * page = &atlas->pages[g->page];
+        page->life = ++atlas->life;
+        ttf_stat.hit_cnt++;
+        return page->buf + g->bitmap_ofs;
+    }
+
+    int w = g->x2 - g->x1 + 1;
+    int h = g->y2 - g->y1 + 1;
+    uint32_t size = w * h;
+    uint8_t * buf;
+    if(size > LV_TINY_TTF_ATLAS_PAGE_SIZE) {
+        /*Can't be cached, render it to a buffer reused by the large glyphs*/
+        if(atlas->large_bitmap_size < size) {
+            if(atlas->large_bitmap) TTF_FREE(atlas->large_bitmap);
+            atlas->large_bitmap = TTF_MALLOC(size);
+            atlas->large_bitmap_size = atlas->large_bitmap ? size : 0;
+            if(atlas->large_bitmap == NULL) return NULL;
+        }
+        buf = atlas->large_bitmap;
+    }
+    else {
+        ttf_atlas_page_t * page = atlas_get_page(size);
+        if(page == NULL) return NULL;
+
+        atlas_list_remove(&atlas->unplaced_glyphs, id, true);
+        g->page = atlas->cur_page;
+        g->page_next = page->glyphs;
+        page->glyphs = id;
+        g->bitmap_ofs = page->used;
+        page->used += size;
+        page->life = ++atlas->life;
+        buf = page->buf + g->bitmap_ofs;
+    }
+
+    LV_LOG_TRACE("rasterizing letter: %u", g->letter);
+    ttf_stat.raster_cnt++;
+    lv_memset_00(buf, size);
+    stbtt_MakeGlyphBitmap(&dsc->info, buf, w, h, w, dsc->scale, dsc->scale, g->glyph_index);
+    return buf;
+}
+
+/*Get the ID of the face of a font data or file. Fonts of the same face share the glyph atlas.*/
+static uint16_t face_get(const char * path, const void * data)
+{
+    ttf_face_t * face;
+    for(face = faces; face; face = face->next) {
+        if(path ? (face->data == NULL && strcmp(face->path, path) == 0) : face->data == data) {
+            face->ref_cnt++;
+            return face->id;
+        }
+    }
+
+    if(atlas == NULL && !atlas_init()) return 0;
+
+    size_t path_size = path ? strlen(path) + 1 : 0;
+    face = TTF_MALLOC(sizeof(ttf_face_t) + path_size);
+    if(face == NULL) {
+        if(faces == NULL) atlas_deinit();
+        return 0;
+    }
+    face->data = path ? NULL : data;
+    if(path) lv_memcpy(face->path, path, path_size);
+    face->ref_cnt = 1;
+
+    /*Find an unused ID*/
+    ttf_face_t * f;
+    do {
+        face_id_last++;
+        if(face_id_last == 0) face_id_last = 1;
+        for(f = faces; f && f->id != face_id_last; f = f->next);
+    } while(f);
+    face->id = face_id_last;
+
+    face->next = faces;
+    faces = face;
+    return face->id;
+}
+
+static void face_release(uint16_t id)
+{
+    ttf_face_t ** face_p;
+    for(face_p = &faces; *face_p && (*face_p)->id != id; face_p = &(*face_p)->next);
+    ttf_face_t * face = *face_p;
+    if(face == NULL || --face->ref_cnt > 0) return;
+
+    /*Drop the face from the atlas*/
+    uint32_t i;
+    for(i = 0; i < ATLAS_GLYPH_CNT; i++) {
+        if(atlas->glyphs[i].face_id == id) atlas_glyph_free(i);
+    }
+    for(i = 0; i < ATLAS_KERN_CNT; i++) {
+        if(atlas->kerns[i].face_id == id) atlas->kerns[i].face_id = 0;
+    }
+
+    *face_p = face->next;
+    TTF_FREE(face);
+    if(faces == NULL) atlas_deinit();
+}
+#endif /*LV_TINY_TTF_ATLAS_SIZE*/
+
+static void set_glyph_dsc(ttf_font_desc_t * dsc, lv_font_glyph_dsc_t * dsc_out, int advw, int k, int x1, int y1,
+                          int x2, int y2)
+{
+    dsc_out->adv_w = (uint16_t)floor((((float)advw + (float)k) * dsc->scale) +
+                                     0.5f); /*Horizontal space required by the glyph in [px]*/
+    dsc_out->box_w = (x2 - x1 + 1);         /*width of the bitmap in [px]*/
+    dsc_out->box_h = (y2 - y1 + 1);         /*height of the bitmap in [px]*/
+    dsc_out->ofs_x = x1;                    /*X offset of the bitmap in [pf]*/
+    dsc_out->ofs_y = -y2;                   /*Y offset of the bitmap measured from the as line*/
+    dsc_out->bpp = 8;                       /*Bits per pixel: 1/2/4/8*/
+    dsc_out->is_placeholder = false;
+}
+
 static bool ttf_get_glyph_dsc_cb(const lv_font_t * font, lv_font_glyph_dsc_t * dsc_out, uint32_t unicode_letter,
                                  uint32_t unicode_letter_next)
 {
@@ -98,6 +470,28 @@ static bool ttf_get_glyph_dsc_cb(const lv_font_t * font, lv_font_glyph_dsc_t * d
         return true;
     }
     ttf_font_desc_t * dsc = (ttf_font_desc_t *)font->dsc;
+
+#if LV_TINY_TTF_ATLAS_SIZE
+    if(dsc->face_id) {
+        uint16_t id = atlas_get_glyph(dsc, unicode_letter);
+        /*Copy it because getting the next glyph can evict it*/
+        ttf_atlas_glyph_t g = atlas->glyphs[id];
+        if(g.glyph_index == 0) {
+            /* Glyph not found */
+            return false;
+        }
+
+        int k = 0;
+        if(unicode_letter_next != 0) {
+            uint16_t glyph2 = atlas->glyphs[atlas_get_glyph(dsc, unicode_letter_next)].glyph_index;
+            if(glyph2) k = atlas_get_kern(dsc, g.glyph_index, glyph2);
+        }
+        set_glyph_dsc(dsc, dsc_out, g.adv, k, g.x1, g.y1, g.x2, g.y2);
+        return true;
+    }
+#endif
+
+    ttf_stat.metrics_cnt++;
     int g1 = stbtt_FindGlyphIndex(&dsc->info, (int)unicode_letter);
     if(g1 == 0) {
         /* Glyph not found */
@@ -112,25 +506,29 @@ static bool ttf_get_glyph_dsc_cb(const lv_font_t * font, lv_font_glyph_dsc_t * d
     }
     int advw, lsb;
     stbtt_GetGlyphHMetrics(&dsc->info, g1, &advw, &lsb);
+    ttf_stat.kern_cnt++;
     int k = stbtt_GetGlyphKernAdvance(&dsc->info, g1, g2);
-    dsc_out->adv_w = (uint16_t)floor((((float)advw + (float)k) * dsc->scale) +
-                                     0.5f); /*Horizontal space required by the glyph in [px]*/
-
-    dsc_out->adv_w = (uint16_t)floor((((float)advw + (float)k) * dsc->scale) +
-                                     0.5f); /*Horizontal space required by the glyph in [px]*/
-    dsc_out->box_w = (x2 - x1 + 1);         /*width of the bitmap in [px]*/
-    dsc_out->box_h = (y2 - y1 + 1);         /*height of the bitmap in [px]*/
-    dsc_out->ofs_x = x1;                    /*X offset of the bitmap in [pf]*/
-    dsc_out->ofs_y = -y2;                   /*Y offset of the bitmap measured from the as line*/
-    dsc_out->bpp = 8;                       /*Bits per pixel: 1/2/4/8*/
-    dsc_out->is_placeholder = false;
+    set_glyph_dsc(dsc, dsc_out, advw, k, x1, y1, x2, y2);
     return true; /*true: glyph found; false: glyph was not found*/
 }
 
 static const uint8_t * ttf_get_glyph_bitmap_cb(const lv_font_t * font, uint32_t unicode_letter)
 {
     ttf_font_desc_t * dsc = (ttf_font_desc_t *)font->dsc;
+
+#if LV_TINY_TTF_ATLAS_SIZE
+    if(dsc->face_id) {
+        uint16_t id = atlas_get_glyph(dsc, unicode_letter);
+        if(atlas->glyphs[id].glyph_index == 0) {
+            /* Glyph not found */
+            return NULL;
+        }
+        return atlas_get_bitmap(dsc, id);
+    }
+#endif
+
     const stbtt_fontinfo * info = (const stbtt_fontinfo *)&dsc->info;
+    ttf_stat.metrics_cnt++;
     int g1 = stbtt_FindGlyphIndex(info, (int)unicode_letter);
     if(g1 == 0) {
         /* Glyph not found */
@@ -150,12 +548,13 @@ static const uint8_t * ttf_get_glyph_bitmap_cb(const lv_font_t * font, uint32_t
     uint8_t * buffer = NULL;
     lv_lru_get(dsc->bitmap_cache, &cache_key, sizeof(cache_key), (void **)&buffer);
     if(buffer) {
+        ttf_stat.hit_cnt++;
         return buffer;
     }
     LV_LOG_TRACE("cache miss for letter: %u", unicode_letter);
     /*Prepare space in cache*/
     size_t szb = h * stride;
-    buffer = lv_mem_alloc(szb);
+    buffer = TTF_MALLOC(szb);
     if(!buffer) {
         LV_LOG_ERROR("failed to allocate cache value");
         return NULL;
@@ -167,6 +566,7 @@ static const uint8_t * ttf_get_glyph_bitmap_cb(const lv_font_t * font, uint32_t
         return NULL;
     }
     /*Render into cache*/
+    ttf_stat.raster_cnt++;
     stbtt_MakeGlyphBitmap(info, buffer, w, h, stride, dsc->scale, dsc->scale, g1);
     return buffer;
 }
@@ -183,6 +583,7 @@ static lv_font_t * lv_tiny_ttf_create(const char * path, const void * data, size
         LV_LOG_ERROR("tiny_ttf: out of memory\n");
         return NULL;
     }
+    lv_memset_00(dsc, sizeof(ttf_font_desc_t));
 #if LV_TINY_TTF_FILE_SUPPORT
     if(path != NULL) {
         if(LV_FS_RES_OK != lv_fs_open(&dsc->file, path, LV_FS_MODE_RD)) {
@@ -199,7 +600,7 @@ static lv_font_t * lv_tiny_ttf_create(const char * path, const void * data, size
     }
     if(0 == stbtt_InitFont(&dsc->info, &dsc->stream, stbtt_GetFontOffsetForIndex(&dsc->stream, 0))) {
         LV_LOG_ERROR("tiny_ttf: init failed\n");
-        goto err_after_dsc;
+        goto err_after_file;
     }
 
 #else
@@ -207,14 +608,27 @@ static lv_font_t * lv_tiny_ttf_create(const char * path, const void * data, size
     LV_UNUSED(data_size);
     if(0 == stbtt_InitFont(&dsc->info, dsc->stream, stbtt_GetFontOffsetForIndex(dsc->stream, 0))) {
         LV_LOG_ERROR("tiny_ttf: init failed\n");
-        goto err_after_dsc;
+        goto err_after_file;
     }
 #endif
 
-    dsc->bitmap_cache = lv_lru_create(cache_size, font_size * font_size, lv_mem_free, lv_mem_free);
-    if(dsc->bitmap_cache == NULL) {
-        LV_LOG_ERROR("failed to create lru cache");
-        goto err_after_dsc;
+#if LV_TINY_TTF_ATLAS_SIZE
+    if(cache_size == LV_TINY_TTF_CACHE_ATLAS) {
+        dsc->face_id = face_get(path, data);
+        if(dsc->face_id == 0) {
+            LV_LOG_ERROR("failed to create the glyph atlas");
+            goto err_after_file;
+        }
+    }
+    else
+#endif
+    {
+        if(cache_size == LV_TINY_TTF_CACHE_ATLAS) cache_size = 4096;  /*The atlas is disabled*/
+        dsc->bitmap_cache = lv_lru_create(cache_size, font_size * font_size, lv_mem_free, lv_mem_free);
+        if(dsc->bitmap_cache == NULL) {
+            LV_LOG_ERROR("failed to create lru cache");
+            goto err_after_file;
+        }
     }
 
     lv_font_t * out_font = (lv_font_t *)TTF_MALLOC(sizeof(lv_font_t));
@@ -229,8 +643,15 @@ static lv_font_t * lv_tiny_ttf_create(const char * path, const void * data, size
     lv_tiny_ttf_set_size(out_font, font_size);
     return out_font;
 err_after_bitmap_cache:
-    lv_lru_del(dsc->bitmap_cache);
+#if LV_TINY_TTF_ATLAS_SIZE
+    if(dsc->face_id) face_release(dsc->face_id);
+#endif
+    if(dsc->bitmap_cache) lv_lru_del(dsc->bitmap_cache);
+err_after_file:
+#if LV_TINY_TTF_FILE_SUPPORT
+    if(dsc->stream.file != NULL) lv_fs_close(&dsc->file);
 err_after_dsc:
+#endif
     TTF_FREE(dsc);
     return NULL;
 }
@@ -241,7 +662,7 @@ lv_font_t * lv_tiny_ttf_create_file_ex(const char * path, lv_coord_t font_size,
 }
 lv_font_t * lv_tiny_ttf_create_file(const char * path, lv_coord_t font_size)
 {
-    return lv_tiny_ttf_create_file_ex(path, font_size, 4096);
+    return lv_tiny_ttf_create_file_ex(path, font_size, LV_TINY_TTF_ATLAS_SIZE ? LV_TINY_TTF_CACHE_ATLAS : 4096);
 }
 #endif /*LV_TINY_TTF_FILE_SUPPORT*/
 lv_font_t * lv_tiny_ttf_create_data_ex(const void * data, size_t data_size, lv_coord_t font_size, size_t cache_size)
@@ -250,7 +671,7 @@ lv_font_t * lv_tiny_ttf_create_data_ex(const void * data, size_t data_size, lv_c
 }
 lv_font_t * lv_tiny_ttf_create_data(const void * data, size_t data_size, lv_coord_t font_size)
 {
-    return lv_tiny_ttf_create_data_ex(data, data_size, font_size, 4096);
+    return lv_tiny_ttf_create_data_ex(data, data_size, font_size, LV_TINY_TTF_ATLAS_SIZE ? LV_TINY_TTF_CACHE_ATLAS : 4096);
 }
 void lv_tiny_ttf_set_size(lv_font_t * font, lv_coord_t font_size)
 {
@@ -259,6 +680,7 @@ void lv_tiny_ttf_set_size(lv_font_t * font, lv_coord_t font_size)
         return;
     }
     ttf_font_desc_t * dsc = (ttf_font_desc_t *)font->dsc;
+    dsc->font_size = font_size;
     dsc->scale = stbtt_ScaleForMappingEmToPixels(&dsc->info, font_size);
     int line_gap = 0;
     stbtt_GetFontVMetrics(&dsc->info, &dsc->ascent, &dsc->descent, &line_gap);
@@ -275,10 +697,31 @@ void lv_tiny_ttf_destroy(lv_font_t * font)
                 lv_fs_close(&ttf->file);
             }
 #endif
-            lv_lru_del(ttf->bitmap_cache);
+#if LV_TINY_TTF_ATLAS_SIZE
+            if(ttf->face_id) face_release(ttf->face_id);
+#endif
+            if(ttf->bitmap_cache) lv_lru_del(ttf->bitmap_cache);
             TTF_FREE(ttf);
         }
         TTF_FREE(font);
     }
 }
+void lv_tiny_ttf_get_stat(lv_tiny_ttf_stat_t * stat)
+{
+    *stat = ttf_stat;
+    stat->atlas_size = 0;
+#if LV_TINY_TTF_ATLAS_SIZE
+    if(atlas) {
+        stat->atlas_size = sizeof(ttf_atlas_t) + atlas->large_bitmap_size;
+        uint32_t i;
+        for(i = 0; i < ATLAS_PAGE_CNT; i++) {
+            if(atlas->pages[i].buf) stat->atlas_size += LV_TINY_TTF_ATLAS_PAGE_SIZE;
+        }
+    }
+#endif
+}
+void lv_tiny_ttf_reset_stat(void)
+{
+    lv_memset_00(&ttf_stat, sizeof(ttf_stat));
+}
 #endif /*LV_USE_TINY_TTF*/
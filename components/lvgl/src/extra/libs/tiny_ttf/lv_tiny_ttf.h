@@ -21,10 +21,23 @@ extern "C" {
  *      DEFINES
  *********************/
 
+/*Use it as `cache_size` to share the glyph atlas with the other fonts (see `LV_TINY_TTF_ATLAS_SIZE`)*/
+#define LV_TINY_TTF_CACHE_ATLAS 0
+
 /**********************
  *      TYPEDEFS
  **********************/
 
+typedef struct {
+    uint32_t raster_cnt;    /**< Number of glyphs rasterized*/
+    uint32_t hit_cnt;       /**< Number of glyph bitmaps found in the cache*/
+    uint32_t metrics_cnt;   /**< Number of glyph lookups and metrics computed by the rasterizer*/
+    uint32_t kern_cnt;      /**< Number of kerning lookups done by the rasterizer*/
+    uint32_t alloc_cnt;     /**< Number of allocations of the fonts, caches and the rasterizer*/
+    uint32_t evict_cnt;     /**< Number of atlas pages evicted*/
+    uint32_t atlas_size;    /**< Current memory used by the glyph atlas in bytes*/
+} lv_tiny_ttf_stat_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -33,14 +46,16 @@ extern "C" {
 /* create a font from the specified file or path with the specified line height.*/
 lv_font_t * lv_tiny_ttf_create_file(const char * path, lv_coord_t font_size);
 
-/* create a font from the specified file or path with the specified line height with the specified cache size.*/
+/* create a font from the specified file or path with the specified line height with the specified cache size.
+ * With `LV_TINY_TTF_CACHE_ATLAS` cache size the font uses the glyph atlas shared by the fonts of the same file.*/
 lv_font_t * lv_tiny_ttf_create_file_ex(const char * path, lv_coord_t font_size, size_t cache_size);
 #endif /*LV_TINY_TTF_FILE_SUPPORT*/
 
 /* create a font from the specified data pointer with the specified line height.*/
 lv_font_t * lv_tiny_ttf_create_data(const void * data, size_t data_size, lv_coord_t font_size);
 
-/* create a font from the specified data pointer with the specified line height and the specified cache size.*/
+/* create a font from the specified data pointer with the specified line height and the specified cache size.
+ * With `LV_TINY_TTF_CACHE_ATLAS` cache size the font uses the glyph atlas shared by the fonts of the same data.*/
 lv_font_t * lv_tiny_ttf_create_data_ex(const void * data, size_t data_size, lv_coord_t font_size, size_t cache_size);
 
 /* set the size of the font to a new font_size*/
@@ -49,6 +64,12 @@ void lv_tiny_ttf_set_size(lv_font_t * font, lv_coord_t font_size);
 /* destroy a font previously created with lv_tiny_ttf_create_xxxx()*/
 void lv_tiny_ttf_destroy(lv_font_t * font);
 
+/* get the rasterization and cache statistics of all the fonts*/
+void lv_tiny_ttf_get_stat(lv_tiny_ttf_stat_t * stat);
+
+/* reset the counters of the statistics*/
+void lv_tiny_ttf_reset_stat(void);
+
 /**********************
  *      MACROS
  **********************/
@@ -16,6 +16,7 @@ extern "C" {
 #include "snapshot/lv_snapshot.h"
 #include "monkey/lv_monkey.h"
 #include "gridnav/lv_gridnav.h"
+#include "pager/lv_pager.h"
 #include "fragment/lv_fragment.h"
 #include "imgfont/lv_imgfont.h"
 #include "msg/lv_msg.h"
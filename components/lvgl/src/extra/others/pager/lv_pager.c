@@ -0,0 +1,686 @@
+/**
+ * @file lv_pager.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_pager.h"
+
+#if LV_USE_PAGER
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Dragging beyond the first or last screen moves the screen only by 1/this of the distance*/
+#define PAGER_RUBBER_BAND_DIV       4
+
+/*Estimate the release velocity from the touches of the last this many milliseconds*/
+#define PAGER_VELOCITY_WINDOW       100
+#define PAGER_SAMPLE_CNT            8
+
+/*Flinging faster than this [px/s] changes the screen regardless of the dragged distance*/
+#define PAGER_FLING_VELOCITY        300
+
+/*On release assume that the screens would keep moving this long [ms] with the release velocity*/
+#define PAGER_PROJECTION_TIME       200
+
+#define PAGER_SETTLE_TIME_MIN       80
+#define PAGER_SETTLE_TIME_MAX       300
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum {
+    PAGER_STATE_IDLE,       /*Not pressed*/
+    PAGER_STATE_TRACK,      /*Pressed, but not moved enough to decide*/
+    PAGER_STATE_IGNORE,     /*The current press belongs to the objects, wait for release*/
+    PAGER_STATE_DRAG,       /*The screens follow the pointer*/
+    PAGER_STATE_SETTLE,     /*The screens are animated to their final position*/
+} pager_state_t;
+
+typedef struct {
+    lv_coord_t x;
+    uint32_t tick;
+} pager_sample_t;
+
+typedef struct _lv_pager {
+    lv_indev_t * indev;
+    lv_disp_t * disp;
+    lv_obj_t ** screens;
+    uint32_t screen_cnt;
+    uint32_t act_id;
+    lv_obj_t * neighbour;           /*The screen shown next to the active screen*/
+    lv_pager_change_cb_t change_cb;
+    void (*monitor_cb_ori)(struct _lv_disp_drv_t * disp_drv, uint32_t time, uint32_t px);
+
+    lv_point_t press_point;
+    lv_coord_t drag_start_x;
+    lv_coord_t offset;
+
+    pager_sample_t samples[PAGER_SAMPLE_CNT];
+    uint8_t sample_cnt;
+    uint8_t sample_next;
+
+    uint32_t latency_start;         /*When the oldest not rendered touch was read*/
+    uint32_t latency_sum;
+    uint32_t latency_cnt;
+    uint32_t last_frame_tick;
+    lv_pager_stat_t stat;
+
+    uint8_t state : 3;
+    uint8_t latency_pending : 1;
+    uint8_t frame_seen : 1;
+#if LV_USE_USER_DATA
+    void * user_data;
+#endif
+} lv_pager_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static lv_pager_t * get_pager_of_indev(lv_indev_t * indev);
+static void indev_read_timer_cb(lv_timer_t * timer);
+static void monitor_cb(lv_disp_drv_t * disp_drv, uint32_t time, uint32_t px);
+static void track_proc(lv_pager_t * pager);
+static void own_read(lv_pager_t * pager);
+static void drag_proc(lv_pager_t * pager, const lv_indev_data_t * data);
+static void frame_proc(lv_pager_t * pager);
+static void capture(lv_pager_t * pager);
+static void drag_to(lv_pager_t * pager, lv_coord_t x);
+static void release(lv_pager_t * pager);
+static void settle(lv_pager_t * pager, lv_coord_t target, int32_t v);
+static void settle_anim_cb(void * var, int32_t v);
+static void settle_ready_cb(lv_anim_t * a);
+static void finish(lv_pager_t * pager);
+static void set_offset(lv_pager_t * pager, lv_coord_t offset);
+static void sample_add(lv_pager_t * pager, lv_coord_t x);
+static int32_t get_velocity(const lv_pager_t * pager);
+static int32_t get_screen_id(const lv_pager_t * pager, const lv_obj_t * scr);
+static bool gesture_reaches_screen(lv_obj_t * obj, lv_obj_t * scr);
+static void screen_delete_event_cb(lv_event_t * e);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_ll_t pager_ll;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+lv_pager_t * lv_pager_create(lv_indev_t * indev)
+{
+    LV_ASSERT_NULL(indev);
+    if(indev->driver->type != LV_INDEV_TYPE_POINTER) {
+        LV_LOG_WARN("the pager works only with pointer input devices");
+        return NULL;
+    }
+
+    if(get_pager_of_indev(indev)) {
+        LV_LOG_WARN("the input device already has a pager");
+        return NULL;
+    }
+
+    if(pager_ll.n_size == 0) _lv_ll_init(&pager_ll, sizeof(lv_pager_t));
+
+    lv_pager_t * pager = _lv_ll_ins_tail(&pager_ll);
+    LV_ASSERT_MALLOC(pager);
+    if(pager == NULL) return NULL;
+    lv_memset_00(pager, sizeof(lv_pager_t));
+
+    pager->indev = indev;
+    pager->disp = indev->driver->disp;
+
+    /*Process the pointer right after LVGL has processed it*/
+    lv_timer_set_cb(indev->driver->read_timer, indev_read_timer_cb);
+
+    /*Hook into the end of rendering. If an other pager hooked it already keep only its original callback*/
+    lv_disp_drv_t * disp_drv = pager->disp->driver;
+    if(disp_drv->monitor_cb == monitor_cb) {
+        lv_pager_t * p;
+        _LV_LL_READ(&pager_ll, p) {
+            if(p != pager && p->disp == pager->disp) {
+                pager->monitor_cb_ori = p->monitor_cb_ori;
+                break;
+            }
+        }
+    }
+    else {
+        pager->monitor_cb_ori = disp_drv->monitor_cb;
+        disp_drv->monitor_cb = monitor_cb;
+    }
+
+    return pager;
+}
+
+void lv_pager_add_screen(lv_pager_t * pager, lv_obj_t * scr)
+{
+    LV_ASSERT_NULL(pager);
+    LV_ASSERT_OBJ(scr, &lv_obj_class);
+
+    lv_obj_t ** screens = lv_mem_realloc(pager->screens, (pager->screen_cnt + 1) * sizeof(lv_obj_t *));
+    LV_ASSERT_MALLOC(screens);
+    if(screens == NULL) return;
+
+    screens[pager->screen_cnt] = scr;
+    pager->screens = screens;
+    pager->screen_cnt++;
+
+    lv_obj_add_event_cb(scr, screen_delete_event_cb, LV_EVENT_DELETE, pager);
+}
+
+void lv_pager_set_change_cb(lv_pager_t * pager, lv_pager_change_cb_t cb)
+{
+    LV_ASSERT_NULL(pager);
+    pager->change_cb = cb;
+}
+
+lv_coord_t lv_pager_get_offset(const lv_pager_t * pager)
+{
+    LV_ASSERT_NULL(pager);
+    return pager->offset;
+}
+
+bool lv_pager_is_active(const lv_pager_t * pager)
+{
+    LV_ASSERT_NULL(pager);
+    return pager->state == PAGER_STATE_DRAG || pager->state == PAGER_STATE_SETTLE;
+}
+
+void lv_pager_get_stat(const lv_pager_t * pager, lv_pager_stat_t * stat)
+{
+    LV_ASSERT_NULL(pager);
+    *stat = pager->stat;
+    stat->latency_avg = pager->latency_cnt ? pager->latency_sum / pager->latency_cnt : 0;
+}
+
+void lv_pager_reset_stat(lv_pager_t * pager)
+{
+    LV_ASSERT_NULL(pager);
+    lv_memset_00(&pager->stat, sizeof(lv_pager_stat_t));
+    pager->latency_sum = 0;
+    pager->latency_cnt = 0;
+}
+
+#if LV_USE_USER_DATA
+
+void lv_pager_set_user_data(lv_pager_t * pager, void * user_data)
+{
+    LV_ASSERT_NULL(pager);
+    pager->user_data = user_data;
+}
+
+void * lv_pager_get_user_data(lv_pager_t * pager)
+{
+    LV_ASSERT_NULL(pager);
+    return pager->user_data;
+}
+
+#endif /*LV_USE_USER_DATA*/
+
+void lv_pager_del(lv_pager_t * pager)
+{
+    LV_ASSERT_NULL(pager);
+
+    lv_anim_del(pager, NULL);
+    if(pager->state == PAGER_STATE_DRAG || pager->state == PAGER_STATE_SETTLE) {
+        /*Go back to the active screen*/
+        pager->offset = 0;
+        finish(pager);
+    }
+
+    lv_timer_set_cb(pager->indev->driver->read_timer, lv_indev_read_timer_cb);
+
+    bool disp_shared = false;
+    lv_pager_t * p;
+    _LV_LL_READ(&pager_ll, p) {
+        if(p != pager && p->disp == pager->disp) {
+            disp_shared = true;
+            break;
+        }
+    }
+    if(!disp_shared) pager->disp->driver->monitor_cb = pager->monitor_cb_ori;
+
+    uint32_t i;
+    for(i = 0; i < pager->screen_cnt; i++) {
+        lv_obj_remove_event_cb_with_user_data(pager->screens[i], screen_delete_event_cb, pager);
+    }
+
+    if(pager->screens) lv_mem_free(pager->screens);
+    _lv_ll_remove(&pager_ll, pager);
+    lv_mem_free(pager);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static lv_pager_t * get_pager_of_indev(lv_indev_t * indev)
+{
+    if(pager_ll.n_size == 0) return NULL;
+
+    lv_pager_t * pager;
+    _LV_LL_READ(&pager_ll, pager) {
+        if(pager->indev == indev) return pager;
+    }
+
+    return NULL;
+}
+
+static void indev_read_timer_cb(lv_timer_t * timer)
+{
+    lv_pager_t * pager = get_pager_of_indev(timer->user_data);
+    if(pager == NULL || (pager->state != PAGER_STATE_DRAG && pager->state != PAGER_STATE_SETTLE)) {
+        lv_indev_read_timer_cb(timer);
+        if(pager) track_proc(pager);
+    }
+    else {
+        /*LVGL doesn't read the input while two screens are shown so read it here*/
+        own_read(pager);
+    }
+}
+
+static void monitor_cb(lv_disp_drv_t * disp_drv, uint32_t time, uint32_t px)
+{
+    lv_pager_t * first = NULL;
+    lv_pager_t * pager;
+    _LV_LL_READ(&pager_ll, pager) {
+        if(pager->disp->driver != disp_drv) continue;
+        if(first == NULL) first = pager;
+        frame_proc(pager);
+    }
+
+    if(first && first->monitor_cb_ori) first->monitor_cb_ori(disp_drv, time, px);
+}
+
+/**
+ * Follow a press processed by LVGL and take it over if it's a horizontal drag of the screen
+ */
+static void track_proc(lv_pager_t * pager)
+{
+    _lv_indev_proc_t * proc = &pager->indev->proc;
+    if(proc->state == LV_INDEV_STATE_RELEASED) {
+        pager->state = PAGER_STATE_IDLE;
+        return;
+    }
+
+    if(pager->state == PAGER_STATE_IGNORE) return;
+
+    /*Don't interfere with screen load animations*/
+    lv_disp_t * disp = pager->disp;
+    if(disp->prev_scr || disp->scr_to_load) {
+        pager->state = PAGER_STATE_IGNORE;
+        return;
+    }
+
+    if(pager->state == PAGER_STATE_IDLE) {
+        int32_t id = get_screen_id(pager, lv_disp_get_scr_act(disp));
+        if(id < 0) {
+            pager->state = PAGER_STATE_IGNORE;
+            return;
+        }
+
+        pager->act_id = id;
+        pager->press_point = proc->types.pointer.act_point;
+        pager->state = PAGER_STATE_TRACK;
+
+        /*Get the neighbours ready while it's not known yet whether they will be shown*/
+        if(id > 0) lv_obj_update_layout(pager->screens[id - 1]);
+        if(id + 1 < (int32_t)pager->screen_cnt) lv_obj_update_layout(pager->screens[id + 1]);
+        return;
+    }
+
+    /*Let the scrolled objects and the objects waiting for release have the press*/
+    if(proc->types.pointer.scroll_obj || proc->wait_until_release) {
+        pager->state = PAGER_STATE_IGNORE;
+        return;
+    }
+
+    lv_coord_t dx = proc->types.pointer.act_point.x - pager->press_point.x;
+    lv_coord_t dy = proc->types.pointer.act_point.y - pager->press_point.y;
+    lv_coord_t limit = pager->indev->driver->scroll_limit;
+    if(LV_ABS(dx) < limit && LV_ABS(dy) < limit) return;
+
+    if(LV_ABS(dy) >= LV_ABS(dx) ||
+       !gesture_reaches_screen(proc->types.pointer.act_obj, pager->screens[pager->act_id])) {
+        pager->state = PAGER_STATE_IGNORE;
+        return;
+    }
+
+    capture(pager);
+}
+
+/**
+ * Take over the press from the objects and start dragging the screens
+ */
+static void capture(lv_pager_t * pager)
+{
+    _lv_indev_proc_t * proc = &pager->indev->proc;
+
+    lv_obj_t * act_obj = proc->types.pointer.act_obj;
+    proc->types.pointer.act_obj = NULL;
+    proc->types.pointer.last_obj = NULL;
+    lv_indev_wait_release(pager->indev);
+    lv_event_send(act_obj, LV_EVENT_PRESS_LOST, pager->indev);
+
+    /*Start from where the drag was recognized to avoid a jump*/
+    lv_coord_t x = proc->types.pointer.act_point.x;
+    lv_coord_t limit = pager->indev->driver->scroll_limit;
+    pager->state = PAGER_STATE_DRAG;
+    pager->drag_start_x = pager->press_point.x + (x < pager->press_point.x ? -limit : limit);
+    pager->offset = 0;
+    pager->sample_cnt = 0;
+    pager->frame_seen = 0;
+    pager->latency_pending = 0;
+    drag_to(pager, x);
+}
+
+static void own_read(lv_pager_t * pager)
+{
+    lv_indev_t * indev = pager->indev;
+    if(indev->proc.disabled) return;
+
+    lv_disp_drv_t * disp_drv = pager->disp->driver;
+    lv_indev_data_t data;
+    bool continue_reading;
+    do {
+        _lv_indev_read(indev, &data);
+        continue_reading = data.continue_reading;
+
+        /*Keep the state of the input device up to date as `indev_pointer_proc` would do*/
+        indev->proc.types.pointer.last_raw_point = data.point;
+        if(disp_drv->rotated == LV_DISP_ROT_180 || disp_drv->rotated == LV_DISP_ROT_270) {
+            data.point.x = disp_drv->hor_res - data.point.x - 1;
+            data.point.y = disp_drv->ver_res - data.point.y - 1;
+        }
+        if(disp_drv->rotated == LV_DISP_ROT_90 || disp_drv->rotated == LV_DISP_ROT_270) {
+            lv_coord_t tmp = data.point.y;
+            data.point.y = data.point.x;
+            data.point.x = disp_drv->ver_res - tmp - 1;
+        }
+
+        indev->proc.state = data.state;
+        indev->proc.types.pointer.act_point = data.point;
+        indev->proc.types.pointer.last_point = data.point;
+        if(data.state == LV_INDEV_STATE_PRESSED) pager->disp->last_activity_time = lv_tick_get();
+
+        drag_proc(pager, &data);
+    } while(continue_reading && (pager->state == PAGER_STATE_DRAG || pager->state == PAGER_STATE_SETTLE));
+}
+
+static void drag_proc(lv_pager_t * pager, const lv_indev_data_t * data)
+{
+    if(pager->state == PAGER_STATE_SETTLE) {
+        if(data->state == LV_INDEV_STATE_RELEASED) return;
+
+        /*Catch the settling screens*/
+        lv_anim_del(pager, NULL);
+        pager->state = PAGER_STATE_DRAG;
+        pager->drag_start_x = data->point.x - pager->offset;
+        pager->sample_cnt = 0;
+        pager->frame_seen = 0;
+    }
+
+    if(data->state == LV_INDEV_STATE_RELEASED) {
+        release(pager);
+        return;
+    }
+
+    drag_to(pager, data->point.x);
+}
+
+/**
+ * Move the screens with the pointer
+ */
+static void drag_to(lv_pager_t * pager, lv_coord_t x)
+{
+    sample_add(pager, x);
+
+    lv_coord_t w = lv_disp_get_hor_res(pager->disp);
+    lv_coord_t offset = x - pager->drag_start_x;
+    bool has_neighbour = offset < 0 ? pager->act_id + 1 < pager->screen_cnt : pager->act_id > 0;
+    if(!has_neighbour) offset /= PAGER_RUBBER_BAND_DIV;
+    offset = LV_CLAMP(-w, offset, w);
+
+    if(offset == pager->offset) return;
+
+    set_offset(pager, offset);
+
+    if(!pager->latency_pending) {
+        pager->latency_start = lv_tick_get();
+        pager->latency_pending = 1;
+    }
+
+    /*Render the new position in this cycle instead of waiting for the refresh period*/
+    if(pager->disp->refr_timer) lv_timer_ready(pager->disp->refr_timer);
+}
+
+static void release(lv_pager_t * pager)
+{
+    lv_coord_t w = lv_disp_get_hor_res(pager->disp);
+    int32_t v = get_velocity(pager);
+    lv_coord_t target = 0;
+
+    if(pager->neighbour) {
+        int32_t projected = pager->offset + v * PAGER_PROJECTION_TIME / 1000;
+        bool flung = LV_ABS(v) > PAGER_FLING_VELOCITY && (v < 0) == (pager->offset < 0);
+        if(flung || (LV_ABS(projected) > w / 2 && (projected < 0) == (pager->offset < 0))) {
+            target = pager->offset < 0 ? -w : w;
+        }
+    }
+
+    settle(pager, target, v);
+}
+
+static void settle(lv_pager_t * pager, lv_coord_t target, int32_t v)
+{
+    int32_t dist = target - pager->offset;
+    if(dist == 0) {
+        finish(pager);
+        return;
+    }
+
+    /*Keep the speed of the finger if it was moving towards the target*/
+    uint32_t time = PAGER_SETTLE_TIME_MAX;
+    if((v < 0) == (dist < 0) && v != 0) {
+        time = LV_ABS(dist) * 1000 / LV_ABS(v);
+        time = LV_CLAMP(PAGER_SETTLE_TIME_MIN, time, PAGER_SETTLE_TIME_MAX);
+    }
+
+    pager->state = PAGER_STATE_SETTLE;
+    pager->frame_seen = 0;
+
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, pager);
+    lv_anim_set_exec_cb(&a, settle_anim_cb);
+    lv_anim_set_values(&a, pager->offset, target);
+    lv_anim_set_time(&a, time);
+    lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
+    lv_anim_set_ready_cb(&a, settle_ready_cb);
+    lv_anim_start(&a);
+}
+
+static void settle_anim_cb(void * var, int32_t v)
+{
+    set_offset(var, (lv_coord_t)v);
+}
+
+static void settle_ready_cb(lv_anim_t * a)
+{
+    finish(a->var);
+}
+
+/**
+ * Put the screens back to their normal position and load the neighbour if it was moved in
+ */
+static void finish(lv_pager_t * pager)
+{
+    lv_disp_t * disp = pager->disp;
+    lv_obj_t * act = pager->screens[pager->act_id];
+    lv_obj_t * neighbour = pager->neighbour;
+    bool load = neighbour && LV_ABS(pager->offset) >= lv_disp_get_hor_res(disp);
+
+    if(disp->prev_scr == neighbour) disp->prev_scr = NULL;
+    pager->neighbour = NULL;
+    pager->offset = 0;
+    pager->state = PAGER_STATE_IDLE;
+    lv_obj_set_x(act, 0);
+    if(neighbour) lv_obj_set_x(neighbour, 0);
+
+    /*The unloaded screen won't be refreshed, so apply its position now*/
+    lv_obj_update_layout(act);
+    if(neighbour) lv_obj_update_layout(neighbour);
+
+    if(load) {
+        pager->act_id = get_screen_id(pager, neighbour);
+        pager->stat.swipe_cnt++;
+        lv_scr_load(neighbour);
+        if(pager->change_cb) pager->change_cb(pager, neighbour);
+    }
+    else {
+        lv_obj_invalidate(act);
+    }
+}
+
+static void set_offset(lv_pager_t * pager, lv_coord_t offset)
+{
+    lv_disp_t * disp = pager->disp;
+    lv_coord_t w = lv_disp_get_hor_res(disp);
+
+    int32_t id = -1;
+    if(offset < 0 && pager->act_id + 1 < pager->screen_cnt) id = pager->act_id + 1;
+    else if(offset > 0 && pager->act_id > 0) id = pager->act_id - 1;
+    lv_obj_t * neighbour = id >= 0 ? pager->screens[id] : NULL;
+
+    /*Draw the neighbour as the "previous screen" to render both screens in the same frame*/
+    if(neighbour != pager->neighbour) {
+        if(pager->neighbour) lv_obj_set_x(pager->neighbour, 0);
+        pager->neighbour = neighbour;
+        disp->prev_scr = neighbour;
+    }
+
+    pager->offset = offset;
+    lv_obj_set_x(pager->screens[pager->act_id], offset);
+    if(neighbour) lv_obj_set_x(neighbour, offset < 0 ? offset + w : offset - w);
+}
+
+static void frame_proc(lv_pager_t * pager)
+{
+    if(pager->state != PAGER_STATE_DRAG && pager->state != PAGER_STATE_SETTLE) return;
+
+    uint32_t period = pager->disp->refr_timer ? pager->disp->refr_timer->period : LV_DISP_DEF_REFR_PERIOD;
+    period = LV_MAX(period, 1);
+
+    pager->stat.frame_cnt++;
+
+    /*While dragging a frame is late if a touch waited more than a period for it*/
+    if(pager->latency_pending) {
+        uint32_t latency = lv_tick_elaps(pager->latency_start);
+        pager->latency_sum += latency;
+        pager->latency_cnt++;
+        pager->stat.latency_max = LV_MAX(pager->stat.latency_max, latency);
+        pager->stat.frame_drop_cnt += latency / period;
+        pager->latency_pending = 0;
+    }
+    /*While settling a frame should be rendered in every period*/
+    else if(pager->state == PAGER_STATE_SETTLE && pager->frame_seen) {
+        uint32_t elaps = lv_tick_elaps(pager->last_frame_tick);
+        uint32_t periods = (elaps + period / 2) / period;
+        if(periods > 1) pager->stat.frame_drop_cnt += periods - 1;
+    }
+
+    pager->last_frame_tick = lv_tick_get();
+    pager->frame_seen = 1;
+}
+
+static void sample_add(lv_pager_t * pager, lv_coord_t x)
+{
+    pager->samples[pager->sample_next].x = x;
+    pager->samples[pager->sample_next].tick = lv_tick_get();
+    pager->sample_next = (pager->sample_next + 1) % PAGER_SAMPLE_CNT;
+    if(pager->sample_cnt < PAGER_SAMPLE_CNT) pager->sample_cnt++;
+}
+
+/**
+ * Get the horizontal velocity of the pointer from the recent samples
+ * @return      the velocity in px/s
+ */
+static int32_t get_velocity(const lv_pager_t * pager)
+{
+    if(pager->sample_cnt < 2) return 0;
+
+    uint32_t now = lv_tick_get();
+    uint32_t last_i = (pager->sample_next + PAGER_SAMPLE_CNT - 1) % PAGER_SAMPLE_CNT;
+    const pager_sample_t * last = &pager->samples[last_i];
+
+    /*Find the oldest sample in the window*/
+    const pager_sample_t * first = last;
+    uint32_t i;
+    for(i = 1; i < pager->sample_cnt; i++) {
+        const pager_sample_t * s = &pager->samples[(last_i + PAGER_SAMPLE_CNT - i) % PAGER_SAMPLE_CNT];
+        if(lv_tick_elaps(s->tick) > PAGER_VELOCITY_WINDOW) break;
+        first = s;
+    }
+
+    /*The pointer stood still before the release*/
+    if(now - last->tick > PAGER_VELOCITY_WINDOW) return 0;
+
+    uint32_t dt = last->tick - first->tick;
+    if(dt == 0) return 0;
+
+    return (int32_t)(last->x - first->x) * 1000 / (int32_t)dt;
+}
+
+static int32_t get_screen_id(const lv_pager_t * pager, const lv_obj_t * scr)
+{
+    uint32_t i;
+    for(i = 0; i < pager->screen_cnt; i++) {
+        if(pager->screens[i] == scr) return (int32_t)i;
+    }
+
+    return -1;
+}
+
+/**
+ * Check if a gesture on an object would be sent to the screen (see `indev_gesture`)
+ */
+static bool gesture_reaches_screen(lv_obj_t * obj, lv_obj_t * scr)
+{
+    while(obj && lv_obj_has_flag(obj, LV_OBJ_FLAG_GESTURE_BUBBLE)) {
+        obj = lv_obj_get_parent(obj);
+    }
+
+    return obj == NULL || obj == scr;
+}
+
+static void screen_delete_event_cb(lv_event_t * e)
+{
+    lv_pager_t * pager = lv_event_get_user_data(e);
+    lv_obj_t * scr = lv_event_get_target(e);
+
+    int32_t id = get_screen_id(pager, scr);
+    if(id < 0) return;
+
+    /*Stop moving the screens before one of them disappears*/
+    if(pager->state == PAGER_STATE_DRAG || pager->state == PAGER_STATE_SETTLE) {
+        lv_anim_del(pager, NULL);
+        pager->offset = 0;
+        finish(pager);
+    }
+
+    uint32_t i;
+    for(i = id; i + 1 < pager->screen_cnt; i++) {
+        pager->screens[i] = pager->screens[i + 1];
+    }
+    pager->screen_cnt--;
+    if(pager->act_id > (uint32_t)id) pager->act_id--;
+}
+
+#endif /*LV_USE_PAGER*/
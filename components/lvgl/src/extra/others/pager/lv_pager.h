@@ -0,0 +1,131 @@
+/**
+ * @file lv_pager.h
+ *
+ */
+#ifndef LV_PAGER_H
+#define LV_PAGER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../../lvgl.h"
+
+#if LV_USE_PAGER
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+struct _lv_pager;
+typedef struct _lv_pager lv_pager_t;
+
+/**
+ * Called when a swipe loaded a new screen
+ */
+typedef void (*lv_pager_change_cb_t)(lv_pager_t * pager, lv_obj_t * scr);
+
+typedef struct {
+    uint32_t swipe_cnt;         /**< Number of swipes which loaded a new screen*/
+    uint32_t frame_cnt;         /**< Frames rendered while the screens were dragged or settling*/
+    uint32_t frame_drop_cnt;    /**< Refresh periods missed while the screens were dragged or settling*/
+    uint32_t latency_avg;       /**< Average time from reading a touch to rendering it [ms]*/
+    uint32_t latency_max;       /**< Maximal time from reading a touch to rendering it [ms]*/
+} lv_pager_stat_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Create a pager which moves between screens by dragging them horizontally with a pointer.
+ * The screens follow the finger and the neighbour screen is drawn next to the active one.
+ * On release the screens settle on the nearer screen or the screen the swipe was flung to.
+ * Drags which start on objects whose gestures don't bubble to the screen, or which scroll something, are ignored.
+ * @param indev     pointer to a pointer input device
+ * @return          pointer to the created pager
+ */
+lv_pager_t * lv_pager_create(lv_indev_t * indev);
+
+/**
+ * Append a screen to the pager. The screens are ordered from left to right in the order they were added.
+ * @param pager     pointer to a pager
+ * @param scr       pointer to a screen
+ */
+void lv_pager_add_screen(lv_pager_t * pager, lv_obj_t * scr);
+
+/**
+ * Set a function to call when a swipe loaded a new screen
+ * @param pager     pointer to a pager
+ * @param cb        the callback function or NULL
+ */
+void lv_pager_set_change_cb(lv_pager_t * pager, lv_pager_change_cb_t cb);
+
+/**
+ * Get the horizontal offset of the active screen while it's being dragged or settling
+ * @param pager     pointer to a pager
+ * @return          the offset in pixels, 0 if the screens are not moving
+ */
+lv_coord_t lv_pager_get_offset(const lv_pager_t * pager);
+
+/**
+ * Check whether the screens are being dragged or settling
+ * @param pager     pointer to a pager
+ * @return          true: the pager handles the input now
+ */
+bool lv_pager_is_active(const lv_pager_t * pager);
+
+/**
+ * Get the swipe and rendering statistics of the pager
+ * @param pager     pointer to a pager
+ * @param stat      store the statistics here
+ */
+void lv_pager_get_stat(const lv_pager_t * pager, lv_pager_stat_t * stat);
+
+/**
+ * Clear the statistics of the pager
+ * @param pager     pointer to a pager
+ */
+void lv_pager_reset_stat(lv_pager_t * pager);
+
+#if LV_USE_USER_DATA
+
+/**
+ * Set the user_data field of the pager
+ * @param pager     pointer to a pager
+ * @param user_data pointer to the new user_data.
+ */
+void lv_pager_set_user_data(lv_pager_t * pager, void * user_data);
+
+/**
+ * Get the user_data field of the pager
+ * @param pager     pointer to a pager
+ * @return          the pointer to the user_data of the pager
+ */
+void * lv_pager_get_user_data(lv_pager_t * pager);
+
+#endif /*LV_USE_USER_DATA*/
+
+/**
+ * Delete a pager. The screens are moved back to their normal position.
+ * @param pager     pointer to a pager
+ */
+void lv_pager_del(lv_pager_t * pager);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_USE_PAGER*/
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*LV_PAGER_H*/
@@ -36,10 +36,14 @@ static void draw_div_lines(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx);
 static void draw_series_line(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx);
 static void draw_series_bar(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx);
 static void draw_series_scatter(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx);
+static void draw_series_stream(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx);
 static void draw_cursors(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx);
 static void draw_axes(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx);
 static uint32_t get_index_from_x(lv_obj_t * obj, lv_coord_t x);
 static void invalidate_point(lv_obj_t * obj, uint16_t i);
+static bool stream_update_cols(lv_obj_t * obj);
+static bool stream_add_value(lv_obj_t * obj, lv_chart_series_t * ser, lv_coord_t value);
+static void stream_invalidate_last_col(lv_obj_t * obj);
 static void new_points_alloc(lv_obj_t * obj, lv_chart_series_t * ser, uint32_t cnt, lv_coord_t ** a);
 lv_chart_tick_dsc_t * get_tick_gsc(lv_obj_t * obj, lv_chart_axis_t axis);
 
@@ -118,6 +122,7 @@ void lv_chart_set_point_count(lv_obj_t * obj, uint16_t cnt)
         }
         if(!ser->y_ext_buf_assigned) new_points_alloc(obj, ser, cnt, &ser->y_points);
         ser->start_point = 0;
+        ser->cols_valid = 0;
     }
 
     chart->point_cnt = cnt;
@@ -264,7 +269,7 @@ uint16_t lv_chart_get_x_start_point(const lv_obj_t * obj, lv_chart_series_t * se
     LV_ASSERT_NULL(ser);
     lv_chart_t * chart  = (lv_chart_t *)obj;
 
-    return chart->update_mode == LV_CHART_UPDATE_MODE_SHIFT ? ser->start_point : 0;
+    return chart->update_mode != LV_CHART_UPDATE_MODE_CIRCULAR ? ser->start_point : 0;
 }
 
 void lv_chart_get_point_pos_by_id(lv_obj_t * obj, lv_chart_series_t * ser, uint16_t id, lv_point_t * p_out)
@@ -367,6 +372,8 @@ lv_chart_series_t * lv_chart_add_series(lv_obj_t * obj, lv_color_t color, lv_cha
     }
 
     ser->start_point = 0;
+    ser->cols = NULL;
+    ser->cols_valid = 0;
     ser->y_ext_buf_assigned = false;
     ser->hidden = 0;
     ser->x_axis_sec = axis & LV_CHART_AXIS_SECONDARY_X ? 1 : 0;
@@ -389,6 +396,7 @@ void lv_chart_remove_series(lv_obj_t * obj, lv_chart_series_t * series)
 
     lv_chart_t * chart    = (lv_chart_t *)obj;
     if(!series->y_ext_buf_assigned && series->y_points) lv_mem_free(series->y_points);
+    if(series->cols) lv_mem_free(series->cols);
 
     _lv_ll_remove(&chart->series_ll, series);
     lv_mem_free(series);
@@ -423,6 +431,7 @@ void lv_chart_set_x_start_point(lv_obj_t * obj, lv_chart_series_t * ser, uint16_
     lv_chart_t * chart  = (lv_chart_t *)obj;
     if(id >= chart->point_cnt) return;
     ser->start_point = id;
+    ser->cols_valid = 0;
 }
 
 lv_chart_series_t * lv_chart_get_series_next(const lv_obj_t * obj, const lv_chart_series_t * ser)
@@ -532,6 +541,7 @@ void lv_chart_set_all_value(lv_obj_t * obj, lv_chart_series_t * ser, lv_coord_t
         ser->y_points[i] = value;
     }
     ser->start_point = 0;
+    ser->cols_valid = 0;
     lv_chart_refresh(obj);
 }
 
@@ -541,12 +551,50 @@ void lv_chart_set_next_value(lv_obj_t * obj, lv_chart_series_t * ser, lv_coord_t
     LV_ASSERT_NULL(ser);
 
     lv_chart_t * chart  = (lv_chart_t *)obj;
+    if(chart->update_mode == LV_CHART_UPDATE_MODE_STREAM) {
+        if(stream_add_value(obj, ser, value)) lv_obj_invalidate(obj);
+        else stream_invalidate_last_col(obj);
+        return;
+    }
+
     ser->y_points[ser->start_point] = value;
+    ser->cols_valid = 0;
     invalidate_point(obj, ser->start_point);
     ser->start_point = (ser->start_point + 1) % chart->point_cnt;
     invalidate_point(obj, ser->start_point);
 }
 
+void lv_chart_set_next_values(lv_obj_t * obj, lv_chart_series_t * ser, const lv_coord_t values[], uint32_t cnt)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    LV_ASSERT_NULL(ser);
+
+    lv_chart_t * chart  = (lv_chart_t *)obj;
+    if(cnt == 0) return;
+
+    uint32_t i;
+    if(chart->update_mode == LV_CHART_UPDATE_MODE_CIRCULAR) {
+        /*Only the changed points are invalidated*/
+        for(i = 0; i < cnt; i++) lv_chart_set_next_value(obj, ser, values[i]);
+    }
+    else if(chart->update_mode == LV_CHART_UPDATE_MODE_STREAM) {
+        bool shifted = false;
+        for(i = 0; i < cnt; i++) {
+            if(stream_add_value(obj, ser, values[i])) shifted = true;
+        }
+        if(shifted) lv_obj_invalidate(obj);
+        else stream_invalidate_last_col(obj);
+    }
+    else {
+        for(i = 0; i < cnt; i++) {
+            ser->y_points[ser->start_point] = values[i];
+            ser->start_point = (ser->start_point + 1) % chart->point_cnt;
+        }
+        ser->cols_valid = 0;
+        lv_obj_invalidate(obj);
+    }
+}
+
 void lv_chart_set_next_value2(lv_obj_t * obj, lv_chart_series_t * ser, lv_coord_t x_value, lv_coord_t y_value)
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
@@ -573,6 +621,7 @@ void lv_chart_set_value_by_id(lv_obj_t * obj, lv_chart_series_t * ser, uint16_t
 
     if(id >= chart->point_cnt) return;
     ser->y_points[id] = value;
+    ser->cols_valid = 0;
     invalidate_point(obj, id);
 }
 
@@ -602,6 +651,7 @@ void lv_chart_set_ext_y_array(lv_obj_t * obj, lv_chart_series_t * ser, lv_coord_
     if(!ser->y_ext_buf_assigned && ser->y_points) lv_mem_free(ser->y_points);
     ser->y_ext_buf_assigned = true;
     ser->y_points = array;
+    ser->cols_valid = 0;
     lv_obj_invalidate(obj);
 }
 
@@ -684,6 +734,7 @@ static void lv_chart_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
         ser = _lv_ll_get_head(&chart->series_ll);
 
         if(!ser->y_ext_buf_assigned) lv_mem_free(ser->y_points);
+        if(ser->cols) lv_mem_free(ser->cols);
 
         _lv_ll_remove(&chart->series_ll, ser);
         lv_mem_free(ser);
@@ -751,7 +802,10 @@ static void lv_chart_event(const lv_obj_class_t * class_p, lv_event_t * e)
         draw_axes(obj, draw_ctx);
 
         if(_lv_ll_is_empty(&chart->series_ll) == false) {
-            if(chart->type == LV_CHART_TYPE_LINE) draw_series_line(obj, draw_ctx);
+            if(chart->type == LV_CHART_TYPE_LINE) {
+                if(stream_update_cols(obj)) draw_series_stream(obj, draw_ctx);
+                else draw_series_line(obj, draw_ctx);
+            }
             else if(chart->type == LV_CHART_TYPE_BAR) draw_series_bar(obj, draw_ctx);
             else if(chart->type == LV_CHART_TYPE_SCATTER) draw_series_scatter(obj, draw_ctx);
         }
@@ -1037,6 +1091,101 @@ static void draw_series_line(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
     draw_ctx->clip_area = clip_area_ori;
 }
 
+/**
+ * Draw the series of a crowded line chart in `LV_CHART_UPDATE_MODE_STREAM` from the cached columns.
+ * Each column is a vertical line between the min. and max. value of its points,
+ * connected to the last point of the previous column.
+ * Draw part events are not sent for the points.
+ */
+static void draw_series_stream(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
+{
+    lv_area_t clip_area;
+    if(_lv_area_intersect(&clip_area, &obj->coords, draw_ctx->clip_area) == false) return;
+
+    const lv_area_t * clip_area_ori = draw_ctx->clip_area;
+    draw_ctx->clip_area = &clip_area;
+
+    lv_chart_t * chart  = (lv_chart_t *)obj;
+    lv_coord_t border_width = lv_obj_get_style_border_width(obj, LV_PART_MAIN);
+    lv_coord_t pad_left = lv_obj_get_style_pad_left(obj, LV_PART_MAIN) + border_width;
+    lv_coord_t pad_top = lv_obj_get_style_pad_top(obj, LV_PART_MAIN) + border_width;
+    lv_coord_t w     = ((int32_t)lv_obj_get_content_width(obj) * chart->zoom_x) >> 8;
+    lv_coord_t h     = ((int32_t)lv_obj_get_content_height(obj) * chart->zoom_y) >> 8;
+    lv_coord_t x_ofs = obj->coords.x1 + pad_left - lv_obj_get_scroll_left(obj);
+    lv_coord_t y_ofs = obj->coords.y1 + pad_top - lv_obj_get_scroll_top(obj);
+
+    lv_draw_line_dsc_t line_dsc;
+    lv_draw_line_dsc_init(&line_dsc);
+    lv_obj_init_draw_line_dsc(obj, LV_PART_ITEMS, &line_dsc);
+    line_dsc.raw_end = 1;   /*The columns are close to each other*/
+
+    uint32_t col_points = chart->col_points;
+    uint32_t col_cnt = chart->col_cnt;
+    lv_chart_series_t * ser;
+    _LV_LL_READ_BACK(&chart->series_ll, ser) {
+        if(ser->hidden) continue;
+        line_dsc.color = ser->color;
+
+        int32_t ymin = chart->ymin[ser->y_axis_sec];
+        int32_t yrange = chart->ymax[ser->y_axis_sec] - ymin;
+
+        /*The newest column is drawn on the right and it contains only the new points*/
+        uint32_t newest = (ser->start_point + chart->point_cnt - 1) % chart->point_cnt;
+        uint32_t col_newest = newest / col_points;
+
+        lv_point_t p1;
+        lv_point_t p2;
+        lv_point_t prev = {0, 0};
+        bool prev_valid = false;
+        uint32_t i;
+        for(i = 0; i < col_cnt; i++) {
+            lv_coord_t x = x_ofs + (col_cnt > 1 ? ((int32_t)w * i) / (col_cnt - 1) : 0);
+            if(x > clip_area.x2 + line_dsc.width) break;
+
+            uint32_t col = (col_newest + 1 + i) % col_cnt;
+            const lv_coord_t * min_max = &ser->cols[col * 2];
+            if(min_max[0] == LV_CHART_POINT_NONE) {
+                prev_valid = false;
+                continue;
+            }
+
+            uint32_t first = col * col_points;
+            uint32_t last = col == col_newest ? newest : LV_MIN(first + col_points, chart->point_cnt) - 1;
+
+            if(x >= clip_area.x1 - line_dsc.width) {
+                p1.x = x;
+                p1.y = h - ((int32_t)min_max[1] - ymin) * h / yrange + y_ofs;
+                p2.x = x;
+                p2.y = h - ((int32_t)min_max[0] - ymin) * h / yrange + y_ofs;
+
+                /*Connect to the last point of the previous column*/
+                if(prev_valid && ser->y_points[first] != LV_CHART_POINT_NONE) {
+                    if(x - prev.x <= 1) {
+                        /*Adjacent columns: just extend the vertical line*/
+                        p1.y = LV_MIN(p1.y, prev.y);
+                        p2.y = LV_MAX(p2.y, prev.y);
+                    }
+                    else {
+                        lv_point_t p_first;
+                        p_first.x = x;
+                        p_first.y = h - ((int32_t)ser->y_points[first] - ymin) * h / yrange + y_ofs;
+                        lv_draw_line(draw_ctx, &line_dsc, &prev, &p_first);
+                    }
+                }
+
+                if(p1.y == p2.y) p2.y++;    /*If they are the same no line will be drawn*/
+                lv_draw_line(draw_ctx, &line_dsc, &p1, &p2);
+            }
+
+            prev_valid = ser->y_points[last] != LV_CHART_POINT_NONE;
+            prev.x = x;
+            prev.y = h - ((int32_t)ser->y_points[last] - ymin) * h / yrange + y_ofs;
+        }
+    }
+
+    draw_ctx->clip_area = clip_area_ori;
+}
+
 static void draw_series_scatter(lv_obj_t * obj, lv_draw_ctx_t * draw_ctx)
 {
 
@@ -1690,7 +1839,7 @@ static void invalidate_point(lv_obj_t * obj, uint16_t i)
     lv_coord_t scroll_left = lv_obj_get_scroll_left(obj);
 
     /*In shift mode the whole chart changes so the whole object*/
-    if(chart->update_mode == LV_CHART_UPDATE_MODE_SHIFT) {
+    if(chart->update_mode != LV_CHART_UPDATE_MODE_CIRCULAR) {
         lv_obj_invalidate(obj);
         return;
     }
@@ -1743,6 +1892,122 @@ static void invalidate_point(lv_obj_t * obj, uint16_t i)
     }
 }
 
+static void stream_col_add(lv_coord_t * min_max, lv_coord_t value)
+{
+    if(value == LV_CHART_POINT_NONE) return;
+
+    if(min_max[0] == LV_CHART_POINT_NONE) {
+        min_max[0] = value;
+        min_max[1] = value;
+    }
+    else {
+        min_max[0] = LV_MIN(min_max[0], value);
+        min_max[1] = LV_MAX(min_max[1], value);
+    }
+}
+
+/**
+ * Update the min/max columns of the series in `LV_CHART_UPDATE_MODE_STREAM`.
+ * The columns are fixed ranges of the point arrays so appending a point changes only one column.
+ * @param obj   pointer to a chart object
+ * @return      true: the series can be drawn from the columns; false: draw the points
+ */
+static bool stream_update_cols(lv_obj_t * obj)
+{
+    lv_chart_t * chart  = (lv_chart_t *)obj;
+    lv_coord_t w = ((int32_t)lv_obj_get_content_width(obj) * chart->zoom_x) >> 8;
+
+    uint32_t col_points = 0;
+    if(chart->update_mode == LV_CHART_UPDATE_MODE_STREAM && chart->type == LV_CHART_TYPE_LINE &&
+       w > 0 && chart->point_cnt > w) {
+        col_points = (chart->point_cnt + w - 1) / w;
+    }
+
+    lv_chart_series_t * ser;
+    if(col_points != chart->col_points) {
+        chart->col_points = col_points;
+        chart->col_cnt = col_points ? (chart->point_cnt + col_points - 1) / col_points : 0;
+        _LV_LL_READ_BACK(&chart->series_ll, ser) {
+            ser->cols_valid = 0;
+        }
+    }
+    if(col_points == 0) return false;
+
+    _LV_LL_READ_BACK(&chart->series_ll, ser) {
+        if(ser->cols_valid) continue;
+
+        lv_coord_t * cols = lv_mem_realloc(ser->cols, sizeof(lv_coord_t) * 2 * chart->col_cnt);
+        LV_ASSERT_MALLOC(cols);
+        if(cols == NULL) return false;
+        ser->cols = cols;
+
+        uint32_t i;
+        for(i = 0; i < 2 * (uint32_t)chart->col_cnt; i++) cols[i] = LV_CHART_POINT_NONE;
+
+        /*The newest column has only the points added since it was started*/
+        uint32_t newest = (ser->start_point + chart->point_cnt - 1) % chart->point_cnt;
+        uint32_t newest_end = (newest / col_points + 1) * col_points;
+        for(i = 0; i < chart->point_cnt; i++) {
+            if(i > newest && i < newest_end) continue;
+            stream_col_add(&cols[(i / col_points) * 2], ser->y_points[i]);
+        }
+        ser->cols_valid = 1;
+    }
+
+    return true;
+}
+
+/**
+ * Add a point to a series in `LV_CHART_UPDATE_MODE_STREAM` and update its column
+ * @param obj   pointer to a chart object
+ * @param ser   pointer to a series
+ * @param value the new value
+ * @return      true: all columns are shifted so the whole chart needs to be redrawn;
+ *              false: only the last column changed
+ */
+static bool stream_add_value(lv_obj_t * obj, lv_chart_series_t * ser, lv_coord_t value)
+{
+    lv_chart_t * chart  = (lv_chart_t *)obj;
+    uint32_t id = ser->start_point;
+    ser->y_points[id] = value;
+    ser->start_point = (id + 1) % chart->point_cnt;
+
+    if(!ser->cols_valid || chart->col_points == 0) return true;
+
+    lv_coord_t * min_max = &ser->cols[(id / chart->col_points) * 2];
+    bool new_col = id % chart->col_points == 0;
+    if(new_col) {
+        min_max[0] = LV_CHART_POINT_NONE;
+        min_max[1] = LV_CHART_POINT_NONE;
+    }
+    stream_col_add(min_max, value);
+    return new_col;
+}
+
+static void stream_invalidate_last_col(lv_obj_t * obj)
+{
+    lv_chart_t * chart  = (lv_chart_t *)obj;
+    if(chart->col_cnt < 2) {
+        lv_obj_invalidate(obj);
+        return;
+    }
+
+    lv_coord_t w  = ((int32_t)lv_obj_get_content_width(obj) * chart->zoom_x) >> 8;
+    lv_coord_t bwidth = lv_obj_get_style_border_width(obj, LV_PART_MAIN);
+    lv_coord_t pleft = lv_obj_get_style_pad_left(obj, LV_PART_MAIN);
+    lv_coord_t x_ofs = obj->coords.x1 + pleft + bwidth - lv_obj_get_scroll_left(obj);
+    lv_coord_t line_width = lv_obj_get_style_line_width(obj, LV_PART_ITEMS);
+
+    /*The last column and its connection to the previous one*/
+    lv_area_t coords;
+    lv_area_copy(&coords, &obj->coords);
+    coords.y1 -= line_width;
+    coords.y2 += line_width;
+    coords.x1 = ((int32_t)w * (chart->col_cnt - 2)) / (chart->col_cnt - 1) + x_ofs - line_width;
+    coords.x2 = w + x_ofs + line_width;
+    lv_obj_invalidate_area(obj, &coords);
+}
+
 static void new_points_alloc(lv_obj_t * obj, lv_chart_series_t * ser, uint32_t cnt, lv_coord_t ** a)
 {
     if((*a) == NULL) return;
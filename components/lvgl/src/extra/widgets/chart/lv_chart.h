@@ -50,6 +50,7 @@ typedef uint8_t lv_chart_type_t;
 enum {
     LV_CHART_UPDATE_MODE_SHIFT,     /**< Shift old data to the left and add the new one the right*/
     LV_CHART_UPDATE_MODE_CIRCULAR,  /**< Add the new data in a circular way*/
+    LV_CHART_UPDATE_MODE_STREAM,    /**< Like shift but many points are drawn as min/max columns updated one by one*/
 };
 typedef uint8_t lv_chart_update_mode_t;
 
@@ -71,8 +72,10 @@ typedef uint8_t lv_chart_axis_t;
 typedef struct {
     lv_coord_t * x_points;
     lv_coord_t * y_points;
+    lv_coord_t * cols;      /**< Min. and max. values of the columns in `LV_CHART_UPDATE_MODE_STREAM`*/
     lv_color_t color;
     uint16_t start_point;
+    uint8_t cols_valid : 1;
     uint8_t hidden : 1;
     uint8_t x_ext_buf_assigned : 1;
     uint8_t y_ext_buf_assigned : 1;
@@ -112,10 +115,12 @@ typedef struct {
     uint16_t hdiv_cnt;      /**< Number of horizontal division lines*/
     uint16_t vdiv_cnt;      /**< Number of vertical division lines*/
     uint16_t point_cnt;    /**< Point number in a data line*/
+    uint16_t col_points;   /**< Points per column in `LV_CHART_UPDATE_MODE_STREAM` or 0 if not crowded*/
+    uint16_t col_cnt;      /**< Number of columns in `LV_CHART_UPDATE_MODE_STREAM`*/
     uint16_t zoom_x;
     uint16_t zoom_y;
     lv_chart_type_t type  : 3; /**< Line or column chart*/
-    lv_chart_update_mode_t update_mode : 1;
+    lv_chart_update_mode_t update_mode : 2;
 } lv_chart_t;
 
 extern const lv_obj_class_t lv_chart_class;
@@ -376,6 +381,16 @@ void lv_chart_set_all_value(lv_obj_t * obj, lv_chart_series_t * ser, lv_coord_t
  */
 void lv_chart_set_next_value(lv_obj_t * obj, lv_chart_series_t * ser, lv_coord_t value);
 
+/**
+ * Set the next points' Y values according to the update mode policy.
+ * The chart is invalidated only once.
+ * @param obj       pointer to chart object
+ * @param ser       pointer to a data series on 'chart'
+ * @param values    the new values
+ * @param cnt       number of values in `values`
+ */
+void lv_chart_set_next_values(lv_obj_t * obj, lv_chart_series_t * ser, const lv_coord_t values[], uint32_t cnt);
+
 /**
  * Set the next point's X and Y value according to the update mode policy.
  * @param obj       pointer to chart object
@@ -60,12 +60,34 @@ typedef struct cmap_table_bin {
     uint8_t padding;
 } cmap_table_bin_t;
 
+/*The descriptor of the loaded fonts*/
+typedef struct {
+    lv_font_fmt_txt_dsc_t dsc;              /*Has to be the first*/
+    lv_font_fmt_txt_glyph_cache_t cache;
+
+    /*If the file is mapped the tables point into it, so it's kept open until the font is freed*/
+    lv_fs_file_t file;
+    const uint8_t * mapped;
+    uint32_t mapped_size;
+
+    /*If the bitmaps of a mapped file are not byte aligned they are shifted to `glyph_bitmap` when drawn*/
+    const uint8_t * loca;
+    uint32_t loca_count;
+    uint8_t loca_format;
+    uint16_t header_bits;
+    const uint8_t * glyf;
+    uint32_t glyf_length;
+} font_loader_dsc_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static bit_iterator_t init_bit_iterator(lv_fs_file_t * fp);
 static bool lvgl_load_font(lv_fs_file_t * fp, lv_font_t * font);
 int32_t load_kern(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc, uint8_t format, uint32_t start);
+static const void * load_data(lv_fs_file_t * fp, uint32_t size, uint32_t align);
+static void free_data(font_loader_dsc_t * ldsc, const void * data);
+static const uint8_t * get_glyph_bitmap_mapped(const lv_font_t * font, uint32_t letter);
 
 static int read_bits_signed(bit_iterator_t * it, int n_bits, lv_fs_res_t * res);
 static unsigned int read_bits(bit_iterator_t * it, int n_bits, lv_fs_res_t * res);
@@ -79,7 +101,9 @@ static unsigned int read_bits(bit_iterator_t * it, int n_bits, lv_fs_res_t * res
  **********************/
 
 /**
- * Loads a `lv_font_t` object from a binary font file
+ * Loads a `lv_font_t` object from a binary font file.
+ * If the driver maps the file into the memory the font points into the file instead of copying it,
+ * and the file is kept open until the font is freed.
  * @param font_name filename where the font file is located
  * @return a pointer to the font or NULL in case of error
  */
@@ -105,7 +129,10 @@ lv_font_t * lv_font_load(const char * font_name)
         }
     }
 
-    lv_fs_close(&file);
+    /*The fonts loaded from mapped files point into the file*/
+    font_loader_dsc_t * ldsc = font ? (font_loader_dsc_t *)font->dsc : NULL;
+    if(ldsc && ldsc->mapped) ldsc->file = file;
+    else lv_fs_close(&file);
 
     return font;
 }
@@ -117,21 +144,18 @@ lv_font_t * lv_font_load(const char * font_name)
 void lv_font_free(lv_font_t * font)
 {
     if(NULL != font) {
-        lv_font_fmt_txt_dsc_t * dsc = (lv_font_fmt_txt_dsc_t *)font->dsc;
+        font_loader_dsc_t * ldsc = (font_loader_dsc_t *)font->dsc;
 
-        if(NULL != dsc) {
+        if(NULL != ldsc) {
+            lv_font_fmt_txt_dsc_t * dsc = &ldsc->dsc;
 
             if(dsc->kern_classes == 0) {
                 lv_font_fmt_txt_kern_pair_t * kern_dsc =
                     (lv_font_fmt_txt_kern_pair_t *)dsc->kern_dsc;
 
                 if(NULL != kern_dsc) {
-                    if(kern_dsc->glyph_ids)
-                        lv_mem_free((void *)kern_dsc->glyph_ids);
-
-                    if(kern_dsc->values)
-                        lv_mem_free((void *)kern_dsc->values);
-
+                    free_data(ldsc, kern_dsc->glyph_ids);
+                    free_data(ldsc, kern_dsc->values);
                     lv_mem_free((void *)kern_dsc);
                 }
             }
@@ -140,15 +164,9 @@ void lv_font_free(lv_font_t * font)
                     (lv_font_fmt_txt_kern_classes_t *)dsc->kern_dsc;
 
                 if(NULL != kern_dsc) {
-                    if(kern_dsc->class_pair_values)
-                        lv_mem_free((void *)kern_dsc->class_pair_values);
-
-                    if(kern_dsc->left_class_mapping)
-                        lv_mem_free((void *)kern_dsc->left_class_mapping);
-
-                    if(kern_dsc->right_class_mapping)
-                        lv_mem_free((void *)kern_dsc->right_class_mapping);
-
+                    free_data(ldsc, kern_dsc->class_pair_values);
+                    free_data(ldsc, kern_dsc->left_class_mapping);
+                    free_data(ldsc, kern_dsc->right_class_mapping);
                     lv_mem_free((void *)kern_dsc);
                 }
             }
@@ -158,21 +176,22 @@ void lv_font_free(lv_font_t * font)
 
             if(NULL != cmaps) {
                 for(int i = 0; i < dsc->cmap_num; ++i) {
-                    if(NULL != cmaps[i].glyph_id_ofs_list)
-                        lv_mem_free((void *)cmaps[i].glyph_id_ofs_list);
-                    if(NULL != cmaps[i].unicode_list)
-                        lv_mem_free((void *)cmaps[i].unicode_list);
+                    free_data(ldsc, cmaps[i].glyph_id_ofs_list);
+                    free_data(ldsc, cmaps[i].unicode_list);
                 }
                 lv_mem_free(cmaps);
             }
 
-            if(NULL != dsc->glyph_bitmap) {
-                lv_mem_free((void *)dsc->glyph_bitmap);
-            }
+            free_data(ldsc, dsc->glyph_bitmap);
             if(NULL != dsc->glyph_dsc) {
                 lv_mem_free((void *)dsc->glyph_dsc);
             }
-            lv_mem_free(dsc);
+
+            /*Close the mapped file only after the font doesn't use it*/
+            if(NULL != ldsc->file.drv) {
+                lv_fs_close(&ldsc->file);
+            }
+            lv_mem_free(ldsc);
         }
         lv_mem_free(font);
     }
@@ -200,10 +219,15 @@ static unsigned int read_bits(bit_iterator_t * it, int n_bits, lv_fs_res_t * res
 
         if(it->bit_pos < 0) {
             it->bit_pos = 7;
-            *res = lv_fs_read(it->fp, &(it->byte_value), 1, NULL);
+            uint32_t br;
+            *res = lv_fs_read(it->fp, &(it->byte_value), 1, &br);
             if(*res != LV_FS_RES_OK) {
                 return 0;
             }
+            if(br != 1) {
+                *res = LV_FS_RES_UNKNOWN;   /*End of the file*/
+                return 0;
+            }
         }
         int8_t bit = (it->byte_value & 0x80) ? 1 : 0;
 
@@ -228,9 +252,12 @@ static int read_label(lv_fs_file_t * fp, int start, const char * label)
 
     uint32_t length;
     char buf[4];
+    uint32_t br1 = 0;
+    uint32_t br2 = 0;
 
-    if(lv_fs_read(fp, &length, 4, NULL) != LV_FS_RES_OK
-       || lv_fs_read(fp, buf, 4, NULL) != LV_FS_RES_OK
+    if(lv_fs_read(fp, &length, 4, &br1) != LV_FS_RES_OK
+       || lv_fs_read(fp, buf, 4, &br2) != LV_FS_RES_OK
+       || br1 != 4 || br2 != 4
        || memcmp(label, buf, 4) != 0) {
         LV_LOG_WARN("Error reading '%s' label.", label);
         return -1;
@@ -261,12 +288,10 @@ static bool load_cmaps_tables(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_ds
 
         switch(cmap_table[i].format_type) {
             case LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL: {
-                    uint8_t ids_size = sizeof(uint8_t) * cmap_table[i].data_entries_count;
-                    uint8_t * glyph_id_ofs_list = lv_mem_alloc(ids_size);
-
-                    cmap->glyph_id_ofs_list = glyph_id_ofs_list;
+                    uint32_t ids_size = sizeof(uint8_t) * cmap_table[i].data_entries_count;
 
-                    if(lv_fs_read(fp, glyph_id_ofs_list, ids_size, NULL) != LV_FS_RES_OK) {
+                    cmap->glyph_id_ofs_list = load_data(fp, ids_size, sizeof(uint8_t));
+                    if(cmap->glyph_id_ofs_list == NULL) {
                         return false;
                     }
 
@@ -278,21 +303,16 @@ static bool load_cmaps_tables(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_ds
             case LV_FONT_FMT_TXT_CMAP_SPARSE_FULL:
             case LV_FONT_FMT_TXT_CMAP_SPARSE_TINY: {
                     uint32_t list_size = sizeof(uint16_t) * cmap_table[i].data_entries_count;
-                    uint16_t * unicode_list = (uint16_t *)lv_mem_alloc(list_size);
 
-                    cmap->unicode_list = unicode_list;
                     cmap->list_length = cmap_table[i].data_entries_count;
-
-                    if(lv_fs_read(fp, unicode_list, list_size, NULL) != LV_FS_RES_OK) {
+                    cmap->unicode_list = load_data(fp, list_size, sizeof(uint16_t));
+                    if(cmap->unicode_list == NULL) {
                         return false;
                     }
 
                     if(cmap_table[i].format_type == LV_FONT_FMT_TXT_CMAP_SPARSE_FULL) {
-                        uint16_t * buf = lv_mem_alloc(sizeof(uint16_t) * cmap->list_length);
-
-                        cmap->glyph_id_ofs_list = buf;
-
-                        if(lv_fs_read(fp, buf, sizeof(uint16_t) * cmap->list_length, NULL) != LV_FS_RES_OK) {
+                        cmap->glyph_id_ofs_list = load_data(fp, list_size, sizeof(uint16_t));
+                        if(cmap->glyph_id_ofs_list == NULL) {
                             return false;
                         }
                     }
@@ -335,9 +355,12 @@ static int32_t load_cmaps(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc, u
     return success ? cmaps_length : -1;
 }
 
-static int32_t load_glyph(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc,
+static int32_t load_glyph(lv_fs_file_t * fp, lv_font_t * font,
                           uint32_t start, uint32_t * glyph_offset, uint32_t loca_count, font_header_bin_t * header)
 {
+    font_loader_dsc_t * ldsc = (font_loader_dsc_t *)font->dsc;
+    lv_font_fmt_txt_dsc_t * font_dsc = &ldsc->dsc;
+
     int32_t glyph_length = read_label(fp, start, "glyf");
     if(glyph_length < 0) {
         return -1;
@@ -351,6 +374,7 @@ static int32_t load_glyph(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc,
     font_dsc->glyph_dsc = glyph_dsc;
 
     int cur_bmp_size = 0;
+    int max_bmp_size = 0;
 
     for(unsigned int i = 0; i < loca_count; ++i) {
         lv_font_fmt_txt_glyph_dsc_t * gdsc = &glyph_dsc[i];
@@ -410,10 +434,47 @@ static int32_t load_glyph(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc,
 
         gdsc->bitmap_index = cur_bmp_size;
         if(gdsc->box_w * gdsc->box_h != 0) {
+            if(bmp_size <= 0 || next_offset > glyph_length) {
+                LV_LOG_WARN("Invalid offset of glyph %d.", (int)i);
+                return -1;
+            }
             cur_bmp_size += bmp_size;
+            max_bmp_size = LV_MAX(bmp_size, max_bmp_size);
         }
     }
 
+    if(ldsc->mapped) {
+        if(ldsc->loca == NULL || start + glyph_length > ldsc->mapped_size) {
+            LV_LOG_WARN("The glyphs are out of the file.");
+            return -1;
+        }
+
+        int nbits = header->advance_width_bits + 2 * header->xy_bits + 2 * header->wh_bits;
+        ldsc->glyf = ldsc->mapped + start;
+        ldsc->glyf_length = glyph_length;
+
+        if(nbits % 8 == 0 && (LV_FONT_FMT_TXT_LARGE || glyph_length < (1 << 20))) {
+            /*The bitmaps are byte aligned, use them from the file*/
+            font_dsc->glyph_bitmap = ldsc->glyf;
+            for(unsigned int i = 1; i < loca_count; ++i) {
+                glyph_dsc[i].bitmap_index = glyph_offset[i] + nbits / 8;
+            }
+        }
+        else {
+            /*Shift the bitmaps to a buffer when they are drawn*/
+            font_dsc->glyph_bitmap = lv_mem_alloc(LV_MAX(max_bmp_size, 1));
+            if(font_dsc->glyph_bitmap == NULL) {
+                return -1;
+            }
+            for(unsigned int i = 0; i < loca_count; ++i) {
+                glyph_dsc[i].bitmap_index = 0;
+            }
+            ldsc->header_bits = nbits;
+            font->get_glyph_bitmap = get_glyph_bitmap_mapped;
+        }
+        return glyph_length;
+    }
+
     uint8_t * glyph_bmp = (uint8_t *)lv_mem_alloc(sizeof(uint8_t) * cur_bmp_size);
 
     font_dsc->glyph_bitmap = glyph_bmp;
@@ -442,7 +503,8 @@ static int32_t load_glyph(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc,
         int bmp_size = next_offset - glyph_offset[i] - nbits / 8;
 
         if(nbits % 8 == 0) {  /*Fast path*/
-            if(lv_fs_read(fp, &glyph_bmp[cur_bmp_size], bmp_size, NULL) != LV_FS_RES_OK) {
+            uint32_t br;
+            if(lv_fs_read(fp, &glyph_bmp[cur_bmp_size], bmp_size, &br) != LV_FS_RES_OK || br != (uint32_t)bmp_size) {
                 return -1;
             }
         }
@@ -482,12 +544,19 @@ static int32_t load_glyph(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc,
  */
 static bool lvgl_load_font(lv_fs_file_t * fp, lv_font_t * font)
 {
-    lv_font_fmt_txt_dsc_t * font_dsc = (lv_font_fmt_txt_dsc_t *)
-                                       lv_mem_alloc(sizeof(lv_font_fmt_txt_dsc_t));
+    font_loader_dsc_t * ldsc = (font_loader_dsc_t *)lv_mem_alloc(sizeof(font_loader_dsc_t));
+    LV_ASSERT_MALLOC(ldsc);
+    if(ldsc == NULL) {
+        return false;
+    }
 
-    memset(font_dsc, 0, sizeof(lv_font_fmt_txt_dsc_t));
+    memset(ldsc, 0, sizeof(font_loader_dsc_t));
 
-    font->dsc = font_dsc;
+    font->dsc = ldsc;
+
+    lv_font_fmt_txt_dsc_t * font_dsc = &ldsc->dsc;
+    font_dsc->cache = &ldsc->cache;
+    ldsc->mapped = lv_fs_get_mapped(fp, &ldsc->mapped_size);
 
     /*header*/
     int32_t header_length = read_label(fp, 0, "head");
@@ -559,10 +628,20 @@ static bool lvgl_load_font(lv_fs_file_t * fp, lv_font_t * font)
         return false;
     }
 
+    /*The glyphs' offsets are read from the mapped file when the bitmaps are drawn*/
+    uint32_t loca_data_start = loca_start + 12;
+    uint32_t loca_entry_size = font_header.index_to_loc_format == 0 ? sizeof(uint16_t) : sizeof(uint32_t);
+    if(ldsc->mapped && loca_data_start <= ldsc->mapped_size &&
+       loca_count <= (ldsc->mapped_size - loca_data_start) / loca_entry_size) {
+        ldsc->loca = ldsc->mapped + loca_data_start;
+        ldsc->loca_count = loca_count;
+        ldsc->loca_format = font_header.index_to_loc_format;
+    }
+
     /*glyph*/
     uint32_t glyph_start = loca_start + loca_length;
     int32_t glyph_length = load_glyph(
-                               fp, font_dsc, glyph_start, glyph_offset, loca_count, &font_header);
+                               fp, font, glyph_start, glyph_offset, loca_count, &font_header);
 
     lv_mem_free(glyph_offset);
 
@@ -619,19 +698,16 @@ int32_t load_kern(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc, uint8_t f
             ids_size = sizeof(int16_t) * 2 * glyph_entries;
         }
 
-        uint8_t * glyph_ids = lv_mem_alloc(ids_size);
-        int8_t * values = lv_mem_alloc(glyph_entries);
-
         kern_pair->glyph_ids_size = format;
         kern_pair->pair_cnt = glyph_entries;
-        kern_pair->glyph_ids = glyph_ids;
-        kern_pair->values = values;
 
-        if(lv_fs_read(fp, glyph_ids, ids_size, NULL) != LV_FS_RES_OK) {
+        kern_pair->glyph_ids = load_data(fp, ids_size, format == 0 ? sizeof(int8_t) : sizeof(int16_t));
+        if(kern_pair->glyph_ids == NULL) {
             return -1;
         }
 
-        if(lv_fs_read(fp, values, glyph_entries, NULL) != LV_FS_RES_OK) {
+        kern_pair->values = load_data(fp, glyph_entries, sizeof(int8_t));
+        if(kern_pair->values == NULL) {
             return -1;
         }
     }
@@ -656,19 +732,21 @@ int32_t load_kern(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc, uint8_t f
 
         int kern_values_length = sizeof(int8_t) * kern_table_rows * kern_table_cols;
 
-        uint8_t * kern_left = lv_mem_alloc(kern_class_mapping_length);
-        uint8_t * kern_right = lv_mem_alloc(kern_class_mapping_length);
-        int8_t * kern_values = lv_mem_alloc(kern_values_length);
-
-        kern_classes->left_class_mapping  = kern_left;
-        kern_classes->right_class_mapping = kern_right;
         kern_classes->left_class_cnt = kern_table_rows;
         kern_classes->right_class_cnt = kern_table_cols;
-        kern_classes->class_pair_values = kern_values;
 
-        if(lv_fs_read(fp, kern_left, kern_class_mapping_length, NULL) != LV_FS_RES_OK ||
-           lv_fs_read(fp, kern_right, kern_class_mapping_length, NULL) != LV_FS_RES_OK ||
-           lv_fs_read(fp, kern_values, kern_values_length, NULL) != LV_FS_RES_OK) {
+        kern_classes->left_class_mapping = load_data(fp, kern_class_mapping_length, sizeof(uint8_t));
+        if(kern_classes->left_class_mapping == NULL) {
+            return -1;
+        }
+
+        kern_classes->right_class_mapping = load_data(fp, kern_class_mapping_length, sizeof(uint8_t));
+        if(kern_classes->right_class_mapping == NULL) {
+            return -1;
+        }
+
+        kern_classes->class_pair_values = load_data(fp, kern_values_length, sizeof(int8_t));
+        if(kern_classes->class_pair_values == NULL) {
             return -1;
         }
     }
@@ -679,3 +757,101 @@ int32_t load_kern(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc, uint8_t f
 
     return kern_length;
 }
+
+/**
+ * Load the next `size` bytes of the file.
+ * The data of the mapped files is not copied if it's aligned.
+ * @param fp        pointer to the font file
+ * @param size      number of bytes to load
+ * @param align     the required alignment of the data
+ * @return          pointer to the data or NULL on error. Free it with `free_data()`.
+ */
+static const void * load_data(lv_fs_file_t * fp, uint32_t size, uint32_t align)
+{
+    uint32_t mapped_size;
+    const uint8_t * mapped = lv_fs_get_mapped(fp, &mapped_size);
+    if(mapped) {
+        uint32_t pos;
+        if(lv_fs_tell(fp, &pos) != LV_FS_RES_OK || pos > mapped_size || size > mapped_size - pos) {
+            return NULL;
+        }
+
+        if(((lv_uintptr_t)(mapped + pos) & (align - 1)) == 0) {
+            lv_fs_seek(fp, pos + size, LV_FS_SEEK_SET);
+            return mapped + pos;
+        }
+    }
+
+    uint8_t * buf = lv_mem_alloc(size);
+    LV_ASSERT_MALLOC(buf);
+    if(buf == NULL) {
+        return NULL;
+    }
+
+    uint32_t br;
+    if(lv_fs_read(fp, buf, size, &br) != LV_FS_RES_OK || br != size) {
+        lv_mem_free(buf);
+        return NULL;
+    }
+
+    return buf;
+}
+
+static void free_data(font_loader_dsc_t * ldsc, const void * data)
+{
+    const uint8_t * p = data;
+    if(p == NULL) return;
+
+    /*Points into the mapped file*/
+    if(ldsc->mapped && p >= ldsc->mapped && p <= ldsc->mapped + ldsc->mapped_size) return;
+
+    lv_mem_free((void *)data);
+}
+
+static uint32_t get_glyph_offset(const font_loader_dsc_t * ldsc, uint32_t gid)
+{
+    if(gid >= ldsc->loca_count) return ldsc->glyf_length;
+
+    if(ldsc->loca_format == 0) {
+        uint16_t offset;
+        lv_memcpy(&offset, ldsc->loca + gid * sizeof(uint16_t), sizeof(uint16_t));
+        return offset;
+    }
+    else {
+        uint32_t offset;
+        lv_memcpy(&offset, ldsc->loca + gid * sizeof(uint32_t), sizeof(uint32_t));
+        return offset;
+    }
+}
+
+/**
+ * Get the bitmap of a glyph of a font loaded from a mapped file.
+ * The bitmap starts after the glyph's header bits so it's shifted to `glyph_bitmap` first.
+ */
+static const uint8_t * get_glyph_bitmap_mapped(const lv_font_t * font, uint32_t letter)
+{
+    font_loader_dsc_t * ldsc = (font_loader_dsc_t *)font->dsc;
+
+    /*It also caches the ID of the glyph*/
+    lv_font_glyph_dsc_t g;
+    if(!lv_font_get_glyph_dsc_fmt_txt(font, &g, letter, 0)) return NULL;
+
+    uint32_t gid = ldsc->cache.last_glyph_id;
+    const lv_font_fmt_txt_glyph_dsc_t * gdsc = &ldsc->dsc.glyph_dsc[gid];
+    if(gdsc->box_w * gdsc->box_h != 0) {
+        /*The offsets were checked when the font was loaded*/
+        uint32_t start = get_glyph_offset(ldsc, gid) + ldsc->header_bits / 8;
+        uint32_t size = get_glyph_offset(ldsc, gid + 1) - start;
+        const uint8_t * src = ldsc->glyf + start;
+        uint8_t * dst = (uint8_t *)ldsc->dsc.glyph_bitmap;
+        uint8_t shift = ldsc->header_bits % 8;
+
+        uint32_t i;
+        for(i = 0; i < size - 1; i++) {
+            dst[i] = (uint8_t)((src[i] << shift) | (src[i + 1] >> (8 - shift)));
+        }
+        dst[size - 1] = (uint8_t)(src[size - 1] << shift);
+    }
+
+    return lv_font_get_bitmap_fmt_txt(font, letter);
+}
@@ -796,6 +796,62 @@
     #endif
 #endif
 
+/*1: Keep a grid of the children's coordinates in objects with many children.
+ *It speeds up finding the clicked object and the top object to redraw on crowded screens*/
+#ifndef LV_USE_OBJ_SPATIAL_INDEX
+    #ifdef CONFIG_LV_USE_OBJ_SPATIAL_INDEX
+        #define LV_USE_OBJ_SPATIAL_INDEX CONFIG_LV_USE_OBJ_SPATIAL_INDEX
+    #else
+        #define LV_USE_OBJ_SPATIAL_INDEX 0
+    #endif
+#endif
+#if LV_USE_OBJ_SPATIAL_INDEX
+    /*Index the children only if an object has at least this many of them*/
+    #ifndef LV_OBJ_SPATIAL_INDEX_MIN_CHILDREN
+        #ifdef CONFIG_LV_OBJ_SPATIAL_INDEX_MIN_CHILDREN
+            #define LV_OBJ_SPATIAL_INDEX_MIN_CHILDREN CONFIG_LV_OBJ_SPATIAL_INDEX_MIN_CHILDREN
+        #else
+            #define LV_OBJ_SPATIAL_INDEX_MIN_CHILDREN 16
+        #endif
+    #endif
+#endif
+
+/*Number of children stored in the object itself before allocating an array for them.
+ *Saves an allocation for objects with only a few children*/
+#ifndef LV_OBJ_CHILD_INLINE_CNT
+    #ifdef CONFIG_LV_OBJ_CHILD_INLINE_CNT
+        #define LV_OBJ_CHILD_INLINE_CNT CONFIG_LV_OBJ_CHILD_INLINE_CNT
+    #else
+        #define LV_OBJ_CHILD_INLINE_CNT 0
+    #endif
+#endif
+
+/*>0: Cache the files of the drivers with `cache_size > 0` in blocks shared by all open files
+ *instead of a single `cache_size` buffer for each file. The size of the cache in bytes*/
+#ifndef LV_FS_CACHE_SIZE
+    #ifdef CONFIG_LV_FS_CACHE_SIZE
+        #define LV_FS_CACHE_SIZE CONFIG_LV_FS_CACHE_SIZE
+    #else
+        #define LV_FS_CACHE_SIZE 0
+    #endif
+#endif
+#if LV_FS_CACHE_SIZE
+    #ifndef LV_FS_CACHE_BLOCK_SIZE
+        #ifdef CONFIG_LV_FS_CACHE_BLOCK_SIZE
+            #define LV_FS_CACHE_BLOCK_SIZE CONFIG_LV_FS_CACHE_BLOCK_SIZE
+        #else
+            #define LV_FS_CACHE_BLOCK_SIZE 1024 /*Size of a block in bytes*/
+        #endif
+    #endif
+    #ifndef LV_FS_CACHE_READ_AHEAD
+        #ifdef CONFIG_LV_FS_CACHE_READ_AHEAD
+            #define LV_FS_CACHE_READ_AHEAD CONFIG_LV_FS_CACHE_READ_AHEAD
+        #else
+            #define LV_FS_CACHE_READ_AHEAD 4    /*Number of blocks to read at once if a file is read sequentially*/
+        #endif
+    #endif
+#endif
+
 /*Change the built in (v)snprintf functions*/
 #ifndef LV_SPRINTF_CUSTOM
     #ifdef CONFIG_LV_SPRINTF_CUSTOM
@@ -2040,6 +2096,13 @@
             #define LV_FS_POSIX_CACHE_SIZE 0    /*>0 to cache this number of bytes in lv_fs_read()*/
         #endif
     #endif
+    #ifndef LV_FS_POSIX_MMAP
+        #ifdef CONFIG_LV_FS_POSIX_MMAP
+            #define LV_FS_POSIX_MMAP CONFIG_LV_FS_POSIX_MMAP
+        #else
+            #define LV_FS_POSIX_MMAP 0          /*1: Map the files opened for reading into memory with mmap() and read them without copying*/
+        #endif
+    #endif
 #endif
 
 /*API for CreateFile, ReadFile, etc*/
@@ -2132,6 +2195,17 @@
         #define LV_USE_PNG 0
     #endif
 #endif
+#if LV_USE_PNG
+    /*Decode non-interlaced images line by line with max. 32 kB + 2 lines of RAM instead of the whole image.
+     *Such images can't be rotated or zoomed.*/
+    #ifndef LV_PNG_STREAM
+        #ifdef CONFIG_LV_PNG_STREAM
+            #define LV_PNG_STREAM CONFIG_LV_PNG_STREAM
+        #else
+            #define LV_PNG_STREAM 0
+        #endif
+    #endif
+#endif
 
 /*BMP decoder library*/
 #ifndef LV_USE_BMP
@@ -2142,6 +2216,15 @@
     #endif
 #endif
 
+/*Decoder of RLE compressed C array images (see scripts/img_to_rle.py)*/
+#ifndef LV_USE_RLE
+    #ifdef CONFIG_LV_USE_RLE
+        #define LV_USE_RLE CONFIG_LV_USE_RLE
+    #else
+        #define LV_USE_RLE 0
+    #endif
+#endif
+
 /* JPG + split JPG decoder library.
  * Split JPG is a custom format optimized for embedded systems. */
 #ifndef LV_USE_SJPG
@@ -2151,6 +2234,33 @@
         #define LV_USE_SJPG 0
     #endif
 #endif
+#if LV_USE_SJPG
+    /*Memory for the decoded fragments shared by all JPG and SJPG images [bytes].
+     *The least recently used fragments are freed when it's full. 0: keep only the last fragment of each opened image*/
+    #ifndef LV_SJPG_CACHE_SIZE
+        #ifdef CONFIG_LV_SJPG_CACHE_SIZE
+            #define LV_SJPG_CACHE_SIZE CONFIG_LV_SJPG_CACHE_SIZE
+        #else
+            #define LV_SJPG_CACHE_SIZE 0
+        #endif
+    #endif
+    /*1: decode the next fragment of SJPG images when LVGL is idle if the cache has free memory*/
+    #ifndef LV_SJPG_PREFETCH
+        #ifdef CONFIG_LV_SJPG_PREFETCH
+            #define LV_SJPG_PREFETCH CONFIG_LV_SJPG_PREFETCH
+        #else
+            #define LV_SJPG_PREFETCH 0
+        #endif
+    #endif
+    /*0: basic decoder for 8/16-bit MCUs; 1: use 32-bit shifts; 2: + table based Huffman decoding (+6 kB RAM)*/
+    #ifndef LV_SJPG_FAST_DECODE
+        #ifdef CONFIG_LV_SJPG_FAST_DECODE
+            #define LV_SJPG_FAST_DECODE CONFIG_LV_SJPG_FAST_DECODE
+        #else
+            #define LV_SJPG_FAST_DECODE 0
+        #endif
+    #endif
+#endif
 
 /*GIF decoder library*/
 #ifndef LV_USE_GIF
@@ -2234,6 +2344,23 @@
             #define LV_TINY_TTF_FILE_SUPPORT 0
         #endif
     #endif
+    /*Memory for the glyph atlas shared by all fonts and sizes [bytes].
+     *It caches the bitmaps, metrics and kerning of the glyphs. 0: each font has its own bitmap cache*/
+    #ifndef LV_TINY_TTF_ATLAS_SIZE
+        #ifdef CONFIG_LV_TINY_TTF_ATLAS_SIZE
+            #define LV_TINY_TTF_ATLAS_SIZE CONFIG_LV_TINY_TTF_ATLAS_SIZE
+        #else
+            #define LV_TINY_TTF_ATLAS_SIZE 0
+        #endif
+    #endif
+    /*The atlas is split into pages of this size [bytes]. The least recently used page is evicted when it's full*/
+    #ifndef LV_TINY_TTF_ATLAS_PAGE_SIZE
+        #ifdef CONFIG_LV_TINY_TTF_ATLAS_PAGE_SIZE
+            #define LV_TINY_TTF_ATLAS_PAGE_SIZE CONFIG_LV_TINY_TTF_ATLAS_PAGE_SIZE
+        #else
+            #define LV_TINY_TTF_ATLAS_PAGE_SIZE 8192
+        #endif
+    #endif
 #endif
 
 /*Rlottie library*/
@@ -2296,6 +2423,15 @@
     #endif
 #endif
 
+/*1: Enable moving between screens by dragging them with a pointer*/
+#ifndef LV_USE_PAGER
+    #ifdef CONFIG_LV_USE_PAGER
+        #define LV_USE_PAGER CONFIG_LV_USE_PAGER
+    #else
+        #define LV_USE_PAGER 0
+    #endif
+#endif
+
 /*1: Enable lv_obj fragment*/
 #ifndef LV_USE_FRAGMENT
     #ifdef CONFIG_LV_USE_FRAGMENT
@@ -20,10 +20,15 @@
  *********************/
 #define LV_ANIM_RESOLUTION 1024
 #define LV_ANIM_RES_SHIFT 10
+#define ANIM_CHUNK_ITEM_CNT 8
 
 /**********************
  *      TYPEDEFS
  **********************/
+typedef struct {
+    lv_anim_t anim;         /*Must be the first to use the items as animations*/
+    lv_ilist_node_t node;
+} anim_item_t;
 
 /**********************
  *  STATIC PROTOTYPES
@@ -56,7 +61,7 @@ static lv_timer_t * _lv_anim_tmr;
 
 void _lv_anim_core_init(void)
 {
-    _lv_ll_init(&LV_GC_ROOT(_lv_anim_ll), sizeof(lv_anim_t));
+    _lv_ilist_init(&LV_GC_ROOT(_lv_anim_ll), sizeof(anim_item_t), offsetof(anim_item_t, node), ANIM_CHUNK_ITEM_CNT);
     _lv_anim_tmr = lv_timer_create(anim_timer, LV_DISP_DEF_REFR_PERIOD, NULL);
     anim_mark_list_change(); /*Turn off the animation timer*/
     anim_list_changed = false;
@@ -81,14 +86,15 @@ lv_anim_t * lv_anim_start(const lv_anim_t * a)
     if(a->exec_cb != NULL) lv_anim_del(a->var, a->exec_cb); /*exec_cb == NULL would delete all animations of var*/
 
     /*If the list is empty the anim timer was suspended and it's last run measure is invalid*/
-    if(_lv_ll_is_empty(&LV_GC_ROOT(_lv_anim_ll))) {
+    if(_lv_ilist_is_empty(&LV_GC_ROOT(_lv_anim_ll))) {
         last_timer_run = lv_tick_get();
     }
 
     /*Add the new animation to the animation linked list*/
-    lv_anim_t * new_anim = _lv_ll_ins_head(&LV_GC_ROOT(_lv_anim_ll));
+    lv_anim_t * new_anim = _lv_ilist_alloc(&LV_GC_ROOT(_lv_anim_ll));
     LV_ASSERT_MALLOC(new_anim);
     if(new_anim == NULL) return NULL;
+    _lv_ilist_ins_head(&LV_GC_ROOT(_lv_anim_ll), new_anim);
 
     /*Initialize the animation descriptor*/
     lv_memcpy(new_anim, a, sizeof(lv_anim_t));
@@ -140,15 +146,15 @@ bool lv_anim_del(void * var, lv_anim_exec_xcb_t exec_cb)
     lv_anim_t * a;
     lv_anim_t * a_next;
     bool del = false;
-    a        = _lv_ll_get_head(&LV_GC_ROOT(_lv_anim_ll));
+    a        = _lv_ilist_get_head(&LV_GC_ROOT(_lv_anim_ll));
     while(a != NULL) {
         /*'a' might be deleted, so get the next object while 'a' is valid*/
-        a_next = _lv_ll_get_next(&LV_GC_ROOT(_lv_anim_ll), a);
+        a_next = _lv_ilist_get_next(&LV_GC_ROOT(_lv_anim_ll), a);
 
         if((a->var == var || var == NULL) && (a->exec_cb == exec_cb || exec_cb == NULL)) {
-            _lv_ll_remove(&LV_GC_ROOT(_lv_anim_ll), a);
+            _lv_ilist_remove(&LV_GC_ROOT(_lv_anim_ll), a);
             if(a->deleted_cb != NULL) a->deleted_cb(a);
-            lv_mem_free(a);
+            _lv_ilist_free(&LV_GC_ROOT(_lv_anim_ll), a);
             anim_mark_list_change(); /*Read by `anim_timer`. It need to know if a delete occurred in
                                        the linked list*/
             del = true;
@@ -162,14 +168,14 @@ bool lv_anim_del(void * var, lv_anim_exec_xcb_t exec_cb)
 
 void lv_anim_del_all(void)
 {
-    _lv_ll_clear(&LV_GC_ROOT(_lv_anim_ll));
+    _lv_ilist_clear(&LV_GC_ROOT(_lv_anim_ll));
     anim_mark_list_change();
 }
 
 lv_anim_t * lv_anim_get(void * var, lv_anim_exec_xcb_t exec_cb)
 {
     lv_anim_t * a;
-    _LV_LL_READ(&LV_GC_ROOT(_lv_anim_ll), a) {
+    _LV_ILIST_READ(&LV_GC_ROOT(_lv_anim_ll), a) {
         if(a->var == var && (a->exec_cb == exec_cb || exec_cb == NULL)) {
             return a;
         }
@@ -187,7 +193,7 @@ uint16_t lv_anim_count_running(void)
 {
     uint16_t cnt = 0;
     lv_anim_t * a;
-    _LV_LL_READ(&LV_GC_ROOT(_lv_anim_ll), a) cnt++;
+    _LV_ILIST_READ(&LV_GC_ROOT(_lv_anim_ll), a) cnt++;
 
     return cnt;
 }
@@ -356,7 +362,7 @@ static void anim_timer(lv_timer_t * param)
     /*Flip the run round*/
     anim_run_round = anim_run_round ? false : true;
 
-    lv_anim_t * a = _lv_ll_get_head(&LV_GC_ROOT(_lv_anim_ll));
+    lv_anim_t * a = _lv_ilist_get_head(&LV_GC_ROOT(_lv_anim_ll));
 
     while(a != NULL) {
         /*It can be set by `lv_anim_del()` typically in `end_cb`. If set then an animation delete
@@ -402,9 +408,9 @@ static void anim_timer(lv_timer_t * param)
         /*If the linked list changed due to anim. delete then it's not safe to continue
          *the reading of the list from here -> start from the head*/
         if(anim_list_changed)
-            a = _lv_ll_get_head(&LV_GC_ROOT(_lv_anim_ll));
+            a = _lv_ilist_get_head(&LV_GC_ROOT(_lv_anim_ll));
         else
-            a = _lv_ll_get_next(&LV_GC_ROOT(_lv_anim_ll), a);
+            a = _lv_ilist_get_next(&LV_GC_ROOT(_lv_anim_ll), a);
     }
 
     last_timer_run = lv_tick_get();
@@ -429,14 +435,14 @@ static void anim_ready_handler(lv_anim_t * a)
 
         /*Delete the animation from the list.
          * This way the `ready_cb` will see the animations like it's animation is ready deleted*/
-        _lv_ll_remove(&LV_GC_ROOT(_lv_anim_ll), a);
+        _lv_ilist_remove(&LV_GC_ROOT(_lv_anim_ll), a);
         /*Flag that the list has changed*/
         anim_mark_list_change();
 
         /*Call the callback function at the end*/
         if(a->ready_cb != NULL) a->ready_cb(a);
         if(a->deleted_cb != NULL) a->deleted_cb(a);
-        lv_mem_free(a);
+        _lv_ilist_free(&LV_GC_ROOT(_lv_anim_ll), a);
     }
     /*If the animation is not deleted then restart it*/
     else {
@@ -463,7 +469,7 @@ static void anim_ready_handler(lv_anim_t * a)
 static void anim_mark_list_change(void)
 {
     anim_list_changed = true;
-    if(_lv_ll_get_head(&LV_GC_ROOT(_lv_anim_ll)) == NULL)
+    if(_lv_ilist_is_empty(&LV_GC_ROOT(_lv_anim_ll)))
         lv_timer_pause(_lv_anim_tmr);
     else
         lv_timer_resume(_lv_anim_tmr);
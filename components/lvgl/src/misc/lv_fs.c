@@ -16,19 +16,56 @@
 /*********************
  *      DEFINES
  *********************/
+#if LV_FS_CACHE_SIZE
+    #define CACHE_BLOCK_CNT (LV_FS_CACHE_SIZE / LV_FS_CACHE_BLOCK_SIZE)
+    #if CACHE_BLOCK_CNT < 2
+        #error "LV_FS_CACHE_SIZE should be at least 2 x LV_FS_CACHE_BLOCK_SIZE"
+    #endif
+    /*Leave enough blocks for the other files*/
+    #define CACHE_READ_AHEAD LV_MAX(LV_MIN(LV_FS_CACHE_READ_AHEAD, CACHE_BLOCK_CNT / 2), 1)
+#endif
 
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_FS_CACHE_SIZE
+/*A file with blocks in the shared cache. Kept while it's open or has blocks.*/
+typedef struct _lv_fs_cache_file_t {
+    struct _lv_fs_cache_file_t * next;
+    uint16_t open_cnt;
+    uint16_t block_cnt;
+    char path[];
+} lv_fs_cache_file_t;
+
+typedef struct {
+    lv_fs_cache_file_t * file;  /*NULL if unused*/
+    uint32_t index;             /*Index of the block in the file*/
+    uint32_t size;              /*Less than the block size at the end of the file*/
+    uint32_t life;              /*The last use, to find the least recently used block*/
+} lv_fs_cache_block_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static const char * lv_fs_get_real_path(const char * path);
+#if LV_FS_CACHE_SIZE
+    static lv_fs_cache_file_t * cache_file_open(const char * path);
+    static void cache_file_close(lv_fs_cache_file_t * file);
+    static void cache_drop_blocks(lv_fs_cache_file_t * file);
+    static lv_fs_res_t lv_fs_read_blocks(lv_fs_file_t * file_p, uint8_t * buf, uint32_t btr, uint32_t * br);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static lv_fs_cache_stat_t cache_stat;
+#if LV_FS_CACHE_SIZE
+    static lv_fs_cache_file_t * cache_files;
+    static lv_fs_cache_block_t cache_blocks[CACHE_BLOCK_CNT];
+    static uint8_t * cache_buf;
+    static uint32_t cache_life;
+#endif
 
 /**********************
  *      MACROS
@@ -41,6 +78,11 @@ static const char * lv_fs_get_real_path(const char * path);
 void _lv_fs_init(void)
 {
     _lv_ll_init(&LV_GC_ROOT(_lv_fsdrv_ll), sizeof(lv_fs_drv_t *));
+#if LV_FS_CACHE_SIZE
+    cache_files = NULL;
+    lv_memset_00(cache_blocks, sizeof(cache_blocks));
+    cache_buf = NULL;
+#endif
 }
 
 bool lv_fs_is_ready(char letter)
@@ -90,13 +132,41 @@ lv_fs_res_t lv_fs_open(lv_fs_file_t * file_p, const char * path, lv_fs_mode_t mo
 
     file_p->drv = drv;
     file_p->file_d = file_d;
+    file_p->cache = NULL;
 
-    if(drv->cache_size) {
+    /*Reading a mapped file is only a copy, it needs no cache*/
+    const void * mapped = NULL;
+    uint32_t mapped_size = 0;
+    if(mode == LV_FS_MODE_RD && drv->mmap_cb) {
+        mapped = drv->mmap_cb(drv, file_d, &mapped_size);
+    }
+
+    if(drv->cache_size || mapped) {
         file_p->cache = lv_mem_alloc(sizeof(lv_fs_file_cache_t));
         LV_ASSERT_MALLOC(file_p->cache);
+        if(file_p->cache == NULL) {
+            if(mapped && drv->munmap_cb) drv->munmap_cb(drv, file_d, mapped, mapped_size);
+            drv->close_cb(drv, file_d);
+            return LV_FS_RES_OUT_OF_MEM;
+        }
         lv_memset_00(file_p->cache, sizeof(lv_fs_file_cache_t));
         file_p->cache->start = UINT32_MAX;  /*Set an invalid range by default*/
         file_p->cache->end = UINT32_MAX - 1;
+        file_p->cache->mapped = mapped;
+        file_p->cache->mapped_size = mapped_size;
+
+#if LV_FS_CACHE_SIZE
+        if(mapped == NULL) {
+            file_p->cache->file = cache_file_open(path);
+            if(file_p->cache->file == NULL) {
+                lv_mem_free(file_p->cache);
+                file_p->cache = NULL;
+                drv->close_cb(drv, file_d);
+                return LV_FS_RES_OUT_OF_MEM;
+            }
+            file_p->cache->last_block = UINT32_MAX; /*Reading the first block is sequential*/
+        }
+#endif
     }
 
     return LV_FS_RES_OK;
@@ -112,13 +182,21 @@ lv_fs_res_t lv_fs_close(lv_fs_file_t * file_p)
         return LV_FS_RES_NOT_IMP;
     }
 
+    if(file_p->cache && file_p->cache->mapped && file_p->drv->munmap_cb) {
+        file_p->drv->munmap_cb(file_p->drv, file_p->file_d, file_p->cache->mapped, file_p->cache->mapped_size);
+    }
+
     lv_fs_res_t res = file_p->drv->close_cb(file_p->drv, file_p->file_d);
 
-    if(file_p->drv->cache_size && file_p->cache) {
+    if(file_p->cache) {
         if(file_p->cache->buffer) {
             lv_mem_free(file_p->cache->buffer);
         }
 
+#if LV_FS_CACHE_SIZE
+        if(file_p->cache->file) cache_file_close(file_p->cache->file);
+#endif
+
         lv_mem_free(file_p->cache);
     }
 
@@ -129,6 +207,7 @@ lv_fs_res_t lv_fs_close(lv_fs_file_t * file_p)
     return res;
 }
 
+#if LV_FS_CACHE_SIZE == 0
 static lv_fs_res_t lv_fs_read_cached(lv_fs_file_t * file_p, char * buf, uint32_t btr, uint32_t * br)
 {
     lv_fs_res_t res = LV_FS_RES_OK;
@@ -157,10 +236,12 @@ static lv_fs_res_t lv_fs_read_cached(lv_fs_file_t * file_p, char * buf, uint32_t
                 /*If remaining data chuck is bigger than buffer size, then do not use cache, instead read it directly from FS*/
                 res = file_p->drv->read_cb(file_p->drv, file_p->file_d, (void *)(buf + buffer_remaining_length),
                                            btr - buffer_remaining_length, &bytes_read_to_buffer);
+                cache_stat.drv_read_cnt++;
             }
             else {
                 /*If remaining data chunk is smaller than buffer size, then read into cache buffer*/
                 res = file_p->drv->read_cb(file_p->drv, file_p->file_d, (void *)buffer, buffer_size, &bytes_read_to_buffer);
+                cache_stat.drv_read_cnt++;
                 file_p->cache->start = file_p->cache->end;
                 file_p->cache->end = file_p->cache->start + bytes_read_to_buffer;
 
@@ -175,6 +256,7 @@ static lv_fs_res_t lv_fs_read_cached(lv_fs_file_t * file_p, char * buf, uint32_t
         if(btr > buffer_size) {
             /*If bigger data is requested, then do not use cache, instead read it directly*/
             res = file_p->drv->read_cb(file_p->drv, file_p->file_d, (void *)buf, btr, br);
+            cache_stat.drv_read_cnt++;
         }
         else {
             /*If small data is requested, then read from FS into cache buffer*/
@@ -186,6 +268,7 @@ static lv_fs_res_t lv_fs_read_cached(lv_fs_file_t * file_p, char * buf, uint32_t
 
             uint32_t bytes_read_to_buffer = 0;
             res = file_p->drv->read_cb(file_p->drv, file_p->file_d, (void *)buffer, buffer_size, &bytes_read_to_buffer);
+            cache_stat.drv_read_cnt++;
             file_p->cache->start = file_position;
             file_p->cache->end = file_p->cache->start + bytes_read_to_buffer;
 
@@ -201,6 +284,7 @@ static lv_fs_res_t lv_fs_read_cached(lv_fs_file_t * file_p, char * buf, uint32_t
 
     return res;
 }
+#endif /*LV_FS_CACHE_SIZE == 0*/
 
 lv_fs_res_t lv_fs_read(lv_fs_file_t * file_p, void * buf, uint32_t btr, uint32_t * br)
 {
@@ -211,11 +295,31 @@ lv_fs_res_t lv_fs_read(lv_fs_file_t * file_p, void * buf, uint32_t btr, uint32_t
     uint32_t br_tmp = 0;
     lv_fs_res_t res;
 
-    if(file_p->drv->cache_size) {
+    if(file_p->cache && file_p->cache->mapped) {
+        lv_fs_file_cache_t * cache = file_p->cache;
+        if(cache->file_position < cache->mapped_size) {
+            br_tmp = LV_MIN(btr, cache->mapped_size - cache->file_position);
+            lv_memcpy(buf, cache->mapped + cache->file_position, br_tmp);
+            cache->file_position += br_tmp;
+        }
+        cache_stat.read_cnt++;
+        cache_stat.mapped_read_cnt++;
+        res = LV_FS_RES_OK;
+    }
+#if LV_FS_CACHE_SIZE
+    else if(file_p->cache) {
+        cache_stat.read_cnt++;
+        res = lv_fs_read_blocks(file_p, buf, btr, &br_tmp);
+    }
+#else
+    else if(file_p->cache) {
+        cache_stat.read_cnt++;
         res = lv_fs_read_cached(file_p, (char *)buf, btr, &br_tmp);
     }
+#endif
     else {
         res = file_p->drv->read_cb(file_p->drv, file_p->file_d, buf, btr, &br_tmp);
+        cache_stat.drv_read_cnt++;
     }
 
     if(br != NULL) *br = br_tmp;
@@ -223,6 +327,17 @@ lv_fs_res_t lv_fs_read(lv_fs_file_t * file_p, void * buf, uint32_t btr, uint32_t
     return res;
 }
 
+const void * lv_fs_get_mapped(lv_fs_file_t * file_p, uint32_t * size)
+{
+    if(file_p->cache == NULL || file_p->cache->mapped == NULL) {
+        *size = 0;
+        return NULL;
+    }
+
+    *size = file_p->cache->mapped_size;
+    return file_p->cache->mapped;
+}
+
 lv_fs_res_t lv_fs_write(lv_fs_file_t * file_p, const void * buf, uint32_t btw, uint32_t * bw)
 {
     if(bw != NULL) *bw = 0;
@@ -236,7 +351,28 @@ lv_fs_res_t lv_fs_write(lv_fs_file_t * file_p, const void * buf, uint32_t btw, u
     }
 
     uint32_t bw_tmp = 0;
-    lv_fs_res_t res = file_p->drv->write_cb(file_p->drv, file_p->file_d, buf, btw, &bw_tmp);
+    lv_fs_res_t res;
+#if LV_FS_CACHE_SIZE
+    lv_fs_file_cache_t * cache = file_p->cache;
+    if(cache && cache->file) {
+        /*The cached blocks become outdated*/
+        cache_drop_blocks(cache->file);
+
+        res = LV_FS_RES_OK;
+        if(cache->drv_position != cache->file_position) {
+            res = file_p->drv->seek_cb(file_p->drv, file_p->file_d, cache->file_position, LV_FS_SEEK_SET);
+        }
+        if(res == LV_FS_RES_OK) {
+            res = file_p->drv->write_cb(file_p->drv, file_p->file_d, buf, btw, &bw_tmp);
+            cache->file_position += bw_tmp;
+        }
+        cache->drv_position = cache->file_position;
+    }
+    else
+#endif
+    {
+        res = file_p->drv->write_cb(file_p->drv, file_p->file_d, buf, btw, &bw_tmp);
+    }
     if(bw != NULL) *bw = bw_tmp;
 
     return res;
@@ -253,7 +389,32 @@ lv_fs_res_t lv_fs_seek(lv_fs_file_t * file_p, uint32_t pos, lv_fs_whence_t whenc
     }
 
     lv_fs_res_t res = LV_FS_RES_OK;
-    if(file_p->drv->cache_size) {
+    if(file_p->cache && file_p->cache->mapped) {
+        lv_fs_file_cache_t * cache = file_p->cache;
+        if(whence == LV_FS_SEEK_SET) cache->file_position = pos;
+        else if(whence == LV_FS_SEEK_CUR) cache->file_position += pos;
+        else if(whence == LV_FS_SEEK_END) cache->file_position = cache->mapped_size + pos;
+    }
+#if LV_FS_CACHE_SIZE
+    else if(file_p->cache) {
+        /*The driver seeks only when a block is read*/
+        lv_fs_file_cache_t * cache = file_p->cache;
+        if(whence == LV_FS_SEEK_SET) cache->file_position = pos;
+        else if(whence == LV_FS_SEEK_CUR) cache->file_position += pos;
+        else if(whence == LV_FS_SEEK_END) {
+            res = file_p->drv->seek_cb(file_p->drv, file_p->file_d, pos, whence);
+            if(res == LV_FS_RES_OK) {
+                uint32_t tmp_position;
+                res = file_p->drv->tell_cb(file_p->drv, file_p->file_d, &tmp_position);
+                if(res == LV_FS_RES_OK) {
+                    cache->file_position = tmp_position;
+                    cache->drv_position = tmp_position;
+                }
+            }
+        }
+    }
+#else
+    else if(file_p->cache) {
         switch(whence) {
             case LV_FS_SEEK_SET: {
                     file_p->cache->file_position = pos;
@@ -290,6 +451,7 @@ lv_fs_res_t lv_fs_seek(lv_fs_file_t * file_p, uint32_t pos, lv_fs_whence_t whenc
                 }
         }
     }
+#endif
     else {
         res = file_p->drv->seek_cb(file_p->drv, file_p->file_d, pos, whence);
     }
@@ -310,7 +472,7 @@ lv_fs_res_t lv_fs_tell(lv_fs_file_t * file_p, uint32_t * pos)
     }
 
     lv_fs_res_t res;
-    if(file_p->drv->cache_size) {
+    if(file_p->cache) {
         *pos = file_p->cache->file_position;
         res = LV_FS_RES_OK;
     }
@@ -321,6 +483,31 @@ lv_fs_res_t lv_fs_tell(lv_fs_file_t * file_p, uint32_t * pos)
     return res;
 }
 
+void lv_fs_cache_invalidate(const char * path)
+{
+#if LV_FS_CACHE_SIZE
+    lv_fs_cache_file_t * file = cache_files;
+    while(file) {
+        /*The file might be freed when its blocks are dropped*/
+        lv_fs_cache_file_t * next = file->next;
+        if(path == NULL || strcmp(path, file->path) == 0) cache_drop_blocks(file);
+        file = next;
+    }
+#else
+    LV_UNUSED(path);
+#endif
+}
+
+void lv_fs_get_cache_stat(lv_fs_cache_stat_t * stat)
+{
+    *stat = cache_stat;
+}
+
+void lv_fs_reset_cache_stat(void)
+{
+    lv_memset_00(&cache_stat, sizeof(cache_stat));
+}
+
 lv_fs_res_t lv_fs_dir_open(lv_fs_dir_t * rddir_p, const char * path)
 {
     if(path == NULL) return LV_FS_RES_INV_PARAM;
@@ -516,3 +703,227 @@ static const char * lv_fs_get_real_path(const char * path)
 
     return path;
 }
+
+#if LV_FS_CACHE_SIZE
+
+/**
+ * Get the shared cache entry of a file to open. Opening the same path again finds its cached blocks.
+ * @param path      the path with the driver letter
+ * @return          the entry or NULL if there is not enough memory
+ */
+static lv_fs_cache_file_t * cache_file_open(const char * path)
+{
+    lv_fs_cache_file_t * file;
+    for(file = cache_files; file; file = file->next) {
+        if(strcmp(path, file->path) == 0) break;
+    }
+
+    if(file == NULL) {
+        size_t len = strlen(path);
+        file = lv_mem_alloc(sizeof(lv_fs_cache_file_t) + len + 1);
+        LV_ASSERT_MALLOC(file);
+        if(file == NULL) return NULL;
+        file->open_cnt = 0;
+        file->block_cnt = 0;
+        lv_memcpy(file->path, path, len + 1);
+        file->next = cache_files;
+        cache_files = file;
+    }
+
+    file->open_cnt++;
+    return file;
+}
+
+/**
+ * Free the entry of a file if it's not open and has no blocks
+ * @param file      the entry of a file
+ */
+static void cache_file_free_unused(lv_fs_cache_file_t * file)
+{
+    if(file->open_cnt || file->block_cnt) return;
+
+    lv_fs_cache_file_t ** prev = &cache_files;
+    while(*prev != file) prev = &(*prev)->next;
+    *prev = file->next;
+    lv_mem_free(file);
+}
+
+static void cache_file_close(lv_fs_cache_file_t * file)
+{
+    file->open_cnt--;
+    cache_file_free_unused(file);
+}
+
+static void cache_block_drop(lv_fs_cache_block_t * block)
+{
+    lv_fs_cache_file_t * file = block->file;
+    block->file = NULL;
+    file->block_cnt--;
+    cache_file_free_unused(file);
+}
+
+static void cache_drop_blocks(lv_fs_cache_file_t * file)
+{
+    /*The file is freed with its last block if it's closed*/
+    uint32_t block_cnt = file->block_cnt;
+    uint32_t i;
+    for(i = 0; i < CACHE_BLOCK_CNT && block_cnt; i++) {
+        if(cache_blocks[i].file == file) {
+            block_cnt--;
+            cache_block_drop(&cache_blocks[i]);
+        }
+    }
+}
+
+static lv_fs_cache_block_t * cache_block_find(lv_fs_cache_file_t * file, uint32_t index)
+{
+    if(file->block_cnt == 0) return NULL;
+
+    uint32_t i;
+    for(i = 0; i < CACHE_BLOCK_CNT; i++) {
+        if(cache_blocks[i].file == file && cache_blocks[i].index == index) {
+            cache_blocks[i].life = ++cache_life;
+            return &cache_blocks[i];
+        }
+    }
+    return NULL;
+}
+
+/*Get an unused or the least recently used block*/
+static lv_fs_cache_block_t * cache_block_get_free(void)
+{
+    lv_fs_cache_block_t * lru = &cache_blocks[0];
+    uint32_t i;
+    for(i = 0; i < CACHE_BLOCK_CNT; i++) {
+        if(cache_blocks[i].file == NULL) return &cache_blocks[i];
+        if(cache_blocks[i].life < lru->life) lru = &cache_blocks[i];
+    }
+
+    cache_block_drop(lru);
+    return lru;
+}
+
+static uint8_t * cache_block_get_data(const lv_fs_cache_block_t * block)
+{
+    return cache_buf + (block - cache_blocks) * LV_FS_CACHE_BLOCK_SIZE;
+}
+
+/*Read from the driver at a position, seeking only if the driver is not there already*/
+static lv_fs_res_t drv_read_at(lv_fs_file_t * file_p, uint32_t pos, void * buf, uint32_t btr, uint32_t * br)
+{
+    lv_fs_file_cache_t * cache = file_p->cache;
+    lv_fs_res_t res;
+    *br = 0;
+
+    if(cache->drv_position != pos) {
+        res = file_p->drv->seek_cb(file_p->drv, file_p->file_d, pos, LV_FS_SEEK_SET);
+        if(res != LV_FS_RES_OK) return res;
+        cache->drv_position = pos;
+    }
+
+    res = file_p->drv->read_cb(file_p->drv, file_p->file_d, buf, btr, br);
+    cache_stat.drv_read_cnt++;
+    if(res == LV_FS_RES_OK) cache->drv_position += *br;
+    else cache->drv_position = UINT32_MAX;  /*Unknown*/
+    return res;
+}
+
+/**
+ * Read `cnt` blocks of a file into the cache, stopping at the first cached block or at the end of the file
+ * @param file_p    pointer to an opened file
+ * @param index     index of the first block to read
+ * @param cnt       the number of blocks to read
+ * @return          LV_FS_RES_OK or an error if not even the first block could be read
+ */
+static lv_fs_res_t cache_blocks_load(lv_fs_file_t * file_p, uint32_t index, uint32_t cnt)
+{
+    lv_fs_cache_file_t * file = file_p->cache->file;
+    uint32_t i;
+    for(i = 0; i < cnt; i++) {
+        if(i > 0 && cache_block_find(file, index + i)) break;
+
+        lv_fs_cache_block_t * block = cache_block_get_free();
+        uint32_t br;
+        lv_fs_res_t res = drv_read_at(file_p, (index + i) * LV_FS_CACHE_BLOCK_SIZE, cache_block_get_data(block),
+                                      LV_FS_CACHE_BLOCK_SIZE, &br);
+        if(res != LV_FS_RES_OK) return i == 0 ? res : LV_FS_RES_OK;
+
+        block->file = file;
+        block->index = index + i;
+        block->size = br;
+        block->life = ++cache_life;
+        file->block_cnt++;
+
+        cache_stat.miss_cnt++;
+        if(i > 0) cache_stat.read_ahead_cnt++;
+
+        if(br < LV_FS_CACHE_BLOCK_SIZE) break;  /*End of the file*/
+    }
+
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t lv_fs_read_blocks(lv_fs_file_t * file_p, uint8_t * buf, uint32_t btr, uint32_t * br)
+{
+    lv_fs_file_cache_t * cache = file_p->cache;
+    lv_fs_cache_file_t * file = cache->file;
+    uint32_t pos = cache->file_position;
+    lv_fs_res_t res = LV_FS_RES_OK;
+    *br = 0;
+
+    if(cache_buf == NULL) {
+        cache_buf = lv_mem_alloc(CACHE_BLOCK_CNT * LV_FS_CACHE_BLOCK_SIZE);
+        if(cache_buf == NULL) {
+            LV_LOG_WARN("Couldn't allocate the file cache, reading without it");
+            res = drv_read_at(file_p, pos, buf, btr, br);
+            cache->file_position += *br;
+            return res;
+        }
+    }
+
+    while(btr) {
+        uint32_t index = pos / LV_FS_CACHE_BLOCK_SIZE;
+        uint32_t offset = pos % LV_FS_CACHE_BLOCK_SIZE;
+        uint32_t n;
+
+        lv_fs_cache_block_t * block = cache_block_find(file, index);
+        if(block) {
+            cache_stat.hit_cnt++;
+        }
+        else if(offset != 0 || btr < LV_FS_CACHE_BLOCK_SIZE) {
+            /*Read the next blocks too if the file is read sequentially*/
+            uint32_t cnt = index == cache->last_block + 1 ? CACHE_READ_AHEAD : 1;
+            res = cache_blocks_load(file_p, index, cnt);
+            if(res != LV_FS_RES_OK) break;
+            block = cache_block_find(file, index);
+        }
+
+        if(block) {
+            if(offset >= block->size) break;   /*End of the file*/
+            n = LV_MIN(btr, block->size - offset);
+            lv_memcpy(buf, cache_block_get_data(block) + offset, n);
+        }
+        else {
+            /*Read the whole blocks which are not cached directly into the buffer.
+             *They would only evict other blocks.*/
+            uint32_t cnt = 1;
+            while((cnt + 1) * LV_FS_CACHE_BLOCK_SIZE <= btr && cache_block_find(file, index + cnt) == NULL) cnt++;
+
+            res = drv_read_at(file_p, pos, buf, cnt * LV_FS_CACHE_BLOCK_SIZE, &n);
+            if(res != LV_FS_RES_OK) break;
+            cache_stat.bypass_size += n;
+            if(n == 0) break;
+        }
+
+        buf += n;
+        btr -= n;
+        pos += n;
+        *br += n;
+        cache->last_block = (pos - 1) / LV_FS_CACHE_BLOCK_SIZE;
+    }
+
+    cache->file_position = pos;
+    return res;
+}
+
+#endif /*LV_FS_CACHE_SIZE*/
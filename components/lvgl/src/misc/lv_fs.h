@@ -78,6 +78,10 @@ typedef struct _lv_fs_drv_t {
     lv_fs_res_t (*seek_cb)(struct _lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs_whence_t whence);
     lv_fs_res_t (*tell_cb)(struct _lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
 
+    /*Optional: map a file opened for reading into memory to read it without copying. Return NULL if it's not possible*/
+    const void * (*mmap_cb)(struct _lv_fs_drv_t * drv, void * file_p, uint32_t * size);
+    void (*munmap_cb)(struct _lv_fs_drv_t * drv, void * file_p, const void * data, uint32_t size);
+
     void * (*dir_open_cb)(struct _lv_fs_drv_t * drv, const char * path);
     lv_fs_res_t (*dir_read_cb)(struct _lv_fs_drv_t * drv, void * rddir_p, char * fn);
     lv_fs_res_t (*dir_close_cb)(struct _lv_fs_drv_t * drv, void * rddir_p);
@@ -87,11 +91,20 @@ typedef struct _lv_fs_drv_t {
 #endif
 } lv_fs_drv_t;
 
+struct _lv_fs_cache_file_t;
+
 typedef struct {
     uint32_t start;
     uint32_t end;
     uint32_t file_position;
     void * buffer;
+#if LV_FS_CACHE_SIZE
+    struct _lv_fs_cache_file_t * file;  /**< Identifies the blocks of the file in the shared cache*/
+    uint32_t drv_position;              /**< Position of the driver's read write pointer*/
+    uint32_t last_block;                /**< The last read block to detect sequential reading*/
+#endif
+    const uint8_t * mapped;             /**< The content of the file if the driver mapped it into memory*/
+    uint32_t mapped_size;
 } lv_fs_file_cache_t;
 
 typedef struct {
@@ -105,6 +118,16 @@ typedef struct {
     lv_fs_drv_t * drv;
 } lv_fs_dir_t;
 
+typedef struct {
+    uint32_t read_cnt;          /**< `lv_fs_read` calls on cached or mapped files*/
+    uint32_t hit_cnt;           /**< Blocks found in the shared cache*/
+    uint32_t miss_cnt;          /**< Blocks read from the drivers into the shared cache*/
+    uint32_t read_ahead_cnt;    /**< Blocks read ahead of sequential reads (included in `miss_cnt`)*/
+    uint32_t bypass_size;       /**< Bytes read from the drivers directly into the caller's buffer*/
+    uint32_t drv_read_cnt;      /**< Calls of the drivers' `read_cb`*/
+    uint32_t mapped_read_cnt;   /**< Reads of memory mapped files*/
+} lv_fs_cache_stat_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -171,6 +194,14 @@ lv_fs_res_t lv_fs_close(lv_fs_file_t * file_p);
  */
 lv_fs_res_t lv_fs_read(lv_fs_file_t * file_p, void * buf, uint32_t btr, uint32_t * br);
 
+/**
+ * Get the content of a file mapped into memory by the driver to read it without copying
+ * @param file_p    pointer to a lv_fs_file_t variable
+ * @param size      store the size of the file here
+ * @return          pointer to the content of the file or NULL if it's not mapped
+ */
+const void * lv_fs_get_mapped(lv_fs_file_t * file_p, uint32_t * size);
+
 /**
  * Write into a file
  * @param file_p    pointer to a lv_fs_file_t variable
@@ -198,6 +229,24 @@ lv_fs_res_t lv_fs_seek(lv_fs_file_t * file_p, uint32_t pos, lv_fs_whence_t whenc
  */
 lv_fs_res_t lv_fs_tell(lv_fs_file_t * file_p, uint32_t * pos);
 
+/**
+ * Drop the cached blocks of a file from the shared cache, e.g. if it was changed bypassing `lv_fs`.
+ * Only used if `LV_FS_CACHE_SIZE > 0`.
+ * @param path      path to the file beginning with the driver letter or NULL to drop all blocks
+ */
+void lv_fs_cache_invalidate(const char * path);
+
+/**
+ * Get the statistics of the cached and mapped reads
+ * @param stat      store the statistics here
+ */
+void lv_fs_get_cache_stat(lv_fs_cache_stat_t * stat);
+
+/**
+ * Reset the statistics of the cached and mapped reads
+ */
+void lv_fs_reset_cache_stat(void);
+
 /**
  * Initialize a 'fs_dir_t' variable for directory reading
  * @param rddir_p   pointer to a 'lv_fs_dir_t' variable
@@ -17,6 +17,7 @@ extern "C" {
 #include <stdint.h>
 #include "lv_mem.h"
 #include "lv_ll.h"
+#include "lv_ilist.h"
 #include "lv_timer.h"
 #include "lv_types.h"
 #include "../draw/lv_img_cache.h"
@@ -41,14 +42,14 @@ extern "C" {
 #define LV_DISPATCH11(f, t, n)          LV_DISPATCH(f, t, n)
 
 #define LV_ITERATE_ROOTS(f)                                                                            \
-    LV_DISPATCH(f, lv_ll_t, _lv_timer_ll) /*Linked list to store the lv_timers*/                       \
+    LV_DISPATCH(f, lv_ilist_t, _lv_timer_ll) /*Linked list to store the lv_timers*/                    \
     LV_DISPATCH(f, lv_ll_t, _lv_disp_ll)  /*Linked list of display device*/                            \
     LV_DISPATCH(f, lv_ll_t, _lv_indev_ll) /*Linked list of input device*/                              \
     LV_DISPATCH(f, lv_ll_t, _lv_fsdrv_ll)                                                              \
-    LV_DISPATCH(f, lv_ll_t, _lv_anim_ll)                                                               \
+    LV_DISPATCH(f, lv_ilist_t, _lv_anim_ll)                                                            \
     LV_DISPATCH(f, lv_ll_t, _lv_group_ll)                                                              \
     LV_DISPATCH(f, lv_ll_t, _lv_img_decoder_ll)                                                        \
-    LV_DISPATCH(f, lv_ll_t, _lv_obj_style_trans_ll)                                                    \
+    LV_DISPATCH(f, lv_ilist_t, _lv_obj_style_trans_ll)                                                 \
     LV_DISPATCH(f, lv_layout_dsc_t *, _lv_layout_list)                                                 \
     LV_DISPATCH_COND(f, _lv_img_cache_entry_t*, _lv_img_cache_array, LV_IMG_CACHE_DEF, 1)              \
     LV_DISPATCH_COND(f, _lv_img_cache_entry_t, _lv_img_cache_single, LV_IMG_CACHE_DEF, 0)              \
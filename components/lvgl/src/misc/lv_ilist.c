@@ -0,0 +1,338 @@
+/**
+ * @file lv_ilist.c
+ * Handle intrusive linked lists.
+ * The items are allocated in chunks by the 'lv_mem' module and released items are reused.
+ * A chunk whose items are all released is freed, except the first one and one spare.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_ilist.h"
+#include "lv_mem.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#ifdef LV_ARCH_64
+    #define ILIST_ALIGN(s) (((s) + 7) & (~0x7))
+#else
+    #define ILIST_ALIGN(s) (((s) + 3) & (~0x3))
+#endif
+
+#define ILIST_CHUNK_HEADER_SIZE ILIST_ALIGN(sizeof(ilist_chunk_t))
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/*The header of a chunk, followed by its items*/
+typedef struct _ilist_chunk_t {
+    struct _ilist_chunk_t * next;
+    uint32_t free_cnt;
+} ilist_chunk_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static bool add_chunk(lv_ilist_t * list);
+static ilist_chunk_t * find_chunk(const lv_ilist_t * list, const void * item);
+static void release_chunk(lv_ilist_t * list, ilist_chunk_t * chunk);
+static void release_chunks(lv_ilist_t * list);
+static void free_items_of_chunk(lv_ilist_t * list, ilist_chunk_t * chunk);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+#define NODE_OF(list, item) ((lv_ilist_node_t *)((uint8_t *)(item) + (list)->node_ofs))
+#define ITEM_OF(list, node) ((void *)((uint8_t *)(node) - (list)->node_ofs))
+#define CHUNK_ITEMS(chunk) ((uint8_t *)(chunk) + ILIST_CHUNK_HEADER_SIZE)
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Initialize an intrusive linked list and allocate the first chunk of its items
+ * @param list pointer to an `lv_ilist_t` variable
+ * @param item_size size of an item in bytes
+ * @param node_ofs offset of the `lv_ilist_node_t` in the item
+ * @param chunk_item_cnt number of items to allocate at once
+ */
+void _lv_ilist_init(lv_ilist_t * list, uint32_t item_size, uint32_t node_ofs, uint16_t chunk_item_cnt)
+{
+    lv_memset_00(list, sizeof(lv_ilist_t));
+    list->item_size = ILIST_ALIGN(item_size);
+    list->node_ofs = node_ofs;
+    list->chunk_item_cnt = chunk_item_cnt > 0 ? chunk_item_cnt : 1;
+
+    add_chunk(list);
+}
+
+/**
+ * Take an item from the pool of the list
+ * @param list pointer to an intrusive linked list
+ * @return pointer to the new item or NULL if out of memory
+ */
+void * _lv_ilist_alloc(lv_ilist_t * list)
+{
+    if(list->free_head == NULL) {
+        if(!add_chunk(list)) return NULL;
+    }
+
+    lv_ilist_node_t * node = list->free_head;
+    list->free_head = node->next;
+    node->prev = NULL;
+    node->next = NULL;
+    list->used_cnt++;
+    void * item = ITEM_OF(list, node);
+    find_chunk(list, item)->free_cnt--;
+
+    return item;
+}
+
+/**
+ * Give back an item to the pool of the list
+ * @param list pointer to an intrusive linked list
+ * @param item pointer to an unlinked item
+ */
+void _lv_ilist_free(lv_ilist_t * list, void * item)
+{
+    if(item == NULL) return;
+
+    lv_ilist_node_t * node = NODE_OF(list, item);
+    node->prev = NULL;
+    node->next = list->free_head;
+    list->free_head = node;
+
+    list->used_cnt--;
+    if(list->used_cnt == 0) {
+        release_chunks(list);
+        return;
+    }
+
+    /*Free the chunk when its items are all released. The first chunk is kept, and so is a chunk
+     *when there would be less than half a chunk of free items left, to not free and allocate
+     *a chunk again and again when the number of items goes up and down around a chunk boundary.*/
+    ilist_chunk_t * chunk = find_chunk(list, item);
+    chunk->free_cnt++;
+    uint32_t free_cnt = (uint32_t)list->chunk_cnt * list->chunk_item_cnt - list->used_cnt;
+    if(chunk->free_cnt == list->chunk_item_cnt && chunk->next != NULL &&
+       free_cnt - list->chunk_item_cnt >= list->chunk_item_cnt / 2u) {
+        release_chunk(list, chunk);
+    }
+}
+
+/**
+ * Link an item as the new head of a list
+ * @param list pointer to an intrusive linked list
+ * @param item pointer to an unlinked item
+ */
+void _lv_ilist_ins_head(lv_ilist_t * list, void * item)
+{
+    lv_ilist_node_t * node = NODE_OF(list, item);
+    node->prev = NULL;
+    node->next = list->head;
+
+    if(list->head) list->head->prev = node;
+    else list->tail = node;
+
+    list->head = node;
+}
+
+/**
+ * Link an item as the new tail of a list
+ * @param list pointer to an intrusive linked list
+ * @param item pointer to an unlinked item
+ */
+void _lv_ilist_ins_tail(lv_ilist_t * list, void * item)
+{
+    lv_ilist_node_t * node = NODE_OF(list, item);
+    node->prev = list->tail;
+    node->next = NULL;
+
+    if(list->tail) list->tail->next = node;
+    else list->head = node;
+
+    list->tail = node;
+}
+
+/**
+ * Unlink an item from a list
+ * @param list pointer to an intrusive linked list
+ * @param item pointer to a linked item
+ */
+void _lv_ilist_remove(lv_ilist_t * list, void * item)
+{
+    lv_ilist_node_t * node = NODE_OF(list, item);
+
+    if(node->prev) node->prev->next = node->next;
+    else list->head = node->next;
+
+    if(node->next) node->next->prev = node->prev;
+    else list->tail = node->prev;
+
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+/**
+ * Unlink all items and give them back to the pool
+ * @param list pointer to an intrusive linked list
+ */
+void _lv_ilist_clear(lv_ilist_t * list)
+{
+    lv_ilist_node_t * node = list->head;
+    list->head = NULL;
+    list->tail = NULL;
+
+    while(node) {
+        lv_ilist_node_t * next = node->next;
+        _lv_ilist_free(list, ITEM_OF(list, node));
+        node = next;
+    }
+}
+
+/**
+ * Return the head item of a list
+ * @param list pointer to an intrusive linked list
+ * @return the head item or NULL if the list is empty
+ */
+void * _lv_ilist_get_head(const lv_ilist_t * list)
+{
+    return list->head ? ITEM_OF(list, list->head) : NULL;
+}
+
+/**
+ * Return the tail item of a list
+ * @param list pointer to an intrusive linked list
+ * @return the tail item or NULL if the list is empty
+ */
+void * _lv_ilist_get_tail(const lv_ilist_t * list)
+{
+    return list->tail ? ITEM_OF(list, list->tail) : NULL;
+}
+
+/**
+ * Return the item after `item`
+ * @param list pointer to an intrusive linked list
+ * @param item pointer to a linked item
+ * @return the next item or NULL if `item` is the tail
+ */
+void * _lv_ilist_get_next(const lv_ilist_t * list, const void * item)
+{
+    lv_ilist_node_t * next = NODE_OF(list, item)->next;
+    return next ? ITEM_OF(list, next) : NULL;
+}
+
+/**
+ * Return the item before `item`
+ * @param list pointer to an intrusive linked list
+ * @param item pointer to a linked item
+ * @return the previous item or NULL if `item` is the head
+ */
+void * _lv_ilist_get_prev(const lv_ilist_t * list, const void * item)
+{
+    lv_ilist_node_t * prev = NODE_OF(list, item)->prev;
+    return prev ? ITEM_OF(list, prev) : NULL;
+}
+
+/**
+ * Check if a list is empty
+ * @param list pointer to an intrusive linked list
+ * @return true: the list has no items
+ */
+bool _lv_ilist_is_empty(const lv_ilist_t * list)
+{
+    return list->head == NULL;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static bool add_chunk(lv_ilist_t * list)
+{
+    ilist_chunk_t * chunk = lv_mem_alloc(ILIST_CHUNK_HEADER_SIZE + (size_t)list->item_size * list->chunk_item_cnt);
+    if(chunk == NULL) return false;
+
+    chunk->next = list->chunks;
+    list->chunks = chunk;
+    list->chunk_cnt++;
+
+    free_items_of_chunk(list, chunk);
+    return true;
+}
+
+/**
+ * Find the chunk of an item. The chunks are few, and the newest ones have the items used the most recently.
+ */
+static ilist_chunk_t * find_chunk(const lv_ilist_t * list, const void * item)
+{
+    const uint8_t * p = item;
+    size_t items_size = (size_t)list->item_size * list->chunk_item_cnt;
+    ilist_chunk_t * chunk = list->chunks;
+    while(p < CHUNK_ITEMS(chunk) || p >= CHUNK_ITEMS(chunk) + items_size) {
+        chunk = chunk->next;
+    }
+    return chunk;
+}
+
+/**
+ * Unlink the items of a chunk from the free items and free the chunk
+ */
+static void release_chunk(lv_ilist_t * list, ilist_chunk_t * chunk)
+{
+    const uint8_t * items_start = CHUNK_ITEMS(chunk);
+    const uint8_t * items_end = items_start + (size_t)list->item_size * list->chunk_item_cnt;
+    lv_ilist_node_t ** node_p = &list->free_head;
+    while(*node_p) {
+        const uint8_t * item = ITEM_OF(list, *node_p);
+        if(item >= items_start && item < items_end) *node_p = (*node_p)->next;
+        else node_p = &(*node_p)->next;
+    }
+
+    ilist_chunk_t ** chunk_p = (ilist_chunk_t **)&list->chunks;
+    while(*chunk_p != chunk) chunk_p = &(*chunk_p)->next;
+    *chunk_p = chunk->next;
+    list->chunk_cnt--;
+    lv_mem_free(chunk);
+}
+
+/**
+ * Free all chunks but the first one when no items are used
+ */
+static void release_chunks(lv_ilist_t * list)
+{
+    if(list->chunk_cnt <= 1) return;
+
+    ilist_chunk_t * chunk = list->chunks;
+    while(chunk->next) {
+        ilist_chunk_t * next = chunk->next;
+        lv_mem_free(chunk);
+        chunk = next;
+    }
+
+    list->chunks = chunk;
+    list->chunk_cnt = 1;
+    list->free_head = NULL;
+    free_items_of_chunk(list, chunk);
+}
+
+static void free_items_of_chunk(lv_ilist_t * list, ilist_chunk_t * chunk)
+{
+    uint8_t * item = CHUNK_ITEMS(chunk);
+    uint32_t i;
+    for(i = 0; i < list->chunk_item_cnt; i++) {
+        lv_ilist_node_t * node = NODE_OF(list, item);
+        node->prev = NULL;
+        node->next = list->free_head;
+        list->free_head = node;
+        item += list->item_size;
+    }
+    chunk->free_cnt = list->chunk_item_cnt;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file lv_ilist.h
+ * Handle intrusive linked lists. The links are stored in the items
+ * and the items are taken from chunks which are kept for reuse.
+ */
+
+#ifndef LV_ILIST_H
+#define LV_ILIST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/** The links of an item. Embed it in the item's type*/
+typedef struct _lv_ilist_node_t {
+    struct _lv_ilist_node_t * prev;
+    struct _lv_ilist_node_t * next;
+} lv_ilist_node_t;
+
+/** Description of an intrusive linked list and the pool of its items*/
+typedef struct {
+    lv_ilist_node_t * head;
+    lv_ilist_node_t * tail;
+    lv_ilist_node_t * free_head;    /**< Released items linked by `next`*/
+    void * chunks;                  /**< Chunks of items, the newest first*/
+    uint32_t item_size;             /**< Size of an item in bytes*/
+    uint32_t node_ofs;              /**< Offset of the `lv_ilist_node_t` in the items*/
+    uint32_t used_cnt;              /**< Number of items taken from the pool*/
+    uint16_t chunk_item_cnt;        /**< Number of items allocated at once*/
+    uint16_t chunk_cnt;
+} lv_ilist_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Initialize an intrusive linked list and allocate the first chunk of its items.
+ * The first chunk is kept until the end, further chunks are freed when all their items are released.
+ * While items are used, one empty chunk may be kept as a spare.
+ * @param list              pointer to an `lv_ilist_t` variable
+ * @param item_size         size of an item in bytes
+ * @param node_ofs          offset of the `lv_ilist_node_t` in the item, typically `offsetof(type, node)`
+ * @param chunk_item_cnt    number of items to allocate at once
+ */
+void _lv_ilist_init(lv_ilist_t * list, uint32_t item_size, uint32_t node_ofs, uint16_t chunk_item_cnt);
+
+/**
+ * Take an item from the pool of the list. It's not linked into the list yet.
+ * @param list      pointer to an intrusive linked list
+ * @return          pointer to the new item or NULL if out of memory
+ */
+void * _lv_ilist_alloc(lv_ilist_t * list);
+
+/**
+ * Give back an item to the pool of the list. It must not be linked into the list.
+ * @param list      pointer to an intrusive linked list
+ * @param item      pointer to an item from `_lv_ilist_alloc`
+ */
+void _lv_ilist_free(lv_ilist_t * list, void * item);
+
+/**
+ * Link an item as the new head of a list
+ * @param list      pointer to an intrusive linked list
+ * @param item      pointer to an unlinked item
+ */
+void _lv_ilist_ins_head(lv_ilist_t * list, void * item);
+
+/**
+ * Link an item as the new tail of a list
+ * @param list      pointer to an intrusive linked list
+ * @param item      pointer to an unlinked item
+ */
+void _lv_ilist_ins_tail(lv_ilist_t * list, void * item);
+
+/**
+ * Unlink an item from a list. It's not given back to the pool.
+ * @param list      pointer to an intrusive linked list
+ * @param item      pointer to a linked item
+ */
+void _lv_ilist_remove(lv_ilist_t * list, void * item);
+
+/**
+ * Unlink all items and give them back to the pool
+ * @param list      pointer to an intrusive linked list
+ */
+void _lv_ilist_clear(lv_ilist_t * list);
+
+/**
+ * Return the head item of a list
+ * @param list      pointer to an intrusive linked list
+ * @return          the head item or NULL if the list is empty
+ */
+void * _lv_ilist_get_head(const lv_ilist_t * list);
+
+/**
+ * Return the tail item of a list
+ * @param list      pointer to an intrusive linked list
+ * @return          the tail item or NULL if the list is empty
+ */
+void * _lv_ilist_get_tail(const lv_ilist_t * list);
+
+/**
+ * Return the item after `item`
+ * @param list      pointer to an intrusive linked list
+ * @param item      pointer to a linked item
+ * @return          the next item or NULL if `item` is the tail
+ */
+void * _lv_ilist_get_next(const lv_ilist_t * list, const void * item);
+
+/**
+ * Return the item before `item`
+ * @param list      pointer to an intrusive linked list
+ * @param item      pointer to a linked item
+ * @return          the previous item or NULL if `item` is the head
+ */
+void * _lv_ilist_get_prev(const lv_ilist_t * list, const void * item);
+
+/**
+ * Check if a list is empty
+ * @param list      pointer to an intrusive linked list
+ * @return          true: the list has no items
+ */
+bool _lv_ilist_is_empty(const lv_ilist_t * list);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#define _LV_ILIST_READ(list, i) for(i = _lv_ilist_get_head(list); i != NULL; i = _lv_ilist_get_next(list, i))
+
+#define _LV_ILIST_READ_BACK(list, i) for(i = _lv_ilist_get_tail(list); i != NULL; i = _lv_ilist_get_prev(list, i))
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif
@@ -60,6 +60,7 @@
 #endif
 
 static uint32_t zero_mem = ZERO_MEM_SENTINEL; /*Give the address of this variable if 0 byte should be allocated*/
+static uint32_t alloc_cnt;
 
 /**********************
  *      MACROS
@@ -153,6 +154,7 @@ void * lv_mem_alloc(size_t size)
 #endif
 
     if(alloc) {
+        alloc_cnt++;
 #if LV_MEM_CUSTOM == 0
         cur_used += size;
         max_used = LV_MAX(cur_used, max_used);
@@ -212,6 +214,7 @@ void * lv_mem_realloc(void * data_p, size_t new_size)
         return NULL;
     }
 
+    alloc_cnt++;
     MEM_TRACE("allocated at %p", new_p);
     return new_p;
 }
@@ -266,6 +269,7 @@ void lv_mem_monitor(lv_mem_monitor_t * mon_p)
 
     MEM_TRACE("finished");
 #endif
+    mon_p->alloc_cnt = alloc_cnt;
 }
 
 
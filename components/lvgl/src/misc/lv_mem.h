@@ -41,6 +41,7 @@ typedef struct {
     uint32_t max_used; /**< Max size of Heap memory used*/
     uint8_t used_pct; /**< Percentage used*/
     uint8_t frag_pct; /**< Amount of fragmentation*/
+    uint32_t alloc_cnt; /**< Number of allocations and reallocations so far*/
 } lv_mem_monitor_t;
 
 typedef struct {
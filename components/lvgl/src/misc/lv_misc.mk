@@ -6,6 +6,7 @@ CSRCS += lv_bidi.c
 CSRCS += lv_color.c
 CSRCS += lv_fs.c
 CSRCS += lv_gc.c
+CSRCS += lv_ilist.c
 CSRCS += lv_ll.c
 CSRCS += lv_log.c
 CSRCS += lv_lru.c
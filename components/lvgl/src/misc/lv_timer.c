@@ -9,7 +9,7 @@
 #include "../hal/lv_hal_tick.h"
 #include "lv_assert.h"
 #include "lv_mem.h"
-#include "lv_ll.h"
+#include "lv_ilist.h"
 #include "lv_gc.h"
 
 /*********************
@@ -17,10 +17,15 @@
  *********************/
 #define IDLE_MEAS_PERIOD 500 /*[ms]*/
 #define DEF_PERIOD 500
+#define TIMER_CHUNK_ITEM_CNT 8
 
 /**********************
  *      TYPEDEFS
  **********************/
+typedef struct {
+    lv_timer_t timer;       /*Must be the first to use the items as timers*/
+    lv_ilist_node_t node;
+} timer_item_t;
 
 /**********************
  *  STATIC PROTOTYPES
@@ -54,7 +59,7 @@ static bool timer_created;
  */
 void _lv_timer_core_init(void)
 {
-    _lv_ll_init(&LV_GC_ROOT(_lv_timer_ll), sizeof(lv_timer_t));
+    _lv_ilist_init(&LV_GC_ROOT(_lv_timer_ll), sizeof(timer_item_t), offsetof(timer_item_t, node), TIMER_CHUNK_ITEM_CNT);
 
     /*Initially enable the lv_timer handling*/
     lv_timer_enable(true);
@@ -100,11 +105,11 @@ uint32_t LV_ATTRIBUTE_TIMER_HANDLER lv_timer_handler(void)
     do {
         timer_deleted             = false;
         timer_created             = false;
-        LV_GC_ROOT(_lv_timer_act) = _lv_ll_get_head(&LV_GC_ROOT(_lv_timer_ll));
+        LV_GC_ROOT(_lv_timer_act) = _lv_ilist_get_head(&LV_GC_ROOT(_lv_timer_ll));
         while(LV_GC_ROOT(_lv_timer_act)) {
             /*The timer might be deleted if it runs only once ('repeat_count = 1')
              *So get next element until the current is surely valid*/
-            next = _lv_ll_get_next(&LV_GC_ROOT(_lv_timer_ll), LV_GC_ROOT(_lv_timer_act));
+            next = _lv_ilist_get_next(&LV_GC_ROOT(_lv_timer_ll), LV_GC_ROOT(_lv_timer_act));
 
             if(lv_timer_exec(LV_GC_ROOT(_lv_timer_act))) {
                 /*If a timer was created or deleted then this or the next item might be corrupted*/
@@ -119,7 +124,7 @@ uint32_t LV_ATTRIBUTE_TIMER_HANDLER lv_timer_handler(void)
     } while(LV_GC_ROOT(_lv_timer_act));
 
     uint32_t time_till_next = LV_NO_TIMER_READY;
-    next = _lv_ll_get_head(&LV_GC_ROOT(_lv_timer_ll));
+    next = _lv_ilist_get_head(&LV_GC_ROOT(_lv_timer_ll));
     while(next) {
         if(!next->paused) {
             uint32_t delay = lv_timer_time_remaining(next);
@@ -127,7 +132,7 @@ uint32_t LV_ATTRIBUTE_TIMER_HANDLER lv_timer_handler(void)
                 time_till_next = delay;
         }
 
-        next = _lv_ll_get_next(&LV_GC_ROOT(_lv_timer_ll), next); /*Find the next timer*/
+        next = _lv_ilist_get_next(&LV_GC_ROOT(_lv_timer_ll), next); /*Find the next timer*/
     }
 
     busy_time += lv_tick_elaps(handler_start);
@@ -168,9 +173,10 @@ lv_timer_t * lv_timer_create(lv_timer_cb_t timer_xcb, uint32_t period, void * us
 {
     lv_timer_t * new_timer = NULL;
 
-    new_timer = _lv_ll_ins_head(&LV_GC_ROOT(_lv_timer_ll));
+    new_timer = _lv_ilist_alloc(&LV_GC_ROOT(_lv_timer_ll));
     LV_ASSERT_MALLOC(new_timer);
     if(new_timer == NULL) return NULL;
+    _lv_ilist_ins_head(&LV_GC_ROOT(_lv_timer_ll), new_timer);
 
     new_timer->period = period;
     new_timer->timer_cb = timer_xcb;
@@ -200,10 +206,10 @@ void lv_timer_set_cb(lv_timer_t * timer, lv_timer_cb_t timer_cb)
  */
 void lv_timer_del(lv_timer_t * timer)
 {
-    _lv_ll_remove(&LV_GC_ROOT(_lv_timer_ll), timer);
+    _lv_ilist_remove(&LV_GC_ROOT(_lv_timer_ll), timer);
     timer_deleted = true;
 
-    lv_mem_free(timer);
+    _lv_ilist_free(&LV_GC_ROOT(_lv_timer_ll), timer);
 }
 
 /**
@@ -284,8 +290,8 @@ uint8_t lv_timer_get_idle(void)
  */
 lv_timer_t * lv_timer_get_next(lv_timer_t * timer)
 {
-    if(timer == NULL) return _lv_ll_get_head(&LV_GC_ROOT(_lv_timer_ll));
-    else return _lv_ll_get_next(&LV_GC_ROOT(_lv_timer_ll), timer);
+    if(timer == NULL) return _lv_ilist_get_head(&LV_GC_ROOT(_lv_timer_ll));
+    else return _lv_ilist_get_next(&LV_GC_ROOT(_lv_timer_ll), timer);
 }
 
 /**********************
@@ -25,13 +25,26 @@
  *      TYPEDEFS
  **********************/
 
+/*A dummy display to fool the lv_draw functions. They will think they draw to a real screen.
+ *It's kept until the buffer of the canvas changes.*/
+typedef struct _lv_canvas_draw_t {
+    lv_disp_t disp;
+    lv_disp_drv_t drv;
+    lv_draw_sw_ctx_t draw_ctx;
+    lv_area_t clip_area;
+    lv_disp_t * refr_ori;       /*The display refreshing before the drawing began*/
+    uint32_t begin_cnt;         /*Nesting of `draw_begin` calls*/
+    uint8_t antialiasing : 1;   /*The default setting of the driver*/
+} lv_canvas_draw_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static void lv_canvas_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
 static void lv_canvas_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
-static void init_fake_disp(lv_obj_t * canvas, lv_disp_t * disp, lv_disp_drv_t * drv, lv_area_t * clip_area);
-static void deinit_fake_disp(lv_obj_t * canvas, lv_disp_t * disp);
+static lv_canvas_draw_t * draw_begin(lv_obj_t * canvas);
+static void draw_end(lv_obj_t * canvas);
+static void draw_free(lv_obj_t * canvas);
 
 /**********************
  *  STATIC VARIABLES
@@ -69,6 +82,7 @@ void lv_canvas_set_buffer(lv_obj_t * obj, void * buf, lv_coord_t w, lv_coord_t h
     LV_ASSERT_NULL(buf);
 
     lv_canvas_t * canvas = (lv_canvas_t *)obj;
+    draw_free(obj);
 
     canvas->dsc.header.cf = cf;
     canvas->dsc.header.w  = w;
@@ -513,6 +527,36 @@ void lv_canvas_fill_bg(lv_obj_t * canvas, lv_color_t color, lv_opa_t opa)
     lv_obj_invalidate(canvas);
 }
 
+lv_draw_ctx_t * lv_canvas_draw_begin(lv_obj_t * canvas)
+{
+    LV_ASSERT_OBJ(canvas, MY_CLASS);
+
+    lv_img_dsc_t * dsc = lv_canvas_get_img(canvas);
+
+    if(dsc->header.cf >= LV_IMG_CF_INDEXED_1BIT && dsc->header.cf <= LV_IMG_CF_INDEXED_8BIT) {
+        LV_LOG_WARN("lv_canvas_draw_begin: can't draw to LV_IMG_CF_INDEXED canvas");
+        return NULL;
+    }
+
+    lv_canvas_draw_t * draw = draw_begin(canvas);
+    if(draw == NULL) return NULL;
+
+    return draw->drv.draw_ctx;
+}
+
+void lv_canvas_draw_end(lv_obj_t * canvas)
+{
+    LV_ASSERT_OBJ(canvas, MY_CLASS);
+
+    lv_canvas_t * c = (lv_canvas_t *)canvas;
+    if(c->draw == NULL || c->draw->begin_cnt == 0) {
+        LV_LOG_WARN("lv_canvas_draw_end: lv_canvas_draw_begin wasn't called");
+        return;
+    }
+
+    draw_end(canvas);
+}
+
 void lv_canvas_draw_rect(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h,
                          const lv_draw_rect_dsc_t * draw_dsc)
 {
@@ -525,21 +569,13 @@ void lv_canvas_draw_rect(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord
         return;
     }
 
-    /*Create a dummy display to fool the lv_draw function.
-     *It will think it draws to real screen.*/
-    lv_disp_t fake_disp;
-    lv_disp_drv_t driver;
-    lv_area_t clip_area;
-    init_fake_disp(canvas, &fake_disp, &driver, &clip_area);
-
-    lv_disp_t * refr_ori = _lv_refr_get_disp_refreshing();
-    _lv_refr_set_disp_refreshing(&fake_disp);
-
+    lv_canvas_draw_t * draw = draw_begin(canvas);
+    if(draw == NULL) return;
     /*Disable anti-aliasing if drawing with transparent color to chroma keyed canvas*/
     lv_color_t ctransp = LV_COLOR_CHROMA_KEY;
     if(dsc->header.cf == LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED &&
        draw_dsc->bg_color.full == ctransp.full) {
-        fake_disp.driver->antialiasing = 0;
+        draw->drv.antialiasing = 0;
     }
 
     lv_area_t coords;
@@ -548,13 +584,9 @@ void lv_canvas_draw_rect(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord
     coords.x2 = x + w - 1;
     coords.y2 = y + h - 1;
 
-    lv_draw_rect(driver.draw_ctx, draw_dsc, &coords);
-
-    _lv_refr_set_disp_refreshing(refr_ori);
+    lv_draw_rect(draw->drv.draw_ctx, draw_dsc, &coords);
 
-    deinit_fake_disp(canvas, &fake_disp);
-
-    lv_obj_invalidate(canvas);
+    draw_end(canvas);
 }
 
 void lv_canvas_draw_text(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord_t max_w,
@@ -569,28 +601,17 @@ void lv_canvas_draw_text(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord
         return;
     }
 
-    /*Create a dummy display to fool the lv_draw function.
-     *It will think it draws to real screen.*/
-    lv_disp_t fake_disp;
-    lv_disp_drv_t driver;
-    lv_area_t clip_area;
-    init_fake_disp(canvas, &fake_disp, &driver, &clip_area);
-
-    lv_disp_t * refr_ori = _lv_refr_get_disp_refreshing();
-    _lv_refr_set_disp_refreshing(&fake_disp);
+    lv_canvas_draw_t * draw = draw_begin(canvas);
+    if(draw == NULL) return;
 
     lv_area_t coords;
     coords.x1 = x;
     coords.y1 = y;
     coords.x2 = x + max_w - 1;
     coords.y2 = dsc->header.h - 1;
-    lv_draw_label(driver.draw_ctx, draw_dsc, &coords, txt, NULL);
-
-    _lv_refr_set_disp_refreshing(refr_ori);
-
-    deinit_fake_disp(canvas, &fake_disp);
+    lv_draw_label(draw->drv.draw_ctx, draw_dsc, &coords, txt, NULL);
 
-    lv_obj_invalidate(canvas);
+    draw_end(canvas);
 }
 
 void lv_canvas_draw_img(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, const void * src,
@@ -611,15 +632,8 @@ void lv_canvas_draw_img(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, const voi
         LV_LOG_WARN("lv_canvas_draw_img: Couldn't get the image data.");
         return;
     }
-    /*Create a dummy display to fool the lv_draw function.
-     *It will think it draws to real screen.*/
-    lv_disp_t fake_disp;
-    lv_disp_drv_t driver;
-    lv_area_t clip_area;
-    init_fake_disp(canvas, &fake_disp, &driver, &clip_area);
-
-    lv_disp_t * refr_ori = _lv_refr_get_disp_refreshing();
-    _lv_refr_set_disp_refreshing(&fake_disp);
+    lv_canvas_draw_t * draw = draw_begin(canvas);
+    if(draw == NULL) return;
 
     lv_area_t coords;
     coords.x1 = x;
@@ -627,13 +641,9 @@ void lv_canvas_draw_img(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, const voi
     coords.x2 = x + header.w - 1;
     coords.y2 = y + header.h - 1;
 
-    lv_draw_img(driver.draw_ctx, draw_dsc, &coords, src);
-
-    _lv_refr_set_disp_refreshing(refr_ori);
+    lv_draw_img(draw->drv.draw_ctx, draw_dsc, &coords, src);
 
-    deinit_fake_disp(canvas, &fake_disp);
-
-    lv_obj_invalidate(canvas);
+    draw_end(canvas);
 }
 
 void lv_canvas_draw_line(lv_obj_t * canvas, const lv_point_t points[], uint32_t point_cnt,
@@ -648,34 +658,22 @@ void lv_canvas_draw_line(lv_obj_t * canvas, const lv_point_t points[], uint32_t
         return;
     }
 
-    /*Create a dummy display to fool the lv_draw function.
-     *It will think it draws to real screen.*/
-    lv_disp_t fake_disp;
-    lv_disp_drv_t driver;
-    lv_area_t clip_area;
-    init_fake_disp(canvas, &fake_disp, &driver, &clip_area);
-
-    lv_disp_t * refr_ori = _lv_refr_get_disp_refreshing();
-    _lv_refr_set_disp_refreshing(&fake_disp);
-
+    lv_canvas_draw_t * draw = draw_begin(canvas);
+    if(draw == NULL) return;
 
     /*Disable anti-aliasing if drawing with transparent color to chroma keyed canvas*/
     lv_color_t ctransp = LV_COLOR_CHROMA_KEY;
     if(dsc->header.cf == LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED &&
        draw_dsc->color.full == ctransp.full) {
-        fake_disp.driver->antialiasing = 0;
+        draw->drv.antialiasing = 0;
     }
 
     uint32_t i;
     for(i = 0; i < point_cnt - 1; i++) {
-        lv_draw_line(driver.draw_ctx, draw_dsc, &points[i], &points[i + 1]);
+        lv_draw_line(draw->drv.draw_ctx, draw_dsc, &points[i], &points[i + 1]);
     }
 
-    _lv_refr_set_disp_refreshing(refr_ori);
-
-    deinit_fake_disp(canvas, &fake_disp);
-
-    lv_obj_invalidate(canvas);
+    draw_end(canvas);
 }
 
 void lv_canvas_draw_polygon(lv_obj_t * canvas, const lv_point_t points[], uint32_t point_cnt,
@@ -690,30 +688,18 @@ void lv_canvas_draw_polygon(lv_obj_t * canvas, const lv_point_t points[], uint32
         return;
     }
 
-    /*Create a dummy display to fool the lv_draw function.
-     *It will think it draws to real screen.*/
-    lv_disp_t fake_disp;
-    lv_disp_drv_t driver;
-    lv_area_t clip_area;
-    init_fake_disp(canvas, &fake_disp, &driver, &clip_area);
-
-    lv_disp_t * refr_ori = _lv_refr_get_disp_refreshing();
-    _lv_refr_set_disp_refreshing(&fake_disp);
-
+    lv_canvas_draw_t * draw = draw_begin(canvas);
+    if(draw == NULL) return;
     /*Disable anti-aliasing if drawing with transparent color to chroma keyed canvas*/
     lv_color_t ctransp = LV_COLOR_CHROMA_KEY;
     if(dsc->header.cf == LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED &&
        draw_dsc->bg_color.full == ctransp.full) {
-        fake_disp.driver->antialiasing = 0;
+        draw->drv.antialiasing = 0;
     }
 
-    lv_draw_polygon(driver.draw_ctx, draw_dsc, points, point_cnt);
-
-    _lv_refr_set_disp_refreshing(refr_ori);
-
-    deinit_fake_disp(canvas, &fake_disp);
+    lv_draw_polygon(draw->drv.draw_ctx, draw_dsc, points, point_cnt);
 
-    lv_obj_invalidate(canvas);
+    draw_end(canvas);
 }
 
 void lv_canvas_draw_arc(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord_t r, int32_t start_angle,
@@ -729,24 +715,13 @@ void lv_canvas_draw_arc(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord_
         return;
     }
 
-    /*Create a dummy display to fool the lv_draw function.
-     *It will think it draws to real screen.*/
-    lv_disp_t fake_disp;
-    lv_disp_drv_t driver;
-    lv_area_t clip_area;
-    init_fake_disp(canvas, &fake_disp, &driver, &clip_area);
-
-    lv_disp_t * refr_ori = _lv_refr_get_disp_refreshing();
-    _lv_refr_set_disp_refreshing(&fake_disp);
+    lv_canvas_draw_t * draw = draw_begin(canvas);
+    if(draw == NULL) return;
 
     lv_point_t p = {x, y};
-    lv_draw_arc(driver.draw_ctx, draw_dsc, &p, r,  start_angle, end_angle);
-
-    _lv_refr_set_disp_refreshing(refr_ori);
+    lv_draw_arc(draw->drv.draw_ctx, draw_dsc, &p, r,  start_angle, end_angle);
 
-    deinit_fake_disp(canvas, &fake_disp);
-
-    lv_obj_invalidate(canvas);
+    draw_end(canvas);
 #else
     LV_UNUSED(canvas);
     LV_UNUSED(x);
@@ -776,6 +751,7 @@ static void lv_canvas_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj
     canvas->dsc.header.w           = 0;
     canvas->dsc.data_size          = 0;
     canvas->dsc.data               = NULL;
+    canvas->draw                   = NULL;
 
     lv_img_set_src(obj, &canvas->dsc);
 
@@ -789,48 +765,91 @@ static void lv_canvas_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
 
     lv_canvas_t * canvas = (lv_canvas_t *)obj;
     lv_img_cache_invalidate_src(&canvas->dsc);
+    draw_free(obj);
 }
 
 
-static void init_fake_disp(lv_obj_t * canvas, lv_disp_t * disp, lv_disp_drv_t * drv, lv_area_t * clip_area)
+/**
+ * Get the dummy display of the canvas and make it the refreshing display.
+ * @param canvas    pointer to a canvas object
+ * @return          the dummy display or NULL on error
+ */
+static lv_canvas_draw_t * draw_begin(lv_obj_t * canvas)
 {
-    lv_img_dsc_t * dsc = lv_canvas_get_img(canvas);
+    lv_canvas_t * c = (lv_canvas_t *)canvas;
+    lv_img_dsc_t * dsc = &c->dsc;
+
+    lv_canvas_draw_t * draw = c->draw;
+    if(draw == NULL) {
+        draw = lv_mem_alloc(sizeof(lv_canvas_draw_t));
+        LV_ASSERT_MALLOC(draw);
+        if(draw == NULL) return NULL;
+        lv_memset_00(draw, sizeof(lv_canvas_draw_t));
+
+        draw->clip_area.x1 = 0;
+        draw->clip_area.x2 = dsc->header.w - 1;
+        draw->clip_area.y1 = 0;
+        draw->clip_area.y2 = dsc->header.h - 1;
+
+        draw->disp.driver = &draw->drv;
+        lv_disp_drv_init(&draw->drv);
+        draw->drv.hor_res = dsc->header.w;
+        draw->drv.ver_res = dsc->header.h;
+
+        lv_draw_sw_init_ctx(&draw->drv, &draw->draw_ctx.base_draw);
+        draw->drv.draw_ctx = &draw->draw_ctx.base_draw;
+        draw->draw_ctx.base_draw.buf_area = &draw->clip_area;
+        draw->draw_ctx.base_draw.buf = (void *)dsc->data;
+
+        lv_disp_drv_use_generic_set_px_cb(&draw->drv, dsc->header.cf);
+        if(LV_COLOR_SCREEN_TRANSP && dsc->header.cf != LV_IMG_CF_TRUE_COLOR_ALPHA) {
+            draw->drv.screen_transp = 0;
+        }
+        draw->antialiasing = draw->drv.antialiasing;
+        c->draw = draw;
+    }
 
-    clip_area->x1 = 0;
-    clip_area->x2 = dsc->header.w - 1;
-    clip_area->y1 = 0;
-    clip_area->y2 = dsc->header.h - 1;
-
-    /*Allocate the fake driver on the stack as the entire display doesn't outlive this function*/
-    lv_memset_00(disp, sizeof(lv_disp_t));
-    disp->driver = drv;
-
-    lv_disp_drv_init(disp->driver);
-    disp->driver->hor_res = dsc->header.w;
-    disp->driver->ver_res = dsc->header.h;
-
-    lv_draw_ctx_t * draw_ctx = lv_mem_alloc(sizeof(lv_draw_sw_ctx_t));
-    LV_ASSERT_MALLOC(draw_ctx);
-    if(draw_ctx == NULL)  return;
-    lv_draw_sw_init_ctx(drv, draw_ctx);
-    disp->driver->draw_ctx = draw_ctx;
-    draw_ctx->clip_area = clip_area;
-    draw_ctx->buf_area = clip_area;
-    draw_ctx->buf = (void *)dsc->data;
-
-    lv_disp_drv_use_generic_set_px_cb(disp->driver, dsc->header.cf);
-    if(LV_COLOR_SCREEN_TRANSP && dsc->header.cf != LV_IMG_CF_TRUE_COLOR_ALPHA) {
-        drv->screen_transp = 0;
+    if(draw->begin_cnt == 0) {
+        draw->refr_ori = _lv_refr_get_disp_refreshing();
+        _lv_refr_set_disp_refreshing(&draw->disp);
     }
+    draw->begin_cnt++;
+
+    /*Undo the changes of the previous drawing*/
+    draw->draw_ctx.base_draw.clip_area = &draw->clip_area;
+    draw->drv.antialiasing = draw->antialiasing;
+
+    return draw;
 }
 
-static void deinit_fake_disp(lv_obj_t * canvas, lv_disp_t * disp)
+/**
+ * Restore the refreshing display and invalidate the canvas if it's the last `draw_begin`
+ * @param canvas    pointer to a canvas object
+ */
+static void draw_end(lv_obj_t * canvas)
 {
-    LV_UNUSED(canvas);
-    lv_draw_sw_deinit_ctx(disp->driver, disp->driver->draw_ctx);
-    lv_mem_free(disp->driver->draw_ctx);
+    lv_canvas_draw_t * draw = ((lv_canvas_t *)canvas)->draw;
+    draw->drv.antialiasing = draw->antialiasing;
+
+    draw->begin_cnt--;
+    if(draw->begin_cnt == 0) {
+        _lv_refr_set_disp_refreshing(draw->refr_ori);
+        lv_obj_invalidate(canvas);
+    }
 }
 
+static void draw_free(lv_obj_t * canvas)
+{
+    lv_canvas_t * c = (lv_canvas_t *)canvas;
+    if(c->draw == NULL) return;
 
+    if(c->draw->begin_cnt) {
+        LV_LOG_WARN("the canvas is being drawn");
+        _lv_refr_set_disp_refreshing(c->draw->refr_ori);
+    }
+    lv_draw_sw_deinit_ctx(&c->draw->drv, &c->draw->draw_ctx.base_draw);
+    lv_mem_free(c->draw);
+    c->draw = NULL;
+}
 
 #endif
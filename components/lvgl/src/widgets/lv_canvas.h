@@ -30,10 +30,13 @@ extern "C" {
  **********************/
 extern const lv_obj_class_t lv_canvas_class;
 
+struct _lv_canvas_draw_t;
+
 /*Data of canvas*/
 typedef struct {
     lv_img_t img;
     lv_img_dsc_t dsc;
+    struct _lv_canvas_draw_t * draw;    /*Draw context reused by the drawing functions*/
 } lv_canvas_t;
 
 /**********************
@@ -184,6 +187,22 @@ void lv_canvas_blur_ver(lv_obj_t * canvas, const lv_area_t * area, uint16_t r);
  */
 void lv_canvas_fill_bg(lv_obj_t * canvas, lv_color_t color, lv_opa_t opa);
 
+/**
+ * Start drawing many primitives to the canvas.
+ * Until `lv_canvas_draw_end` the `lv_canvas_draw_...` functions don't invalidate the canvas,
+ * and the `lv_draw_...` functions can be called directly with the returned draw context.
+ * LVGL shouldn't refresh a display (e.g. `lv_timer_handler` shouldn't run) until `lv_canvas_draw_end`.
+ * @param canvas    pointer to a canvas object
+ * @return          the draw context of the canvas or NULL on error
+ */
+lv_draw_ctx_t * lv_canvas_draw_begin(lv_obj_t * canvas);
+
+/**
+ * Finish drawing started with `lv_canvas_draw_begin` and invalidate the canvas
+ * @param canvas    pointer to a canvas object
+ */
+void lv_canvas_draw_end(lv_obj_t * canvas);
+
 /**
  * Draw a rectangle on the canvas
  * @param canvas   pointer to a canvas object
@@ -32,6 +32,15 @@
  *      TYPEDEFS
  **********************/
 
+/*Properties of the text used to find the changed glyphs*/
+typedef struct {
+    const lv_font_t * font;
+    lv_coord_t letter_space;
+    lv_coord_t max_w;           /*Width of the text area*/
+    lv_coord_t x;               /*Left side of the lines*/
+    lv_text_align_t align;
+} text_diff_dsc_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -41,7 +50,20 @@ static void lv_label_event(const lv_obj_class_t * class_p, lv_event_t * e);
 static void draw_main(lv_event_t * e);
 
 static void lv_label_refr_text(lv_obj_t * obj);
+static void lv_label_refr_text_core(lv_obj_t * obj);
 static void lv_label_revert_dots(lv_obj_t * label);
+static void lv_label_free_text(lv_obj_t * obj);
+static void lv_label_replace_text(lv_obj_t * obj, char * new_txt);
+static char * lv_label_get_fixed_buf(lv_obj_t * obj);
+static char * lv_label_get_fixed_back(lv_obj_t * obj);
+static void lv_label_copy_fixed(char * dst, const char * src, uint32_t cap);
+static void lv_label_trim_fixed(char * txt, uint32_t len);
+static void lv_label_swap_fixed(lv_obj_t * obj);
+static void lv_label_invalidate_change(lv_obj_t * obj, const char * old_txt);
+static void invalidate_line_change(lv_obj_t * obj, const text_diff_dsc_t * dsc, const char * old_line,
+                                   uint32_t old_len, const char * new_line, uint32_t new_len, lv_coord_t y);
+static lv_coord_t add_glyph_boxes(const text_diff_dsc_t * dsc, const char * line, uint32_t from, uint32_t to,
+                                  lv_coord_t x, lv_coord_t y, lv_area_t * area);
 
 static bool lv_label_set_dot_tmp(lv_obj_t * label, char * data, uint32_t len);
 static char * lv_label_get_dot_tmp(lv_obj_t * label);
@@ -87,12 +109,23 @@ void lv_label_set_text(lv_obj_t * obj, const char * text)
     LV_ASSERT_OBJ(obj, MY_CLASS);
     lv_label_t * label = (lv_label_t *)obj;
 
-    lv_obj_invalidate(obj);
+    /*In fixed capacity mode write the text into the unused half of the buffer*/
+    if(label->text_cap != 0 && text != NULL && text != label->text) {
+        lv_label_copy_fixed(lv_label_get_fixed_back(obj), text, label->text_cap);
+        lv_label_swap_fixed(obj);
+        return;
+    }
 
     /*If text is NULL then just refresh with the current text*/
     if(text == NULL) text = label->text;
 
-    if(label->text == text && label->static_txt == 0) {
+    if(label->text == text && label->text_cap != 0) {
+        /*The fixed capacity buffer is never reallocated, just refresh*/
+        lv_obj_invalidate(obj);
+    }
+    else if(label->text == text && label->static_txt == 0) {
+        lv_obj_invalidate(obj);
+
         /*If set its own text then reallocate it (maybe its size changed)*/
 #if LV_USE_ARABIC_PERSIAN_CHARS
         /*Get the size of the text and process it*/
@@ -111,34 +144,28 @@ void lv_label_set_text(lv_obj_t * obj, const char * text)
         if(label->text == NULL) return;
     }
     else {
-        /*Free the old text*/
-        if(label->text != NULL && label->static_txt == 0) {
-            lv_mem_free(label->text);
-            label->text = NULL;
-        }
-
 #if LV_USE_ARABIC_PERSIAN_CHARS
         /*Get the size of the text and process it*/
         size_t len = _lv_txt_ap_calc_bytes_cnt(text);
 
-        label->text = lv_mem_alloc(len);
-        LV_ASSERT_MALLOC(label->text);
-        if(label->text == NULL) return;
+        char * new_txt = lv_mem_alloc(len);
+        LV_ASSERT_MALLOC(new_txt);
+        if(new_txt == NULL) return;
 
-        _lv_txt_ap_proc(text, label->text);
+        _lv_txt_ap_proc(text, new_txt);
 #else
         /*Get the size of the text*/
         size_t len = strlen(text) + 1;
 
         /*Allocate space for the new text*/
-        label->text = lv_mem_alloc(len);
-        LV_ASSERT_MALLOC(label->text);
-        if(label->text == NULL) return;
-        strcpy(label->text, text);
+        char * new_txt = lv_mem_alloc(len);
+        LV_ASSERT_MALLOC(new_txt);
+        if(new_txt == NULL) return;
+        strcpy(new_txt, text);
 #endif
 
-        /*Now the text is dynamically allocated*/
-        label->static_txt = 0;
+        lv_label_replace_text(obj, new_txt);
+        return;
     }
 
     lv_label_refr_text(obj);
@@ -149,27 +176,36 @@ void lv_label_set_text_fmt(lv_obj_t * obj, const char * fmt, ...)
     LV_ASSERT_OBJ(obj, MY_CLASS);
     LV_ASSERT_NULL(fmt);
 
-    lv_obj_invalidate(obj);
     lv_label_t * label = (lv_label_t *)obj;
 
+    /*In fixed capacity mode format the text directly into the unused half of the buffer*/
+    if(fmt != NULL && label->text_cap != 0) {
+        char * back = lv_label_get_fixed_back(obj);
+        va_list args;
+        va_start(args, fmt);
+        int len = lv_vsnprintf(back, label->text_cap, fmt, args);
+        va_end(args);
+        if(len < 0) back[0] = '\0';
+        else if((uint32_t)len >= label->text_cap) lv_label_trim_fixed(back, label->text_cap - 1);
+
+        lv_label_swap_fixed(obj);
+        return;
+    }
+
     /*If text is NULL then refresh*/
     if(fmt == NULL) {
+        lv_obj_invalidate(obj);
         lv_label_refr_text(obj);
         return;
     }
 
-    if(label->text != NULL && label->static_txt == 0) {
-        lv_mem_free(label->text);
-        label->text = NULL;
-    }
-
     va_list args;
     va_start(args, fmt);
-    label->text = _lv_txt_set_text_vfmt(fmt, args);
+    char * new_txt = _lv_txt_set_text_vfmt(fmt, args);
     va_end(args);
-    label->static_txt = 0; /*Now the text is dynamically allocated*/
+    if(new_txt == NULL) return;
 
-    lv_label_refr_text(obj);
+    lv_label_replace_text(obj, new_txt);
 }
 
 void lv_label_set_text_static(lv_obj_t * obj, const char * text)
@@ -177,10 +213,7 @@ void lv_label_set_text_static(lv_obj_t * obj, const char * text)
     LV_ASSERT_OBJ(obj, MY_CLASS);
     lv_label_t * label = (lv_label_t *)obj;
 
-    if(label->static_txt == 0 && label->text != NULL) {
-        lv_mem_free(label->text);
-        label->text = NULL;
-    }
+    lv_label_free_text(obj);
 
     if(text != NULL) {
         label->static_txt = 1;
@@ -190,6 +223,42 @@ void lv_label_set_text_static(lv_obj_t * obj, const char * text)
     lv_label_refr_text(obj);
 }
 
+void lv_label_set_text_capacity(lv_obj_t * obj, uint32_t capacity)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+    lv_label_t * label = (lv_label_t *)obj;
+
+    if(capacity == label->text_cap) return;
+
+    /*Keep the current text without the dots*/
+    lv_label_revert_dots(obj);
+    const char * text = label->text ? label->text : "";
+
+    char * buf;
+    if(capacity == 0) {
+        buf = lv_mem_alloc(strlen(text) + 1);
+        LV_ASSERT_MALLOC(buf);
+        if(buf == NULL) return;
+        strcpy(buf, text);
+    }
+    else {
+        /*Two halves: the current text and the place of the next one*/
+        buf = lv_mem_alloc(2 * (size_t)capacity);
+        LV_ASSERT_MALLOC(buf);
+        if(buf == NULL) return;
+        lv_label_copy_fixed(buf, text, capacity);
+    }
+
+    lv_label_free_text(obj);
+    label->text = buf;
+    label->text_cap = capacity;
+    label->text_2nd = 0;
+    label->static_txt = 0;
+
+    lv_obj_invalidate(obj);
+    lv_label_refr_text(obj);
+}
+
 void lv_label_set_long_mode(lv_obj_t * obj, lv_label_long_mode_t long_mode)
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
@@ -283,6 +352,14 @@ bool lv_label_get_recolor(const lv_obj_t * obj)
     return label->recolor == 0 ? false : true;
 }
 
+uint32_t lv_label_get_text_capacity(const lv_obj_t * obj)
+{
+    LV_ASSERT_OBJ(obj, MY_CLASS);
+
+    lv_label_t * label = (lv_label_t *)obj;
+    return label->text_cap;
+}
+
 void lv_label_get_letter_pos(const lv_obj_t * obj, uint32_t char_id, lv_point_t * pos)
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
@@ -645,6 +722,24 @@ void lv_label_ins_text(lv_obj_t * obj, uint32_t pos, const char * txt)
     /*Can not append to static text*/
     if(label->static_txt != 0) return;
 
+    /*Insert into a copy in the unused half of the fixed buffer*/
+    if(label->text_cap != 0) {
+        if(strlen(label->text) + strlen(txt) + 1 > label->text_cap) {
+            LV_LOG_WARN("the text doesn't fit into the fixed capacity");
+            return;
+        }
+
+        char * back = lv_label_get_fixed_back(obj);
+        strcpy(back, label->text);
+        if(pos == LV_LABEL_POS_LAST) {
+            pos = _lv_txt_get_encoded_length(back);
+        }
+
+        _lv_txt_ins(back, pos, txt);
+        lv_label_swap_fixed(obj);
+        return;
+    }
+
     lv_obj_invalidate(obj);
 
     /*Allocate space for the new text*/
@@ -712,6 +807,8 @@ static void lv_label_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
 #endif
     label->dot.tmp_ptr   = NULL;
     label->dot_tmp_alloc = 0;
+    label->text_cap      = 0;
+    label->text_2nd      = 0;
 
     lv_obj_clear_flag(obj, LV_OBJ_FLAG_CLICKABLE);
     lv_label_set_long_mode(obj, LV_LABEL_LONG_WRAP);
@@ -727,7 +824,7 @@ static void lv_label_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
     lv_label_t * label = (lv_label_t *)obj;
 
     lv_label_dot_tmp_free(obj);
-    if(!label->static_txt) lv_mem_free(label->text);
+    lv_label_free_text(obj);
     label->text = NULL;
 }
 
@@ -896,6 +993,19 @@ static void lv_label_refr_text(lv_obj_t * obj)
 {
     lv_label_t * label = (lv_label_t *)obj;
     if(label->text == NULL) return;
+
+    lv_label_refr_text_core(obj);
+    lv_obj_invalidate(obj);
+}
+
+/**
+ * Update the size, the scrolling and the dots of the label according to its text
+ * but leave the invalidation to the caller
+ * @param label pointer to a label object
+ */
+static void lv_label_refr_text_core(lv_obj_t * obj)
+{
+    lv_label_t * label = (lv_label_t *)obj;
 #if LV_LABEL_LONG_TXT_HINT
     label->hint.line_start = -1; /*The hint is invalid if the text changes*/
 #endif
@@ -1164,8 +1274,6 @@ static void lv_label_refr_text(lv_obj_t * obj)
     else if(label->long_mode == LV_LABEL_LONG_CLIP) {
         /*Do nothing*/
     }
-
-    lv_obj_invalidate(obj);
 }
 
 
@@ -1256,6 +1364,342 @@ static void lv_label_dot_tmp_free(lv_obj_t * obj)
 }
 
 
+static void lv_label_free_text(lv_obj_t * obj)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+
+    if(label->text != NULL && label->static_txt == 0) {
+        lv_mem_free(label->text_cap != 0 ? lv_label_get_fixed_buf(obj) : label->text);
+        label->text = NULL;
+    }
+
+    label->text_cap = 0;
+    label->text_2nd = 0;
+}
+
+/**
+ * Use a newly allocated text and free the old one.
+ * If the old text was allocated by the label too, redraw only the changed glyphs.
+ * @param label pointer to label object not in fixed capacity mode
+ * @param new_txt the new text allocated with `lv_mem_alloc`
+ */
+static void lv_label_replace_text(lv_obj_t * obj, char * new_txt)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+
+    /*A static text might have been modified since it was drawn so it can't be compared*/
+    char * old_txt = label->static_txt == 0 ? label->text : NULL;
+
+    label->text = new_txt;
+    label->static_txt = 0;      /*Now the text is dynamically allocated*/
+
+    lv_label_refr_text_core(obj);
+
+    if(old_txt) {
+        lv_label_invalidate_change(obj, old_txt);
+        lv_mem_free(old_txt);
+    }
+    else {
+        lv_obj_invalidate(obj);
+    }
+}
+
+/**
+ * Get the start of the fixed capacity buffer
+ * @param label pointer to label object in fixed capacity mode
+ * @return pointer to the buffer. It has to be freed instead of the text.
+ */
+static char * lv_label_get_fixed_buf(lv_obj_t * obj)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    return label->text_2nd ? label->text - label->text_cap : label->text;
+}
+
+/**
+ * Get the half of the fixed capacity buffer which doesn't store the current text
+ * @param label pointer to label object in fixed capacity mode
+ * @return pointer to `text_cap` bytes where the next text can be written
+ */
+static char * lv_label_get_fixed_back(lv_obj_t * obj)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    return label->text_2nd ? label->text - label->text_cap : label->text + label->text_cap;
+}
+
+/**
+ * Copy a text into a fixed capacity buffer and truncate it if it's too long
+ * @param dst pointer to a buffer
+ * @param src the text to copy
+ * @param cap size of `dst` in bytes
+ */
+static void lv_label_copy_fixed(char * dst, const char * src, uint32_t cap)
+{
+    size_t len = strlen(src);
+    if(len < cap) {
+        lv_memcpy(dst, src, len + 1);
+        return;
+    }
+
+    lv_memcpy(dst, src, cap - 1);
+    dst[cap - 1] = '\0';
+    lv_label_trim_fixed(dst, cap - 1);
+}
+
+/**
+ * Remove the last letter of a truncated text if it was cut in the middle
+ * @param txt pointer to a text truncated to `len` bytes
+ * @param len length of the text in bytes
+ */
+static void lv_label_trim_fixed(char * txt, uint32_t len)
+{
+#if LV_TXT_ENC == LV_TXT_ENC_UTF8
+    /*Find the first byte of the last letter*/
+    uint32_t i = len;
+    while(i > 0 && (txt[i - 1] & 0xC0) == 0x80) i--;
+    if(i == 0) return;
+    i--;
+
+    if(i + _lv_txt_encoded_size(&txt[i]) > len) txt[i] = '\0';
+#else
+    LV_UNUSED(txt);
+    LV_UNUSED(len);
+#endif
+}
+
+/**
+ * Make the text written into the unused half of the fixed buffer the current text
+ * and redraw only the changed part
+ * @param label pointer to label object in fixed capacity mode
+ */
+static void lv_label_swap_fixed(lv_obj_t * obj)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    char * back = lv_label_get_fixed_back(obj);
+
+#if LV_USE_ARABIC_PERSIAN_CHARS
+    /*Process in place if there are Arabic letters (U+0600...U+06FF) and the result fits.
+     *Check it first because the processing allocates memory.*/
+    const uint8_t * c = (const uint8_t *)back;
+    while(*c != '\0' && (*c < 0xD8 || *c > 0xDB)) c++;
+    if(*c != '\0' && _lv_txt_ap_calc_bytes_cnt(back) <= label->text_cap) _lv_txt_ap_proc(back, back);
+#endif
+
+    /*Nothing to redraw if the text is the same*/
+    if(strcmp(back, label->text) == 0) return;
+
+    char * old_txt = label->text;
+    label->text = back;
+    label->text_2nd = !label->text_2nd;
+
+    lv_label_refr_text_core(obj);
+    lv_label_invalidate_change(obj, old_txt);
+}
+
+/**
+ * Invalidate only the glyphs which differ from the old text.
+ * Invalidate the whole label if the text is not drawn line by line from its coordinates.
+ * @param label pointer to label object
+ * @param old_txt the previous text of the label
+ */
+static void lv_label_invalidate_change(lv_obj_t * obj, const char * old_txt)
+{
+    lv_label_t * label = (lv_label_t *)obj;
+    const char * new_txt = label->text;
+
+    /*Scrolling, dots, recoloring, selection and decoration change more than the glyphs*/
+    bool simple = (label->long_mode == LV_LABEL_LONG_WRAP || label->long_mode == LV_LABEL_LONG_CLIP) &&
+                  label->recolor == 0 && label->expand == 0 &&
+                  lv_obj_get_style_text_decor(obj, LV_PART_MAIN) == LV_TEXT_DECOR_NONE;
+#if LV_LABEL_TEXT_SELECTION
+    if(label->sel_start != LV_DRAW_LABEL_NO_TXT_SEL || label->sel_end != LV_DRAW_LABEL_NO_TXT_SEL) simple = false;
+#endif
+
+    text_diff_dsc_t dsc;
+    dsc.align = lv_obj_get_style_text_align(obj, LV_PART_MAIN);
+    lv_base_dir_t base_dir = lv_obj_get_style_base_dir(obj, LV_PART_MAIN);
+    lv_bidi_calculate_align(&dsc.align, &base_dir, new_txt);
+#if LV_USE_BIDI
+    /*Right-to-left letters might be reordered. All of them are above U+0590 so check the first bytes.*/
+    if(base_dir == LV_BASE_DIR_RTL) simple = false;
+    const char * txts[2] = {old_txt, new_txt};
+    uint32_t t;
+    for(t = 0; t < 2 && simple; t++) {
+        const uint8_t * c;
+        for(c = (const uint8_t *)txts[t]; *c != '\0'; c++) {
+            if(*c >= 0xD6) {
+                simple = false;
+                break;
+            }
+        }
+    }
+#endif
+
+    if(!simple) {
+        lv_obj_invalidate(obj);
+        return;
+    }
+
+    lv_area_t txt_coords;
+    lv_obj_get_content_coords(obj, &txt_coords);
+    dsc.font = lv_obj_get_style_text_font(obj, LV_PART_MAIN);
+    dsc.letter_space = lv_obj_get_style_text_letter_space(obj, LV_PART_MAIN);
+    dsc.max_w = lv_area_get_width(&txt_coords);
+    dsc.x = txt_coords.x1 + label->offset.x;
+    lv_coord_t line_space = lv_obj_get_style_text_line_space(obj, LV_PART_MAIN);
+    lv_coord_t line_h = lv_font_get_line_height(dsc.font) + line_space;
+
+    lv_text_flag_t flag = LV_TEXT_FLAG_NONE;
+    if(lv_obj_get_style_width(obj, LV_PART_MAIN) == LV_SIZE_CONTENT && !obj->w_layout) flag |= LV_TEXT_FLAG_FIT;
+
+    lv_coord_t y = txt_coords.y1 + label->offset.y;
+    if(label->long_mode == LV_LABEL_LONG_WRAP) y -= lv_obj_get_scroll_top(obj);
+
+    /*Compare the texts line by line. The lines below the label are not drawn.*/
+    lv_coord_t y_max = obj->coords.y2 + _lv_obj_get_ext_draw_size(obj);
+    uint32_t old_start = 0;
+    uint32_t new_start = 0;
+    while((old_txt[old_start] != '\0' || new_txt[new_start] != '\0') && y <= y_max) {
+        uint32_t old_len = _lv_txt_get_next_line(&old_txt[old_start], dsc.font, dsc.letter_space, dsc.max_w, NULL, flag);
+        uint32_t new_len = _lv_txt_get_next_line(&new_txt[new_start], dsc.font, dsc.letter_space, dsc.max_w, NULL, flag);
+        if(old_len == 0 && new_len == 0) break;
+
+        invalidate_line_change(obj, &dsc, &old_txt[old_start], old_len, &new_txt[new_start], new_len, y);
+
+        old_start += old_len;
+        new_start += new_len;
+        y += line_h;
+    }
+}
+
+/**
+ * Invalidate the boxes of the glyphs which differ in two versions of a line.
+ * The common beginning and end of the lines are not invalidated if they are drawn to the same place.
+ * @param label pointer to label object
+ * @param dsc properties of the text
+ * @param old_line the line in the old text
+ * @param old_len length of the old line in bytes
+ * @param new_line the line in the new text
+ * @param new_len length of the new line in bytes
+ * @param y top of the line
+ */
+static void invalidate_line_change(lv_obj_t * obj, const text_diff_dsc_t * dsc, const char * old_line,
+                                   uint32_t old_len, const char * new_line, uint32_t new_len, lv_coord_t y)
+{
+    if(old_len == new_len && memcmp(old_line, new_line, old_len) == 0) return;
+
+    /*Skip the common beginning and end*/
+    uint32_t pre = 0;
+    while(pre < old_len && pre < new_len && old_line[pre] == new_line[pre]) pre++;
+
+    uint32_t suf = 0;
+    while(suf < old_len - pre && suf < new_len - pre &&
+          old_line[old_len - 1 - suf] == new_line[new_len - 1 - suf]) suf++;
+
+#if LV_TXT_ENC == LV_TXT_ENC_UTF8
+    /*Don't cut letters*/
+    while(pre > 0 && (new_line[pre] & 0xC0) == 0x80) pre--;
+    while(suf > 0 && (new_line[new_len - suf] & 0xC0) == 0x80) suf--;
+#endif
+
+    /*Aligned lines move if their width changes*/
+    lv_coord_t old_x = dsc->x;
+    lv_coord_t new_x = dsc->x;
+    if(dsc->align == LV_TEXT_ALIGN_CENTER || dsc->align == LV_TEXT_ALIGN_RIGHT) {
+        lv_coord_t old_w = lv_txt_get_width(old_line, old_len, dsc->font, dsc->letter_space, LV_TEXT_FLAG_NONE);
+        lv_coord_t new_w = lv_txt_get_width(new_line, new_len, dsc->font, dsc->letter_space, LV_TEXT_FLAG_NONE);
+        if(dsc->align == LV_TEXT_ALIGN_CENTER) {
+            old_x += (dsc->max_w - old_w) / 2;
+            new_x += (dsc->max_w - new_w) / 2;
+        }
+        else {
+            old_x += dsc->max_w - old_w;
+            new_x += dsc->max_w - new_w;
+        }
+    }
+
+    /*The common beginning stays in place only if the line hasn't moved
+     *and the common end only if it starts at the same position*/
+    if(old_x != new_x) pre = 0;
+    if(suf > 0) {
+        lv_coord_t old_suf_x = add_glyph_boxes(dsc, old_line, old_len - suf, old_len - suf, old_x, y, NULL);
+        lv_coord_t new_suf_x = add_glyph_boxes(dsc, new_line, new_len - suf, new_len - suf, new_x, y, NULL);
+        if(old_suf_x != new_suf_x) suf = 0;
+    }
+
+    lv_area_t a;
+    a.x1 = LV_COORD_MAX;
+    a.y1 = LV_COORD_MAX;
+    a.x2 = LV_COORD_MIN;
+    a.y2 = LV_COORD_MIN;
+    add_glyph_boxes(dsc, old_line, pre, old_len - suf, old_x, y, &a);
+    add_glyph_boxes(dsc, new_line, pre, new_len - suf, new_x, y, &a);
+
+    /*E.g. only spaces have changed*/
+    if(a.x1 > a.x2) return;
+
+    lv_obj_invalidate_area(obj, &a);
+}
+
+/**
+ * Go through the glyphs of a line the same way `lv_draw_label` does
+ * and add the area of the glyphs in `[from, to)` to an area.
+ * @param dsc properties of the text
+ * @param line pointer to the start of a line
+ * @param from byte index of the first glyph to add
+ * @param to byte index after the last glyph to add
+ * @param x the x coordinate of the first glyph of the line
+ * @param y the top of the line
+ * @param area increase this area with the glyphs. NULL to just get the position.
+ * @return the x coordinate of the glyph at `to`
+ */
+static lv_coord_t add_glyph_boxes(const text_diff_dsc_t * dsc, const char * line, uint32_t from, uint32_t to,
+                                  lv_coord_t x, lv_coord_t y, lv_area_t * area)
+{
+    const lv_font_t * font = dsc->font;
+
+    uint32_t i = 0;
+    while(i < to) {
+        uint32_t i_act = i;
+        uint32_t letter;
+        uint32_t letter_next;
+        _lv_txt_encoded_letter_next_2(line, &letter, &letter_next, &i);
+
+        if(area && i_act >= from) {
+            lv_font_glyph_dsc_t g;
+            lv_area_t box;
+            bool found = lv_font_get_glyph_dsc(font, &g, letter, '\0');
+            if(found && g.box_w > 0 && g.box_h > 0) {
+                box.x1 = x + g.ofs_x;
+                box.x2 = box.x1 + g.box_w - 1;
+                box.y1 = y + (font->line_height - font->base_line) - g.box_h - g.ofs_y;
+                box.y2 = box.y1 + g.box_h - 1;
+            }
+            else if(!found && g.box_w > 0) {
+                /*The placeholder of a missing glyph*/
+                box.x1 = x;
+                box.x2 = x + g.box_w;
+                box.y1 = y;
+                box.y2 = y + g.box_h;
+            }
+            else {
+                box.x1 = LV_COORD_MAX;
+            }
+
+            if(box.x1 != LV_COORD_MAX) {
+                area->x1 = LV_MIN(area->x1, box.x1);
+                area->y1 = LV_MIN(area->y1, box.y1);
+                area->x2 = LV_MAX(area->x2, box.x2);
+                area->y2 = LV_MAX(area->y2, box.y2);
+            }
+        }
+
+        lv_coord_t letter_w = lv_font_get_glyph_width(font, letter, letter_next);
+        if(letter_w > 0) x += letter_w + dsc->letter_space;
+    }
+
+    return x;
+}
+
 static void set_ofs_x_anim(void * obj, int32_t v)
 {
     lv_label_t * label = (lv_label_t *)obj;
@@ -74,6 +74,8 @@ typedef struct {
     uint8_t recolor : 1;                /*Enable in-line letter re-coloring*/
     uint8_t expand : 1;                 /*Ignore real width (used by the library with LV_LABEL_LONG_SCROLL)*/
     uint8_t dot_tmp_alloc : 1;         /*1: dot is allocated, 0: dot directly holds up to 4 chars*/
+    uint8_t text_2nd : 1;               /*In fixed capacity mode 1: the text is in the 2nd half of the buffer*/
+    uint32_t text_cap;                  /*Capacity of the fixed text buffer in bytes, 0: allocate the text as needed*/
 } lv_label_t;
 
 extern const lv_obj_class_t lv_label_class;
@@ -94,14 +96,17 @@ lv_obj_t * lv_label_create(lv_obj_t * parent);
  *====================*/
 
 /**
- * Set a new text for a label. Memory will be allocated to store the text by the label.
+ * Set a new text for a label. Memory will be allocated to store the text by the label
+ * unless it has a fixed capacity buffer (see `lv_label_set_text_capacity`).
+ * Only the glyphs which differ from the previous text are redrawn.
  * @param obj           pointer to a label object
  * @param text          '\0' terminated character string. NULL to refresh with the current text.
  */
 void lv_label_set_text(lv_obj_t * obj, const char * text);
 
 /**
- * Set a new formatted text for a label. Memory will be allocated to store the text by the label.
+ * Set a new formatted text for a label. Memory will be allocated to store the text by the label
+ * unless it has a fixed capacity buffer. In this case the text is formatted directly into it.
  * @param obj           pointer to a label object
  * @param fmt           `printf`-like format
  * @example lv_label_set_text_fmt(label1, "%d user", user_num);
@@ -116,6 +121,19 @@ void lv_label_set_text_fmt(lv_obj_t * obj, const char * fmt, ...) LV_FORMAT_ATTR
  */
 void lv_label_set_text_static(lv_obj_t * obj, const char * text);
 
+/**
+ * Allocate a fixed capacity buffer once and keep the text in it.
+ * After this `lv_label_set_text` and `lv_label_set_text_fmt` don't allocate memory,
+ * longer texts are truncated, and setting the same text again does nothing.
+ * On single line texts only the changed glyphs are redrawn.
+ * Useful for labels showing frequently updated values.
+ * @param obj           pointer to a label object
+ * @param capacity      maximal size of the text in bytes including the closing '\0'.
+ *                      0: leave the fixed capacity mode and allocate the text as needed again.
+ * @note                `2 * capacity` bytes are allocated as the new text is compared to the old one
+ */
+void lv_label_set_text_capacity(lv_obj_t * obj, uint32_t capacity);
+
 /**
  * Set the behavior of the label with longer text then the object size
  * @param obj           pointer to a label object
@@ -171,6 +189,13 @@ lv_label_long_mode_t lv_label_get_long_mode(const lv_obj_t * obj);
  */
 bool lv_label_get_recolor(const lv_obj_t * obj);
 
+/**
+ * Get the capacity of the fixed text buffer
+ * @param obj       pointer to a label object
+ * @return          the capacity in bytes or 0 if the label is not in fixed capacity mode
+ */
+uint32_t lv_label_get_text_capacity(const lv_obj_t * obj);
+
 /**
  * Get the relative x and y coordinates of a letter
  * @param obj       pointer to a label object
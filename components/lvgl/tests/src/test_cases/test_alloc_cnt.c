@@ -0,0 +1,377 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+#include "../src/misc/lv_ilist.h"
+#include "../src/misc/lv_gc.h"
+
+#include "unity/unity.h"
+#include "lv_test_helpers.h"
+#include "lv_test_indev.h"
+
+void setUp(void);
+void tearDown(void);
+void test_ilist(void);
+void test_ilist_release_chunks(void);
+void test_timer_no_alloc(void);
+void test_anim_no_alloc(void);
+void test_child_array_growth(void);
+void test_child_array_inline(void);
+void test_screen_rebuild(void);
+
+typedef struct {
+    uint32_t value;
+    lv_ilist_node_t node;
+} item_t;
+
+static uint32_t anim_value;
+
+static uint32_t get_alloc_cnt(void)
+{
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.alloc_cnt;
+}
+
+static void timer_cb(lv_timer_t * t)
+{
+    LV_UNUSED(t);
+}
+
+static void anim_exec_cb(void * var, int32_t v)
+{
+    LV_UNUSED(var);
+    anim_value = v;
+}
+
+static void build_screen(lv_obj_t * scr)
+{
+    uint32_t i;
+    lv_obj_t * list = lv_list_create(scr);
+    lv_obj_set_size(list, lv_pct(50), lv_pct(100));
+    for(i = 0; i < 20; i++) {
+        lv_list_add_btn(list, LV_SYMBOL_FILE, "Item");
+    }
+
+    lv_obj_t * cont = lv_obj_create(scr);
+    lv_obj_set_size(cont, lv_pct(50), lv_pct(100));
+    lv_obj_align(cont, LV_ALIGN_RIGHT_MID, 0, 0);
+    lv_obj_set_flex_flow(cont, LV_FLEX_FLOW_ROW_WRAP);
+    for(i = 0; i < 20; i++) {
+        lv_obj_t * btn = lv_btn_create(cont);
+        lv_label_set_text(lv_label_create(btn), "Button");
+    }
+
+    lv_slider_create(cont);
+    lv_switch_create(cont);
+}
+
+void setUp(void)
+{
+    /* Function run before every test */
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_ilist(void)
+{
+    lv_ilist_t list;
+    _lv_ilist_init(&list, sizeof(item_t), offsetof(item_t, node), 4);
+    TEST_ASSERT_TRUE(_lv_ilist_is_empty(&list));
+
+    uint32_t i;
+    for(i = 0; i < 10; i++) {
+        item_t * item = _lv_ilist_alloc(&list);
+        TEST_ASSERT_NOT_NULL(item);
+        item->value = i;
+        if(i % 2) _lv_ilist_ins_head(&list, item);
+        else _lv_ilist_ins_tail(&list, item);
+    }
+
+    /*9, 7, 5, 3, 1, 0, 2, 4, 6, 8*/
+    const uint32_t order[] = {9, 7, 5, 3, 1, 0, 2, 4, 6, 8};
+    item_t * item;
+    i = 0;
+    _LV_ILIST_READ(&list, item) {
+        TEST_ASSERT_EQUAL(order[i], item->value);
+        i++;
+    }
+    TEST_ASSERT_EQUAL(10, i);
+
+    /*Remove the head, the tail and one in the middle*/
+    item_t * head = _lv_ilist_get_head(&list);
+    item_t * tail = _lv_ilist_get_tail(&list);
+    item_t * mid = _lv_ilist_get_next(&list, _lv_ilist_get_next(&list, head));
+    _lv_ilist_remove(&list, head);
+    _lv_ilist_remove(&list, tail);
+    _lv_ilist_remove(&list, mid);
+    _lv_ilist_free(&list, head);
+    _lv_ilist_free(&list, tail);
+    _lv_ilist_free(&list, mid);
+
+    const uint32_t order_back[] = {6, 4, 2, 0, 1, 3, 7};
+    i = 0;
+    _LV_ILIST_READ_BACK(&list, item) {
+        TEST_ASSERT_EQUAL(order_back[i], item->value);
+        i++;
+    }
+    TEST_ASSERT_EQUAL(7, i);
+    TEST_ASSERT_EQUAL(7, list.used_cnt);
+
+    _lv_ilist_clear(&list);
+    TEST_ASSERT_TRUE(_lv_ilist_is_empty(&list));
+    TEST_ASSERT_EQUAL(0, list.used_cnt);
+    TEST_ASSERT_EQUAL(1, list.chunk_cnt);
+
+    lv_mem_free(list.chunks);
+}
+
+void test_ilist_release_chunks(void)
+{
+    uint32_t free_mem = lv_test_get_free_mem();
+
+    lv_ilist_t list;
+    _lv_ilist_init(&list, sizeof(item_t), offsetof(item_t, node), 8);
+
+    /*Reusing the items doesn't allocate*/
+    uint32_t alloc_cnt = get_alloc_cnt();
+    uint32_t i;
+    for(i = 0; i < 100; i++) {
+        item_t * item = _lv_ilist_alloc(&list);
+        _lv_ilist_ins_head(&list, item);
+        _lv_ilist_remove(&list, item);
+        _lv_ilist_free(&list, item);
+    }
+    TEST_ASSERT_EQUAL(alloc_cnt, get_alloc_cnt());
+
+    /*A burst allocates in chunks*/
+    for(i = 0; i < 50; i++) {
+        _lv_ilist_ins_tail(&list, _lv_ilist_alloc(&list));
+    }
+    TEST_ASSERT_EQUAL(7, list.chunk_cnt);
+    TEST_ASSERT_EQUAL(alloc_cnt + 6, get_alloc_cnt());
+
+    /*And frees them when their items are released, even if the list is never empty
+     *like the timer list: the first chunk and the one of the last item are kept*/
+    item_t * item = _lv_ilist_get_head(&list);
+    for(i = 0; i < 49; i++) {
+        item_t * next = _lv_ilist_get_next(&list, item);
+        _lv_ilist_remove(&list, item);
+        _lv_ilist_free(&list, item);
+        item = next;
+    }
+    TEST_ASSERT_EQUAL(2, list.chunk_cnt);
+    _lv_ilist_clear(&list);
+    TEST_ASSERT_EQUAL(1, list.chunk_cnt);
+
+    /*Going up and down around a chunk boundary doesn't free and allocate the chunk every time*/
+    item_t * items[8];
+    for(i = 0; i < 8; i++) {
+        items[i] = _lv_ilist_alloc(&list);
+    }
+    alloc_cnt = get_alloc_cnt();
+    for(i = 0; i < 20; i++) {
+        _lv_ilist_free(&list, _lv_ilist_alloc(&list));
+    }
+    TEST_ASSERT_EQUAL(alloc_cnt + 1, get_alloc_cnt());
+    TEST_ASSERT_EQUAL(2, list.chunk_cnt);
+    /*The spare chunk goes with the next one emptied*/
+    for(i = 0; i < 16; i++) {
+        _lv_ilist_ins_tail(&list, _lv_ilist_alloc(&list));
+    }
+    TEST_ASSERT_EQUAL(3, list.chunk_cnt);
+    _lv_ilist_clear(&list);
+    for(i = 1; i < 8; i++) {
+        _lv_ilist_free(&list, items[i]);
+    }
+    TEST_ASSERT_EQUAL(2, list.chunk_cnt);
+    _lv_ilist_free(&list, items[0]);
+    TEST_ASSERT_EQUAL(1, list.chunk_cnt);
+
+    /*The remaining chunk is fully usable*/
+    for(i = 0; i < 8; i++) {
+        _lv_ilist_ins_tail(&list, _lv_ilist_alloc(&list));
+    }
+    TEST_ASSERT_EQUAL(1, list.chunk_cnt);
+    _lv_ilist_clear(&list);
+
+    lv_mem_free(list.chunks);
+    LV_HEAP_CHECK(TEST_ASSERT_EQUAL(free_mem, lv_test_get_free_mem()));
+}
+
+void test_timer_no_alloc(void)
+{
+    /*Create and delete timers without touching the heap*/
+    uint32_t alloc_cnt = get_alloc_cnt();
+    uint32_t i;
+    for(i = 0; i < 100; i++) {
+        lv_timer_t * t = lv_timer_create(timer_cb, 10, NULL);
+        lv_timer_handler();
+        lv_timer_del(t);
+    }
+    TEST_ASSERT_EQUAL(alloc_cnt, get_alloc_cnt());
+
+    /*Timers created in a burst take a few chunks*/
+    lv_timer_t * timers[40];
+    for(i = 0; i < 40; i++) {
+        timers[i] = lv_timer_create(timer_cb, 10, NULL);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(alloc_cnt + 6, get_alloc_cnt());
+
+    lv_timer_handler();
+    for(i = 0; i < 40; i++) {
+        lv_timer_del(timers[i]);
+    }
+    /*The display and indev timers are still there, but the burst's chunks are freed*/
+    TEST_ASSERT_FALSE(_lv_ilist_is_empty(&LV_GC_ROOT(_lv_timer_ll)));
+    TEST_ASSERT_LESS_OR_EQUAL(2, LV_GC_ROOT(_lv_timer_ll).chunk_cnt);
+
+    /*Deleted timers are reused*/
+    alloc_cnt = get_alloc_cnt();
+    for(i = 0; i < 8; i++) {
+        timers[i] = lv_timer_create(timer_cb, 10, NULL);
+    }
+    for(i = 0; i < 8; i++) {
+        lv_timer_del(timers[i]);
+    }
+    TEST_ASSERT_EQUAL(alloc_cnt, get_alloc_cnt());
+}
+
+void test_anim_no_alloc(void)
+{
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_exec_cb(&a, anim_exec_cb);
+    lv_anim_set_values(&a, 0, 100);
+    lv_anim_set_time(&a, 50);
+
+    /*Run an animation once to get a chunk*/
+    lv_anim_set_var(&a, &anim_value);
+    lv_anim_start(&a);
+    lv_test_indev_wait(100);
+    TEST_ASSERT_EQUAL(100, anim_value);
+
+    uint32_t alloc_cnt = get_alloc_cnt();
+    uint32_t i;
+    for(i = 0; i < 20; i++) {
+        /*Started, replaced and finished animations*/
+        lv_anim_start(&a);
+        lv_anim_start(&a);
+        lv_test_indev_wait(100);
+        TEST_ASSERT_NULL(lv_anim_get(&anim_value, anim_exec_cb));
+    }
+    TEST_ASSERT_EQUAL(alloc_cnt, get_alloc_cnt());
+
+    /*Deleted animations*/
+    for(i = 0; i < 100; i++) {
+        lv_anim_start(&a);
+        TEST_ASSERT_TRUE(lv_anim_del(&anim_value, anim_exec_cb));
+    }
+    TEST_ASSERT_EQUAL(alloc_cnt, get_alloc_cnt());
+}
+
+void test_child_array_growth(void)
+{
+    lv_obj_t * parent = lv_obj_create(lv_scr_act());
+
+    /*Get the allocations of creating a child when the array doesn't need to grow*/
+    lv_obj_t * child = lv_obj_create(parent);
+    lv_obj_create(child);
+    uint32_t alloc_cnt = get_alloc_cnt();
+    lv_obj_create(child);
+    uint32_t alloc_per_child = get_alloc_cnt() - alloc_cnt;
+    lv_obj_del(child);
+
+    /*The child array grows in steps, not for every child*/
+    alloc_cnt = get_alloc_cnt();
+    uint32_t i;
+    for(i = 0; i < 200; i++) {
+        lv_obj_create(parent);
+    }
+    uint32_t growth_cnt = get_alloc_cnt() - alloc_cnt - 200 * alloc_per_child;
+    TEST_ASSERT_LESS_OR_EQUAL(12, growth_cnt);
+    TEST_ASSERT_EQUAL(200, lv_obj_get_child_cnt(parent));
+    TEST_ASSERT_GREATER_OR_EQUAL(200, parent->spec_attr->child_cap);
+
+    /*Deleting the children in any order keeps them in order*/
+    for(i = 0; i < 180; i++) {
+        lv_obj_del(lv_obj_get_child(parent, (i * 7) % lv_obj_get_child_cnt(parent)));
+    }
+    TEST_ASSERT_EQUAL(20, lv_obj_get_child_cnt(parent));
+    TEST_ASSERT_LESS_THAN(200, parent->spec_attr->child_cap);
+    for(i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL(i, lv_obj_get_index(lv_obj_get_child(parent, i)));
+    }
+
+    /*Moving the children to an other parent*/
+    lv_obj_t * parent2 = lv_obj_create(lv_scr_act());
+    for(i = 0; i < 20; i++) {
+        lv_obj_set_parent(lv_obj_get_child(parent, 0), parent2);
+    }
+    TEST_ASSERT_EQUAL(0, lv_obj_get_child_cnt(parent));
+    TEST_ASSERT_NULL(parent->spec_attr->children);
+    TEST_ASSERT_EQUAL(20, lv_obj_get_child_cnt(parent2));
+}
+
+void test_child_array_inline(void)
+{
+#if LV_OBJ_CHILD_INLINE_CNT
+    lv_obj_t * parent = lv_obj_create(lv_scr_act());
+    lv_obj_t * children[LV_OBJ_CHILD_INLINE_CNT + 1];
+
+    uint32_t i;
+    for(i = 0; i < LV_OBJ_CHILD_INLINE_CNT; i++) {
+        children[i] = lv_obj_create(parent);
+    }
+    TEST_ASSERT_EQUAL_PTR(parent->spec_attr->child_inline, parent->spec_attr->children);
+
+    /*One more child needs an array*/
+    children[i] = lv_obj_create(parent);
+    TEST_ASSERT_NOT_EQUAL(parent->spec_attr->child_inline, parent->spec_attr->children);
+
+    /*Deleting it moves the children back*/
+    lv_obj_del(children[LV_OBJ_CHILD_INLINE_CNT]);
+    TEST_ASSERT_EQUAL_PTR(parent->spec_attr->child_inline, parent->spec_attr->children);
+    for(i = 0; i < LV_OBJ_CHILD_INLINE_CNT; i++) {
+        TEST_ASSERT_EQUAL_PTR(children[i], lv_obj_get_child(parent, i));
+    }
+
+    lv_obj_swap(children[0], children[LV_OBJ_CHILD_INLINE_CNT - 1]);
+    TEST_ASSERT_EQUAL_PTR(children[0], lv_obj_get_child(parent, LV_OBJ_CHILD_INLINE_CNT - 1));
+
+    lv_obj_clean(parent);
+    TEST_ASSERT_NULL(parent->spec_attr->children);
+#endif
+}
+
+void test_screen_rebuild(void)
+{
+    lv_obj_t * scr_ori = lv_scr_act();
+
+    uint32_t alloc_cnt[6];
+    uint32_t free_mem[6];
+    uint32_t i;
+    for(i = 0; i < 6; i++) {
+        uint32_t alloc_start = get_alloc_cnt();
+        lv_obj_t * scr = lv_obj_create(NULL);
+        build_screen(scr);
+        lv_scr_load_anim(scr, LV_SCR_LOAD_ANIM_MOVE_LEFT, 100, 0, false);
+        lv_test_indev_wait(200);
+
+        lv_scr_load(scr_ori);
+        lv_obj_del(scr);
+        lv_test_indev_wait(50);
+
+        alloc_cnt[i] = get_alloc_cnt() - alloc_start;
+        free_mem[i] = lv_test_get_free_mem();
+    }
+
+    /*Once warmed up each cycle allocates and frees the same*/
+    for(i = 2; i < 6; i++) {
+        TEST_ASSERT_EQUAL(alloc_cnt[1], alloc_cnt[i]);
+        LV_HEAP_CHECK(TEST_ASSERT_EQUAL(free_mem[1], free_mem[i]));
+    }
+}
+
+#endif
@@ -0,0 +1,208 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#include <time.h>
+
+#define CANVAS_W    200
+#define CANVAS_H    150
+
+void setUp(void);
+void tearDown(void);
+void test_canvas_batch_same_as_single_calls(void);
+void test_canvas_batch_invalidate_once(void);
+void test_canvas_draw_ctx_direct(void);
+void test_canvas_set_buffer_after_draw(void);
+void test_canvas_benchmark(void);
+
+static lv_color_t buf[LV_CANVAS_BUF_SIZE_TRUE_COLOR(CANVAS_W, CANVAS_H)];
+static lv_color_t ref_buf[LV_CANVAS_BUF_SIZE_TRUE_COLOR(CANVAS_W, CANVAS_H)];
+static lv_obj_t * canvas;
+static lv_draw_line_dsc_t line_dsc;
+static lv_draw_rect_dsc_t rect_dsc;
+
+/*Ticks of a gauge and a sparkline*/
+static void line_points(uint32_t i, lv_point_t p[2])
+{
+    p[0].x = (i * 7) % CANVAS_W;
+    p[0].y = (i * 13) % CANVAS_H;
+    p[1].x = p[0].x + (i % 9) - 4;
+    p[1].y = p[0].y + (i % 11);
+}
+
+static void rect_area(uint32_t i, lv_area_t * a)
+{
+    a->x1 = (i * 17) % CANVAS_W;
+    a->y1 = (i * 5) % CANVAS_H;
+    a->x2 = a->x1 + i % 8;
+    a->y2 = a->y1 + i % 6;
+}
+
+static void draw_single(uint32_t line_cnt, uint32_t rect_cnt)
+{
+    uint32_t i;
+    for(i = 0; i < line_cnt; i++) {
+        lv_point_t p[2];
+        line_points(i, p);
+        lv_canvas_draw_line(canvas, p, 2, &line_dsc);
+    }
+    for(i = 0; i < rect_cnt; i++) {
+        lv_area_t a;
+        rect_area(i, &a);
+        lv_canvas_draw_rect(canvas, a.x1, a.y1, lv_area_get_width(&a), lv_area_get_height(&a), &rect_dsc);
+    }
+}
+
+static void draw_direct(lv_draw_ctx_t * draw_ctx, uint32_t line_cnt, uint32_t rect_cnt)
+{
+    uint32_t i;
+    for(i = 0; i < line_cnt; i++) {
+        lv_point_t p[2];
+        line_points(i, p);
+        lv_draw_line(draw_ctx, &line_dsc, &p[0], &p[1]);
+    }
+    for(i = 0; i < rect_cnt; i++) {
+        lv_area_t a;
+        rect_area(i, &a);
+        lv_draw_rect(draw_ctx, &rect_dsc, &a);
+    }
+}
+
+void setUp(void)
+{
+    canvas = lv_canvas_create(lv_scr_act());
+    lv_canvas_set_buffer(canvas, buf, CANVAS_W, CANVAS_H, LV_IMG_CF_TRUE_COLOR);
+    lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
+
+    lv_draw_line_dsc_init(&line_dsc);
+    line_dsc.color = lv_palette_main(LV_PALETTE_BLUE);
+    line_dsc.width = 2;
+
+    lv_draw_rect_dsc_init(&rect_dsc);
+    rect_dsc.bg_color = lv_palette_main(LV_PALETTE_RED);
+    rect_dsc.bg_opa = LV_OPA_70;
+    rect_dsc.radius = 2;
+    lv_refr_now(NULL);
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_canvas_batch_same_as_single_calls(void)
+{
+    draw_single(500, 300);
+    lv_memcpy(ref_buf, buf, sizeof(buf));
+
+    lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
+    TEST_ASSERT_NOT_NULL(lv_canvas_draw_begin(canvas));
+    draw_single(500, 300);
+    lv_canvas_draw_end(canvas);
+    TEST_ASSERT_EQUAL_MEMORY(ref_buf, buf, sizeof(buf));
+
+    /*The anti-aliasing is disabled only for the transparent color of chroma keyed canvases*/
+    lv_canvas_set_buffer(canvas, buf, CANVAS_W, CANVAS_H, LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED);
+    lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
+    lv_draw_line_dsc_t line_dsc_transp = line_dsc;
+    line_dsc_transp.color = LV_COLOR_CHROMA_KEY;
+    lv_point_t p[2] = {{10, 10}, {100, 37}};
+    lv_canvas_draw_line(canvas, p, 2, &line_dsc_transp);
+    draw_single(500, 0);
+    lv_memcpy(ref_buf, buf, sizeof(buf));
+
+    lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
+    lv_canvas_draw_begin(canvas);
+    lv_canvas_draw_line(canvas, p, 2, &line_dsc_transp);
+    draw_single(500, 0);
+    lv_canvas_draw_end(canvas);
+    TEST_ASSERT_EQUAL_MEMORY(ref_buf, buf, sizeof(buf));
+}
+
+void test_canvas_batch_invalidate_once(void)
+{
+    lv_disp_t * disp = lv_disp_get_default();
+    lv_disp_t * disp_refr = _lv_refr_get_disp_refreshing();
+    lv_canvas_draw_begin(canvas);
+    draw_single(10, 10);
+    TEST_ASSERT_EQUAL(0, disp->inv_p);
+    TEST_ASSERT_NOT_EQUAL(disp_refr, _lv_refr_get_disp_refreshing());
+    lv_canvas_draw_end(canvas);
+
+    TEST_ASSERT_EQUAL(1, disp->inv_p);
+    TEST_ASSERT_GREATER_OR_EQUAL(CANVAS_W * CANVAS_H, lv_area_get_size(&disp->inv_areas[0]));
+    TEST_ASSERT_EQUAL_PTR(disp_refr, _lv_refr_get_disp_refreshing());
+}
+
+void test_canvas_draw_ctx_direct(void)
+{
+    draw_single(500, 300);
+    lv_memcpy(ref_buf, buf, sizeof(buf));
+
+    lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
+    lv_draw_ctx_t * draw_ctx = lv_canvas_draw_begin(canvas);
+    TEST_ASSERT_NOT_NULL(draw_ctx);
+    draw_direct(draw_ctx, 500, 300);
+    lv_canvas_draw_end(canvas);
+    TEST_ASSERT_EQUAL_MEMORY(ref_buf, buf, sizeof(buf));
+
+    /*Can't draw to indexed canvases*/
+    lv_canvas_set_buffer(canvas, buf, CANVAS_W, CANVAS_H, LV_IMG_CF_INDEXED_1BIT);
+    TEST_ASSERT_NULL(lv_canvas_draw_begin(canvas));
+}
+
+void test_canvas_set_buffer_after_draw(void)
+{
+    draw_single(100, 100);
+
+    /*The draw context is created again for the new buffer*/
+    lv_canvas_set_buffer(canvas, ref_buf, CANVAS_W / 2, CANVAS_H / 2, LV_IMG_CF_TRUE_COLOR);
+    lv_canvas_fill_bg(canvas, lv_color_black(), LV_OPA_COVER);
+    lv_memset_00(buf, sizeof(buf));
+    rect_dsc.bg_opa = LV_OPA_COVER;
+    rect_dsc.radius = 0;
+    lv_canvas_draw_rect(canvas, -10, -10, CANVAS_W, CANVAS_H, &rect_dsc);
+
+    uint32_t i;
+    for(i = 0; i < CANVAS_W / 2 * CANVAS_H / 2; i++) {
+        TEST_ASSERT_EQUAL_HEX32(lv_color_to32(rect_dsc.bg_color), lv_color_to32(ref_buf[i]));
+    }
+    for(i = 0; i < sizeof(buf) / sizeof(buf[0]); i++) {
+        TEST_ASSERT_EQUAL_HEX32(0, lv_color_to32(buf[i]));
+    }
+}
+
+void test_canvas_benchmark(void)
+{
+    /*Draw 10k lines or rectangles one by one, in a batch and directly with the draw context*/
+    const uint32_t cnt = 10000;
+    const char * modes[] = {"single calls", "batch", "draw context"};
+    char msg[256];
+
+    uint32_t rect;
+    for(rect = 0; rect <= 1; rect++) {
+        uint32_t m;
+        for(m = 0; m < 3; m++) {
+            lv_canvas_fill_bg(canvas, lv_color_white(), LV_OPA_COVER);
+            clock_t t = clock();
+            if(m == 0) {
+                draw_single(rect ? 0 : cnt, rect ? cnt : 0);
+            }
+            else {
+                lv_draw_ctx_t * draw_ctx = lv_canvas_draw_begin(canvas);
+                if(m == 1) draw_single(rect ? 0 : cnt, rect ? cnt : 0);
+                else draw_direct(draw_ctx, rect ? 0 : cnt, rect ? cnt : 0);
+                lv_canvas_draw_end(canvas);
+            }
+            uint32_t us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+            lv_refr_now(NULL);
+
+            lv_snprintf(msg, sizeof(msg), "Canvas %d %s, %s: %d us", (int)cnt, rect ? "rectangles" : "lines", modes[m],
+                        (int)us);
+            TEST_MESSAGE(msg);
+        }
+    }
+}
+
+#endif
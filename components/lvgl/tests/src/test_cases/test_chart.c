@@ -0,0 +1,259 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+void setUp(void);
+void tearDown(void);
+void test_chart_stream_same_as_shift_if_not_crowded(void);
+void test_chart_stream_cols_same_as_rebuilt(void);
+void test_chart_stream_invalidate_last_col(void);
+void test_chart_stream_next_values(void);
+void test_chart_stream_benchmark(void);
+
+#if LV_USE_CHART
+
+#include <time.h>
+
+extern lv_color_t test_fb[];
+static lv_color_t ref_fb[800 * 480];
+static uint32_t rnd_seed;
+
+static lv_coord_t rnd_value(void)
+{
+    rnd_seed = rnd_seed * 1103515245 + 12345;
+    return (rnd_seed >> 16) % 101;
+}
+
+static lv_obj_t * chart_create(lv_chart_update_mode_t mode, uint16_t point_cnt)
+{
+    lv_obj_t * chart = lv_chart_create(lv_scr_act());
+    lv_obj_set_size(chart, 400, 200);
+    lv_obj_center(chart);
+    lv_chart_set_update_mode(chart, mode);
+    lv_chart_set_point_count(chart, point_cnt);
+    return chart;
+}
+
+static void render(void)
+{
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+}
+
+/*The area invalidated since the last refresh*/
+static uint32_t get_inv_px_cnt(void)
+{
+    lv_disp_t * disp = lv_disp_get_default();
+    uint32_t px_cnt = 0;
+    uint16_t i;
+    for(i = 0; i < disp->inv_p; i++) {
+        if(disp->inv_area_joined[i] == 0) px_cnt += lv_area_get_size(&disp->inv_areas[i]);
+    }
+    return px_cnt;
+}
+
+void setUp(void)
+{
+    rnd_seed = 1;
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_chart_stream_same_as_shift_if_not_crowded(void)
+{
+    lv_obj_t * chart = chart_create(LV_CHART_UPDATE_MODE_SHIFT, 50);
+    lv_chart_series_t * ser = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_RED), LV_CHART_AXIS_PRIMARY_Y);
+    uint32_t i;
+    for(i = 0; i < 70; i++) lv_chart_set_next_value(chart, ser, rnd_value());
+    render();
+    lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+
+    lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_STREAM);
+    render();
+    TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+}
+
+void test_chart_stream_cols_same_as_rebuilt(void)
+{
+    /*Many points per pixel with some gaps*/
+    lv_obj_t * chart = chart_create(LV_CHART_UPDATE_MODE_STREAM, 2000);
+    lv_chart_series_t * ser1 = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_RED), LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_series_t * ser2 = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_BLUE), LV_CHART_AXIS_PRIMARY_Y);
+    render();
+    TEST_ASSERT_GREATER_THAN(1, ((lv_chart_t *)chart)->col_points);
+
+    uint32_t i;
+    for(i = 0; i < 2500; i++) {
+        lv_chart_set_next_value(chart, ser1, (i / 100) % 7 == 3 ? LV_CHART_POINT_NONE : rnd_value());
+        lv_chart_set_next_value(chart, ser2, rnd_value() / 2);
+        /*Draw the columns while they are being filled too*/
+        if(i % 333 == 0) lv_refr_now(NULL);
+    }
+    render();
+    lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+
+    /*Setting the start point rebuilds the columns from the points*/
+    TEST_ASSERT_TRUE(ser1->cols_valid);
+    lv_chart_set_x_start_point(chart, ser1, ser1->start_point);
+    lv_chart_set_x_start_point(chart, ser2, ser2->start_point);
+    TEST_ASSERT_FALSE(ser1->cols_valid);
+    render();
+    TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+}
+
+void test_chart_stream_invalidate_last_col(void)
+{
+    lv_obj_t * chart = chart_create(LV_CHART_UPDATE_MODE_STREAM, 4000);
+    lv_chart_series_t * ser = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_RED), LV_CHART_AXIS_PRIMARY_Y);
+    lv_chart_set_all_value(chart, ser, 50);
+    render();
+
+    uint16_t col_points = ((lv_chart_t *)chart)->col_points;
+    TEST_ASSERT_GREATER_THAN(1, col_points);
+
+    /*Start a new column: everything is shifted*/
+    lv_chart_set_next_value(chart, ser, 10);
+    TEST_ASSERT_EQUAL(0, (ser->start_point - 1) % col_points);
+    TEST_ASSERT_GREATER_OR_EQUAL(400 * 200, get_inv_px_cnt());
+    lv_refr_now(NULL);
+
+    /*Fill the column: only its area is redrawn*/
+    uint32_t i;
+    for(i = 1; i < col_points; i++) {
+        lv_chart_set_next_value(chart, ser, 90);
+        TEST_ASSERT_LESS_THAN(400 * 200 / 20, get_inv_px_cnt());
+        lv_refr_now(NULL);
+    }
+
+    lv_chart_set_next_value(chart, ser, 10);
+    TEST_ASSERT_GREATER_OR_EQUAL(400 * 200, get_inv_px_cnt());
+}
+
+void test_chart_stream_next_values(void)
+{
+    lv_coord_t values[300];
+    uint32_t i;
+    for(i = 0; i < sizeof(values) / sizeof(values[0]); i++) values[i] = rnd_value();
+
+    /*Adding the values at once is the same as one by one in every mode*/
+    const lv_chart_update_mode_t modes[] = {LV_CHART_UPDATE_MODE_SHIFT, LV_CHART_UPDATE_MODE_CIRCULAR, LV_CHART_UPDATE_MODE_STREAM};
+    uint32_t m;
+    for(m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        lv_obj_t * chart = chart_create(modes[m], 1000);
+        lv_chart_series_t * ser = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_RED), LV_CHART_AXIS_PRIMARY_Y);
+        render();
+        for(i = 0; i < sizeof(values) / sizeof(values[0]); i++) lv_chart_set_next_value(chart, ser, values[i]);
+        render();
+        lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+        lv_obj_del(chart);
+
+        chart = chart_create(modes[m], 1000);
+        ser = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_RED), LV_CHART_AXIS_PRIMARY_Y);
+        render();
+        lv_chart_set_next_values(chart, ser, values, sizeof(values) / sizeof(values[0]));
+        render();
+        TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+        lv_obj_del(chart);
+    }
+}
+
+void test_chart_stream_benchmark(void)
+{
+    /*Stream 10k points/s to a chart showing the last 5 s at 25 FPS in shift and stream mode,
+     *and with the series hidden to measure only the drawing of the series*/
+    const uint32_t rate = 10000;
+    const uint32_t fps = 25;
+    const uint32_t frame_cnt = 2 * fps;
+    const char * names[] = {"shift", "stream", "hidden"};
+    lv_coord_t values[10000 / 25];
+    char msg[256];
+    uint32_t us[3];
+    uint32_t px[3];
+
+    uint32_t m;
+    for(m = 0; m < 3; m++) {
+        rnd_seed = 1;
+        lv_obj_t * chart = chart_create(m == 1 ? LV_CHART_UPDATE_MODE_STREAM : LV_CHART_UPDATE_MODE_SHIFT, 5 * rate);
+        lv_chart_series_t * ser = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_RED), LV_CHART_AXIS_PRIMARY_Y);
+        if(m == 2) lv_chart_hide_series(chart, ser, true);
+        render();
+
+        clock_t t = clock();
+        uint32_t f;
+        for(f = 0; f < frame_cnt; f++) {
+            uint32_t i;
+            for(i = 0; i < rate / fps; i++) values[i] = rnd_value();
+            lv_chart_set_next_values(chart, ser, values, rate / fps);
+            lv_refr_now(NULL);
+        }
+        us[m] = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+        /*One point per frame: stream mode redraws only the last column until it's full*/
+        px[m] = 0;
+        for(f = 0; f < frame_cnt; f++) {
+            lv_chart_set_next_value(chart, ser, rnd_value());
+            px[m] += get_inv_px_cnt();
+            lv_refr_now(NULL);
+        }
+        lv_obj_del(chart);
+
+        lv_snprintf(msg, sizeof(msg),
+                    "Chart %s, %d points: %d points/frame %d us per frame; 1 point/frame %d px per frame",
+                    names[m], (int)(5 * rate), (int)(rate / fps), (int)(us[m] / frame_cnt), (int)(px[m] / frame_cnt));
+        TEST_MESSAGE(msg);
+    }
+
+    uint32_t shift_us = us[0] - LV_MIN(us[0], us[2]);
+    uint32_t stream_us = us[1] - LV_MIN(us[1], us[2]);
+    lv_snprintf(msg, sizeof(msg), "Drawing the series: shift %d us, stream %d us per frame",
+                (int)(shift_us / frame_cnt), (int)(stream_us / frame_cnt));
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_LESS_THAN(shift_us / 2, stream_us);
+    TEST_ASSERT_LESS_THAN(px[0] / 4, px[1]);
+}
+
+#else /*LV_USE_CHART*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_chart_stream_same_as_shift_if_not_crowded(void)
+{
+
+}
+
+void test_chart_stream_cols_same_as_rebuilt(void)
+{
+
+}
+
+void test_chart_stream_invalidate_last_col(void)
+{
+
+}
+
+void test_chart_stream_next_values(void)
+{
+
+}
+
+void test_chart_stream_benchmark(void)
+{
+
+}
+
+#endif /*LV_USE_CHART*/
+
+#endif
@@ -12,9 +12,13 @@
 
 #include "unity/unity.h"
 
+#include <stdio.h>
+#include <time.h>
+
 /*********************
  *      DEFINES
  *********************/
+#define TRUNCATED_FN    "/tmp/lv_font_loader_test.fnt"
 
 /**********************
  *      TYPEDEFS
@@ -25,11 +29,22 @@
  **********************/
 
 static int compare_fonts(lv_font_t * f1, lv_font_t * f2);
+#if LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+static void compare_glyphs(lv_font_t * f1, lv_font_t * f2);
+#endif
+void setUp(void);
+void tearDown(void);
 void test_font_loader(void);
+void test_font_loader_mapped(void);
+void test_font_loader_truncated(void);
+void test_font_loader_benchmark(void);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+#if LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+static lv_fs_drv_t drv_b_ori;
+#endif
 
 /**********************
  *      MACROS
@@ -43,6 +58,20 @@ extern lv_font_t font_1;
 extern lv_font_t font_2;
 extern lv_font_t font_3;
 
+void setUp(void)
+{
+#if LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+    drv_b_ori = *lv_fs_get_drv('B');
+#endif
+}
+
+void tearDown(void)
+{
+#if LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+    *lv_fs_get_drv('B') = drv_b_ori;
+#endif
+}
+
 void test_font_loader(void)
 {
     /*Test with cahce ('A' has cache)*/
@@ -59,6 +88,9 @@ void test_font_loader(void)
     lv_font_free(font_3_bin);
 
     /*Test with cahce ('B' has NO cache)*/
+#if LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+    lv_fs_get_drv('B')->mmap_cb = NULL;     /*Read the files to test the copying loader*/
+#endif
     font_1_bin = lv_font_load("B:src/test_fonts/font_1.fnt");
     font_2_bin = lv_font_load("B:src/test_fonts/font_2.fnt");
     font_3_bin = lv_font_load("B:src/test_fonts/font_3.fnt");
@@ -70,6 +102,124 @@ void test_font_loader(void)
     lv_font_free(font_1_bin);
     lv_font_free(font_2_bin);
     lv_font_free(font_3_bin);
+
+    /*The bitmaps are byte aligned in this file*/
+    lv_font_t * font_2_aligned_bin = lv_font_load("A:src/test_fonts/font_2_aligned.fnt");
+    compare_fonts(&font_2, font_2_aligned_bin);
+    lv_font_free(font_2_aligned_bin);
+}
+
+void test_font_loader_mapped(void)
+{
+#if LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+    /*The tables point into the mapped file. The bitmaps are shifted when they are drawn.*/
+    lv_font_t * font_1_bin = lv_font_load("B:src/test_fonts/font_1.fnt");
+    lv_font_t * font_2_bin = lv_font_load("B:src/test_fonts/font_2.fnt");
+    lv_font_t * font_3_bin = lv_font_load("B:src/test_fonts/font_3.fnt");
+
+    compare_glyphs(&font_1, font_1_bin);
+    compare_glyphs(&font_2, font_2_bin);
+    compare_glyphs(&font_3, font_3_bin);
+    TEST_ASSERT_TRUE(font_2_bin->get_glyph_bitmap != lv_font_get_bitmap_fmt_txt);
+
+    lv_font_free(font_1_bin);
+    lv_font_free(font_2_bin);
+    lv_font_free(font_3_bin);
+
+    /*The bitmaps are used from the mapped file directly*/
+    lv_font_t * font_2_aligned_bin = lv_font_load("B:src/test_fonts/font_2_aligned.fnt");
+    compare_fonts(&font_2, font_2_aligned_bin);
+    compare_glyphs(&font_2, font_2_aligned_bin);
+    TEST_ASSERT_TRUE(font_2_aligned_bin->get_glyph_bitmap == lv_font_get_bitmap_fmt_txt);
+    lv_font_free(font_2_aligned_bin);
+#endif
+}
+
+void test_font_loader_truncated(void)
+{
+    const char * fns[] = {"font_1.fnt", "font_2.fnt", "font_3.fnt", "font_2_aligned.fnt"};
+    static uint8_t data[16 * 1024];
+    char path[128];
+
+    uint32_t i;
+    for(i = 0; i < sizeof(fns) / sizeof(fns[0]); i++) {
+        lv_fs_file_t f;
+        uint32_t size;
+        lv_snprintf(path, sizeof(path), "A:src/test_fonts/%s", fns[i]);
+        TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, path, LV_FS_MODE_RD));
+        TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_read(&f, data, sizeof(data), &size));
+        lv_fs_close(&f);
+        TEST_ASSERT_LESS_THAN(sizeof(data), size);
+
+        /*Loading must fail both when reading and mapping the file*/
+        uint32_t len;
+        for(len = 0; len < size; len += 37) {
+            uint32_t bw;
+            TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, "A:" TRUNCATED_FN, LV_FS_MODE_WR));
+            TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_write(&f, data, len, &bw));
+            lv_fs_close(&f);
+
+            TEST_ASSERT_NULL_MESSAGE(lv_font_load("A:" TRUNCATED_FN), fns[i]);
+            TEST_ASSERT_NULL_MESSAGE(lv_font_load("B:" TRUNCATED_FN), fns[i]);
+        }
+    }
+
+    remove(TRUNCATED_FN);
+}
+
+void test_font_loader_benchmark(void)
+{
+#if LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+    const char * modes[] = {"read", "mapped", "mapped, aligned"};
+    const char * fns[] = {"B:src/test_fonts/font_2.fnt", "B:src/test_fonts/font_2.fnt", "B:src/test_fonts/font_2_aligned.fnt"};
+    const uint32_t load_cnt = 100;
+#if LV_MEM_CUSTOM == 0
+    uint32_t ram[3];
+#endif
+    char msg[256];
+
+    uint32_t i;
+    for(i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        lv_fs_get_drv('B')->mmap_cb = i == 0 ? NULL : drv_b_ori.mmap_cb;
+
+        clock_t t = clock();
+        uint32_t k;
+        for(k = 0; k < load_cnt; k++) {
+            lv_font_t * font = lv_font_load(fns[i]);
+            TEST_ASSERT_NOT_NULL(font);
+            lv_font_free(font);
+        }
+        uint32_t us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+        /*Draw all the glyphs once too*/
+        lv_font_t * font = lv_font_load(fns[i]);
+        t = clock();
+        compare_glyphs(&font_2, font);
+        uint32_t draw_us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+        char ram_txt[32] = "";
+#if LV_MEM_CUSTOM == 0
+        lv_mem_monitor_t mon1;
+        lv_mem_monitor_t mon2;
+        lv_mem_monitor(&mon1);
+        lv_font_free(font);
+        lv_mem_monitor(&mon2);
+        ram[i] = mon2.free_size - mon1.free_size;
+        lv_snprintf(ram_txt, sizeof(ram_txt), ", %d bytes RAM", (int)ram[i]);
+#else
+        lv_font_free(font);
+#endif
+
+        lv_snprintf(msg, sizeof(msg), "font loader %s: %d us per load, all glyphs compared in %d us%s",
+                    modes[i], (int)(us / load_cnt), (int)draw_us, ram_txt);
+        TEST_MESSAGE(msg);
+    }
+
+#if LV_MEM_CUSTOM == 0
+    TEST_ASSERT_LESS_THAN(ram[0] / 2, ram[1]);
+    TEST_ASSERT_LESS_THAN(ram[0] / 2, ram[2]);
+#endif
+#endif
 }
 
 static int compare_fonts(lv_font_t * f1, lv_font_t * f2)
@@ -216,5 +366,49 @@ static int compare_fonts(lv_font_t * f1, lv_font_t * f2)
  *   STATIC FUNCTIONS
  **********************/
 
+#if LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+/*Compare the glyphs of all letters of `f1` as they are drawn*/
+static void compare_glyphs(lv_font_t * f1, lv_font_t * f2)
+{
+    TEST_ASSERT_NOT_NULL_MESSAGE(f2, "font not null");
+
+    lv_font_fmt_txt_dsc_t * dsc1 = (lv_font_fmt_txt_dsc_t *)f1->dsc;
+    static uint8_t bitmap1[4096];
+
+    for(int i = 0; i < dsc1->cmap_num; ++i) {
+        const lv_font_fmt_txt_cmap_t * cmap = &dsc1->cmaps[i];
+        uint32_t cnt = cmap->unicode_list ? cmap->list_length : cmap->range_length;
+        for(uint32_t k = 0; k < cnt; ++k) {
+            uint32_t letter = cmap->range_start + (cmap->unicode_list ? cmap->unicode_list[k] : k);
+            lv_font_glyph_dsc_t g1;
+            lv_font_glyph_dsc_t g2;
+            TEST_ASSERT_EQUAL(lv_font_get_glyph_dsc(f1, &g1, letter, 0), lv_font_get_glyph_dsc(f2, &g2, letter, 0));
+            TEST_ASSERT_EQUAL_INT_MESSAGE(g1.adv_w, g2.adv_w, "adv_w");
+            TEST_ASSERT_EQUAL_INT_MESSAGE(g1.box_w, g2.box_w, "box_w");
+            TEST_ASSERT_EQUAL_INT_MESSAGE(g1.box_h, g2.box_h, "box_h");
+            TEST_ASSERT_EQUAL_INT_MESSAGE(g1.ofs_x, g2.ofs_x, "ofs_x");
+            TEST_ASSERT_EQUAL_INT_MESSAGE(g1.ofs_y, g2.ofs_y, "ofs_y");
+            if(g1.box_w * g1.box_h == 0) continue;
+
+            /*Compressed bitmaps are decompressed to the same buffer so copy the first*/
+            uint32_t bits = g1.box_w * g1.box_h * (g1.bpp == 3 ? 4 : g1.bpp);
+            TEST_ASSERT_LESS_OR_EQUAL(sizeof(bitmap1) * 8, bits);
+            const uint8_t * b1 = lv_font_get_glyph_bitmap(f1, letter);
+            TEST_ASSERT_NOT_NULL(b1);
+            lv_memcpy(bitmap1, b1, (bits + 7) / 8);
+            const uint8_t * b2 = lv_font_get_glyph_bitmap(f2, letter);
+            TEST_ASSERT_NOT_NULL(b2);
+
+            TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(bitmap1, b2, bits / 8, "bitmap");
+            if(bits % 8) {
+                uint8_t mask = (uint8_t)(0xFF << (8 - bits % 8));
+                TEST_ASSERT_EQUAL_HEX8_MESSAGE(bitmap1[bits / 8] & mask, b2[bits / 8] & mask, "bitmap");
+            }
+        }
+    }
+}
+
+#endif
+
 #endif // LV_BUILD_TEST
 
@@ -3,18 +3,35 @@
 
 #include "unity/unity.h"
 
+void setUp(void);
+void tearDown(void);
+void test_read(void);
+void test_read_random_access(void);
+void test_mapped(void);
+void test_cache_shared(void);
+void test_cache_read_ahead(void);
+void test_cache_write(void);
+void test_cache_benchmark(void);
+
 
 const char * read_exp =
     "Lorem ipsum dolor sit amet, consectetur adipiscing elit. Etiam sed maximus orci. Morbi massa nisi, varius eu convallis ac, venenatis at metus. In in nibh id urna pretium feugiat vitae eu libero. Ut eget fringilla eros. Nunc ullamcorper lectus mauris, vel rhoncus velit volutpat et. Phasellus sed molestie massa. Maecenas quis dui sollicitudin, vulputate nunc ut, dictum quam. Nam a congue lorem. Nulla non facilisis sapien. Ut luctus nulla nibh, sed finibus urna porta non. Duis aliquet augue id urna euismod auctor. Integer pellentesque vulputate enim non mattis. Donec finibus mattis dolor, et feugiat nisi pharetra porta. Mauris ullamcorper cursus magna. Orci varius natoque penatibus et magnis dis parturient montes, nascetur ridiculus mus.";
 
+#define BIG_FN     "src/test_fonts/ubuntu_font.c"
+
+static lv_fs_drv_t drv_b_ori;
+
 void setUp(void)
 {
     /* Function run before every test */
+    drv_b_ori = *lv_fs_get_drv('B');
 }
 
 void tearDown(void)
 {
     /* Function run after every test */
+    *lv_fs_get_drv('B') = drv_b_ori;
+    lv_fs_cache_invalidate(NULL);
 }
 #include <stdio.h>
 void test_read(void)
@@ -50,4 +67,373 @@ void test_read(void)
     lv_fs_close(&fb);
 }
 
+/*Read a whole file without cache and memory mapping*/
+static uint8_t * load_file(const char * fn, uint32_t * size)
+{
+    lv_fs_drv_t * drv = lv_fs_get_drv('B');
+    drv->cache_size = 0;
+    drv->mmap_cb = NULL;
+
+    char path[64];
+    lv_snprintf(path, sizeof(path), "B:%s", fn);
+    lv_fs_file_t f;
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, path, LV_FS_MODE_RD));
+    lv_fs_seek(&f, 0, LV_FS_SEEK_END);
+    lv_fs_tell(&f, size);
+    lv_fs_seek(&f, 0, LV_FS_SEEK_SET);
+    uint8_t * data = lv_mem_alloc(*size);
+    TEST_ASSERT_NOT_NULL(data);
+    uint32_t br;
+    lv_fs_read(&f, data, *size, &br);
+    TEST_ASSERT_EQUAL(*size, br);
+    lv_fs_close(&f);
+
+    *drv = drv_b_ori;
+    return data;
+}
+
+static uint32_t rnd(uint32_t * seed, uint32_t max)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 8) % max;
+}
+
+/*Seek and read randomly and compare with the content of the file*/
+static void assert_random_access(const char * path, const uint8_t * data, uint32_t size)
+{
+    static uint8_t buf[4000];
+    lv_fs_file_t f;
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, path, LV_FS_MODE_RD));
+
+    uint32_t seed = 1;
+    uint32_t pos = 0;
+    uint32_t i;
+    for(i = 0; i < 2000; i++) {
+        uint32_t r = rnd(&seed, 10);
+        if(r == 0) {
+            pos = rnd(&seed, size + 100);
+            TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_seek(&f, pos, LV_FS_SEEK_SET));
+        }
+        else if(r == 1) {
+            uint32_t back = rnd(&seed, 1000);
+            pos = size - back;
+            TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_seek(&f, 0, LV_FS_SEEK_END));
+            TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_seek(&f, pos, LV_FS_SEEK_SET));
+        }
+        else if(r == 2) {
+            uint32_t skip = rnd(&seed, 3000);
+            pos += skip;
+            TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_seek(&f, skip, LV_FS_SEEK_CUR));
+        }
+
+        /*Mostly small reads like the decoders do, and some big ones*/
+        uint32_t btr = rnd(&seed, 8) == 0 ? rnd(&seed, sizeof(buf)) : rnd(&seed, 64);
+        uint32_t br;
+        TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_read(&f, buf, btr, &br));
+        uint32_t exp_br = pos < size ? LV_MIN(btr, size - pos) : 0;
+        TEST_ASSERT_EQUAL(exp_br, br);
+        if(br) TEST_ASSERT_EQUAL_MEMORY(data + pos, buf, br);
+        pos += br;
+
+        uint32_t tell;
+        lv_fs_tell(&f, &tell);
+        TEST_ASSERT_EQUAL(pos, tell);
+    }
+
+    lv_fs_close(&f);
+}
+
+void test_read_random_access(void)
+{
+    uint32_t size;
+    uint8_t * data = load_file(BIG_FN, &size);
+
+    /*Cached*/
+    assert_random_access("A:" BIG_FN, data, size);
+
+    /*Not cached and not mapped*/
+    lv_fs_drv_t * drv = lv_fs_get_drv('B');
+    drv->mmap_cb = NULL;
+    assert_random_access("B:" BIG_FN, data, size);
+
+    /*Mapped*/
+    *drv = drv_b_ori;
+    assert_random_access("B:" BIG_FN, data, size);
+
+    /*Cached in the shared cache*/
+    drv->mmap_cb = NULL;
+    drv->cache_size = 1;
+    assert_random_access("B:" BIG_FN, data, size);
+
+    lv_mem_free(data);
+}
+
+#if LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+
+void test_mapped(void)
+{
+    uint32_t size;
+    uint8_t * data = load_file(BIG_FN, &size);
+
+    lv_fs_file_t f;
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, "B:" BIG_FN, LV_FS_MODE_RD));
+    uint32_t mapped_size;
+    const uint8_t * mapped = lv_fs_get_mapped(&f, &mapped_size);
+    TEST_ASSERT_NOT_NULL(mapped);
+    TEST_ASSERT_EQUAL(size, mapped_size);
+    TEST_ASSERT_EQUAL_MEMORY(data, mapped, size);
+
+    /*Reading needs no driver calls*/
+    lv_fs_reset_cache_stat();
+    uint8_t buf[100];
+    uint32_t br;
+    lv_fs_read(&f, buf, sizeof(buf), &br);
+    lv_fs_cache_stat_t stat;
+    lv_fs_get_cache_stat(&stat);
+    TEST_ASSERT_EQUAL(1, stat.mapped_read_cnt);
+    TEST_ASSERT_EQUAL(0, stat.drv_read_cnt);
+    lv_fs_close(&f);
+
+    /*Not mapped for writing and by drivers without mmap*/
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, "B:" BIG_FN, LV_FS_MODE_RD | LV_FS_MODE_WR));
+    TEST_ASSERT_NULL(lv_fs_get_mapped(&f, &mapped_size));
+    TEST_ASSERT_EQUAL(0, mapped_size);
+    lv_fs_close(&f);
+
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, "A:" BIG_FN, LV_FS_MODE_RD));
+    TEST_ASSERT_NULL(lv_fs_get_mapped(&f, &mapped_size));
+    lv_fs_close(&f);
+
+    lv_mem_free(data);
+}
+
+#else
+
+void test_mapped(void)
+{
+
+}
+
+#endif /*LV_USE_FS_POSIX && LV_FS_POSIX_MMAP*/
+
+#if LV_FS_CACHE_SIZE
+
+#define BLOCK_CNT ((LV_FS_CACHE_SIZE) / (LV_FS_CACHE_BLOCK_SIZE))
+
+/*Read `size` bytes in small chunks*/
+static void read_chunks(lv_fs_file_t * f, uint32_t pos, uint32_t size)
+{
+    uint8_t buf[50];
+    uint32_t br;
+    lv_fs_seek(f, pos, LV_FS_SEEK_SET);
+    while(size) {
+        uint32_t btr = LV_MIN(size, sizeof(buf));
+        lv_fs_read(f, buf, btr, &br);
+        TEST_ASSERT_EQUAL(btr, br);
+        size -= btr;
+    }
+}
+
+void test_cache_shared(void)
+{
+    lv_fs_cache_stat_t stat;
+    lv_fs_file_t f1;
+    lv_fs_file_t f2;
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f1, "A:" BIG_FN, LV_FS_MODE_RD));
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f2, "A:" BIG_FN, LV_FS_MODE_RD));
+
+    /*Read the same block with both files: read from the driver only once*/
+    lv_fs_reset_cache_stat();
+    read_chunks(&f1, 100 * LV_FS_CACHE_BLOCK_SIZE, LV_FS_CACHE_BLOCK_SIZE);
+    read_chunks(&f2, 100 * LV_FS_CACHE_BLOCK_SIZE, LV_FS_CACHE_BLOCK_SIZE);
+    lv_fs_get_cache_stat(&stat);
+    TEST_ASSERT_EQUAL(1, stat.miss_cnt);
+    TEST_ASSERT_EQUAL(1, stat.drv_read_cnt);
+    lv_fs_close(&f2);
+
+    /*Still cached when opened again*/
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f2, "A:" BIG_FN, LV_FS_MODE_RD));
+    lv_fs_reset_cache_stat();
+    read_chunks(&f2, 100 * LV_FS_CACHE_BLOCK_SIZE, LV_FS_CACHE_BLOCK_SIZE);
+    lv_fs_get_cache_stat(&stat);
+    TEST_ASSERT_EQUAL(0, stat.miss_cnt);
+
+    /*Read the first block again and then many other blocks: the first block is kept as it was used recently*/
+    read_chunks(&f1, 0, 1);
+    uint32_t i;
+    for(i = 0; i < BLOCK_CNT; i++) {
+        read_chunks(&f1, (200 + i * 2) * LV_FS_CACHE_BLOCK_SIZE, 1);
+        read_chunks(&f2, 0, 1);
+    }
+    lv_fs_reset_cache_stat();
+    read_chunks(&f2, 0, 1);
+    read_chunks(&f2, 100 * LV_FS_CACHE_BLOCK_SIZE, 1);
+    lv_fs_get_cache_stat(&stat);
+    TEST_ASSERT_EQUAL(1, stat.hit_cnt);
+    TEST_ASSERT_EQUAL(1, stat.miss_cnt);
+
+    /*Dropped*/
+    lv_fs_cache_invalidate("A:" BIG_FN);
+    lv_fs_reset_cache_stat();
+    read_chunks(&f2, 0, 1);
+    lv_fs_get_cache_stat(&stat);
+    TEST_ASSERT_EQUAL(1, stat.miss_cnt);
+
+    lv_fs_close(&f1);
+    lv_fs_close(&f2);
+}
+
+void test_cache_read_ahead(void)
+{
+    lv_fs_cache_stat_t stat;
+    lv_fs_file_t f;
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, "A:" BIG_FN, LV_FS_MODE_RD));
+
+    /*Sequential: the blocks are read in groups*/
+    lv_fs_reset_cache_stat();
+    uint32_t block_cnt = 4 * LV_FS_CACHE_READ_AHEAD;
+    read_chunks(&f, 0, block_cnt * LV_FS_CACHE_BLOCK_SIZE);
+    lv_fs_get_cache_stat(&stat);
+    TEST_ASSERT_EQUAL(block_cnt, stat.miss_cnt);
+    TEST_ASSERT_EQUAL(block_cnt - 4, stat.read_ahead_cnt);
+
+    /*Random: only the needed block is read*/
+    lv_fs_reset_cache_stat();
+    read_chunks(&f, 300 * LV_FS_CACHE_BLOCK_SIZE + 10, 1);
+    read_chunks(&f, 200 * LV_FS_CACHE_BLOCK_SIZE + 10, 1);
+    lv_fs_get_cache_stat(&stat);
+    TEST_ASSERT_EQUAL(2, stat.miss_cnt);
+    TEST_ASSERT_EQUAL(0, stat.read_ahead_cnt);
+
+    /*Big reads bypass the cache*/
+    static uint8_t buf[10 * LV_FS_CACHE_BLOCK_SIZE];
+    uint32_t br;
+    lv_fs_reset_cache_stat();
+    lv_fs_seek(&f, 400 * LV_FS_CACHE_BLOCK_SIZE + 10, LV_FS_SEEK_SET);
+    lv_fs_read(&f, buf, sizeof(buf), &br);
+    TEST_ASSERT_EQUAL(sizeof(buf), br);
+    lv_fs_get_cache_stat(&stat);
+    /*Only the first and last partial blocks are cached*/
+    TEST_ASSERT_EQUAL(sizeof(buf) - LV_FS_CACHE_BLOCK_SIZE, stat.bypass_size);
+
+    lv_fs_close(&f);
+}
+
+void test_cache_write(void)
+{
+    const char * path = "A:/tmp/lv_fs_cache_test.txt";
+    lv_fs_file_t f;
+    uint32_t bw;
+    uint32_t br;
+    char buf[16];
+
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, path, LV_FS_MODE_WR));
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_write(&f, "0123456789", 10, &bw));
+    lv_fs_close(&f);
+
+    /*Cache the content and then overwrite it*/
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, path, LV_FS_MODE_RD | LV_FS_MODE_WR));
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_read(&f, buf, 4, &br));
+    TEST_ASSERT_EQUAL_MEMORY("0123", buf, 4);
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_write(&f, "abc", 3, &bw));
+    TEST_ASSERT_EQUAL(3, bw);
+
+    uint32_t pos;
+    lv_fs_tell(&f, &pos);
+    TEST_ASSERT_EQUAL(7, pos);
+
+    lv_fs_seek(&f, 0, LV_FS_SEEK_SET);
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_read(&f, buf, sizeof(buf), &br));
+    TEST_ASSERT_EQUAL(10, br);
+    TEST_ASSERT_EQUAL_MEMORY("0123abc789", buf, 10);
+    lv_fs_close(&f);
+}
+
+#else
+
+void test_cache_shared(void)
+{
+
+}
+
+void test_cache_read_ahead(void)
+{
+
+}
+
+void test_cache_write(void)
+{
+
+}
+
+#endif /*LV_FS_CACHE_SIZE*/
+
+#if LV_FS_CACHE_SIZE && LV_USE_FS_POSIX && LV_FS_POSIX_MMAP
+
+#include <time.h>
+
+void test_cache_benchmark(void)
+{
+    /*Load a font and read randomly like the image decoders do
+     *without cache, with the shared cache and from the mapped file*/
+    const char * mode_names[] = {"no cache", "shared cache", "mapped"};
+    char msg[256];
+    lv_fs_drv_t * drv = lv_fs_get_drv('B');
+    uint32_t drv_read_cnts[3];
+
+    uint32_t mode;
+    for(mode = 0; mode < 3; mode++) {
+        *drv = drv_b_ori;
+        if(mode != 2) drv->mmap_cb = NULL;
+        if(mode == 1) drv->cache_size = 1;
+        lv_fs_cache_invalidate(NULL);
+        lv_fs_reset_cache_stat();
+
+        clock_t t = clock();
+        uint32_t i;
+        for(i = 0; i < 10; i++) {
+            lv_font_t * font = lv_font_load("B:src/test_fonts/font_2.fnt");
+            TEST_ASSERT_NOT_NULL(font);
+            lv_font_free(font);
+        }
+        uint32_t font_us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+        t = clock();
+        lv_fs_file_t f;
+        TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, "B:" BIG_FN, LV_FS_MODE_RD));
+        uint32_t seed = 1;
+        for(i = 0; i < 20000; i++) {
+            /*Small reads in a few hot regions, e.g. the headers and tables of the opened images*/
+            uint8_t buf[32];
+            uint32_t br;
+            uint32_t region = rnd(&seed, 4) * 64 * 1024;
+            lv_fs_seek(&f, region + rnd(&seed, 2 * 1024), LV_FS_SEEK_SET);
+            lv_fs_read(&f, buf, 1 + rnd(&seed, sizeof(buf)), &br);
+        }
+        lv_fs_close(&f);
+        uint32_t random_us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+        lv_fs_cache_stat_t stat;
+        lv_fs_get_cache_stat(&stat);
+        uint32_t block_cnt = stat.hit_cnt + stat.miss_cnt;
+        lv_snprintf(msg, sizeof(msg),
+                    "lv_fs %s: 10 font loads in %d us, 20000 random reads in %d us, %d driver reads, hit rate %d%%",
+                    mode_names[mode], (int)font_us, (int)random_us, (int)stat.drv_read_cnt,
+                    block_cnt ? (int)(stat.hit_cnt * 100 / block_cnt) : 0);
+        TEST_MESSAGE(msg);
+        drv_read_cnts[mode] = stat.drv_read_cnt;
+    }
+
+    TEST_ASSERT_EQUAL(0, drv_read_cnts[2]);
+}
+
+#else
+
+void test_cache_benchmark(void)
+{
+
+}
+
+#endif /*LV_FS_CACHE_SIZE && LV_USE_FS_POSIX && LV_FS_POSIX_MMAP*/
+
 #endif
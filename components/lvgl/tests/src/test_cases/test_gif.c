@@ -0,0 +1,298 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+void setUp(void);
+void tearDown(void);
+void test_gif_dispose_same_as_ref(void);
+void test_gif_spinner_same_as_ref(void);
+void test_gif_frame_period(void);
+void test_gif_invalidate_frame_area(void);
+void test_gif_invalidate_transformed(void);
+void test_gif_partial_refresh_same_as_full(void);
+void test_gif_benchmark(void);
+
+#if LV_USE_GIF && LV_COLOR_DEPTH == 32
+
+#include <time.h>
+
+/*Frames with all disposal methods, transparency and interlacing,
+ *and the same frames composited to full opaque frames in the `_ref` files*/
+#define DISPOSE_FN      "A:src/test_files/gif/dispose.gif"
+#define DISPOSE_REF_FN  "A:src/test_files/gif/dispose_ref.gif"
+#define DISPOSE_FRAMES  10
+/*A 24 px dot going around on a 200x200 background like a loading animation*/
+#define SPINNER_FN      "A:src/test_files/gif/spinner.gif"
+#define SPINNER_REF_FN  "A:src/test_files/gif/spinner_ref.gif"
+#define SPINNER_FRAMES  25
+
+extern lv_color_t test_fb[];
+
+/*The screen updated by the flushed areas*/
+static lv_color_t screen_fb[800 * 480];
+static lv_color_t ref_fb[800 * 480];
+static void (*test_flush_cb)(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p);
+
+static void screen_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
+{
+    lv_coord_t w = lv_area_get_width(area);
+    lv_coord_t y;
+    for(y = area->y1; y <= area->y2; y++) {
+        lv_memcpy(&screen_fb[y * disp_drv->hor_res + area->x1], &color_p[(y - area->y1) * w], w * sizeof(lv_color_t));
+    }
+    test_flush_cb(disp_drv, area, color_p);
+}
+
+static lv_obj_t * gif_create(const char * fn)
+{
+    lv_obj_t * obj = lv_gif_create(lv_scr_act());
+    lv_gif_set_src(obj, fn);
+    TEST_ASSERT_NOT_NULL(((lv_gif_t *)obj)->gif);
+    return obj;
+}
+
+/*Show the next frame like the timer would do when the frame's delay elapses*/
+static void next_frame(lv_obj_t * obj)
+{
+    lv_timer_t * t = ((lv_gif_t *)obj)->timer;
+    t->timer_cb(t);
+}
+
+/*The area invalidated since the last refresh*/
+static uint32_t get_inv_px_cnt(void)
+{
+    lv_disp_t * disp = lv_disp_get_default();
+    uint32_t px_cnt = 0;
+    uint16_t i;
+    for(i = 0; i < disp->inv_p; i++) {
+        if(disp->inv_area_joined[i] == 0) px_cnt += lv_area_get_size(&disp->inv_areas[i]);
+    }
+    return px_cnt;
+}
+
+static void assert_same_as_ref(const char * fn, const char * ref_fn, uint32_t frame_cnt)
+{
+    lv_obj_t * obj = gif_create(fn);
+    lv_obj_t * ref = gif_create(ref_fn);
+    gd_GIF * gif = ((lv_gif_t *)obj)->gif;
+    gd_GIF * ref_gif = ((lv_gif_t *)ref)->gif;
+    uint32_t size = gif->width * gif->height * LV_IMG_PX_SIZE_ALPHA_BYTE;
+
+    uint32_t i;
+    for(i = 0; i < frame_cnt; i++) {
+        if(i > 0) {
+            next_frame(obj);
+            next_frame(ref);
+        }
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(ref_gif->canvas, gif->canvas, size, fn);
+    }
+}
+
+void setUp(void)
+{
+    lv_disp_drv_t * drv = lv_disp_get_default()->driver;
+    test_flush_cb = drv->flush_cb;
+    drv->flush_cb = screen_flush_cb;
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_disp_get_default()->driver->flush_cb = test_flush_cb;
+}
+
+void test_gif_dispose_same_as_ref(void)
+{
+    assert_same_as_ref(DISPOSE_FN, DISPOSE_REF_FN, DISPOSE_FRAMES);
+}
+
+void test_gif_spinner_same_as_ref(void)
+{
+    assert_same_as_ref(SPINNER_FN, SPINNER_REF_FN, SPINNER_FRAMES);
+}
+
+void test_gif_frame_period(void)
+{
+    /*The timer runs only when the frame's delay elapsed*/
+    lv_obj_t * obj = gif_create(DISPOSE_FN);
+    lv_timer_t * t = ((lv_gif_t *)obj)->timer;
+    TEST_ASSERT_EQUAL(50, t->period);
+
+    uint32_t i;
+    for(i = 1; i < 8; i++) next_frame(obj);
+    TEST_ASSERT_EQUAL(50, t->period);
+    next_frame(obj);
+    TEST_ASSERT_EQUAL(70, t->period);
+
+    /*0 delay*/
+    next_frame(obj);
+    TEST_ASSERT_EQUAL(10, t->period);
+}
+
+void test_gif_invalidate_frame_area(void)
+{
+    lv_obj_t * obj = gif_create(SPINNER_FN);
+    lv_obj_set_pos(obj, 13, 27);
+    lv_refr_now(NULL);
+
+    /*The previous dot is restored and the next is drawn: at most two dots*/
+    uint32_t i;
+    for(i = 1; i < SPINNER_FRAMES; i++) {
+        next_frame(obj);
+        gd_GIF * gif = ((lv_gif_t *)obj)->gif;
+        uint32_t px_cnt = get_inv_px_cnt();
+        /*Invalidation adds 5 px around the area*/
+        TEST_ASSERT_EQUAL((gif->dw + 10) * (gif->dh + 10), px_cnt);
+        TEST_ASSERT_LESS_OR_EQUAL(2 * 34 * 34, px_cnt);
+        lv_refr_now(NULL);
+    }
+}
+
+void test_gif_invalidate_transformed(void)
+{
+    lv_obj_t * obj = gif_create(SPINNER_FN);
+    lv_obj_set_pos(obj, 13, 27);
+
+    /*The canvas is tiled*/
+    lv_obj_set_size(obj, 300, 200);
+    lv_refr_now(NULL);
+    next_frame(obj);
+    TEST_ASSERT_GREATER_OR_EQUAL(300 * 200, get_inv_px_cnt());
+    lv_refr_now(NULL);
+
+    /*The canvas is zoomed*/
+    lv_obj_set_size(obj, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+    lv_img_set_zoom(obj, 128);
+    lv_refr_now(NULL);
+    next_frame(obj);
+    TEST_ASSERT_GREATER_OR_EQUAL(200 * 200, get_inv_px_cnt());
+    lv_refr_now(NULL);
+
+    /*Cropped: only the changed area is invalidated*/
+    lv_img_set_zoom(obj, LV_IMG_ZOOM_NONE);
+    lv_obj_set_size(obj, 100, 200);
+    lv_refr_now(NULL);
+    next_frame(obj);
+    TEST_ASSERT_LESS_OR_EQUAL(2 * 34 * 34, get_inv_px_cnt());
+    lv_refr_now(NULL);
+}
+
+void test_gif_partial_refresh_same_as_full(void)
+{
+    const char * fns[] = {DISPOSE_FN, SPINNER_FN};
+    const uint32_t frame_cnts[] = {DISPOSE_FRAMES, SPINNER_FRAMES};
+
+    uint32_t i;
+    for(i = 0; i < sizeof(fns) / sizeof(fns[0]); i++) {
+        lv_obj_t * obj = gif_create(fns[i]);
+        lv_obj_set_pos(obj, 13, 27);
+        lv_obj_set_style_border_width(obj, 3, 0);
+        lv_obj_set_style_pad_all(obj, 5, 0);
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(NULL);
+
+        /*Go around once more to test the restart too*/
+        uint32_t f;
+        for(f = 1; f < 2 * frame_cnts[i]; f++) {
+            next_frame(obj);
+            lv_refr_now(NULL);
+            lv_memcpy(ref_fb, screen_fb, sizeof(ref_fb));
+
+            lv_obj_invalidate(lv_scr_act());
+            lv_refr_now(NULL);
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(test_fb, ref_fb, sizeof(ref_fb), fns[i]);
+        }
+        lv_obj_del(obj);
+    }
+}
+
+void test_gif_benchmark(void)
+{
+    /*Render the frames of a loading animation invalidating only the changed area
+     *and invalidating the whole GIF on every frame*/
+    const uint32_t loop_cnt = 4;
+    char msg[256];
+    uint32_t delta_px_cnt = 0;
+    uint32_t full_px_cnt = 0;
+
+    lv_obj_t * obj = gif_create(SPINNER_FN);
+    lv_obj_set_pos(obj, 13, 27);
+    lv_refr_now(NULL);
+
+    uint32_t full;
+    for(full = 0; full <= 1; full++) {
+        uint32_t px_cnt = 0;
+        uint32_t frame_cnt = 0;
+        clock_t t = clock();
+        uint32_t i;
+        for(i = 0; i < loop_cnt * SPINNER_FRAMES; i++) {
+            next_frame(obj);
+            if(full) lv_obj_invalidate(obj);
+            px_cnt += get_inv_px_cnt();
+            lv_refr_now(NULL);
+            frame_cnt++;
+        }
+        uint32_t us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+        lv_snprintf(msg, sizeof(msg), "GIF %s invalidation: %d frames of 200x200, %d us and %d px per frame",
+                    full ? "whole object" : "frame area", (int)frame_cnt, (int)(us / frame_cnt), (int)(px_cnt / frame_cnt));
+        TEST_MESSAGE(msg);
+
+        if(full) full_px_cnt = px_cnt;
+        else delta_px_cnt = px_cnt;
+    }
+
+    TEST_ASSERT_LESS_THAN(full_px_cnt / 10, delta_px_cnt);
+}
+
+#else /*LV_USE_GIF && LV_COLOR_DEPTH == 32*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_gif_dispose_same_as_ref(void)
+{
+
+}
+
+void test_gif_spinner_same_as_ref(void)
+{
+
+}
+
+void test_gif_frame_period(void)
+{
+
+}
+
+void test_gif_invalidate_frame_area(void)
+{
+
+}
+
+void test_gif_invalidate_transformed(void)
+{
+
+}
+
+void test_gif_partial_refresh_same_as_full(void)
+{
+
+}
+
+void test_gif_benchmark(void)
+{
+
+}
+
+#endif /*LV_USE_GIF && LV_COLOR_DEPTH == 32*/
+
+#endif
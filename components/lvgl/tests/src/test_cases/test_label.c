@@ -0,0 +1,422 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+#include "lv_test_indev.h"
+
+void setUp(void);
+void tearDown(void);
+void test_label_fixed_capacity_set_text(void);
+void test_label_fixed_capacity_truncate_utf8(void);
+void test_label_fixed_capacity_fmt(void);
+void test_label_fixed_capacity_ins_text(void);
+void test_label_fixed_capacity_leave(void);
+void test_label_fixed_capacity_same_text_not_invalidated(void);
+void test_label_fixed_capacity_invalidate_changed_glyphs(void);
+void test_label_fixed_capacity_invalidate_moved_line(void);
+void test_label_fixed_capacity_1khz_benchmark(void);
+void test_label_invalidate_same_text(void);
+void test_label_invalidate_changed_glyphs(void);
+void test_label_invalidate_changed_line(void);
+void test_label_invalidate_new_line(void);
+void test_label_invalidate_layout_shift(void);
+void test_label_invalidate_static_text(void);
+void test_label_invalidate_clock_pixels(void);
+
+#if LV_FONT_MONTSERRAT_48
+    #define BIG_FONT    &lv_font_montserrat_48
+#else
+    #define BIG_FONT    LV_FONT_DEFAULT
+#endif
+
+static lv_obj_t * label;
+static uint32_t px_cnt;
+
+static void monitor_cb(lv_disp_drv_t * disp_drv, uint32_t time, uint32_t px)
+{
+    LV_UNUSED(disp_drv);
+    LV_UNUSED(time);
+    px_cnt += px;
+}
+
+/*Sum of the invalidated areas. The overlaps are counted multiple times.*/
+static uint32_t get_inv_px(void)
+{
+    lv_disp_t * disp = lv_disp_get_default();
+    uint32_t px = 0;
+    uint32_t i;
+    for(i = 0; i < disp->inv_p; i++) {
+        px += lv_area_get_size(&disp->inv_areas[i]);
+    }
+    return px;
+}
+
+static bool is_invalidated(const lv_area_t * a)
+{
+    lv_disp_t * disp = lv_disp_get_default();
+    uint32_t i;
+    for(i = 0; i < disp->inv_p; i++) {
+        if(_lv_area_is_in(a, &disp->inv_areas[i], 0)) return true;
+    }
+    return false;
+}
+
+static uint32_t get_alloc_cnt(void)
+{
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.alloc_cnt;
+}
+
+/*Update the text of `label` every ms for a second like a 1 kHz sensor would do.
+ *Return the number of allocations made by the updates.*/
+static uint32_t run_1khz(bool inv_all)
+{
+    uint32_t alloc_cnt = 0;
+    uint32_t i;
+    for(i = 0; i < 1000; i++) {
+        uint32_t alloc_cnt_start = get_alloc_cnt();
+        lv_label_set_text_fmt(label, "Temp: %d.%d C", 20 + (i / 100) % 10, (i / 10) % 10);
+        alloc_cnt += get_alloc_cnt() - alloc_cnt_start;
+        if(inv_all) lv_obj_invalidate(label);
+
+        lv_test_indev_wait(1);
+    }
+
+    return alloc_cnt;
+}
+
+void setUp(void)
+{
+    label = lv_label_create(lv_scr_act());
+    lv_obj_set_width(label, 200);
+    lv_label_set_text(label, "Temp: 00.0 C");
+
+    lv_refr_now(NULL);
+    px_cnt = 0;
+    lv_disp_get_default()->driver->monitor_cb = monitor_cb;
+}
+
+void tearDown(void)
+{
+    lv_disp_get_default()->driver->monitor_cb = NULL;
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_label_fixed_capacity_set_text(void)
+{
+    lv_label_set_text_capacity(label, 8);
+    TEST_ASSERT_EQUAL(8, lv_label_get_text_capacity(label));
+    TEST_ASSERT_EQUAL_STRING("Temp: 0", lv_label_get_text(label));
+
+    lv_label_set_text(label, "Hello");
+    TEST_ASSERT_EQUAL_STRING("Hello", lv_label_get_text(label));
+
+    lv_label_set_text(label, "1234567");
+    TEST_ASSERT_EQUAL_STRING("1234567", lv_label_get_text(label));
+
+    /*Too long texts are truncated*/
+    lv_label_set_text(label, "123456789");
+    TEST_ASSERT_EQUAL_STRING("1234567", lv_label_get_text(label));
+
+    /*Setting its own text just refreshes it*/
+    lv_label_set_text(label, lv_label_get_text(label));
+    lv_label_set_text(label, NULL);
+    TEST_ASSERT_EQUAL_STRING("1234567", lv_label_get_text(label));
+}
+
+void test_label_fixed_capacity_truncate_utf8(void)
+{
+    lv_label_set_text_capacity(label, 8);
+
+    /*"°" takes 2 bytes and only 1 would fit*/
+    lv_label_set_text(label, "23.5 C \xC2\xB0");
+    TEST_ASSERT_EQUAL_STRING("23.5 C ", lv_label_get_text(label));
+
+    lv_label_set_text(label, "23.5 \xC2\xB0" "C");
+    TEST_ASSERT_EQUAL_STRING("23.5 \xC2\xB0", lv_label_get_text(label));
+
+    lv_label_set_text_fmt(label, "%d.%d C %s", 23, 5, "\xC2\xB0");
+    TEST_ASSERT_EQUAL_STRING("23.5 C ", lv_label_get_text(label));
+}
+
+void test_label_fixed_capacity_fmt(void)
+{
+    lv_label_set_text_capacity(label, 16);
+
+    lv_label_set_text_fmt(label, "%d.%d C", 23, 5);
+    TEST_ASSERT_EQUAL_STRING("23.5 C", lv_label_get_text(label));
+
+    lv_label_set_text_fmt(label, "%s %d %d", "Value:", 12345, 67890);
+    TEST_ASSERT_EQUAL_STRING("Value: 12345 67", lv_label_get_text(label));
+}
+
+void test_label_fixed_capacity_ins_text(void)
+{
+    lv_label_set_text_capacity(label, 8);
+    lv_label_set_text(label, "23 C");
+
+    lv_label_ins_text(label, 2, ".5");
+    TEST_ASSERT_EQUAL_STRING("23.5 C", lv_label_get_text(label));
+
+    lv_label_ins_text(label, LV_LABEL_POS_LAST, "!");
+    TEST_ASSERT_EQUAL_STRING("23.5 C!", lv_label_get_text(label));
+
+    /*Doesn't fit*/
+    lv_label_ins_text(label, 0, "-");
+    TEST_ASSERT_EQUAL_STRING("23.5 C!", lv_label_get_text(label));
+
+    lv_label_cut_text(label, 0, 3);
+    TEST_ASSERT_EQUAL_STRING("5 C!", lv_label_get_text(label));
+}
+
+void test_label_fixed_capacity_leave(void)
+{
+    lv_label_set_text_capacity(label, 32);
+    lv_label_set_text(label, "Fixed");
+
+    lv_label_set_text_capacity(label, 0);
+    TEST_ASSERT_EQUAL(0, lv_label_get_text_capacity(label));
+    TEST_ASSERT_EQUAL_STRING("Fixed", lv_label_get_text(label));
+
+    lv_label_set_text(label, "A longer text than the capacity was");
+    TEST_ASSERT_EQUAL_STRING("A longer text than the capacity was", lv_label_get_text(label));
+
+    /*A static text also leaves the fixed capacity mode*/
+    lv_label_set_text_capacity(label, 32);
+    lv_label_set_text_static(label, "Static");
+    TEST_ASSERT_EQUAL(0, lv_label_get_text_capacity(label));
+    TEST_ASSERT_EQUAL_STRING("Static", lv_label_get_text(label));
+}
+
+void test_label_fixed_capacity_same_text_not_invalidated(void)
+{
+    lv_label_set_text_capacity(label, 16);
+    lv_refr_now(NULL);
+
+    lv_label_set_text(label, "Temp: 00.0 C");
+    lv_label_set_text_fmt(label, "Temp: %02d.%d C", 0, 0);
+    TEST_ASSERT_EQUAL(0, lv_disp_get_default()->inv_p);
+}
+
+void test_label_fixed_capacity_invalidate_changed_glyphs(void)
+{
+    lv_label_set_text_capacity(label, 32);
+    lv_refr_now(NULL);
+
+    /*The same width: only about two digits wide but the full line high*/
+    lv_label_set_text(label, "Temp: 10.0 C");
+    lv_refr_now(NULL);
+    lv_label_set_text(label, "Temp: 01.0 C");
+    lv_disp_t * disp = lv_disp_get_default();
+    TEST_ASSERT_EQUAL(1, disp->inv_p);
+
+    const lv_font_t * font = lv_obj_get_style_text_font(label, LV_PART_MAIN);
+    lv_coord_t font_h = lv_font_get_line_height(font);
+    lv_coord_t digits_w = lv_txt_get_width("01", 2, font, 0, LV_TEXT_FLAG_NONE);
+    lv_coord_t prefix_w = lv_txt_get_width("Temp: ", 6, font, 0, LV_TEXT_FLAG_NONE);
+    /*The invalidated areas are increased by 5 px on each side*/
+    TEST_ASSERT_LESS_OR_EQUAL(digits_w + font_h + 10, lv_area_get_width(&disp->inv_areas[0]));
+    TEST_ASSERT_GREATER_OR_EQUAL(font_h, lv_area_get_height(&disp->inv_areas[0]));
+    TEST_ASSERT_LESS_OR_EQUAL(label->coords.x1 + prefix_w, disp->inv_areas[0].x1);
+    TEST_ASSERT_GREATER_OR_EQUAL(label->coords.x1 + prefix_w + digits_w - 1, disp->inv_areas[0].x2);
+
+    /*A different width on a left aligned label invalidates until the end of the line*/
+    lv_refr_now(NULL);
+    lv_label_set_text(label, "Temp: 01.5 C (max)");
+    lv_coord_t w = lv_txt_get_width("Temp: 01.5 C (max)", 18, font, 0, LV_TEXT_FLAG_NONE);
+    prefix_w = lv_txt_get_width("Temp: 01.", 9, font, 0, LV_TEXT_FLAG_NONE);
+    TEST_ASSERT_EQUAL(1, disp->inv_p);
+    TEST_ASSERT_LESS_OR_EQUAL(label->coords.x1 + prefix_w, disp->inv_areas[0].x1);
+    TEST_ASSERT_GREATER_THAN(label->coords.x1 + prefix_w - font_h, disp->inv_areas[0].x1);
+    TEST_ASSERT_GREATER_OR_EQUAL(label->coords.x1 + w - 1, disp->inv_areas[0].x2);
+    TEST_ASSERT_LESS_THAN(label->coords.x2, disp->inv_areas[0].x2);
+}
+
+void test_label_fixed_capacity_invalidate_moved_line(void)
+{
+    lv_label_set_text_capacity(label, 16);
+    lv_obj_set_style_text_align(label, LV_TEXT_ALIGN_CENTER, 0);
+    lv_refr_now(NULL);
+
+    /*Same width, only the digits are redrawn*/
+    lv_label_set_text(label, "Temp: 12.0 C");
+    lv_refr_now(NULL);
+    lv_label_set_text(label, "Temp: 21.0 C");
+    lv_disp_t * disp = lv_disp_get_default();
+    TEST_ASSERT_EQUAL(1, disp->inv_p);
+    TEST_ASSERT_LESS_THAN(lv_obj_get_width(label) / 2, lv_area_get_width(&disp->inv_areas[0]));
+
+    /*The centered line moves so all of its glyphs are redrawn*/
+    lv_refr_now(NULL);
+    lv_label_set_text(label, "Temp: 100.5 C");
+    const lv_font_t * font = lv_obj_get_style_text_font(label, LV_PART_MAIN);
+    lv_coord_t old_w = lv_txt_get_width("Temp: 21.0 C", 12, font, 0, LV_TEXT_FLAG_NONE);
+    lv_coord_t new_w = lv_txt_get_width("Temp: 100.5 C", 13, font, 0, LV_TEXT_FLAG_NONE);
+    TEST_ASSERT_EQUAL(1, disp->inv_p);
+    TEST_ASSERT_LESS_OR_EQUAL(label->coords.x1 + (200 - new_w) / 2, disp->inv_areas[0].x1);
+    TEST_ASSERT_GREATER_OR_EQUAL(label->coords.x1 + (200 + old_w) / 2 - 1, disp->inv_areas[0].x2);
+}
+
+void test_label_fixed_capacity_1khz_benchmark(void)
+{
+    /*Normal label redrawn entirely on every change*/
+    uint32_t normal_alloc_cnt = run_1khz(true);
+    uint32_t normal_px_cnt = px_cnt;
+
+    /*The same with fixed capacity*/
+    lv_label_set_text_capacity(label, 16);
+    lv_label_set_text(label, "Temp: 00.0 C");
+    lv_refr_now(NULL);
+    px_cnt = 0;
+
+    uint32_t fixed_alloc_cnt = run_1khz(false);
+    uint32_t fixed_px_cnt = px_cnt;
+
+    char buf[128];
+    lv_snprintf(buf, sizeof(buf), "1 kHz label updates: allocations %d -> %d, rendered pixels %d -> %d",
+                (int)normal_alloc_cnt, (int)fixed_alloc_cnt, (int)normal_px_cnt, (int)fixed_px_cnt);
+    TEST_MESSAGE(buf);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(1000, normal_alloc_cnt);
+    TEST_ASSERT_EQUAL(0, fixed_alloc_cnt);
+    TEST_ASSERT_LESS_THAN(normal_px_cnt / 2, fixed_px_cnt);
+}
+
+void test_label_invalidate_same_text(void)
+{
+    lv_label_set_text(label, "Temp: 00.0 C");
+    lv_label_set_text_fmt(label, "Temp: %02d.%d C", 0, 0);
+    TEST_ASSERT_EQUAL(0, lv_disp_get_default()->inv_p);
+}
+
+void test_label_invalidate_changed_glyphs(void)
+{
+    lv_obj_set_style_text_font(label, BIG_FONT, 0);
+    lv_obj_set_width(label, 400);
+    lv_label_set_text(label, "12:34:56");
+    lv_refr_now(NULL);
+
+    lv_label_set_text(label, "12:34:58");
+
+    /*Only the box of the last digits*/
+    lv_area_t full;
+    lv_obj_get_coords(label, &full);
+    lv_area_increase(&full, _lv_obj_get_ext_draw_size(label), _lv_obj_get_ext_draw_size(label));
+    TEST_ASSERT_EQUAL(1, lv_disp_get_default()->inv_p);
+    TEST_ASSERT_LESS_THAN(lv_area_get_size(&full) / 8, get_inv_px());
+
+    const lv_area_t * a = &lv_disp_get_default()->inv_areas[0];
+    lv_coord_t prefix_w = lv_txt_get_width("12:34:5", 7, BIG_FONT, 0, LV_TEXT_FLAG_NONE);
+    lv_coord_t w = lv_txt_get_width("12:34:58", 8, BIG_FONT, 0, LV_TEXT_FLAG_NONE);
+    TEST_ASSERT_GREATER_OR_EQUAL(label->coords.x1 + prefix_w - 5, a->x1);
+    TEST_ASSERT_LESS_OR_EQUAL(label->coords.x1 + w + 5, a->x2);
+
+    /*The glyphs are not as high as the line*/
+    TEST_ASSERT_LESS_THAN(lv_font_get_line_height(BIG_FONT) + 10, lv_area_get_height(a));
+}
+
+void test_label_invalidate_changed_line(void)
+{
+    lv_obj_set_width(label, 200);
+    lv_label_set_text(label, "Temperature\n21.5\nHumidity");
+    lv_refr_now(NULL);
+
+    lv_label_set_text(label, "Temperature\n22.5\nHumidity");
+
+    /*Only in the second line*/
+    lv_coord_t line_h = lv_font_get_line_height(LV_FONT_DEFAULT);
+    const lv_area_t * a = &lv_disp_get_default()->inv_areas[0];
+    TEST_ASSERT_EQUAL(1, lv_disp_get_default()->inv_p);
+    TEST_ASSERT_GREATER_OR_EQUAL(label->coords.y1 + line_h - 5, a->y1);
+    TEST_ASSERT_LESS_OR_EQUAL(label->coords.y1 + 2 * line_h + 5, a->y2);
+    TEST_ASSERT_LESS_THAN(100, lv_area_get_width(a));
+}
+
+void test_label_invalidate_new_line(void)
+{
+    lv_obj_set_size(label, 200, 200);
+    lv_label_set_text(label, "Line 1\nLine 2");
+    lv_refr_now(NULL);
+
+    lv_label_set_text(label, "Line 1\nLine 2\nLine 3");
+
+    /*Only the new line*/
+    lv_coord_t line_h = lv_font_get_line_height(LV_FONT_DEFAULT);
+    const lv_area_t * a = &lv_disp_get_default()->inv_areas[0];
+    TEST_ASSERT_EQUAL(1, lv_disp_get_default()->inv_p);
+    TEST_ASSERT_GREATER_OR_EQUAL(label->coords.y1 + 2 * line_h - 5, a->y1);
+    TEST_ASSERT_LESS_OR_EQUAL(label->coords.y1 + 3 * line_h + 5, a->y2);
+
+    /*A longer first line wraps and moves all lines*/
+    lv_refr_now(NULL);
+    lv_label_set_text(label, "A very long first line which wraps\nLine 2\nLine 3");
+    lv_area_t lines = label->coords;
+    lines.y2 = lines.y1 + 4 * line_h - 1;
+    lv_area_t line_4 = lines;
+    line_4.y1 = lines.y1 + 3 * line_h;
+    lv_area_t glyphs;
+    lv_area_set(&glyphs, label->coords.x1 + 10, line_4.y1 + 5, label->coords.x1 + 30, line_4.y2 - 5);
+    TEST_ASSERT_TRUE(is_invalidated(&glyphs));
+}
+
+void test_label_invalidate_layout_shift(void)
+{
+    /*Like a centered temperature*/
+    lv_obj_set_width(label, LV_SIZE_CONTENT);
+    lv_obj_set_style_text_font(label, BIG_FONT, 0);
+    lv_obj_center(label);
+    lv_label_set_text(label, "21.5");
+    lv_refr_now(NULL);
+
+    lv_area_t old_coords = label->coords;
+    lv_label_set_text(label, "22");
+    lv_obj_update_layout(label);
+
+    /*The label has moved so both the old and the new place are redrawn*/
+    TEST_ASSERT_FALSE(_lv_area_is_equal(&old_coords, &label->coords));
+    TEST_ASSERT_TRUE(is_invalidated(&old_coords));
+    TEST_ASSERT_TRUE(is_invalidated(&label->coords));
+}
+
+void test_label_invalidate_static_text(void)
+{
+    static char buf[16] = "Temp: 00.0 C";
+    lv_label_set_text_static(label, buf);
+    lv_refr_now(NULL);
+
+    /*It could have been changed in place so the whole label is redrawn*/
+    lv_label_set_text(label, "Temp: 00.5 C");
+    lv_area_t full;
+    lv_obj_get_coords(label, &full);
+    TEST_ASSERT_TRUE(is_invalidated(&full));
+}
+
+void test_label_invalidate_clock_pixels(void)
+{
+    lv_obj_set_style_text_font(label, BIG_FONT, 0);
+    lv_obj_set_width(label, 400);
+
+    /*A clock ticking for 2 minutes, redrawn entirely and only where changed*/
+    uint32_t px_full = 0;
+    uint32_t px_diff = 0;
+    uint32_t i;
+    for(i = 0; i < 2 * 2 * 60; i++) {
+        bool full = i < 2 * 60;
+        uint32_t sec = i % 120;
+        lv_label_set_text_fmt(label, "12:%02d:%02d", (int)sec / 60, (int)sec % 60);
+        if(full) lv_obj_invalidate(label);
+
+        px_cnt = 0;
+        lv_refr_now(NULL);
+        if(full) px_full += px_cnt;
+        else px_diff += px_cnt;
+    }
+
+    char buf[128];
+    lv_snprintf(buf, sizeof(buf), "Clock label rendered pixels: %d -> %d", (int)px_full, (int)px_diff);
+    TEST_MESSAGE(buf);
+    TEST_ASSERT_LESS_THAN(px_full / 3, px_diff);
+}
+
+#endif
@@ -0,0 +1,271 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#include <time.h>
+
+#define CHILD_CNT   300
+#define BENCH_CHILD_CNT     3000
+#define BENCH_SEARCH_CNT    5000
+
+void setUp(void);
+void tearDown(void);
+void test_obj_spatial_index_initial(void);
+void test_obj_spatial_index_move_and_resize(void);
+void test_obj_spatial_index_scroll(void);
+void test_obj_spatial_index_reorder_and_delete(void);
+void test_obj_spatial_index_special_children(void);
+void test_obj_spatial_index_benchmark(void);
+
+static lv_obj_t * cont;
+static uint32_t seed;
+
+static uint32_t rnd(uint32_t max)
+{
+    seed = seed * 1103515245 + 12345;
+    return ((seed >> 16) & 0x7fff) % max;
+}
+
+/*The same search as `lv_indev_search_obj` but checks every child*/
+static lv_obj_t * search_linear(lv_obj_t * obj, const lv_point_t * point)
+{
+    if(lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) return NULL;
+
+    lv_point_t p_trans = *point;
+    lv_obj_transform_point(obj, &p_trans, false, true);
+
+    bool hit_test_ok = lv_obj_hit_test(obj, &p_trans);
+
+    if(_lv_area_is_point_on(&obj->coords, &p_trans, 0) || lv_obj_has_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE)) {
+        int32_t i;
+        for(i = (int32_t)lv_obj_get_child_cnt(obj) - 1; i >= 0; i--) {
+            lv_obj_t * found_p = search_linear(lv_obj_get_child(obj, i), &p_trans);
+            if(found_p) return found_p;
+        }
+    }
+
+    return hit_test_ok ? obj : NULL;
+}
+
+static void check_points(void)
+{
+    lv_obj_update_layout(lv_scr_act());
+
+    lv_point_t p;
+    for(p.y = -20; p.y < 500; p.y += 11) {
+        for(p.x = -20; p.x < 820; p.x += 11) {
+            lv_obj_t * expected = search_linear(lv_scr_act(), &p);
+            lv_obj_t * found = lv_indev_search_obj(lv_scr_act(), &p);
+            TEST_ASSERT_EQUAL_PTR(expected, found);
+        }
+    }
+}
+
+void setUp(void)
+{
+    seed = 1;
+    cont = lv_obj_create(lv_scr_act());
+    lv_obj_remove_style_all(cont);
+    lv_obj_set_size(cont, 800, 480);
+
+    uint32_t i;
+    for(i = 0; i < CHILD_CNT; i++) {
+        lv_obj_t * obj = lv_obj_create(cont);
+        lv_obj_remove_style_all(obj);
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_set_pos(obj, rnd(1200), rnd(900));
+        lv_obj_set_size(obj, 5 + rnd(80), 5 + rnd(80));
+    }
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_obj_spatial_index_initial(void)
+{
+    check_points();
+}
+
+void test_obj_spatial_index_move_and_resize(void)
+{
+    check_points();
+
+    uint32_t i;
+    for(i = 0; i < 60; i++) {
+        lv_obj_t * obj = lv_obj_get_child(cont, rnd(CHILD_CNT));
+        lv_obj_set_pos(obj, rnd(900) - 50, rnd(600) - 50);
+    }
+    check_points();
+
+    for(i = 0; i < 60; i++) {
+        lv_obj_t * obj = lv_obj_get_child(cont, rnd(CHILD_CNT));
+        lv_obj_set_size(obj, rnd(300), rnd(200));
+    }
+    check_points();
+
+    /*Move the container itself with its children*/
+    lv_obj_set_pos(cont, -30, 40);
+    check_points();
+}
+
+void test_obj_spatial_index_scroll(void)
+{
+    check_points();
+
+    lv_obj_scroll_to(cont, 200, 150, LV_ANIM_OFF);
+    check_points();
+
+    /*A floating child doesn't move with the others*/
+    lv_obj_t * floating = lv_obj_get_child(cont, 10);
+    lv_obj_add_flag(floating, LV_OBJ_FLAG_FLOATING);
+    lv_obj_set_size(floating, 200, 200);
+    lv_obj_scroll_by(cont, 100, 100, LV_ANIM_OFF);
+    check_points();
+
+    lv_obj_set_pos(lv_obj_get_child(cont, 20), 10, 10);
+    lv_obj_scroll_to(cont, 0, 0, LV_ANIM_OFF);
+    check_points();
+}
+
+void test_obj_spatial_index_reorder_and_delete(void)
+{
+    check_points();
+
+    uint32_t i;
+    for(i = 0; i < 20; i++) {
+        lv_obj_move_foreground(lv_obj_get_child(cont, rnd(CHILD_CNT)));
+        lv_obj_move_background(lv_obj_get_child(cont, rnd(CHILD_CNT)));
+    }
+    check_points();
+
+    lv_obj_swap(lv_obj_get_child(cont, 3), lv_obj_get_child(cont, 250));
+    check_points();
+
+    for(i = 0; i < 50; i++) {
+        lv_obj_del(lv_obj_get_child(cont, rnd(lv_obj_get_child_cnt(cont))));
+    }
+    check_points();
+
+    /*Move children between two indexed parents*/
+    lv_obj_t * cont2 = lv_obj_create(lv_scr_act());
+    lv_obj_remove_style_all(cont2);
+    lv_obj_set_size(cont2, 400, 300);
+    for(i = 0; i < 40; i++) {
+        lv_obj_t * obj = lv_obj_create(cont2);
+        lv_obj_remove_style_all(obj);
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_set_pos(obj, rnd(400), rnd(300));
+        lv_obj_set_size(obj, 10 + rnd(40), 10 + rnd(40));
+    }
+    check_points();
+
+    for(i = 0; i < 30; i++) {
+        lv_obj_set_parent(lv_obj_get_child(cont, rnd(lv_obj_get_child_cnt(cont))), cont2);
+    }
+    check_points();
+
+    /*Drop below the limit*/
+    lv_obj_clean(cont2);
+    check_points();
+}
+
+void test_obj_spatial_index_special_children(void)
+{
+    check_points();
+
+    lv_obj_t * obj = lv_obj_get_child(cont, 100);
+    lv_obj_set_pos(obj, 300, 200);
+    lv_obj_set_ext_click_area(obj, 40);
+    check_points();
+
+    /*The children of this child stick out of it*/
+    obj = lv_obj_get_child(cont, 150);
+    lv_obj_set_pos(obj, 100, 100);
+    lv_obj_set_size(obj, 20, 20);
+    lv_obj_t * grandchild = lv_obj_create(obj);
+    lv_obj_remove_style_all(grandchild);
+    lv_obj_add_flag(grandchild, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_pos(grandchild, 100, 50);
+    lv_obj_set_size(grandchild, 100, 100);
+    lv_obj_add_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE);
+    check_points();
+
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE);
+    check_points();
+
+    /*A zoomed child can be hit outside of its coordinates*/
+    obj = lv_obj_get_child(cont, 200);
+    lv_obj_set_pos(obj, 400, 300);
+    lv_obj_set_size(obj, 40, 40);
+    lv_obj_set_style_transform_zoom(obj, 1024, 0);
+    check_points();
+
+    lv_obj_set_style_transform_zoom(obj, 256, 0);
+    check_points();
+
+    lv_obj_add_flag(lv_obj_get_child(cont, 50), LV_OBJ_FLAG_HIDDEN);
+    check_points();
+}
+
+void test_obj_spatial_index_benchmark(void)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_obj_t * big = lv_obj_create(lv_scr_act());
+    lv_obj_remove_style_all(big);
+    lv_obj_set_size(big, 800, 480);
+
+    uint32_t i;
+    for(i = 0; i < BENCH_CHILD_CNT; i++) {
+        lv_obj_t * obj = lv_obj_create(big);
+        lv_obj_remove_style_all(obj);
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_set_pos(obj, rnd(780), rnd(460));
+        lv_obj_set_size(obj, 5 + rnd(30), 5 + rnd(30));
+    }
+    lv_obj_update_layout(lv_scr_act());
+
+    lv_point_t points[64];
+    for(i = 0; i < 64; i++) {
+        points[i].x = rnd(800);
+        points[i].y = rnd(480);
+    }
+
+    /*The first search builds the grid*/
+    lv_indev_search_obj(lv_scr_act(), &points[0]);
+
+    clock_t t = clock();
+    for(i = 0; i < BENCH_SEARCH_CNT; i++) {
+        lv_indev_search_obj(lv_scr_act(), &points[i % 64]);
+    }
+    uint32_t indexed_us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+    t = clock();
+    for(i = 0; i < BENCH_SEARCH_CNT; i++) {
+        search_linear(lv_scr_act(), &points[i % 64]);
+    }
+    uint32_t linear_us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+    /*Moving a child updates its cells, no rebuild*/
+    t = clock();
+    for(i = 0; i < BENCH_SEARCH_CNT; i++) {
+        lv_obj_set_pos(lv_obj_get_child(big, rnd(BENCH_CHILD_CNT)), rnd(780), rnd(460));
+        lv_indev_search_obj(lv_scr_act(), &points[i % 64]);
+    }
+    uint32_t move_us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+    char msg[256];
+    lv_snprintf(msg, sizeof(msg),
+                "%d children, %d searches: linear %d us, indexed %d us, indexed with a move before each %d us",
+                BENCH_CHILD_CNT, BENCH_SEARCH_CNT, (int)linear_us, (int)indexed_us, (int)move_us);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_LESS_THAN(linear_us / 4, indexed_us);
+
+    /*Still the same results after all the moves*/
+    check_points();
+}
+
+#endif
@@ -0,0 +1,358 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+#include "lv_test_indev.h"
+
+void setUp(void);
+void tearDown(void);
+void test_pager_slow_drag_over_half(void);
+void test_pager_short_drag_snaps_back(void);
+void test_pager_fling(void);
+void test_pager_fling_backwards_snaps_back(void);
+void test_pager_no_neighbour(void);
+void test_pager_vertical_drag_ignored(void);
+void test_pager_click_not_captured(void);
+void test_pager_bubble_disabled(void);
+void test_pager_catch_while_settling(void);
+void test_pager_stat(void);
+
+#if LV_USE_PAGER
+
+static lv_obj_t * scr_ori;
+static lv_obj_t * scr[3];
+static lv_obj_t * btn;
+static lv_pager_t * pager;
+static lv_obj_t * changed_scr;
+static uint32_t click_cnt;
+static uint32_t press_lost_cnt;
+
+static void change_cb(lv_pager_t * p, lv_obj_t * s)
+{
+    LV_UNUSED(p);
+    changed_scr = s;
+}
+
+static void btn_event_cb(lv_event_t * e)
+{
+    if(lv_event_get_code(e) == LV_EVENT_CLICKED) click_cnt++;
+    else if(lv_event_get_code(e) == LV_EVENT_PRESS_LOST) press_lost_cnt++;
+}
+
+/*Touch at `x_start`, move to `x_end` in `step_cnt` steps waiting `step_time` ms each,
+ *stand still for `hold_time` ms and release*/
+static void swipe(lv_coord_t x_start, lv_coord_t x_end, uint32_t step_cnt, uint32_t step_time, uint32_t hold_time)
+{
+    lv_test_mouse_move_to(x_start, 240);
+    lv_test_mouse_press();
+    lv_test_indev_wait(step_time);
+
+    uint32_t i;
+    for(i = 1; i <= step_cnt; i++) {
+        lv_test_mouse_move_to(x_start + (x_end - x_start) * (int32_t)i / (int32_t)step_cnt, 240);
+        lv_test_indev_wait(step_time);
+    }
+
+    if(hold_time) lv_test_indev_wait(hold_time);
+    lv_test_mouse_release();
+    lv_test_indev_wait(500);
+}
+
+void setUp(void)
+{
+    scr_ori = lv_scr_act();
+
+    uint32_t i;
+    for(i = 0; i < 3; i++) {
+        scr[i] = lv_obj_create(NULL);
+    }
+
+    btn = lv_btn_create(scr[0]);
+    lv_obj_set_size(btn, 200, 100);
+    lv_obj_center(btn);
+    lv_obj_add_event_cb(btn, btn_event_cb, LV_EVENT_ALL, NULL);
+
+    lv_scr_load(scr[0]);
+    lv_test_indev_wait(50);
+
+    pager = lv_pager_create(lv_test_mouse_indev);
+    for(i = 0; i < 3; i++) {
+        lv_pager_add_screen(pager, scr[i]);
+    }
+    lv_pager_set_change_cb(pager, change_cb);
+
+    changed_scr = NULL;
+    click_cnt = 0;
+    press_lost_cnt = 0;
+}
+
+void tearDown(void)
+{
+    lv_pager_del(pager);
+    lv_scr_load(scr_ori);
+
+    uint32_t i;
+    for(i = 0; i < 3; i++) {
+        lv_obj_del(scr[i]);
+    }
+}
+
+void test_pager_slow_drag_over_half(void)
+{
+    /*Follows the finger while dragging*/
+    lv_test_mouse_move_to(700, 240);
+    lv_test_mouse_press();
+    lv_test_indev_wait(50);
+    lv_test_mouse_move_to(400, 240);
+    lv_test_indev_wait(50);
+
+    TEST_ASSERT_TRUE(lv_pager_is_active(pager));
+    lv_coord_t offset = lv_pager_get_offset(pager);
+    TEST_ASSERT_LESS_THAN(-250, offset);
+    TEST_ASSERT_EQUAL(offset, lv_obj_get_x(scr[0]));
+    TEST_ASSERT_EQUAL(offset + 800, lv_obj_get_x(scr[1]));
+    TEST_ASSERT_EQUAL_PTR(scr[1], lv_disp_get_default()->prev_scr);
+
+    lv_test_mouse_move_to(200, 240);
+    lv_test_indev_wait(200);
+    lv_test_mouse_release();
+    lv_test_indev_wait(500);
+
+    TEST_ASSERT_FALSE(lv_pager_is_active(pager));
+    TEST_ASSERT_EQUAL_PTR(scr[1], lv_scr_act());
+    TEST_ASSERT_EQUAL_PTR(scr[1], changed_scr);
+    TEST_ASSERT_NULL(lv_disp_get_default()->prev_scr);
+    TEST_ASSERT_EQUAL(0, lv_obj_get_x(scr[0]));
+    TEST_ASSERT_EQUAL(0, lv_obj_get_x(scr[1]));
+
+    /*And back*/
+    swipe(100, 600, 5, 30, 100);
+    TEST_ASSERT_EQUAL_PTR(scr[0], lv_scr_act());
+}
+
+void test_pager_short_drag_snaps_back(void)
+{
+    swipe(600, 450, 5, 30, 150);
+
+    TEST_ASSERT_EQUAL_PTR(scr[0], lv_scr_act());
+    TEST_ASSERT_NULL(changed_scr);
+    TEST_ASSERT_EQUAL(0, lv_pager_get_offset(pager));
+    TEST_ASSERT_EQUAL(0, lv_obj_get_x(scr[0]));
+    TEST_ASSERT_NULL(lv_disp_get_default()->prev_scr);
+}
+
+void test_pager_fling(void)
+{
+    /*A short but fast swipe is enough*/
+    swipe(600, 480, 3, 30, 0);
+
+    TEST_ASSERT_EQUAL_PTR(scr[1], lv_scr_act());
+
+    swipe(600, 480, 3, 30, 0);
+    TEST_ASSERT_EQUAL_PTR(scr[2], lv_scr_act());
+}
+
+void test_pager_fling_backwards_snaps_back(void)
+{
+    lv_test_mouse_move_to(700, 240);
+    lv_test_mouse_press();
+    lv_test_indev_wait(30);
+    lv_test_mouse_move_to(300, 240);
+    lv_test_indev_wait(100);
+    lv_test_mouse_move_to(340, 240);
+    lv_test_indev_wait(30);
+    lv_test_mouse_move_to(380, 240);
+    lv_test_indev_wait(30);
+    lv_test_mouse_release();
+    lv_test_indev_wait(500);
+
+    TEST_ASSERT_EQUAL_PTR(scr[0], lv_scr_act());
+}
+
+void test_pager_no_neighbour(void)
+{
+    /*There is nothing on the left of the first screen*/
+    lv_test_mouse_move_to(100, 240);
+    lv_test_mouse_press();
+    lv_test_indev_wait(50);
+    lv_test_mouse_move_to(700, 240);
+    lv_test_indev_wait(50);
+
+    TEST_ASSERT_LESS_OR_EQUAL(600 / 4, lv_pager_get_offset(pager));
+    TEST_ASSERT_NULL(lv_disp_get_default()->prev_scr);
+
+    lv_test_mouse_release();
+    lv_test_indev_wait(500);
+    TEST_ASSERT_EQUAL_PTR(scr[0], lv_scr_act());
+    TEST_ASSERT_EQUAL(0, lv_obj_get_x(scr[0]));
+}
+
+void test_pager_vertical_drag_ignored(void)
+{
+    lv_test_mouse_move_to(100, 100);
+    lv_test_mouse_press();
+    lv_test_indev_wait(50);
+    lv_test_mouse_move_to(120, 300);
+    lv_test_indev_wait(50);
+    TEST_ASSERT_FALSE(lv_pager_is_active(pager));
+
+    /*Moving horizontally later doesn't start dragging either*/
+    lv_test_mouse_move_to(500, 300);
+    lv_test_indev_wait(50);
+    TEST_ASSERT_FALSE(lv_pager_is_active(pager));
+
+    lv_test_mouse_release();
+    lv_test_indev_wait(500);
+    TEST_ASSERT_EQUAL_PTR(scr[0], lv_scr_act());
+}
+
+void test_pager_click_not_captured(void)
+{
+    lv_test_mouse_click_at(400, 240);
+    TEST_ASSERT_EQUAL(1, click_cnt);
+    TEST_ASSERT_FALSE(lv_pager_is_active(pager));
+
+    /*Dragging from the button takes the press away from it*/
+    swipe(400, 100, 5, 30, 0);
+    TEST_ASSERT_EQUAL(1, click_cnt);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, press_lost_cnt);
+    TEST_ASSERT_FALSE(lv_obj_has_state(btn, LV_STATE_PRESSED));
+    TEST_ASSERT_EQUAL_PTR(scr[1], lv_scr_act());
+
+    /*The input works normally after the swipe*/
+    lv_scr_load(scr[0]);
+    lv_test_mouse_click_at(400, 240);
+    TEST_ASSERT_EQUAL(2, click_cnt);
+}
+
+void test_pager_bubble_disabled(void)
+{
+    lv_obj_clear_flag(btn, LV_OBJ_FLAG_GESTURE_BUBBLE);
+    swipe(400, 100, 5, 30, 0);
+
+    TEST_ASSERT_EQUAL_PTR(scr[0], lv_scr_act());
+    TEST_ASSERT_EQUAL(0, changed_scr);
+}
+
+void test_pager_catch_while_settling(void)
+{
+    lv_test_mouse_move_to(700, 240);
+    lv_test_mouse_press();
+    lv_test_indev_wait(30);
+    lv_test_mouse_move_to(600, 240);
+    lv_test_indev_wait(150);
+    lv_test_mouse_release();
+    lv_test_indev_wait(40);
+
+    /*Settling back, catch it and pull it to the next screen*/
+    TEST_ASSERT_TRUE(lv_pager_is_active(pager));
+    lv_coord_t offset = lv_pager_get_offset(pager);
+    TEST_ASSERT_LESS_THAN(0, offset);
+
+    lv_test_mouse_press();
+    lv_test_indev_wait(30);
+    TEST_ASSERT_EQUAL(offset, lv_pager_get_offset(pager));
+
+    lv_test_mouse_move_to(100, 240);
+    lv_test_indev_wait(200);
+    lv_test_mouse_release();
+    lv_test_indev_wait(500);
+
+    TEST_ASSERT_EQUAL_PTR(scr[1], lv_scr_act());
+}
+
+void test_pager_stat(void)
+{
+    lv_pager_reset_stat(pager);
+    swipe(700, 100, 10, 30, 100);
+
+    lv_pager_stat_t stat;
+    lv_pager_get_stat(pager, &stat);
+    TEST_ASSERT_EQUAL(1, stat.swipe_cnt);
+    TEST_ASSERT_GREATER_THAN(10, stat.frame_cnt);
+
+    /*The touches are rendered in the same cycle they are read*/
+    TEST_ASSERT_LESS_OR_EQUAL(1, stat.latency_max);
+    TEST_ASSERT_EQUAL(0, stat.frame_drop_cnt);
+
+    /*A stall while settling is detected*/
+    lv_pager_reset_stat(pager);
+    lv_test_mouse_move_to(700, 240);
+    lv_test_mouse_press();
+    lv_test_indev_wait(30);
+    lv_test_mouse_move_to(500, 240);
+    lv_test_indev_wait(150);
+    lv_test_mouse_release();
+    lv_test_indev_wait(60);
+    lv_tick_inc(100);
+    lv_test_indev_wait(500);
+
+    lv_pager_get_stat(pager, &stat);
+    TEST_ASSERT_GREATER_THAN(0, stat.frame_drop_cnt);
+}
+
+#else /*LV_USE_PAGER*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_pager_slow_drag_over_half(void)
+{
+
+}
+
+void test_pager_short_drag_snaps_back(void)
+{
+
+}
+
+void test_pager_fling(void)
+{
+
+}
+
+void test_pager_fling_backwards_snaps_back(void)
+{
+
+}
+
+void test_pager_no_neighbour(void)
+{
+
+}
+
+void test_pager_vertical_drag_ignored(void)
+{
+
+}
+
+void test_pager_click_not_captured(void)
+{
+
+}
+
+void test_pager_bubble_disabled(void)
+{
+
+}
+
+void test_pager_catch_while_settling(void)
+{
+
+}
+
+void test_pager_stat(void)
+{
+
+}
+
+#endif /*LV_USE_PAGER*/
+
+#endif
@@ -0,0 +1,393 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+void setUp(void);
+void tearDown(void);
+void test_png_stream_pixel_exact(void);
+void test_png_stream_c_array(void);
+void test_png_stream_random_access(void);
+void test_png_stream_interlaced_fallback(void);
+void test_png_stream_draw_pixel_exact(void);
+void test_png_stream_corrupted(void);
+void test_png_stream_benchmark(void);
+
+#if LV_USE_PNG && LV_PNG_STREAM && LV_COLOR_DEPTH == 32
+
+#include "../../src/extra/libs/png/lodepng.h"
+#include "../../src/extra/libs/png/lv_png_stream.h"
+#include <time.h>
+
+#define PNG_DIR "A:src/test_files/png/"
+
+extern lv_color_t test_fb[];
+
+static const char * stream_files[] = {
+    "rgba8_466.png",
+    "rgba16.png",
+    "rgb8_stored.png",
+    "rgb8_small_window.png",
+    "rgb16_key_fixed.png",
+    "gray1.png",
+    "gray2.png",
+    "gray4.png",
+    "gray8.png",
+    "gray16.png",
+    "gray_alpha8.png",
+    "gray_alpha16.png",
+    "palette1.png",
+    "palette2.png",
+    "palette4.png",
+    "palette8.png",
+};
+
+static lv_color_t ref_fb[800 * 480];
+
+/*Decode a PNG file with lodepng as reference in the format of `read_line`*/
+static uint8_t * decode_ref(const char * fn, uint32_t * w, uint32_t * h)
+{
+    uint8_t * rgba = NULL;
+    unsigned png_w;
+    unsigned png_h;
+    TEST_ASSERT_EQUAL(0, lodepng_decode32_file(&rgba, &png_w, &png_h, fn));
+    *w = png_w;
+    *h = png_h;
+
+    uint32_t i;
+    for(i = 0; i < png_w * png_h; i++) {
+        uint8_t * p = &rgba[i * 4];
+        lv_color32_t c;
+        c.ch.red = p[0];
+        c.ch.green = p[1];
+        c.ch.blue = p[2];
+        c.ch.alpha = p[3];
+        lv_memcpy_small(p, &c, 4);
+    }
+    return rgba;
+}
+
+static uint8_t * load_file(const char * fn, uint32_t * size)
+{
+    lv_fs_file_t f;
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, fn, LV_FS_MODE_RD));
+    lv_fs_seek(&f, 0, LV_FS_SEEK_END);
+    lv_fs_tell(&f, size);
+    lv_fs_seek(&f, 0, LV_FS_SEEK_SET);
+    uint8_t * data = lv_mem_alloc(*size);
+    uint32_t rn;
+    lv_fs_read(&f, data, *size, &rn);
+    lv_fs_close(&f);
+    TEST_ASSERT_EQUAL(*size, rn);
+    return data;
+}
+
+/*Compare all lines and some parts of the lines with the reference*/
+static void check_stream(const void * src, const uint8_t * ref, uint32_t w, uint32_t h)
+{
+    lv_png_stream_t * stream = lv_png_stream_open(src);
+    TEST_ASSERT_NOT_NULL(stream);
+
+    uint32_t stream_w;
+    uint32_t stream_h;
+    lv_png_stream_get_size(stream, &stream_w, &stream_h);
+    TEST_ASSERT_EQUAL(w, stream_w);
+    TEST_ASSERT_EQUAL(h, stream_h);
+
+    uint8_t * buf = lv_mem_alloc(w * 4);
+    uint32_t y;
+    for(y = 0; y < h; y++) {
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_png_stream_read_line(stream, 0, y, w, buf));
+        TEST_ASSERT_EQUAL_MEMORY(ref + y * w * 4, buf, w * 4);
+    }
+
+    /*Parts of the lines*/
+    for(y = 0; y < h; y += 3) {
+        uint32_t x = (y * 7) % w;
+        uint32_t len = LV_MIN(w - x, 1 + y % 11);
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_png_stream_read_line(stream, x, y, len, buf));
+        TEST_ASSERT_EQUAL_MEMORY(ref + (y * w + x) * 4, buf, len * 4);
+    }
+
+    lv_mem_free(buf);
+    lv_png_stream_close(stream);
+}
+
+void setUp(void)
+{
+    /* Function run before every test */
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_png_stream_pixel_exact(void)
+{
+    uint32_t i;
+    for(i = 0; i < sizeof(stream_files) / sizeof(stream_files[0]); i++) {
+        char fn[64];
+        lv_snprintf(fn, sizeof(fn), PNG_DIR "%s", stream_files[i]);
+        TEST_MESSAGE(fn);
+
+        uint32_t w;
+        uint32_t h;
+        uint8_t * ref = decode_ref(fn, &w, &h);
+        check_stream(fn, ref, w, h);
+        lv_mem_free(ref);
+    }
+}
+
+void test_png_stream_c_array(void)
+{
+    uint32_t w;
+    uint32_t h;
+    uint8_t * ref = decode_ref(PNG_DIR "rgb16_key_fixed.png", &w, &h);
+
+    lv_img_dsc_t dsc;
+    lv_memset_00(&dsc, sizeof(dsc));
+    dsc.data = load_file(PNG_DIR "rgb16_key_fixed.png", &dsc.data_size);
+    check_stream(&dsc, ref, w, h);
+
+    /*Through the image decoder*/
+    lv_img_header_t header;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_get_info(&dsc, &header));
+    TEST_ASSERT_EQUAL(w, header.w);
+    TEST_ASSERT_EQUAL(h, header.h);
+
+    lv_img_decoder_dsc_t dec_dsc;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&dec_dsc, &dsc, lv_color_black(), 0));
+    TEST_ASSERT_NULL(dec_dsc.img_data);
+    uint8_t buf[64 * 4];
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&dec_dsc, 0, 5, w, buf));
+    TEST_ASSERT_EQUAL_MEMORY(ref + 5 * w * 4, buf, w * 4);
+    lv_img_decoder_close(&dec_dsc);
+
+    lv_mem_free((void *)dsc.data);
+    lv_mem_free(ref);
+}
+
+void test_png_stream_random_access(void)
+{
+    const char * fn = PNG_DIR "rgba8_466.png";
+    uint32_t w;
+    uint32_t h;
+    uint8_t * ref = decode_ref(fn, &w, &h);
+    uint8_t * buf = lv_mem_alloc(w * 4);
+
+    lv_png_stream_t * stream = lv_png_stream_open(fn);
+    TEST_ASSERT_NOT_NULL(stream);
+    TEST_ASSERT_EQUAL(1, lv_png_stream_get_pass_cnt(stream));
+
+    /*Forward jumps and the last two lines don't restart the decoding*/
+    static const uint32_t ys[] = {100, 101, 100, 300, 465, 464};
+    uint32_t i;
+    for(i = 0; i < sizeof(ys) / sizeof(ys[0]); i++) {
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_png_stream_read_line(stream, 0, ys[i], w, buf));
+        TEST_ASSERT_EQUAL_MEMORY(ref + ys[i] * w * 4, buf, w * 4);
+    }
+    TEST_ASSERT_EQUAL(1, lv_png_stream_get_pass_cnt(stream));
+
+    /*Earlier lines are decoded again from the first line*/
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_png_stream_read_line(stream, 10, 50, 20, buf));
+    TEST_ASSERT_EQUAL_MEMORY(ref + (50 * w + 10) * 4, buf, 20 * 4);
+    TEST_ASSERT_EQUAL(2, lv_png_stream_get_pass_cnt(stream));
+
+    /*Out of the image*/
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_png_stream_read_line(stream, 0, h, 1, buf));
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_png_stream_read_line(stream, 1, 0, w, buf));
+
+    lv_png_stream_close(stream);
+    lv_mem_free(buf);
+    lv_mem_free(ref);
+}
+
+void test_png_stream_interlaced_fallback(void)
+{
+    const char * fn = PNG_DIR "rgba8_interlaced.png";
+    TEST_ASSERT_NULL(lv_png_stream_open(fn));
+
+    /*Decoded entirely instead*/
+    uint32_t w;
+    uint32_t h;
+    uint8_t * ref = decode_ref(fn, &w, &h);
+    lv_img_decoder_dsc_t dec_dsc;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&dec_dsc, fn, lv_color_black(), 0));
+    TEST_ASSERT_NOT_NULL(dec_dsc.img_data);
+    TEST_ASSERT_EQUAL_MEMORY(ref, dec_dsc.img_data, w * h * 4);
+    lv_img_decoder_close(&dec_dsc);
+    lv_mem_free(ref);
+}
+
+void test_png_stream_draw_pixel_exact(void)
+{
+    const char * fn = PNG_DIR "rgba8_466.png";
+    uint32_t w;
+    uint32_t h;
+    uint8_t * ref = decode_ref(fn, &w, &h);
+
+    lv_obj_set_style_bg_color(lv_scr_act(), lv_palette_main(LV_PALETTE_BLUE), 0);
+    lv_obj_t * img = lv_img_create(lv_scr_act());
+    lv_obj_set_pos(img, 100, -20);
+
+    /*The reference drawn as an uncompressed image*/
+    lv_img_dsc_t ref_dsc;
+    lv_memset_00(&ref_dsc, sizeof(ref_dsc));
+    ref_dsc.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    ref_dsc.header.w = w;
+    ref_dsc.header.h = h;
+    ref_dsc.data = ref;
+    ref_dsc.data_size = w * h * 4;
+    lv_img_set_src(img, &ref_dsc);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+    lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+
+    lv_img_set_src(img, fn);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+    TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+
+    lv_obj_del(img);
+    lv_img_cache_invalidate_src(fn);
+    lv_mem_free(ref);
+}
+
+void test_png_stream_corrupted(void)
+{
+    lv_img_dsc_t dsc;
+    lv_memset_00(&dsc, sizeof(dsc));
+    uint32_t size;
+    uint8_t * data = load_file(PNG_DIR "rgba16.png", &size);
+    dsc.data = data;
+    uint8_t buf[37 * 4];
+
+    /*Not a PNG*/
+    dsc.data_size = 7;
+    TEST_ASSERT_NULL(lv_png_stream_open(&dsc));
+
+    /*Truncated: the first lines are still readable*/
+    dsc.data_size = size / 2;
+    lv_png_stream_t * stream = lv_png_stream_open(&dsc);
+    TEST_ASSERT_NOT_NULL(stream);
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_png_stream_read_line(stream, 0, 0, 37, buf));
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_png_stream_read_line(stream, 0, 22, 37, buf));
+    /*Restarts after an error*/
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_png_stream_read_line(stream, 0, 1, 37, buf));
+    lv_png_stream_close(stream);
+
+    /*Garbage in the compressed data mustn't crash*/
+    dsc.data_size = size;
+    uint32_t i;
+    for(i = 200; i < size - 16; i += 97) {
+        uint8_t ori = data[i];
+        data[i] ^= 0x5A;
+        stream = lv_png_stream_open(&dsc);
+        if(stream) {
+            uint32_t y;
+            for(y = 0; y < 23; y++) {
+                if(lv_png_stream_read_line(stream, 0, y, 37, buf) != LV_RES_OK) break;
+            }
+            lv_png_stream_close(stream);
+        }
+        data[i] = ori;
+    }
+
+    lv_mem_free(data);
+}
+
+void test_png_stream_benchmark(void)
+{
+    const char * fn = PNG_DIR "rgba8_466.png";
+    uint32_t size;
+    uint8_t * data = load_file(fn, &size);
+    lv_img_dsc_t dsc;
+    lv_memset_00(&dsc, sizeof(dsc));
+    dsc.data = data;
+    dsc.data_size = size;
+
+    /*Decoding the whole image*/
+    clock_t t = clock();
+    uint8_t * img = NULL;
+    unsigned w;
+    unsigned h;
+    TEST_ASSERT_EQUAL(0, lodepng_decode32(&img, &w, &h, data, size));
+    double full_ms = (double)(clock() - t) * 1000 / CLOCKS_PER_SEC;
+    lv_mem_free(img);
+    /*lodepng keeps the inflated lines and the decoded image at the same time*/
+    uint32_t full_mem = h * (w * 4 + 1) + w * h * 4;
+
+    /*Decoding line by line*/
+    t = clock();
+    lv_png_stream_t * stream = lv_png_stream_open(&dsc);
+    TEST_ASSERT_NOT_NULL(stream);
+    uint8_t * buf = lv_mem_alloc(w * 4);
+    uint32_t y;
+    for(y = 0; y < h; y++) {
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_png_stream_read_line(stream, 0, y, w, buf));
+    }
+    double stream_ms = (double)(clock() - t) * 1000 / CLOCKS_PER_SEC;
+    uint32_t stream_mem = lv_png_stream_get_mem_size(stream);
+    lv_png_stream_close(stream);
+    lv_mem_free(buf);
+    lv_mem_free(data);
+
+    char msg[200];
+    lv_snprintf(msg, sizeof(msg), "%dx%d PNG: peak memory %d -> %d bytes, decode time %d -> %d us",
+                (int)w, (int)h, (int)full_mem, (int)stream_mem, (int)(full_ms * 1000), (int)(stream_ms * 1000));
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_LESS_THAN(64 * 1024, stream_mem);
+}
+
+#else /*LV_USE_PNG && LV_PNG_STREAM && LV_COLOR_DEPTH == 32*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_png_stream_pixel_exact(void)
+{
+
+}
+
+void test_png_stream_c_array(void)
+{
+
+}
+
+void test_png_stream_random_access(void)
+{
+
+}
+
+void test_png_stream_interlaced_fallback(void)
+{
+
+}
+
+void test_png_stream_draw_pixel_exact(void)
+{
+
+}
+
+void test_png_stream_corrupted(void)
+{
+
+}
+
+void test_png_stream_benchmark(void)
+{
+
+}
+
+#endif /*LV_USE_PNG && LV_PNG_STREAM && LV_COLOR_DEPTH == 32*/
+
+#endif
@@ -0,0 +1,203 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+void setUp(void);
+void tearDown(void);
+void test_rle_info(void);
+void test_rle_read_line_pixel_exact(void);
+void test_rle_draw_pixel_exact(void);
+void test_rle_draw_faded_pixel_exact(void);
+void test_rle_stat(void);
+void test_rle_invalid(void);
+
+#if LV_USE_RLE && LV_COLOR_DEPTH == 32
+
+LV_IMG_DECLARE(img_rle_test_raw)
+LV_IMG_DECLARE(img_rle_test)
+
+extern lv_color_t test_fb[];
+
+static lv_color_t ref_fb[800 * 480];
+static lv_obj_t * img;
+
+/*Draw the image with `src` on the whole screen and return the rendered screen in `test_fb`*/
+static void render(const void * src)
+{
+    lv_img_set_src(img, src);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+}
+
+void setUp(void)
+{
+    img = lv_img_create(lv_scr_act());
+    lv_obj_set_pos(img, 13, 27);
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+}
+
+void test_rle_info(void)
+{
+    TEST_ASSERT_TRUE(lv_rle_is_rle(&img_rle_test));
+    TEST_ASSERT_FALSE(lv_rle_is_rle(&img_rle_test_raw));
+    TEST_ASSERT_FALSE(lv_rle_is_rle("A:src/test_files/readtest.txt"));
+
+    lv_img_header_t header;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_get_info(&img_rle_test, &header));
+    TEST_ASSERT_EQUAL(150, header.w);
+    TEST_ASSERT_EQUAL(30, header.h);
+    TEST_ASSERT_EQUAL(LV_IMG_CF_TRUE_COLOR_ALPHA, header.cf);
+
+    /*The flash saved by the compression*/
+    TEST_ASSERT_EQUAL(img_rle_test_raw.data_size, lv_rle_get_raw_size(&img_rle_test));
+    TEST_ASSERT_EQUAL(0, lv_rle_get_raw_size(&img_rle_test_raw));
+    TEST_ASSERT_LESS_THAN(img_rle_test_raw.data_size / 4, img_rle_test.data_size);
+}
+
+void test_rle_read_line_pixel_exact(void)
+{
+    uint32_t px_size = LV_IMG_PX_SIZE_ALPHA_BYTE;
+    lv_coord_t w = img_rle_test.header.w;
+    uint8_t buf[150 * LV_IMG_PX_SIZE_ALPHA_BYTE];
+
+    lv_coord_t y;
+    for(y = 0; y < img_rle_test.header.h; y++) {
+        const uint8_t * raw_line = img_rle_test_raw.data + y * w * px_size;
+
+        /*Whole lines*/
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_rle_read_line(&img_rle_test, 0, y, w, buf));
+        TEST_ASSERT_EQUAL_MEMORY(raw_line, buf, w * px_size);
+
+        /*Parts of the lines, starting and ending inside the runs and the literal pixels*/
+        lv_coord_t x;
+        for(x = 0; x < w; x += 7) {
+            lv_coord_t len = LV_MIN(w - x, 1 + x % 61);
+            lv_memset_00(buf, sizeof(buf));
+            TEST_ASSERT_EQUAL(LV_RES_OK, lv_rle_read_line(&img_rle_test, x, y, len, buf));
+            TEST_ASSERT_EQUAL_MEMORY(raw_line + x * px_size, buf, len * px_size);
+        }
+    }
+}
+
+void test_rle_draw_pixel_exact(void)
+{
+    render(&img_rle_test_raw);
+    lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+
+    render(&img_rle_test);
+    TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+}
+
+void test_rle_draw_faded_pixel_exact(void)
+{
+    /*Like the fade of the splash screen*/
+    lv_obj_set_style_img_opa(img, LV_OPA_40, 0);
+    lv_obj_set_style_bg_color(lv_scr_act(), lv_palette_main(LV_PALETTE_RED), 0);
+
+    render(&img_rle_test_raw);
+    lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+
+    render(&img_rle_test);
+    TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+}
+
+void test_rle_stat(void)
+{
+    render(&img_rle_test);
+
+    /*Not cached: opened again*/
+    lv_img_cache_invalidate_src(&img_rle_test);
+    lv_rle_reset_stat();
+    lv_obj_invalidate(img);
+    lv_refr_now(NULL);
+
+    lv_rle_stat_t stat;
+    lv_rle_get_stat(&stat);
+    TEST_ASSERT_EQUAL(1, stat.open_cnt);
+    TEST_ASSERT_EQUAL(30, stat.line_cnt);
+    TEST_ASSERT_EQUAL(150 * 30, stat.px_cnt);
+    TEST_ASSERT_LESS_OR_EQUAL(img_rle_test.data_size, stat.in_size);
+
+    /*Only the visible lines are decoded*/
+    lv_rle_reset_stat();
+    lv_obj_set_y(img, -20);
+    lv_refr_now(NULL);
+    lv_rle_get_stat(&stat);
+    TEST_ASSERT_EQUAL(10, stat.line_cnt);
+}
+
+void test_rle_invalid(void)
+{
+    uint8_t buf[150 * LV_IMG_PX_SIZE_ALPHA_BYTE];
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_rle_read_line(&img_rle_test, 0, 30, 1, buf));
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_rle_read_line(&img_rle_test, 100, 0, 51, buf));
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_rle_read_line(&img_rle_test_raw, 0, 0, 1, buf));
+
+    /*Converted for an other color depth*/
+    static uint8_t data[4096];
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(data), img_rle_test.data_size);
+    lv_memcpy(data, img_rle_test.data, img_rle_test.data_size);
+    data[5] = 16;
+    lv_img_dsc_t dsc = img_rle_test;
+    dsc.data = data;
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_rle_read_line(&dsc, 0, 0, 1, buf));
+
+    lv_img_decoder_dsc_t dec_dsc;
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_img_decoder_open(&dec_dsc, &dsc, lv_color_black(), 0));
+
+    /*Truncated*/
+    dsc = img_rle_test;
+    dsc.data_size = img_rle_test.data_size - 20;
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_rle_read_line(&dsc, 0, 29, 150, buf));
+}
+
+#else /*LV_USE_RLE && LV_COLOR_DEPTH == 32*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_rle_info(void)
+{
+
+}
+
+void test_rle_read_line_pixel_exact(void)
+{
+
+}
+
+void test_rle_draw_pixel_exact(void)
+{
+
+}
+
+void test_rle_draw_faded_pixel_exact(void)
+{
+
+}
+
+void test_rle_stat(void)
+{
+
+}
+
+void test_rle_invalid(void)
+{
+
+}
+
+#endif /*LV_USE_RLE && LV_COLOR_DEPTH == 32*/
+
+#endif
@@ -0,0 +1,491 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+void setUp(void);
+void tearDown(void);
+void test_sjpg_info(void);
+void test_sjpg_read_line_same_as_jpg(void);
+void test_sjpg_c_array(void);
+void test_sjpg_draw_same_as_jpg(void);
+void test_sjpg_cache_redraw(void);
+void test_sjpg_cache_lru(void);
+void test_sjpg_cache_disabled(void);
+void test_sjpg_cache_invalidate(void);
+void test_sjpg_prefetch(void);
+void test_sjpg_corrupted(void);
+void test_sjpg_benchmark(void);
+
+#if LV_USE_SJPG && LV_COLOR_DEPTH == 32
+
+#include <stdlib.h>
+#include <time.h>
+
+#define SJPG_FN     "A:src/test_files/sjpg/gradient.sjpg"
+#define JPG_FN      "A:src/test_files/sjpg/gradient.jpg"
+#define IMG_W       466
+#define IMG_H       232
+#define FRAME_H     16
+#define FRAME_CNT   ((IMG_H + FRAME_H - 1) / FRAME_H)
+#define FRAME_SIZE  (IMG_W * FRAME_H * sizeof(lv_color_t))
+#define CACHE_SIZE  (1024 * 1024)   /*Enough for both test images*/
+
+extern lv_color_t test_fb[];
+
+static lv_color_t ref_fb[800 * 480];
+static lv_img_dsc_t sjpg_dsc;
+
+/*The pixels encoded into the test images: the JPG in 4:2:0 MCUs and the SJPG in 16 px high fragments*/
+static uint8_t tri(int32_t v)
+{
+    v %= 512;
+    return v > 255 ? 511 - v : v;
+}
+
+static lv_color_t test_px(int32_t x, int32_t y)
+{
+    return lv_color_make(tri(x * 2), tri(y * 3), tri(x + y));
+}
+
+static uint8_t * load_file(const char * fn, uint32_t * size)
+{
+    lv_fs_file_t f;
+    TEST_ASSERT_EQUAL(LV_FS_RES_OK, lv_fs_open(&f, fn, LV_FS_MODE_RD));
+    lv_fs_seek(&f, 0, LV_FS_SEEK_END);
+    lv_fs_tell(&f, size);
+    lv_fs_seek(&f, 0, LV_FS_SEEK_SET);
+    uint8_t * data = lv_mem_alloc(*size);
+    uint32_t rn;
+    lv_fs_read(&f, data, *size, &rn);
+    lv_fs_close(&f);
+    TEST_ASSERT_EQUAL(*size, rn);
+    return data;
+}
+
+/*Read the whole image with the decoder's `read_line`*/
+static lv_color_t * read_img(const void * src)
+{
+    lv_img_decoder_dsc_t dsc;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&dsc, src, lv_color_black(), 0));
+    TEST_ASSERT_NULL(dsc.img_data);
+
+    lv_color_t * px = lv_mem_alloc(IMG_W * IMG_H * sizeof(lv_color_t));
+    lv_coord_t y;
+    for(y = 0; y < IMG_H; y++) {
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&dsc, 0, y, IMG_W, (uint8_t *)&px[y * IMG_W]));
+    }
+    lv_img_decoder_close(&dsc);
+    return px;
+}
+
+static void read_frame(lv_img_decoder_dsc_t * dsc, int32_t frame)
+{
+    lv_color_t buf[IMG_W];
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(dsc, 0, frame * FRAME_H, IMG_W, (uint8_t *)buf));
+}
+
+static void render(const void * src)
+{
+    lv_obj_t * img = lv_img_create(lv_scr_act());
+    lv_obj_set_pos(img, 17, 41);
+    lv_img_set_src(img, src);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+    lv_obj_del(img);
+}
+
+void setUp(void)
+{
+    lv_sjpg_cache_set_size(CACHE_SIZE);
+    lv_sjpg_cache_invalidate_src(NULL);
+    lv_img_cache_invalidate_src(NULL);
+    lv_sjpg_reset_stat();
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_sjpg_cache_set_size(LV_SJPG_CACHE_SIZE);
+    if(sjpg_dsc.data) {
+        lv_sjpg_cache_invalidate_src(&sjpg_dsc);
+        lv_img_cache_invalidate_src(&sjpg_dsc);
+        lv_mem_free((void *)sjpg_dsc.data);
+        lv_memset_00(&sjpg_dsc, sizeof(sjpg_dsc));
+    }
+}
+
+void test_sjpg_info(void)
+{
+    lv_img_header_t header;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_get_info(SJPG_FN, &header));
+    TEST_ASSERT_EQUAL(IMG_W, header.w);
+    TEST_ASSERT_EQUAL(IMG_H, header.h);
+    TEST_ASSERT_EQUAL(LV_IMG_CF_RAW, header.cf);
+
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_get_info(JPG_FN, &header));
+    TEST_ASSERT_EQUAL(IMG_W, header.w);
+    TEST_ASSERT_EQUAL(IMG_H, header.h);
+}
+
+void test_sjpg_read_line_same_as_jpg(void)
+{
+    /*The fragments are encoded like the MCU rows of the JPG, so they decode to the same pixels*/
+    lv_color_t * sjpg_px = read_img(SJPG_FN);
+    lv_color_t * jpg_px = read_img(JPG_FN);
+    TEST_ASSERT_EQUAL_MEMORY(jpg_px, sjpg_px, IMG_W * IMG_H * sizeof(lv_color_t));
+
+    /*And they are close to the original image*/
+    uint32_t err = 0;
+    int32_t x;
+    int32_t y;
+    for(y = 0; y < IMG_H; y++) {
+        for(x = 0; x < IMG_W; x++) {
+            lv_color_t c1 = sjpg_px[y * IMG_W + x];
+            lv_color_t c2 = test_px(x, y);
+            err += LV_ABS(c1.ch.red - c2.ch.red) + LV_ABS(c1.ch.green - c2.ch.green) + LV_ABS(c1.ch.blue - c2.ch.blue);
+        }
+    }
+    TEST_ASSERT_LESS_THAN(4 * 3, err / (IMG_W * IMG_H));
+
+    lv_mem_free(sjpg_px);
+    lv_mem_free(jpg_px);
+}
+
+void test_sjpg_c_array(void)
+{
+    uint32_t size;
+    sjpg_dsc.data = load_file(SJPG_FN, &size);
+    sjpg_dsc.data_size = size;
+    sjpg_dsc.header.w = IMG_W;
+    sjpg_dsc.header.h = IMG_H;
+    sjpg_dsc.header.cf = LV_IMG_CF_RAW;
+
+    lv_img_decoder_dsc_t array_dsc;
+    lv_img_decoder_dsc_t file_dsc;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&array_dsc, &sjpg_dsc, lv_color_black(), 0));
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&file_dsc, SJPG_FN, lv_color_black(), 0));
+
+    lv_color_t array_buf[IMG_W];
+    lv_color_t file_buf[IMG_W];
+    lv_coord_t y;
+    for(y = 0; y < IMG_H; y++) {
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&array_dsc, 0, y, IMG_W, (uint8_t *)array_buf));
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&file_dsc, 0, y, IMG_W, (uint8_t *)file_buf));
+        TEST_ASSERT_EQUAL_MEMORY(file_buf, array_buf, sizeof(file_buf));
+    }
+
+    /*Parts of lines in random order*/
+    uint32_t i;
+    for(i = 0; i < 200; i++) {
+        y = rand() % IMG_H;
+        lv_coord_t x = rand() % IMG_W;
+        lv_coord_t len = 1 + rand() % (IMG_W - x);
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&array_dsc, x, y, len, (uint8_t *)array_buf));
+        TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&file_dsc, 0, y, IMG_W, (uint8_t *)file_buf));
+        TEST_ASSERT_EQUAL_MEMORY(&file_buf[x], array_buf, len * sizeof(lv_color_t));
+    }
+
+    lv_img_decoder_close(&array_dsc);
+    lv_img_decoder_close(&file_dsc);
+}
+
+void test_sjpg_draw_same_as_jpg(void)
+{
+    render(JPG_FN);
+    lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+
+    render(SJPG_FN);
+    TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+}
+
+void test_sjpg_cache_redraw(void)
+{
+    lv_sjpg_stat_t stat;
+    render(SJPG_FN);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(FRAME_CNT, stat.decode_cnt);
+    TEST_ASSERT_EQUAL(0, stat.hit_cnt);
+    TEST_ASSERT_EQUAL(FRAME_CNT * FRAME_SIZE, stat.cache_size);
+
+    /*The image is closed and opened again but its fragments are still cached*/
+    lv_img_cache_invalidate_src(SJPG_FN);
+    lv_sjpg_reset_stat();
+    render(SJPG_FN);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(0, stat.decode_cnt);
+    TEST_ASSERT_EQUAL(FRAME_CNT, stat.hit_cnt);
+
+    lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+    render(JPG_FN);
+    TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+}
+
+void test_sjpg_cache_lru(void)
+{
+    lv_sjpg_cache_set_size(4 * FRAME_SIZE);
+
+    lv_img_decoder_dsc_t dsc;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&dsc, SJPG_FN, lv_color_black(), 0));
+
+    int32_t i;
+    for(i = 0; i < 6; i++) read_frame(&dsc, i);
+
+    lv_sjpg_stat_t stat;
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(6, stat.decode_cnt);
+    TEST_ASSERT_EQUAL(4 * FRAME_SIZE, stat.cache_size);
+
+    /*2..5 are cached, 0 and 1 were the least recently used*/
+    read_frame(&dsc, 4);
+    read_frame(&dsc, 2);
+    read_frame(&dsc, 5);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(6, stat.decode_cnt);
+    TEST_ASSERT_EQUAL(3, stat.hit_cnt);
+
+    /*0 replaces 3 which is the least recently used now*/
+    read_frame(&dsc, 0);
+    read_frame(&dsc, 2);
+    read_frame(&dsc, 3);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(8, stat.decode_cnt);
+    TEST_ASSERT_EQUAL(4, stat.hit_cnt);
+
+    /*Shrinking the cache frees the least recently used fragments*/
+    lv_sjpg_cache_set_size(2 * FRAME_SIZE);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(2 * FRAME_SIZE, stat.cache_size);
+    read_frame(&dsc, 2);
+    read_frame(&dsc, 3);
+    read_frame(&dsc, 0);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(6, stat.hit_cnt);
+    TEST_ASSERT_EQUAL(9, stat.decode_cnt);
+
+    lv_img_decoder_close(&dsc);
+}
+
+void test_sjpg_cache_disabled(void)
+{
+    lv_sjpg_cache_set_size(0);
+
+    lv_img_decoder_dsc_t dsc;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&dsc, SJPG_FN, lv_color_black(), 0));
+
+    /*Only the last fragment is kept*/
+    lv_color_t buf[IMG_W];
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&dsc, 0, 0, IMG_W, (uint8_t *)buf));
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&dsc, 0, FRAME_H - 1, IMG_W, (uint8_t *)buf));
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&dsc, 0, FRAME_H, IMG_W, (uint8_t *)buf));
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&dsc, 0, 0, IMG_W, (uint8_t *)buf));
+    lv_img_decoder_close(&dsc);
+
+    lv_sjpg_stat_t stat;
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(3, stat.decode_cnt);
+    TEST_ASSERT_EQUAL(0, stat.hit_cnt);
+    TEST_ASSERT_EQUAL(0, stat.cache_size);
+
+    /*Fragments bigger than the cache are not cached either*/
+    lv_sjpg_cache_set_size(FRAME_SIZE);
+    lv_color_t * px = read_img(JPG_FN);
+    lv_mem_free(px);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(4, stat.decode_cnt);
+    TEST_ASSERT_EQUAL(0, stat.cache_size);
+}
+
+void test_sjpg_cache_invalidate(void)
+{
+    lv_color_t * px = read_img(SJPG_FN);
+    lv_mem_free(px);
+    px = read_img(JPG_FN);
+    lv_mem_free(px);
+
+    lv_sjpg_stat_t stat;
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(FRAME_CNT * FRAME_SIZE + IMG_W * IMG_H * sizeof(lv_color_t), stat.cache_size);
+
+    lv_sjpg_cache_invalidate_src(SJPG_FN);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(IMG_W * IMG_H * sizeof(lv_color_t), stat.cache_size);
+
+    lv_sjpg_cache_invalidate_src(NULL);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(0, stat.cache_size);
+}
+
+void test_sjpg_prefetch(void)
+{
+#if LV_SJPG_PREFETCH
+    lv_img_decoder_dsc_t dsc;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&dsc, SJPG_FN, lv_color_black(), 0));
+    read_frame(&dsc, 0);
+    lv_img_decoder_close(&dsc);
+
+    /*The next fragment is decoded when LVGL is idle, even if the image is closed*/
+    lv_timer_handler();
+    lv_sjpg_stat_t stat;
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(2, stat.decode_cnt);
+    TEST_ASSERT_EQUAL(1, stat.prefetch_cnt);
+    TEST_ASSERT_EQUAL(2 * FRAME_SIZE, stat.cache_size);
+
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&dsc, SJPG_FN, lv_color_black(), 0));
+    read_frame(&dsc, 1);
+    lv_img_decoder_close(&dsc);
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(1, stat.hit_cnt);
+    TEST_ASSERT_EQUAL(2, stat.decode_cnt);
+
+    /*Nothing is freed for prefetching*/
+    lv_sjpg_cache_set_size(2 * FRAME_SIZE);
+    lv_sjpg_reset_stat();
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&dsc, SJPG_FN, lv_color_black(), 0));
+    read_frame(&dsc, 5);
+    lv_img_decoder_close(&dsc);
+    lv_timer_handler();
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(1, stat.decode_cnt);
+    TEST_ASSERT_EQUAL(0, stat.prefetch_cnt);
+#endif
+}
+
+void test_sjpg_corrupted(void)
+{
+    uint32_t size;
+    uint8_t * data = load_file(SJPG_FN, &size);
+    sjpg_dsc.data = data;
+    sjpg_dsc.data_size = size;
+    sjpg_dsc.header.w = IMG_W;
+    sjpg_dsc.header.h = IMG_H;
+    sjpg_dsc.header.cf = LV_IMG_CF_RAW;
+
+    /*Break the header of the 4th fragment*/
+    uint8_t * frame = data + 22 + FRAME_CNT * 2;
+    int32_t i;
+    for(i = 0; i < 3; i++) frame += data[22 + i * 2] | (data[22 + i * 2 + 1] << 8);
+    lv_memset_00(frame, 64);
+
+    lv_img_decoder_dsc_t dsc;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_open(&dsc, &sjpg_dsc, lv_color_black(), 0));
+    lv_color_t buf[IMG_W];
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&dsc, 0, 0, IMG_W, (uint8_t *)buf));
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_img_decoder_read_line(&dsc, 0, 3 * FRAME_H, IMG_W, (uint8_t *)buf));
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_img_decoder_read_line(&dsc, 0, 3 * FRAME_H + 1, IMG_W, (uint8_t *)buf));
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_read_line(&dsc, 0, 4 * FRAME_H, IMG_W, (uint8_t *)buf));
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_img_decoder_read_line(&dsc, 0, IMG_H, IMG_W, (uint8_t *)buf));
+    TEST_ASSERT_EQUAL(LV_RES_INV, lv_img_decoder_read_line(&dsc, 1, 0, IMG_W, (uint8_t *)buf));
+    lv_img_decoder_close(&dsc);
+
+    /*The broken fragment is not cached*/
+    lv_sjpg_stat_t stat;
+    lv_sjpg_get_stat(&stat);
+    TEST_ASSERT_EQUAL(2 * FRAME_SIZE, stat.cache_size);
+}
+
+void test_sjpg_benchmark(void)
+{
+    /*Redraw the image like an animation above it would, without image cache (as in the application)*/
+    const uint32_t redraw_cnt = 10;
+    const uint32_t cache_sizes[] = {0, FRAME_CNT * FRAME_SIZE};
+    char msg[256];
+
+    uint32_t i;
+    for(i = 0; i < sizeof(cache_sizes) / sizeof(cache_sizes[0]); i++) {
+        lv_sjpg_cache_set_size(cache_sizes[i]);
+        lv_sjpg_cache_invalidate_src(NULL);
+        lv_sjpg_reset_stat();
+
+        clock_t t = clock();
+        uint32_t r;
+        for(r = 0; r < redraw_cnt; r++) {
+            lv_img_cache_invalidate_src(SJPG_FN);
+            render(SJPG_FN);
+        }
+        uint32_t us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+
+        lv_sjpg_stat_t stat;
+        lv_sjpg_get_stat(&stat);
+        lv_snprintf(msg, sizeof(msg),
+                    "SJPG cache %d bytes: %d redraws of %dx%d in %d us, %d fragments decoded in %d ms (max. %d ms per fragment), %d hits",
+                    (int)cache_sizes[i], (int)redraw_cnt, IMG_W, IMG_H, (int)us, (int)stat.decode_cnt, (int)stat.decode_time,
+                    (int)stat.decode_time_max, (int)stat.hit_cnt);
+        TEST_MESSAGE(msg);
+
+        if(cache_sizes[i] == 0) TEST_ASSERT_EQUAL(redraw_cnt * FRAME_CNT, stat.decode_cnt);
+        else TEST_ASSERT_EQUAL(FRAME_CNT, stat.decode_cnt);
+    }
+}
+
+#else /*LV_USE_SJPG && LV_COLOR_DEPTH == 32*/
+
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_sjpg_info(void)
+{
+
+}
+
+void test_sjpg_read_line_same_as_jpg(void)
+{
+
+}
+
+void test_sjpg_c_array(void)
+{
+
+}
+
+void test_sjpg_draw_same_as_jpg(void)
+{
+
+}
+
+void test_sjpg_cache_redraw(void)
+{
+
+}
+
+void test_sjpg_cache_lru(void)
+{
+
+}
+
+void test_sjpg_cache_disabled(void)
+{
+
+}
+
+void test_sjpg_cache_invalidate(void)
+{
+
+}
+
+void test_sjpg_prefetch(void)
+{
+
+}
+
+void test_sjpg_corrupted(void)
+{
+
+}
+
+void test_sjpg_benchmark(void)
+{
+
+}
+
+#endif /*LV_USE_SJPG && LV_COLOR_DEPTH == 32*/
+
+#endif
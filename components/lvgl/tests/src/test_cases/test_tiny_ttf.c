@@ -3,6 +3,18 @@
 
 #include "unity/unity.h"
 
+void setUp(void);
+void tearDown(void);
+void test_tiny_ttf_rendering_test(void);
+void test_tiny_ttf_atlas_same_as_cache(void);
+void test_tiny_ttf_atlas_shared(void);
+void test_tiny_ttf_atlas_file(void);
+void test_tiny_ttf_atlas_eviction(void);
+void test_tiny_ttf_benchmark(void);
+
+extern const uint8_t ubuntu_font[];
+extern size_t ubuntu_font_size;
+
 void setUp(void)
 {
     /* Function run before every test */
@@ -11,14 +23,13 @@ void setUp(void)
 void tearDown(void)
 {
     /* Function run after every test */
+    lv_obj_clean(lv_scr_act());
 }
 
 void test_tiny_ttf_rendering_test(void)
 {
 #if LV_USE_TINY_TTF
     /*Create a font*/
-    extern const uint8_t ubuntu_font[];
-    extern size_t ubuntu_font_size;
     lv_font_t * font = lv_tiny_ttf_create_data(ubuntu_font, ubuntu_font_size, 30);
 
     /*Create style with the new font*/
@@ -46,4 +57,234 @@ void test_tiny_ttf_rendering_test(void)
 #endif
 }
 
+#if LV_USE_TINY_TTF && LV_TINY_TTF_ATLAS_SIZE
+
+#include <stdio.h>
+#include <time.h>
+
+#define TEXT        "The quick brown fox jumps over the lazy dog. 0123456789\n" \
+    "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG! ÁÉÍÓÖŐÜŰ áéíóöőüű"
+#define TTF_FN      "/tmp/lv_tiny_ttf_test.ttf"
+#define REF_CACHE   (1024 * 1024)  /*Large enough to rasterize every glyph once*/
+
+extern lv_color_t test_fb[];
+static lv_color_t ref_fb[800 * 480];
+
+static lv_obj_t * label_create(const lv_font_t * font, lv_coord_t y)
+{
+    lv_obj_t * label = lv_label_create(lv_scr_act());
+    lv_obj_set_width(label, 800);
+    lv_obj_set_y(label, y);
+    lv_obj_set_style_text_font(label, font, 0);
+    lv_label_set_text(label, TEXT);
+    return label;
+}
+
+/*Render a label with `font` to `test_fb`*/
+static void render(const lv_font_t * font)
+{
+    lv_obj_clean(lv_scr_act());
+    label_create(font, 0);
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+}
+
+static void render_ref(lv_coord_t font_size)
+{
+    lv_font_t * ref = lv_tiny_ttf_create_data_ex(ubuntu_font, ubuntu_font_size, font_size, REF_CACHE);
+    render(ref);
+    lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+    lv_obj_clean(lv_scr_act());
+    lv_tiny_ttf_destroy(ref);
+}
+
+void test_tiny_ttf_atlas_same_as_cache(void)
+{
+    /*The largest glyphs don't fit on a page*/
+    const lv_coord_t sizes[] = {12, 30, 120};
+
+    uint32_t i;
+    for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        render_ref(sizes[i]);
+        lv_font_t * font = lv_tiny_ttf_create_data(ubuntu_font, ubuntu_font_size, sizes[i]);
+        render(font);
+        TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+        lv_obj_clean(lv_scr_act());
+        lv_tiny_ttf_destroy(font);
+    }
+}
+
+void test_tiny_ttf_atlas_shared(void)
+{
+    lv_tiny_ttf_stat_t stat;
+    lv_font_t * font1 = lv_tiny_ttf_create_data(ubuntu_font, ubuntu_font_size, 20);
+    render(font1);
+    lv_tiny_ttf_get_stat(&stat);
+    TEST_ASSERT_GREATER_THAN(0, stat.atlas_size);
+
+    /*Nothing is rasterized or looked up again for an other font of the same face and size*/
+    lv_tiny_ttf_reset_stat();
+    lv_font_t * font2 = lv_tiny_ttf_create_data(ubuntu_font, ubuntu_font_size, 20);
+    render(font2);
+    lv_tiny_ttf_get_stat(&stat);
+    TEST_ASSERT_EQUAL(0, stat.raster_cnt);
+    TEST_ASSERT_EQUAL(0, stat.metrics_cnt);
+    TEST_ASSERT_EQUAL(0, stat.kern_cnt);
+    TEST_ASSERT_GREATER_THAN(0, stat.hit_cnt);
+
+    /*A new size is rasterized once*/
+    lv_tiny_ttf_reset_stat();
+    lv_font_t * font3 = lv_tiny_ttf_create_data(ubuntu_font, ubuntu_font_size, 24);
+    render(font3);
+    lv_tiny_ttf_get_stat(&stat);
+    TEST_ASSERT_GREATER_THAN(0, stat.raster_cnt);
+    TEST_ASSERT_GREATER_THAN(0, stat.metrics_cnt);
+
+    /*And reused when an other font is resized to it*/
+    lv_tiny_ttf_reset_stat();
+    lv_tiny_ttf_set_size(font1, 24);
+    render(font1);
+    lv_tiny_ttf_get_stat(&stat);
+    TEST_ASSERT_EQUAL(0, stat.raster_cnt);
+    TEST_ASSERT_EQUAL(0, stat.metrics_cnt);
+    lv_obj_clean(lv_scr_act());
+
+    /*The atlas is freed with the last font*/
+    lv_tiny_ttf_destroy(font1);
+    lv_tiny_ttf_destroy(font2);
+    lv_tiny_ttf_get_stat(&stat);
+    TEST_ASSERT_GREATER_THAN(0, stat.atlas_size);
+    lv_tiny_ttf_destroy(font3);
+    lv_tiny_ttf_get_stat(&stat);
+    TEST_ASSERT_EQUAL(0, stat.atlas_size);
+}
+
+void test_tiny_ttf_atlas_file(void)
+{
+    FILE * f = fopen(TTF_FN, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL(ubuntu_font_size, fwrite(ubuntu_font, 1, ubuntu_font_size, f));
+    fclose(f);
+
+    render_ref(16);
+
+    /*The fonts of the same file share the atlas*/
+    lv_tiny_ttf_stat_t stat;
+    lv_font_t * font1 = lv_tiny_ttf_create_file("A:" TTF_FN, 16);
+    TEST_ASSERT_NOT_NULL(font1);
+    render(font1);
+    TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+
+    lv_tiny_ttf_reset_stat();
+    lv_font_t * font2 = lv_tiny_ttf_create_file("A:" TTF_FN, 16);
+    render(font2);
+    lv_tiny_ttf_get_stat(&stat);
+    TEST_ASSERT_EQUAL(0, stat.raster_cnt);
+    TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+
+    lv_obj_clean(lv_scr_act());
+    lv_tiny_ttf_destroy(font1);
+    lv_tiny_ttf_destroy(font2);
+    remove(TTF_FN);
+}
+
+void test_tiny_ttf_atlas_eviction(void)
+{
+    /*The glyphs of the text don't fit in the atlas at this size*/
+    render_ref(70);
+
+    lv_tiny_ttf_reset_stat();
+    lv_font_t * font = lv_tiny_ttf_create_data(ubuntu_font, ubuntu_font_size, 70);
+    uint32_t i;
+    for(i = 0; i < 3; i++) {
+        render(font);
+        TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+    }
+
+    lv_tiny_ttf_stat_t stat;
+    lv_tiny_ttf_get_stat(&stat);
+    TEST_ASSERT_GREATER_THAN(0, stat.evict_cnt);
+    TEST_ASSERT_LESS_OR_EQUAL(LV_TINY_TTF_ATLAS_SIZE + 32 * 1024, stat.atlas_size);
+
+    lv_obj_clean(lv_scr_act());
+    lv_tiny_ttf_destroy(font);
+}
+
+void test_tiny_ttf_benchmark(void)
+{
+    /*Render paragraphs with 2 fonts of each size with the default private caches and with the atlas*/
+    const lv_coord_t sizes[] = {12, 16, 20, 28};
+    const uint32_t font_cnt = 2 * sizeof(sizes) / sizeof(sizes[0]);
+    const uint32_t frame_cnt = 5;
+    lv_font_t * fonts[8];
+    lv_tiny_ttf_stat_t stats[2];
+    char msg[256];
+
+    uint32_t atlas;
+    for(atlas = 0; atlas <= 1; atlas++) {
+        lv_tiny_ttf_reset_stat();
+        clock_t t = clock();
+        uint32_t i;
+        lv_coord_t y = 0;
+        for(i = 0; i < font_cnt; i++) {
+            lv_coord_t size = sizes[i / 2];
+            fonts[i] = lv_tiny_ttf_create_data_ex(ubuntu_font, ubuntu_font_size, size,
+                                                  atlas ? LV_TINY_TTF_CACHE_ATLAS : 4096);
+            label_create(fonts[i], y);
+            y += fonts[i]->line_height * 2;
+        }
+
+        for(i = 0; i < frame_cnt; i++) {
+            lv_obj_invalidate(lv_scr_act());
+            lv_refr_now(NULL);
+        }
+        uint32_t us = (uint32_t)((clock() - t) * 1000000 / CLOCKS_PER_SEC);
+        lv_tiny_ttf_get_stat(&stats[atlas]);
+
+        lv_obj_clean(lv_scr_act());
+        for(i = 0; i < font_cnt; i++) lv_tiny_ttf_destroy(fonts[i]);
+
+        lv_snprintf(msg, sizeof(msg),
+                    "Tiny TTF %s: %d frames, %d us per frame, %d rasterized, %d hits, %d metrics, %d kerning, %d allocations",
+                    atlas ? "atlas" : "font caches", (int)frame_cnt, (int)(us / frame_cnt), (int)stats[atlas].raster_cnt,
+                    (int)stats[atlas].hit_cnt, (int)stats[atlas].metrics_cnt, (int)stats[atlas].kern_cnt,
+                    (int)stats[atlas].alloc_cnt);
+        TEST_MESSAGE(msg);
+    }
+
+    TEST_ASSERT_LESS_THAN(stats[0].raster_cnt / 4, stats[1].raster_cnt);
+    TEST_ASSERT_LESS_THAN(stats[0].alloc_cnt / 4, stats[1].alloc_cnt);
+    TEST_ASSERT_LESS_THAN(stats[0].metrics_cnt / 4, stats[1].metrics_cnt);
+    TEST_ASSERT_LESS_THAN(stats[0].kern_cnt / 4, stats[1].kern_cnt);
+}
+
+#else /*LV_USE_TINY_TTF && LV_TINY_TTF_ATLAS_SIZE*/
+
+void test_tiny_ttf_atlas_same_as_cache(void)
+{
+
+}
+
+void test_tiny_ttf_atlas_shared(void)
+{
+
+}
+
+void test_tiny_ttf_atlas_file(void)
+{
+
+}
+
+void test_tiny_ttf_atlas_eviction(void)
+{
+
+}
+
+void test_tiny_ttf_benchmark(void)
+{
+
+}
+
+#endif /*LV_USE_TINY_TTF && LV_TINY_TTF_ATLAS_SIZE*/
+
 #endif
@@ -0,0 +1,193 @@
+// RLE compressed 150x30 image converted by lvgl/scripts/img_to_rle.py: 2791 bytes instead of 18000
+#include "../../lvgl.h"
+
+#ifndef LV_ATTRIBUTE_MEM_ALIGN
+#define LV_ATTRIBUTE_MEM_ALIGN
+#endif
+
+const LV_ATTRIBUTE_MEM_ALIGN uint8_t img_rle_test_data[] = {
+    0x4c,0x56,0x52,0x4c,0x05,0x20,0x00,0x00,0x50,0x46,0x00,0x00,0x00,0x00,0x00,0x00,
+    0x0f,0x00,0x00,0x00,0x1e,0x00,0x00,0x00,0x2d,0x00,0x00,0x00,0x66,0x00,0x00,0x00,
+    0x91,0x00,0x00,0x00,0xbc,0x00,0x00,0x00,0xe7,0x00,0x00,0x00,0x12,0x01,0x00,0x00,
+    0x35,0x01,0x00,0x00,0x58,0x01,0x00,0x00,0x94,0x03,0x00,0x00,0xd0,0x05,0x00,0x00,
+    0x0c,0x08,0x00,0x00,0x2f,0x08,0x00,0x00,0x52,0x08,0x00,0x00,0x6b,0x08,0x00,0x00,
+    0x8e,0x08,0x00,0x00,0xb1,0x08,0x00,0x00,0xd4,0x08,0x00,0x00,0xf7,0x08,0x00,0x00,
+    0x1a,0x09,0x00,0x00,0x3d,0x09,0x00,0x00,0x60,0x09,0x00,0x00,0x8b,0x09,0x00,0x00,
+    0xb6,0x09,0x00,0x00,0xe1,0x09,0x00,0x00,0x0c,0x0a,0x00,0x00,0x45,0x0a,0x00,0x00,
+    0x54,0x0a,0x00,0x00,0xcf,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,
+    0x00,0x00,0x00,0xcf,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,
+    0x00,0x00,0xcf,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,
+    0x00,0xa3,0x00,0x00,0x00,0x00,0x08,0x20,0x40,0xe0,0x59,0x20,0x40,0xe0,0xa0,0x20,
+    0x40,0xe0,0xd4,0x20,0x40,0xe0,0xf4,0x20,0x40,0xe0,0xff,0x20,0x40,0xe0,0xf4,0x20,
+    0x40,0xe0,0xd4,0x20,0x40,0xe0,0xa0,0x20,0x40,0xe0,0x59,0xa2,0x00,0x00,0x00,0x00,
+    0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0xa1,0x00,0x00,0x00,0x00,0x01,
+    0x20,0x40,0xe0,0x77,0x20,0x40,0xe0,0xe9,0x88,0x20,0x40,0xe0,0xff,0x01,0x20,0x40,
+    0xe0,0xe9,0x20,0x40,0xe0,0x77,0xa0,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,
+    0x89,0x00,0x00,0x00,0x00,0x9f,0x00,0x00,0x00,0x00,0x01,0x20,0x40,0xe0,0x31,0x20,
+    0x40,0xe0,0xca,0x8c,0x20,0x40,0xe0,0xff,0x01,0x20,0x40,0xe0,0xca,0x20,0x40,0xe0,
+    0x31,0x9e,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,
+    0x9e,0x00,0x00,0x00,0x00,0x01,0x20,0x40,0xe0,0x45,0x20,0x40,0xe0,0xf4,0x8e,0x20,
+    0x40,0xe0,0xff,0x01,0x20,0x40,0xe0,0xf4,0x20,0x40,0xe0,0x45,0x9d,0x00,0x00,0x00,
+    0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0x9d,0x00,0x00,0x00,0x00,
+    0x01,0x20,0x40,0xe0,0x31,0x20,0x40,0xe0,0xf4,0x90,0x20,0x40,0xe0,0xff,0x01,0x20,
+    0x40,0xe0,0xf4,0x20,0x40,0xe0,0x31,0x9c,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,
+    0x80,0x89,0x00,0x00,0x00,0x00,0x9d,0x00,0x00,0x00,0x00,0x00,0x20,0x40,0xe0,0xca,
+    0x92,0x20,0x40,0xe0,0xff,0x00,0x20,0x40,0xe0,0xca,0x9c,0x00,0x00,0x00,0x00,0xbb,
+    0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0x9c,0x00,0x00,0x00,0x00,0x00,0x20,
+    0x40,0xe0,0x77,0x94,0x20,0x40,0xe0,0xff,0x00,0x20,0x40,0xe0,0x77,0x9b,0x00,0x00,
+    0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0x84,0x00,0x00,0x00,
+    0x00,0x7f,0xdc,0x04,0x65,0xff,0xaa,0x1f,0xad,0xff,0x1d,0x5a,0xda,0xff,0xe5,0xac,
+    0x1b,0xff,0x1e,0x5f,0x13,0xff,0x70,0x79,0x6c,0xff,0xfd,0x10,0xff,0xff,0x19,0xaf,
+    0x60,0xff,0x1d,0x04,0xac,0xff,0xb4,0x1d,0x02,0xff,0x2b,0x46,0x78,0xff,0x73,0x3a,
+    0xf2,0xff,0xdf,0x5f,0xae,0xff,0xb7,0x08,0x59,0xff,0xd1,0xee,0x39,0xff,0x10,0xcb,
+    0x48,0xff,0x95,0xb5,0xcc,0xff,0x89,0x29,0x11,0xff,0xff,0x06,0xb6,0xff,0x62,0x2e,
+    0xdf,0xff,0x3c,0xf9,0x35,0xff,0xfd,0x4b,0x94,0xff,0x28,0xca,0x09,0xff,0x7c,0x44,
+    0xb3,0xff,0x02,0x5e,0x96,0xff,0x5f,0xb3,0xea,0xff,0x6d,0xac,0xd4,0xff,0x2d,0x81,
+    0x6e,0xff,0x69,0xaf,0xe0,0xff,0xe6,0x87,0x4c,0xff,0x9c,0x04,0xe7,0xff,0xd2,0x36,
+    0x5d,0xff,0x2c,0x60,0xc9,0xff,0xea,0xf4,0x79,0xff,0xf6,0x86,0xa0,0xff,0xeb,0x93,
+    0x26,0xff,0xe4,0x62,0x12,0xff,0xd5,0x0d,0xcb,0xff,0xb3,0x77,0x15,0xff,0x6a,0x6a,
+    0x3a,0xff,0x68,0xba,0x8e,0xff,0xdb,0x74,0x08,0xff,0x46,0x9e,0xf3,0xff,0xce,0xb3,
+    0x0a,0xff,0xf8,0xd0,0xdd,0xff,0x68,0xbb,0xf8,0xff,0x5f,0xfa,0x24,0xff,0xf2,0xd2,
+    0xfc,0xff,0x18,0x87,0xfb,0xff,0x5c,0x87,0xba,0xff,0xb4,0x38,0x32,0xff,0xa5,0x9b,
+    0x1b,0xff,0x3d,0x10,0x7c,0xff,0xf7,0x78,0xd6,0xff,0x7f,0xe2,0x6d,0xff,0xf8,0x11,
+    0x91,0xff,0x29,0x7e,0x93,0xff,0x95,0xcb,0x12,0xff,0xc5,0x57,0xce,0xff,0x5a,0xf1,
+    0xd4,0xff,0x16,0x18,0xd7,0xff,0x19,0xbc,0x04,0xff,0x5b,0x7e,0x99,0xff,0x65,0xf1,
+    0xa2,0xff,0x94,0x71,0xc4,0xff,0x2a,0xac,0x6a,0xff,0xa9,0x38,0xc4,0xff,0x75,0xc7,
+    0xad,0xff,0x32,0x38,0x02,0xff,0x1f,0x05,0x3b,0xff,0x2c,0x99,0x1a,0xff,0xfc,0xeb,
+    0x15,0xff,0xde,0xcf,0x68,0xff,0xba,0xe0,0x7c,0xff,0xbc,0xd6,0x1e,0xff,0x97,0x1b,
+    0x9a,0xff,0x0b,0x9d,0xbe,0xff,0x97,0x63,0xd3,0xff,0x92,0xfc,0xaf,0xff,0xdf,0xa2,
+    0x8c,0xff,0x97,0x23,0x45,0xff,0x62,0xeb,0xdd,0xff,0x07,0x65,0x70,0xff,0xff,0x58,
+    0x89,0xff,0x6a,0xcf,0xf7,0xff,0xca,0xee,0x3f,0xff,0x1c,0xe9,0xe4,0xff,0x0a,0x68,
+    0xe5,0xff,0xde,0x93,0x8d,0xff,0x38,0x9c,0x7d,0xff,0xbd,0xd7,0x5b,0xff,0x09,0xd4,
+    0xe7,0xff,0xe2,0x33,0x44,0xff,0x3f,0x4a,0x8c,0xff,0xc4,0xa1,0x90,0xff,0xd6,0xb8,
+    0xb8,0xff,0xdc,0x61,0x5f,0xff,0xd1,0x8e,0x28,0xff,0xbe,0x59,0x0e,0xff,0xaa,0x50,
+    0x1b,0xff,0x50,0x8a,0x6a,0xff,0x36,0x29,0xe6,0xff,0x70,0xdf,0x55,0xff,0x77,0xba,
+    0xdc,0xff,0x44,0x6d,0x43,0xff,0xbb,0xa9,0x08,0xff,0x17,0xd6,0xc0,0xff,0xf6,0x7b,
+    0x08,0xff,0x61,0x70,0xd9,0xff,0x2d,0xc9,0x12,0xff,0x72,0x5b,0x24,0xff,0x7e,0xc2,
+    0xe2,0xff,0xda,0xb1,0xb2,0xff,0x04,0x9e,0x20,0xff,0x80,0x74,0x37,0xff,0x9a,0x6f,
+    0x90,0xff,0x0c,0xdd,0x2e,0xff,0x5e,0x72,0xf5,0xff,0x09,0x48,0xb6,0xff,0x58,0xd1,
+    0x97,0xff,0xe9,0xc3,0x8c,0xff,0xb1,0x6e,0xd3,0xff,0xdd,0x12,0x44,0xff,0x62,0x32,
+    0x0c,0xff,0x14,0xa7,0xaf,0xff,0x3f,0xfa,0x0c,0xff,0xde,0xd6,0x13,0xff,0xce,0x13,
+    0x86,0xff,0x0b,0xcb,0x57,0xa0,0xff,0x47,0xe4,0x5b,0xff,0xbe,0xd1,0x45,0xff,0xb4,
+    0x36,0xd5,0xff,0x88,0xfe,0xd2,0xff,0x00,0x41,0xf2,0xff,0x87,0xb1,0x0f,0xff,0x83,
+    0x5f,0x74,0xff,0x65,0xba,0x28,0xff,0x46,0x16,0x52,0xff,0xdf,0x88,0xa2,0xff,0x13,
+    0xd9,0xbf,0xff,0x84,0x00,0x00,0x00,0x00,0x84,0x00,0x00,0x00,0x00,0x7f,0x42,0xef,
+    0xb7,0xff,0x11,0xb5,0xde,0xff,0x07,0x7f,0xc9,0xff,0x79,0xba,0xe3,0xff,0xa8,0x58,
+    0x4a,0xff,0xa9,0xe8,0x2d,0xff,0xa8,0x4d,0x50,0xff,0x9d,0xe6,0x98,0xff,0x6b,0xe2,
+    0xa9,0xff,0x9a,0xcf,0x21,0xff,0x4c,0x66,0x2a,0xff,0x8c,0xd5,0x90,0xff,0x11,0x37,
+    0x98,0xff,0x67,0x89,0xbb,0xff,0xad,0xf3,0x51,0xff,0x8d,0x13,0xad,0xff,0xf5,0x1c,
+    0xa1,0xff,0x01,0x94,0xac,0xff,0xb0,0x84,0x6c,0xff,0xf5,0x8a,0xf5,0xff,0x2a,0x7a,
+    0x91,0xff,0xf5,0xf3,0xab,0xff,0x2f,0x86,0x32,0xff,0xba,0x81,0x45,0xff,0x20,0x3d,
+    0xc3,0xff,0x67,0x14,0x88,0xff,0x7a,0x75,0x90,0xff,0xc8,0x63,0xc7,0xff,0x07,0xe0,
+    0x1e,0xff,0xc2,0x70,0x03,0xff,0x9a,0xd1,0x8b,0xff,0x16,0x3f,0x24,0xff,0xf6,0xc3,
+    0xde,0xff,0x2b,0xef,0x5d,0xff,0x5a,0xd1,0xe6,0xff,0x76,0x13,0x79,0xff,0xca,0x42,
+    0x16,0xff,0xb9,0x10,0xaa,0xff,0x05,0xd9,0x83,0xff,0x30,0xc7,0x0a,0xff,0xcf,0x85,
+    0xf0,0xff,0x66,0xcb,0xec,0xff,0xef,0xac,0x89,0xff,0x4c,0xfa,0xb7,0xff,0x1f,0x18,
+    0xba,0xff,0xc3,0x34,0xdf,0xff,0xb6,0x60,0x4a,0xff,0xb2,0x80,0x32,0xff,0xcd,0x39,
+    0xa1,0xff,0x6e,0xdf,0x94,0xff,0x44,0x14,0xe1,0xff,0xf3,0xa6,0xec,0xff,0xc1,0xf4,
+    0x39,0xff,0x43,0x06,0xc0,0xff,0x9b,0x62,0x9d,0xff,0xe3,0x3a,0xd3,0xff,0x61,0xef,
+    0xc3,0xff,0x53,0x6b,0xd0,0xff,0x4f,0x96,0x1f,0xff,0xee,0x4d,0xbd,0xff,0xf3,0x05,
+    0x2d,0xff,0x97,0xfe,0xc4,0xff,0xd1,0x9b,0x45,0xff,0x27,0xb4,0xa2,0xff,0xc4,0x94,
+    0xd8,0xff,0x64,0x3e,0xb8,0xff,0x71,0xb9,0xc4,0xff,0x1f,0x53,0x8b,0xff,0x08,0x95,
+    0x1c,0xff,0x9e,0x5f,0x40,0xff,0x21,0xff,0x97,0xff,0x7a,0x1a,0x4d,0xff,0x7f,0x70,
+    0x8c,0xff,0xab,0x2f,0x7c,0xff,0xfa,0x80,0x1b,0xff,0x42,0xca,0xf5,0xff,0xdb,0x8c,
+    0xf9,0xff,0x2c,0xb8,0xe6,0xff,0x7e,0x41,0xf6,0xff,0xf9,0x7f,0x01,0xff,0xe4,0xa8,
+    0x36,0xff,0x6d,0xa4,0xec,0xff,0xa2,0xed,0xba,0xff,0x70,0xed,0x54,0xff,0x57,0xeb,
+    0xa0,0xff,0x97,0x63,0x41,0xff,0x89,0x4d,0x4d,0xff,0x59,0x68,0xe6,0xff,0x92,0xbc,
+    0x5c,0xff,0xab,0x0e,0xf3,0xff,0x10,0x79,0x06,0xff,0x9d,0xa5,0x3d,0xff,0xf1,0x52,
+    0x5d,0xff,0x2e,0x09,0x3b,0xff,0x0d,0xce,0x96,0xff,0x6d,0x41,0x9e,0xff,0xf5,0x0a,
+    0x2c,0xff,0xa4,0x6b,0x16,0xff,0x56,0x9d,0xac,0xff,0x1a,0x04,0x02,0xff,0x29,0x7b,
+    0x66,0xff,0xbd,0x1d,0x97,0xff,0x83,0xa8,0x56,0xff,0xa5,0xe5,0xca,0xff,0xc3,0x49,
+    0x04,0xff,0x50,0xc2,0xfa,0xff,0x73,0x4d,0x28,0xff,0x14,0xcc,0x31,0xff,0x0d,0xbc,
+    0x5d,0xff,0x0b,0x5c,0x78,0xff,0x8f,0x7e,0x1e,0xff,0x8a,0x1a,0x85,0xff,0x81,0x0f,
+    0xeb,0xff,0xe6,0xab,0xdc,0xff,0xd0,0x77,0x41,0xff,0x14,0xe9,0x14,0xff,0xb5,0x89,
+    0xcf,0xff,0x5c,0x53,0xd8,0xff,0x81,0x2e,0x0b,0xff,0x43,0x13,0xe6,0xff,0xfc,0x4c,
+    0x15,0xff,0x57,0xc5,0x17,0xff,0xc4,0x88,0x8a,0xff,0x7d,0xf3,0x2f,0xff,0xc8,0xef,
+    0xb7,0xff,0xef,0xd9,0x11,0xff,0xd5,0x50,0x46,0xff,0x12,0xec,0x82,0xff,0x0b,0xd0,
+    0xcd,0x62,0xff,0xd1,0x3d,0xa1,0xff,0x10,0xe8,0xe3,0xff,0x11,0xad,0xc6,0xff,0xf6,
+    0x1a,0xfb,0xff,0x80,0x91,0x58,0xff,0xb3,0xbb,0x85,0xff,0xd7,0x31,0xe8,0xff,0xe5,
+    0xba,0xe0,0xff,0x3e,0x4e,0x8e,0xff,0x63,0x79,0xf7,0xff,0x6b,0x89,0x54,0xff,0x84,
+    0x00,0x00,0x00,0x00,0x84,0x00,0x00,0x00,0x00,0x7f,0x7c,0xd0,0xee,0xff,0xc7,0x6a,
+    0x3c,0xff,0x70,0x00,0x89,0xff,0x8c,0x58,0x23,0xff,0xed,0x18,0x45,0xff,0xc2,0xbb,
+    0x8c,0xff,0xd8,0x1b,0xbc,0xff,0x86,0x21,0x14,0xff,0xa3,0xf4,0xcc,0xff,0xf7,0x1e,
+    0x2b,0xff,0x0b,0xed,0x9f,0xff,0xc8,0x43,0x3c,0xff,0xe7,0x47,0x76,0xff,0x40,0x57,
+    0x65,0xff,0x73,0x2b,0xf6,0xff,0x35,0xbf,0x7c,0xff,0x41,0x04,0x42,0xff,0x40,0xb6,
+    0xee,0xff,0xb1,0x0c,0x1f,0xff,0x3d,0xbf,0xb6,0xff,0x9f,0x85,0x03,0xff,0xd6,0x7d,
+    0x80,0xff,0xa7,0xff,0xb4,0xff,0xaa,0xd6,0xbd,0xff,0x36,0x9c,0xe3,0xff,0x4e,0x04,
+    0x29,0xff,0x3a,0x21,0xef,0xff,0x3a,0x07,0x10,0xff,0x2b,0x69,0xa8,0xff,0x5c,0x99,
+    0x60,0xff,0xd3,0x6c,0xd1,0xff,0xf0,0x87,0x45,0xff,0xf1,0xf0,0xb4,0xff,0xc8,0x27,
+    0xdc,0xff,0xa9,0xaf,0x00,0xff,0x29,0x41,0x46,0xff,0x6f,0x69,0xcd,0xff,0xe9,0x9d,
+    0x23,0xff,0xc0,0x41,0x74,0xff,0x70,0x1d,0x3d,0xff,0xe9,0x56,0xa1,0xff,0xd2,0x0c,
+    0xe4,0xff,0xb0,0x73,0xd0,0xff,0x11,0x00,0x4f,0xff,0x9b,0x55,0x07,0xff,0x4e,0x8c,
+    0x05,0xff,0x25,0xc9,0x90,0xff,0x6f,0x92,0x0b,0xff,0x24,0xb9,0x05,0xff,0x8c,0xe7,
+    0x7a,0xff,0x29,0xe7,0xe7,0xff,0x15,0xc1,0xa1,0xff,0xa8,0xda,0x95,0xff,0x98,0xf3,
+    0xdb,0xff,0x24,0x4c,0x65,0xff,0x8e,0x08,0xd1,0xff,0xb3,0x27,0x27,0xff,0x90,0xbe,
+    0xb3,0xff,0x9e,0xc1,0x5a,0xff,0xf4,0x6e,0xa9,0xff,0xde,0x00,0xe4,0xff,0x93,0x6b,
+    0x98,0xff,0xca,0x8f,0xfd,0xff,0x49,0x50,0xed,0xff,0x33,0x44,0xb7,0xff,0x77,0xde,
+    0xfe,0xff,0xc3,0x72,0x4b,0xff,0x88,0xde,0x53,0xff,0x51,0xab,0x0c,0xff,0x42,0x19,
+    0xcb,0xff,0x92,0x4f,0xb0,0xff,0x79,0x66,0x77,0xff,0x4e,0xd5,0x55,0xff,0x55,0x64,
+    0xa9,0xff,0xf7,0xa8,0x67,0xff,0x47,0x53,0x88,0xff,0x5f,0x1e,0x51,0xff,0x67,0x2e,
+    0x1f,0xff,0xe3,0xca,0xa1,0xff,0xd2,0xf2,0xc5,0xff,0x38,0x36,0x0a,0xff,0x38,0xb5,
+    0x5d,0xff,0xc6,0xcc,0x67,0xff,0xc4,0xfa,0xab,0xff,0x33,0x73,0xa2,0xff,0x02,0x67,
+    0xd9,0xff,0x8d,0x37,0x3e,0xff,0x65,0xc9,0xea,0xff,0x33,0xe4,0xcd,0xff,0xad,0x06,
+    0x9e,0xff,0x69,0x84,0x8f,0xff,0x2e,0x6e,0x1b,0xff,0x46,0x25,0x1d,0xff,0xca,0x8e,
+    0x5e,0xff,0x50,0x49,0xc4,0xff,0x1f,0x6a,0x32,0xff,0x0b,0xf4,0x00,0xff,0x3c,0xd5,
+    0x4c,0xff,0x44,0x31,0x32,0xff,0xd0,0x36,0xb4,0xff,0xd9,0x87,0x89,0xff,0xb5,0xf7,
+    0xab,0xff,0x56,0xb0,0xb9,0xff,0x48,0x82,0xa8,0xff,0x9b,0x9a,0xf0,0xff,0xe7,0x6e,
+    0x24,0xff,0x67,0x72,0x2c,0xff,0x90,0x42,0x4e,0xff,0x7c,0x4a,0xda,0xff,0x76,0x03,
+    0xda,0xff,0xb4,0x97,0x70,0xff,0x05,0x69,0x91,0xff,0x46,0xa3,0x59,0xff,0xae,0x68,
+    0x3f,0xff,0x0f,0xa0,0x66,0xff,0x71,0x72,0x3d,0xff,0x8a,0xfa,0xb1,0xff,0xf9,0xa0,
+    0xa4,0xff,0xec,0x27,0x89,0xff,0xd7,0xa3,0xef,0xff,0x7f,0xfb,0xdf,0xff,0x0e,0x25,
+    0x91,0xff,0x22,0x51,0x56,0xff,0x11,0x0f,0xcf,0xff,0xaa,0x81,0xda,0xff,0xe9,0xc8,
+    0xda,0xff,0x6e,0x02,0x6e,0xff,0x1a,0x5f,0xff,0xff,0x0b,0x41,0x28,0x96,0xff,0x7d,
+    0x55,0x6c,0xff,0xb6,0xd5,0x7c,0xff,0x2a,0x50,0xd1,0xff,0x4f,0xa3,0xcc,0xff,0x2b,
+    0xfe,0xea,0xff,0x12,0xc9,0xd7,0xff,0x87,0xfb,0xbb,0xff,0x97,0xcd,0x7b,0xff,0xf0,
+    0x74,0xfb,0xff,0x8a,0xbc,0xe6,0xff,0x15,0xd7,0x0a,0xff,0x84,0x00,0x00,0x00,0x00,
+    0x9b,0x00,0x00,0x00,0x00,0x00,0x20,0x40,0xe0,0xd4,0x96,0x20,0x40,0xe0,0xff,0x00,
+    0x20,0x40,0xe0,0xd4,0x9a,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,
+    0x00,0x00,0x00,0x9b,0x00,0x00,0x00,0x00,0x00,0x20,0x40,0xe0,0xf4,0x96,0x20,0x40,
+    0xe0,0xff,0x00,0x20,0x40,0xe0,0xf4,0x9a,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,
+    0x80,0x89,0x00,0x00,0x00,0x00,0x9b,0x00,0x00,0x00,0x00,0x98,0x20,0x40,0xe0,0xff,
+    0x9a,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0x9b,
+    0x00,0x00,0x00,0x00,0x00,0x20,0x40,0xe0,0xf4,0x96,0x20,0x40,0xe0,0xff,0x00,0x20,
+    0x40,0xe0,0xf4,0x9a,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,
+    0x00,0x00,0x9b,0x00,0x00,0x00,0x00,0x00,0x20,0x40,0xe0,0xd4,0x96,0x20,0x40,0xe0,
+    0xff,0x00,0x20,0x40,0xe0,0xd4,0x9a,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,
+    0x89,0x00,0x00,0x00,0x00,0x9b,0x00,0x00,0x00,0x00,0x00,0x20,0x40,0xe0,0xa0,0x96,
+    0x20,0x40,0xe0,0xff,0x00,0x20,0x40,0xe0,0xa0,0x9a,0x00,0x00,0x00,0x00,0xbb,0xff,
+    0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0x9b,0x00,0x00,0x00,0x00,0x00,0x20,0x40,
+    0xe0,0x59,0x96,0x20,0x40,0xe0,0xff,0x00,0x20,0x40,0xe0,0x59,0x9a,0x00,0x00,0x00,
+    0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0x9c,0x00,0x00,0x00,0x00,
+    0x00,0x20,0x40,0xe0,0xe9,0x94,0x20,0x40,0xe0,0xff,0x00,0x20,0x40,0xe0,0xe9,0x9b,
+    0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0x9c,0x00,
+    0x00,0x00,0x00,0x00,0x20,0x40,0xe0,0x77,0x94,0x20,0x40,0xe0,0xff,0x00,0x20,0x40,
+    0xe0,0x77,0x9b,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,
+    0x00,0x9d,0x00,0x00,0x00,0x00,0x00,0x20,0x40,0xe0,0xca,0x92,0x20,0x40,0xe0,0xff,
+    0x00,0x20,0x40,0xe0,0xca,0x9c,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,
+    0x00,0x00,0x00,0x00,0x9d,0x00,0x00,0x00,0x00,0x01,0x20,0x40,0xe0,0x31,0x20,0x40,
+    0xe0,0xf4,0x90,0x20,0x40,0xe0,0xff,0x01,0x20,0x40,0xe0,0xf4,0x20,0x40,0xe0,0x31,
+    0x9c,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0x9e,
+    0x00,0x00,0x00,0x00,0x01,0x20,0x40,0xe0,0x45,0x20,0x40,0xe0,0xf4,0x8e,0x20,0x40,
+    0xe0,0xff,0x01,0x20,0x40,0xe0,0xf4,0x20,0x40,0xe0,0x45,0x9d,0x00,0x00,0x00,0x00,
+    0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0x9f,0x00,0x00,0x00,0x00,0x01,
+    0x20,0x40,0xe0,0x31,0x20,0x40,0xe0,0xca,0x8c,0x20,0x40,0xe0,0xff,0x01,0x20,0x40,
+    0xe0,0xca,0x20,0x40,0xe0,0x31,0x9e,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,
+    0x89,0x00,0x00,0x00,0x00,0xa1,0x00,0x00,0x00,0x00,0x01,0x20,0x40,0xe0,0x77,0x20,
+    0x40,0xe0,0xe9,0x88,0x20,0x40,0xe0,0xff,0x01,0x20,0x40,0xe0,0xe9,0x20,0x40,0xe0,
+    0x77,0xa0,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,
+    0xa3,0x00,0x00,0x00,0x00,0x08,0x20,0x40,0xe0,0x59,0x20,0x40,0xe0,0xa0,0x20,0x40,
+    0xe0,0xd4,0x20,0x40,0xe0,0xf4,0x20,0x40,0xe0,0xff,0x20,0x40,0xe0,0xf4,0x20,0x40,
+    0xe0,0xd4,0x20,0x40,0xe0,0xa0,0x20,0x40,0xe0,0x59,0xa2,0x00,0x00,0x00,0x00,0xbb,
+    0xff,0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0xcf,0x00,0x00,0x00,0x00,0xbb,0xff,
+    0xff,0xff,0x80,0x89,0x00,0x00,0x00,0x00,0xcf,0x00,0x00,0x00,0x00,0xbb,0xff,0xff,
+    0xff,0x80,0x89,0x00,0x00,0x00,0x00,
+};
+
+const lv_img_dsc_t img_rle_test = {
+    .header.always_zero = 0,
+    .header.w = 150,
+    .header.h = 30,
+    .data_size = sizeof(img_rle_test_data),
+    .header.cf = LV_IMG_CF_RAW_ALPHA,
+    .data = img_rle_test_data
+};
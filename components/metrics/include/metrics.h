@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Counters, gauges and histograms aggregated in fixed-length windows.
+ * Recording only adds to the current window. When a window ends it is handed
+ * out as a snapshot and the next one starts empty, so every snapshot covers
+ * the same length of time. Histograms keep the count, sum, min and max
+ * exactly and the distribution in power of 2 buckets, from which the
+ * percentiles are estimated. Snapshots are written as compact JSON.
+ * Plain C without ESP-IDF dependencies: the time is passed by the caller and
+ * nothing is locked, so the aggregation can be tested and benchmarked on the host.
+ */
+
+/** Metrics of a set */
+#ifndef METRICS_MAX
+#define METRICS_MAX             16
+#endif
+
+/** Bucket 0 holds 0, bucket b (b > 0) the values from 2^(b-1) to 2^b - 1 */
+#define METRICS_HIST_BUCKETS    33
+
+typedef enum {
+    METRICS_COUNTER = 0,        /*!< Sum of the window, starts at 0 */
+    METRICS_GAUGE,              /*!< Last value set, kept between windows */
+    METRICS_HIST,               /*!< Distribution of the values recorded in the window */
+} metrics_kind_t;
+
+typedef struct {
+    const char *name;           /*!< Key in the JSON */
+    uint8_t kind;               /*!< metrics_kind_t */
+} metrics_def_t;
+
+typedef struct {
+    uint32_t cnt;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[METRICS_HIST_BUCKETS];
+} metrics_hist_t;
+
+typedef union {
+    uint32_t counter;
+    int32_t gauge;
+    metrics_hist_t hist;
+} metrics_value_t;
+
+typedef struct {
+    uint32_t seq;               /*!< Number of the window since metrics_init() */
+    uint32_t start;
+    uint32_t len;
+    metrics_value_t values[METRICS_MAX];
+} metrics_window_t;
+
+typedef struct {
+    const metrics_def_t *defs;
+    size_t cnt;
+    uint32_t window_len;
+    metrics_window_t cur;
+} metrics_t;
+
+/**
+ * @brief Start the first window at `now`.
+ *
+ * @param defs The metrics, indexed by their id. Kept, not copied.
+ * @return False if there are more than METRICS_MAX metrics or the window length is 0.
+ */
+bool metrics_init(metrics_t *metrics, const metrics_def_t *defs, size_t cnt, uint32_t window_len, uint32_t now);
+
+/**
+ * @brief Add `n` to a counter.
+ */
+void metrics_add(metrics_t *metrics, size_t id, uint32_t n);
+
+/**
+ * @brief Set a gauge.
+ */
+void metrics_set(metrics_t *metrics, size_t id, int32_t value);
+
+/**
+ * @brief Record a value of a histogram.
+ */
+void metrics_record(metrics_t *metrics, size_t id, uint32_t value);
+
+/**
+ * @brief Time from `now` to the end of the current window.
+ */
+uint32_t metrics_until_roll(const metrics_t *metrics, uint32_t now);
+
+/**
+ * @brief End the current window if its time is over.
+ *
+ * The next window starts where the ended one ends, or at `now` if windows were skipped.
+ *
+ * @param window Set to the ended window.
+ * @return Whether a window ended.
+ */
+bool metrics_roll(metrics_t *metrics, uint32_t now, metrics_window_t *window);
+
+void metrics_hist_record(metrics_hist_t *hist, uint32_t value);
+
+/**
+ * @brief Estimate the value below which `pct` percent of the values are.
+ *
+ * Interpolated in the bucket of the value and limited to the min and max.
+ *
+ * @return 0 without values.
+ */
+uint32_t metrics_hist_percentile(const metrics_hist_t *hist, uint32_t pct);
+
+/**
+ * @brief Write a window as one line of JSON, e.g.
+ * {"seq":3,"t":30000,"len":10000,"ui_events":2,"frame_us":{"n":300,"avg":9000,"min":..,"p50":..,"p90":..,"p99":..,"max":..}}
+ *
+ * @return Length without the terminating 0, or 0 if `size` is too small.
+ */
+size_t metrics_to_json(const metrics_t *metrics, const metrics_window_t *window, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
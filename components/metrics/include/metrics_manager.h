@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define METRICS_MANAGER_DEFAULT_WINDOW_MS   10000
+#define METRICS_MANAGER_MAX_JSON_LEN        2048
+
+/* Called in the metrics task at the end of every window, e.g. to set the gauges */
+typedef void (*metrics_manager_sample_cb_t)(void *ctx);
+
+typedef struct {
+    const metrics_def_t *defs;      /*!< Kept, not copied */
+    size_t cnt;
+    uint32_t window_ms;             /*!< 0 for METRICS_MANAGER_DEFAULT_WINDOW_MS */
+    const char *topic;              /*!< Kept, not copied */
+    metrics_manager_sample_cb_t sample_cb;
+    void *sample_ctx;
+} metrics_manager_config_t;
+
+typedef struct {
+    uint32_t published_cnt;         /**< Snapshots handed to the MQTT client */
+    uint32_t failed_cnt;            /**< Snapshots lost, mostly while the broker was unreachable */
+    uint32_t last_len;              /**< Bytes of the last snapshot */
+} metrics_manager_stat_t;
+
+/*
+ * Start aggregating and publish a JSON snapshot of every window with QoS1 via
+ * mqtt_manager. The snapshots aren't kept while the broker is unreachable.
+ */
+esp_err_t metrics_manager_init(const metrics_manager_config_t *config);
+
+/*
+ * Record into the current window. Take a spinlock for a few instructions, so
+ * they can be called from any task and from interrupts. Ignored before
+ * metrics_manager_init().
+ */
+void metrics_manager_add(size_t id, uint32_t n);
+void metrics_manager_set(size_t id, int32_t value);
+void metrics_manager_record(size_t id, uint32_t value);
+
+void metrics_manager_get_stat(metrics_manager_stat_t *stat);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,168 @@
+#include "metrics.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static void metrics_clear_window(metrics_t *metrics)
+{
+    for (size_t i = 0; i < metrics->cnt; ++i) {
+        metrics_value_t *value = &metrics->cur.values[i];
+        switch (metrics->defs[i].kind) {
+        case METRICS_COUNTER:
+            value->counter = 0;
+            break;
+        case METRICS_HIST:
+            memset(&value->hist, 0, sizeof(value->hist));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool metrics_init(metrics_t *metrics, const metrics_def_t *defs, size_t cnt, uint32_t window_len, uint32_t now)
+{
+    memset(metrics, 0, sizeof(*metrics));
+    if (cnt > METRICS_MAX || window_len == 0) {
+        return false;
+    }
+    metrics->defs = defs;
+    metrics->cnt = cnt;
+    metrics->window_len = window_len;
+    metrics->cur.start = now;
+    metrics->cur.len = window_len;
+    return true;
+}
+
+void metrics_add(metrics_t *metrics, size_t id, uint32_t n)
+{
+    if (id < metrics->cnt && metrics->defs[id].kind == METRICS_COUNTER) {
+        metrics->cur.values[id].counter += n;
+    }
+}
+
+void metrics_set(metrics_t *metrics, size_t id, int32_t value)
+{
+    if (id < metrics->cnt && metrics->defs[id].kind == METRICS_GAUGE) {
+        metrics->cur.values[id].gauge = value;
+    }
+}
+
+void metrics_record(metrics_t *metrics, size_t id, uint32_t value)
+{
+    if (id < metrics->cnt && metrics->defs[id].kind == METRICS_HIST) {
+        metrics_hist_record(&metrics->cur.values[id].hist, value);
+    }
+}
+
+uint32_t metrics_until_roll(const metrics_t *metrics, uint32_t now)
+{
+    uint32_t elapsed = now - metrics->cur.start;
+    return elapsed < metrics->window_len ? metrics->window_len - elapsed : 0;
+}
+
+bool metrics_roll(metrics_t *metrics, uint32_t now, metrics_window_t *window)
+{
+    uint32_t elapsed = now - metrics->cur.start;
+    if (elapsed < metrics->window_len) {
+        return false;
+    }
+    *window = metrics->cur;
+    metrics->cur.seq++;
+    metrics->cur.start = elapsed < 2 * metrics->window_len ? metrics->cur.start + metrics->window_len : now;
+    metrics_clear_window(metrics);
+    return true;
+}
+
+static uint32_t metrics_bucket(uint32_t value)
+{
+    return value ? 32 - (uint32_t)__builtin_clz(value) : 0;
+}
+
+void metrics_hist_record(metrics_hist_t *hist, uint32_t value)
+{
+    if (hist->cnt == 0 || value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    hist->cnt++;
+    hist->sum += value;
+    hist->buckets[metrics_bucket(value)]++;
+}
+
+uint32_t metrics_hist_percentile(const metrics_hist_t *hist, uint32_t pct)
+{
+    if (hist->cnt == 0) {
+        return 0;
+    }
+    /* Rank of the value, 1 based */
+    uint64_t rank = ((uint64_t)hist->cnt * pct + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t below = 0;
+    for (uint32_t b = 0; b < METRICS_HIST_BUCKETS; ++b) {
+        uint32_t cnt = hist->buckets[b];
+        if (below + cnt < rank) {
+            below += cnt;
+            continue;
+        }
+        uint64_t low = b ? (uint64_t)1 << (b - 1) : 0;
+        uint64_t high = b ? ((uint64_t)1 << b) - 1 : 0;
+        uint64_t value = low + (high - low) * (rank - below) / cnt;
+        if (value < hist->min) {
+            value = hist->min;
+        }
+        if (value > hist->max) {
+            value = hist->max;
+        }
+        return (uint32_t)value;
+    }
+    return hist->max;
+}
+
+size_t metrics_to_json(const metrics_t *metrics, const metrics_window_t *window, char *buf, size_t size)
+{
+    size_t len = 0;
+    int n = snprintf(buf, size, "{\"seq\":%" PRIu32 ",\"t\":%" PRIu32 ",\"len\":%" PRIu32,
+                     window->seq, window->start, window->len);
+    for (size_t i = 0; n >= 0 && (size_t)n < size - len && i < metrics->cnt; ++i) {
+        len += (size_t)n;
+        const metrics_value_t *value = &window->values[i];
+        const char *name = metrics->defs[i].name;
+        switch (metrics->defs[i].kind) {
+        case METRICS_COUNTER:
+            n = snprintf(&buf[len], size - len, ",\"%s\":%" PRIu32, name, value->counter);
+            break;
+        case METRICS_GAUGE:
+            n = snprintf(&buf[len], size - len, ",\"%s\":%" PRId32, name, value->gauge);
+            break;
+        default: {
+            const metrics_hist_t *hist = &value->hist;
+            if (hist->cnt == 0) {
+                n = snprintf(&buf[len], size - len, ",\"%s\":{\"n\":0}", name);
+                break;
+            }
+            n = snprintf(&buf[len], size - len,
+                         ",\"%s\":{\"n\":%" PRIu32 ",\"avg\":%" PRIu32 ",\"min\":%" PRIu32 ",\"p50\":%" PRIu32
+                         ",\"p90\":%" PRIu32 ",\"p99\":%" PRIu32 ",\"max\":%" PRIu32 "}",
+                         name, hist->cnt, (uint32_t)(hist->sum / hist->cnt), hist->min,
+                         metrics_hist_percentile(hist, 50), metrics_hist_percentile(hist, 90),
+                         metrics_hist_percentile(hist, 99), hist->max);
+            break;
+        }
+        }
+    }
+    if (n < 0 || (size_t)n >= size - len) {
+        return 0;
+    }
+    len += (size_t)n;
+    n = snprintf(&buf[len], size - len, "}");
+    if (n < 0 || (size_t)n >= size - len) {
+        return 0;
+    }
+    return len + (size_t)n;
+}
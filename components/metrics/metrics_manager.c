@@ -0,0 +1,135 @@
+#include "metrics_manager.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mqtt_manager.h"
+
+#define METRICS_MANAGER_TASK_STACK      4096
+/* Below the UI and the MQTT tasks: a late snapshot costs nothing */
+#define METRICS_MANAGER_TASK_PRIORITY   1
+
+static const char *TAG = "metrics";
+
+typedef struct {
+    bool initialized;
+    portMUX_TYPE lock;
+    metrics_t metrics;              /* Taken with `lock` */
+    metrics_window_t window;        /* Ended window, only used by the task */
+    char json[METRICS_MANAGER_MAX_JSON_LEN];
+    metrics_manager_config_t config;
+    metrics_manager_stat_t stat;
+} metrics_manager_ctx_t;
+
+static metrics_manager_ctx_t s_metrics = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static uint32_t metrics_manager_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void metrics_manager_publish(void)
+{
+    size_t len = metrics_to_json(&s_metrics.metrics, &s_metrics.window, s_metrics.json, sizeof(s_metrics.json));
+    if (len == 0) {
+        ESP_LOGW(TAG, "Snapshot longer than %d bytes", METRICS_MANAGER_MAX_JSON_LEN);
+        s_metrics.stat.failed_cnt++;
+        return;
+    }
+    s_metrics.stat.last_len = (uint32_t)len;
+    if (mqtt_manager_publish(s_metrics.config.topic, s_metrics.json, len, 1) == ESP_OK) {
+        s_metrics.stat.published_cnt++;
+    } else {
+        s_metrics.stat.failed_cnt++;
+    }
+}
+
+static void metrics_manager_task(void *arg)
+{
+    (void)arg;
+    while (true) {
+        taskENTER_CRITICAL(&s_metrics.lock);
+        uint32_t wait_ms = metrics_until_roll(&s_metrics.metrics, metrics_manager_now_ms());
+        taskEXIT_CRITICAL(&s_metrics.lock);
+        if (wait_ms > 0) {
+            vTaskDelay(pdMS_TO_TICKS(wait_ms) + 1);
+            continue;
+        }
+
+        if (s_metrics.config.sample_cb) {
+            s_metrics.config.sample_cb(s_metrics.config.sample_ctx);
+        }
+        taskENTER_CRITICAL(&s_metrics.lock);
+        bool ended = metrics_roll(&s_metrics.metrics, metrics_manager_now_ms(), &s_metrics.window);
+        taskEXIT_CRITICAL(&s_metrics.lock);
+        if (ended) {
+            metrics_manager_publish();
+        }
+    }
+}
+
+esp_err_t metrics_manager_init(const metrics_manager_config_t *config)
+{
+    if (s_metrics.initialized) {
+        return ESP_OK;
+    }
+    if (!config || !config->defs || !config->topic) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_metrics.config = *config;
+    if (!s_metrics.config.window_ms) {
+        s_metrics.config.window_ms = METRICS_MANAGER_DEFAULT_WINDOW_MS;
+    }
+    if (!metrics_init(&s_metrics.metrics, config->defs, config->cnt, s_metrics.config.window_ms,
+                      metrics_manager_now_ms())) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (xTaskCreate(metrics_manager_task, "metrics", METRICS_MANAGER_TASK_STACK, NULL,
+                    METRICS_MANAGER_TASK_PRIORITY, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    __atomic_store_n(&s_metrics.initialized, true, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+void metrics_manager_add(size_t id, uint32_t n)
+{
+    if (!__atomic_load_n(&s_metrics.initialized, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    portENTER_CRITICAL_SAFE(&s_metrics.lock);
+    metrics_add(&s_metrics.metrics, id, n);
+    portEXIT_CRITICAL_SAFE(&s_metrics.lock);
+}
+
+void metrics_manager_set(size_t id, int32_t value)
+{
+    if (!__atomic_load_n(&s_metrics.initialized, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    portENTER_CRITICAL_SAFE(&s_metrics.lock);
+    metrics_set(&s_metrics.metrics, id, value);
+    portEXIT_CRITICAL_SAFE(&s_metrics.lock);
+}
+
+void metrics_manager_record(size_t id, uint32_t value)
+{
+    if (!__atomic_load_n(&s_metrics.initialized, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    portENTER_CRITICAL_SAFE(&s_metrics.lock);
+    metrics_record(&s_metrics.metrics, id, value);
+    portEXIT_CRITICAL_SAFE(&s_metrics.lock);
+}
+
+void metrics_manager_get_stat(metrics_manager_stat_t *stat)
+{
+    if (stat) {
+        *stat = s_metrics.stat;
+    }
+}
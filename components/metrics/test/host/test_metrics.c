@@ -0,0 +1,296 @@
+/* Window rolling, histogram percentiles and the JSON snapshots of the metrics */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "metrics.h"
+
+#define VALUE_CNT   10000
+
+typedef enum {
+    M_UI_EVENTS = 0,
+    M_UI_QUEUE,
+    M_FRAME_US,
+    M_CNT,
+} metric_id_t;
+
+static const metrics_def_t defs[M_CNT] = {
+    [M_UI_EVENTS] = { "ui_events", METRICS_COUNTER },
+    [M_UI_QUEUE] = { "ui_queue", METRICS_GAUGE },
+    [M_FRAME_US] = { "frame_us", METRICS_HIST },
+};
+
+static uint32_t seed = 1;
+static uint32_t values[VALUE_CNT];
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) | (seed << 16);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t bucket_low(uint32_t value)
+{
+    return value ? (uint32_t)1 << (31 - __builtin_clz(value)) : 0;
+}
+
+static uint32_t bucket_high(uint32_t value)
+{
+    return value ? (uint32_t)(((uint64_t)bucket_low(value) << 1) - 1) : 0;
+}
+
+static void test_init(void)
+{
+    metrics_t metrics;
+    assert(!metrics_init(&metrics, defs, METRICS_MAX + 1, 1000, 0));
+    assert(!metrics_init(&metrics, defs, M_CNT, 0, 0));
+    assert(metrics_init(&metrics, defs, M_CNT, 1000, 5));
+    assert(metrics.cur.seq == 0 && metrics.cur.start == 5 && metrics.cur.len == 1000);
+
+    /* Wrong kinds and unknown ids are ignored */
+    metrics_add(&metrics, M_UI_QUEUE, 5);
+    metrics_add(&metrics, M_FRAME_US, 5);
+    metrics_set(&metrics, M_UI_EVENTS, 5);
+    metrics_record(&metrics, M_UI_QUEUE, 5);
+    metrics_add(&metrics, M_CNT, 1);
+    metrics_add(&metrics, METRICS_MAX, 1);
+    metrics_window_t window;
+    assert(metrics_roll(&metrics, 1005, &window));
+    assert(window.values[M_UI_EVENTS].counter == 0 && window.values[M_UI_QUEUE].gauge == 0);
+    assert(window.values[M_FRAME_US].hist.cnt == 0);
+}
+
+static void test_window_roll(void)
+{
+    metrics_t metrics;
+    metrics_window_t window;
+    assert(metrics_init(&metrics, defs, M_CNT, 1000, 5));
+    assert(metrics_until_roll(&metrics, 5) == 1000);
+    assert(metrics_until_roll(&metrics, 1004) == 1);
+    assert(metrics_until_roll(&metrics, 1005) == 0 && metrics_until_roll(&metrics, 5000) == 0);
+    assert(!metrics_roll(&metrics, 1004, &window));
+
+    metrics_add(&metrics, M_UI_EVENTS, 2);
+    metrics_add(&metrics, M_UI_EVENTS, 3);
+    metrics_set(&metrics, M_UI_QUEUE, -4);
+    metrics_record(&metrics, M_FRAME_US, 9000);
+    assert(metrics_roll(&metrics, 1005, &window));
+    assert(window.seq == 0 && window.start == 5 && window.len == 1000);
+    assert(window.values[M_UI_EVENTS].counter == 5 && window.values[M_UI_QUEUE].gauge == -4);
+    assert(window.values[M_FRAME_US].hist.cnt == 1);
+
+    /* Counters and histograms restart, gauges are kept. A late roll doesn't shift the windows */
+    assert(!metrics_roll(&metrics, 2004, &window));
+    assert(metrics_roll(&metrics, 2100, &window));
+    assert(window.seq == 1 && window.start == 1005);
+    assert(window.values[M_UI_EVENTS].counter == 0 && window.values[M_UI_QUEUE].gauge == -4);
+    assert(window.values[M_FRAME_US].hist.cnt == 0);
+    assert(metrics.cur.start == 2005 && metrics_until_roll(&metrics, 2100) == 905);
+
+    /* Only one window per roll, also when late */
+    metrics_add(&metrics, M_UI_EVENTS, 1);
+    assert(metrics_roll(&metrics, 4003, &window) && window.start == 2005 && window.values[M_UI_EVENTS].counter == 1);
+    assert(!metrics_roll(&metrics, 4003, &window) && metrics.cur.start == 3005);
+    assert(metrics_roll(&metrics, 4005, &window) && window.values[M_UI_EVENTS].counter == 0);
+}
+
+static void test_window_skip(void)
+{
+    metrics_t metrics;
+    metrics_window_t window;
+    assert(metrics_init(&metrics, defs, M_CNT, 1000, 0));
+    metrics_add(&metrics, M_UI_EVENTS, 7);
+
+    /* Not rolled for a while (e.g. the task was blocked): the skipped windows aren't made up */
+    assert(metrics_roll(&metrics, 9500, &window));
+    assert(window.seq == 0 && window.start == 0 && window.values[M_UI_EVENTS].counter == 7);
+    assert(metrics.cur.seq == 1 && metrics.cur.start == 9500);
+    assert(!metrics_roll(&metrics, 10499, &window));
+    assert(metrics_roll(&metrics, 10500, &window) && window.seq == 1 && window.start == 9500);
+
+    /* Just under two windows late: still aligned */
+    assert(metrics_roll(&metrics, 12499, &window) && window.start == 10500);
+    assert(metrics.cur.start == 11500);
+    /* Exactly two windows late: restarted */
+    assert(metrics_roll(&metrics, 13500, &window) && window.start == 11500);
+    assert(metrics.cur.start == 13500);
+}
+
+static void test_time_wrap(void)
+{
+    metrics_t metrics;
+    metrics_window_t window;
+    assert(metrics_init(&metrics, defs, M_CNT, 1000, UINT32_MAX - 10));
+    assert(metrics_until_roll(&metrics, 500) == 489);
+    assert(!metrics_roll(&metrics, 500, &window));
+    assert(metrics_roll(&metrics, 989, &window));
+    assert(window.start == UINT32_MAX - 10 && metrics.cur.start == 989);
+}
+
+/* Every percentile is in the power of 2 bucket of the exact one, between the min and the max */
+static void check_percentiles(const uint32_t *sorted, uint32_t cnt, const char *name)
+{
+    metrics_hist_t hist = { 0 };
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < cnt; ++i) {
+        metrics_hist_record(&hist, sorted[(i * 7919u) % cnt]);
+        sum += sorted[i];
+    }
+    assert(hist.cnt == cnt && hist.sum == sum && hist.min == sorted[0] && hist.max == sorted[cnt - 1]);
+
+    uint32_t last = 0;
+    double max_error = 0;
+    for (uint32_t pct = 0; pct <= 100; ++pct) {
+        uint32_t rank = (uint32_t)(((uint64_t)cnt * pct + 99) / 100);
+        uint32_t exact = sorted[rank ? rank - 1 : 0];
+        uint32_t estimate = metrics_hist_percentile(&hist, pct);
+        assert(estimate >= bucket_low(exact) && estimate <= bucket_high(exact));
+        assert(estimate >= hist.min && estimate <= hist.max);
+        /* Never decreasing */
+        assert(estimate >= last);
+        last = estimate;
+        if (exact) {
+            double error = ((double)estimate - exact) / exact;
+            error = error < 0 ? -error : error;
+            max_error = error > max_error ? error : max_error;
+        }
+    }
+    assert(metrics_hist_percentile(&hist, 100) == hist.max);
+    printf("%s: p50 %u (exact %u), p99 %u (exact %u), max error %.0f%%\n", name,
+           (unsigned)metrics_hist_percentile(&hist, 50), (unsigned)sorted[(cnt * 50 + 99) / 100 - 1],
+           (unsigned)metrics_hist_percentile(&hist, 99), (unsigned)sorted[(cnt * 99 + 99) / 100 - 1],
+           max_error * 100);
+    assert(max_error < 1.0);
+}
+
+static void test_percentiles(void)
+{
+    /* Frame times: uniform, long tailed, constant, two modes, and spanning all buckets */
+    for (uint32_t i = 0; i < VALUE_CNT; ++i) {
+        values[i] = 1000 + rnd() % 30000;
+    }
+    qsort(values, VALUE_CNT, sizeof(values[0]), compare_u32);
+    check_percentiles(values, VALUE_CNT, "uniform");
+
+    for (uint32_t i = 0; i < VALUE_CNT; ++i) {
+        values[i] = 8000 + (rnd() % 100 == 0 ? rnd() % 200000 : rnd() % 2000);
+    }
+    qsort(values, VALUE_CNT, sizeof(values[0]), compare_u32);
+    check_percentiles(values, VALUE_CNT, "long tail");
+
+    for (uint32_t i = 0; i < VALUE_CNT; ++i) {
+        values[i] = 16667;
+    }
+    check_percentiles(values, VALUE_CNT, "constant");
+
+    for (uint32_t i = 0; i < VALUE_CNT; ++i) {
+        values[i] = i % 2 ? 16000 + rnd() % 1000 : 33000 + rnd() % 1000;
+    }
+    qsort(values, VALUE_CNT, sizeof(values[0]), compare_u32);
+    check_percentiles(values, VALUE_CNT, "two modes");
+
+    for (uint32_t i = 0; i < VALUE_CNT; ++i) {
+        values[i] = rnd() >> (rnd() % 32);
+    }
+    values[0] = 0;
+    values[1] = UINT32_MAX;
+    qsort(values, VALUE_CNT, sizeof(values[0]), compare_u32);
+    metrics_hist_t hist = { 0 };
+    for (uint32_t i = 0; i < VALUE_CNT; ++i) {
+        metrics_hist_record(&hist, values[i]);
+    }
+    for (uint32_t pct = 0; pct <= 100; ++pct) {
+        uint32_t rank = (VALUE_CNT * pct + 99) / 100;
+        uint32_t exact = values[rank ? rank - 1 : 0];
+        uint32_t estimate = metrics_hist_percentile(&hist, pct);
+        assert(estimate >= bucket_low(exact) && estimate <= bucket_high(exact));
+    }
+
+    /* Few values */
+    metrics_hist_t empty = { 0 };
+    assert(metrics_hist_percentile(&empty, 50) == 0);
+    metrics_hist_t seven = { 0 };
+    metrics_hist_record(&seven, 7);
+    for (uint32_t pct = 0; pct <= 100; ++pct) {
+        assert(metrics_hist_percentile(&seven, pct) == 7);
+    }
+    metrics_hist_t extremes = { 0 };
+    metrics_hist_record(&extremes, 0);
+    assert(metrics_hist_percentile(&extremes, 99) == 0);
+    metrics_hist_record(&extremes, UINT32_MAX);
+    assert(metrics_hist_percentile(&extremes, 50) == 0 && metrics_hist_percentile(&extremes, 51) == UINT32_MAX);
+    assert(extremes.sum == UINT32_MAX && extremes.buckets[0] == 1 && extremes.buckets[32] == 1);
+}
+
+static void test_json(void)
+{
+    metrics_t metrics;
+    metrics_window_t window;
+    char buf[512];
+    assert(metrics_init(&metrics, defs, M_CNT, 10000, 20000));
+    metrics_add(&metrics, M_UI_EVENTS, 2);
+    metrics_set(&metrics, M_UI_QUEUE, -1);
+    metrics_record(&metrics, M_FRAME_US, 9000);
+    metrics_record(&metrics, M_FRAME_US, 9000);
+    metrics_record(&metrics, M_FRAME_US, 12000);
+    assert(metrics_roll(&metrics, 30000, &window));
+
+    const char *expected = "{\"seq\":0,\"t\":20000,\"len\":10000,\"ui_events\":2,\"ui_queue\":-1,"
+                           "\"frame_us\":{\"n\":3,\"avg\":10000,\"min\":9000,\"p50\":12000,\"p90\":12000,"
+                           "\"p99\":12000,\"max\":12000}}";
+    size_t len = metrics_to_json(&metrics, &window, buf, sizeof(buf));
+    assert(len == strlen(expected) && strcmp(buf, expected) == 0);
+
+    /* Too small by any amount: 0, and nothing written past the buffer */
+    for (size_t size = 0; size <= len; ++size) {
+        memset(buf, '#', sizeof(buf));
+        assert(metrics_to_json(&metrics, &window, buf, size) == 0);
+        for (size_t i = size; i < sizeof(buf); ++i) {
+            assert(buf[i] == '#');
+        }
+    }
+    assert(metrics_to_json(&metrics, &window, buf, len + 1) == len);
+
+    /* An empty histogram */
+    assert(metrics_roll(&metrics, 40000, &window));
+    len = metrics_to_json(&metrics, &window, buf, sizeof(buf));
+    assert(strcmp(buf, "{\"seq\":1,\"t\":30000,\"len\":10000,\"ui_events\":0,\"ui_queue\":-1,"
+                  "\"frame_us\":{\"n\":0}}") == 0);
+    assert(len == strlen(buf));
+
+    /* The widest values */
+    metrics_add(&metrics, M_UI_EVENTS, UINT32_MAX);
+    metrics_set(&metrics, M_UI_QUEUE, INT32_MIN);
+    metrics_record(&metrics, M_FRAME_US, UINT32_MAX);
+    metrics_record(&metrics, M_FRAME_US, UINT32_MAX);
+    assert(metrics_roll(&metrics, 50000, &window));
+    len = metrics_to_json(&metrics, &window, buf, sizeof(buf));
+    assert(len > 0 && strstr(buf, "\"ui_events\":4294967295,\"ui_queue\":-2147483648,"));
+    assert(strstr(buf, "\"avg\":4294967295"));
+    for (size_t size = 0; size <= len; ++size) {
+        assert(metrics_to_json(&metrics, &window, buf, size) == 0);
+    }
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    RUN(test_init);
+    RUN(test_window_roll);
+    RUN(test_window_skip);
+    RUN(test_time_wrap);
+    RUN(test_percentiles);
+    RUN(test_json);
+    return 0;
+}
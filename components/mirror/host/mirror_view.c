@@ -0,0 +1,110 @@
+/*
+ * Host viewer of the mirror stream: reads the stream from stdin and writes the
+ * screen as a PPM image at the end of every frame.
+ *
+ * Build:
+ *   cc -O2 -Icomponents/mirror/include components/mirror/host/mirror_view.c components/mirror/mirror.c -o mirror_view
+ * Run, with the mirror turned on by publishing "on" to esp32lvgl/mirror/ctl:
+ *   mosquitto_sub -h <broker> -t esp32lvgl/mirror -N | ./mirror_view screen.ppm
+ * The image is replaced atomically, so a viewer reloading it (e.g. `feh -R 0.2`) never
+ * sees half a file. Publish "key" after starting late to get the whole screen.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mirror.h"
+
+#define MIRROR_VIEW_DEFAULT_SIZE    466
+#define MIRROR_VIEW_BUF_SIZE        (256 * 1024)
+
+static int write_ppm(const char *path, const uint16_t *screen, uint16_t width, uint16_t height, bool swapped)
+{
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *file = fopen(tmp, "wb");
+    if (!file) {
+        perror(tmp);
+        return -1;
+    }
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+    for (size_t i = 0; i < (size_t)width * height; ++i) {
+        uint16_t pixel = screen[i];
+        if (swapped) {
+            pixel = (uint16_t)(pixel << 8 | pixel >> 8);
+        }
+        uint8_t r = (uint8_t)(pixel >> 11 & 0x1f);
+        uint8_t g = (uint8_t)(pixel >> 5 & 0x3f);
+        uint8_t b = (uint8_t)(pixel & 0x1f);
+        uint8_t rgb[3] = { (uint8_t)(r << 3 | r >> 2), (uint8_t)(g << 2 | g >> 4), (uint8_t)(b << 3 | b >> 2) };
+        fwrite(rgb, 1, sizeof(rgb), file);
+    }
+    if (fclose(file) != 0 || rename(tmp, path) != 0) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s out.ppm [width height] < stream\n", argv[0]);
+        return 2;
+    }
+    uint16_t width = argc >= 4 ? (uint16_t)atoi(argv[2]) : MIRROR_VIEW_DEFAULT_SIZE;
+    uint16_t height = argc >= 4 ? (uint16_t)atoi(argv[3]) : MIRROR_VIEW_DEFAULT_SIZE;
+    uint16_t *screen = calloc((size_t)width * height, sizeof(uint16_t));
+    uint8_t *buf = malloc(MIRROR_VIEW_BUF_SIZE);
+    if (!screen || !buf) {
+        fprintf(stderr, "no memory\n");
+        return 1;
+    }
+
+    size_t len = 0;
+    bool synced = false;
+    unsigned frames = 0;
+    while (true) {
+        size_t n = fread(&buf[len], 1, MIRROR_VIEW_BUF_SIZE - len, stdin);
+        if (n == 0) {
+            break;
+        }
+        len += n;
+        size_t pos = 0;
+        while (pos < len) {
+            mirror_packet_t packet;
+            long used = mirror_decode(&buf[pos], len - pos, screen, width, height, &packet);
+            if (used == 0) {
+                break;
+            }
+            if (used < 0) {
+                /* Lost in the stream: wait for a key frame on a packet boundary */
+                if (synced) {
+                    fprintf(stderr, "invalid packet, waiting for a key frame\n");
+                }
+                synced = false;
+                pos++;
+                continue;
+            }
+            pos += (size_t)used;
+            if (packet.flags & MIRROR_FLAG_KEY) {
+                synced = true;
+            }
+            if (synced && (packet.flags & MIRROR_FLAG_FRAME_END)) {
+                write_ppm(argv[1], screen, width, height, packet.flags & MIRROR_FLAG_SWAPPED);
+                frames++;
+            }
+        }
+        if (pos == 0 && len == MIRROR_VIEW_BUF_SIZE) {
+            fprintf(stderr, "packet longer than %u bytes\n", (unsigned)MIRROR_VIEW_BUF_SIZE);
+            return 1;
+        }
+        memmove(buf, &buf[pos], len - pos);
+        len -= pos;
+    }
+    fprintf(stderr, "%u frames\n", frames);
+    free(buf);
+    free(screen);
+    return 0;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Mirroring of a 16 bit display to a remote viewer.
+ * The flushed areas are copied into `cur`, a copy of the screen, and collected
+ * as dirty rectangles. A frame encodes the dirty rectangles against `sent`,
+ * the content the viewer has: every pixel is XORed with its sent value, so
+ * the unchanged pixels become 0, and the result is run length encoded.
+ * Areas flushed several times before a frame is sent are sent once, so the
+ * frame rate adapts to the bandwidth without a backlog.
+ *
+ * Stream: packets, each one a band of rows of a rectangle, little endian:
+ *   0  MIRROR_MAGIC
+ *   1  flags (MIRROR_FLAG_*)
+ *   2  frame sequence number, 16 bit
+ *   4  x, y, w, h, 16 bit each
+ *   12 length of the data, 32 bit
+ *   16 data: the rows' XORed pixels as tokens of a control byte c and
+ *        c < 0x80:  c + 1 pixels, 16 bit each
+ *        c >= 0x80: (c & 0x7f) + 1 times the following pixel
+ * The packets are self-delimiting, so the stream can be cut into messages anywhere
+ * between packets, or read from a socket as it comes.
+ * Plain C without ESP-IDF dependencies: the host viewer decodes with the same code.
+ */
+
+#define MIRROR_MAGIC            0x4d
+#define MIRROR_HEADER_SIZE      16
+
+#define MIRROR_FLAG_KEY         0x01    /*!< The viewer clears the screen to 0 before the packet */
+#define MIRROR_FLAG_FRAME_END   0x02    /*!< Last packet of a frame */
+#define MIRROR_FLAG_SWAPPED     0x04    /*!< RGB565 with the bytes swapped (LV_COLOR_16_SWAP) */
+
+/** Dirty rectangles kept apart, more are merged */
+#ifndef MIRROR_MAX_RECTS
+#define MIRROR_MAX_RECTS        8
+#endif
+
+/** Widest screen */
+#ifndef MIRROR_MAX_WIDTH
+#define MIRROR_MAX_WIDTH        1024
+#endif
+
+/** Longest encoded row of `w` pixels */
+#define MIRROR_ROW_MAX_SIZE(w)  ((size_t)(w) * 2 + (size_t)(w) / 128 + 1)
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} mirror_rect_t;
+
+typedef struct {
+    mirror_rect_t rects[MIRROR_MAX_RECTS];
+    uint8_t cnt;
+} mirror_region_t;
+
+/* Bandwidth limit: a token bucket of bytes */
+typedef struct {
+    uint32_t bytes_per_s;
+    uint32_t burst;
+    int64_t tokens;             /*!< Negative after a frame larger than the tokens left */
+    uint32_t last;
+} mirror_rate_t;
+
+typedef struct {
+    uint32_t capture_cnt;       /**< Flushed areas captured */
+    uint32_t frame_cnt;         /**< Frames sent */
+    uint32_t skipped_cnt;       /**< Frames due but over the bandwidth limit, sent later merged */
+    uint32_t raw_bytes;         /**< Size of the sent pixels */
+    uint32_t sent_bytes;        /**< Size of the packets */
+} mirror_stat_t;
+
+typedef struct {
+    uint16_t *cur;              /*!< Screen as flushed, width * height pixels */
+    uint16_t *sent;             /*!< Screen as sent to the viewer */
+    uint16_t width;
+    uint16_t height;
+    uint8_t flags;              /*!< MIRROR_FLAG_SWAPPED, added to every packet */
+    uint16_t seq;
+    bool key;                   /*!< The next frame starts from a cleared screen */
+    mirror_region_t dirty;
+    mirror_rate_t rate;
+    mirror_stat_t stat;
+} mirror_t;
+
+/**
+ * @brief Set up a mirror starting with a key frame of the whole screen.
+ *
+ * @param cur, sent     Buffers of width * height pixels
+ * @param bytes_per_s   Bandwidth limit, 0 for none
+ * @return False if the width is over MIRROR_MAX_WIDTH.
+ */
+bool mirror_init(mirror_t *mirror, uint16_t *cur, uint16_t *sent, uint16_t width, uint16_t height,
+                 uint8_t flags, uint32_t bytes_per_s, uint32_t now_ms);
+
+/**
+ * @brief Copy a flushed area, its rows of `rect.w` pixels following each other.
+ *
+ * Clipped to the screen.
+ */
+void mirror_capture(mirror_t *mirror, mirror_rect_t rect, const uint16_t *pixels);
+
+/**
+ * @brief Send the whole screen again, e.g. for a viewer joining.
+ */
+void mirror_request_key(mirror_t *mirror);
+
+/**
+ * @brief Take the dirty rectangles of the next frame, if the bandwidth allows.
+ *
+ * @param key Set to whether the frame is a key frame.
+ * @return False if nothing is dirty or the bandwidth limit is reached.
+ */
+bool mirror_take(mirror_t *mirror, uint32_t now_ms, mirror_region_t *region, bool *key);
+
+/**
+ * @brief Encode the rectangles taken by mirror_take() into packets.
+ *
+ * Can run without holding the lock of mirror_capture(): a pixel changing
+ * meanwhile is sent with either value and its area is dirty again. The rows
+ * not fitting into `size` are left in `region`, to be given back with mirror_untake().
+ * mirror_take() and mirror_encode() have to be called by one task.
+ *
+ * @param key Cleared once the key frame is started.
+ * @return Length of the packets, 0 if not even one row fits.
+ */
+size_t mirror_encode(mirror_t *mirror, mirror_region_t *region, bool *key, uint8_t *out, size_t size);
+
+/**
+ * @brief Give back the rectangles not encoded, and a key frame not started.
+ */
+void mirror_untake(mirror_t *mirror, const mirror_region_t *region, bool key);
+
+/**
+ * @brief Add a rectangle, merging it with the overlapping and touching ones.
+ */
+void mirror_region_add(mirror_region_t *region, mirror_rect_t rect);
+
+typedef struct {
+    uint8_t flags;
+    uint16_t seq;
+    mirror_rect_t rect;
+} mirror_packet_t;
+
+/**
+ * @brief Apply a packet of the stream to a screen of width * height pixels.
+ *
+ * @return Bytes of the packet, 0 if `len` doesn't hold the whole packet yet, or -1 if it is
+ *         invalid. The screen is left partly updated by an invalid packet.
+ */
+long mirror_decode(const uint8_t *data, size_t len, uint16_t *screen, uint16_t width, uint16_t height,
+                   mirror_packet_t *packet);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "mirror.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MIRROR_MANAGER_DEFAULT_BYTES_PER_S  (64 * 1024)
+#define MIRROR_MANAGER_DEFAULT_MSG_LEN      (16 * 1024)
+#define MIRROR_MANAGER_DEFAULT_FRAME_MS     100
+
+/* Send a part of the stream, returns whether it was sent */
+typedef bool (*mirror_manager_send_cb_t)(const uint8_t *data, size_t len, void *ctx);
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t flags;                  /*!< MIRROR_FLAG_SWAPPED if the pixels are */
+    uint32_t bytes_per_s;           /*!< 0 for MIRROR_MANAGER_DEFAULT_BYTES_PER_S */
+    uint32_t max_msg_len;           /*!< 0 for MIRROR_MANAGER_DEFAULT_MSG_LEN */
+    uint32_t frame_ms;              /*!< Shortest time between frames, 0 for MIRROR_MANAGER_DEFAULT_FRAME_MS */
+    mirror_manager_send_cb_t send_cb;
+    void *send_ctx;
+} mirror_manager_config_t;
+
+typedef struct {
+    mirror_stat_t mirror;
+    uint32_t capture_us_max;        /**< Longest copy of a flushed area, taken from the flushing task */
+    uint32_t encode_us_max;         /**< Longest encoding of a message, in the mirror task */
+    uint32_t send_fail_cnt;         /**< Messages not sent, followed by a key frame */
+} mirror_manager_stat_t;
+
+/*
+ * Set up the mirror task. Nothing is captured and no memory is taken until
+ * mirror_manager_start().
+ */
+esp_err_t mirror_manager_init(const mirror_manager_config_t *config);
+
+/*
+ * Start mirroring with a key frame. Two copies of the screen are allocated in PSRAM.
+ */
+esp_err_t mirror_manager_start(void);
+
+/*
+ * Stop mirroring and free the copies of the screen.
+ */
+void mirror_manager_stop(void);
+
+/*
+ * Send the whole screen again, e.g. for a viewer joining.
+ */
+void mirror_manager_request_key(void);
+
+/*
+ * Copy a flushed area, e.g. from the display driver's flush callback.
+ * Returns at once while not mirroring.
+ */
+void mirror_manager_capture(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels);
+
+void mirror_manager_get_stat(mirror_manager_stat_t *stat);
+
+#ifdef __cplusplus
+}
+#endif
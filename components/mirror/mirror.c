@@ -0,0 +1,303 @@
+#include "mirror.h"
+
+#include <string.h>
+
+static void mirror_put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t mirror_get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static bool mirror_rate_allow(mirror_rate_t *rate, uint32_t now_ms)
+{
+    if (!rate->bytes_per_s) {
+        return true;
+    }
+    rate->tokens += (int64_t)(now_ms - rate->last) * rate->bytes_per_s / 1000;
+    rate->last = now_ms;
+    if (rate->tokens > rate->burst) {
+        rate->tokens = rate->burst;
+    }
+    return rate->tokens > 0;
+}
+
+bool mirror_init(mirror_t *mirror, uint16_t *cur, uint16_t *sent, uint16_t width, uint16_t height,
+                 uint8_t flags, uint32_t bytes_per_s, uint32_t now_ms)
+{
+    memset(mirror, 0, sizeof(*mirror));
+    if (width > MIRROR_MAX_WIDTH) {
+        return false;
+    }
+    mirror->cur = cur;
+    mirror->sent = sent;
+    mirror->width = width;
+    mirror->height = height;
+    mirror->flags = flags & MIRROR_FLAG_SWAPPED;
+    mirror->rate.bytes_per_s = bytes_per_s;
+    mirror->rate.burst = bytes_per_s;
+    mirror->rate.tokens = bytes_per_s;
+    mirror->rate.last = now_ms;
+    memset(cur, 0, (size_t)width * height * sizeof(uint16_t));
+    mirror_request_key(mirror);
+    return true;
+}
+
+static bool mirror_rect_touch(const mirror_rect_t *a, const mirror_rect_t *b)
+{
+    return a->x <= b->x + b->w && b->x <= a->x + a->w && a->y <= b->y + b->h && b->y <= a->y + a->h;
+}
+
+static mirror_rect_t mirror_rect_union(const mirror_rect_t *a, const mirror_rect_t *b)
+{
+    uint16_t x1 = a->x < b->x ? a->x : b->x;
+    uint16_t y1 = a->y < b->y ? a->y : b->y;
+    int x2 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y2 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+    return (mirror_rect_t) { x1, y1, (uint16_t)(x2 - x1), (uint16_t)(y2 - y1) };
+}
+
+static uint32_t mirror_rect_area(const mirror_rect_t *rect)
+{
+    return (uint32_t)rect->w * rect->h;
+}
+
+void mirror_region_add(mirror_region_t *region, mirror_rect_t rect)
+{
+    if (rect.w == 0 || rect.h == 0) {
+        return;
+    }
+    /* The merged rectangle can touch more of the others */
+    for (int i = 0; i < region->cnt;) {
+        if (mirror_rect_touch(&region->rects[i], &rect)) {
+            rect = mirror_rect_union(&region->rects[i], &rect);
+            region->rects[i] = region->rects[--region->cnt];
+            i = 0;
+        } else {
+            ++i;
+        }
+    }
+    if (region->cnt < MIRROR_MAX_RECTS) {
+        region->rects[region->cnt++] = rect;
+        return;
+    }
+    /* Full: merged with the rectangle growing the least */
+    int best = 0;
+    uint32_t best_growth = UINT32_MAX;
+    for (int i = 0; i < region->cnt; ++i) {
+        mirror_rect_t merged = mirror_rect_union(&region->rects[i], &rect);
+        uint32_t growth = mirror_rect_area(&merged) - mirror_rect_area(&region->rects[i]);
+        if (growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
+    }
+    rect = mirror_rect_union(&region->rects[best], &rect);
+    region->rects[best] = region->rects[--region->cnt];
+    mirror_region_add(region, rect);
+}
+
+void mirror_capture(mirror_t *mirror, mirror_rect_t rect, const uint16_t *pixels)
+{
+    if (rect.x >= mirror->width || rect.y >= mirror->height) {
+        return;
+    }
+    uint16_t w = rect.w < mirror->width - rect.x ? rect.w : (uint16_t)(mirror->width - rect.x);
+    uint16_t h = rect.h < mirror->height - rect.y ? rect.h : (uint16_t)(mirror->height - rect.y);
+    for (uint16_t row = 0; row < h; ++row) {
+        memcpy(&mirror->cur[(size_t)(rect.y + row) * mirror->width + rect.x], &pixels[(size_t)row * rect.w],
+               (size_t)w * sizeof(uint16_t));
+    }
+    mirror_region_add(&mirror->dirty, (mirror_rect_t) { rect.x, rect.y, w, h });
+    mirror->stat.capture_cnt++;
+}
+
+void mirror_request_key(mirror_t *mirror)
+{
+    mirror->key = true;
+    mirror->dirty.cnt = 0;
+    mirror_region_add(&mirror->dirty, (mirror_rect_t) { 0, 0, mirror->width, mirror->height });
+}
+
+bool mirror_take(mirror_t *mirror, uint32_t now_ms, mirror_region_t *region, bool *key)
+{
+    if (mirror->dirty.cnt == 0) {
+        return false;
+    }
+    if (!mirror_rate_allow(&mirror->rate, now_ms)) {
+        mirror->stat.skipped_cnt++;
+        return false;
+    }
+    *region = mirror->dirty;
+    *key = mirror->key;
+    mirror->dirty.cnt = 0;
+    mirror->key = false;
+    return true;
+}
+
+void mirror_untake(mirror_t *mirror, const mirror_region_t *region, bool key)
+{
+    for (int i = 0; i < region->cnt; ++i) {
+        mirror_region_add(&mirror->dirty, region->rects[i]);
+    }
+    mirror->key |= key;
+}
+
+/* XOR a row with the sent one, which takes its value, and run length encode it */
+static size_t mirror_encode_row(const uint16_t *cur, uint16_t *sent, uint16_t w, uint8_t *out)
+{
+    uint16_t delta[MIRROR_MAX_WIDTH];
+    for (uint16_t i = 0; i < w; ++i) {
+        /* Read once, it can change meanwhile */
+        uint16_t pixel = cur[i];
+        delta[i] = pixel ^ sent[i];
+        sent[i] = pixel;
+    }
+    size_t len = 0;
+    uint16_t i = 0;
+    while (i < w) {
+        uint16_t run = 1;
+        while (i + run < w && run < 128 && delta[i + run] == delta[i]) {
+            ++run;
+        }
+        if (run >= 2) {
+            out[len++] = (uint8_t)(0x80 | (run - 1));
+            mirror_put_u16(&out[len], delta[i]);
+            len += 2;
+            i += run;
+            continue;
+        }
+        /* Literals up to the next run */
+        uint16_t start = i;
+        uint16_t cnt = 0;
+        do {
+            ++i;
+            ++cnt;
+        } while (i < w && cnt < 128 && !(i + 1 < w && delta[i + 1] == delta[i]));
+        out[len++] = (uint8_t)(cnt - 1);
+        for (uint16_t j = start; j < i; ++j) {
+            mirror_put_u16(&out[len], delta[j]);
+            len += 2;
+        }
+    }
+    return len;
+}
+
+size_t mirror_encode(mirror_t *mirror, mirror_region_t *region, bool *key, uint8_t *out, size_t size)
+{
+    if (*key) {
+        memset(mirror->sent, 0, (size_t)mirror->width * mirror->height * sizeof(uint16_t));
+    }
+    size_t len = 0;
+    size_t last_packet = SIZE_MAX;
+    int done = 0;
+    for (; done < region->cnt; ++done) {
+        mirror_rect_t *rect = &region->rects[done];
+        size_t row_max = MIRROR_ROW_MAX_SIZE(rect->w);
+        while (rect->h > 0 && size - len >= MIRROR_HEADER_SIZE + row_max) {
+            uint8_t *header = &out[len];
+            size_t data = len + MIRROR_HEADER_SIZE;
+            uint16_t y = rect->y;
+            while (rect->h > 0 && size - data >= row_max) {
+                size_t offset = (size_t)rect->y * mirror->width + rect->x;
+                data += mirror_encode_row(&mirror->cur[offset], &mirror->sent[offset], rect->w, &out[data]);
+                rect->y++;
+                rect->h--;
+            }
+            uint16_t rows = (uint16_t)(rect->y - y);
+            header[0] = MIRROR_MAGIC;
+            header[1] = mirror->flags | (*key ? MIRROR_FLAG_KEY : 0);
+            mirror_put_u16(&header[2], mirror->seq);
+            mirror_put_u16(&header[4], rect->x);
+            mirror_put_u16(&header[6], y);
+            mirror_put_u16(&header[8], rect->w);
+            mirror_put_u16(&header[10], rows);
+            uint32_t data_len = (uint32_t)(data - len - MIRROR_HEADER_SIZE);
+            mirror_put_u16(&header[12], (uint16_t)data_len);
+            mirror_put_u16(&header[14], (uint16_t)(data_len >> 16));
+            mirror->stat.raw_bytes += (uint32_t)rows * rect->w * sizeof(uint16_t);
+            *key = false;
+            last_packet = len;
+            len = data;
+        }
+        if (rect->h > 0) {
+            break;
+        }
+    }
+    /* Keep the rectangles not sent */
+    memmove(&region->rects[0], &region->rects[done], (size_t)(region->cnt - done) * sizeof(region->rects[0]));
+    region->cnt = (uint8_t)(region->cnt - done);
+
+    if (last_packet == SIZE_MAX) {
+        return 0;
+    }
+    if (region->cnt == 0) {
+        out[last_packet + 1] |= MIRROR_FLAG_FRAME_END;
+        mirror->seq++;
+        mirror->stat.frame_cnt++;
+    }
+    mirror->stat.sent_bytes += (uint32_t)len;
+    if (mirror->rate.bytes_per_s) {
+        mirror->rate.tokens -= (int64_t)len;
+    }
+    return len;
+}
+
+long mirror_decode(const uint8_t *data, size_t len, uint16_t *screen, uint16_t width, uint16_t height,
+                   mirror_packet_t *packet)
+{
+    if (len < MIRROR_HEADER_SIZE) {
+        return 0;
+    }
+    if (data[0] != MIRROR_MAGIC) {
+        return -1;
+    }
+    mirror_packet_t p = {
+        .flags = data[1],
+        .seq = mirror_get_u16(&data[2]),
+        .rect = { mirror_get_u16(&data[4]), mirror_get_u16(&data[6]),
+                  mirror_get_u16(&data[8]), mirror_get_u16(&data[10]) },
+    };
+    uint32_t data_len = mirror_get_u16(&data[12]) | (uint32_t)mirror_get_u16(&data[14]) << 16;
+    if (p.rect.x + p.rect.w > width || p.rect.y + p.rect.h > height ||
+        data_len > MIRROR_ROW_MAX_SIZE(p.rect.w) * p.rect.h) {
+        return -1;
+    }
+    if (len - MIRROR_HEADER_SIZE < data_len) {
+        return 0;
+    }
+
+    if (p.flags & MIRROR_FLAG_KEY) {
+        memset(screen, 0, (size_t)width * height * sizeof(uint16_t));
+    }
+    const uint8_t *in = &data[MIRROR_HEADER_SIZE];
+    const uint8_t *end = in + data_len;
+    for (uint16_t row = 0; row < p.rect.h; ++row) {
+        uint16_t *pixels = &screen[(size_t)(p.rect.y + row) * width + p.rect.x];
+        uint16_t i = 0;
+        while (i < p.rect.w) {
+            if (in == end) {
+                return -1;
+            }
+            uint8_t c = *in++;
+            uint16_t cnt = (uint16_t)((c & 0x7f) + 1);
+            size_t need = c & 0x80 ? 2 : (size_t)cnt * 2;
+            if (cnt > p.rect.w - i || (size_t)(end - in) < need) {
+                return -1;
+            }
+            for (uint16_t j = 0; j < cnt; ++j, ++i) {
+                pixels[i] ^= mirror_get_u16(c & 0x80 ? in : &in[j * 2]);
+            }
+            in += need;
+        }
+    }
+    if (in != end) {
+        return -1;
+    }
+    *packet = p;
+    return (long)(MIRROR_HEADER_SIZE + data_len);
+}
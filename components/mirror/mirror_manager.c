@@ -0,0 +1,219 @@
+#include "mirror_manager.h"
+
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+/* The encoder keeps a row on the stack */
+#define MIRROR_MANAGER_TASK_STACK       (4096 + MIRROR_MAX_WIDTH * 2)
+/* Below the UI task: a late frame is merged into the next one */
+#define MIRROR_MANAGER_TASK_PRIORITY    1
+
+static const char *TAG = "mirror";
+
+typedef struct {
+    bool initialized;
+    bool running;                   /* Buffers allocated, set with `lock` taken */
+    bool want_running;              /* Applied by the task, which allocates and frees */
+    SemaphoreHandle_t lock;         /* Taken while capturing and taking the dirty areas */
+    TaskHandle_t task;
+    mirror_manager_config_t config;
+    mirror_t mirror;
+    uint8_t *msg;
+    mirror_manager_stat_t stat;
+} mirror_manager_ctx_t;
+
+static mirror_manager_ctx_t s_mirror;
+
+static uint32_t mirror_manager_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void mirror_manager_free(void)
+{
+    xSemaphoreTake(s_mirror.lock, portMAX_DELAY);
+    __atomic_store_n(&s_mirror.running, false, __ATOMIC_RELAXED);
+    xSemaphoreGive(s_mirror.lock);
+    heap_caps_free(s_mirror.mirror.cur);
+    heap_caps_free(s_mirror.mirror.sent);
+    heap_caps_free(s_mirror.msg);
+    s_mirror.mirror.cur = NULL;
+    s_mirror.mirror.sent = NULL;
+    s_mirror.msg = NULL;
+}
+
+static void mirror_manager_alloc(void)
+{
+    size_t size = (size_t)s_mirror.config.width * s_mirror.config.height * sizeof(uint16_t);
+    uint16_t *cur = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint16_t *sent = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    /* Encoded from internal RAM if there is some */
+    uint8_t *msg = heap_caps_malloc(s_mirror.config.max_msg_len, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!msg) {
+        msg = heap_caps_malloc(s_mirror.config.max_msg_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!cur || !sent || !msg) {
+        ESP_LOGW(TAG, "No memory for mirroring");
+        heap_caps_free(cur);
+        heap_caps_free(sent);
+        heap_caps_free(msg);
+        __atomic_store_n(&s_mirror.want_running, false, __ATOMIC_RELAXED);
+        return;
+    }
+    xSemaphoreTake(s_mirror.lock, portMAX_DELAY);
+    mirror_init(&s_mirror.mirror, cur, sent, s_mirror.config.width, s_mirror.config.height,
+                s_mirror.config.flags, s_mirror.config.bytes_per_s, mirror_manager_now_ms());
+    s_mirror.msg = msg;
+    __atomic_store_n(&s_mirror.running, true, __ATOMIC_RELAXED);
+    xSemaphoreGive(s_mirror.lock);
+}
+
+/* Send a message of the dirty areas, if the bandwidth allows */
+static void mirror_manager_send_frame(void)
+{
+    mirror_region_t region;
+    bool key;
+    xSemaphoreTake(s_mirror.lock, portMAX_DELAY);
+    bool taken = mirror_take(&s_mirror.mirror, mirror_manager_now_ms(), &region, &key);
+    xSemaphoreGive(s_mirror.lock);
+    if (!taken) {
+        return;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    size_t len = mirror_encode(&s_mirror.mirror, &region, &key, s_mirror.msg, s_mirror.config.max_msg_len);
+    uint32_t encode_us = (uint32_t)(esp_timer_get_time() - start_us);
+    if (encode_us > s_mirror.stat.encode_us_max) {
+        s_mirror.stat.encode_us_max = encode_us;
+    }
+
+    bool sent = len > 0 && s_mirror.config.send_cb(s_mirror.msg, len, s_mirror.config.send_ctx);
+    xSemaphoreTake(s_mirror.lock, portMAX_DELAY);
+    mirror_untake(&s_mirror.mirror, &region, key);
+    /* The viewer missed a part: start over */
+    if (len > 0 && !sent) {
+        s_mirror.stat.send_fail_cnt++;
+        mirror_request_key(&s_mirror.mirror);
+    }
+    xSemaphoreGive(s_mirror.lock);
+}
+
+static void mirror_manager_task(void *arg)
+{
+    (void)arg;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(s_mirror.config.frame_ms));
+        bool want_running = __atomic_load_n(&s_mirror.want_running, __ATOMIC_RELAXED);
+        if (want_running && !s_mirror.running) {
+            mirror_manager_alloc();
+        } else if (!want_running && s_mirror.running) {
+            mirror_manager_free();
+        }
+        if (s_mirror.running) {
+            mirror_manager_send_frame();
+        }
+    }
+}
+
+esp_err_t mirror_manager_init(const mirror_manager_config_t *config)
+{
+    if (s_mirror.initialized) {
+        return ESP_OK;
+    }
+    if (!config || !config->send_cb || config->width == 0 || config->width > MIRROR_MAX_WIDTH ||
+        config->height == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_mirror.config = *config;
+    if (!s_mirror.config.bytes_per_s) {
+        s_mirror.config.bytes_per_s = MIRROR_MANAGER_DEFAULT_BYTES_PER_S;
+    }
+    if (!s_mirror.config.max_msg_len) {
+        s_mirror.config.max_msg_len = MIRROR_MANAGER_DEFAULT_MSG_LEN;
+    }
+    if (!s_mirror.config.frame_ms) {
+        s_mirror.config.frame_ms = MIRROR_MANAGER_DEFAULT_FRAME_MS;
+    }
+    if (s_mirror.config.max_msg_len < MIRROR_HEADER_SIZE + MIRROR_ROW_MAX_SIZE(config->width)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_mirror.lock = xSemaphoreCreateMutex();
+    if (!s_mirror.lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(mirror_manager_task, "mirror", MIRROR_MANAGER_TASK_STACK, NULL,
+                    MIRROR_MANAGER_TASK_PRIORITY, &s_mirror.task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_mirror.initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t mirror_manager_start(void)
+{
+    if (!s_mirror.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    __atomic_store_n(&s_mirror.want_running, true, __ATOMIC_RELAXED);
+    xTaskNotifyGive(s_mirror.task);
+    return ESP_OK;
+}
+
+void mirror_manager_stop(void)
+{
+    if (!s_mirror.initialized) {
+        return;
+    }
+    __atomic_store_n(&s_mirror.want_running, false, __ATOMIC_RELAXED);
+    xTaskNotifyGive(s_mirror.task);
+}
+
+void mirror_manager_request_key(void)
+{
+    if (!__atomic_load_n(&s_mirror.running, __ATOMIC_RELAXED)) {
+        return;
+    }
+    xSemaphoreTake(s_mirror.lock, portMAX_DELAY);
+    if (s_mirror.running) {
+        mirror_request_key(&s_mirror.mirror);
+    }
+    xSemaphoreGive(s_mirror.lock);
+}
+
+void mirror_manager_capture(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels)
+{
+    if (!__atomic_load_n(&s_mirror.running, __ATOMIC_RELAXED)) {
+        return;
+    }
+    int64_t start_us = esp_timer_get_time();
+    xSemaphoreTake(s_mirror.lock, portMAX_DELAY);
+    if (s_mirror.running) {
+        mirror_capture(&s_mirror.mirror, (mirror_rect_t) { x, y, w, h }, pixels);
+    }
+    xSemaphoreGive(s_mirror.lock);
+    uint32_t capture_us = (uint32_t)(esp_timer_get_time() - start_us);
+    if (capture_us > s_mirror.stat.capture_us_max) {
+        s_mirror.stat.capture_us_max = capture_us;
+    }
+}
+
+void mirror_manager_get_stat(mirror_manager_stat_t *stat)
+{
+    if (!stat) {
+        return;
+    }
+    if (!s_mirror.initialized) {
+        memset(stat, 0, sizeof(*stat));
+        return;
+    }
+    xSemaphoreTake(s_mirror.lock, portMAX_DELAY);
+    *stat = s_mirror.stat;
+    stat->mirror = s_mirror.mirror.stat;
+    xSemaphoreGive(s_mirror.lock);
+}
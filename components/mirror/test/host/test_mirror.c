@@ -0,0 +1,402 @@
+/* Mirror stream round trip through a viewer, with small messages, key frames and lost messages, and its cost */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mirror.h"
+
+#define W               466
+#define H               466
+#define MIN_MSG_LEN     (MIRROR_HEADER_SIZE + MIRROR_ROW_MAX_SIZE(W))
+#define MAX_MSG_LEN     (512 * 1024)  /* A key frame of noise */
+#define BENCH_FRAMES    50
+/* Generous for a host, the firmware's budget is a few ns per pixel */
+#define MAX_NS_PER_PIXEL 50
+
+static uint16_t cur[W * H];
+static uint16_t sent[W * H];
+static uint16_t lcd[W * H];         /* What the panel shows */
+static uint16_t pixels[W * H];
+static uint8_t msg[MAX_MSG_LEN];
+static uint32_t seed = 1;
+
+/* The viewer: reads the stream in pieces of any length, as from a socket */
+static struct {
+    uint16_t screen[W * H];
+    uint8_t buf[MAX_MSG_LEN];
+    size_t len;
+    uint16_t seq;
+    bool synced;                /* Has seen a key frame since the last loss */
+    uint32_t frame_cnt;
+    uint32_t key_cnt;
+} viewer;
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) | (seed << 16);
+}
+
+static void viewer_reset(void)
+{
+    memset(&viewer, 0, sizeof(viewer));
+    /* Whatever was on the screen before */
+    memset(viewer.screen, 0xab, sizeof(viewer.screen));
+}
+
+static void viewer_feed(const uint8_t *data, size_t len)
+{
+    assert(viewer.len + len <= sizeof(viewer.buf));
+    memcpy(&viewer.buf[viewer.len], data, len);
+    viewer.len += len;
+    size_t offset = 0;
+    long packet_len;
+    mirror_packet_t packet;
+    while ((packet_len = mirror_decode(&viewer.buf[offset], viewer.len - offset, viewer.screen, W, H, &packet)) > 0) {
+        offset += (size_t)packet_len;
+        if (packet.flags & MIRROR_FLAG_KEY) {
+            viewer.synced = true;
+            viewer.key_cnt++;
+        } else if (viewer.synced) {
+            /* The packets of a frame share its number, the next frame has the next one */
+            assert(packet.seq == viewer.seq);
+        }
+        viewer.seq = packet.seq;
+        if (packet.flags & MIRROR_FLAG_FRAME_END) {
+            viewer.frame_cnt++;
+            viewer.seq++;
+            /* A frame shows the screen as it was encoded */
+            if (viewer.synced) {
+                assert(memcmp(viewer.screen, sent, sizeof(sent)) == 0);
+            }
+        }
+    }
+    assert(packet_len == 0);
+    memmove(viewer.buf, &viewer.buf[offset], viewer.len - offset);
+    viewer.len -= offset;
+}
+
+/* Flush an area to the panel and capture it, like the display driver */
+static void draw(mirror_t *mirror, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    uint32_t kind = rnd() % 4;
+    uint16_t color = (uint16_t)rnd();
+    for (uint32_t row = 0; row < h; ++row) {
+        for (uint32_t col = 0; col < w; ++col) {
+            uint16_t value;
+            switch (kind) {
+            case 0:
+                value = (uint16_t)rnd();
+                break;
+            case 1:
+                value = color;
+                break;
+            case 2:
+                /* Gradient */
+                value = (uint16_t)((x + col) / 7 * 31 + (y + row) / 5);
+                break;
+            default:
+                /* Text on a background */
+                value = rnd() % 10 == 0 ? 0xffff : color;
+                break;
+            }
+            pixels[row * w + col] = value;
+            if (x + col < W && y + row < H) {
+                lcd[(y + row) * W + x + col] = value;
+            }
+        }
+    }
+    mirror_capture(mirror, (mirror_rect_t) { x, y, w, h }, pixels);
+}
+
+/* One run of the mirror task: a message of at most `msg_len`, lost if `lost` */
+static bool send_frame(mirror_t *mirror, uint32_t now, size_t msg_len, bool lost)
+{
+    mirror_region_t region;
+    bool key;
+    if (!mirror_take(mirror, now, &region, &key)) {
+        return false;
+    }
+    size_t len = mirror_encode(mirror, &region, &key, msg, msg_len);
+    assert(len > 0 && len <= msg_len);
+    mirror_untake(mirror, &region, key);
+    if (lost) {
+        viewer.synced = false;
+        viewer.len = 0;
+        mirror_request_key(mirror);
+        return true;
+    }
+    /* Cut into random pieces on the way */
+    for (size_t offset = 0; offset < len;) {
+        size_t piece = 1 + rnd() % (len - offset);
+        viewer_feed(&msg[offset], piece);
+        offset += piece;
+    }
+    return true;
+}
+
+static void drain(mirror_t *mirror, size_t msg_len)
+{
+    for (int i = 0; i < 10000 && mirror->dirty.cnt; ++i) {
+        send_frame(mirror, UINT32_MAX / 2, msg_len, false);
+    }
+    assert(mirror->dirty.cnt == 0);
+}
+
+static void test_region(void)
+{
+    mirror_region_t region = { 0 };
+    mirror_region_add(&region, (mirror_rect_t) { 0, 0, 10, 10 });
+    mirror_region_add(&region, (mirror_rect_t) { 10, 0, 10, 10 });
+    assert(region.cnt == 1 && region.rects[0].w == 20 && region.rects[0].h == 10);
+    mirror_region_add(&region, (mirror_rect_t) { 5, 5, 0, 10 });
+    assert(region.cnt == 1);
+
+    /* Random rectangles: never more than the maximum, and every one covered */
+    for (int round = 0; round < 1000; ++round) {
+        region.cnt = 0;
+        mirror_rect_t added[32];
+        for (int i = 0; i < 32; ++i) {
+            added[i] = (mirror_rect_t) { (uint16_t)(rnd() % W), (uint16_t)(rnd() % H),
+                                         (uint16_t)(1 + rnd() % 60), (uint16_t)(1 + rnd() % 60) };
+            mirror_region_add(&region, added[i]);
+            assert(region.cnt <= MIRROR_MAX_RECTS);
+        }
+        for (int i = 0; i < 32; ++i) {
+            bool covered = false;
+            for (int r = 0; r < region.cnt && !covered; ++r) {
+                const mirror_rect_t *rect = &region.rects[r];
+                covered = added[i].x >= rect->x && added[i].y >= rect->y &&
+                          added[i].x + added[i].w <= rect->x + rect->w && added[i].y + added[i].h <= rect->y + rect->h;
+            }
+            assert(covered);
+        }
+        /* Apart: no two touch */
+        for (int a = 0; a < region.cnt; ++a) {
+            for (int b = a + 1; b < region.cnt; ++b) {
+                const mirror_rect_t *ra = &region.rects[a];
+                const mirror_rect_t *rb = &region.rects[b];
+                assert(ra->x > rb->x + rb->w || rb->x > ra->x + ra->w || ra->y > rb->y + rb->h || rb->y > ra->y + ra->h);
+            }
+        }
+    }
+}
+
+/* Random dirty rectangles sent in small messages, key frames, lost messages: the viewer ends with `cur` */
+static void test_round_trip(void)
+{
+    mirror_t mirror;
+    assert(!mirror_init(&mirror, cur, sent, MIRROR_MAX_WIDTH + 1, 10, 0, 0, 0));
+    assert(mirror_init(&mirror, cur, sent, W, H, MIRROR_FLAG_SWAPPED, 0, 0));
+    memset(lcd, 0, sizeof(lcd));
+    viewer_reset();
+    uint32_t lost_cnt = 0;
+    uint32_t partial_cnt = 0;
+
+    for (uint32_t round = 0; round < 3000; ++round) {
+        /* Some areas over the edge, clipped */
+        for (uint32_t n = rnd() % 4; n > 0; --n) {
+            draw(&mirror, (uint16_t)(rnd() % W), (uint16_t)(rnd() % H),
+                 (uint16_t)(1 + rnd() % W), (uint16_t)(1 + rnd() % 80));
+        }
+        if (rnd() % 100 == 0) {
+            /* A viewer joining */
+            mirror_request_key(&mirror);
+        }
+        size_t msg_len = rnd() % 2 ? MIN_MSG_LEN + rnd() % 4096 : sizeof(msg);
+        bool lost = rnd() % 200 == 0;
+        uint16_t seq = mirror.seq;
+        if (send_frame(&mirror, round, msg_len, lost)) {
+            lost_cnt += lost;
+            partial_cnt += mirror.seq == seq;
+        }
+        assert(memcmp(cur, lcd, sizeof(cur)) == 0);
+    }
+    drain(&mirror, MIN_MSG_LEN);
+    assert(viewer.synced && viewer.len == 0);
+    assert(memcmp(viewer.screen, cur, sizeof(cur)) == 0);
+    assert(memcmp(sent, cur, sizeof(cur)) == 0);
+    printf("%u frames, %u keys, %u partial messages, %u lost, %u%% of the raw size\n",
+           (unsigned)mirror.stat.frame_cnt, (unsigned)viewer.key_cnt, (unsigned)partial_cnt, (unsigned)lost_cnt,
+           (unsigned)((uint64_t)mirror.stat.sent_bytes * 100 / mirror.stat.raw_bytes));
+    assert(partial_cnt > 0 && lost_cnt > 0 && viewer.key_cnt > lost_cnt);
+}
+
+/* Worst case rows fit MIRROR_ROW_MAX_SIZE, and a message too small for a row gives nothing */
+static void test_row_max_size(void)
+{
+    static uint16_t row_cur[W];
+    static uint16_t row_sent[W];
+    for (int t = 0; t < 3000; ++t) {
+        uint16_t w = (uint16_t)(1 + rnd() % W);
+        mirror_t mirror;
+        assert(mirror_init(&mirror, row_cur, row_sent, w, 1, 0, 0, 0));
+        for (uint16_t i = 0; i < w; ++i) {
+            switch (t % 3) {
+            case 0:
+                row_cur[i] = (uint16_t)rnd();
+                break;
+            case 1:
+                /* Runs of 2 between literals */
+                row_cur[i] = i % 3 == 0 ? (uint16_t)rnd() : 7;
+                break;
+            default:
+                row_cur[i] = (uint16_t)(rnd() % 2);
+                break;
+            }
+        }
+        mirror_region_t region;
+        bool key;
+        assert(mirror_take(&mirror, 0, &region, &key));
+        assert(mirror_encode(&mirror, &region, &key, msg, MIRROR_HEADER_SIZE + MIRROR_ROW_MAX_SIZE(w) - 1) == 0);
+        assert(region.cnt == 1 && key);
+        size_t len = mirror_encode(&mirror, &region, &key, msg, MIRROR_HEADER_SIZE + MIRROR_ROW_MAX_SIZE(w));
+        assert(len > 0 && region.cnt == 0 && !key);
+
+        static uint16_t screen[W];
+        mirror_packet_t packet;
+        assert(mirror_decode(msg, len, screen, w, 1, &packet) == (long)len);
+        assert(memcmp(screen, row_cur, (size_t)w * sizeof(uint16_t)) == 0);
+        assert(packet.flags == (MIRROR_FLAG_KEY | MIRROR_FLAG_FRAME_END));
+    }
+}
+
+/* Broken packets never write outside the screen or read past the data (ASan) */
+static void test_decode_corrupt(void)
+{
+    static uint16_t screen[W * H];
+    mirror_t mirror;
+    assert(mirror_init(&mirror, cur, sent, W, H, 0, 0, 0));
+    memset(lcd, 0, sizeof(lcd));
+    draw(&mirror, 10, 10, 200, 20);
+    mirror_region_t region;
+    bool key;
+    assert(mirror_take(&mirror, 0, &region, &key));
+    size_t len = mirror_encode(&mirror, &region, &key, msg, sizeof(msg));
+    mirror_untake(&mirror, &region, key);
+
+    uint32_t invalid_cnt = 0;
+    for (int t = 0; t < 20000; ++t) {
+        size_t packet_len = rnd() % 3 ? len : rnd() % 64;
+        uint8_t *copy = malloc(packet_len ? packet_len : 1);
+        assert(copy);
+        memcpy(copy, msg, packet_len < len ? packet_len : len);
+        for (size_t i = len; i < packet_len; ++i) {
+            copy[i] = (uint8_t)rnd();
+        }
+        for (uint32_t flip = 1 + rnd() % 4; flip > 0 && packet_len; --flip) {
+            copy[rnd() % packet_len] ^= (uint8_t)(1 << (rnd() % 8));
+        }
+        mirror_packet_t packet;
+        long r = mirror_decode(copy, packet_len, screen, W, H, &packet);
+        assert(r >= -1 && r <= (long)packet_len);
+        invalid_cnt += r < 0;
+        free(copy);
+    }
+    assert(invalid_cnt > 0);
+}
+
+static double elapsed_ns(clock_t start)
+{
+    return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC;
+}
+
+/* The encoding work follows the dirty area, not the screen */
+static void test_cost(void)
+{
+    mirror_t mirror;
+    assert(mirror_init(&mirror, cur, sent, W, H, 0, 0, 0));
+    memset(lcd, 0, sizeof(lcd));
+    viewer_reset();
+    drain(&mirror, sizeof(msg));
+
+    /* A label updated every frame: exactly its pixels, unchanged ones for a few bytes */
+    uint32_t raw_bytes = mirror.stat.raw_bytes;
+    uint32_t sent_bytes = mirror.stat.sent_bytes;
+    for (int i = 0; i < 100; ++i) {
+        for (uint16_t p = 0; p < 120 * 40; ++p) {
+            pixels[p] = 0x18c3;
+        }
+        mirror_capture(&mirror, (mirror_rect_t) { 100, 200, 120, 40 }, pixels);
+        assert(send_frame(&mirror, 0, sizeof(msg), false));
+    }
+    assert(mirror.stat.raw_bytes - raw_bytes == 100 * 120 * 40 * 2);
+    /* The first frame changes every pixel to one color, then nothing changes: one run per row */
+    assert(mirror.stat.sent_bytes - sent_bytes <= 100 * (MIRROR_HEADER_SIZE + 40 * 3));
+
+    /* Full screen frames of UI-like content */
+    for (size_t p = 0; p < W * 116; ++p) {
+        pixels[p] = p % 97 < 10 ? (uint16_t)(p * 2654435761u >> 16) : 0x18c3;
+    }
+    clock_t start = clock();
+    for (int frame = 0; frame < BENCH_FRAMES; ++frame) {
+        for (uint16_t band = 0; band < 4; ++band) {
+            pixels[frame] ^= 1;
+            mirror_capture(&mirror, (mirror_rect_t) { 0, (uint16_t)(band * 116), W, 116 }, pixels);
+        }
+    }
+    double capture_ns = elapsed_ns(start) / BENCH_FRAMES;
+
+    start = clock();
+    size_t bytes = 0;
+    for (int frame = 0; frame < BENCH_FRAMES; ++frame) {
+        for (uint16_t band = 0; band < 4; ++band) {
+            mirror_capture(&mirror, (mirror_rect_t) { 0, (uint16_t)(band * 116), W, 116 }, pixels);
+        }
+        if (frame % 2) {
+            mirror_request_key(&mirror);
+        }
+        mirror_region_t region;
+        bool key;
+        assert(mirror_take(&mirror, 0, &region, &key));
+        bytes += mirror_encode(&mirror, &region, &key, msg, sizeof(msg));
+        assert(region.cnt == 0);
+    }
+    double encode_ns = elapsed_ns(start) / BENCH_FRAMES - capture_ns;
+    double screen_pixels = (double)W * 464;
+    printf("full screen: capture %.0f us, encode %.0f us (%.1f ns per pixel), %.1f%% of the raw size\n",
+           capture_ns / 1000, encode_ns / 1000, encode_ns / screen_pixels,
+           100.0 * (double)bytes / BENCH_FRAMES / (screen_pixels * 2));
+    assert(capture_ns / screen_pixels < MAX_NS_PER_PIXEL && encode_ns / screen_pixels < MAX_NS_PER_PIXEL);
+}
+
+static void test_rate_limit(void)
+{
+    mirror_t mirror;
+    assert(mirror_init(&mirror, cur, sent, W, H, 0, 10000, 0));
+    memset(lcd, 0, sizeof(lcd));
+    mirror_region_t region;
+    bool key;
+
+    /* The key frame uses the burst and more, later frames wait for the budget and are merged */
+    for (size_t p = 0; p < W * H; ++p) {
+        cur[p] = (uint16_t)rnd();
+    }
+    assert(mirror_take(&mirror, 0, &region, &key));
+    size_t len = mirror_encode(&mirror, &region, &key, msg, sizeof(msg));
+    assert(len > 10000 && region.cnt == 0);
+    draw(&mirror, 0, 0, 10, 10);
+    draw(&mirror, 5, 5, 10, 10);
+    uint32_t debt_ms = (uint32_t)((len - 10000) * 1000 / 10000);
+    assert(!mirror_take(&mirror, debt_ms, &region, &key));
+    assert(mirror.stat.skipped_cnt == 1 && mirror.dirty.cnt == 1);
+    assert(mirror_take(&mirror, debt_ms + 1, &region, &key) && !key);
+    assert(region.cnt == 1 && region.rects[0].w == 15 && region.rects[0].h == 15);
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    RUN(test_region);
+    RUN(test_round_trip);
+    RUN(test_row_max_size);
+    RUN(test_decode_corrupt);
+    RUN(test_cost);
+    RUN(test_rate_limit);
+    return 0;
+}
@@ -4,6 +4,10 @@
 #include <stddef.h>
 
 #include "esp_err.h"
+#include "mqtt_outbox.h"
+#include "mqtt_pub_sched.h"
+#include "mqtt_reasm.h"
+#include "mqtt_router.h"
 #include "wifi_manager.h"
 
 #ifdef __cplusplus
@@ -11,27 +15,105 @@ extern "C" {
 #endif
 
 #define MQTT_MANAGER_MAX_TOPIC_LEN   128
-#define MQTT_MANAGER_MAX_PAYLOAD_LEN 256
 
-typedef void (*mqtt_manager_message_cb_t)(const char *topic,
-                                          const char *payload,
-                                          void *ctx);
+/* Gets views into the received message, valid only during the call */
+typedef mqtt_router_cb_t mqtt_manager_message_cb_t;
+/* Gets the parts of the message as they arrive, see mqtt_router_stream_cb_t */
+typedef mqtt_router_stream_cb_t mqtt_manager_stream_cb_t;
+typedef mqtt_router_chunk_t mqtt_manager_chunk_t;
+
+typedef mqtt_pub_sched_stat_t mqtt_manager_publish_stat_t;
+typedef mqtt_outbox_stat_t mqtt_manager_outbox_stat_t;
+typedef mqtt_reasm_stat_t mqtt_manager_receive_stat_t;
+
+typedef struct {
+    uint32_t connect_cnt;
+    uint32_t session_present_cnt;   /**< Connections resuming the MQTT session, so nothing was subscribed */
+    uint32_t tls_ticket_cnt;        /**< TLS handshakes resuming the previous session's ticket */
+    uint32_t last_handshake_ms;     /**< TCP connect and TLS handshake of the last connection */
+    uint32_t last_reconnect_ms;     /**< From losing the connection or Wi-Fi to the next connection */
+    uint32_t max_reconnect_ms;
+    uint32_t last_first_msg_ms;     /**< From losing the connection or Wi-Fi to the first message after it */
+    uint32_t last_rtt_ms;           /**< From publishing the last measured QoS1 message to its PUBACK */
+} mqtt_manager_connect_stat_t;
+
+/* Topic of a button, returned by mqtt_manager_add_button_topic(). 0 is no topic. */
+typedef int mqtt_manager_button_t;
 
 typedef void (*mqtt_manager_status_cb_t)(bool connected, void *ctx);
+typedef void (*mqtt_manager_rtt_cb_t)(uint32_t rtt_ms, void *ctx);
 
 typedef struct {
     char broker_uri[MQTT_MANAGER_MAX_TOPIC_LEN];
-    char temperature_sub_topic[MQTT_MANAGER_MAX_TOPIC_LEN];
     char button_pub_topic_prefix[MQTT_MANAGER_MAX_TOPIC_LEN];
 } mqtt_manager_config_t;
 
 esp_err_t mqtt_manager_init(const mqtt_manager_config_t *config,
-                            mqtt_manager_message_cb_t message_cb,
-                            void *message_ctx,
                             mqtt_manager_status_cb_t status_cb,
                             void *status_ctx);
 
-esp_err_t mqtt_manager_publish_button_event(const char *button_id, const char *state);
+/*
+ * Call `message_cb` for the messages whose topic matches `filter`. `filter` can
+ * have `+` and `#` wildcards. Can be called before mqtt_manager_init(). The filter
+ * is subscribed on every connection with the QoS of its first route.
+ * The handlers run in the MQTT task.
+ */
+esp_err_t mqtt_manager_subscribe(const char *filter,
+                                 int qos,
+                                 mqtt_manager_message_cb_t message_cb,
+                                 void *message_ctx);
+
+/*
+ * Call `stream_cb` with the parts of the messages whose topic matches `filter`,
+ * as the client receives them. Meant for messages longer than the client's
+ * buffer (e.g. images) going straight into a consumer: nothing is copied. The
+ * message handlers get such messages only after they were put together in PSRAM,
+ * up to 128 kB.
+ */
+esp_err_t mqtt_manager_subscribe_stream(const char *filter,
+                                        int qos,
+                                        mqtt_manager_stream_cb_t stream_cb,
+                                        void *stream_ctx);
+
+/*
+ * Add the topic of `button_id` and set `button` to the handle to publish its
+ * events with. The topic is built here once. Events are published at most once
+ * every `min_interval_ms` (0: no limit); events coming faster are coalesced, the
+ * last one is published when the interval ends. Call after mqtt_manager_init(),
+ * once for every button.
+ */
+esp_err_t mqtt_manager_add_button_topic(const char *button_id, uint32_t min_interval_ms,
+                                        mqtt_manager_button_t *button);
+
+/*
+ * Publish an event. While the broker is not reachable the events wait in the
+ * outbox and are sent on the next connection. If the outbox is full the
+ * oldest waiting event is dropped. Doesn't wait for the network.
+ */
+esp_err_t mqtt_manager_publish_button_event(mqtt_manager_button_t button, const char *state);
+
+/*
+ * Publish a message right away, e.g. diagnostics. Unlike the button events it
+ * isn't kept in the outbox: while the broker is not reachable
+ * ESP_ERR_INVALID_STATE is returned and the message is lost. Waits for the
+ * network, so don't call it from the UI task.
+ */
+esp_err_t mqtt_manager_publish(const char *topic, const void *data, size_t len, int qos);
+
+/*
+ * Call `rtt_cb` with the time from publishing a QoS1 message (a button event
+ * or mqtt_manager_publish()) to its PUBACK. Runs in the MQTT task.
+ */
+void mqtt_manager_set_rtt_cb(mqtt_manager_rtt_cb_t rtt_cb, void *rtt_ctx);
+
+void mqtt_manager_get_publish_stat(mqtt_manager_publish_stat_t *stat);
+
+/* Latencies are in ms */
+void mqtt_manager_get_outbox_stat(mqtt_manager_outbox_stat_t *stat);
+
+void mqtt_manager_get_connect_stat(mqtt_manager_connect_stat_t *stat);
+
+void mqtt_manager_get_receive_stat(mqtt_manager_receive_stat_t *stat);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Outbox keeping the messages published while the broker is not reachable.
+ * Messages wait in a RAM ring and, if a storage (e.g. a flash partition) is
+ * set, the ones not fitting into the ring are written there. On connection
+ * they are sent in order, keeping at most MQTT_OUTBOX_WINDOW QoS1 messages
+ * in flight; every PUBACK sends the next one. Messages whose PUBACK doesn't
+ * come are sent again.
+ * Sending is split in mqtt_outbox_take() and mqtt_outbox_sent(), so the caller
+ * can release its lock while the client sends the message over the network.
+ * Writing the storage is split likewise: mqtt_outbox_add() only queues the
+ * message in RAM, and the sector erases and writes are done by
+ * mqtt_outbox_spill_write() without the lock.
+ * Plain C without ESP-IDF dependencies: the time is passed by the caller, so
+ * it can be run on the host against a broker stand-in.
+ */
+
+/** Messages in the RAM ring */
+#ifndef MQTT_OUTBOX_LEN
+#define MQTT_OUTBOX_LEN             32
+#endif
+
+/** QoS1 messages sent but not acknowledged yet */
+#ifndef MQTT_OUTBOX_WINDOW
+#define MQTT_OUTBOX_WINDOW          4
+#endif
+
+#ifndef MQTT_OUTBOX_MAX_PAYLOAD_LEN
+#define MQTT_OUTBOX_MAX_PAYLOAD_LEN 32
+#endif
+
+/** Messages added but not written to the storage yet. If writing falls behind, the oldest waiting message that makes space is dropped. */
+#ifndef MQTT_OUTBOX_SPILL_LEN
+#define MQTT_OUTBOX_SPILL_LEN       8
+#endif
+
+/** Bytes of a message in the storage. `size` and `sector_size` of the storage have to be its multiple. */
+#define MQTT_OUTBOX_RECORD_SIZE     64
+
+/** Returned by mqtt_outbox_check_timeouts() if no message is in flight */
+#define MQTT_OUTBOX_IDLE            UINT32_MAX
+
+/**
+ * Storage written like a flash: a sector has to be erased before it's written again.
+ * The functions return whether they succeeded.
+ */
+typedef struct {
+    bool (*read)(void *ctx, uint32_t offset, void *buf, size_t len);
+    bool (*write)(void *ctx, uint32_t offset, const void *buf, size_t len);
+    bool (*erase)(void *ctx, uint32_t offset, uint32_t len);
+    void *ctx;
+    uint32_t size;
+    uint32_t sector_size;
+} mqtt_outbox_storage_t;
+
+typedef struct {
+    uint32_t queued_cnt;        /**< Messages waiting to be sent now, in RAM and in the storage */
+    uint32_t in_flight_cnt;     /**< Messages sent and waiting for their acknowledgment */
+    uint32_t spilled_cnt;       /**< Messages waiting in the storage now, or to be written there */
+    uint32_t delivered_cnt;     /**< Messages acknowledged by the broker */
+    uint32_t compacted_cnt;     /**< Messages replaced by a newer value of the same topic */
+    uint32_t dropped_cnt;       /**< Messages dropped because the outbox was full */
+    uint32_t resent_cnt;        /**< Messages sent again because their acknowledgment didn't come */
+    uint32_t latency_avg;       /**< Average time from adding a message to its acknowledgment */
+    uint32_t latency_max;
+} mqtt_outbox_stat_t;
+
+typedef struct {
+    uint32_t add_time;
+    uint16_t topic;
+    uint8_t compact;            /*!< Only the latest waiting value of the topic is kept */
+    uint8_t payload_len;
+    char payload[MQTT_OUTBOX_MAX_PAYLOAD_LEN];
+} mqtt_outbox_msg_t;
+
+typedef struct {
+    mqtt_outbox_msg_t msg;
+    int msg_id;
+    uint32_t send_time;         /*!< When the message went in flight */
+    uint8_t state;
+} mqtt_outbox_entry_t;
+
+/** A message to write to the storage, see mqtt_outbox_spill_take() */
+typedef struct {
+    mqtt_outbox_msg_t msg;
+    uint32_t offset;
+    bool erase;                 /*!< The sector starting at `offset` has to be erased first */
+} mqtt_outbox_spill_t;
+
+typedef struct {
+    mqtt_outbox_entry_t entries[MQTT_OUTBOX_LEN];
+    uint16_t head;              /*!< Oldest entry */
+    uint16_t cnt;
+    uint16_t sent_cnt;          /*!< Entries from `head` which are being sent, in flight or acknowledged */
+    bool sending;               /*!< A message is taken and mqtt_outbox_sent() wasn't called yet */
+    int early_ack;              /*!< Acknowledgment arrived before the id of the message being sent, 0: none */
+
+    mqtt_outbox_storage_t storage;
+    uint32_t storage_read;      /*!< Offset of the oldest message in the storage */
+    uint32_t storage_write;
+    uint32_t storage_cnt;
+    mqtt_outbox_msg_t spill[MQTT_OUTBOX_SPILL_LEN];  /*!< Newer than the messages in the storage */
+    uint16_t spill_head;
+    uint16_t spill_cnt;
+    bool spilling;              /*!< The oldest of `spill` is being written */
+    bool spill_moved;           /*!< The message being written was moved to RAM meanwhile */
+
+    mqtt_outbox_stat_t stat;
+    uint64_t latency_sum;
+} mqtt_outbox_t;
+
+/**
+ * @brief Set up an empty outbox.
+ */
+void mqtt_outbox_init(mqtt_outbox_t *outbox);
+
+/**
+ * @brief Write the messages not fitting into the RAM ring to `storage`.
+ *
+ * Messages already in the storage are not read back: it is used as if it were empty.
+ * Its sectors are erased when they are first written.
+ *
+ * @return Whether the storage can be used. It must be set while the outbox is empty.
+ */
+bool mqtt_outbox_set_storage(mqtt_outbox_t *outbox, const mqtt_outbox_storage_t *storage);
+
+/**
+ * @brief Add a message to be sent.
+ *
+ * If the outbox is full the oldest waiting message is dropped. Doesn't access the
+ * storage: the messages for it are written by mqtt_outbox_spill_write().
+ *
+ * @param compact Replace the waiting message of the same topic if any.
+ *                Done only while the storage is empty, to keep the order of the values.
+ * @return Whether the message was added.
+ */
+bool mqtt_outbox_add(mqtt_outbox_t *outbox, int topic, const char *payload, size_t payload_len,
+                     bool compact, uint32_t now);
+
+/**
+ * @brief Take the oldest message to write to the storage.
+ *
+ * mqtt_outbox_spill_done() has to be called with the result of
+ * mqtt_outbox_spill_write() before the next one can be taken.
+ *
+ * @return Whether a message was taken.
+ */
+bool mqtt_outbox_spill_take(mqtt_outbox_t *outbox, mqtt_outbox_spill_t *spill);
+
+/**
+ * @brief Erase the sector if needed and write the message taken by mqtt_outbox_spill_take().
+ *
+ * Only reads the storage set by mqtt_outbox_set_storage(), so it can be called
+ * without the lock of the outbox while it is used.
+ *
+ * @return Whether the message was written.
+ */
+bool mqtt_outbox_spill_write(const mqtt_outbox_t *outbox, const mqtt_outbox_spill_t *spill);
+
+/**
+ * @brief Record the result of mqtt_outbox_spill_write(). A message not written is dropped.
+ */
+void mqtt_outbox_spill_done(mqtt_outbox_t *outbox, bool ok);
+
+/**
+ * @brief Take the next message to send if there is space in the in-flight window.
+ *
+ * The message stays in the outbox; mqtt_outbox_sent() has to be called with the
+ * result of sending it before the next one can be taken.
+ *
+ * @param msg Set to the copy of the message.
+ * @return Whether a message was taken.
+ */
+bool mqtt_outbox_take(mqtt_outbox_t *outbox, mqtt_outbox_msg_t *msg);
+
+/**
+ * @brief Record the result of sending the message taken by mqtt_outbox_take().
+ *
+ * @param msg_id Id of the message whose acknowledgment is waited for, 0 if the message
+ *               needs no acknowledgment (QoS0), or -1 if the client refused it, so it's
+ *               taken again later.
+ */
+void mqtt_outbox_sent(mqtt_outbox_t *outbox, int msg_id, uint32_t now);
+
+/**
+ * @brief Handle the acknowledgment of a message.
+ *
+ * @return Whether the message is in the outbox. Acknowledgments of messages published
+ *         without the outbox are ignored.
+ */
+bool mqtt_outbox_ack(mqtt_outbox_t *outbox, int msg_id, uint32_t now);
+
+/**
+ * @brief The client dropped a message in flight: send it again.
+ *
+ * @return Whether the message is in the outbox.
+ */
+bool mqtt_outbox_resend(mqtt_outbox_t *outbox, int msg_id);
+
+/**
+ * @brief Send again the messages in flight for at least `timeout`.
+ *
+ * @return Time until the next message in flight times out, 0 if messages are waiting
+ *         to be sent again now, or MQTT_OUTBOX_IDLE if no message is in flight.
+ */
+uint32_t mqtt_outbox_check_timeouts(mqtt_outbox_t *outbox, uint32_t now, uint32_t timeout);
+
+/**
+ * @brief The connection is lost: send the messages in flight again.
+ *
+ * Must not be called between mqtt_outbox_take() and mqtt_outbox_sent().
+ */
+void mqtt_outbox_reset_in_flight(mqtt_outbox_t *outbox);
+
+void mqtt_outbox_get_stat(const mqtt_outbox_t *outbox, mqtt_outbox_stat_t *stat);
+
+/**
+ * @brief Whether there are messages waiting or in flight.
+ */
+static inline bool mqtt_outbox_is_empty(const mqtt_outbox_t *outbox)
+{
+    return outbox->cnt == 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Publish scheduler limiting how often each topic is published.
+ * A value published within the topic's interval after the previous one waits,
+ * and a newer value replaces the waiting one ("last value wins"). The waiting
+ * value is published when the interval ends (trailing edge), so the last
+ * value is always published.
+ * Plain C without ESP-IDF dependencies: the time is passed by the caller and
+ * the messages go to a send callback, so it can be run on the host against
+ * a broker stand-in.
+ */
+
+#ifndef MQTT_PUB_SCHED_MAX_TOPICS
+#define MQTT_PUB_SCHED_MAX_TOPICS       24
+#endif
+
+#ifndef MQTT_PUB_SCHED_MAX_PAYLOAD_LEN
+#define MQTT_PUB_SCHED_MAX_PAYLOAD_LEN  32
+#endif
+
+/** Bytes for the topic strings, including their terminating 0 */
+#ifndef MQTT_PUB_SCHED_TOPIC_POOL_SIZE
+#define MQTT_PUB_SCHED_TOPIC_POOL_SIZE  1024
+#endif
+
+/** Returned by mqtt_pub_sched_flush() if no value is waiting */
+#define MQTT_PUB_SCHED_IDLE             UINT32_MAX
+
+/**
+ * @brief Publish a message.
+ *
+ * @param topic Index of the topic, see mqtt_pub_sched_get_topic().
+ * @return Whether the message was accepted by the client.
+ */
+typedef bool (*mqtt_pub_sched_send_cb_t)(int topic, const char *payload, size_t payload_len, void *ctx);
+
+typedef struct {
+    uint32_t sent_cnt;          /**< Messages accepted by the send callback */
+    uint32_t coalesced_cnt;     /**< Values replaced by a newer value before being sent */
+    uint32_t dropped_cnt;       /**< Values too long or refused by the send callback */
+} mqtt_pub_sched_stat_t;
+
+typedef struct {
+    uint16_t topic_off;         /*!< Start of the 0 terminated topic in `topic_pool` */
+    uint32_t min_interval;      /*!< Minimum time between two publishes */
+    uint32_t last_send;         /*!< Time of the last publish */
+    uint8_t qos;
+    uint8_t pending : 1;        /*!< `payload` waits for the interval to end */
+    uint8_t sent : 1;           /*!< Published at least once, so `last_send` is valid */
+    uint8_t payload_len;
+    char payload[MQTT_PUB_SCHED_MAX_PAYLOAD_LEN];
+} mqtt_pub_sched_topic_t;
+
+typedef struct {
+    mqtt_pub_sched_topic_t topics[MQTT_PUB_SCHED_MAX_TOPICS];
+    char topic_pool[MQTT_PUB_SCHED_TOPIC_POOL_SIZE];
+    uint16_t topic_cnt;
+    uint16_t topic_pool_used;
+    mqtt_pub_sched_send_cb_t send_cb;
+    void *send_ctx;
+    mqtt_pub_sched_stat_t stat;
+} mqtt_pub_sched_t;
+
+/**
+ * @brief Set up a scheduler without topics.
+ */
+void mqtt_pub_sched_init(mqtt_pub_sched_t *sched, mqtt_pub_sched_send_cb_t send_cb, void *send_ctx);
+
+/**
+ * @brief Add the topic `<prefix>/<name>`, or only `<name>` if `prefix` is NULL or empty.
+ *
+ * The topic is built once here and published by its index, so publishing needs
+ * no formatting and no lookup.
+ *
+ * @param min_interval Minimum time between two publishes, 0: no limit.
+ * @return Index of the topic or -1 if there is no space for it.
+ */
+int mqtt_pub_sched_add_topic(mqtt_pub_sched_t *sched, const char *prefix, const char *name,
+                             uint8_t qos, uint32_t min_interval);
+
+/**
+ * @brief Publish a value now, or when the topic's interval ends.
+ *
+ * @return Whether the value was sent or is waiting to be sent.
+ */
+bool mqtt_pub_sched_publish(mqtt_pub_sched_t *sched, int topic, const char *payload, size_t payload_len,
+                            uint32_t now);
+
+/**
+ * @brief Publish the waiting values whose interval ended.
+ *
+ * @return Time until the next waiting value is due or MQTT_PUB_SCHED_IDLE.
+ */
+uint32_t mqtt_pub_sched_flush(mqtt_pub_sched_t *sched, uint32_t now);
+
+/**
+ * @brief The 0 terminated topic.
+ */
+static inline const char *mqtt_pub_sched_get_topic(const mqtt_pub_sched_t *sched, int topic)
+{
+    return &sched->topic_pool[sched->topics[topic].topic_off];
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mqtt_router.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Reassembly of the messages the MQTT client receives in fragments.
+ * A message longer than the client's receive buffer comes as several data
+ * events: the first one has the topic, and every one has its offset in the
+ * message and the message's total length. The fragments of a message are
+ * copied into one buffer, which is kept for the next messages and grows up
+ * to the longest message allowed. Unfragmented messages aren't copied.
+ * Plain C without ESP-IDF dependencies: the buffer comes from an allocator
+ * callback, so it can be run on the host with fragments from a broker stand-in.
+ */
+
+/** Longer topics are dropped with their messages */
+#ifndef MQTT_REASM_MAX_TOPIC_LEN
+#define MQTT_REASM_MAX_TOPIC_LEN    128
+#endif
+
+typedef void *(*mqtt_reasm_alloc_cb_t)(size_t size, void *ctx);
+typedef void (*mqtt_reasm_free_cb_t)(void *ptr, void *ctx);
+
+typedef struct {
+    const char *topic;          /*!< Only with the first fragment */
+    size_t topic_len;
+    const char *data;
+    size_t data_len;
+    size_t offset;              /*!< Of `data` in the message */
+    size_t total_len;
+} mqtt_reasm_fragment_t;
+
+typedef enum {
+    MQTT_REASM_PARTIAL = 0,     /*!< More fragments to come */
+    MQTT_REASM_COMPLETE,        /*!< The payload holds the whole message */
+    MQTT_REASM_SKIPPED,         /*!< Not kept: not asked for, too long, no memory or a fragment missing */
+} mqtt_reasm_state_t;
+
+typedef struct {
+    uint32_t msg_cnt;           /**< Messages received, fragmented or not */
+    uint32_t reassembled_cnt;   /**< Fragmented messages put together */
+    uint32_t too_long_cnt;      /**< Fragmented messages over the length limit */
+    uint32_t no_mem_cnt;        /**< Fragmented messages without a buffer */
+    uint32_t broken_cnt;        /**< Messages with a missing or misplaced fragment */
+    uint32_t buf_size;          /**< Size of the kept buffer */
+} mqtt_reasm_stat_t;
+
+typedef struct {
+    size_t max_len;             /*!< Longer fragmented messages aren't kept */
+    mqtt_reasm_alloc_cb_t alloc_cb;
+    mqtt_reasm_free_cb_t free_cb;
+    void *alloc_ctx;
+    char *buf;
+    size_t buf_size;
+    char topic[MQTT_REASM_MAX_TOPIC_LEN];
+    size_t topic_len;
+    size_t total_len;
+    size_t received;            /*!< Message bytes received so far */
+    bool active;                /*!< Between the first and the last fragment of a message */
+    bool keep;                  /*!< The fragments are copied into `buf` */
+    mqtt_reasm_stat_t stat;
+} mqtt_reasm_t;
+
+void mqtt_reasm_init(mqtt_reasm_t *reasm, size_t max_len,
+                     mqtt_reasm_alloc_cb_t alloc_cb, mqtt_reasm_free_cb_t free_cb, void *alloc_ctx);
+
+/**
+ * @brief Free the buffer.
+ */
+void mqtt_reasm_deinit(mqtt_reasm_t *reasm);
+
+/**
+ * @brief Take a fragment.
+ *
+ * @param keep    Whether to put the message together, only checked with the first fragment.
+ *                Otherwise the fragments only go to `topic` for streaming.
+ * @param topic   Set to the topic of the message, or to an empty view if the fragment
+ *                doesn't belong to a message (e.g. its first fragment was lost).
+ * @param payload Set to the whole message if MQTT_REASM_COMPLETE is returned.
+ *                It points into the fragment if the message came in one piece.
+ */
+mqtt_reasm_state_t mqtt_reasm_feed(mqtt_reasm_t *reasm, const mqtt_reasm_fragment_t *frag, bool keep,
+                                   mqtt_router_view_t *topic, mqtt_router_view_t *payload);
+
+/**
+ * @brief Whether a fragment starts a message. Needs the topic to tell which routes want it.
+ */
+static inline bool mqtt_reasm_is_first(const mqtt_reasm_fragment_t *frag)
+{
+    return frag->offset == 0;
+}
+
+/**
+ * @brief Whether a fragment holds the whole message.
+ */
+static inline bool mqtt_reasm_is_whole(const mqtt_reasm_fragment_t *frag)
+{
+    return frag->offset == 0 && frag->data_len == frag->total_len;
+}
+
+#ifdef __cplusplus
+}
+#endif
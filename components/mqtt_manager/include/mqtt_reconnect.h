@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Reconnection policy of mqtt_manager: the delay between the attempts, and
+ * the TLS session of the last connection offered on the next handshake.
+ * Plain C without ESP-IDF dependencies: the random value is passed by the
+ * caller and the sessions are opaque, so it can be run on the host.
+ */
+
+/** Delay of the first attempt, doubled on every failed one */
+#ifndef MQTT_RECONNECT_BACKOFF_MIN_MS
+#define MQTT_RECONNECT_BACKOFF_MIN_MS   500
+#endif
+
+#ifndef MQTT_RECONNECT_BACKOFF_MAX_MS
+#define MQTT_RECONNECT_BACKOFF_MAX_MS   60000
+#endif
+
+typedef void (*mqtt_reconnect_free_cb_t)(void *session, void *ctx);
+
+typedef struct {
+    void *session;              /*!< Of the last handshake, NULL if none */
+    bool offered;               /*!< `session` was offered in the handshake in progress */
+    mqtt_reconnect_free_cb_t free_cb;
+    void *free_ctx;
+} mqtt_reconnect_session_t;
+
+/**
+ * @brief Delay before an attempt to reconnect.
+ *
+ * Half of it is random, so the devices don't reconnect at once after a broker restart.
+ *
+ * @param attempt Failed attempts since the last connection.
+ * @param rnd Random value.
+ */
+uint32_t mqtt_reconnect_backoff_ms(uint32_t attempt, uint32_t rnd);
+
+/**
+ * @brief Set up a cache without a session.
+ *
+ * @param free_cb Frees the sessions replaced or forgotten.
+ */
+void mqtt_reconnect_session_init(mqtt_reconnect_session_t *cache, mqtt_reconnect_free_cb_t free_cb,
+                                 void *free_ctx);
+
+/**
+ * @brief The session to offer in a new handshake, or NULL.
+ */
+void *mqtt_reconnect_session_offer(mqtt_reconnect_session_t *cache);
+
+/**
+ * @brief The handshake failed: the session isn't offered again, as the broker may have refused it.
+ */
+void mqtt_reconnect_session_failed(mqtt_reconnect_session_t *cache);
+
+/**
+ * @brief The handshake succeeded: keep its session for the next one.
+ *
+ * @param session Session of the new connection, may be NULL.
+ * @return Whether the previous session was offered in the handshake.
+ */
+bool mqtt_reconnect_session_done(mqtt_reconnect_session_t *cache, void *session);
+
+/**
+ * @brief Free the session.
+ */
+void mqtt_reconnect_session_clear(mqtt_reconnect_session_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
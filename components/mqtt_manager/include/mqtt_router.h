@@ -0,0 +1,164 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Topic trie dispatching MQTT messages to the handlers of matching topic filters.
+ * Plain C without ESP-IDF dependencies, so the wildcard matching can be built and
+ * checked on the host.
+ *
+ * Every level of a filter is a node. Literal children are found in a hash table
+ * keyed by (parent, level), so a topic is dispatched in O(topic depth) steps plus
+ * one extra branch for every matching `+` level. Nothing is allocated: the nodes,
+ * routes and filter strings live in fixed arrays of the router.
+ */
+
+#ifndef MQTT_ROUTER_MAX_ROUTES
+#define MQTT_ROUTER_MAX_ROUTES     48
+#endif
+
+#ifndef MQTT_ROUTER_MAX_NODES
+#define MQTT_ROUTER_MAX_NODES      128
+#endif
+
+/** Bytes for the filter strings of all routes, including their terminating 0 */
+#ifndef MQTT_ROUTER_FILTER_POOL_SIZE
+#define MQTT_ROUTER_FILTER_POOL_SIZE 2048
+#endif
+
+#define MQTT_ROUTER_NONE           UINT16_MAX
+
+/** A part of a buffer. It is not 0 terminated. */
+typedef struct {
+    const char *ptr;
+    size_t len;
+} mqtt_router_view_t;
+
+/**
+ * @brief Called with the topic and payload of a message matching the route's filter.
+ *
+ * The views point into the received message and are valid only during the call.
+ */
+typedef void (*mqtt_router_cb_t)(mqtt_router_view_t topic, mqtt_router_view_t payload, void *ctx);
+
+/** A part of a message received in fragments */
+typedef struct {
+    mqtt_router_view_t data;
+    size_t offset;          /*!< Of `data` in the message, 0 starts a new message */
+    size_t total_len;       /*!< Length of the whole message */
+} mqtt_router_chunk_t;
+
+/**
+ * @brief Called with every part of a message matching a stream route's filter, in order.
+ *
+ * The message is complete when `offset + data.len == total_len`. Blocking here
+ * holds back the client's receiving, which slows the broker down.
+ */
+typedef void (*mqtt_router_stream_cb_t)(mqtt_router_view_t topic, const mqtt_router_chunk_t *chunk, void *ctx);
+
+typedef struct {
+    uint32_t hash;          /*!< Hash of the level and the parent node */
+    uint16_t parent;
+    uint16_t level_off;     /*!< Start of the level's name in `filter_pool` */
+    uint16_t level_len;
+    uint16_t plus;          /*!< `+` child node */
+    uint16_t routes;        /*!< First route whose filter ends here */
+    uint16_t hash_routes;   /*!< First route whose filter ends here with a `#` level */
+} mqtt_router_node_t;
+
+typedef struct {
+    union {
+        mqtt_router_cb_t cb;
+        mqtt_router_stream_cb_t stream_cb;
+    };
+    void *ctx;
+    uint16_t filter_off;    /*!< Start of the 0 terminated filter in `filter_pool` */
+    uint16_t next;          /*!< Next route with the same filter */
+    uint8_t qos;
+    uint8_t first : 1;      /*!< First route with this filter, i.e. the one to subscribe */
+    uint8_t stream : 1;     /*!< Gets the parts of the messages with `stream_cb` */
+} mqtt_router_route_t;
+
+typedef struct {
+    mqtt_router_node_t nodes[MQTT_ROUTER_MAX_NODES];
+    uint16_t children[MQTT_ROUTER_MAX_NODES * 2];   /*!< Hash table of the literal child nodes */
+    mqtt_router_route_t routes[MQTT_ROUTER_MAX_ROUTES];
+    char filter_pool[MQTT_ROUTER_FILTER_POOL_SIZE];
+    uint16_t node_cnt;
+    uint16_t route_cnt;
+    uint16_t filter_pool_used;
+} mqtt_router_t;
+
+/**
+ * @brief Set up an empty router.
+ */
+void mqtt_router_init(mqtt_router_t *router);
+
+/**
+ * @brief Whether `filter` is a valid MQTT topic filter.
+ *
+ * `+` and `#` have to take a whole level and `#` can be only the last level.
+ */
+bool mqtt_router_filter_is_valid(const char *filter);
+
+/**
+ * @brief Call `cb` for the messages whose topic matches `filter`.
+ *
+ * More routes can have the same or overlapping filters; all of the matching
+ * ones are called.
+ *
+ * @return Index of the route or -1 if the filter is invalid or the router is full.
+ */
+int mqtt_router_add(mqtt_router_t *router, const char *filter, uint8_t qos,
+                    mqtt_router_cb_t cb, void *ctx);
+
+/**
+ * @brief Call `stream_cb` with the parts of the messages whose topic matches `filter`.
+ *
+ * @return Index of the route or -1 if the filter is invalid or the router is full.
+ */
+int mqtt_router_add_stream(mqtt_router_t *router, const char *filter, uint8_t qos,
+                           mqtt_router_stream_cb_t stream_cb, void *ctx);
+
+/**
+ * @brief Call the handlers of the routes matching `topic`. Stream routes are skipped.
+ *
+ * Topics starting with `$` don't match filters starting with a wildcard.
+ *
+ * @return Number of handlers called.
+ */
+uint32_t mqtt_router_dispatch(const mqtt_router_t *router,
+                              const char *topic, size_t topic_len,
+                              const char *payload, size_t payload_len);
+
+/**
+ * @brief Call the handlers of the stream routes matching `topic` with a part of a message.
+ *
+ * @return Number of handlers called.
+ */
+uint32_t mqtt_router_dispatch_chunk(const mqtt_router_t *router,
+                                    const char *topic, size_t topic_len,
+                                    const mqtt_router_chunk_t *chunk);
+
+/**
+ * @brief Number of the routes matching `topic`, either the stream routes or the others.
+ */
+uint32_t mqtt_router_count(const mqtt_router_t *router, const char *topic, size_t topic_len, bool stream);
+
+/**
+ * @brief The 0 terminated filter of a route.
+ */
+static inline const char *mqtt_router_get_filter(const mqtt_router_t *router, int route)
+{
+    return &router->filter_pool[router->routes[route].filter_off];
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,8 +4,34 @@
 #include <string.h>
 
 #include "esp_event.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "mqtt_client.h"
+#include "mqtt_reconnect.h"
+#include "mqtt_tls_transport.h"
+#include "sdkconfig.h"
+
+#define MQTT_MANAGER_PUB_TASK_STACK     4096
+#define MQTT_MANAGER_PUB_TASK_PRIORITY  4
+/* Retry sending the outbox if the client refused a message */
+#define MQTT_MANAGER_RETRY_MS           500
+/* Send an outbox message again if its PUBACK didn't come. Longer than the client's
+ * own outbox expiry, which drops the message with MQTT_EVENT_DELETED first. */
+#define MQTT_MANAGER_ACK_TIMEOUT_MS     60000
+/* Optional data partition for the messages not fitting into the RAM outbox */
+#define MQTT_MANAGER_OUTBOX_PARTITION   "mqtt_outbox"
+/* Longest message put together from fragments for the handlers, in PSRAM */
+#define MQTT_MANAGER_MAX_MESSAGE_LEN    (128 * 1024)
+/* QoS1 messages whose round trip is measured at once */
+#define MQTT_MANAGER_RTT_SLOTS          (MQTT_OUTBOX_WINDOW + 4)
+
+_Static_assert(MQTT_ROUTER_MAX_ROUTES <= 64, "The subscribed routes are stored in a 64 bit mask");
 
 static const char *TAG = "mqtt_mgr";
 static const char HIVEMQ_CLOUD_ROOT_CA[] =
@@ -46,51 +72,284 @@ typedef struct {
     bool mqtt_connected;
     esp_mqtt_client_handle_t client;
     mqtt_manager_config_t config;
-    mqtt_manager_message_cb_t message_cb;
-    void *message_ctx;
+    SemaphoreHandle_t router_lock;  /* Recursive, so the handlers can subscribe too */
+    mqtt_router_t router;
+    mqtt_reasm_t reasm;             /* Taken with `router_lock` */
+    /* Taken only while `pub_sched` and `outbox` are changed, never while the client
+     * sends (the MQTT task takes it with the client's lock taken) or the flash is written */
+    SemaphoreHandle_t pub_lock;
+    mqtt_pub_sched_t pub_sched;
+    mqtt_outbox_t outbox;
+    TaskHandle_t pub_task;          /* Sends the messages of `outbox` */
+    volatile uint32_t connect_cnt;
+
+    bool started;
+    bool wifi_up;
+    esp_ip4_addr_t ip;
+    esp_timer_handle_t reconnect_timer;
+    uint32_t reconnect_attempt;
+    uint64_t subscribed;            /* Routes subscribed in the broker's session, kept if it persists */
+    int64_t down_us;                /* When the connection was lost, 0 while connected */
+    bool first_msg_wait;            /* Measuring the time to the first message after a reconnect */
+    mqtt_manager_connect_stat_t connect_stat;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    esp_transport_handle_t transport;
+#endif
     mqtt_manager_status_cb_t status_cb;
     void *status_ctx;
+    portMUX_TYPE rtt_lock;
+    struct {
+        int msg_id;                 /* 0 if free */
+        uint32_t time;
+    } rtt_sent[MQTT_MANAGER_RTT_SLOTS];
+    int rtt_next;
+    mqtt_manager_rtt_cb_t rtt_cb;
+    void *rtt_ctx;
 } mqtt_manager_ctx_t;
 
-static mqtt_manager_ctx_t s_mqtt;
+static mqtt_manager_ctx_t s_mqtt = {
+    .rtt_lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static void mqtt_manager_wake_pub_task(void)
+{
+    if (s_mqtt.pub_task) {
+        xTaskNotifyGive(s_mqtt.pub_task);
+    }
+}
+
+static void *mqtt_manager_reasm_alloc(size_t size, void *ctx)
+{
+    (void)ctx;
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+static void mqtt_manager_reasm_free(void *ptr, void *ctx)
+{
+    (void)ctx;
+    heap_caps_free(ptr);
+}
+
+static bool mqtt_manager_setup_router(void)
+{
+    if (!s_mqtt.router_lock) {
+        s_mqtt.router_lock = xSemaphoreCreateRecursiveMutex();
+        if (!s_mqtt.router_lock) {
+            return false;
+        }
+        mqtt_router_init(&s_mqtt.router);
+        mqtt_reasm_init(&s_mqtt.reasm, MQTT_MANAGER_MAX_MESSAGE_LEN,
+                        mqtt_manager_reasm_alloc, mqtt_manager_reasm_free, NULL);
+    }
+    return true;
+}
+
+/* Subscribe the filters the broker's session doesn't have yet */
+static void mqtt_manager_subscribe_all(esp_mqtt_client_handle_t client, bool session_present)
+{
+    xSemaphoreTakeRecursive(s_mqtt.router_lock, portMAX_DELAY);
+    if (!session_present) {
+        s_mqtt.subscribed = 0;
+    }
+    for (int i = 0; i < s_mqtt.router.route_cnt; ++i) {
+        uint64_t bit = (uint64_t)1 << i;
+        if (s_mqtt.router.routes[i].first && !(s_mqtt.subscribed & bit) &&
+            esp_mqtt_client_subscribe(client,
+                                      mqtt_router_get_filter(&s_mqtt.router, i),
+                                      s_mqtt.router.routes[i].qos) >= 0) {
+            s_mqtt.subscribed |= bit;
+        }
+    }
+    xSemaphoreGiveRecursive(s_mqtt.router_lock);
+}
+
+static void mqtt_manager_reconnect_timer_cb(void *arg)
+{
+    (void)arg;
+    esp_mqtt_client_reconnect(s_mqtt.client);
+}
+
+static void mqtt_manager_schedule_reconnect(void)
+{
+    esp_timer_stop(s_mqtt.reconnect_timer);
+    /* Without IP it would fail anyway. GOT_IP reconnects. */
+    if (!s_mqtt.wifi_up) {
+        return;
+    }
+    uint32_t delay_ms = mqtt_reconnect_backoff_ms(s_mqtt.reconnect_attempt++, esp_random());
+    ESP_LOGI(TAG, "Reconnecting in %u ms", (unsigned)delay_ms);
+    esp_timer_start_once(s_mqtt.reconnect_timer, (uint64_t)delay_ms * 1000);
+}
+
+static void mqtt_manager_connection_lost(void)
+{
+    if (s_mqtt.down_us == 0) {
+        s_mqtt.down_us = esp_timer_get_time();
+    }
+}
+
+static void mqtt_manager_connected(esp_mqtt_event_handle_t event)
+{
+    int64_t now = esp_timer_get_time();
+    mqtt_manager_connect_stat_t *stat = &s_mqtt.connect_stat;
+    stat->connect_cnt++;
+    if (event->session_present) {
+        stat->session_present_cnt++;
+    }
+    if (s_mqtt.down_us) {
+        stat->last_reconnect_ms = (uint32_t)((now - s_mqtt.down_us) / 1000);
+        if (stat->last_reconnect_ms > stat->max_reconnect_ms) {
+            stat->max_reconnect_ms = stat->last_reconnect_ms;
+        }
+        s_mqtt.first_msg_wait = true;
+    }
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    mqtt_tls_transport_stat_t tls_stat;
+    mqtt_tls_transport_get_stat(s_mqtt.transport, &tls_stat);
+    stat->tls_ticket_cnt = tls_stat.ticket_offered_cnt;
+    stat->last_handshake_ms = tls_stat.last_handshake_ms;
+#endif
+    ESP_LOGI(TAG, "Connected in %u ms, session %s", (unsigned)stat->last_reconnect_ms,
+             event->session_present ? "kept" : "new");
+    s_mqtt.reconnect_attempt = 0;
+    esp_timer_stop(s_mqtt.reconnect_timer);
+}
+
+static void mqtt_manager_first_msg(void)
+{
+    if (s_mqtt.first_msg_wait) {
+        s_mqtt.first_msg_wait = false;
+        s_mqtt.connect_stat.last_first_msg_ms = (uint32_t)((esp_timer_get_time() - s_mqtt.down_us) / 1000);
+    }
+    s_mqtt.down_us = 0;
+}
+
+/* Messages longer than the client's buffer come in several events */
+static void mqtt_manager_receive(esp_mqtt_event_handle_t event)
+{
+    mqtt_reasm_fragment_t frag = {
+        .topic = event->topic,
+        .topic_len = event->topic_len > 0 ? (size_t)event->topic_len : 0,
+        .data = event->data,
+        .data_len = event->data_len > 0 ? (size_t)event->data_len : 0,
+        .offset = event->current_data_offset > 0 ? (size_t)event->current_data_offset : 0,
+        .total_len = event->total_data_len > 0 ? (size_t)event->total_data_len : 0,
+    };
+    mqtt_router_view_t topic;
+    mqtt_router_view_t payload;
+
+    xSemaphoreTakeRecursive(s_mqtt.router_lock, portMAX_DELAY);
+    /* Put together only the messages some handler wants whole */
+    bool keep = mqtt_reasm_is_first(&frag) && !mqtt_reasm_is_whole(&frag) && frag.topic &&
+                mqtt_router_count(&s_mqtt.router, frag.topic, frag.topic_len, false) > 0;
+    mqtt_reasm_state_t state = mqtt_reasm_feed(&s_mqtt.reasm, &frag, keep, &topic, &payload);
+    if (topic.ptr) {
+        const mqtt_router_chunk_t chunk = {
+            .data = { frag.data, frag.data_len },
+            .offset = frag.offset,
+            .total_len = frag.total_len,
+        };
+        mqtt_router_dispatch_chunk(&s_mqtt.router, topic.ptr, topic.len, &chunk);
+    }
+    if (state == MQTT_REASM_COMPLETE) {
+        /* The handlers get the payload in the client's buffer, or in the reassembly buffer */
+        mqtt_router_dispatch(&s_mqtt.router, topic.ptr, topic.len, payload.ptr, payload.len);
+    }
+    xSemaphoreGiveRecursive(s_mqtt.router_lock);
+}
+
+static uint32_t mqtt_manager_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* Remember when a QoS1 message was sent to measure the round trip to its PUBACK */
+static void mqtt_manager_rtt_sent(int msg_id)
+{
+    if (msg_id <= 0) {
+        return;
+    }
+    taskENTER_CRITICAL(&s_mqtt.rtt_lock);
+    s_mqtt.rtt_sent[s_mqtt.rtt_next].msg_id = msg_id;
+    s_mqtt.rtt_sent[s_mqtt.rtt_next].time = mqtt_manager_now_ms();
+    s_mqtt.rtt_next = (s_mqtt.rtt_next + 1) % MQTT_MANAGER_RTT_SLOTS;
+    taskEXIT_CRITICAL(&s_mqtt.rtt_lock);
+}
+
+/* A PUBACK arriving before its id was noted (the sender preempted for a whole
+ * round trip) or after the slot was reused isn't measured */
+static void mqtt_manager_rtt_acked(int msg_id)
+{
+    uint32_t now = mqtt_manager_now_ms();
+    bool found = false;
+    uint32_t rtt = 0;
+    taskENTER_CRITICAL(&s_mqtt.rtt_lock);
+    for (int i = 0; i < MQTT_MANAGER_RTT_SLOTS; ++i) {
+        if (s_mqtt.rtt_sent[i].msg_id == msg_id) {
+            rtt = now - s_mqtt.rtt_sent[i].time;
+            s_mqtt.rtt_sent[i].msg_id = 0;
+            found = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_mqtt.rtt_lock);
+    if (!found) {
+        return;
+    }
+    s_mqtt.connect_stat.last_rtt_ms = rtt;
+    if (s_mqtt.rtt_cb) {
+        s_mqtt.rtt_cb(rtt, s_mqtt.rtt_ctx);
+    }
+}
+
+/* A message was acknowledged or dropped by the client */
+static void mqtt_manager_outbox_event(int msg_id, bool acked)
+{
+    xSemaphoreTake(s_mqtt.pub_lock, portMAX_DELAY);
+    bool in_outbox = acked ? mqtt_outbox_ack(&s_mqtt.outbox, msg_id, mqtt_manager_now_ms())
+                           : mqtt_outbox_resend(&s_mqtt.outbox, msg_id);
+    xSemaphoreGive(s_mqtt.pub_lock);
+    /* Space in the in-flight window, or a message to send again */
+    if (in_outbox) {
+        mqtt_manager_wake_pub_task();
+    }
+}
 
 static void mqtt_manager_handle_event(esp_mqtt_event_handle_t event)
 {
     switch (event->event_id) {
     case MQTT_EVENT_CONNECTED:
         s_mqtt.mqtt_connected = true;
-        ESP_LOGI(TAG, "Connected to broker");
-        esp_mqtt_client_subscribe(event->client,
-                                  s_mqtt.config.temperature_sub_topic,
-                                  1);
+        s_mqtt.connect_cnt++;
+        mqtt_manager_connected(event);
+        mqtt_manager_subscribe_all(event->client, event->session_present);
+        mqtt_manager_wake_pub_task();
         if (s_mqtt.status_cb) {
             s_mqtt.status_cb(true, s_mqtt.status_ctx);
         }
         break;
     case MQTT_EVENT_DISCONNECTED:
+        /* Also sent when a connection attempt fails */
         s_mqtt.mqtt_connected = false;
         ESP_LOGW(TAG, "Disconnected from broker");
+        mqtt_manager_connection_lost();
+        mqtt_manager_schedule_reconnect();
         if (s_mqtt.status_cb) {
             s_mqtt.status_cb(false, s_mqtt.status_ctx);
         }
         break;
-    case MQTT_EVENT_DATA: {
-        char topic[MQTT_MANAGER_MAX_TOPIC_LEN] = { 0 };
-        size_t topic_len = (size_t)event->topic_len < sizeof(topic) - 1 ?
-                           (size_t)event->topic_len : sizeof(topic) - 1;
-        memcpy(topic, event->topic, topic_len);
-
-        char payload[MQTT_MANAGER_MAX_PAYLOAD_LEN] = { 0 };
-        size_t payload_len = (size_t)event->data_len < sizeof(payload) - 1 ?
-                             (size_t)event->data_len : sizeof(payload) - 1;
-        memcpy(payload, event->data, payload_len);
-
-        if (strcmp(topic, s_mqtt.config.temperature_sub_topic) == 0 &&
-            s_mqtt.message_cb) {
-            s_mqtt.message_cb(topic, payload, s_mqtt.message_ctx);
-        }
+    case MQTT_EVENT_PUBLISHED:
+        mqtt_manager_rtt_acked(event->msg_id);
+        mqtt_manager_outbox_event(event->msg_id, true);
+        break;
+    case MQTT_EVENT_DELETED:
+        /* Expired in the client's outbox without a PUBACK */
+        mqtt_manager_outbox_event(event->msg_id, false);
+        break;
+    case MQTT_EVENT_DATA:
+        mqtt_manager_first_msg();
+        mqtt_manager_receive(event);
         break;
-    }
     default:
         break;
     }
@@ -106,25 +365,180 @@ static void mqtt_event_handler(void *handler_args,
     mqtt_manager_handle_event((esp_mqtt_event_handle_t)event_data);
 }
 
+static void mqtt_manager_got_ip(const wifi_manager_ip_info_t *info)
+{
+    bool ip_changed = info && info->ip.addr != s_mqtt.ip.addr;
+    if (info) {
+        s_mqtt.ip = info->ip;
+    }
+    s_mqtt.wifi_up = true;
+    s_mqtt.reconnect_attempt = 0;
+
+    if (!s_mqtt.started) {
+        s_mqtt.started = esp_mqtt_client_start(s_mqtt.client) == ESP_OK;
+        return;
+    }
+    if (s_mqtt.mqtt_connected) {
+        /* After a short drop with the same IP the TCP connection is still usable */
+        if (ip_changed) {
+            esp_mqtt_client_disconnect(s_mqtt.client);
+        }
+        return;
+    }
+    esp_timer_stop(s_mqtt.reconnect_timer);
+    esp_mqtt_client_reconnect(s_mqtt.client);
+}
+
 static void wifi_event_forwarder(wifi_manager_event_t event, void *ctx, const void *event_data)
 {
     (void)ctx;
-    (void)event_data;
     if (!s_mqtt.client) {
         return;
     }
+    /* The client isn't stopped on Wi-Fi drops: the TCP connection may survive short ones,
+     * and the TLS and MQTT sessions are resumed otherwise */
     switch (event) {
     case WIFI_MANAGER_EVENT_GOT_IP:
-        esp_mqtt_client_start(s_mqtt.client);
+        mqtt_manager_got_ip(event_data);
         break;
     case WIFI_MANAGER_EVENT_DISCONNECTED:
-        esp_mqtt_client_stop(s_mqtt.client);
+        s_mqtt.wifi_up = false;
+        esp_timer_stop(s_mqtt.reconnect_timer);
+        mqtt_manager_connection_lost();
         break;
     default:
         break;
     }
 }
 
+/* Called by `pub_sched` with `pub_lock` taken */
+static bool mqtt_manager_add_to_outbox(int topic, const char *payload, size_t payload_len, void *ctx)
+{
+    (void)ctx;
+    /* Rate limited topics carry a state, so only their latest value has to be delivered */
+    bool compact = s_mqtt.pub_sched.topics[topic].min_interval > 0;
+    return mqtt_outbox_add(&s_mqtt.outbox, topic, payload, payload_len, compact, mqtt_manager_now_ms());
+}
+
+/* Called by the publish task without `pub_lock`: the client may wait for the network.
+ * The topics are never changed once added. */
+static int mqtt_manager_send(const mqtt_outbox_msg_t *msg)
+{
+    if (!s_mqtt.mqtt_connected) {
+        return -1;
+    }
+    int id = esp_mqtt_client_publish(s_mqtt.client,
+                                     mqtt_pub_sched_get_topic(&s_mqtt.pub_sched, msg->topic),
+                                     msg->payload, msg->payload_len,
+                                     s_mqtt.pub_sched.topics[msg->topic].qos, 0);
+    if (id > 0) {
+        mqtt_manager_rtt_sent(id);
+    }
+    return id;
+}
+
+static void mqtt_manager_pub_task(void *arg)
+{
+    (void)arg;
+    uint32_t connect_cnt = 0;
+    TickType_t wait = portMAX_DELAY;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        xSemaphoreTake(s_mqtt.pub_lock, portMAX_DELAY);
+        /* The messages not acknowledged in the previous connection are sent again */
+        if (connect_cnt != s_mqtt.connect_cnt) {
+            connect_cnt = s_mqtt.connect_cnt;
+            mqtt_outbox_reset_in_flight(&s_mqtt.outbox);
+        }
+        uint32_t wait_ms = mqtt_pub_sched_flush(&s_mqtt.pub_sched, mqtt_manager_now_ms());
+        /* A sector erase takes tens of ms: the publishers don't wait for it */
+        mqtt_outbox_spill_t spill;
+        while (mqtt_outbox_spill_take(&s_mqtt.outbox, &spill)) {
+            xSemaphoreGive(s_mqtt.pub_lock);
+            bool ok = mqtt_outbox_spill_write(&s_mqtt.outbox, &spill);
+            xSemaphoreTake(s_mqtt.pub_lock, portMAX_DELAY);
+            mqtt_outbox_spill_done(&s_mqtt.outbox, ok);
+        }
+        mqtt_outbox_msg_t msg;
+        while (s_mqtt.mqtt_connected && mqtt_outbox_take(&s_mqtt.outbox, &msg)) {
+            xSemaphoreGive(s_mqtt.pub_lock);
+            int msg_id = mqtt_manager_send(&msg);
+            xSemaphoreTake(s_mqtt.pub_lock, portMAX_DELAY);
+            mqtt_outbox_sent(&s_mqtt.outbox, msg_id, mqtt_manager_now_ms());
+            if (msg_id < 0) {
+                if (wait_ms > MQTT_MANAGER_RETRY_MS) {
+                    wait_ms = MQTT_MANAGER_RETRY_MS;
+                }
+                break;
+            }
+        }
+        uint32_t ack_wait_ms = mqtt_outbox_check_timeouts(&s_mqtt.outbox, mqtt_manager_now_ms(),
+                                                          MQTT_MANAGER_ACK_TIMEOUT_MS);
+        xSemaphoreGive(s_mqtt.pub_lock);
+
+        if (ack_wait_ms < wait_ms) {
+            wait_ms = ack_wait_ms;
+        }
+        wait = wait_ms == MQTT_PUB_SCHED_IDLE ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms) + 1;
+    }
+}
+
+static bool mqtt_manager_partition_read(void *ctx, uint32_t offset, void *buf, size_t len)
+{
+    return esp_partition_read(ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool mqtt_manager_partition_write(void *ctx, uint32_t offset, const void *buf, size_t len)
+{
+    return esp_partition_write(ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool mqtt_manager_partition_erase(void *ctx, uint32_t offset, uint32_t len)
+{
+    return esp_partition_erase_range(ctx, offset, len) == ESP_OK;
+}
+
+static void mqtt_manager_setup_outbox_storage(void)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           MQTT_MANAGER_OUTBOX_PARTITION);
+    if (!part) {
+        return;
+    }
+    const mqtt_outbox_storage_t storage = {
+        .read = mqtt_manager_partition_read,
+        .write = mqtt_manager_partition_write,
+        .erase = mqtt_manager_partition_erase,
+        .ctx = (void *)part,
+        .size = part->size,
+        .sector_size = part->erase_size,
+    };
+    if (mqtt_outbox_set_storage(&s_mqtt.outbox, &storage)) {
+        ESP_LOGI(TAG, "Outbox spills to partition %s", part->label);
+    } else {
+        ESP_LOGW(TAG, "Partition %s can't be used for the outbox", part->label);
+    }
+}
+
+static esp_err_t mqtt_manager_setup_publish(void)
+{
+    s_mqtt.pub_lock = xSemaphoreCreateMutex();
+    if (!s_mqtt.pub_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    mqtt_pub_sched_init(&s_mqtt.pub_sched, mqtt_manager_add_to_outbox, NULL);
+    mqtt_outbox_init(&s_mqtt.outbox);
+    mqtt_manager_setup_outbox_storage();
+
+    if (xTaskCreate(mqtt_manager_pub_task, "mqtt_pub", MQTT_MANAGER_PUB_TASK_STACK, NULL,
+                    MQTT_MANAGER_PUB_TASK_PRIORITY, &s_mqtt.pub_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
 static void mqtt_manager_copy_string(char *dest, size_t dest_size, const char *src)
 {
     if (!dest || dest_size == 0 || !src) {
@@ -141,11 +555,6 @@ static void mqtt_manager_apply_default_config(mqtt_manager_config_t *cfg)
                                  sizeof(cfg->broker_uri),
                                  "mqtts://af241302675248c586ce5c30d689ded4.s1.eu.hivemq.cloud:8883");
     }
-    if (!cfg->temperature_sub_topic[0]) {
-        mqtt_manager_copy_string(cfg->temperature_sub_topic,
-                                 sizeof(cfg->temperature_sub_topic),
-                                 "esp32lvgl/temperature");
-    }
     if (!cfg->button_pub_topic_prefix[0]) {
         mqtt_manager_copy_string(cfg->button_pub_topic_prefix,
                                  sizeof(cfg->button_pub_topic_prefix),
@@ -154,14 +563,15 @@ static void mqtt_manager_apply_default_config(mqtt_manager_config_t *cfg)
 }
 
 esp_err_t mqtt_manager_init(const mqtt_manager_config_t *config,
-                            mqtt_manager_message_cb_t message_cb,
-                            void *message_ctx,
                             mqtt_manager_status_cb_t status_cb,
                             void *status_ctx)
 {
     if (s_mqtt.initialized) {
         return ESP_OK;
     }
+    if (!mqtt_manager_setup_router()) {
+        return ESP_ERR_NO_MEM;
+    }
 
     if (config) {
         s_mqtt.config = *config;
@@ -170,29 +580,54 @@ esp_err_t mqtt_manager_init(const mqtt_manager_config_t *config,
     }
     mqtt_manager_apply_default_config(&s_mqtt.config);
 
+    esp_err_t err = mqtt_manager_setup_publish();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = mqtt_manager_reconnect_timer_cb,
+        .name = "mqtt_reconnect",
+    };
+    err = esp_timer_create(&timer_args, &s_mqtt.reconnect_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    /* The broker keeps the subscriptions and the QoS1 messages while disconnected.
+     * The client id has to be the same for it: the default one is made of the MAC. */
     esp_mqtt_client_config_t client_cfg = {
         .broker.address.uri = s_mqtt.config.broker_uri,
-        .broker.verification.certificate = HIVEMQ_CLOUD_ROOT_CA,
         .credentials.username = "audihmi",
         .credentials.authentication.password = "Audi1!!!",
+        .session.disable_clean_session = true,
+        .network.disable_auto_reconnect = true,
     };
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    s_mqtt.transport = mqtt_tls_transport_create(HIVEMQ_CLOUD_ROOT_CA);
+    if (!s_mqtt.transport) {
+        return ESP_ERR_NO_MEM;
+    }
+    client_cfg.network.transport = s_mqtt.transport;
+#else
+    client_cfg.broker.verification.certificate = HIVEMQ_CLOUD_ROOT_CA;
+#endif
     s_mqtt.client = esp_mqtt_client_init(&client_cfg);
     if (!s_mqtt.client) {
         return ESP_FAIL;
     }
+    s_mqtt.down_us = esp_timer_get_time();
 
     esp_mqtt_client_register_event(s_mqtt.client,
                                    ESP_EVENT_ANY_ID,
                                    mqtt_event_handler,
                                    NULL);
 
-    esp_err_t err = wifi_manager_register_event_handler(wifi_event_forwarder, NULL);
+    err = wifi_manager_register_event_handler(wifi_event_forwarder, NULL);
     if (err != ESP_OK) {
         return err;
     }
 
-    s_mqtt.message_cb = message_cb;
-    s_mqtt.message_ctx = message_ctx;
     s_mqtt.status_cb = status_cb;
     s_mqtt.status_ctx = status_ctx;
     s_mqtt.initialized = true;
@@ -200,14 +635,158 @@ esp_err_t mqtt_manager_init(const mqtt_manager_config_t *config,
     return ESP_OK;
 }
 
-esp_err_t mqtt_manager_publish_button_event(const char *button_id, const char *state)
+static esp_err_t mqtt_manager_add_route(const char *filter, int qos,
+                                        mqtt_manager_message_cb_t message_cb,
+                                        mqtt_manager_stream_cb_t stream_cb, void *ctx)
 {
-    if (!s_mqtt.client || !s_mqtt.mqtt_connected || !button_id || !state) {
+    if ((!message_cb && !stream_cb) || !mqtt_router_filter_is_valid(filter) || qos < 0 || qos > 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!mqtt_manager_setup_router()) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTakeRecursive(s_mqtt.router_lock, portMAX_DELAY);
+    int route = message_cb ? mqtt_router_add(&s_mqtt.router, filter, (uint8_t)qos, message_cb, ctx)
+                           : mqtt_router_add_stream(&s_mqtt.router, filter, (uint8_t)qos, stream_cb, ctx);
+    bool subscribe = route >= 0 && s_mqtt.router.routes[route].first;
+    xSemaphoreGiveRecursive(s_mqtt.router_lock);
+    if (route < 0) {
+        ESP_LOGE(TAG, "No space for the route of %s", filter);
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Otherwise it's subscribed on connection.
+     * Not called with the lock taken, as the MQTT task takes it with the client's lock taken. */
+    if (subscribe && s_mqtt.client && s_mqtt.mqtt_connected &&
+        esp_mqtt_client_subscribe(s_mqtt.client, filter, qos) >= 0) {
+        xSemaphoreTakeRecursive(s_mqtt.router_lock, portMAX_DELAY);
+        s_mqtt.subscribed |= (uint64_t)1 << route;
+        xSemaphoreGiveRecursive(s_mqtt.router_lock);
+    }
+    return ESP_OK;
+}
+
+esp_err_t mqtt_manager_subscribe(const char *filter,
+                                 int qos,
+                                 mqtt_manager_message_cb_t message_cb,
+                                 void *message_ctx)
+{
+    return message_cb ? mqtt_manager_add_route(filter, qos, message_cb, NULL, message_ctx) : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t mqtt_manager_subscribe_stream(const char *filter,
+                                        int qos,
+                                        mqtt_manager_stream_cb_t stream_cb,
+                                        void *stream_ctx)
+{
+    return stream_cb ? mqtt_manager_add_route(filter, qos, NULL, stream_cb, stream_ctx) : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t mqtt_manager_add_button_topic(const char *button_id, uint32_t min_interval_ms,
+                                        mqtt_manager_button_t *button)
+{
+    if (!button_id || !button) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_mqtt.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_mqtt.pub_lock, portMAX_DELAY);
+    int topic = mqtt_pub_sched_add_topic(&s_mqtt.pub_sched, s_mqtt.config.button_pub_topic_prefix,
+                                         button_id, 1, min_interval_ms);
+    xSemaphoreGive(s_mqtt.pub_lock);
+    if (topic < 0) {
+        ESP_LOGE(TAG, "No space for the topic of %s", button_id);
+        return ESP_ERR_NO_MEM;
+    }
+    *button = topic + 1;
+    return ESP_OK;
+}
+
+esp_err_t mqtt_manager_publish_button_event(mqtt_manager_button_t button, const char *state)
+{
+    if (!state) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_mqtt.initialized || button <= 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_mqtt.pub_lock, portMAX_DELAY);
+    bool ok = mqtt_pub_sched_publish(&s_mqtt.pub_sched, button - 1, state, strlen(state), mqtt_manager_now_ms());
+    xSemaphoreGive(s_mqtt.pub_lock);
+    /* Sent by the publish task, so the caller doesn't wait for the network */
+    mqtt_manager_wake_pub_task();
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t mqtt_manager_publish(const char *topic, const void *data, size_t len, int qos)
+{
+    if (!topic || (!data && len)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_mqtt.initialized || !s_mqtt.mqtt_connected) {
         return ESP_ERR_INVALID_STATE;
     }
-    char topic[MQTT_MANAGER_MAX_TOPIC_LEN] = { 0 };
-    snprintf(topic, sizeof(topic), "%s/%s", s_mqtt.config.button_pub_topic_prefix, button_id);
-    return (esp_mqtt_client_publish(s_mqtt.client, topic, state, 0, 1, 0) >= 0) ?
-               ESP_OK :
-               ESP_FAIL;
+    int id = esp_mqtt_client_publish(s_mqtt.client, topic, data, (int)len, qos, 0);
+    if (id < 0) {
+        return ESP_FAIL;
+    }
+    mqtt_manager_rtt_sent(id);
+    return ESP_OK;
+}
+
+void mqtt_manager_set_rtt_cb(mqtt_manager_rtt_cb_t rtt_cb, void *rtt_ctx)
+{
+    s_mqtt.rtt_ctx = rtt_ctx;
+    s_mqtt.rtt_cb = rtt_cb;
+}
+
+void mqtt_manager_get_publish_stat(mqtt_manager_publish_stat_t *stat)
+{
+    if (!stat) {
+        return;
+    }
+    if (!s_mqtt.initialized) {
+        memset(stat, 0, sizeof(*stat));
+        return;
+    }
+    xSemaphoreTake(s_mqtt.pub_lock, portMAX_DELAY);
+    *stat = s_mqtt.pub_sched.stat;
+    xSemaphoreGive(s_mqtt.pub_lock);
+}
+
+void mqtt_manager_get_outbox_stat(mqtt_manager_outbox_stat_t *stat)
+{
+    if (!stat) {
+        return;
+    }
+    if (!s_mqtt.initialized) {
+        memset(stat, 0, sizeof(*stat));
+        return;
+    }
+    xSemaphoreTake(s_mqtt.pub_lock, portMAX_DELAY);
+    mqtt_outbox_get_stat(&s_mqtt.outbox, stat);
+    xSemaphoreGive(s_mqtt.pub_lock);
+}
+
+void mqtt_manager_get_connect_stat(mqtt_manager_connect_stat_t *stat)
+{
+    if (stat) {
+        *stat = s_mqtt.connect_stat;
+    }
+}
+
+void mqtt_manager_get_receive_stat(mqtt_manager_receive_stat_t *stat)
+{
+    if (!stat) {
+        return;
+    }
+    if (!mqtt_manager_setup_router()) {
+        memset(stat, 0, sizeof(*stat));
+        return;
+    }
+    xSemaphoreTakeRecursive(s_mqtt.router_lock, portMAX_DELAY);
+    *stat = s_mqtt.reasm.stat;
+    xSemaphoreGiveRecursive(s_mqtt.router_lock);
 }
@@ -0,0 +1,431 @@
+#include "mqtt_outbox.h"
+
+#include <string.h>
+
+_Static_assert(sizeof(mqtt_outbox_msg_t) <= MQTT_OUTBOX_RECORD_SIZE, "Outbox message doesn't fit into a record");
+_Static_assert(MQTT_OUTBOX_SPILL_LEN >= 2, "A message has to be added while another one is written");
+
+enum {
+    MQTT_OUTBOX_QUEUED,
+    MQTT_OUTBOX_SENDING,
+    MQTT_OUTBOX_IN_FLIGHT,
+    MQTT_OUTBOX_ACKED,
+};
+
+static mqtt_outbox_entry_t *mqtt_outbox_entry(mqtt_outbox_t *outbox, uint32_t i)
+{
+    return &outbox->entries[(outbox->head + i) % MQTT_OUTBOX_LEN];
+}
+
+static bool mqtt_outbox_spill_busy(const mqtt_outbox_t *outbox)
+{
+    return outbox->spilling && !outbox->spill_moved;
+}
+
+static void mqtt_outbox_pop_spill(mqtt_outbox_t *outbox, mqtt_outbox_msg_t *msg)
+{
+    outbox->spill_moved = outbox->spilling;
+    *msg = outbox->spill[outbox->spill_head];
+    outbox->spill_head = (outbox->spill_head + 1) % MQTT_OUTBOX_SPILL_LEN;
+    outbox->spill_cnt--;
+}
+
+/* Move the oldest messages of the storage, then of the ones not written yet, to the RAM ring */
+static void mqtt_outbox_refill(mqtt_outbox_t *outbox)
+{
+    mqtt_outbox_storage_t *storage = &outbox->storage;
+    while (outbox->cnt < MQTT_OUTBOX_LEN) {
+        mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, outbox->cnt);
+        if (outbox->storage_cnt > 0) {
+            bool ok = storage->read(storage->ctx, outbox->storage_read, &e->msg, sizeof(e->msg));
+            outbox->storage_read = (outbox->storage_read + MQTT_OUTBOX_RECORD_SIZE) % storage->size;
+            outbox->storage_cnt--;
+            if (!ok || e->msg.payload_len > MQTT_OUTBOX_MAX_PAYLOAD_LEN) {
+                outbox->stat.dropped_cnt++;
+                continue;
+            }
+        } else if (outbox->spill_cnt > 0) {
+            /* Not written yet, or being written: the record is skipped then */
+            mqtt_outbox_pop_spill(outbox, &e->msg);
+        } else {
+            break;
+        }
+        e->state = MQTT_OUTBOX_QUEUED;
+        e->msg_id = 0;
+        outbox->cnt++;
+    }
+}
+
+/* Drop the oldest message not written yet, except the one being written */
+static void mqtt_outbox_drop_spill(mqtt_outbox_t *outbox)
+{
+    uint32_t i = mqtt_outbox_spill_busy(outbox) ? 1 : 0;
+    for (; i + 1 < outbox->spill_cnt; ++i) {
+        outbox->spill[(outbox->spill_head + i) % MQTT_OUTBOX_SPILL_LEN] =
+            outbox->spill[(outbox->spill_head + i + 1) % MQTT_OUTBOX_SPILL_LEN];
+    }
+    outbox->spill_cnt--;
+    outbox->stat.dropped_cnt++;
+}
+
+/* Remove the acknowledged messages from the start of the ring */
+static void mqtt_outbox_pop_acked(mqtt_outbox_t *outbox)
+{
+    bool popped = false;
+    while (outbox->sent_cnt > 0 && mqtt_outbox_entry(outbox, 0)->state == MQTT_OUTBOX_ACKED) {
+        outbox->head = (outbox->head + 1) % MQTT_OUTBOX_LEN;
+        outbox->cnt--;
+        outbox->sent_cnt--;
+        popped = true;
+    }
+    if (popped) {
+        mqtt_outbox_refill(outbox);
+    }
+}
+
+/* Remove the acknowledged messages kept behind a message still in flight */
+static void mqtt_outbox_remove_acked(mqtt_outbox_t *outbox)
+{
+    uint32_t kept = 0;
+    uint32_t sent_cnt = outbox->sent_cnt;
+    for (uint32_t i = 0; i < outbox->cnt; ++i) {
+        mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, i);
+        if (e->state == MQTT_OUTBOX_ACKED) {
+            sent_cnt -= i < outbox->sent_cnt;
+            continue;
+        }
+        if (kept != i) {
+            *mqtt_outbox_entry(outbox, kept) = *e;
+        }
+        kept++;
+    }
+    outbox->cnt = (uint16_t)kept;
+    outbox->sent_cnt = (uint16_t)sent_cnt;
+    mqtt_outbox_refill(outbox);
+}
+
+static bool mqtt_outbox_drop_oldest(mqtt_outbox_t *outbox)
+{
+    /* Messages in flight are kept: they may be delivered already */
+    uint32_t i;
+    for (i = outbox->sent_cnt; i < outbox->cnt; ++i) {
+        if (mqtt_outbox_entry(outbox, i)->state == MQTT_OUTBOX_QUEUED) {
+            break;
+        }
+    }
+    if (i >= outbox->cnt) {
+        return false;
+    }
+    for (; i + 1 < outbox->cnt; ++i) {
+        *mqtt_outbox_entry(outbox, i) = *mqtt_outbox_entry(outbox, i + 1);
+    }
+    outbox->cnt--;
+    outbox->stat.dropped_cnt++;
+    mqtt_outbox_refill(outbox);
+    return true;
+}
+
+static void mqtt_outbox_delivered(mqtt_outbox_t *outbox, mqtt_outbox_entry_t *e, uint32_t now)
+{
+    uint32_t latency = now - e->msg.add_time;
+    outbox->latency_sum += latency;
+    if (latency > outbox->stat.latency_max) {
+        outbox->stat.latency_max = latency;
+    }
+    outbox->stat.delivered_cnt++;
+    e->state = MQTT_OUTBOX_ACKED;
+}
+
+/* Send the message in flight again */
+static void mqtt_outbox_requeue(mqtt_outbox_t *outbox, uint32_t i)
+{
+    mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, i);
+    e->state = MQTT_OUTBOX_QUEUED;
+    e->msg_id = 0;
+    outbox->stat.in_flight_cnt--;
+    outbox->stat.resent_cnt++;
+    if (i < outbox->sent_cnt) {
+        outbox->sent_cnt = (uint16_t)i;
+    }
+}
+
+static int mqtt_outbox_find_in_flight(mqtt_outbox_t *outbox, int msg_id)
+{
+    /* Requeued messages may leave messages in flight after `sent_cnt` */
+    for (uint32_t i = 0; i < outbox->cnt; ++i) {
+        mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, i);
+        if (e->state == MQTT_OUTBOX_IN_FLIGHT && e->msg_id == msg_id) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void mqtt_outbox_init(mqtt_outbox_t *outbox)
+{
+    memset(outbox, 0, sizeof(*outbox));
+}
+
+bool mqtt_outbox_set_storage(mqtt_outbox_t *outbox, const mqtt_outbox_storage_t *storage)
+{
+    if (!mqtt_outbox_is_empty(outbox) || !storage || !storage->read || !storage->write || !storage->erase ||
+        storage->sector_size == 0 || storage->sector_size % MQTT_OUTBOX_RECORD_SIZE ||
+        storage->size < 2 * storage->sector_size || storage->size % storage->sector_size) {
+        return false;
+    }
+    outbox->storage = *storage;
+    outbox->storage_read = 0;
+    outbox->storage_write = 0;
+    outbox->storage_cnt = 0;
+    outbox->spill_head = 0;
+    outbox->spill_cnt = 0;
+    outbox->spilling = false;
+    outbox->spill_moved = false;
+    return true;
+}
+
+bool mqtt_outbox_add(mqtt_outbox_t *outbox, int topic, const char *payload, size_t payload_len,
+                     bool compact, uint32_t now)
+{
+    if (payload_len > MQTT_OUTBOX_MAX_PAYLOAD_LEN) {
+        outbox->stat.dropped_cnt++;
+        return false;
+    }
+
+    /* The newest waiting message of the topic is at the end if any */
+    if (compact && outbox->storage_cnt == 0 && outbox->spill_cnt == 0) {
+        for (uint32_t i = outbox->cnt; i > outbox->sent_cnt; --i) {
+            mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, i - 1);
+            if (e->state == MQTT_OUTBOX_QUEUED && e->msg.topic == topic) {
+                /* Keep the time of the first value to measure how long the topic was stale */
+                memcpy(e->msg.payload, payload, payload_len);
+                e->msg.payload_len = (uint8_t)payload_len;
+                outbox->stat.compacted_cnt++;
+                return true;
+            }
+        }
+    }
+
+    mqtt_outbox_msg_t msg = {
+        .add_time = now,
+        .topic = (uint16_t)topic,
+        .compact = compact,
+        .payload_len = (uint8_t)payload_len,
+    };
+    memcpy(msg.payload, payload, payload_len);
+
+    if (outbox->cnt == MQTT_OUTBOX_LEN) {
+        mqtt_outbox_remove_acked(outbox);
+    }
+    /* Once a message is for the storage the newer ones go there too to keep the order */
+    if (outbox->storage.write &&
+        (outbox->cnt == MQTT_OUTBOX_LEN || outbox->storage_cnt > 0 || outbox->spill_cnt > 0)) {
+        if (outbox->spill_cnt == MQTT_OUTBOX_SPILL_LEN) {
+            /* Writing falls behind. The drop moves a message not written yet to RAM if it can. */
+            if (outbox->storage_cnt > 0 || !mqtt_outbox_drop_oldest(outbox) ||
+                outbox->spill_cnt == MQTT_OUTBOX_SPILL_LEN) {
+                mqtt_outbox_drop_spill(outbox);
+            }
+        }
+        outbox->spill[(outbox->spill_head + outbox->spill_cnt++) % MQTT_OUTBOX_SPILL_LEN] = msg;
+        return true;
+    }
+    if (outbox->cnt == MQTT_OUTBOX_LEN && !mqtt_outbox_drop_oldest(outbox)) {
+        outbox->stat.dropped_cnt++;
+        return false;
+    }
+
+    mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, outbox->cnt);
+    e->msg = msg;
+    e->msg_id = 0;
+    e->state = MQTT_OUTBOX_QUEUED;
+    outbox->cnt++;
+    return true;
+}
+
+bool mqtt_outbox_spill_take(mqtt_outbox_t *outbox, mqtt_outbox_spill_t *spill)
+{
+    mqtt_outbox_storage_t *storage = &outbox->storage;
+    if (outbox->spilling) {
+        return false;
+    }
+    /* Keep a sector free, so the sector erased for writing never holds waiting messages.
+     * If the storage is full the oldest waiting message is dropped, moving one from the storage to RAM. */
+    while (outbox->spill_cnt > 0 &&
+           (outbox->storage_cnt + 1) * MQTT_OUTBOX_RECORD_SIZE > storage->size - storage->sector_size) {
+        if (!mqtt_outbox_drop_oldest(outbox)) {
+            mqtt_outbox_drop_spill(outbox);
+        }
+    }
+    if (outbox->spill_cnt == 0) {
+        return false;
+    }
+    spill->msg = outbox->spill[outbox->spill_head];
+    spill->offset = outbox->storage_write;
+    spill->erase = outbox->storage_write % storage->sector_size == 0;
+    outbox->spilling = true;
+    return true;
+}
+
+bool mqtt_outbox_spill_write(const mqtt_outbox_t *outbox, const mqtt_outbox_spill_t *spill)
+{
+    const mqtt_outbox_storage_t *storage = &outbox->storage;
+    if (spill->erase && !storage->erase(storage->ctx, spill->offset, storage->sector_size)) {
+        return false;
+    }
+    return storage->write(storage->ctx, spill->offset, &spill->msg, sizeof(spill->msg));
+}
+
+void mqtt_outbox_spill_done(mqtt_outbox_t *outbox, bool ok)
+{
+    if (!outbox->spilling) {
+        return;
+    }
+    outbox->spilling = false;
+    if (outbox->spill_moved) {
+        /* The message is in RAM, and nothing newer was written since as the storage was empty.
+         * The record can't be written again before its sector is erased, so it's skipped. */
+        outbox->spill_moved = false;
+        if (ok) {
+            outbox->storage_write = (outbox->storage_write + MQTT_OUTBOX_RECORD_SIZE) % outbox->storage.size;
+            outbox->storage_read = outbox->storage_write;
+        }
+        return;
+    }
+    mqtt_outbox_msg_t msg;
+    mqtt_outbox_pop_spill(outbox, &msg);
+    if (ok) {
+        outbox->storage_write = (outbox->storage_write + MQTT_OUTBOX_RECORD_SIZE) % outbox->storage.size;
+        outbox->storage_cnt++;
+    } else {
+        outbox->stat.dropped_cnt++;
+    }
+    /* The ring may have emptied while the message was written */
+    mqtt_outbox_refill(outbox);
+}
+
+bool mqtt_outbox_take(mqtt_outbox_t *outbox, mqtt_outbox_msg_t *msg)
+{
+    if (outbox->sending || outbox->stat.in_flight_cnt >= MQTT_OUTBOX_WINDOW) {
+        return false;
+    }
+    /* Make space for the messages in the storage */
+    mqtt_outbox_pop_acked(outbox);
+    while (outbox->sent_cnt < outbox->cnt &&
+           mqtt_outbox_entry(outbox, outbox->sent_cnt)->state != MQTT_OUTBOX_QUEUED) {
+        outbox->sent_cnt++;
+    }
+    if (outbox->sent_cnt >= outbox->cnt) {
+        return false;
+    }
+    mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, outbox->sent_cnt++);
+    e->state = MQTT_OUTBOX_SENDING;
+    *msg = e->msg;
+    outbox->sending = true;
+    outbox->early_ack = 0;
+    return true;
+}
+
+void mqtt_outbox_sent(mqtt_outbox_t *outbox, int msg_id, uint32_t now)
+{
+    if (!outbox->sending) {
+        return;
+    }
+    outbox->sending = false;
+    for (uint32_t i = 0; i < outbox->cnt; ++i) {
+        mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, i);
+        if (e->state != MQTT_OUTBOX_SENDING) {
+            continue;
+        }
+        if (msg_id < 0) {
+            e->state = MQTT_OUTBOX_QUEUED;
+            if (i < outbox->sent_cnt) {
+                outbox->sent_cnt = (uint16_t)i;
+            }
+        } else if (msg_id == 0 || msg_id == outbox->early_ack) {
+            mqtt_outbox_delivered(outbox, e, now);
+        } else {
+            e->state = MQTT_OUTBOX_IN_FLIGHT;
+            e->msg_id = msg_id;
+            e->send_time = now;
+            outbox->stat.in_flight_cnt++;
+        }
+        break;
+    }
+    outbox->early_ack = 0;
+    mqtt_outbox_pop_acked(outbox);
+}
+
+bool mqtt_outbox_ack(mqtt_outbox_t *outbox, int msg_id, uint32_t now)
+{
+    int i = mqtt_outbox_find_in_flight(outbox, msg_id);
+    if (i < 0) {
+        /* The acknowledgment may come before the id of the message being sent is known.
+         * Only the last one is kept: if it was not for this message, the message is sent
+         * again when its acknowledgment times out. */
+        if (outbox->sending) {
+            outbox->early_ack = msg_id;
+        }
+        return false;
+    }
+    mqtt_outbox_delivered(outbox, mqtt_outbox_entry(outbox, (uint32_t)i), now);
+    outbox->stat.in_flight_cnt--;
+    mqtt_outbox_pop_acked(outbox);
+    return true;
+}
+
+bool mqtt_outbox_resend(mqtt_outbox_t *outbox, int msg_id)
+{
+    int i = mqtt_outbox_find_in_flight(outbox, msg_id);
+    if (i < 0) {
+        return false;
+    }
+    mqtt_outbox_requeue(outbox, (uint32_t)i);
+    return true;
+}
+
+uint32_t mqtt_outbox_check_timeouts(mqtt_outbox_t *outbox, uint32_t now, uint32_t timeout)
+{
+    uint32_t next = MQTT_OUTBOX_IDLE;
+    bool requeued = false;
+    for (uint32_t i = 0; i < outbox->cnt; ++i) {
+        mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, i);
+        if (e->state != MQTT_OUTBOX_IN_FLIGHT) {
+            continue;
+        }
+        uint32_t elapsed = now - e->send_time;
+        if (elapsed >= timeout) {
+            mqtt_outbox_requeue(outbox, i);
+            requeued = true;
+        } else if (timeout - elapsed < next) {
+            next = timeout - elapsed;
+        }
+    }
+    return requeued ? 0 : next;
+}
+
+void mqtt_outbox_reset_in_flight(mqtt_outbox_t *outbox)
+{
+    for (uint32_t i = 0; i < outbox->cnt; ++i) {
+        mqtt_outbox_entry_t *e = mqtt_outbox_entry(outbox, i);
+        if (e->state == MQTT_OUTBOX_IN_FLIGHT) {
+            e->state = MQTT_OUTBOX_QUEUED;
+            e->msg_id = 0;
+        }
+    }
+    outbox->sent_cnt = 0;
+    outbox->early_ack = 0;
+    outbox->stat.in_flight_cnt = 0;
+}
+
+void mqtt_outbox_get_stat(const mqtt_outbox_t *outbox, mqtt_outbox_stat_t *stat)
+{
+    *stat = outbox->stat;
+    stat->queued_cnt = outbox->storage_cnt + outbox->spill_cnt;
+    for (uint32_t i = 0; i < outbox->cnt; ++i) {
+        const mqtt_outbox_entry_t *e = &outbox->entries[(outbox->head + i) % MQTT_OUTBOX_LEN];
+        stat->queued_cnt += e->state == MQTT_OUTBOX_QUEUED;
+    }
+    stat->spilled_cnt = outbox->storage_cnt + outbox->spill_cnt;
+    stat->latency_avg = stat->delivered_cnt ? (uint32_t)(outbox->latency_sum / stat->delivered_cnt) : 0;
+}
@@ -0,0 +1,104 @@
+#include "mqtt_pub_sched.h"
+
+#include <string.h>
+
+static void mqtt_pub_sched_send(mqtt_pub_sched_t *sched, mqtt_pub_sched_topic_t *t, uint32_t now)
+{
+    if (sched->send_cb((int)(t - sched->topics), t->payload, t->payload_len, sched->send_ctx)) {
+        sched->stat.sent_cnt++;
+    } else {
+        sched->stat.dropped_cnt++;
+    }
+    /* Refused values start the interval too, so a retry doesn't hammer the client */
+    t->last_send = now;
+    t->sent = 1;
+    t->pending = 0;
+}
+
+static bool mqtt_pub_sched_is_due(const mqtt_pub_sched_topic_t *t, uint32_t now)
+{
+    return !t->sent || now - t->last_send >= t->min_interval;
+}
+
+void mqtt_pub_sched_init(mqtt_pub_sched_t *sched, mqtt_pub_sched_send_cb_t send_cb, void *send_ctx)
+{
+    memset(sched, 0, sizeof(*sched));
+    sched->send_cb = send_cb;
+    sched->send_ctx = send_ctx;
+}
+
+int mqtt_pub_sched_add_topic(mqtt_pub_sched_t *sched, const char *prefix, const char *name,
+                             uint8_t qos, uint32_t min_interval)
+{
+    if (!sched || !name || !name[0]) {
+        return -1;
+    }
+    size_t prefix_len = prefix ? strlen(prefix) : 0;
+    size_t name_len = strlen(name);
+    size_t topic_len = prefix_len ? prefix_len + 1 + name_len : name_len;
+    if (sched->topic_cnt >= MQTT_PUB_SCHED_MAX_TOPICS ||
+        sched->topic_pool_used + topic_len + 1 > MQTT_PUB_SCHED_TOPIC_POOL_SIZE) {
+        return -1;
+    }
+
+    /* The name is the end of the topic */
+    char *topic = &sched->topic_pool[sched->topic_pool_used];
+    if (prefix_len) {
+        memcpy(topic, prefix, prefix_len);
+        topic[prefix_len] = '/';
+    }
+    memcpy(&topic[topic_len - name_len], name, name_len + 1);
+
+    int id = sched->topic_cnt++;
+    mqtt_pub_sched_topic_t *t = &sched->topics[id];
+    memset(t, 0, sizeof(*t));
+    t->topic_off = sched->topic_pool_used;
+    t->qos = qos;
+    t->min_interval = min_interval;
+    sched->topic_pool_used += topic_len + 1;
+    return id;
+}
+
+bool mqtt_pub_sched_publish(mqtt_pub_sched_t *sched, int topic, const char *payload, size_t payload_len,
+                            uint32_t now)
+{
+    if (!sched || topic < 0 || topic >= sched->topic_cnt || !payload) {
+        return false;
+    }
+    if (payload_len > MQTT_PUB_SCHED_MAX_PAYLOAD_LEN) {
+        sched->stat.dropped_cnt++;
+        return false;
+    }
+
+    mqtt_pub_sched_topic_t *t = &sched->topics[topic];
+    if (t->pending) {
+        sched->stat.coalesced_cnt++;
+    }
+    memcpy(t->payload, payload, payload_len);
+    t->payload_len = (uint8_t)payload_len;
+    t->pending = 1;
+    if (mqtt_pub_sched_is_due(t, now)) {
+        mqtt_pub_sched_send(sched, t, now);
+    }
+    return true;
+}
+
+uint32_t mqtt_pub_sched_flush(mqtt_pub_sched_t *sched, uint32_t now)
+{
+    uint32_t next = MQTT_PUB_SCHED_IDLE;
+    for (int i = 0; i < sched->topic_cnt; ++i) {
+        mqtt_pub_sched_topic_t *t = &sched->topics[i];
+        if (!t->pending) {
+            continue;
+        }
+        if (mqtt_pub_sched_is_due(t, now)) {
+            mqtt_pub_sched_send(sched, t, now);
+        } else {
+            uint32_t wait = t->min_interval - (now - t->last_send);
+            if (wait < next) {
+                next = wait;
+            }
+        }
+    }
+    return next;
+}
@@ -0,0 +1,128 @@
+#include "mqtt_reasm.h"
+
+#include <string.h>
+
+/* Have a buffer for `len` bytes, keeping the current one if it's large enough */
+static bool mqtt_reasm_reserve(mqtt_reasm_t *reasm, size_t len)
+{
+    if (reasm->buf_size >= len) {
+        return true;
+    }
+    if (reasm->buf) {
+        reasm->free_cb(reasm->buf, reasm->alloc_ctx);
+        reasm->buf = NULL;
+        reasm->buf_size = 0;
+    }
+    reasm->buf = reasm->alloc_cb(len, reasm->alloc_ctx);
+    if (!reasm->buf) {
+        reasm->stat.buf_size = 0;
+        return false;
+    }
+    reasm->buf_size = len;
+    reasm->stat.buf_size = (uint32_t)len;
+    return true;
+}
+
+static mqtt_reasm_state_t mqtt_reasm_begin(mqtt_reasm_t *reasm, const mqtt_reasm_fragment_t *frag, bool keep)
+{
+    reasm->stat.msg_cnt++;
+    reasm->active = false;
+    if (!frag->topic || frag->topic_len > sizeof(reasm->topic)) {
+        reasm->stat.broken_cnt++;
+        return MQTT_REASM_SKIPPED;
+    }
+    memcpy(reasm->topic, frag->topic, frag->topic_len);
+    reasm->topic_len = frag->topic_len;
+    reasm->total_len = frag->total_len;
+    reasm->received = 0;
+    reasm->active = true;
+    reasm->keep = false;
+    if (!keep) {
+        return MQTT_REASM_PARTIAL;
+    }
+    if (frag->total_len > reasm->max_len) {
+        reasm->stat.too_long_cnt++;
+    } else if (!mqtt_reasm_reserve(reasm, frag->total_len)) {
+        reasm->stat.no_mem_cnt++;
+    } else {
+        reasm->keep = true;
+    }
+    return MQTT_REASM_PARTIAL;
+}
+
+void mqtt_reasm_init(mqtt_reasm_t *reasm, size_t max_len,
+                     mqtt_reasm_alloc_cb_t alloc_cb, mqtt_reasm_free_cb_t free_cb, void *alloc_ctx)
+{
+    memset(reasm, 0, sizeof(*reasm));
+    reasm->max_len = max_len;
+    reasm->alloc_cb = alloc_cb;
+    reasm->free_cb = free_cb;
+    reasm->alloc_ctx = alloc_ctx;
+}
+
+void mqtt_reasm_deinit(mqtt_reasm_t *reasm)
+{
+    if (reasm->buf) {
+        reasm->free_cb(reasm->buf, reasm->alloc_ctx);
+    }
+    reasm->buf = NULL;
+    reasm->buf_size = 0;
+    reasm->stat.buf_size = 0;
+    reasm->active = false;
+}
+
+mqtt_reasm_state_t mqtt_reasm_feed(mqtt_reasm_t *reasm, const mqtt_reasm_fragment_t *frag, bool keep,
+                                   mqtt_router_view_t *topic, mqtt_router_view_t *payload)
+{
+    *topic = (mqtt_router_view_t) { NULL, 0 };
+    *payload = (mqtt_router_view_t) { NULL, 0 };
+
+    if (mqtt_reasm_is_whole(frag)) {
+        /* A message still waiting for fragments lost its end */
+        if (reasm->active) {
+            reasm->stat.broken_cnt++;
+            reasm->active = false;
+        }
+        reasm->stat.msg_cnt++;
+        *topic = (mqtt_router_view_t) { frag->topic, frag->topic ? frag->topic_len : 0 };
+        *payload = (mqtt_router_view_t) { frag->data, frag->data_len };
+        return MQTT_REASM_COMPLETE;
+    }
+
+    if (mqtt_reasm_is_first(frag)) {
+        if (reasm->active) {
+            reasm->stat.broken_cnt++;
+        }
+        if (mqtt_reasm_begin(reasm, frag, keep) == MQTT_REASM_SKIPPED) {
+            return MQTT_REASM_SKIPPED;
+        }
+    } else if (!reasm->active || frag->offset != reasm->received || frag->total_len != reasm->total_len) {
+        if (reasm->active) {
+            reasm->stat.broken_cnt++;
+            reasm->active = false;
+        }
+        return MQTT_REASM_SKIPPED;
+    }
+
+    if (frag->data_len > reasm->total_len - reasm->received) {
+        reasm->stat.broken_cnt++;
+        reasm->active = false;
+        return MQTT_REASM_SKIPPED;
+    }
+    *topic = (mqtt_router_view_t) { reasm->topic, reasm->topic_len };
+    if (reasm->keep) {
+        memcpy(&reasm->buf[reasm->received], frag->data, frag->data_len);
+    }
+    reasm->received += frag->data_len;
+    if (reasm->received < reasm->total_len) {
+        return MQTT_REASM_PARTIAL;
+    }
+
+    reasm->active = false;
+    if (!reasm->keep) {
+        return MQTT_REASM_SKIPPED;
+    }
+    reasm->stat.reassembled_cnt++;
+    *payload = (mqtt_router_view_t) { reasm->buf, reasm->total_len };
+    return MQTT_REASM_COMPLETE;
+}
@@ -0,0 +1,54 @@
+#include "mqtt_reconnect.h"
+
+#include <stddef.h>
+
+uint32_t mqtt_reconnect_backoff_ms(uint32_t attempt, uint32_t rnd)
+{
+    /* The shift is limited so a long outage doesn't overflow it */
+    uint32_t delay = MQTT_RECONNECT_BACKOFF_MIN_MS << (attempt < 8 ? attempt : 8);
+    if (delay > MQTT_RECONNECT_BACKOFF_MAX_MS) {
+        delay = MQTT_RECONNECT_BACKOFF_MAX_MS;
+    }
+    return delay / 2 + rnd % (delay / 2 + 1);
+}
+
+void mqtt_reconnect_session_init(mqtt_reconnect_session_t *cache, mqtt_reconnect_free_cb_t free_cb,
+                                 void *free_ctx)
+{
+    cache->session = NULL;
+    cache->offered = false;
+    cache->free_cb = free_cb;
+    cache->free_ctx = free_ctx;
+}
+
+void *mqtt_reconnect_session_offer(mqtt_reconnect_session_t *cache)
+{
+    cache->offered = cache->session != NULL;
+    return cache->session;
+}
+
+void mqtt_reconnect_session_clear(mqtt_reconnect_session_t *cache)
+{
+    if (cache->session) {
+        cache->free_cb(cache->session, cache->free_ctx);
+        cache->session = NULL;
+    }
+    cache->offered = false;
+}
+
+void mqtt_reconnect_session_failed(mqtt_reconnect_session_t *cache)
+{
+    mqtt_reconnect_session_clear(cache);
+}
+
+bool mqtt_reconnect_session_done(mqtt_reconnect_session_t *cache, void *session)
+{
+    bool offered = cache->offered;
+    /* A new ticket may have been issued */
+    if (session != cache->session) {
+        mqtt_reconnect_session_clear(cache);
+        cache->session = session;
+    }
+    cache->offered = false;
+    return offered;
+}
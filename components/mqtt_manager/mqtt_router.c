@@ -0,0 +1,285 @@
+#include "mqtt_router.h"
+
+#include <string.h>
+
+#define MQTT_ROUTER_CHILD_SLOTS (MQTT_ROUTER_MAX_NODES * 2)
+#define MQTT_ROUTER_TOPIC_END   SIZE_MAX
+
+typedef struct {
+    const mqtt_router_t *router;
+    const char *topic;
+    size_t topic_len;
+    mqtt_router_view_t payload;
+    const mqtt_router_chunk_t *chunk;
+    bool stream;            /* Only the stream routes are called, or only the others */
+    bool count_only;
+    bool system_topic;      /* Starts with `$`, so not matched by a wildcard on the first level */
+    uint32_t call_cnt;
+} mqtt_router_dispatch_t;
+
+/* FNV-1a of the level, seeded with the parent, so the same level under other parents lands elsewhere */
+static uint32_t mqtt_router_hash(uint16_t parent, const char *level, size_t len)
+{
+    uint32_t hash = (2166136261u ^ parent) * 16777619u;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ (uint8_t)level[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool mqtt_router_level_is(const char *level, size_t len, char c)
+{
+    return len == 1 && level[0] == c;
+}
+
+/* Return the slot of the child, or the empty slot where it should be inserted */
+static uint32_t mqtt_router_find_slot(const mqtt_router_t *router, uint16_t parent, uint32_t hash,
+                                      const char *level, size_t len)
+{
+    uint32_t slot = hash % MQTT_ROUTER_CHILD_SLOTS;
+    while (router->children[slot] != MQTT_ROUTER_NONE) {
+        const mqtt_router_node_t *node = &router->nodes[router->children[slot]];
+        if (node->hash == hash && node->parent == parent && node->level_len == len &&
+            memcmp(&router->filter_pool[node->level_off], level, len) == 0) {
+            break;
+        }
+        slot = (slot + 1) % MQTT_ROUTER_CHILD_SLOTS;
+    }
+    return slot;
+}
+
+static uint16_t mqtt_router_new_node(mqtt_router_t *router, uint16_t parent, uint32_t hash,
+                                     size_t level_off, size_t level_len)
+{
+    uint16_t id = router->node_cnt++;
+    mqtt_router_node_t *node = &router->nodes[id];
+    node->hash = hash;
+    node->parent = parent;
+    node->level_off = (uint16_t)level_off;
+    node->level_len = (uint16_t)level_len;
+    node->plus = MQTT_ROUTER_NONE;
+    node->routes = MQTT_ROUTER_NONE;
+    node->hash_routes = MQTT_ROUTER_NONE;
+    return id;
+}
+
+void mqtt_router_init(mqtt_router_t *router)
+{
+    memset(router, 0, sizeof(*router));
+    for (size_t i = 0; i < MQTT_ROUTER_CHILD_SLOTS; ++i) {
+        router->children[i] = MQTT_ROUTER_NONE;
+    }
+    /* The root: the parent of the first level */
+    mqtt_router_new_node(router, MQTT_ROUTER_NONE, 0, 0, 0);
+}
+
+bool mqtt_router_filter_is_valid(const char *filter)
+{
+    if (!filter || !filter[0]) {
+        return false;
+    }
+    const char *level = filter;
+    while (true) {
+        const char *end = strchr(level, '/');
+        size_t len = end ? (size_t)(end - level) : strlen(level);
+        if (memchr(level, '#', len) && (!mqtt_router_level_is(level, len, '#') || end)) {
+            return false;
+        }
+        if (memchr(level, '+', len) && !mqtt_router_level_is(level, len, '+')) {
+            return false;
+        }
+        if (!end) {
+            return true;
+        }
+        level = end + 1;
+    }
+}
+
+static int mqtt_router_add_route(mqtt_router_t *router, const char *filter, uint8_t qos, bool stream)
+{
+    if (!router || !mqtt_router_filter_is_valid(filter)) {
+        return -1;
+    }
+    size_t filter_len = strlen(filter);
+    size_t level_cnt = 1;
+    for (size_t i = 0; i < filter_len; ++i) {
+        level_cnt += filter[i] == '/';
+    }
+    /* Check the space first to not leave half added filters behind */
+    if (router->route_cnt >= MQTT_ROUTER_MAX_ROUTES ||
+        router->filter_pool_used + filter_len + 1 > MQTT_ROUTER_FILTER_POOL_SIZE ||
+        router->node_cnt + level_cnt > MQTT_ROUTER_MAX_NODES) {
+        return -1;
+    }
+
+    size_t filter_off = router->filter_pool_used;
+    const char *pool_filter = &router->filter_pool[filter_off];
+    memcpy(&router->filter_pool[filter_off], filter, filter_len + 1);
+    router->filter_pool_used += filter_len + 1;
+
+    uint16_t node = 0;
+    bool multi_level = false;
+    size_t level_off = 0;
+    while (level_off <= filter_len) {
+        const char *level = &pool_filter[level_off];
+        const char *end = strchr(level, '/');
+        size_t len = end ? (size_t)(end - level) : strlen(level);
+
+        if (mqtt_router_level_is(level, len, '#')) {
+            multi_level = true;
+            break;
+        }
+        if (mqtt_router_level_is(level, len, '+')) {
+            if (router->nodes[node].plus == MQTT_ROUTER_NONE) {
+                router->nodes[node].plus = mqtt_router_new_node(router, node, 0, filter_off + level_off, len);
+            }
+            node = router->nodes[node].plus;
+        } else {
+            uint32_t hash = mqtt_router_hash(node, level, len);
+            uint32_t slot = mqtt_router_find_slot(router, node, hash, level, len);
+            if (router->children[slot] == MQTT_ROUTER_NONE) {
+                router->children[slot] = mqtt_router_new_node(router, node, hash, filter_off + level_off, len);
+            }
+            node = router->children[slot];
+        }
+        level_off += len + 1;
+    }
+
+    uint16_t *list = multi_level ? &router->nodes[node].hash_routes : &router->nodes[node].routes;
+    uint16_t id = router->route_cnt++;
+    mqtt_router_route_t *route = &router->routes[id];
+    route->filter_off = (uint16_t)filter_off;
+    route->qos = qos;
+    route->first = *list == MQTT_ROUTER_NONE;
+    route->stream = stream;
+    route->next = *list;
+    *list = id;
+    return id;
+}
+
+int mqtt_router_add(mqtt_router_t *router, const char *filter, uint8_t qos,
+                    mqtt_router_cb_t cb, void *ctx)
+{
+    int id = cb ? mqtt_router_add_route(router, filter, qos, false) : -1;
+    if (id >= 0) {
+        router->routes[id].cb = cb;
+        router->routes[id].ctx = ctx;
+    }
+    return id;
+}
+
+int mqtt_router_add_stream(mqtt_router_t *router, const char *filter, uint8_t qos,
+                           mqtt_router_stream_cb_t stream_cb, void *ctx)
+{
+    int id = stream_cb ? mqtt_router_add_route(router, filter, qos, true) : -1;
+    if (id >= 0) {
+        router->routes[id].stream_cb = stream_cb;
+        router->routes[id].ctx = ctx;
+    }
+    return id;
+}
+
+static void mqtt_router_call(mqtt_router_dispatch_t *d, uint16_t id)
+{
+    mqtt_router_view_t topic = { d->topic, d->topic_len };
+    while (id != MQTT_ROUTER_NONE) {
+        const mqtt_router_route_t *route = &d->router->routes[id];
+        id = route->next;
+        if (route->stream != d->stream) {
+            continue;
+        }
+        if (!d->count_only) {
+            if (d->stream) {
+                route->stream_cb(topic, d->chunk, route->ctx);
+            } else {
+                route->cb(topic, d->payload, route->ctx);
+            }
+        }
+        d->call_cnt++;
+    }
+}
+
+/* `level_off` is the start of the topic level below `node_id` or MQTT_ROUTER_TOPIC_END */
+static void mqtt_router_match(mqtt_router_dispatch_t *d, uint16_t node_id, size_t level_off)
+{
+    const mqtt_router_t *router = d->router;
+    const mqtt_router_node_t *node = &router->nodes[node_id];
+    bool wildcard_ok = node_id != 0 || !d->system_topic;
+
+    /* `#` matches the parent level too, e.g. "a/#" matches "a" */
+    if (wildcard_ok) {
+        mqtt_router_call(d, node->hash_routes);
+    }
+    if (level_off == MQTT_ROUTER_TOPIC_END) {
+        mqtt_router_call(d, node->routes);
+        return;
+    }
+
+    const char *level = &d->topic[level_off];
+    const char *end = memchr(level, '/', d->topic_len - level_off);
+    size_t len = end ? (size_t)(end - level) : d->topic_len - level_off;
+    size_t next_off = end ? level_off + len + 1 : MQTT_ROUTER_TOPIC_END;
+
+    uint32_t hash = mqtt_router_hash(node_id, level, len);
+    uint16_t child = router->children[mqtt_router_find_slot(router, node_id, hash, level, len)];
+    if (child != MQTT_ROUTER_NONE) {
+        mqtt_router_match(d, child, next_off);
+    }
+    if (node->plus != MQTT_ROUTER_NONE && wildcard_ok) {
+        mqtt_router_match(d, node->plus, next_off);
+    }
+}
+
+uint32_t mqtt_router_dispatch(const mqtt_router_t *router,
+                              const char *topic, size_t topic_len,
+                              const char *payload, size_t payload_len)
+{
+    if (!router || !topic) {
+        return 0;
+    }
+    mqtt_router_dispatch_t d = {
+        .router = router,
+        .topic = topic,
+        .topic_len = topic_len,
+        .payload = { payload, payload_len },
+        .system_topic = topic_len > 0 && topic[0] == '$',
+    };
+    mqtt_router_match(&d, 0, 0);
+    return d.call_cnt;
+}
+
+uint32_t mqtt_router_dispatch_chunk(const mqtt_router_t *router,
+                                    const char *topic, size_t topic_len,
+                                    const mqtt_router_chunk_t *chunk)
+{
+    if (!router || !topic || !chunk) {
+        return 0;
+    }
+    mqtt_router_dispatch_t d = {
+        .router = router,
+        .topic = topic,
+        .topic_len = topic_len,
+        .chunk = chunk,
+        .stream = true,
+        .system_topic = topic_len > 0 && topic[0] == '$',
+    };
+    mqtt_router_match(&d, 0, 0);
+    return d.call_cnt;
+}
+
+uint32_t mqtt_router_count(const mqtt_router_t *router, const char *topic, size_t topic_len, bool stream)
+{
+    if (!router || !topic) {
+        return 0;
+    }
+    mqtt_router_dispatch_t d = {
+        .router = router,
+        .topic = topic,
+        .topic_len = topic_len,
+        .stream = stream,
+        .count_only = true,
+        .system_topic = topic_len > 0 && topic[0] == '$',
+    };
+    mqtt_router_match(&d, 0, 0);
+    return d.call_cnt;
+}
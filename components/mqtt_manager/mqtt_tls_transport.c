@@ -0,0 +1,183 @@
+#include "mqtt_tls_transport.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_tls.h"
+#include "mqtt_reconnect.h"
+#include "sdkconfig.h"
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+
+static const char *TAG = "mqtt_tls";
+
+typedef struct {
+    esp_tls_t *tls;
+    const char *ca_pem;
+    mqtt_reconnect_session_t session;   /* Of the last connection */
+    mqtt_tls_transport_stat_t stat;
+} mqtt_tls_transport_t;
+
+static int mqtt_tls_transport_poll(esp_transport_handle_t t, int timeout_ms, bool write)
+{
+    mqtt_tls_transport_t *ctx = esp_transport_get_context_data(t);
+    int fd;
+    if (!ctx->tls || esp_tls_get_conn_sockfd(ctx->tls, &fd) != ESP_OK) {
+        return -1;
+    }
+    if (!write && esp_tls_get_bytes_avail(ctx->tls) > 0) {
+        return 1;
+    }
+
+    fd_set set;
+    fd_set err_set;
+    FD_ZERO(&set);
+    FD_ZERO(&err_set);
+    FD_SET(fd, &set);
+    FD_SET(fd, &err_set);
+    struct timeval timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    int ret = select(fd + 1, write ? NULL : &set, write ? &set : NULL, &err_set,
+                     timeout_ms < 0 ? NULL : &timeout);
+    if (ret > 0 && FD_ISSET(fd, &err_set)) {
+        return -1;
+    }
+    return ret;
+}
+
+static int mqtt_tls_transport_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    return mqtt_tls_transport_poll(t, timeout_ms, false);
+}
+
+static int mqtt_tls_transport_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    return mqtt_tls_transport_poll(t, timeout_ms, true);
+}
+
+static void mqtt_tls_transport_free_session(void *session, void *ctx)
+{
+    (void)ctx;
+    esp_tls_free_client_session(session);
+}
+
+static int mqtt_tls_transport_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    mqtt_tls_transport_t *ctx = esp_transport_get_context_data(t);
+    ctx->tls = esp_tls_init();
+    if (!ctx->tls) {
+        return -1;
+    }
+
+    esp_tls_cfg_t cfg = {
+        .cacert_buf = (const unsigned char *)ctx->ca_pem,
+        .cacert_bytes = strlen(ctx->ca_pem) + 1,
+        .timeout_ms = timeout_ms,
+        .client_session = mqtt_reconnect_session_offer(&ctx->session),
+    };
+    int64_t start = esp_timer_get_time();
+    if (esp_tls_conn_new_sync(host, (int)strlen(host), port, &cfg, ctx->tls) <= 0) {
+        esp_tls_conn_destroy(ctx->tls);
+        ctx->tls = NULL;
+        mqtt_reconnect_session_failed(&ctx->session);
+        return -1;
+    }
+
+    bool offered = mqtt_reconnect_session_done(&ctx->session, esp_tls_get_client_session(ctx->tls));
+    ctx->stat.handshake_cnt++;
+    ctx->stat.last_handshake_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    ctx->stat.last_ticket_offered = offered;
+    if (offered) {
+        ctx->stat.ticket_offered_cnt++;
+    }
+    ESP_LOGI(TAG, "Handshake %s ticket took %u ms", offered ? "with" : "without",
+             (unsigned)ctx->stat.last_handshake_ms);
+    return 0;
+}
+
+static int mqtt_tls_transport_read(esp_transport_handle_t t, char *buf, int len, int timeout_ms)
+{
+    mqtt_tls_transport_t *ctx = esp_transport_get_context_data(t);
+    int poll = 1;
+    if (esp_tls_get_bytes_avail(ctx->tls) <= 0) {
+        poll = mqtt_tls_transport_poll_read(t, timeout_ms);
+        if (poll <= 0) {
+            return poll;
+        }
+    }
+    int ret = esp_tls_conn_read(ctx->tls, buf, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_TIMEOUT) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    if (ret == 0) {
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    return ret < 0 ? ERR_TCP_TRANSPORT_CONNECTION_FAILED : ret;
+}
+
+static int mqtt_tls_transport_write(esp_transport_handle_t t, const char *buf, int len, int timeout_ms)
+{
+    mqtt_tls_transport_t *ctx = esp_transport_get_context_data(t);
+    int poll = mqtt_tls_transport_poll_write(t, timeout_ms);
+    if (poll <= 0) {
+        return poll;
+    }
+    int ret = esp_tls_conn_write(ctx->tls, buf, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return 0;
+    }
+    return ret < 0 ? ERR_TCP_TRANSPORT_CONNECTION_FAILED : ret;
+}
+
+static int mqtt_tls_transport_close(esp_transport_handle_t t)
+{
+    mqtt_tls_transport_t *ctx = esp_transport_get_context_data(t);
+    if (ctx->tls) {
+        esp_tls_conn_destroy(ctx->tls);
+        ctx->tls = NULL;
+    }
+    return 0;
+}
+
+static int mqtt_tls_transport_destroy(esp_transport_handle_t t)
+{
+    mqtt_tls_transport_t *ctx = esp_transport_get_context_data(t);
+    mqtt_tls_transport_close(t);
+    mqtt_reconnect_session_clear(&ctx->session);
+    free(ctx);
+    return 0;
+}
+
+esp_transport_handle_t mqtt_tls_transport_create(const char *ca_pem)
+{
+    mqtt_tls_transport_t *ctx = calloc(1, sizeof(*ctx));
+    esp_transport_handle_t t = esp_transport_init();
+    if (!ctx || !t) {
+        free(ctx);
+        if (t) {
+            esp_transport_destroy(t);
+        }
+        return NULL;
+    }
+    ctx->ca_pem = ca_pem;
+    mqtt_reconnect_session_init(&ctx->session, mqtt_tls_transport_free_session, NULL);
+    esp_transport_set_context_data(t, ctx);
+    esp_transport_set_func(t, mqtt_tls_transport_connect, mqtt_tls_transport_read, mqtt_tls_transport_write,
+                           mqtt_tls_transport_close, mqtt_tls_transport_poll_read,
+                           mqtt_tls_transport_poll_write, mqtt_tls_transport_destroy);
+    esp_transport_set_default_port(t, 8883);
+    return t;
+}
+
+void mqtt_tls_transport_get_stat(esp_transport_handle_t t, mqtt_tls_transport_stat_t *stat)
+{
+    mqtt_tls_transport_t *ctx = esp_transport_get_context_data(t);
+    *stat = ctx->stat;
+}
+
+#endif /*CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS*/
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * TLS transport for the MQTT client keeping the TLS session of the last
+ * connection. The next connection offers its ticket to the broker, which can
+ * resume the session with an abbreviated handshake: no certificate chain to
+ * verify and no key exchange.
+ * Needs CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS.
+ */
+
+typedef struct {
+    uint32_t handshake_cnt;
+    uint32_t ticket_offered_cnt;    /*!< Handshakes offering the ticket of the previous session */
+    uint32_t last_handshake_ms;     /*!< Duration of the last TCP connect and TLS handshake */
+    bool last_ticket_offered;
+} mqtt_tls_transport_stat_t;
+
+/**
+ * @brief Create the transport.
+ *
+ * @param ca_pem PEM certificate of the broker's CA. Not copied.
+ */
+esp_transport_handle_t mqtt_tls_transport_create(const char *ca_pem);
+
+void mqtt_tls_transport_get_stat(esp_transport_handle_t t, mqtt_tls_transport_stat_t *stat);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,690 @@
+/* Outbox against a broker stand-in dropping connections, with a flash stand-in for the spill */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mqtt_outbox.h"
+
+#define TOPIC_PRESS     1
+#define TOPIC_TEMP      2
+#define TOPIC_QOS0      9       /* Published without acknowledgment */
+
+#define DELIVERED_LEN   8192
+#define FLASH_SECTOR    4096
+#define FLASH_SIZE      (4 * FLASH_SECTOR)
+#define ACK_TIMEOUT     1000
+
+typedef struct {
+    int topic;
+    char payload[MQTT_OUTBOX_MAX_PAYLOAD_LEN + 1];
+} broker_msg_t;
+
+/* Messages received by the broker, and the ones it hasn't acknowledged yet */
+static struct {
+    bool online;
+    int next_id;
+    int pending[MQTT_OUTBOX_LEN];
+    uint32_t pending_cnt;
+    broker_msg_t delivered[DELIVERED_LEN];
+    uint32_t delivered_cnt;
+} broker;
+
+static uint8_t flash[FLASH_SIZE];
+static uint32_t erase_cnt;
+static uint32_t write_cnt;
+static bool flash_fail;
+static mqtt_outbox_t outbox;
+
+static int broker_publish(const mqtt_outbox_msg_t *msg)
+{
+    if (!broker.online) {
+        return -1;
+    }
+    assert(broker.delivered_cnt < DELIVERED_LEN);
+    broker_msg_t *d = &broker.delivered[broker.delivered_cnt++];
+    d->topic = msg->topic;
+    memcpy(d->payload, msg->payload, msg->payload_len);
+    d->payload[msg->payload_len] = '\0';
+    if (msg->topic == TOPIC_QOS0) {
+        return 0;
+    }
+    int id = broker.next_id++;
+    assert(broker.pending_cnt < MQTT_OUTBOX_LEN);
+    broker.pending[broker.pending_cnt++] = id;
+    return id;
+}
+
+/* Write what waits for the flash, as the publish task does before sending */
+static void spill_all(void)
+{
+    mqtt_outbox_spill_t spill;
+    while (mqtt_outbox_spill_take(&outbox, &spill)) {
+        mqtt_outbox_spill_done(&outbox, mqtt_outbox_spill_write(&outbox, &spill));
+    }
+}
+
+/* Send what the window allows, as the publish task does */
+static uint32_t send_all(uint32_t now)
+{
+    spill_all();
+    uint32_t sent_cnt = 0;
+    mqtt_outbox_msg_t msg;
+    while (mqtt_outbox_take(&outbox, &msg)) {
+        int msg_id = broker_publish(&msg);
+        mqtt_outbox_sent(&outbox, msg_id, now);
+        if (msg_id < 0) {
+            break;
+        }
+        sent_cnt++;
+    }
+    return sent_cnt;
+}
+
+/* Acknowledge the oldest message waiting at the broker */
+static int broker_ack(uint32_t now)
+{
+    assert(broker.pending_cnt > 0);
+    int id = broker.pending[0];
+    memmove(broker.pending, broker.pending + 1, --broker.pending_cnt * sizeof(broker.pending[0]));
+    mqtt_outbox_ack(&outbox, id, now);
+    return id;
+}
+
+static void ack_all(uint32_t now)
+{
+    send_all(now);
+    while (broker.pending_cnt > 0) {
+        broker_ack(now);
+        send_all(now);
+    }
+}
+
+/* The PUBACKs not sent yet are lost with the connection */
+static void broker_disconnect(void)
+{
+    broker.online = false;
+    broker.pending_cnt = 0;
+}
+
+static void broker_reconnect(void)
+{
+    broker.online = true;
+    mqtt_outbox_reset_in_flight(&outbox);
+}
+
+static void setup(void)
+{
+    memset(&broker, 0, sizeof(broker));
+    broker.online = true;
+    broker.next_id = 1;
+    mqtt_outbox_init(&outbox);
+}
+
+static bool add(int topic, int value, bool compact, uint32_t now)
+{
+    char payload[16];
+    int len = snprintf(payload, sizeof(payload), "%d", value);
+    return mqtt_outbox_add(&outbox, topic, payload, (size_t)len, compact, now);
+}
+
+static void assert_delivered(uint32_t i, int topic, int value)
+{
+    char payload[16];
+    snprintf(payload, sizeof(payload), "%d", value);
+    assert(i < broker.delivered_cnt);
+    assert(broker.delivered[i].topic == topic);
+    assert(strcmp(broker.delivered[i].payload, payload) == 0);
+}
+
+static mqtt_outbox_stat_t get_stat(void)
+{
+    mqtt_outbox_stat_t stat;
+    mqtt_outbox_get_stat(&outbox, &stat);
+    return stat;
+}
+
+static bool flash_read(void *ctx, uint32_t offset, void *buf, size_t len)
+{
+    assert(ctx == flash && offset + len <= FLASH_SIZE);
+    memcpy(buf, &flash[offset], len);
+    return true;
+}
+
+/* Like a NOR flash, writing can only clear bits */
+static bool flash_write(void *ctx, uint32_t offset, const void *buf, size_t len)
+{
+    assert(ctx == flash && offset + len <= FLASH_SIZE);
+    if (flash_fail) {
+        return false;
+    }
+    write_cnt++;
+    const uint8_t *src = buf;
+    for (size_t i = 0; i < len; ++i) {
+        assert((flash[offset + i] & src[i]) == src[i]);
+        flash[offset + i] &= src[i];
+    }
+    return true;
+}
+
+static bool flash_erase(void *ctx, uint32_t offset, uint32_t len)
+{
+    assert(ctx == flash && offset % FLASH_SECTOR == 0 && len == FLASH_SECTOR);
+    memset(&flash[offset], 0xff, len);
+    erase_cnt++;
+    return true;
+}
+
+static const mqtt_outbox_storage_t flash_storage = {
+    .read = flash_read,
+    .write = flash_write,
+    .erase = flash_erase,
+    .ctx = flash,
+    .size = FLASH_SIZE,
+    .sector_size = FLASH_SECTOR,
+};
+
+static void test_compaction(void)
+{
+    setup();
+    broker_disconnect();
+    /* 10 presses and 5 temperature changes after each while offline */
+    uint32_t now = 0;
+    for (int i = 0; i < 10; ++i) {
+        assert(add(TOPIC_PRESS, i, false, now++));
+        for (int k = 0; k < 5; ++k) {
+            assert(add(TOPIC_TEMP, 200 + i * 10 + k, true, now++));
+        }
+    }
+    mqtt_outbox_stat_t stat = get_stat();
+    assert(stat.queued_cnt == 11 && stat.compacted_cnt == 49 && stat.dropped_cnt == 0);
+    assert(send_all(now) == 0);
+
+    broker_reconnect();
+    ack_all(1000);
+    assert(mqtt_outbox_is_empty(&outbox));
+    /* The presses in order, the temperature once with its latest value where it was first added */
+    assert(broker.delivered_cnt == 11);
+    assert_delivered(0, TOPIC_PRESS, 0);
+    assert_delivered(1, TOPIC_TEMP, 294);
+    for (int i = 1; i < 10; ++i) {
+        assert_delivered((uint32_t)i + 1, TOPIC_PRESS, i);
+    }
+    stat = get_stat();
+    assert(stat.delivered_cnt == 11 && stat.in_flight_cnt == 0 && stat.queued_cnt == 0);
+    assert(stat.latency_max == 1000 && stat.latency_avg > 950);
+
+    /* A value sent already isn't replaced */
+    assert(add(TOPIC_TEMP, 1, true, 2000));
+    assert(send_all(2000) == 1);
+    assert(add(TOPIC_TEMP, 2, true, 2000));
+    assert(get_stat().compacted_cnt == 49);
+    ack_all(2000);
+    assert(broker.delivered_cnt == 13);
+    assert_delivered(12, TOPIC_TEMP, 2);
+}
+
+static void test_window(void)
+{
+    setup();
+    for (int i = 0; i < 10; ++i) {
+        assert(add(TOPIC_PRESS, i, false, 0));
+    }
+    assert(send_all(0) == MQTT_OUTBOX_WINDOW);
+    assert(broker.pending_cnt == MQTT_OUTBOX_WINDOW);
+    assert(get_stat().in_flight_cnt == MQTT_OUTBOX_WINDOW);
+    mqtt_outbox_msg_t msg;
+    assert(!mqtt_outbox_take(&outbox, &msg));
+
+    /* Every PUBACK lets the next one go */
+    broker_ack(10);
+    assert(send_all(10) == 1);
+    assert(get_stat().in_flight_cnt == MQTT_OUTBOX_WINDOW);
+
+    /* An acknowledgment out of order frees the window too, the others keep waiting */
+    int id = broker.pending[2];
+    memmove(&broker.pending[2], &broker.pending[3], sizeof(broker.pending[0]));
+    broker.pending_cnt--;
+    assert(mqtt_outbox_ack(&outbox, id, 20));
+    assert(send_all(20) == 1);
+
+    ack_all(30);
+    assert(mqtt_outbox_is_empty(&outbox));
+    assert(broker.delivered_cnt == 10);
+    for (int i = 0; i < 10; ++i) {
+        assert_delivered((uint32_t)i, TOPIC_PRESS, i);
+    }
+
+    /* QoS0 messages don't wait for an acknowledgment */
+    for (int i = 0; i < 10; ++i) {
+        assert(add(TOPIC_QOS0, i, false, 40));
+    }
+    assert(send_all(40) == 10);
+    assert(mqtt_outbox_is_empty(&outbox));
+    assert(get_stat().delivered_cnt == 20);
+}
+
+static void test_not_owned(void)
+{
+    setup();
+    assert(add(TOPIC_PRESS, 1, false, 0));
+    assert(send_all(0) == 1);
+
+    /* PUBACKs of messages published without the outbox */
+    assert(!mqtt_outbox_ack(&outbox, 1000, 10));
+    assert(!mqtt_outbox_resend(&outbox, 1000));
+    mqtt_outbox_stat_t stat = get_stat();
+    assert(stat.in_flight_cnt == 1 && stat.delivered_cnt == 0 && stat.resent_cnt == 0);
+
+    assert(mqtt_outbox_ack(&outbox, broker.pending[0], 10));
+    assert(!mqtt_outbox_ack(&outbox, broker.pending[0], 10));
+    assert(mqtt_outbox_is_empty(&outbox));
+    assert(get_stat().delivered_cnt == 1);
+}
+
+static void test_early_ack(void)
+{
+    setup();
+    assert(add(TOPIC_PRESS, 1, false, 0));
+    assert(add(TOPIC_PRESS, 2, false, 0));
+
+    /* The PUBACK is handled before the client returned the message id */
+    mqtt_outbox_msg_t msg;
+    assert(mqtt_outbox_take(&outbox, &msg));
+    assert(!mqtt_outbox_take(&outbox, &msg));
+    assert(!mqtt_outbox_ack(&outbox, 7, 5));
+    mqtt_outbox_sent(&outbox, 7, 10);
+    mqtt_outbox_stat_t stat = get_stat();
+    assert(stat.delivered_cnt == 1 && stat.in_flight_cnt == 0);
+
+    /* Only the id of the message being sent counts */
+    assert(mqtt_outbox_take(&outbox, &msg));
+    assert(msg.payload_len == 1 && msg.payload[0] == '2');
+    assert(!mqtt_outbox_ack(&outbox, 7, 15));
+    mqtt_outbox_sent(&outbox, 8, 20);
+    stat = get_stat();
+    assert(stat.delivered_cnt == 1 && stat.in_flight_cnt == 1);
+    assert(mqtt_outbox_ack(&outbox, 8, 30));
+    assert(mqtt_outbox_is_empty(&outbox));
+
+    /* An acknowledgment while nothing is being sent is not kept */
+    assert(!mqtt_outbox_ack(&outbox, 9, 40));
+    assert(add(TOPIC_PRESS, 3, false, 40));
+    assert(mqtt_outbox_take(&outbox, &msg));
+    mqtt_outbox_sent(&outbox, 9, 50);
+    assert(get_stat().in_flight_cnt == 1);
+}
+
+static void test_refused(void)
+{
+    setup();
+    for (int i = 0; i < 3; ++i) {
+        assert(add(TOPIC_PRESS, i, false, 0));
+    }
+    mqtt_outbox_msg_t msg;
+    assert(mqtt_outbox_take(&outbox, &msg));
+    mqtt_outbox_sent(&outbox, -1, 0);
+    mqtt_outbox_stat_t stat = get_stat();
+    assert(stat.queued_cnt == 3 && stat.in_flight_cnt == 0);
+
+    /* The refused message is taken again first */
+    ack_all(10);
+    assert(broker.delivered_cnt == 3);
+    for (int i = 0; i < 3; ++i) {
+        assert_delivered((uint32_t)i, TOPIC_PRESS, i);
+    }
+    mqtt_outbox_sent(&outbox, 1, 20);
+    assert(mqtt_outbox_is_empty(&outbox));
+}
+
+static void test_reconnect(void)
+{
+    setup();
+    for (int i = 0; i < 6; ++i) {
+        assert(add(TOPIC_PRESS, i, false, 0));
+    }
+    assert(send_all(0) == MQTT_OUTBOX_WINDOW);
+    int old_id = broker.pending[1];
+    broker_ack(10);
+
+    /* The connection drops with 3 messages in flight */
+    broker_disconnect();
+    assert(send_all(20) == 0);
+    broker_reconnect();
+    mqtt_outbox_stat_t stat = get_stat();
+    assert(stat.in_flight_cnt == 0 && stat.queued_cnt == 5);
+
+    /* They are sent again in order, and a late PUBACK of the old connection is ignored */
+    assert(send_all(30) == MQTT_OUTBOX_WINDOW);
+    assert(!mqtt_outbox_ack(&outbox, old_id, 30));
+    ack_all(40);
+    assert(mqtt_outbox_is_empty(&outbox));
+    assert(broker.delivered_cnt == 4 + 5);
+    for (int i = 0; i < 5; ++i) {
+        assert_delivered(4 + (uint32_t)i, TOPIC_PRESS, i + 1);
+    }
+    assert(get_stat().delivered_cnt == 6);
+}
+
+static void test_timeout(void)
+{
+    setup();
+    assert(add(TOPIC_PRESS, 1, false, 0));
+    assert(add(TOPIC_PRESS, 2, false, 0));
+    assert(mqtt_outbox_check_timeouts(&outbox, 0, ACK_TIMEOUT) == MQTT_OUTBOX_IDLE);
+    assert(send_all(0) == 1 + 1);
+    assert(add(TOPIC_PRESS, 3, false, 300));
+    assert(send_all(300) == 1);
+
+    /* The PUBACKs never come */
+    int lost_id = broker.pending[0];
+    broker.pending_cnt = 0;
+    assert(mqtt_outbox_check_timeouts(&outbox, 400, ACK_TIMEOUT) == 600);
+    assert(mqtt_outbox_check_timeouts(&outbox, ACK_TIMEOUT, ACK_TIMEOUT) == 0);
+    mqtt_outbox_stat_t stat = get_stat();
+    assert(stat.resent_cnt == 2 && stat.in_flight_cnt == 1 && stat.queued_cnt == 2);
+    assert(mqtt_outbox_check_timeouts(&outbox, ACK_TIMEOUT, ACK_TIMEOUT) == 300);
+
+    /* Sent again in order; the PUBACK of the first send comes late and is ignored */
+    assert(send_all(ACK_TIMEOUT) == 2);
+    assert(!mqtt_outbox_ack(&outbox, lost_id, ACK_TIMEOUT));
+    ack_all(ACK_TIMEOUT + 10);
+    /* The third one is still waiting */
+    assert(mqtt_outbox_check_timeouts(&outbox, ACK_TIMEOUT + 10, ACK_TIMEOUT) == 300 - 10);
+    assert(broker.delivered_cnt == 5);
+    assert_delivered(3, TOPIC_PRESS, 1);
+    assert_delivered(4, TOPIC_PRESS, 2);
+    assert(get_stat().delivered_cnt == 2);
+
+    /* Timeouts across the wrap-around of the time */
+    setup();
+    assert(add(TOPIC_PRESS, 1, false, UINT32_MAX - 100));
+    assert(send_all(UINT32_MAX - 100) == 1);
+    assert(mqtt_outbox_check_timeouts(&outbox, 100, ACK_TIMEOUT) == ACK_TIMEOUT - 201);
+    assert(mqtt_outbox_check_timeouts(&outbox, ACK_TIMEOUT - 101, ACK_TIMEOUT) == 0);
+}
+
+static void test_deleted(void)
+{
+    setup();
+    for (int i = 0; i < 3; ++i) {
+        assert(add(TOPIC_PRESS, i, false, 0));
+    }
+    assert(send_all(0) == 3);
+
+    /* The client dropped the second message from its own outbox */
+    int deleted_id = broker.pending[1];
+    memmove(&broker.pending[1], &broker.pending[2], sizeof(broker.pending[0]));
+    broker.pending_cnt--;
+    assert(mqtt_outbox_resend(&outbox, deleted_id));
+    assert(!mqtt_outbox_resend(&outbox, deleted_id));
+    mqtt_outbox_stat_t stat = get_stat();
+    assert(stat.resent_cnt == 1 && stat.in_flight_cnt == 2 && stat.queued_cnt == 1);
+
+    ack_all(10);
+    assert(mqtt_outbox_is_empty(&outbox));
+    assert(broker.delivered_cnt == 4);
+    assert_delivered(3, TOPIC_PRESS, 1);
+    assert(get_stat().delivered_cnt == 3);
+}
+
+static void test_overflow(void)
+{
+    setup();
+    broker_disconnect();
+    for (int i = 0; i < MQTT_OUTBOX_LEN + 5; ++i) {
+        assert(add(TOPIC_PRESS, i, false, 0));
+    }
+    mqtt_outbox_stat_t stat = get_stat();
+    assert(stat.dropped_cnt == 5 && stat.queued_cnt == MQTT_OUTBOX_LEN);
+
+    /* The messages in flight are kept, the oldest waiting one is dropped */
+    broker_reconnect();
+    assert(send_all(0) == MQTT_OUTBOX_WINDOW);
+    assert(add(TOPIC_PRESS, 1000, false, 0));
+    assert(get_stat().dropped_cnt == 6);
+    ack_all(10);
+    assert(broker.delivered_cnt == MQTT_OUTBOX_LEN);
+    for (int i = 0; i < MQTT_OUTBOX_WINDOW; ++i) {
+        assert_delivered((uint32_t)i, TOPIC_PRESS, 5 + i);
+    }
+    assert_delivered(MQTT_OUTBOX_WINDOW, TOPIC_PRESS, 5 + MQTT_OUTBOX_WINDOW + 1);
+    assert_delivered(MQTT_OUTBOX_LEN - 1, TOPIC_PRESS, 1000);
+
+    char too_long[MQTT_OUTBOX_MAX_PAYLOAD_LEN + 1] = { 0 };
+    assert(!mqtt_outbox_add(&outbox, TOPIC_PRESS, too_long, sizeof(too_long), false, 0));
+    assert(get_stat().dropped_cnt == 7);
+}
+
+static void test_spill(void)
+{
+    setup();
+    mqtt_outbox_storage_t bad = flash_storage;
+    bad.sector_size = 100;
+    assert(!mqtt_outbox_set_storage(&outbox, &bad));
+    bad = flash_storage;
+    bad.size = FLASH_SECTOR;
+    assert(!mqtt_outbox_set_storage(&outbox, &bad));
+    /* Garbage from a previous boot: sectors are erased before they are written */
+    memset(flash, 0, sizeof(flash));
+    assert(mqtt_outbox_set_storage(&outbox, &flash_storage));
+
+    /* One sector is kept free */
+    const uint32_t capacity = MQTT_OUTBOX_LEN + (FLASH_SIZE - FLASH_SECTOR) / MQTT_OUTBOX_RECORD_SIZE;
+    static broker_msg_t added[2 * MQTT_OUTBOX_LEN + FLASH_SIZE / MQTT_OUTBOX_RECORD_SIZE];
+    int value = 0;
+    for (uint32_t round = 0; round < 8; ++round) {
+        broker_disconnect();
+        broker.delivered_cnt = 0;
+        uint32_t added_cnt = 0;
+        uint32_t press_cnt = capacity - 60 + round * 20;
+        uint32_t dropped = get_stat().dropped_cnt;
+        for (uint32_t i = 0; i < press_cnt; ++i) {
+            added[added_cnt].topic = TOPIC_PRESS;
+            snprintf(added[added_cnt++].payload, sizeof(added[0].payload), "%d", value);
+            assert(add(TOPIC_PRESS, value++, false, round));
+            spill_all();
+            /* Spilled values are not compacted, to keep their order */
+            if (i == MQTT_OUTBOX_LEN + 3) {
+                for (int k = 0; k < 2; ++k) {
+                    added[added_cnt].topic = TOPIC_TEMP;
+                    snprintf(added[added_cnt++].payload, sizeof(added[0].payload), "%d", k);
+                    assert(add(TOPIC_TEMP, k, true, round));
+                    spill_all();
+                }
+            }
+        }
+        mqtt_outbox_stat_t stat = get_stat();
+        uint32_t kept = added_cnt < capacity ? added_cnt : capacity;
+        assert(stat.queued_cnt == kept);
+        assert(stat.spilled_cnt == kept - MQTT_OUTBOX_LEN);
+        assert(stat.dropped_cnt - dropped == added_cnt - kept);
+        assert(stat.compacted_cnt == 0);
+
+        /* The newest ones are delivered in order, refilling the ring from the flash */
+        broker_reconnect();
+        ack_all(round);
+        assert(mqtt_outbox_is_empty(&outbox));
+        assert(broker.delivered_cnt == kept);
+        for (uint32_t i = 0; i < kept; ++i) {
+            const broker_msg_t *expected = &added[added_cnt - kept + i];
+            assert(broker.delivered[i].topic == expected->topic);
+            assert(strcmp(broker.delivered[i].payload, expected->payload) == 0);
+        }
+    }
+    printf("%u sector erases\n", (unsigned)erase_cnt);
+    assert(erase_cnt > 0);
+}
+
+/* The flash is written by the publish task, which may fall behind the publishers */
+static void test_spill_behind(void)
+{
+    setup();
+    assert(mqtt_outbox_set_storage(&outbox, &flash_storage));
+    broker_disconnect();
+
+    /* Adding never touches the flash */
+    uint32_t writes = write_cnt;
+    uint32_t erases = erase_cnt;
+    int value = 0;
+    for (int i = 0; i < MQTT_OUTBOX_LEN + MQTT_OUTBOX_SPILL_LEN; ++i) {
+        assert(add(TOPIC_PRESS, value++, false, 0));
+    }
+    mqtt_outbox_stat_t stat = get_stat();
+    assert(stat.queued_cnt == MQTT_OUTBOX_LEN + MQTT_OUTBOX_SPILL_LEN && stat.spilled_cnt == MQTT_OUTBOX_SPILL_LEN);
+    assert(write_cnt == writes && erase_cnt == erases);
+    /* Nothing written yet: the oldest waiting one is dropped, the first one for the flash moves to RAM */
+    assert(add(TOPIC_PRESS, value++, false, 0));
+    stat = get_stat();
+    assert(stat.dropped_cnt == 1 && stat.spilled_cnt == MQTT_OUTBOX_SPILL_LEN);
+
+    /* Adding, sending and acknowledging go on while a message is written.
+     * The ring has space again, so the one being written moves to RAM. */
+    mqtt_outbox_spill_t spill;
+    assert(mqtt_outbox_spill_take(&outbox, &spill));
+    assert(!mqtt_outbox_spill_take(&outbox, &spill));
+    assert(add(TOPIC_PRESS, value++, false, 1));
+    assert(get_stat().dropped_cnt == 2);
+    broker_reconnect();
+    ack_all(1);
+    assert(mqtt_outbox_is_empty(&outbox));
+    assert(mqtt_outbox_spill_write(&outbox, &spill));
+    mqtt_outbox_spill_done(&outbox, true);
+    assert(write_cnt == writes + 1);
+    assert(get_stat().spilled_cnt == 0);
+
+    /* The skipped record isn't read back */
+    broker_disconnect();
+    for (int i = 0; i < MQTT_OUTBOX_LEN + 3; ++i) {
+        assert(add(TOPIC_PRESS, value++, false, 2));
+    }
+    spill_all();
+    assert(get_stat().spilled_cnt == 3 && write_cnt == writes + 4);
+    broker_reconnect();
+    ack_all(2);
+    assert(mqtt_outbox_is_empty(&outbox));
+
+    /* In order, without the dropped ones */
+    for (uint32_t i = 0; i < broker.delivered_cnt; ++i) {
+        assert_delivered(i, TOPIC_PRESS, 2 + (int)i);
+    }
+    assert(broker.delivered_cnt == (uint32_t)value - 2);
+
+    /* A message which can't be written is dropped */
+    broker_disconnect();
+    for (int i = 0; i < MQTT_OUTBOX_LEN + 1; ++i) {
+        assert(add(TOPIC_PRESS, value++, false, 3));
+    }
+    flash_fail = true;
+    spill_all();
+    flash_fail = false;
+    stat = get_stat();
+    assert(stat.dropped_cnt == 3 && stat.queued_cnt == MQTT_OUTBOX_LEN && stat.spilled_cnt == 0);
+}
+
+static void test_random(void)
+{
+    setup();
+    assert(mqtt_outbox_set_storage(&outbox, &flash_storage));
+    srand(1);
+    static bool seen[60000];
+    memset(seen, 0, sizeof(seen));
+    int value = 0;
+    uint32_t now = 0;
+    /* A write to the flash spanning steps, as if the publish task were preempted */
+    mqtt_outbox_spill_t spill;
+    bool spilling = false;
+    for (int step = 0; step < 200000 && value < 60000; ++step, now += 3) {
+        int r = rand() % 100;
+        if (r >= 60 && r < 65) {
+            if (!spilling) {
+                spilling = mqtt_outbox_spill_take(&outbox, &spill);
+            } else {
+                mqtt_outbox_spill_done(&outbox, rand() % 20 && mqtt_outbox_spill_write(&outbox, &spill));
+                spilling = false;
+            }
+            continue;
+        }
+        if (r < 15) {
+            assert(add(TOPIC_PRESS, value++, false, now));
+        } else if (r < 17) {
+            if (broker.online) {
+                broker_disconnect();
+            } else {
+                broker_reconnect();
+            }
+        } else if (r < 60) {
+            send_all(now);
+        } else if (r < 90) {
+            if (broker.online && broker.pending_cnt > 0) {
+                broker_ack(now);
+            }
+        } else if (r < 91) {
+            /* A PUBACK lost without losing the connection */
+            if (broker.pending_cnt > 0) {
+                memmove(broker.pending, broker.pending + 1, --broker.pending_cnt * sizeof(broker.pending[0]));
+            }
+        } else {
+            mqtt_outbox_check_timeouts(&outbox, now, ACK_TIMEOUT);
+        }
+        mqtt_outbox_stat_t stat = get_stat();
+        assert(stat.in_flight_cnt <= MQTT_OUTBOX_WINDOW);
+        assert(stat.queued_cnt + stat.in_flight_cnt <=
+               MQTT_OUTBOX_LEN + MQTT_OUTBOX_SPILL_LEN + (FLASH_SIZE - FLASH_SECTOR) / MQTT_OUTBOX_RECORD_SIZE);
+        for (uint32_t i = 0; i < broker.delivered_cnt; ++i) {
+            int v = atoi(broker.delivered[i].payload);
+            assert(v >= 0 && v < value);
+            seen[v] = true;
+        }
+        broker.delivered_cnt = 0;
+    }
+
+    /* Everything not dropped arrives at last */
+    if (spilling) {
+        mqtt_outbox_spill_done(&outbox, mqtt_outbox_spill_write(&outbox, &spill));
+    }
+    if (!broker.online) {
+        broker_reconnect();
+    }
+    while (!mqtt_outbox_is_empty(&outbox)) {
+        now += ACK_TIMEOUT;
+        mqtt_outbox_check_timeouts(&outbox, now, ACK_TIMEOUT);
+        ack_all(now);
+    }
+    for (uint32_t i = 0; i < broker.delivered_cnt; ++i) {
+        seen[atoi(broker.delivered[i].payload)] = true;
+    }
+    mqtt_outbox_stat_t stat = get_stat();
+    uint32_t seen_cnt = 0;
+    for (int i = 0; i < value; ++i) {
+        seen_cnt += seen[i];
+    }
+    printf("%d messages: %u delivered, %u dropped, %u resent\n", value, (unsigned)seen_cnt,
+           (unsigned)stat.dropped_cnt, (unsigned)stat.resent_cnt);
+    /* A message delivered without its PUBACK can be dropped while waiting to be sent again,
+     * so it's counted in both */
+    assert((uint32_t)value - seen_cnt <= stat.dropped_cnt);
+    assert(stat.dropped_cnt <= (uint32_t)value);
+    assert(stat.resent_cnt > 0);
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    RUN(test_compaction);
+    RUN(test_window);
+    RUN(test_not_owned);
+    RUN(test_early_ack);
+    RUN(test_refused);
+    RUN(test_reconnect);
+    RUN(test_timeout);
+    RUN(test_deleted);
+    RUN(test_overflow);
+    RUN(test_spill);
+    RUN(test_spill_behind);
+    RUN(test_random);
+    return 0;
+}
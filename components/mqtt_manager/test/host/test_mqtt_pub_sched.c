@@ -0,0 +1,254 @@
+/* Rate limiting and coalescing of the publish scheduler against a broker stand-in */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mqtt_pub_sched.h"
+
+#define BROKER_LOG_LEN  64
+
+/* Messages received by the broker, in order */
+typedef struct {
+    int topic;
+    uint32_t time;
+    char payload[MQTT_PUB_SCHED_MAX_PAYLOAD_LEN + 1];
+} broker_msg_t;
+
+static mqtt_pub_sched_t sched;
+static broker_msg_t broker_log[BROKER_LOG_LEN];
+static uint32_t broker_cnt;
+static bool broker_online;
+static uint32_t now;
+
+static bool broker_send(int topic, const char *payload, size_t payload_len, void *ctx)
+{
+    assert(ctx == &sched);
+    assert(topic >= 0 && topic < sched.topic_cnt);
+    if (!broker_online) {
+        return false;
+    }
+    assert(broker_cnt < BROKER_LOG_LEN);
+    broker_msg_t *msg = &broker_log[broker_cnt++];
+    msg->topic = topic;
+    msg->time = now;
+    memcpy(msg->payload, payload, payload_len);
+    msg->payload[payload_len] = '\0';
+    return true;
+}
+
+static void setup(void)
+{
+    mqtt_pub_sched_init(&sched, broker_send, &sched);
+    broker_cnt = 0;
+    broker_online = true;
+    now = 1000;
+}
+
+static void publish(int topic, const char *payload)
+{
+    assert(mqtt_pub_sched_publish(&sched, topic, payload, strlen(payload), now));
+}
+
+/* Run the clock to `end` flushing when the scheduler asks to, as the publish task does */
+static void run_until(uint32_t end, uint32_t *due)
+{
+    while (*due != MQTT_PUB_SCHED_IDLE && *due <= end) {
+        now = *due;
+        uint32_t wait = mqtt_pub_sched_flush(&sched, now);
+        *due = wait == MQTT_PUB_SCHED_IDLE ? wait : now + wait;
+    }
+    now = end;
+}
+
+static void test_topics(void)
+{
+    setup();
+    int temp = mqtt_pub_sched_add_topic(&sched, "esp32lvgl/buttons", "hvac/temp_set", 1, 200);
+    int out = mqtt_pub_sched_add_topic(&sched, NULL, "TempOut", 0, 0);
+    int play = mqtt_pub_sched_add_topic(&sched, "", "media/play", 1, 0);
+    assert(temp == 0 && out == 1 && play == 2);
+    assert(strcmp(mqtt_pub_sched_get_topic(&sched, temp), "esp32lvgl/buttons/hvac/temp_set") == 0);
+    assert(strcmp(mqtt_pub_sched_get_topic(&sched, out), "TempOut") == 0);
+    assert(strcmp(mqtt_pub_sched_get_topic(&sched, play), "media/play") == 0);
+    assert(sched.topics[temp].qos == 1 && sched.topics[out].qos == 0);
+
+    assert(mqtt_pub_sched_add_topic(&sched, "p", "", 0, 0) == -1);
+    assert(mqtt_pub_sched_add_topic(&sched, "p", NULL, 0, 0) == -1);
+    assert(!mqtt_pub_sched_publish(&sched, -1, "x", 1, now));
+    assert(!mqtt_pub_sched_publish(&sched, sched.topic_cnt, "x", 1, now));
+
+    /* Full: no half added topic is left behind */
+    while (sched.topic_cnt < MQTT_PUB_SCHED_MAX_TOPICS) {
+        assert(mqtt_pub_sched_add_topic(&sched, NULL, "t", 0, 0) >= 0);
+    }
+    uint16_t pool_used = sched.topic_pool_used;
+    assert(mqtt_pub_sched_add_topic(&sched, NULL, "t", 0, 0) == -1);
+    assert(sched.topic_pool_used == pool_used);
+
+    static char long_name[MQTT_PUB_SCHED_TOPIC_POOL_SIZE + 1];
+    memset(long_name, 'a', sizeof(long_name) - 1);
+    setup();
+    assert(mqtt_pub_sched_add_topic(&sched, NULL, long_name, 0, 0) == -1);
+    assert(sched.topic_pool_used == 0 && sched.topic_cnt == 0);
+}
+
+static void test_unlimited(void)
+{
+    setup();
+    int play = mqtt_pub_sched_add_topic(&sched, "b", "media/play", 1, 0);
+    for (int i = 0; i < 5; ++i) {
+        publish(play, i % 2 ? "stop" : "play");
+    }
+    assert(broker_cnt == 5);
+    assert(strcmp(broker_log[4].payload, "play") == 0);
+    assert(mqtt_pub_sched_flush(&sched, now) == MQTT_PUB_SCHED_IDLE);
+    assert(sched.stat.sent_cnt == 5 && sched.stat.coalesced_cnt == 0 && sched.stat.dropped_cnt == 0);
+}
+
+static void test_rate_limit(void)
+{
+    setup();
+    int temp = mqtt_pub_sched_add_topic(&sched, "b", "hvac/temp_set", 1, 200);
+
+    /* The first value is sent at once (leading edge) */
+    publish(temp, "20");
+    assert(broker_cnt == 1 && broker_log[0].time == 1000);
+
+    /* The next ones wait for the interval and only the last one is kept */
+    now = 1050;
+    publish(temp, "21");
+    now = 1100;
+    publish(temp, "22");
+    assert(broker_cnt == 1);
+    assert(sched.stat.coalesced_cnt == 1);
+    assert(mqtt_pub_sched_flush(&sched, now) == 100);
+
+    /* Trailing edge: published when the interval ends even without a new value */
+    assert(mqtt_pub_sched_flush(&sched, 1199) == 1);
+    assert(broker_cnt == 1);
+    now = 1200;
+    assert(mqtt_pub_sched_flush(&sched, now) == MQTT_PUB_SCHED_IDLE);
+    assert(broker_cnt == 2);
+    assert(strcmp(broker_log[1].payload, "22") == 0 && broker_log[1].time == 1200);
+
+    /* A value after a quiet interval is sent at once again */
+    now = 1500;
+    publish(temp, "23");
+    assert(broker_cnt == 3 && broker_log[2].time == 1500);
+    assert(sched.stat.sent_cnt == 3 && sched.stat.coalesced_cnt == 1 && sched.stat.dropped_cnt == 0);
+}
+
+static void test_drag(void)
+{
+    setup();
+    int temp = mqtt_pub_sched_add_topic(&sched, "b", "hvac/temp_set", 1, 200);
+    int play = mqtt_pub_sched_add_topic(&sched, "b", "media/play", 1, 0);
+
+    /* 2 s drag changing the value every frame, with a button pressed meanwhile */
+    uint32_t due = MQTT_PUB_SCHED_IDLE;
+    uint32_t event_cnt = 0;
+    char payload[8];
+    for (uint32_t t = 0; t < 2000; t += 16) {
+        run_until(1000 + t, &due);
+        snprintf(payload, sizeof(payload), "%u", (unsigned)(160 + t / 10));
+        publish(temp, payload);
+        event_cnt++;
+        if (t == 512) {
+            publish(play, "play");
+            event_cnt++;
+        }
+        uint32_t wait = mqtt_pub_sched_flush(&sched, now);
+        due = wait == MQTT_PUB_SCHED_IDLE ? wait : now + wait;
+    }
+    run_until(UINT32_MAX - 1, &due);
+    assert(due == MQTT_PUB_SCHED_IDLE);
+
+    /* Every value was either sent or replaced by a newer one */
+    assert(sched.stat.sent_cnt + sched.stat.coalesced_cnt == event_cnt);
+    assert(sched.stat.dropped_cnt == 0);
+    assert(broker_cnt == sched.stat.sent_cnt);
+
+    /* At most one message every 200 ms, and the last value arrived */
+    uint32_t temp_cnt = 0;
+    uint32_t last_time = 0;
+    const char *last = NULL;
+    for (uint32_t i = 0; i < broker_cnt; ++i) {
+        if (broker_log[i].topic != temp) {
+            assert(strcmp(broker_log[i].payload, "play") == 0 && broker_log[i].time == 1512);
+            continue;
+        }
+        assert(temp_cnt == 0 || broker_log[i].time - last_time >= 200);
+        last_time = broker_log[i].time;
+        last = broker_log[i].payload;
+        temp_cnt++;
+    }
+    snprintf(payload, sizeof(payload), "%u", (unsigned)(160 + 1984 / 10));
+    assert(strcmp(last, payload) == 0);
+    assert(temp_cnt <= 2000 / 200 + 1);
+    assert(temp_cnt >= 2000 / 200);
+    printf("%u events -> %u messages\n", (unsigned)event_cnt, (unsigned)broker_cnt);
+}
+
+static void test_dropped(void)
+{
+    setup();
+    int temp = mqtt_pub_sched_add_topic(&sched, "b", "hvac/temp_set", 1, 200);
+
+    char too_long[MQTT_PUB_SCHED_MAX_PAYLOAD_LEN + 1];
+    memset(too_long, '9', sizeof(too_long));
+    assert(!mqtt_pub_sched_publish(&sched, temp, too_long, sizeof(too_long), now));
+    assert(sched.stat.dropped_cnt == 1);
+    assert(mqtt_pub_sched_publish(&sched, temp, too_long, MQTT_PUB_SCHED_MAX_PAYLOAD_LEN, now));
+    assert(broker_cnt == 1 && strlen(broker_log[0].payload) == MQTT_PUB_SCHED_MAX_PAYLOAD_LEN);
+
+    /* Refused values are dropped, and start the interval so the client is not hammered */
+    broker_online = false;
+    now = 1200;
+    publish(temp, "21");
+    assert(sched.stat.dropped_cnt == 2);
+    now = 1300;
+    publish(temp, "22");
+    assert(sched.stat.dropped_cnt == 2);
+    broker_online = true;
+    assert(mqtt_pub_sched_flush(&sched, now) == 100);
+    assert(mqtt_pub_sched_flush(&sched, 1400) == MQTT_PUB_SCHED_IDLE);
+    assert(broker_cnt == 2 && strcmp(broker_log[1].payload, "22") == 0);
+    assert(sched.stat.sent_cnt == 2 && sched.stat.coalesced_cnt == 0 && sched.stat.dropped_cnt == 2);
+}
+
+static void test_time_wrap(void)
+{
+    setup();
+    int a = mqtt_pub_sched_add_topic(&sched, "p", "a", 0, 100);
+    int b = mqtt_pub_sched_add_topic(&sched, "p", "b", 0, 30);
+
+    now = UINT32_MAX - 10;
+    publish(a, "1");
+    publish(b, "1");
+    now = UINT32_MAX - 5;
+    publish(a, "2");
+    publish(b, "2");
+    /* The soonest due topic decides the wait */
+    assert(mqtt_pub_sched_flush(&sched, now) == 25);
+    now += 25;
+    assert(now == 19);
+    assert(mqtt_pub_sched_flush(&sched, now) == 70);
+    assert(broker_cnt == 3 && broker_log[2].topic == b);
+    assert(mqtt_pub_sched_flush(&sched, 89) == MQTT_PUB_SCHED_IDLE);
+    assert(broker_cnt == 4 && broker_log[3].topic == a);
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    RUN(test_topics);
+    RUN(test_unlimited);
+    RUN(test_rate_limit);
+    RUN(test_drag);
+    RUN(test_dropped);
+    RUN(test_time_wrap);
+    return 0;
+}
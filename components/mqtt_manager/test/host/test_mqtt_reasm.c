@@ -0,0 +1,465 @@
+/* Reassembly of fragmented messages fed by a broker stand-in, with lost, reordered and oversized fragments */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mqtt_reasm.h"
+#include "mqtt_router.h"
+
+#define MAX_LEN         100000
+#define DATA_LEN        250000
+#define MAX_FRAGS       1024
+#define CLIENT_BUF_LEN  4096
+
+/* The fragments of one message as the client reports them */
+typedef struct {
+    mqtt_reasm_fragment_t frags[MAX_FRAGS];
+    int cnt;
+} message_t;
+
+/* What the handlers saw */
+typedef struct {
+    uint32_t whole_cnt;
+    const char *whole_ptr;
+    size_t whole_len;
+    char whole[MAX_LEN];
+    uint32_t chunk_cnt;
+    uint32_t stream_done_cnt;
+    size_t streamed_len;
+    char streamed[DATA_LEN];
+} sink_t;
+
+static mqtt_router_t router;
+static mqtt_reasm_t reasm;
+static sink_t sink;
+static char data[DATA_LEN];
+static char client_buf[CLIENT_BUF_LEN];     /* Reused by the client for every fragment */
+static uint32_t seed = 1;
+
+/* PSRAM pool stand-in with a byte budget */
+static struct {
+    size_t budget;
+    size_t used;
+    uint32_t alloc_cnt;
+    uint32_t fail_cnt;
+} pool;
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) | (seed << 16);
+}
+
+static void *pool_alloc(size_t size, void *ctx)
+{
+    assert(ctx == &pool);
+    if (size > pool.budget - pool.used) {
+        pool.fail_cnt++;
+        return NULL;
+    }
+    size_t *block = malloc(sizeof(size_t) + size);
+    assert(block);
+    *block = size;
+    pool.used += size;
+    pool.alloc_cnt++;
+    return block + 1;
+}
+
+static void pool_free(void *ptr, void *ctx)
+{
+    assert(ctx == &pool);
+    size_t *block = (size_t *)ptr - 1;
+    assert(pool.used >= *block);
+    pool.used -= *block;
+    free(block);
+}
+
+static void whole_cb(mqtt_router_view_t topic, mqtt_router_view_t payload, void *ctx)
+{
+    (void)topic;
+    (void)ctx;
+    assert(payload.len <= MAX_LEN);
+    sink.whole_cnt++;
+    sink.whole_ptr = payload.ptr;
+    sink.whole_len = payload.len;
+    memcpy(sink.whole, payload.ptr, payload.len);
+}
+
+static void stream_cb(mqtt_router_view_t topic, const mqtt_router_chunk_t *chunk, void *ctx)
+{
+    (void)topic;
+    (void)ctx;
+    sink.chunk_cnt++;
+    if (chunk->offset == 0) {
+        sink.streamed_len = 0;
+    }
+    /* The chunks of a message come in order and without gaps */
+    assert(chunk->offset == sink.streamed_len);
+    assert(chunk->offset + chunk->data.len <= chunk->total_len && chunk->total_len <= DATA_LEN);
+    memcpy(&sink.streamed[chunk->offset], chunk->data.ptr, chunk->data.len);
+    sink.streamed_len += chunk->data.len;
+    if (sink.streamed_len == chunk->total_len) {
+        sink.stream_done_cnt++;
+    }
+}
+
+static void setup(size_t pool_budget)
+{
+    mqtt_reasm_deinit(&reasm);
+    assert(pool.used == 0);
+    memset(&pool, 0, sizeof(pool));
+    pool.budget = pool_budget;
+    memset(&sink, 0, sizeof(sink));
+    mqtt_router_init(&router);
+    mqtt_reasm_init(&reasm, MAX_LEN, pool_alloc, pool_free, &pool);
+    assert(mqtt_router_add(&router, "img/whole", 1, whole_cb, NULL) >= 0);
+    assert(mqtt_router_add_stream(&router, "img/+", 1, stream_cb, NULL) >= 0);
+    assert(mqtt_router_add_stream(&router, "art", 1, stream_cb, NULL) >= 0);
+}
+
+/* The manager's receive path */
+static mqtt_reasm_state_t receive(const mqtt_reasm_fragment_t *frag)
+{
+    assert(frag->data_len <= sizeof(client_buf));
+    memcpy(client_buf, frag->data, frag->data_len);
+    mqtt_reasm_fragment_t copy = *frag;
+    copy.data = client_buf;
+
+    mqtt_router_view_t topic;
+    mqtt_router_view_t payload;
+    bool keep = mqtt_reasm_is_first(&copy) && !mqtt_reasm_is_whole(&copy) && copy.topic &&
+                mqtt_router_count(&router, copy.topic, copy.topic_len, false) > 0;
+    mqtt_reasm_state_t state = mqtt_reasm_feed(&reasm, &copy, keep, &topic, &payload);
+    if (topic.ptr) {
+        const mqtt_router_chunk_t chunk = {
+            .data = { copy.data, copy.data_len },
+            .offset = copy.offset,
+            .total_len = copy.total_len,
+        };
+        mqtt_router_dispatch_chunk(&router, topic.ptr, topic.len, &chunk);
+    }
+    if (state == MQTT_REASM_COMPLETE) {
+        mqtt_router_dispatch(&router, topic.ptr, topic.len, payload.ptr, payload.len);
+    } else {
+        assert(payload.ptr == NULL);
+    }
+    return state;
+}
+
+/* Broker stand-in: the message is read through a `buf_len` buffer, the first piece also holds the topic */
+static void fragment(message_t *msg, const char *topic, const char *payload, size_t len, size_t buf_len)
+{
+    size_t topic_len = strlen(topic);
+    size_t first = buf_len - topic_len - 8;
+    size_t offset = 0;
+    msg->cnt = 0;
+    do {
+        size_t n = len - offset;
+        size_t max = offset == 0 ? first : buf_len;
+        n = n < max ? n : max;
+        assert(msg->cnt < MAX_FRAGS);
+        msg->frags[msg->cnt++] = (mqtt_reasm_fragment_t) {
+            .topic = offset == 0 ? topic : NULL,
+            .topic_len = offset == 0 ? topic_len : 0,
+            .data = payload + offset,
+            .data_len = n,
+            .offset = offset,
+            .total_len = len,
+        };
+        offset += n;
+    } while (offset < len);
+}
+
+static void deliver(const message_t *msg)
+{
+    for (int i = 0; i < msg->cnt; ++i) {
+        receive(&msg->frags[i]);
+    }
+}
+
+static void publish(const char *topic, const char *payload, size_t len, size_t buf_len)
+{
+    static message_t msg;
+    fragment(&msg, topic, payload, len, buf_len);
+    deliver(&msg);
+}
+
+static void test_unfragmented(void)
+{
+    setup(SIZE_MAX);
+    mqtt_reasm_fragment_t frag = { "img/whole", 9, data, 100, 0, 100 };
+    assert(receive(&frag) == MQTT_REASM_COMPLETE);
+    /* Straight from the client's buffer, nothing allocated */
+    assert(sink.whole_cnt == 1 && sink.whole_len == 100 && sink.whole_ptr == client_buf);
+    assert(memcmp(sink.whole, data, 100) == 0);
+    assert(sink.stream_done_cnt == 1 && pool.alloc_cnt == 0);
+
+    /* Empty message */
+    frag = (mqtt_reasm_fragment_t) { "img/whole", 9, data, 0, 0, 0 };
+    assert(receive(&frag) == MQTT_REASM_COMPLETE);
+    assert(sink.whole_cnt == 2 && sink.whole_len == 0);
+    assert(reasm.stat.msg_cnt == 2 && reasm.stat.reassembled_cnt == 0);
+}
+
+static void test_reassembly(void)
+{
+    setup(SIZE_MAX);
+    publish("img/whole", data, 50000, 1024);
+    assert(sink.whole_cnt == 1 && sink.whole_len == 50000 && memcmp(sink.whole, data, 50000) == 0);
+    assert(sink.stream_done_cnt == 1 && memcmp(sink.streamed, data, 50000) == 0);
+    assert(pool.alloc_cnt == 1 && reasm.stat.buf_size == 50000);
+
+    /* Shorter: the buffer is reused */
+    publish("img/whole", data + 3, 30000, 700);
+    assert(sink.whole_cnt == 2 && memcmp(sink.whole, data + 3, 30000) == 0);
+    assert(pool.alloc_cnt == 1);
+
+    /* Longer: replaced, never two buffers at once */
+    publish("img/whole", data + 5, MAX_LEN, 4096);
+    assert(sink.whole_cnt == 3 && sink.whole_len == MAX_LEN && memcmp(sink.whole, data + 5, MAX_LEN) == 0);
+    assert(pool.alloc_cnt == 2 && pool.used == MAX_LEN && reasm.stat.buf_size == MAX_LEN);
+
+    /* Stream only: not copied, whatever the length */
+    publish("art", data, DATA_LEN, 4096);
+    assert(sink.stream_done_cnt == 4 && memcmp(sink.streamed, data, DATA_LEN) == 0);
+    assert(sink.whole_cnt == 3 && pool.alloc_cnt == 2);
+    assert(reasm.stat.msg_cnt == 4 && reasm.stat.reassembled_cnt == 3 && reasm.stat.broken_cnt == 0);
+
+    mqtt_reasm_deinit(&reasm);
+    assert(pool.used == 0 && reasm.stat.buf_size == 0);
+}
+
+static void test_out_of_order(void)
+{
+    static message_t msg;
+    setup(SIZE_MAX);
+    fragment(&msg, "img/whole", data, 20000, 1024);
+
+    /* Two fragments swapped: dropped from the first misplaced one on, not reassembled wrong */
+    mqtt_reasm_fragment_t tmp = msg.frags[5];
+    msg.frags[5] = msg.frags[6];
+    msg.frags[6] = tmp;
+    deliver(&msg);
+    assert(sink.whole_cnt == 0 && sink.stream_done_cnt == 0);
+    assert(sink.chunk_cnt == 5 && reasm.stat.broken_cnt == 1);
+
+    /* A repeated fragment */
+    fragment(&msg, "img/whole", data, 20000, 1024);
+    msg.frags[8] = msg.frags[7];
+    deliver(&msg);
+    assert(sink.whole_cnt == 0 && reasm.stat.broken_cnt == 2);
+
+    /* A missing one */
+    fragment(&msg, "img/whole", data, 20000, 1024);
+    memmove(&msg.frags[3], &msg.frags[4], (size_t)(msg.cnt - 4) * sizeof(msg.frags[0]));
+    msg.cnt--;
+    deliver(&msg);
+    assert(sink.whole_cnt == 0 && reasm.stat.broken_cnt == 3);
+
+    /* A fragment of another message with the same offset */
+    fragment(&msg, "img/whole", data, 20000, 1024);
+    msg.frags[2].total_len++;
+    deliver(&msg);
+    assert(sink.whole_cnt == 0 && reasm.stat.broken_cnt == 4);
+
+    /* The next message is fine */
+    publish("img/whole", data + 1, 20000, 1024);
+    assert(sink.whole_cnt == 1 && sink.stream_done_cnt == 1 && memcmp(sink.whole, data + 1, 20000) == 0);
+    assert(reasm.stat.reassembled_cnt == 1 && reasm.stat.broken_cnt == 4);
+}
+
+static void test_oversized(void)
+{
+    static message_t msg;
+    setup(SIZE_MAX);
+
+    /* Over the limit: not kept, still streamed */
+    publish("img/whole", data, MAX_LEN + 1, 4096);
+    assert(sink.whole_cnt == 0 && sink.stream_done_cnt == 1 && pool.alloc_cnt == 0);
+    assert(reasm.stat.too_long_cnt == 1 && reasm.stat.broken_cnt == 0);
+
+    /* A fragment running past the announced length */
+    fragment(&msg, "img/whole", data, 20000, 1024);
+    msg.frags[msg.cnt - 1].data_len++;
+    mqtt_reasm_fragment_t last = msg.frags[msg.cnt - 1];
+    msg.cnt--;
+    deliver(&msg);
+    assert(receive(&last) == MQTT_REASM_SKIPPED);
+    assert(sink.whole_cnt == 0 && sink.stream_done_cnt == 1 && reasm.stat.broken_cnt == 1);
+
+    /* Already the first one */
+    fragment(&msg, "img/whole", data, 20000, 1024);
+    msg.frags[0].total_len = 10;
+    assert(receive(&msg.frags[0]) == MQTT_REASM_SKIPPED);
+    assert(reasm.stat.broken_cnt == 2);
+
+    /* A topic too long to keep: neither kept nor streamed */
+    static char long_topic[MQTT_REASM_MAX_TOPIC_LEN + 2];
+    memset(long_topic, 'a', sizeof(long_topic) - 1);
+    memcpy(long_topic, "img/", 4);
+    uint32_t chunk_cnt = sink.chunk_cnt;
+    publish(long_topic, data, 20000, 1024);
+    assert(sink.chunk_cnt == chunk_cnt && reasm.stat.broken_cnt == 3);
+
+    /* The longest one kept */
+    long_topic[MQTT_REASM_MAX_TOPIC_LEN] = '\0';
+    publish(long_topic, data, 20000, 1024);
+    assert(sink.stream_done_cnt == 2 && reasm.stat.broken_cnt == 3);
+}
+
+static void test_abort(void)
+{
+    static message_t msg;
+    setup(SIZE_MAX);
+
+    /* The end of a message lost, and the next one starts */
+    fragment(&msg, "img/whole", data, 20000, 1024);
+    msg.cnt -= 2;
+    deliver(&msg);
+    publish("img/whole", data + 1, 5000, 1024);
+    assert(sink.whole_cnt == 1 && memcmp(sink.whole, data + 1, 5000) == 0);
+    assert(reasm.stat.broken_cnt == 1);
+
+    /* Cut by an unfragmented message */
+    deliver(&msg);
+    publish("img/whole", data + 2, 100, 1024);
+    assert(sink.whole_cnt == 2 && sink.whole_len == 100 && reasm.stat.broken_cnt == 2);
+
+    /* Continuations without their first fragment have no topic */
+    fragment(&msg, "img/whole", data, 20000, 1024);
+    uint32_t chunk_cnt = sink.chunk_cnt;
+    for (int i = 1; i < msg.cnt; ++i) {
+        mqtt_router_view_t topic;
+        mqtt_router_view_t payload;
+        assert(mqtt_reasm_feed(&reasm, &msg.frags[i], false, &topic, &payload) == MQTT_REASM_SKIPPED);
+        assert(topic.ptr == NULL && topic.len == 0 && payload.ptr == NULL);
+    }
+    assert(sink.chunk_cnt == chunk_cnt && reasm.stat.broken_cnt == 2);
+
+    /* Disconnected in the middle of a message: the buffer is freed and nothing is left active */
+    msg.cnt /= 2;
+    deliver(&msg);
+    assert(reasm.active && pool.used > 0);
+    mqtt_reasm_deinit(&reasm);
+    assert(!reasm.active && pool.used == 0);
+    fragment(&msg, "img/whole", data, 20000, 1024);
+    assert(receive(&msg.frags[msg.cnt - 1]) == MQTT_REASM_SKIPPED);
+    publish("img/whole", data + 3, 20000, 1024);
+    assert(sink.whole_cnt == 3 && memcmp(sink.whole, data + 3, 20000) == 0);
+}
+
+static void test_pool_exhaustion(void)
+{
+    /* Room for a 60 kB buffer, then the other users of the pool take most of it */
+    setup(60000);
+    publish("img/whole", data, 40000, 2048);
+    assert(sink.whole_cnt == 1 && pool.used == 40000);
+
+    /* Growing fails: the message is streamed but not kept, and the old buffer is gone too */
+    publish("img/whole", data, 70000, 2048);
+    assert(sink.whole_cnt == 1 && sink.stream_done_cnt == 2);
+    assert(reasm.stat.no_mem_cnt == 1 && pool.fail_cnt == 1);
+    assert(pool.used == 0 && reasm.stat.buf_size == 0);
+
+    /* The memory is back to the pool for the others, and a later message gets a buffer again */
+    pool.budget = 20000;
+    publish("img/whole", data + 1, 30000, 2048);
+    assert(sink.whole_cnt == 1 && reasm.stat.no_mem_cnt == 2);
+    publish("img/whole", data + 2, 15000, 2048);
+    assert(sink.whole_cnt == 2 && memcmp(sink.whole, data + 2, 15000) == 0 && pool.used == 15000);
+    assert(sink.stream_done_cnt == 4);
+
+    /* Exhausted for good: every fragmented message still reaches the streams */
+    pool.budget = 0;
+    mqtt_reasm_deinit(&reasm);
+    for (int i = 0; i < 10; ++i) {
+        publish("img/whole", data + i, 10000 + (size_t)i, 2048);
+        assert(sink.streamed_len == 10000 + (size_t)i && memcmp(sink.streamed, data + i, sink.streamed_len) == 0);
+    }
+    assert(sink.whole_cnt == 2 && sink.stream_done_cnt == 14 && reasm.stat.no_mem_cnt == 12);
+    /* Unfragmented messages need no buffer */
+    publish("img/whole", data, 1000, 2048);
+    assert(sink.whole_cnt == 3);
+}
+
+/* Random lengths, client buffer sizes and faults against what should come out */
+static void test_random(void)
+{
+    static message_t msg;
+    setup(SIZE_MAX);
+    uint32_t expected_whole = 0;
+    uint32_t expected_done = 0;
+
+    for (int i = 0; i < 3000; ++i) {
+        size_t len = rnd() % (MAX_LEN + MAX_LEN / 4) + 1;
+        size_t buf_len = rnd() % (CLIENT_BUF_LEN - 256) + 256;
+        const char *payload = &data[rnd() % (DATA_LEN - len + 1)];
+        bool stream_only = rnd() % 4 == 0;
+        fragment(&msg, stream_only ? "art" : "img/whole", payload, len, buf_len);
+        pool.budget = rnd() % 8 == 0 ? MAX_LEN / 2 : SIZE_MAX;
+        if (rnd() % 8 == 0) {
+            /* Disconnected */
+            mqtt_reasm_deinit(&reasm);
+        }
+
+        uint32_t fault = rnd() % 10;
+        if (fault == 0 && msg.cnt > 2) {
+            /* Lost */
+            int f = 1 + (int)(rnd() % (uint32_t)(msg.cnt - 1));
+            memmove(&msg.frags[f], &msg.frags[f + 1], (size_t)(msg.cnt - f - 1) * sizeof(msg.frags[0]));
+            msg.cnt--;
+        } else if (fault == 1 && msg.cnt > 2) {
+            /* Swapped */
+            int f = 1 + (int)(rnd() % (uint32_t)(msg.cnt - 2));
+            mqtt_reasm_fragment_t tmp = msg.frags[f];
+            msg.frags[f] = msg.frags[f + 1];
+            msg.frags[f + 1] = tmp;
+        } else {
+            fault = UINT32_MAX;
+        }
+
+        uint32_t whole_cnt = sink.whole_cnt;
+        uint32_t done_cnt = sink.stream_done_cnt;
+        size_t buf_size = reasm.buf_size;
+        deliver(&msg);
+        bool intact = fault == UINT32_MAX;
+        /* The kept buffer is reused if large enough, otherwise replaced */
+        bool fits = msg.cnt == 1 || (len <= MAX_LEN && (len <= buf_size || len <= pool.budget));
+        expected_whole += intact && !stream_only && fits;
+        expected_done += intact;
+        assert(sink.whole_cnt == expected_whole && sink.stream_done_cnt == expected_done);
+        if (sink.whole_cnt != whole_cnt) {
+            assert(sink.whole_len == len && memcmp(sink.whole, payload, len) == 0);
+        }
+        if (sink.stream_done_cnt != done_cnt) {
+            assert(sink.streamed_len == len && memcmp(sink.streamed, payload, len) == 0);
+        }
+        assert(pool.used <= MAX_LEN);
+    }
+    const mqtt_reasm_stat_t *stat = &reasm.stat;
+    printf("%u messages: %u reassembled, %u too long, %u without memory, %u broken\n",
+           (unsigned)stat->msg_cnt, (unsigned)stat->reassembled_cnt, (unsigned)stat->too_long_cnt,
+           (unsigned)stat->no_mem_cnt, (unsigned)stat->broken_cnt);
+    assert(stat->msg_cnt == 3000 && stat->no_mem_cnt > 0);
+    mqtt_reasm_deinit(&reasm);
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (char)(i * 7 + i / 251);
+    }
+    RUN(test_unfragmented);
+    RUN(test_reassembly);
+    RUN(test_out_of_order);
+    RUN(test_oversized);
+    RUN(test_abort);
+    RUN(test_pool_exhaustion);
+    RUN(test_random);
+    return 0;
+}
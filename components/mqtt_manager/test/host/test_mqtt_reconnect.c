@@ -0,0 +1,208 @@
+/* Reconnect backoff with jitter, and the TLS session kept across reconnections */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mqtt_reconnect.h"
+
+#define DEVICE_CNT  1000
+
+static uint32_t seed = 1;
+static uint32_t session_cnt;        /* Allocated and not freed yet */
+static uint32_t free_cnt;
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) | (seed << 16);
+}
+
+/* Delay without jitter */
+static uint32_t full_delay(uint32_t attempt)
+{
+    uint64_t delay = (uint64_t)MQTT_RECONNECT_BACKOFF_MIN_MS << (attempt < 32 ? attempt : 32);
+    return delay < MQTT_RECONNECT_BACKOFF_MAX_MS ? (uint32_t)delay : MQTT_RECONNECT_BACKOFF_MAX_MS;
+}
+
+static void *session_new(int ticket)
+{
+    int *session = malloc(sizeof(*session));
+    assert(session);
+    *session = ticket;
+    session_cnt++;
+    return session;
+}
+
+static void session_free(void *session, void *ctx)
+{
+    assert(ctx == &session_cnt);
+    assert(session);
+    session_cnt--;
+    free_cnt++;
+    free(session);
+}
+
+static int ticket(const void *session)
+{
+    return session ? *(const int *)session : 0;
+}
+
+static void test_backoff_schedule(void)
+{
+    /* Doubled on every failed attempt up to the maximum, also after very long outages */
+    const uint32_t attempts[] = { 0, 1, 2, 3, 6, 7, 8, 9, 31, 32, 33, 1000, UINT32_MAX };
+    for (size_t i = 0; i < sizeof(attempts) / sizeof(attempts[0]); ++i) {
+        uint32_t delay = full_delay(attempts[i]);
+        assert(mqtt_reconnect_backoff_ms(attempts[i], 0) == delay / 2);
+        assert(mqtt_reconnect_backoff_ms(attempts[i], delay / 2) == delay);
+        assert(mqtt_reconnect_backoff_ms(attempts[i], delay / 2 + 1) == delay / 2);
+        assert(mqtt_reconnect_backoff_ms(attempts[i], UINT32_MAX) <= delay);
+    }
+    assert(full_delay(0) == MQTT_RECONNECT_BACKOFF_MIN_MS);
+    assert(full_delay(6) < MQTT_RECONNECT_BACKOFF_MAX_MS);
+    assert(full_delay(7) == MQTT_RECONNECT_BACKOFF_MAX_MS);
+
+    /* Time to give up on a broker down for an hour is bounded by the maximum delay */
+    uint64_t total = 0;
+    uint32_t attempt = 0;
+    while (total < 3600 * 1000) {
+        total += mqtt_reconnect_backoff_ms(attempt++, UINT32_MAX / 2);
+    }
+    printf("%u attempts in the first hour\n", (unsigned)attempt);
+    assert(attempt > 3600 * 1000 / MQTT_RECONNECT_BACKOFF_MAX_MS);
+    assert(attempt < 2 * 3600 * 1000 / MQTT_RECONNECT_BACKOFF_MAX_MS + 8);
+}
+
+static void test_backoff_jitter(void)
+{
+    /* After a broker restart the devices spread their attempts over the upper half of the delay */
+    for (uint32_t attempt = 0; attempt < 10; ++attempt) {
+        uint32_t delay = full_delay(attempt);
+        uint32_t buckets[10] = { 0 };
+        uint64_t sum = 0;
+        for (int i = 0; i < DEVICE_CNT; ++i) {
+            uint32_t d = mqtt_reconnect_backoff_ms(attempt, rnd());
+            assert(d >= delay / 2 && d <= delay);
+            buckets[(uint64_t)(d - delay / 2) * 10 / (delay / 2 + 1)]++;
+            sum += d;
+        }
+        /* Roughly uniform: no tenth of the range gets more than twice its share */
+        for (int b = 0; b < 10; ++b) {
+            assert(buckets[b] > DEVICE_CNT / 10 / 2);
+            assert(buckets[b] < DEVICE_CNT / 10 * 2);
+        }
+        uint32_t avg = (uint32_t)(sum / DEVICE_CNT);
+        assert(avg > delay * 3 / 4 - delay / 20 && avg < delay * 3 / 4 + delay / 20);
+    }
+}
+
+static void test_session_resume(void)
+{
+    mqtt_reconnect_session_t cache;
+    mqtt_reconnect_session_init(&cache, session_free, &session_cnt);
+    session_cnt = 0;
+    free_cnt = 0;
+
+    /* First connection: nothing to offer */
+    assert(mqtt_reconnect_session_offer(&cache) == NULL);
+    assert(!mqtt_reconnect_session_done(&cache, session_new(1)));
+    assert(session_cnt == 1);
+
+    /* The next ones offer the ticket of the previous one and keep the new one */
+    for (int i = 2; i < 10; ++i) {
+        assert(ticket(mqtt_reconnect_session_offer(&cache)) == i - 1);
+        assert(mqtt_reconnect_session_done(&cache, session_new(i)));
+        assert(session_cnt == 1);
+    }
+
+    /* The broker resumed without issuing a new ticket: the same session is kept */
+    void *session = mqtt_reconnect_session_offer(&cache);
+    assert(mqtt_reconnect_session_done(&cache, session));
+    assert(ticket(mqtt_reconnect_session_offer(&cache)) == 9 && session_cnt == 1);
+
+    /* No session from the handshake: the next handshake is a full one */
+    assert(mqtt_reconnect_session_done(&cache, NULL));
+    assert(session_cnt == 0);
+    assert(mqtt_reconnect_session_offer(&cache) == NULL);
+    assert(!mqtt_reconnect_session_done(&cache, session_new(10)));
+
+    mqtt_reconnect_session_clear(&cache);
+    mqtt_reconnect_session_clear(&cache);
+    assert(session_cnt == 0 && free_cnt == 10);
+}
+
+static void test_session_failed(void)
+{
+    mqtt_reconnect_session_t cache;
+    mqtt_reconnect_session_init(&cache, session_free, &session_cnt);
+    session_cnt = 0;
+
+    /* A failed handshake may be a refused ticket: it isn't offered again */
+    assert(!mqtt_reconnect_session_done(&cache, session_new(1)));
+    assert(ticket(mqtt_reconnect_session_offer(&cache)) == 1);
+    mqtt_reconnect_session_failed(&cache);
+    assert(session_cnt == 0);
+    assert(mqtt_reconnect_session_offer(&cache) == NULL);
+    mqtt_reconnect_session_failed(&cache);
+    assert(!mqtt_reconnect_session_done(&cache, session_new(2)));
+
+    /* Failures without a connection in between, then a resumed connection */
+    for (int i = 0; i < 3; ++i) {
+        mqtt_reconnect_session_offer(&cache);
+        mqtt_reconnect_session_failed(&cache);
+    }
+    assert(mqtt_reconnect_session_offer(&cache) == NULL);
+    assert(!mqtt_reconnect_session_done(&cache, session_new(3)));
+    assert(ticket(mqtt_reconnect_session_offer(&cache)) == 3);
+    assert(mqtt_reconnect_session_done(&cache, session_new(4)));
+    mqtt_reconnect_session_clear(&cache);
+    assert(session_cnt == 0);
+}
+
+static void test_session_random(void)
+{
+    mqtt_reconnect_session_t cache;
+    mqtt_reconnect_session_init(&cache, session_free, &session_cnt);
+    session_cnt = 0;
+
+    /* The ticket offered is always the one of the last successful handshake since the last failure */
+    int expected = 0;
+    int next_ticket = 1;
+    uint32_t offered_cnt = 0;
+    for (int i = 0; i < 10000; ++i) {
+        void *session = mqtt_reconnect_session_offer(&cache);
+        assert(ticket(session) == expected);
+        uint32_t r = rnd() % 4;
+        if (r == 0) {
+            mqtt_reconnect_session_failed(&cache);
+            expected = 0;
+        } else if (r == 1 && session) {
+            assert(mqtt_reconnect_session_done(&cache, session));
+            offered_cnt++;
+        } else {
+            bool offered = mqtt_reconnect_session_done(&cache, session_new(next_ticket));
+            assert(offered == (session != NULL));
+            offered_cnt += offered;
+            expected = next_ticket++;
+        }
+        assert(session_cnt == (expected != 0));
+    }
+    assert(offered_cnt > 10000 / 2);
+    mqtt_reconnect_session_clear(&cache);
+    assert(session_cnt == 0);
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    RUN(test_backoff_schedule);
+    RUN(test_backoff_jitter);
+    RUN(test_session_resume);
+    RUN(test_session_failed);
+    RUN(test_session_random);
+    return 0;
+}
@@ -0,0 +1,296 @@
+/* Wildcard semantics of the topic trie (MQTT 3.1.1 section 4.7) and a dispatch benchmark */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "mqtt_router.h"
+
+#define BENCH_DISPATCH_CNT  4000000
+
+static mqtt_router_t router;
+static uint32_t hits[32];
+static uint32_t seed = 1;
+
+static uint32_t rnd(uint32_t max)
+{
+    seed = seed * 1103515245 + 12345;
+    return ((seed >> 16) & 0x7fff) % max;
+}
+
+static void count_cb(mqtt_router_view_t topic, mqtt_router_view_t payload, void *ctx)
+{
+    (void)topic;
+    (void)payload;
+    hits[(size_t)ctx]++;
+}
+
+static uint32_t matches(const char *filter, const char *topic)
+{
+    mqtt_router_init(&router);
+    assert(mqtt_router_add(&router, filter, 0, count_cb, (void *)1) == 0);
+    return mqtt_router_dispatch(&router, topic, strlen(topic), "x", 1);
+}
+
+/* Matching as written in the specification, level by level */
+static bool reference_matches(const char *filter, const char *topic)
+{
+    if (topic[0] == '$' && (filter[0] == '+' || filter[0] == '#')) {
+        return false;
+    }
+    while (true) {
+        if (filter[0] == '#') {
+            return true;
+        }
+        const char *filter_end = strchr(filter, '/');
+        const char *topic_end = strchr(topic, '/');
+        size_t filter_len = filter_end ? (size_t)(filter_end - filter) : strlen(filter);
+        size_t topic_len = topic_end ? (size_t)(topic_end - topic) : strlen(topic);
+        if (!(filter_len == 1 && filter[0] == '+') &&
+            (filter_len != topic_len || memcmp(filter, topic, topic_len) != 0)) {
+            return false;
+        }
+        if (!filter_end || !topic_end) {
+            /* "a/#" matches "a" */
+            return !filter_end && !topic_end ? true : !topic_end && strcmp(filter_end, "/#") == 0;
+        }
+        filter = filter_end + 1;
+        topic = topic_end + 1;
+    }
+}
+
+static void test_spec_examples(void)
+{
+    assert(matches("sport/tennis/player1/#", "sport/tennis/player1") == 1);
+    assert(matches("sport/tennis/player1/#", "sport/tennis/player1/ranking") == 1);
+    assert(matches("sport/tennis/player1/#", "sport/tennis/player1/score/wimbledon") == 1);
+    assert(matches("sport/#", "sport") == 1);
+    assert(matches("#", "a/b/c") == 1);
+    assert(matches("sport/tennis/+", "sport/tennis/player1") == 1);
+    assert(matches("sport/tennis/+", "sport/tennis/player1/ranking") == 0);
+    assert(matches("sport/+", "sport") == 0);
+    assert(matches("sport/+", "sport/") == 1);
+    assert(matches("+/+", "/finance") == 1);
+    assert(matches("/+", "/finance") == 1);
+    assert(matches("+", "/finance") == 0);
+    assert(matches("+/tennis/#", "sport/tennis/player1") == 1);
+}
+
+static void test_literal_levels(void)
+{
+    assert(matches("a/b", "a/b") == 1);
+    assert(matches("a/b", "a/bc") == 0);
+    assert(matches("a/b", "a") == 0);
+    assert(matches("a/b", "a/b/c") == 0);
+    assert(matches("a//b", "a//b") == 1);
+    assert(matches("+/+/+", "a//b") == 1);
+    assert(matches("A/b", "a/b") == 0);
+}
+
+static void test_system_topics(void)
+{
+    assert(matches("#", "$SYS/broker/uptime") == 0);
+    assert(matches("+/monitor/Clients", "$SYS/monitor/Clients") == 0);
+    assert(matches("$SYS/#", "$SYS/monitor/Clients") == 1);
+    assert(matches("$SYS/monitor/+", "$SYS/monitor/Clients") == 1);
+    /* Only the first level is protected */
+    assert(matches("a/+", "a/$b") == 1);
+}
+
+static void test_invalid_filters(void)
+{
+    assert(!mqtt_router_filter_is_valid(""));
+    assert(!mqtt_router_filter_is_valid("a/#/b"));
+    assert(!mqtt_router_filter_is_valid("a#"));
+    assert(!mqtt_router_filter_is_valid("a/b#"));
+    assert(!mqtt_router_filter_is_valid("a/b+"));
+    assert(!mqtt_router_filter_is_valid("+a/b"));
+    assert(mqtt_router_filter_is_valid("+/#"));
+    assert(mqtt_router_filter_is_valid("/"));
+
+    mqtt_router_init(&router);
+    assert(mqtt_router_add(&router, "a/#/b", 0, count_cb, NULL) == -1);
+    assert(mqtt_router_add(&router, "a/b", 0, NULL, NULL) == -1);
+    assert(router.route_cnt == 0);
+}
+
+static void test_overlapping_routes(void)
+{
+    mqtt_router_init(&router);
+    memset(hits, 0, sizeof(hits));
+    int plus = mqtt_router_add(&router, "car/+/speed", 1, count_cb, (void *)1);
+    int hash = mqtt_router_add(&router, "car/#", 1, count_cb, (void *)2);
+    int plus_again = mqtt_router_add(&router, "car/+/speed", 1, count_cb, (void *)3);
+    int literal = mqtt_router_add(&router, "car/front/speed", 1, count_cb, (void *)4);
+
+    /* Only the first route of a filter is subscribed */
+    assert(router.routes[plus].first && router.routes[hash].first);
+    assert(!router.routes[plus_again].first && router.routes[literal].first);
+    assert(strcmp(mqtt_router_get_filter(&router, literal), "car/front/speed") == 0);
+
+    assert(mqtt_router_dispatch(&router, "car/front/speed", 15, NULL, 0) == 4);
+    assert(hits[1] == 1 && hits[2] == 1 && hits[3] == 1 && hits[4] == 1);
+    assert(mqtt_router_dispatch(&router, "car/rear/speed", 14, NULL, 0) == 3);
+    assert(mqtt_router_dispatch(&router, "car", 3, NULL, 0) == 1);
+    assert(mqtt_router_dispatch(&router, "bus/front/speed", 15, NULL, 0) == 0);
+}
+
+static void test_views_not_terminated(void)
+{
+    mqtt_router_init(&router);
+    memset(hits, 0, sizeof(hits));
+    mqtt_router_add(&router, "a/b", 0, count_cb, (void *)1);
+    /* The topic is a part of a longer buffer, as in the received message */
+    const char buf[] = "a/b/c";
+    assert(mqtt_router_dispatch(&router, buf, 3, NULL, 0) == 1);
+    assert(mqtt_router_dispatch(&router, buf, 2, NULL, 0) == 0);
+}
+
+static void stream_cb(mqtt_router_view_t topic, const mqtt_router_chunk_t *chunk, void *ctx)
+{
+    (void)topic;
+    (void)chunk;
+    hits[(size_t)ctx]++;
+}
+
+static void test_stream_routes(void)
+{
+    mqtt_router_init(&router);
+    memset(hits, 0, sizeof(hits));
+    mqtt_router_add(&router, "art/#", 0, count_cb, (void *)1);
+    mqtt_router_add_stream(&router, "art/+", 0, stream_cb, (void *)2);
+
+    mqtt_router_chunk_t chunk = { { "xy", 2 }, 0, 2 };
+    assert(mqtt_router_dispatch(&router, "art/cover", 9, "xy", 2) == 1);
+    assert(mqtt_router_dispatch_chunk(&router, "art/cover", 9, &chunk) == 1);
+    assert(hits[1] == 1 && hits[2] == 1);
+    assert(mqtt_router_count(&router, "art/cover", 9, true) == 1);
+    assert(mqtt_router_count(&router, "art/cover", 9, false) == 1);
+    assert(hits[1] == 1 && hits[2] == 1);
+}
+
+static void test_full(void)
+{
+    mqtt_router_init(&router);
+    char filter[32];
+    int cnt = 0;
+    while (true) {
+        snprintf(filter, sizeof(filter), "vehicle/%d/x", cnt);
+        if (mqtt_router_add(&router, filter, 0, count_cb, NULL) < 0) {
+            break;
+        }
+        cnt++;
+    }
+    /* A failed add leaves nothing behind */
+    uint16_t node_cnt = router.node_cnt;
+    uint16_t pool_used = router.filter_pool_used;
+    assert(mqtt_router_add(&router, "vehicle/new/x", 0, count_cb, NULL) < 0);
+    assert(router.node_cnt == node_cnt && router.filter_pool_used == pool_used);
+    assert(mqtt_router_dispatch(&router, "vehicle/0/x", 11, NULL, 0) == 1);
+    assert(mqtt_router_dispatch(&router, "vehicle/new/x", 13, NULL, 0) == 0);
+}
+
+/* Random filters and topics from a small alphabet, so that they often match */
+static void random_levels(char *out, size_t size, bool filter)
+{
+    static const char *levels[] = { "a", "b", "", "$x" };
+    size_t len = 0;
+    uint32_t level_cnt = 1 + rnd(4);
+    for (uint32_t i = 0; i < level_cnt; ++i) {
+        const char *level = levels[rnd(4)];
+        if (filter) {
+            uint32_t r = rnd(6);
+            level = r == 0 ? "+" : r == 1 && i == level_cnt - 1 ? "#" : level;
+        }
+        len += (size_t)snprintf(&out[len], size - len, "%s%s", i ? "/" : "", level);
+    }
+}
+
+static void test_against_reference(void)
+{
+    for (int round = 0; round < 200; ++round) {
+        mqtt_router_init(&router);
+        char filters[16][32];
+        for (int i = 0; i < 16; ++i) {
+            do {
+                random_levels(filters[i], sizeof(filters[i]), true);
+            } while (!mqtt_router_filter_is_valid(filters[i]));
+            assert(mqtt_router_add(&router, filters[i], 0, count_cb, NULL) >= 0);
+        }
+        for (int t = 0; t < 100; ++t) {
+            char topic[32];
+            random_levels(topic, sizeof(topic), false);
+            uint32_t expected = 0;
+            for (int i = 0; i < 16; ++i) {
+                expected += reference_matches(filters[i], topic);
+            }
+            uint32_t found = mqtt_router_count(&router, topic, strlen(topic), false);
+            if (found != expected) {
+                printf("topic \"%s\": %u routes, expected %u\n", topic, (unsigned)found, (unsigned)expected);
+            }
+            assert(found == expected);
+        }
+    }
+}
+
+static void test_dispatch_benchmark(void)
+{
+    static const char *signals[] = { "speed", "rpm", "soc", "range", "temp_in", "temp_out", "gear", "odometer" };
+    char filter[64];
+    mqtt_router_init(&router);
+    for (size_t i = 0; i < 8; ++i) {
+        snprintf(filter, sizeof(filter), "vehicle/telemetry/%s", signals[i]);
+        mqtt_router_add(&router, filter, 0, count_cb, (void *)(i + 1));
+    }
+    mqtt_router_add(&router, "vehicle/+/alerts/#", 0, count_cb, (void *)20);
+    mqtt_router_add(&router, "vehicle/hvac/+", 0, count_cb, (void *)21);
+    mqtt_router_add(&router, "TempOut", 0, count_cb, (void *)22);
+
+    char topics[16][64];
+    size_t lens[16];
+    for (size_t i = 0; i < 8; ++i) {
+        snprintf(topics[i], sizeof(topics[i]), "vehicle/telemetry/%s", signals[i]);
+    }
+    strcpy(topics[8], "vehicle/hvac/temp_set");
+    strcpy(topics[9], "vehicle/body/alerts/door/fl");
+    strcpy(topics[10], "TempOut");
+    strcpy(topics[11], "vehicle/telemetry/unknown");
+    strcpy(topics[12], "other/topic/x");
+    strcpy(topics[13], "vehicle/media/track");
+    strcpy(topics[14], "vehicle/telemetry/speed");
+    strcpy(topics[15], "vehicle/hvac/power");
+    for (size_t i = 0; i < 16; ++i) {
+        lens[i] = strlen(topics[i]);
+    }
+
+    uint64_t call_cnt = 0;
+    clock_t start = clock();
+    for (uint32_t i = 0; i < BENCH_DISPATCH_CNT; ++i) {
+        call_cnt += mqtt_router_dispatch(&router, topics[i & 15], lens[i & 15], "1", 1);
+    }
+    double s = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("%u dispatches over %u routes, %llu handler calls: %.1f ns per dispatch\n",
+           (unsigned)BENCH_DISPATCH_CNT, (unsigned)router.route_cnt, (unsigned long long)call_cnt,
+           s * 1e9 / BENCH_DISPATCH_CNT);
+    /* 13 of the 16 topics match one route */
+    assert(call_cnt == (uint64_t)BENCH_DISPATCH_CNT / 16 * 13);
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    RUN(test_spec_examples);
+    RUN(test_literal_levels);
+    RUN(test_system_topics);
+    RUN(test_invalid_filters);
+    RUN(test_overlapping_routes);
+    RUN(test_views_not_terminated);
+    RUN(test_stream_routes);
+    RUN(test_full);
+    RUN(test_against_reference);
+    RUN(test_dispatch_benchmark);
+    return 0;
+}
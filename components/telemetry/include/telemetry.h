@@ -0,0 +1,146 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Binary telemetry frames carrying several signals at once.
+ *
+ * Frame, little endian:
+ *   0  version (TELEMETRY_VERSION)
+ *   1  number of values
+ *   2  sequence number, 16 bit, incremented by the sender for every frame
+ *   4  values, TELEMETRY_VALUE_SIZE bytes each:
+ *        0  signal id
+ *        1  type (telemetry_type_t)
+ *        2  value, 32 bit: float, signed integer or 0/1
+ *
+ * The frames are decoded in place from the received buffer. The decoded
+ * values go to a store holding the latest value of every signal, which the
+ * UI reads the changed values from.
+ * Plain C without ESP-IDF dependencies, so the codec can be fuzzed and
+ * benchmarked on the host.
+ */
+
+#define TELEMETRY_VERSION       1
+#define TELEMETRY_HEADER_SIZE   4
+#define TELEMETRY_VALUE_SIZE    6
+#define TELEMETRY_MAX_VALUES    UINT8_MAX
+
+/** Signal ids of a store are below this */
+#ifndef TELEMETRY_MAX_SIGNALS
+#define TELEMETRY_MAX_SIGNALS   32
+#endif
+
+/** Size of a frame with `n` values */
+#define TELEMETRY_FRAME_SIZE(n) (TELEMETRY_HEADER_SIZE + (n) * TELEMETRY_VALUE_SIZE)
+
+_Static_assert(TELEMETRY_MAX_SIGNALS <= 32, "The changed signals are stored in a 32 bit mask");
+
+typedef enum {
+    TELEMETRY_TYPE_F32 = 0,
+    TELEMETRY_TYPE_I32,
+    TELEMETRY_TYPE_BOOL,
+    TELEMETRY_TYPE_CNT,
+} telemetry_type_t;
+
+typedef struct {
+    uint8_t signal;
+    uint8_t type;               /*!< telemetry_type_t */
+    union {
+        float f32;
+        int32_t i32;
+        bool b;
+    };
+} telemetry_value_t;
+
+typedef void (*telemetry_value_cb_t)(const telemetry_value_t *value, void *ctx);
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    bool overflow;              /*!< A value didn't fit, the frame is invalid */
+} telemetry_encoder_t;
+
+typedef struct {
+    uint32_t frame_cnt;
+    uint32_t invalid_cnt;       /**< Frames rejected as a whole: wrong version, length or type */
+    uint32_t value_cnt;
+    uint32_t unknown_cnt;       /**< Values of signals outside the store */
+    uint32_t lost_cnt;          /**< Frames missing according to the sequence numbers */
+} telemetry_stat_t;
+
+/**
+ * Latest value of every signal.
+ * One writer (telemetry_store_put(), telemetry_store_decode()) and one reader
+ * (telemetry_store_take_changed()) may run in different tasks.
+ */
+typedef struct {
+    telemetry_value_t values[TELEMETRY_MAX_SIGNALS];
+    uint32_t changed;           /*!< Signals written since the last telemetry_store_take_changed() */
+    uint16_t seq;
+    bool seq_valid;
+    telemetry_stat_t stat;
+} telemetry_store_t;
+
+/**
+ * @brief Check a frame and call `cb` with every value.
+ *
+ * The frame is checked as a whole first, so an invalid frame gives no value.
+ *
+ * @param seq Set to the frame's sequence number if not NULL.
+ * @return Number of values or -1 if the frame is invalid.
+ */
+int telemetry_decode(const void *frame, size_t len, uint16_t *seq, telemetry_value_cb_t cb, void *ctx);
+
+void telemetry_encode_begin(telemetry_encoder_t *enc, void *buf, size_t size, uint16_t seq);
+
+void telemetry_encode_f32(telemetry_encoder_t *enc, uint8_t signal, float value);
+
+void telemetry_encode_i32(telemetry_encoder_t *enc, uint8_t signal, int32_t value);
+
+void telemetry_encode_bool(telemetry_encoder_t *enc, uint8_t signal, bool value);
+
+/**
+ * @brief Finish a frame.
+ *
+ * @return Length of the frame or 0 if it didn't fit into the buffer.
+ */
+size_t telemetry_encode_end(telemetry_encoder_t *enc);
+
+void telemetry_store_init(telemetry_store_t *store);
+
+/**
+ * @brief Store a value and mark its signal changed. Usable as telemetry_value_cb_t.
+ */
+void telemetry_store_put(const telemetry_value_t *value, void *store);
+
+/**
+ * @brief Decode a frame into the store.
+ *
+ * @return Whether the frame was valid.
+ */
+bool telemetry_store_decode(telemetry_store_t *store, const void *frame, size_t len);
+
+/**
+ * @brief Mask of the signals changed since the last call, cleared by the call.
+ */
+uint32_t telemetry_store_take_changed(telemetry_store_t *store);
+
+/**
+ * @brief The latest value of a signal. Its type is TELEMETRY_TYPE_CNT if not received yet.
+ */
+static inline const telemetry_value_t *telemetry_store_get(const telemetry_store_t *store, uint8_t signal)
+{
+    return &store->values[signal];
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,152 @@
+#include "telemetry.h"
+
+#include <string.h>
+
+static uint32_t telemetry_get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void telemetry_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+int telemetry_decode(const void *frame, size_t len, uint16_t *seq, telemetry_value_cb_t cb, void *ctx)
+{
+    const uint8_t *p = frame;
+    if (!p || len < TELEMETRY_HEADER_SIZE || p[0] != TELEMETRY_VERSION ||
+        len != TELEMETRY_FRAME_SIZE((size_t)p[1])) {
+        return -1;
+    }
+    int cnt = p[1];
+    const uint8_t *values = p + TELEMETRY_HEADER_SIZE;
+    for (int i = 0; i < cnt; ++i) {
+        if (values[i * TELEMETRY_VALUE_SIZE + 1] >= TELEMETRY_TYPE_CNT) {
+            return -1;
+        }
+    }
+
+    if (seq) {
+        *seq = (uint16_t)(p[2] | p[3] << 8);
+    }
+    for (int i = 0; i < cnt && cb; ++i) {
+        const uint8_t *v = &values[i * TELEMETRY_VALUE_SIZE];
+        uint32_t raw = telemetry_get_u32(&v[2]);
+        telemetry_value_t value = {
+            .signal = v[0],
+            .type = v[1],
+        };
+        switch (value.type) {
+        case TELEMETRY_TYPE_F32:
+            memcpy(&value.f32, &raw, sizeof(value.f32));
+            break;
+        case TELEMETRY_TYPE_I32:
+            value.i32 = (int32_t)raw;
+            break;
+        default:
+            value.b = raw != 0;
+            break;
+        }
+        cb(&value, ctx);
+    }
+    return cnt;
+}
+
+void telemetry_encode_begin(telemetry_encoder_t *enc, void *buf, size_t size, uint16_t seq)
+{
+    enc->buf = buf;
+    enc->size = size;
+    enc->len = TELEMETRY_HEADER_SIZE;
+    enc->overflow = size < TELEMETRY_HEADER_SIZE;
+    if (!enc->overflow) {
+        enc->buf[0] = TELEMETRY_VERSION;
+        enc->buf[1] = 0;
+        enc->buf[2] = (uint8_t)seq;
+        enc->buf[3] = (uint8_t)(seq >> 8);
+    }
+}
+
+static void telemetry_encode_raw(telemetry_encoder_t *enc, uint8_t signal, telemetry_type_t type, uint32_t raw)
+{
+    if (enc->overflow || enc->len + TELEMETRY_VALUE_SIZE > enc->size || enc->buf[1] == TELEMETRY_MAX_VALUES) {
+        enc->overflow = true;
+        return;
+    }
+    uint8_t *v = &enc->buf[enc->len];
+    v[0] = signal;
+    v[1] = (uint8_t)type;
+    telemetry_put_u32(&v[2], raw);
+    enc->len += TELEMETRY_VALUE_SIZE;
+    enc->buf[1]++;
+}
+
+void telemetry_encode_f32(telemetry_encoder_t *enc, uint8_t signal, float value)
+{
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    telemetry_encode_raw(enc, signal, TELEMETRY_TYPE_F32, raw);
+}
+
+void telemetry_encode_i32(telemetry_encoder_t *enc, uint8_t signal, int32_t value)
+{
+    telemetry_encode_raw(enc, signal, TELEMETRY_TYPE_I32, (uint32_t)value);
+}
+
+void telemetry_encode_bool(telemetry_encoder_t *enc, uint8_t signal, bool value)
+{
+    telemetry_encode_raw(enc, signal, TELEMETRY_TYPE_BOOL, value);
+}
+
+size_t telemetry_encode_end(telemetry_encoder_t *enc)
+{
+    return enc->overflow ? 0 : enc->len;
+}
+
+void telemetry_store_init(telemetry_store_t *store)
+{
+    memset(store, 0, sizeof(*store));
+    for (int i = 0; i < TELEMETRY_MAX_SIGNALS; ++i) {
+        store->values[i].signal = (uint8_t)i;
+        store->values[i].type = TELEMETRY_TYPE_CNT;
+    }
+}
+
+void telemetry_store_put(const telemetry_value_t *value, void *ctx)
+{
+    telemetry_store_t *store = ctx;
+    if (value->signal >= TELEMETRY_MAX_SIGNALS) {
+        store->stat.unknown_cnt++;
+        return;
+    }
+    store->values[value->signal] = *value;
+    store->stat.value_cnt++;
+    /* Published after the value, so the reader never sees the flag without the value */
+    __atomic_fetch_or(&store->changed, (uint32_t)1 << value->signal, __ATOMIC_RELEASE);
+}
+
+bool telemetry_store_decode(telemetry_store_t *store, const void *frame, size_t len)
+{
+    uint16_t seq;
+    if (telemetry_decode(frame, len, &seq, telemetry_store_put, store) < 0) {
+        store->stat.invalid_cnt++;
+        return false;
+    }
+    /* Repeated frames (QoS 1) and restarted senders don't count as lost */
+    uint16_t gap = (uint16_t)(seq - store->seq);
+    if (store->seq_valid && gap > 1 && gap < UINT16_MAX / 2) {
+        store->stat.lost_cnt += gap - 1;
+    }
+    store->seq = seq;
+    store->seq_valid = true;
+    store->stat.frame_cnt++;
+    return true;
+}
+
+uint32_t telemetry_store_take_changed(telemetry_store_t *store)
+{
+    return __atomic_exchange_n(&store->changed, 0, __ATOMIC_ACQUIRE);
+}
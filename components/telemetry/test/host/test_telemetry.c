@@ -0,0 +1,407 @@
+/* Round trip and fuzzing of the telemetry frames, and a benchmark against the text payloads */
+
+#undef NDEBUG
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "telemetry.h"
+
+#define FUZZ_CNT        1000000
+#define BENCH_VALUE_CNT 4000000
+#define BENCH_SIGNALS   8
+
+typedef struct {
+    telemetry_value_t values[TELEMETRY_MAX_VALUES];
+    int cnt;
+} capture_t;
+
+static uint32_t seed = 1;
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) | (seed << 16);
+}
+
+static void capture_cb(const telemetry_value_t *value, void *ctx)
+{
+    capture_t *capture = ctx;
+    assert(capture->cnt < TELEMETRY_MAX_VALUES);
+    assert(value->type < TELEMETRY_TYPE_CNT);
+    capture->values[capture->cnt++] = *value;
+}
+
+static bool same_value(const telemetry_value_t *a, const telemetry_value_t *b)
+{
+    if (a->signal != b->signal || a->type != b->type) {
+        return false;
+    }
+    switch (a->type) {
+    case TELEMETRY_TYPE_F32:
+        /* Bit exact, NaN payloads and the sign of zero included */
+        return memcmp(&a->f32, &b->f32, sizeof(a->f32)) == 0;
+    case TELEMETRY_TYPE_I32:
+        return a->i32 == b->i32;
+    default:
+        return a->b == b->b;
+    }
+}
+
+static void random_value(telemetry_value_t *value)
+{
+    value->signal = (uint8_t)rnd();
+    value->type = (uint8_t)(rnd() % TELEMETRY_TYPE_CNT);
+    uint32_t raw = rnd();
+    switch (value->type) {
+    case TELEMETRY_TYPE_F32:
+        memcpy(&value->f32, &raw, sizeof(value->f32));
+        break;
+    case TELEMETRY_TYPE_I32:
+        value->i32 = (int32_t)raw;
+        break;
+    default:
+        value->b = raw & 1;
+        break;
+    }
+}
+
+static void encode_value(telemetry_encoder_t *enc, const telemetry_value_t *value)
+{
+    switch (value->type) {
+    case TELEMETRY_TYPE_F32:
+        telemetry_encode_f32(enc, value->signal, value->f32);
+        break;
+    case TELEMETRY_TYPE_I32:
+        telemetry_encode_i32(enc, value->signal, value->i32);
+        break;
+    default:
+        telemetry_encode_bool(enc, value->signal, value->b);
+        break;
+    }
+}
+
+/* Decode from a heap copy of exactly `len` bytes, so ASan catches reads past the frame */
+static int decode_copy(const uint8_t *frame, size_t len, uint16_t *seq, capture_t *capture)
+{
+    uint8_t *copy = malloc(len ? len : 1);
+    assert(copy);
+    memcpy(copy, frame, len);
+    capture->cnt = 0;
+    int cnt = telemetry_decode(copy, len, seq, capture_cb, capture);
+    free(copy);
+    return cnt;
+}
+
+static void test_round_trip(void)
+{
+    static uint8_t buf[TELEMETRY_FRAME_SIZE(TELEMETRY_MAX_VALUES)];
+    static telemetry_value_t values[TELEMETRY_MAX_VALUES];
+    static capture_t capture;
+    const float specials[] = { 0.0f, -0.0f, INFINITY, -INFINITY, NAN, 1e-45f, 3.4028235e38f, 21.5f };
+
+    for (int i = 0; i < 10000; ++i) {
+        int cnt = i < 10 ? i : (i == 10 ? TELEMETRY_MAX_VALUES : (int)(rnd() % 32));
+        uint16_t seq = (uint16_t)rnd();
+        telemetry_encoder_t enc;
+        telemetry_encode_begin(&enc, buf, sizeof(buf), seq);
+        for (int v = 0; v < cnt; ++v) {
+            random_value(&values[v]);
+            if (values[v].type == TELEMETRY_TYPE_F32 && rnd() % 4 == 0) {
+                values[v].f32 = specials[rnd() % (sizeof(specials) / sizeof(specials[0]))];
+            }
+            encode_value(&enc, &values[v]);
+        }
+        size_t len = telemetry_encode_end(&enc);
+        assert(len == TELEMETRY_FRAME_SIZE((size_t)cnt));
+
+        uint16_t decoded_seq = 0;
+        assert(decode_copy(buf, len, &decoded_seq, &capture) == cnt);
+        assert(decoded_seq == seq && capture.cnt == cnt);
+        for (int v = 0; v < cnt; ++v) {
+            assert(same_value(&capture.values[v], &values[v]));
+        }
+    }
+
+    /* The layout is fixed, whatever the host's byte order */
+    telemetry_encoder_t enc;
+    telemetry_encode_begin(&enc, buf, sizeof(buf), 0x1234);
+    telemetry_encode_i32(&enc, 7, -2);
+    telemetry_encode_f32(&enc, 8, 1.0f);
+    telemetry_encode_bool(&enc, 9, true);
+    const uint8_t expected[] = {
+        TELEMETRY_VERSION, 3, 0x34, 0x12,
+        7, TELEMETRY_TYPE_I32, 0xfe, 0xff, 0xff, 0xff,
+        8, TELEMETRY_TYPE_F32, 0x00, 0x00, 0x80, 0x3f,
+        9, TELEMETRY_TYPE_BOOL, 0x01, 0x00, 0x00, 0x00,
+    };
+    assert(telemetry_encode_end(&enc) == sizeof(expected));
+    assert(memcmp(buf, expected, sizeof(expected)) == 0);
+}
+
+static void test_encoder_overflow(void)
+{
+    uint8_t buf[TELEMETRY_FRAME_SIZE(TELEMETRY_MAX_VALUES + 1)];
+    telemetry_encoder_t enc;
+
+    telemetry_encode_begin(&enc, buf, TELEMETRY_HEADER_SIZE - 1, 0);
+    assert(telemetry_encode_end(&enc) == 0);
+
+    telemetry_encode_begin(&enc, buf, TELEMETRY_HEADER_SIZE, 0);
+    assert(telemetry_encode_end(&enc) == TELEMETRY_HEADER_SIZE);
+
+    /* A value not fitting invalidates the frame, also when the next one would fit */
+    telemetry_encode_begin(&enc, buf, TELEMETRY_FRAME_SIZE(2) - 1, 0);
+    telemetry_encode_f32(&enc, 0, 1.0f);
+    telemetry_encode_f32(&enc, 1, 1.0f);
+    assert(telemetry_encode_end(&enc) == 0);
+    assert(enc.len <= enc.size);
+
+    /* The value count is 8 bit */
+    telemetry_encode_begin(&enc, buf, sizeof(buf), 0);
+    for (int i = 0; i < TELEMETRY_MAX_VALUES; ++i) {
+        telemetry_encode_i32(&enc, 0, i);
+    }
+    assert(telemetry_encode_end(&enc) == TELEMETRY_FRAME_SIZE(TELEMETRY_MAX_VALUES));
+    telemetry_encode_i32(&enc, 0, 0);
+    assert(telemetry_encode_end(&enc) == 0);
+}
+
+static void test_invalid_frames(void)
+{
+    uint8_t buf[TELEMETRY_FRAME_SIZE(3) + 1];
+    capture_t capture;
+    telemetry_encoder_t enc;
+    telemetry_encode_begin(&enc, buf, sizeof(buf), 5);
+    telemetry_encode_f32(&enc, 0, 1.0f);
+    telemetry_encode_i32(&enc, 1, 2);
+    telemetry_encode_bool(&enc, 2, true);
+    size_t len = telemetry_encode_end(&enc);
+
+    assert(telemetry_decode(NULL, 0, NULL, capture_cb, &capture) == -1);
+    for (size_t l = 0; l < len; ++l) {
+        assert(decode_copy(buf, l, NULL, &capture) == -1 && capture.cnt == 0);
+    }
+    buf[len] = 0;
+    assert(decode_copy(buf, len + 1, NULL, &capture) == -1);
+
+    buf[0] = TELEMETRY_VERSION + 1;
+    assert(decode_copy(buf, len, NULL, &capture) == -1);
+    buf[0] = TELEMETRY_VERSION;
+
+    /* An unknown type in the last value rejects the whole frame */
+    buf[TELEMETRY_FRAME_SIZE(2) + 1] = TELEMETRY_TYPE_CNT;
+    uint16_t seq = 0;
+    assert(decode_copy(buf, len, &seq, &capture) == -1 && capture.cnt == 0 && seq == 0);
+    buf[TELEMETRY_FRAME_SIZE(2) + 1] = TELEMETRY_TYPE_BOOL;
+    assert(decode_copy(buf, len, &seq, &capture) == 3 && seq == 5);
+
+    /* Any nonzero boolean is true */
+    buf[TELEMETRY_FRAME_SIZE(2) + 2] = 0;
+    buf[TELEMETRY_FRAME_SIZE(2) + 5] = 0x80;
+    assert(decode_copy(buf, len, NULL, &capture) == 3 && capture.values[2].b);
+
+    /* Without a callback the frame is only checked */
+    assert(telemetry_decode(buf, len, NULL, NULL, NULL) == 3);
+}
+
+static void test_store(void)
+{
+    telemetry_store_t store;
+    telemetry_store_init(&store);
+    assert(telemetry_store_get(&store, 3)->type == TELEMETRY_TYPE_CNT);
+    assert(telemetry_store_get(&store, 3)->signal == 3);
+
+    uint8_t buf[TELEMETRY_FRAME_SIZE(8)];
+    telemetry_encoder_t enc;
+    telemetry_encode_begin(&enc, buf, sizeof(buf), 0);
+    telemetry_encode_f32(&enc, 0, 21.5f);
+    telemetry_encode_i32(&enc, 1, -7);
+    telemetry_encode_f32(&enc, 0, 22.0f);
+    telemetry_encode_bool(&enc, TELEMETRY_MAX_SIGNALS - 1, true);
+    telemetry_encode_f32(&enc, TELEMETRY_MAX_SIGNALS, 1.0f);
+    telemetry_encode_f32(&enc, UINT8_MAX, 1.0f);
+    size_t len = telemetry_encode_end(&enc);
+    assert(telemetry_store_decode(&store, buf, len));
+
+    /* The last value of a signal wins, signals outside the store are counted */
+    assert(telemetry_store_get(&store, 0)->f32 == 22.0f);
+    assert(telemetry_store_get(&store, 1)->i32 == -7);
+    assert(telemetry_store_get(&store, TELEMETRY_MAX_SIGNALS - 1)->b);
+    assert(store.stat.value_cnt == 4 && store.stat.unknown_cnt == 2);
+    assert(telemetry_store_take_changed(&store) == (3u | 1u << (TELEMETRY_MAX_SIGNALS - 1)));
+    assert(telemetry_store_take_changed(&store) == 0);
+
+    /* An invalid frame changes nothing */
+    buf[1]++;
+    assert(!telemetry_store_decode(&store, buf, len));
+    assert(store.stat.invalid_cnt == 1 && store.stat.frame_cnt == 1 && store.stat.value_cnt == 4);
+    assert(telemetry_store_take_changed(&store) == 0);
+}
+
+static void test_lost_frames(void)
+{
+    telemetry_store_t store;
+    telemetry_store_init(&store);
+    uint8_t buf[TELEMETRY_HEADER_SIZE];
+    telemetry_encoder_t enc;
+    const struct {
+        uint16_t seq;
+        uint32_t lost_cnt;
+    } frames[] = {
+        { 100, 0 },         /* The first one gives nothing to compare with */
+        { 101, 0 },
+        { 104, 2 },
+        { 104, 2 },         /* Repeated */
+        { 105, 2 },
+        { 7, 2 },           /* Restarted sender */
+        { 8, 2 },
+        { 65534, 2 },       /* Restarted sender, or far behind */
+        { 65535, 2 },
+        { 1, 3 },           /* Wrapped */
+    };
+    for (size_t i = 0; i < sizeof(frames) / sizeof(frames[0]); ++i) {
+        telemetry_encode_begin(&enc, buf, sizeof(buf), frames[i].seq);
+        assert(telemetry_store_decode(&store, buf, telemetry_encode_end(&enc)));
+        assert(store.stat.lost_cnt == frames[i].lost_cnt);
+    }
+    assert(store.stat.frame_cnt == sizeof(frames) / sizeof(frames[0]));
+}
+
+static void test_fuzz(void)
+{
+    static uint8_t buf[TELEMETRY_FRAME_SIZE(16) + 8];
+    static capture_t capture;
+    telemetry_store_t store;
+    telemetry_store_init(&store);
+    uint32_t valid_cnt = 0;
+    uint32_t value_cnt = 0;
+
+    for (uint32_t i = 0; i < FUZZ_CNT; ++i) {
+        size_t len;
+        if (i & 1) {
+            /* Random bytes, often with a plausible header */
+            len = rnd() % sizeof(buf);
+            for (size_t b = 0; b < len; ++b) {
+                buf[b] = (uint8_t)rnd();
+            }
+            if (len > 0 && rnd() % 2) {
+                buf[0] = TELEMETRY_VERSION;
+            }
+            if (len > 1 && rnd() % 2) {
+                buf[1] = (uint8_t)((len - TELEMETRY_HEADER_SIZE) / TELEMETRY_VALUE_SIZE);
+            }
+        } else {
+            /* A valid frame with a few flipped bits or cut */
+            telemetry_encoder_t enc;
+            telemetry_encode_begin(&enc, buf, sizeof(buf), (uint16_t)rnd());
+            for (uint32_t v = rnd() % 16; v > 0; --v) {
+                telemetry_value_t value;
+                random_value(&value);
+                value.signal %= TELEMETRY_MAX_SIGNALS + 8;
+                encode_value(&enc, &value);
+            }
+            len = telemetry_encode_end(&enc);
+            assert(len > 0);
+            for (uint32_t flip = rnd() % 3; flip > 0; --flip) {
+                buf[rnd() % len] ^= (uint8_t)(1 << (rnd() % 8));
+            }
+            if (rnd() % 4 == 0) {
+                len = rnd() % (len + 2);
+            }
+        }
+
+        int cnt = decode_copy(buf, len, NULL, &capture);
+        /* All or nothing */
+        assert(cnt == -1 ? capture.cnt == 0 : cnt == capture.cnt);
+        if (cnt >= 0) {
+            assert(len == TELEMETRY_FRAME_SIZE((size_t)cnt));
+            valid_cnt++;
+            value_cnt += (uint32_t)cnt;
+        }
+        assert(telemetry_store_decode(&store, buf, len) == (cnt >= 0));
+    }
+    assert(store.stat.frame_cnt == valid_cnt && store.stat.invalid_cnt == FUZZ_CNT - valid_cnt);
+    assert(store.stat.value_cnt + store.stat.unknown_cnt == value_cnt);
+    printf("%u of %u fuzzed frames valid\n", (unsigned)valid_cnt, (unsigned)FUZZ_CNT);
+    assert(valid_cnt > FUZZ_CNT / 10);
+}
+
+/* The handler of the text payloads: one value per message, parsed from a copy */
+static void put_text(telemetry_store_t *store, uint8_t signal, const char *payload, size_t payload_len)
+{
+    char text[16];
+    size_t len = payload_len < sizeof(text) - 1 ? payload_len : sizeof(text) - 1;
+    memcpy(text, payload, len);
+    text[len] = '\0';
+    telemetry_value_t value = {
+        .signal = signal,
+        .type = TELEMETRY_TYPE_F32,
+        .f32 = strtof(text, NULL),
+    };
+    telemetry_store_put(&value, store);
+}
+
+static void test_benchmark(void)
+{
+    char texts[BENCH_SIGNALS][16];
+    size_t text_lens[BENCH_SIGNALS];
+    uint8_t frame[TELEMETRY_FRAME_SIZE(BENCH_SIGNALS)];
+    telemetry_encoder_t enc;
+    telemetry_encode_begin(&enc, frame, sizeof(frame), 0);
+    for (int s = 0; s < BENCH_SIGNALS; ++s) {
+        float value = 18.5f + (float)s * 1.25f;
+        text_lens[s] = (size_t)snprintf(texts[s], sizeof(texts[s]), "%.2f", (double)value);
+        telemetry_encode_f32(&enc, (uint8_t)s, value);
+    }
+    assert(telemetry_encode_end(&enc) == sizeof(frame));
+
+    telemetry_store_t text_store;
+    telemetry_store_init(&text_store);
+    clock_t start = clock();
+    for (uint32_t i = 0; i < BENCH_VALUE_CNT; ++i) {
+        uint8_t s = i % BENCH_SIGNALS;
+        put_text(&text_store, s, texts[s], text_lens[s]);
+    }
+    double text_s = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    telemetry_store_t store;
+    telemetry_store_init(&store);
+    start = clock();
+    for (uint32_t i = 0; i < BENCH_VALUE_CNT / BENCH_SIGNALS; ++i) {
+        frame[2] = (uint8_t)i;
+        frame[3] = (uint8_t)(i >> 8);
+        telemetry_store_decode(&store, frame, sizeof(frame));
+    }
+    double frame_s = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* Both paths end with the same values */
+    assert(text_store.stat.value_cnt == BENCH_VALUE_CNT && store.stat.value_cnt == BENCH_VALUE_CNT);
+    assert(store.stat.lost_cnt == 0 && store.stat.invalid_cnt == 0);
+    for (int s = 0; s < BENCH_SIGNALS; ++s) {
+        assert(same_value(telemetry_store_get(&text_store, (uint8_t)s), telemetry_store_get(&store, (uint8_t)s)));
+    }
+
+    double text_ns = text_s * 1e9 / BENCH_VALUE_CNT;
+    double frame_ns = frame_s * 1e9 / BENCH_VALUE_CNT;
+    printf("%u values: text %.1f ns per value, frames of %d values %.1f ns per value (%.1fx)\n",
+           (unsigned)BENCH_VALUE_CNT, text_ns, BENCH_SIGNALS, frame_ns, frame_ns > 0 ? text_ns / frame_ns : 0.0);
+    assert(frame_ns < text_ns);
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    RUN(test_round_trip);
+    RUN(test_encoder_overflow);
+    RUN(test_invalid_frames);
+    RUN(test_store);
+    RUN(test_lost_frames);
+    RUN(test_fuzz);
+    RUN(test_benchmark);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lightweight tracing of a value's way through the stages of a pipeline,
+ * e.g. from a received message to the pixels on the panel.
+ * Every traced item gets a correlation id, and every stage it passes records
+ * (time, id, stage) into the ring of the CPU core it runs on. Recording takes
+ * no lock, so it works in interrupts too. The rings are exported in the
+ * Chrome trace JSON format, which Perfetto and chrome://tracing open: every
+ * id is an async slice from its first to its last stage with the stages as
+ * instants inside.
+ * Plain C without ESP-IDF dependencies: the clock and the core id come from
+ * callbacks, so a host build (e.g. a simulator) records the same traces.
+ */
+
+#ifndef TRACE_MAX_CORES
+#define TRACE_MAX_CORES     2
+#endif
+
+/** Records kept per core, the oldest ones are overwritten. A power of 2. */
+#ifndef TRACE_RING_LEN
+#define TRACE_RING_LEN      128
+#endif
+
+_Static_assert((TRACE_RING_LEN & (TRACE_RING_LEN - 1)) == 0, "TRACE_RING_LEN has to be a power of 2");
+
+/** Id of nothing traced, not recorded */
+#define TRACE_ID_NONE       0
+
+typedef uint64_t (*trace_now_cb_t)(void);
+typedef uint32_t (*trace_core_cb_t)(void);
+
+/**
+ * @brief Write a part of the exported JSON.
+ *
+ * @return Whether to continue.
+ */
+typedef bool (*trace_write_cb_t)(const char *data, size_t len, void *ctx);
+
+typedef struct {
+    uint64_t time;              /*!< In us */
+    uint32_t seq;               /*!< Index of the record + 1, set last, so half written records are skipped */
+    uint16_t id;
+    uint8_t stage;
+    uint8_t core;
+} trace_record_t;
+
+typedef struct {
+    trace_record_t records[TRACE_RING_LEN];
+    uint32_t head;              /*!< Records written so far */
+} trace_ring_t;
+
+/**
+ * @brief Set the clock and the core id source and drop the records.
+ *
+ * @param now_cb  Monotonic time in us.
+ * @param core_cb Index of the current core, below TRACE_MAX_CORES. NULL for one core.
+ */
+void trace_init(trace_now_cb_t now_cb, trace_core_cb_t core_cb);
+
+/**
+ * @brief A new correlation id, never TRACE_ID_NONE.
+ */
+uint16_t trace_new_id(void);
+
+/**
+ * @brief Record that the item `id` reached `stage`.
+ */
+void trace_point(uint16_t id, uint8_t stage);
+
+/**
+ * @brief Export the records as Chrome trace JSON.
+ *
+ * @param stage_names Names of the stages. The first stage opens an item's slice, the last one closes it.
+ * @return Whether everything was written.
+ */
+bool trace_export_json(const char *const *stage_names, size_t stage_cnt, trace_write_cb_t write_cb, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,562 @@
+/* Traces of a simulated display pipeline, exported and checked with a strict JSON parser */
+
+#undef NDEBUG
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+#define EXPORT_MAX_LEN  (1024 * 1024)
+#define MAX_EVENTS      4096
+#define STRESS_CNT      200000
+
+typedef enum {
+    STAGE_MQTT_RX = 0,
+    STAGE_DECODED,
+    STAGE_UI_APPLY,
+    STAGE_FLUSH,
+    STAGE_DMA_DONE,
+    STAGE_CNT,
+} stage_t;
+
+static const char *const stage_names[STAGE_CNT] = {
+    [STAGE_MQTT_RX] = "mqtt_rx",
+    [STAGE_DECODED] = "decoded",
+    [STAGE_UI_APPLY] = "ui_apply",
+    [STAGE_FLUSH] = "flush",
+    [STAGE_DMA_DONE] = "dma_done",
+};
+
+/* A trace event of the export */
+typedef struct {
+    char name[32];
+    char ph[4];
+    double id;
+    double ts;
+    double tid;
+    double pid;
+    uint32_t field_cnt;
+} event_t;
+
+typedef struct {
+    const char *p;
+    const char *end;
+} parser_t;
+
+static struct {
+    char buf[EXPORT_MAX_LEN];
+    size_t len;
+    size_t fail_at;             /* The write failing once this many bytes were written */
+    uint32_t write_cnt;
+} out;
+
+static event_t events[MAX_EVENTS];
+static uint32_t event_cnt;
+
+static uint64_t sim_time;
+static _Thread_local uint32_t sim_core;
+
+static uint64_t sim_now(void)
+{
+    return sim_time;
+}
+
+static uint32_t sim_core_id(void)
+{
+    return sim_core;
+}
+
+static bool out_write(const char *data, size_t len, void *ctx)
+{
+    assert(ctx == &out);
+    out.write_cnt++;
+    if (out.len + len > out.fail_at) {
+        return false;
+    }
+    assert(out.len + len < sizeof(out.buf));
+    memcpy(&out.buf[out.len], data, len);
+    out.len += len;
+    out.buf[out.len] = '\0';
+    return true;
+}
+
+static bool export_json(void)
+{
+    out.len = 0;
+    out.fail_at = sizeof(out.buf) - 1;
+    out.write_cnt = 0;
+    return trace_export_json(stage_names, STAGE_CNT, out_write, &out);
+}
+
+/* Strict RFC 8259 parser, collecting the objects of "traceEvents" */
+
+static void skip_ws(parser_t *parser)
+{
+    while (parser->p < parser->end &&
+           (*parser->p == ' ' || *parser->p == '\t' || *parser->p == '\n' || *parser->p == '\r')) {
+        parser->p++;
+    }
+}
+
+static bool parse_literal(parser_t *parser, const char *literal)
+{
+    size_t len = strlen(literal);
+    if ((size_t)(parser->end - parser->p) < len || memcmp(parser->p, literal, len) != 0) {
+        return false;
+    }
+    parser->p += len;
+    return true;
+}
+
+static bool parse_string(parser_t *parser, char *str, size_t size)
+{
+    size_t len = 0;
+    if (parser->p >= parser->end || *parser->p++ != '"') {
+        return false;
+    }
+    while (parser->p < parser->end && *parser->p != '"') {
+        unsigned char c = (unsigned char)*parser->p++;
+        if (c < 0x20) {
+            return false;
+        }
+        if (c == '\\') {
+            if (parser->p >= parser->end || !strchr("\"\\/bfnrtu", *parser->p)) {
+                return false;
+            }
+            if (*parser->p++ == 'u') {
+                for (int i = 0; i < 4; ++i, ++parser->p) {
+                    if (parser->p >= parser->end || !strchr("0123456789abcdefABCDEF", *parser->p)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        if (str && len + 1 < size) {
+            str[len++] = (char)c;
+        }
+    }
+    if (str) {
+        str[len] = '\0';
+    }
+    return parser->p++ < parser->end;
+}
+
+static bool parse_number(parser_t *parser, double *number)
+{
+    const char *start = parser->p;
+    if (parser->p < parser->end && *parser->p == '-') {
+        parser->p++;
+    }
+    if (parser->p >= parser->end || *parser->p < '0' || *parser->p > '9') {
+        return false;
+    }
+    /* No leading zeros */
+    if (*parser->p++ == '0' && parser->p < parser->end && *parser->p >= '0' && *parser->p <= '9') {
+        return false;
+    }
+    while (parser->p < parser->end && *parser->p >= '0' && *parser->p <= '9') {
+        parser->p++;
+    }
+    if (parser->p < parser->end && *parser->p == '.') {
+        parser->p++;
+        if (parser->p >= parser->end || *parser->p < '0' || *parser->p > '9') {
+            return false;
+        }
+        while (parser->p < parser->end && *parser->p >= '0' && *parser->p <= '9') {
+            parser->p++;
+        }
+    }
+    if (parser->p < parser->end && (*parser->p == 'e' || *parser->p == 'E')) {
+        parser->p++;
+        if (parser->p < parser->end && (*parser->p == '+' || *parser->p == '-')) {
+            parser->p++;
+        }
+        if (parser->p >= parser->end || *parser->p < '0' || *parser->p > '9') {
+            return false;
+        }
+        while (parser->p < parser->end && *parser->p >= '0' && *parser->p <= '9') {
+            parser->p++;
+        }
+    }
+    if (number) {
+        char tmp[64];
+        size_t len = (size_t)(parser->p - start);
+        assert(len < sizeof(tmp));
+        memcpy(tmp, start, len);
+        tmp[len] = '\0';
+        *number = strtod(tmp, NULL);
+    }
+    return true;
+}
+
+static bool parse_value(parser_t *parser, int depth, bool events_array);
+
+/* `event` collects the fields of a trace event, NULL for other objects */
+static bool parse_object(parser_t *parser, int depth, event_t *event)
+{
+    parser->p++;
+    skip_ws(parser);
+    if (parser->p < parser->end && *parser->p == '}') {
+        parser->p++;
+        return true;
+    }
+    while (true) {
+        char key[32];
+        skip_ws(parser);
+        if (!parse_string(parser, key, sizeof(key))) {
+            return false;
+        }
+        skip_ws(parser);
+        if (parser->p >= parser->end || *parser->p++ != ':') {
+            return false;
+        }
+        skip_ws(parser);
+        bool ok;
+        if (event && strcmp(key, "name") == 0) {
+            ok = parse_string(parser, event->name, sizeof(event->name));
+        } else if (event && strcmp(key, "ph") == 0) {
+            ok = parse_string(parser, event->ph, sizeof(event->ph));
+        } else if (event && strcmp(key, "id") == 0) {
+            ok = parse_number(parser, &event->id);
+        } else if (event && strcmp(key, "ts") == 0) {
+            ok = parse_number(parser, &event->ts);
+        } else if (event && strcmp(key, "tid") == 0) {
+            ok = parse_number(parser, &event->tid);
+        } else if (event && strcmp(key, "pid") == 0) {
+            ok = parse_number(parser, &event->pid);
+        } else {
+            ok = parse_value(parser, depth + 1, !event && depth == 0 && strcmp(key, "traceEvents") == 0);
+        }
+        if (!ok) {
+            return false;
+        }
+        if (event) {
+            event->field_cnt++;
+        }
+        skip_ws(parser);
+        if (parser->p >= parser->end) {
+            return false;
+        }
+        if (*parser->p == '}') {
+            parser->p++;
+            return true;
+        }
+        if (*parser->p++ != ',') {
+            return false;
+        }
+    }
+}
+
+static bool parse_array(parser_t *parser, int depth, bool events_array)
+{
+    parser->p++;
+    skip_ws(parser);
+    if (parser->p < parser->end && *parser->p == ']') {
+        parser->p++;
+        return true;
+    }
+    while (true) {
+        skip_ws(parser);
+        bool ok;
+        if (events_array) {
+            if (parser->p >= parser->end || *parser->p != '{' || event_cnt == MAX_EVENTS) {
+                return false;
+            }
+            event_t *event = &events[event_cnt++];
+            memset(event, 0, sizeof(*event));
+            ok = parse_object(parser, depth + 1, event);
+        } else {
+            ok = parse_value(parser, depth + 1, false);
+        }
+        if (!ok) {
+            return false;
+        }
+        skip_ws(parser);
+        if (parser->p >= parser->end) {
+            return false;
+        }
+        if (*parser->p == ']') {
+            parser->p++;
+            return true;
+        }
+        if (*parser->p++ != ',') {
+            return false;
+        }
+    }
+}
+
+static bool parse_value(parser_t *parser, int depth, bool events_array)
+{
+    if (depth > 16 || parser->p >= parser->end) {
+        return false;
+    }
+    switch (*parser->p) {
+    case '{':
+        return parse_object(parser, depth, NULL);
+    case '[':
+        return parse_array(parser, depth, events_array);
+    case '"':
+        return parse_string(parser, NULL, 0);
+    case 't':
+        return parse_literal(parser, "true");
+    case 'f':
+        return parse_literal(parser, "false");
+    case 'n':
+        return parse_literal(parser, "null");
+    default:
+        return parse_number(parser, NULL);
+    }
+}
+
+/* Parse the whole export, which has to be one JSON object and nothing else */
+static bool parse_export(void)
+{
+    parser_t parser = { out.buf, out.buf + out.len };
+    event_cnt = 0;
+    skip_ws(&parser);
+    if (parser.p >= parser.end || *parser.p != '{' || !parse_object(&parser, 0, NULL)) {
+        return false;
+    }
+    skip_ws(&parser);
+    return parser.p == parser.end;
+}
+
+/* Every event is well formed, and the slices of an id are balanced and in time order */
+static void check_events(void)
+{
+    for (uint32_t i = 0; i < event_cnt; ++i) {
+        const event_t *event = &events[i];
+        assert(event->field_cnt == 7 && event->pid == 1);
+        assert(event->tid >= 0 && event->tid < TRACE_MAX_CORES);
+        assert(event->id >= 1 && event->id <= UINT16_MAX);
+        if (strcmp(event->ph, "b") == 0 || strcmp(event->ph, "e") == 0) {
+            assert(strcmp(event->name, "item") == 0);
+            /* Followed by the instant of the same record */
+            assert(i + 1 < event_cnt && strcmp(events[i + 1].ph, "n") == 0);
+            assert(events[i + 1].id == event->id && events[i + 1].ts == event->ts);
+            const char *stage = strcmp(event->ph, "b") == 0 ? stage_names[0] : stage_names[STAGE_CNT - 1];
+            assert(strcmp(events[i + 1].name, stage) == 0);
+        } else {
+            assert(strcmp(event->ph, "n") == 0);
+        }
+    }
+}
+
+static uint32_t count_events(const char *ph, const char *name)
+{
+    uint32_t cnt = 0;
+    for (uint32_t i = 0; i < event_cnt; ++i) {
+        cnt += strcmp(events[i].ph, ph) == 0 && (!name || strcmp(events[i].name, name) == 0);
+    }
+    return cnt;
+}
+
+static void test_parser(void)
+{
+    /* The checker itself rejects what Perfetto would */
+    static const char *const valid[] = {
+        "{}", " {\"a\":[1,-2.5e3,0.5,true,false,null,\"\\u00e9\\n\"]} ",
+        "{\"traceEvents\":[]}",
+    };
+    static const char *const invalid[] = {
+        "", "{", "{\"a\":1,}", "{\"a\":[1,]}", "{\"a\":01}", "{\"a\":1.}", "{\"a\":\"\x01\"}",
+        "{\"a\":\"\\x\"}", "{\"a\":tru}", "{} {}", "{\"a\" 1}", "[]", "{\"a\":\"unterminated}",
+    };
+    for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); ++i) {
+        out.len = strlen(valid[i]);
+        memcpy(out.buf, valid[i], out.len);
+        assert(parse_export());
+    }
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+        out.len = strlen(invalid[i]);
+        memcpy(out.buf, invalid[i], out.len);
+        assert(!parse_export());
+    }
+}
+
+static void test_empty(void)
+{
+    trace_init(sim_now, sim_core_id);
+    assert(export_json());
+    assert(parse_export() && event_cnt == 0);
+
+    /* Not recorded: no id, no clock, or a core out of range */
+    trace_point(TRACE_ID_NONE, STAGE_MQTT_RX);
+    sim_core = TRACE_MAX_CORES;
+    trace_point(trace_new_id(), STAGE_MQTT_RX);
+    sim_core = 0;
+    assert(export_json() && parse_export() && event_cnt == 0);
+    trace_init(NULL, NULL);
+    trace_point(1, STAGE_MQTT_RX);
+    assert(export_json() && parse_export() && event_cnt == 0);
+}
+
+/*
+ * The firmware's pipeline: the MQTT task on core 0 receives and decodes the values, the LVGL task
+ * on core 1 applies them and flushes, the DMA interrupt on core 1 ends the transfer. Values
+ * arriving while the UI is busy are coalesced and never reach the panel.
+ */
+static void test_pipeline(void)
+{
+    trace_init(sim_now, sim_core_id);
+    uint32_t item_cnt = 0;
+    uint32_t shown_cnt = 0;
+    uint16_t pending = TRACE_ID_NONE;
+    for (uint64_t frame = 0; frame < 20; ++frame) {
+        /* Two values per 33 ms frame, the first one replaced by the second */
+        for (int i = 0; i < 2; ++i) {
+            uint16_t id = trace_new_id();
+            sim_core = 0;
+            sim_time = 1000 + frame * 33000 + (uint64_t)i * 5000;
+            trace_point(id, STAGE_MQTT_RX);
+            sim_time += 40;
+            trace_point(id, STAGE_DECODED);
+            pending = id;
+            item_cnt++;
+        }
+        sim_core = 1;
+        sim_time = 1000 + frame * 33000 + 16000;
+        trace_point(pending, STAGE_UI_APPLY);
+        sim_time += 6000;
+        trace_point(pending, STAGE_FLUSH);
+        sim_time += 4000;
+        trace_point(pending, STAGE_DMA_DONE);
+        shown_cnt++;
+    }
+    assert(export_json());
+    assert(parse_export());
+    check_events();
+    printf("%u items, %u events, %u bytes\n", (unsigned)item_cnt, (unsigned)event_cnt, (unsigned)out.len);
+
+    assert(count_events("b", NULL) == item_cnt && count_events("e", NULL) == shown_cnt);
+    assert(count_events("n", "decoded") == item_cnt && count_events("n", "dma_done") == shown_cnt);
+
+    /* The stages of an item are on the core they ran on, in order */
+    for (uint32_t i = 0; i < event_cnt; ++i) {
+        const event_t *event = &events[i];
+        if (strcmp(event->ph, "n") != 0) {
+            continue;
+        }
+        bool mqtt = strcmp(event->name, "mqtt_rx") == 0 || strcmp(event->name, "decoded") == 0;
+        assert(event->tid == (mqtt ? 0 : 1));
+    }
+    for (uint32_t i = 0; i < event_cnt; ++i) {
+        if (strcmp(events[i].ph, "e") != 0) {
+            continue;
+        }
+        double begin = -1;
+        for (uint32_t j = 0; j < event_cnt; ++j) {
+            if (strcmp(events[j].ph, "b") == 0 && events[j].id == events[i].id) {
+                begin = events[j].ts;
+            }
+        }
+        /* 21 ms from the value to the panel: 11 ms waiting for the UI, 6 ms flushing and 4 ms in the DMA */
+        assert(begin >= 0 && events[i].ts - begin == 16000 - 5000 + 6000 + 4000);
+    }
+}
+
+static void test_ring_overflow(void)
+{
+    trace_init(sim_now, sim_core_id);
+    sim_core = 0;
+    const char *const names[] = { "first", "last" };
+    /* Only the newest records are kept */
+    for (uint32_t i = 0; i < TRACE_RING_LEN * 3 + 5; ++i) {
+        sim_time = i;
+        trace_point(trace_new_id(), (uint8_t)(i % 3));
+    }
+    assert(export_json() && parse_export());
+    check_events();
+    assert(count_events("n", NULL) == TRACE_RING_LEN);
+    assert(events[1].ts == TRACE_RING_LEN * 2 + 5);
+
+    /* Stages without a name: the export stays valid */
+    out.len = 0;
+    out.fail_at = sizeof(out.buf) - 1;
+    assert(trace_export_json(names, 2, out_write, &out));
+    assert(parse_export() && count_events("n", "?") > 0);
+}
+
+static void test_write_failure(void)
+{
+    trace_init(sim_now, sim_core_id);
+    sim_core = 1;
+    for (int i = 0; i < 50; ++i) {
+        uint16_t id = trace_new_id();
+        for (int stage = 0; stage < STAGE_CNT; ++stage) {
+            trace_point(id, (uint8_t)stage);
+        }
+    }
+    assert(export_json() && parse_export());
+    size_t full_len = out.len;
+    uint32_t full_write_cnt = out.write_cnt;
+
+    /* Stops at the first refused write */
+    for (size_t fail_at = 0; fail_at < full_len; fail_at += 97) {
+        out.len = 0;
+        out.fail_at = fail_at;
+        out.write_cnt = 0;
+        assert(!trace_export_json(stage_names, STAGE_CNT, out_write, &out));
+        assert(out.len <= fail_at && out.write_cnt <= full_write_cnt);
+    }
+}
+
+static uint64_t stress_time;
+
+static uint64_t stress_now(void)
+{
+    return __atomic_add_fetch(&stress_time, 1, __ATOMIC_RELAXED);
+}
+
+static void *stress_writer(void *arg)
+{
+    sim_core = (uint32_t)(uintptr_t)arg;
+    for (int i = 0; i < STRESS_CNT; ++i) {
+        trace_point(trace_new_id(), (uint8_t)(i % STAGE_CNT));
+    }
+    return NULL;
+}
+
+/* Exported while both cores record: half written records are skipped, the JSON stays valid */
+static void test_concurrent(void)
+{
+    trace_init(stress_now, sim_core_id);
+    pthread_t writers[TRACE_MAX_CORES];
+    for (int i = 0; i < TRACE_MAX_CORES; ++i) {
+        assert(pthread_create(&writers[i], NULL, stress_writer, (void *)(uintptr_t)i) == 0);
+    }
+    uint32_t export_cnt = 0;
+    uint32_t max_events = 0;
+    do {
+        assert(export_json());
+        assert(parse_export());
+        check_events();
+        assert(count_events("n", NULL) <= TRACE_RING_LEN * TRACE_MAX_CORES);
+        max_events = event_cnt > max_events ? event_cnt : max_events;
+        export_cnt++;
+    } while (__atomic_load_n(&stress_time, __ATOMIC_RELAXED) < (uint64_t)STRESS_CNT * TRACE_MAX_CORES &&
+             export_cnt < 1000);
+    for (int i = 0; i < TRACE_MAX_CORES; ++i) {
+        pthread_join(writers[i], NULL);
+    }
+    assert(export_json() && parse_export());
+    check_events();
+    assert(count_events("n", NULL) == TRACE_RING_LEN * TRACE_MAX_CORES);
+    printf("%u exports during the writes, up to %u events\n", (unsigned)export_cnt, (unsigned)max_events);
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    RUN(test_parser);
+    RUN(test_empty);
+    RUN(test_pipeline);
+    RUN(test_ring_overflow);
+    RUN(test_write_failure);
+    RUN(test_concurrent);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "trace.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static struct {
+    trace_now_cb_t now_cb;
+    trace_core_cb_t core_cb;
+    uint16_t next_id;
+    trace_ring_t rings[TRACE_MAX_CORES];
+} s_trace;
+
+void trace_init(trace_now_cb_t now_cb, trace_core_cb_t core_cb)
+{
+    memset(&s_trace, 0, sizeof(s_trace));
+    s_trace.now_cb = now_cb;
+    s_trace.core_cb = core_cb;
+}
+
+uint16_t trace_new_id(void)
+{
+    uint16_t id;
+    do {
+        id = __atomic_add_fetch(&s_trace.next_id, 1, __ATOMIC_RELAXED);
+    } while (id == TRACE_ID_NONE);
+    return id;
+}
+
+void trace_point(uint16_t id, uint8_t stage)
+{
+    if (id == TRACE_ID_NONE || !s_trace.now_cb) {
+        return;
+    }
+    uint32_t core = s_trace.core_cb ? s_trace.core_cb() : 0;
+    if (core >= TRACE_MAX_CORES) {
+        return;
+    }
+    /* Other tasks and interrupts of the core may record in between, so the slot is reserved atomically */
+    trace_ring_t *ring = &s_trace.rings[core];
+    uint32_t index = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    trace_record_t *record = &ring->records[index % TRACE_RING_LEN];
+    __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    record->time = s_trace.now_cb();
+    record->id = id;
+    record->stage = stage;
+    record->core = (uint8_t)core;
+    __atomic_store_n(&record->seq, index + 1, __ATOMIC_RELEASE);
+}
+
+static bool trace_write_record(const trace_record_t *record, const char *const *stage_names, size_t stage_cnt,
+                               bool *first, trace_write_cb_t write_cb, void *ctx)
+{
+    char buf[192];
+    const char *name = record->stage < stage_cnt ? stage_names[record->stage] : "?";
+    /* The slice of the id: begins with the first stage, ends with the last one */
+    const char *phase = record->stage == 0 ? "b" : (size_t)record->stage + 1 == stage_cnt ? "e" : NULL;
+    int len = 0;
+    if (phase) {
+        len = snprintf(buf, sizeof(buf),
+                       "%s{\"name\":\"item\",\"cat\":\"trace\",\"ph\":\"%s\",\"id\":%u,"
+                       "\"ts\":%" PRIu64 ",\"pid\":1,\"tid\":%u}",
+                       *first ? "" : ",\n", phase, record->id, record->time, record->core);
+        *first = false;
+    }
+    len += snprintf(&buf[len], sizeof(buf) - (size_t)len,
+                    "%s{\"name\":\"%s\",\"cat\":\"trace\",\"ph\":\"n\",\"id\":%u,"
+                    "\"ts\":%" PRIu64 ",\"pid\":1,\"tid\":%u}",
+                    *first ? "" : ",\n", name, record->id, record->time, record->core);
+    *first = false;
+    return len > 0 && (size_t)len < sizeof(buf) && write_cb(buf, (size_t)len, ctx);
+}
+
+bool trace_export_json(const char *const *stage_names, size_t stage_cnt, trace_write_cb_t write_cb, void *ctx)
+{
+    static const char head[] = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    static const char tail[] = "\n]}\n";
+    if (!write_cb(head, sizeof(head) - 1, ctx)) {
+        return false;
+    }
+    bool first = true;
+    for (int core = 0; core < TRACE_MAX_CORES; ++core) {
+        const trace_ring_t *ring = &s_trace.rings[core];
+        uint32_t head_index = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint32_t start = head_index > TRACE_RING_LEN ? head_index - TRACE_RING_LEN : 0;
+        for (uint32_t i = start; i < head_index; ++i) {
+            /* Skip the records being written or overwritten while copied */
+            const trace_record_t *slot = &ring->records[i % TRACE_RING_LEN];
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != i + 1) {
+                continue;
+            }
+            trace_record_t record = *slot;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != i + 1) {
+                continue;
+            }
+            if (!trace_write_record(&record, stage_names, stage_cnt, &first, write_cb, ctx)) {
+                return false;
+            }
+        }
+    }
+    return write_cb(tail, sizeof(tail) - 1, ctx);
+}
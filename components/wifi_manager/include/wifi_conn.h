@@ -0,0 +1,134 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Wi-Fi connection state machine: which AP to connect to and when to retry.
+ * The AP of the last connection is cached, so the next connection can skip
+ * the scan of every channel. Failed attempts are retried with an exponential
+ * backoff with jitter instead of at once.
+ * Plain C without ESP-IDF dependencies: the Wi-Fi driver, the timer and the
+ * storage of the cached AP are behind a driver interface, and the time is
+ * passed by the caller, so it can be run on the host with a simulated driver.
+ */
+
+#ifndef WIFI_CONN_BACKOFF_MIN_MS
+#define WIFI_CONN_BACKOFF_MIN_MS    500
+#endif
+
+#ifndef WIFI_CONN_BACKOFF_MAX_MS
+#define WIFI_CONN_BACKOFF_MAX_MS    30000
+#endif
+
+/** Time to get an IP after the association */
+#ifndef WIFI_CONN_IP_TIMEOUT_MS
+#define WIFI_CONN_IP_TIMEOUT_MS     15000
+#endif
+
+/** Passed to `set_timer` to stop the timer */
+#define WIFI_CONN_TIMER_OFF         UINT32_MAX
+
+typedef enum {
+    WIFI_CONN_IDLE = 0,         /*!< Not connecting, e.g. no credentials */
+    WIFI_CONN_CONNECTING,       /*!< Waiting for the association */
+    WIFI_CONN_ASSOCIATED,       /*!< Waiting for the IP */
+    WIFI_CONN_CONNECTED,
+    WIFI_CONN_BACKOFF,          /*!< Waiting for the next attempt */
+} wifi_conn_state_t;
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    bool valid;
+    uint32_t ip;                /*!< IPv4 address got from the AP's network */
+} wifi_conn_ap_t;
+
+typedef struct {
+    /** Start an attempt with the cached AP, or with a scan of every channel if `ap` is NULL */
+    void (*connect)(void *ctx, const wifi_conn_ap_t *ap);
+    /** Drop the association, which has to be reported with wifi_conn_disconnected() */
+    void (*disconnect)(void *ctx);
+    /** Call wifi_conn_timeout() after `delay_ms`, replacing the running timer */
+    void (*set_timer)(void *ctx, uint32_t delay_ms);
+    /** Store the AP for the next boot, NULL to erase it */
+    void (*save_ap)(void *ctx, const wifi_conn_ap_t *ap);
+    uint32_t (*random)(void *ctx);
+    void *ctx;
+} wifi_conn_driver_t;
+
+typedef struct {
+    uint32_t connect_cnt;
+    uint32_t fast_cnt;          /**< Connections to the cached AP without a full scan */
+    uint32_t fast_fail_cnt;     /**< Attempts with the cached AP that failed */
+    uint32_t fail_cnt;          /**< Failed attempts, including the ones with the cached AP */
+    uint32_t ip_reused_cnt;     /**< Connections getting the same IP as the last one */
+    uint32_t last_connect_ms;   /**< From the first attempt to the IP, including the retries */
+    uint32_t max_connect_ms;
+    uint32_t last_assoc_ms;     /**< Association of the successful attempt */
+    uint32_t last_ip_ms;        /**< From the association to the IP */
+} wifi_conn_stat_t;
+
+typedef struct {
+    wifi_conn_state_t state;
+    wifi_conn_driver_t driver;
+    wifi_conn_ap_t ap;          /*!< Cached AP */
+    wifi_conn_ap_t assoc;       /*!< AP of the current association */
+    uint32_t attempt;           /*!< Failed attempts since the last connection */
+    bool fast;                  /*!< The current attempt uses the cached AP */
+    bool fast_failed;           /*!< Scan every channel until the next connection */
+    uint32_t start_time;        /*!< First attempt since the last connection */
+    uint32_t attempt_time;
+    uint32_t assoc_time;
+    wifi_conn_stat_t stat;
+} wifi_conn_t;
+
+/**
+ * @brief Set up an idle state machine.
+ *
+ * @param ap The AP stored by `save_ap`, NULL if none.
+ */
+void wifi_conn_init(wifi_conn_t *conn, const wifi_conn_driver_t *driver, const wifi_conn_ap_t *ap);
+
+/**
+ * @brief Start connecting now, also if waiting for a retry.
+ */
+void wifi_conn_start(wifi_conn_t *conn, uint32_t now);
+
+/**
+ * @brief Stop connecting. The association isn't dropped.
+ */
+void wifi_conn_stop(wifi_conn_t *conn);
+
+/**
+ * @brief Forget the cached AP, e.g. when the credentials changed.
+ */
+void wifi_conn_forget_ap(wifi_conn_t *conn);
+
+void wifi_conn_associated(wifi_conn_t *conn, const uint8_t bssid[6], uint8_t channel, uint32_t now);
+
+void wifi_conn_got_ip(wifi_conn_t *conn, uint32_t ip, uint32_t now);
+
+/**
+ * @brief Report a failed attempt or a lost connection.
+ */
+void wifi_conn_disconnected(wifi_conn_t *conn, uint32_t now);
+
+/**
+ * @brief Report the end of the time set by `set_timer`.
+ */
+void wifi_conn_timeout(wifi_conn_t *conn, uint32_t now);
+
+/**
+ * @brief Delay before retrying after `attempt` failed attempts, with jitter.
+ */
+uint32_t wifi_conn_backoff_ms(uint32_t attempt, uint32_t random);
+
+#ifdef __cplusplus
+}
+#endif
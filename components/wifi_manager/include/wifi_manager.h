@@ -5,6 +5,7 @@
 
 #include "esp_err.h"
 #include "esp_netif_ip_addr.h"
+#include "wifi_conn.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,10 +30,20 @@ typedef struct {
     esp_ip4_addr_t ip;
 } wifi_manager_ip_info_t;
 
+typedef wifi_conn_stat_t wifi_manager_connect_stat_t;
+
 typedef void (*wifi_manager_event_cb_t)(wifi_manager_event_t event,
                                         void *ctx,
                                         const void *event_data);
 
+/**
+ * @brief Initialize NVS and load the stored credentials without starting Wi-Fi.
+ *
+ * Called by wifi_manager_init() too, so it can run earlier on its own
+ * (e.g. to show the stored credentials while Wi-Fi is still starting).
+ */
+esp_err_t wifi_manager_nvs_init(void);
+
 /**
  * @brief Initialize Wi-Fi manager and (optionally) load stored credentials.
  *
@@ -47,6 +58,8 @@ esp_err_t wifi_manager_register_event_handler(wifi_manager_event_cb_t cb, void *
 
 /**
  * @brief Update credentials (optionally persisting them) and reconnect.
+ *
+ * An empty SSID clears the credentials: connecting stops and the AP is left.
  */
 esp_err_t wifi_manager_set_credentials(const wifi_manager_credentials_t *creds, bool persist);
 
@@ -65,6 +78,11 @@ const wifi_manager_credentials_t *wifi_manager_get_credentials(void);
  */
 bool wifi_manager_has_credentials(void);
 
+/**
+ * @brief Connection times and how often the cached AP was used. Times are in ms.
+ */
+void wifi_manager_get_connect_stat(wifi_manager_connect_stat_t *stat);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,411 @@
+/* Connection state machine against a simulated Wi-Fi driver, AP and DHCP server */
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "wifi_conn.h"
+
+#define SCAN_MS         1500    /* Association after a scan of every channel */
+#define SCAN_FAIL_MS    2000
+#define FAST_MS         100     /* Association with the known channel and BSSID */
+#define FAST_FAIL_MS    300
+#define DHCP_MS         200
+#define DISCONNECT_MS   10
+#define IP_A            0x0a00000a
+#define IP_B            0x0a00000b
+
+typedef enum {
+    SIM_NONE,
+    SIM_ASSOCIATED,
+    SIM_FAILED,
+    SIM_GOT_IP,
+    SIM_DISCONNECTED,
+} sim_event_t;
+
+/* The driver reports one event at a time, the timer is separate */
+static struct {
+    uint32_t now;
+    sim_event_t event;
+    uint32_t event_time;
+    uint32_t timer_time;        /* WIFI_CONN_TIMER_OFF if not running */
+
+    /* The network */
+    bool ap_up;
+    uint8_t bssid[6];
+    uint8_t channel;
+    bool dhcp_up;
+    uint32_t ip;
+
+    uint32_t connect_cnt;
+    uint32_t fast_connect_cnt;
+    uint32_t disconnect_cnt;
+    uint32_t save_cnt;
+    wifi_conn_ap_t saved;
+    uint32_t random;
+} sim;
+
+static wifi_conn_t conn;
+
+static void sim_event(sim_event_t event, uint32_t delay)
+{
+    sim.event = event;
+    sim.event_time = sim.now + delay;
+}
+
+static void sim_connect(void *ctx, const wifi_conn_ap_t *ap)
+{
+    assert(ctx == &sim);
+    sim.connect_cnt++;
+    if (ap) {
+        assert(ap->valid);
+        sim.fast_connect_cnt++;
+        bool found = sim.ap_up && ap->channel == sim.channel && memcmp(ap->bssid, sim.bssid, 6) == 0;
+        sim_event(found ? SIM_ASSOCIATED : SIM_FAILED, found ? FAST_MS : FAST_FAIL_MS);
+    } else {
+        sim_event(sim.ap_up ? SIM_ASSOCIATED : SIM_FAILED, sim.ap_up ? SCAN_MS : SCAN_FAIL_MS);
+    }
+}
+
+static void sim_disconnect(void *ctx)
+{
+    assert(ctx == &sim);
+    sim.disconnect_cnt++;
+    sim_event(SIM_DISCONNECTED, DISCONNECT_MS);
+}
+
+static void sim_set_timer(void *ctx, uint32_t delay_ms)
+{
+    assert(ctx == &sim);
+    sim.timer_time = delay_ms == WIFI_CONN_TIMER_OFF ? WIFI_CONN_TIMER_OFF : sim.now + delay_ms;
+}
+
+static void sim_save_ap(void *ctx, const wifi_conn_ap_t *ap)
+{
+    assert(ctx == &sim);
+    sim.save_cnt++;
+    if (ap) {
+        sim.saved = *ap;
+    } else {
+        memset(&sim.saved, 0, sizeof(sim.saved));
+    }
+}
+
+static uint32_t sim_random(void *ctx)
+{
+    assert(ctx == &sim);
+    sim.random = sim.random * 1103515245 + 12345;
+    return sim.random >> 8;
+}
+
+static const wifi_conn_driver_t sim_driver = {
+    .connect = sim_connect,
+    .disconnect = sim_disconnect,
+    .set_timer = sim_set_timer,
+    .save_ap = sim_save_ap,
+    .random = sim_random,
+    .ctx = &sim,
+};
+
+/* Boot with the AP stored by the previous run, if any */
+static void sim_boot(const wifi_conn_ap_t *stored)
+{
+    wifi_conn_ap_t saved = sim.saved;
+    memset(&sim, 0, sizeof(sim));
+    sim.saved = saved;
+    sim.timer_time = WIFI_CONN_TIMER_OFF;
+    sim.ap_up = true;
+    sim.dhcp_up = true;
+    sim.channel = 6;
+    memcpy(sim.bssid, "\x24\x0a\xc4\x01\x02\x03", 6);
+    sim.ip = IP_A;
+    sim.random = 1;
+    wifi_conn_init(&conn, &sim_driver, stored);
+}
+
+/* Deliver the events and timeouts due until `end`, in order */
+static void sim_run_until(uint32_t end)
+{
+    while (true) {
+        bool event_due = sim.event != SIM_NONE && sim.event_time <= end;
+        bool timer_due = sim.timer_time != WIFI_CONN_TIMER_OFF && sim.timer_time <= end;
+        if (!event_due && !timer_due) {
+            break;
+        }
+        if (event_due && (!timer_due || sim.event_time <= sim.timer_time)) {
+            sim.now = sim.event_time;
+            sim_event_t event = sim.event;
+            sim.event = SIM_NONE;
+            switch (event) {
+            case SIM_ASSOCIATED:
+                wifi_conn_associated(&conn, sim.bssid, sim.channel, sim.now);
+                if (sim.dhcp_up) {
+                    sim_event(SIM_GOT_IP, DHCP_MS);
+                }
+                break;
+            case SIM_GOT_IP:
+                wifi_conn_got_ip(&conn, sim.ip, sim.now);
+                break;
+            case SIM_FAILED:
+            case SIM_DISCONNECTED:
+                wifi_conn_disconnected(&conn, sim.now);
+                break;
+            default:
+                break;
+            }
+        } else {
+            sim.now = sim.timer_time;
+            sim.timer_time = WIFI_CONN_TIMER_OFF;
+            wifi_conn_timeout(&conn, sim.now);
+        }
+    }
+    sim.now = end;
+}
+
+/* The link drops while connected */
+static void sim_link_lost(void)
+{
+    sim_event(SIM_DISCONNECTED, 0);
+    sim_run_until(sim.now);
+}
+
+static void test_cold_boot(void)
+{
+    sim_boot(NULL);
+    wifi_conn_start(&conn, 0);
+    assert(conn.state == WIFI_CONN_CONNECTING);
+    assert(sim.connect_cnt == 1 && sim.fast_connect_cnt == 0);
+    sim_run_until(10000);
+
+    assert(conn.state == WIFI_CONN_CONNECTED);
+    assert(sim.timer_time == WIFI_CONN_TIMER_OFF);
+    assert(sim.save_cnt == 1 && sim.saved.valid);
+    assert(sim.saved.channel == 6 && sim.saved.ip == IP_A && memcmp(sim.saved.bssid, sim.bssid, 6) == 0);
+    const wifi_conn_stat_t *stat = &conn.stat;
+    assert(stat->connect_cnt == 1 && stat->fast_cnt == 0 && stat->fail_cnt == 0 && stat->ip_reused_cnt == 0);
+    assert(stat->last_assoc_ms == SCAN_MS && stat->last_ip_ms == DHCP_MS);
+    assert(stat->last_connect_ms == SCAN_MS + DHCP_MS);
+}
+
+static void test_warm_boot(void)
+{
+    /* The AP stored by the cold boot */
+    wifi_conn_ap_t stored = sim.saved;
+    sim_boot(&stored);
+    wifi_conn_start(&conn, 0);
+    assert(sim.fast_connect_cnt == 1);
+    sim_run_until(10000);
+
+    assert(conn.state == WIFI_CONN_CONNECTED);
+    assert(conn.stat.fast_cnt == 1 && conn.stat.ip_reused_cnt == 1);
+    assert(conn.stat.last_connect_ms == FAST_MS + DHCP_MS);
+    /* Nothing changed, so the flash isn't written */
+    assert(sim.save_cnt == 0);
+
+    /* A stored AP without a channel is not used */
+    stored.channel = 0;
+    sim_boot(&stored);
+    wifi_conn_start(&conn, 0);
+    assert(sim.fast_connect_cnt == 0);
+}
+
+static void test_ap_moved(void)
+{
+    wifi_conn_ap_t stored = sim.saved;
+    stored.channel = 6;
+    sim_boot(&stored);
+    sim.channel = 11;
+    sim.ip = IP_B;
+    wifi_conn_start(&conn, 0);
+    sim_run_until(10000);
+
+    /* The cached AP fails, the scan follows at once without a backoff */
+    assert(conn.state == WIFI_CONN_CONNECTED);
+    assert(sim.connect_cnt == 2 && sim.fast_connect_cnt == 1);
+    assert(conn.stat.fast_fail_cnt == 1 && conn.stat.fail_cnt == 1 && conn.stat.fast_cnt == 0);
+    assert(conn.stat.last_connect_ms == FAST_FAIL_MS + SCAN_MS + DHCP_MS);
+    assert(sim.save_cnt == 1 && sim.saved.channel == 11 && sim.saved.ip == IP_B);
+    assert(conn.stat.ip_reused_cnt == 0);
+}
+
+static void test_ap_down(void)
+{
+    sim_boot(NULL);
+    sim.ap_up = false;
+    wifi_conn_start(&conn, 0);
+
+    /* Retries with a growing delay, the upper half of it random */
+    uint32_t attempt_times[32] = { 0 };
+    uint32_t attempt_cnt = 1;
+    while (sim.now < 300000) {
+        uint32_t connect_cnt = sim.connect_cnt;
+        sim_run_until(sim.now + 1);
+        if (sim.connect_cnt != connect_cnt) {
+            assert(attempt_cnt < 32);
+            attempt_times[attempt_cnt++] = sim.now;
+        }
+    }
+    assert(conn.stat.fail_cnt >= attempt_cnt);
+    for (uint32_t i = 1; i < attempt_cnt; ++i) {
+        uint32_t gap = attempt_times[i] - attempt_times[i - 1] - SCAN_FAIL_MS;
+        uint32_t delay = WIFI_CONN_BACKOFF_MIN_MS << (i - 1 < 16 ? i - 1 : 16);
+        if (delay > WIFI_CONN_BACKOFF_MAX_MS) {
+            delay = WIFI_CONN_BACKOFF_MAX_MS;
+        }
+        assert(gap >= delay / 2 && gap <= delay);
+    }
+    printf("%u attempts in 5 min with the AP down\n", (unsigned)attempt_cnt);
+    assert(attempt_cnt > 300000 / (WIFI_CONN_BACKOFF_MAX_MS + SCAN_FAIL_MS));
+    assert(attempt_cnt < 300000 / (WIFI_CONN_BACKOFF_MAX_MS / 2 + SCAN_FAIL_MS) + 8);
+    assert(sim.fast_connect_cnt == 0 && sim.save_cnt == 0);
+
+    /* The AP is back: connected by the next attempt */
+    sim.ap_up = true;
+    assert(conn.state == WIFI_CONN_BACKOFF || conn.state == WIFI_CONN_CONNECTING);
+    sim_run_until(sim.now + WIFI_CONN_BACKOFF_MAX_MS + SCAN_FAIL_MS + SCAN_MS + DHCP_MS);
+    assert(conn.state == WIFI_CONN_CONNECTED);
+    assert(conn.stat.last_connect_ms >= 300000);
+    assert(conn.stat.max_connect_ms == conn.stat.last_connect_ms);
+    assert(conn.attempt == 0);
+}
+
+static void test_no_ip(void)
+{
+    sim_boot(NULL);
+    sim.dhcp_up = false;
+    wifi_conn_start(&conn, 0);
+    sim_run_until(SCAN_MS);
+    assert(conn.state == WIFI_CONN_ASSOCIATED);
+    assert(sim.timer_time == SCAN_MS + WIFI_CONN_IP_TIMEOUT_MS);
+
+    /* The association is dropped when the IP doesn't come, and counts as a failed attempt */
+    sim_run_until(SCAN_MS + WIFI_CONN_IP_TIMEOUT_MS + DISCONNECT_MS);
+    assert(sim.disconnect_cnt == 1);
+    assert(conn.state == WIFI_CONN_BACKOFF && conn.stat.fail_cnt == 1);
+    assert(sim.save_cnt == 0);
+
+    sim.dhcp_up = true;
+    sim_run_until(sim.now + WIFI_CONN_BACKOFF_MIN_MS + SCAN_MS + DHCP_MS);
+    assert(conn.state == WIFI_CONN_CONNECTED);
+    assert(sim.connect_cnt == 2);
+}
+
+static void test_link_lost(void)
+{
+    sim_boot(NULL);
+    wifi_conn_start(&conn, 0);
+    sim_run_until(10000);
+    assert(conn.state == WIFI_CONN_CONNECTED);
+
+    /* Retried at once with the cached AP */
+    sim_link_lost();
+    assert(conn.state == WIFI_CONN_CONNECTING);
+    assert(sim.connect_cnt == 2 && sim.fast_connect_cnt == 1);
+    sim_run_until(20000);
+    assert(conn.state == WIFI_CONN_CONNECTED);
+    assert(conn.stat.connect_cnt == 2 && conn.stat.fast_cnt == 1 && conn.stat.ip_reused_cnt == 1);
+    assert(conn.stat.last_connect_ms == FAST_MS + DHCP_MS);
+    assert(sim.save_cnt == 1);
+
+    /* A new IP of the current connection (DHCP lease renewal) is stored */
+    wifi_conn_got_ip(&conn, IP_B, 21000);
+    assert(sim.save_cnt == 2 && sim.saved.ip == IP_B);
+    wifi_conn_got_ip(&conn, IP_B, 22000);
+    assert(sim.save_cnt == 2);
+    assert(conn.stat.connect_cnt == 2);
+}
+
+static void test_credentials_changed(void)
+{
+    wifi_conn_ap_t stored = sim.saved;
+    sim_boot(&stored);
+    wifi_conn_start(&conn, 0);
+    sim_run_until(10000);
+    assert(conn.stat.fast_cnt == 1);
+    uint32_t save_cnt = sim.save_cnt;
+
+    /* The cached AP belongs to the old network */
+    wifi_conn_forget_ap(&conn);
+    assert(sim.save_cnt == save_cnt + 1 && !sim.saved.valid);
+    wifi_conn_forget_ap(&conn);
+    assert(sim.save_cnt == save_cnt + 1);
+
+    wifi_conn_disconnected(&conn, 10000);
+    assert(sim.fast_connect_cnt == 1 && sim.connect_cnt == 2);
+    sim_run_until(20000);
+    assert(conn.state == WIFI_CONN_CONNECTED && sim.saved.valid);
+}
+
+static void test_stop_and_restart(void)
+{
+    sim_boot(NULL);
+    sim.ap_up = false;
+    wifi_conn_start(&conn, 0);
+    sim_run_until(SCAN_FAIL_MS);
+    assert(conn.state == WIFI_CONN_BACKOFF && sim.timer_time != WIFI_CONN_TIMER_OFF);
+
+    /* No attempt while stopped, and late events of the driver are ignored */
+    wifi_conn_stop(&conn);
+    assert(conn.state == WIFI_CONN_IDLE && sim.timer_time == WIFI_CONN_TIMER_OFF);
+    sim_run_until(200000);
+    assert(sim.connect_cnt == 1);
+    wifi_conn_associated(&conn, sim.bssid, sim.channel, sim.now);
+    wifi_conn_got_ip(&conn, IP_A, sim.now);
+    wifi_conn_disconnected(&conn, sim.now);
+    wifi_conn_timeout(&conn, sim.now);
+    assert(conn.state == WIFI_CONN_IDLE && sim.connect_cnt == 1 && conn.stat.connect_cnt == 0);
+
+    /* A start during the backoff tries at once, with the backoff reset */
+    sim.ap_up = true;
+    wifi_conn_start(&conn, sim.now);
+    sim_run_until(sim.now + 100);
+    assert(conn.state == WIFI_CONN_CONNECTING);
+    sim_run_until(sim.now + SCAN_MS + DHCP_MS);
+    assert(conn.state == WIFI_CONN_CONNECTED);
+
+    /* The AP goes away until a few attempts failed */
+    sim.ap_up = false;
+    sim_link_lost();
+    while (conn.state != WIFI_CONN_BACKOFF || conn.attempt < 3) {
+        sim_run_until(sim.now + 1);
+    }
+    uint32_t connect_cnt = sim.connect_cnt;
+    sim.ap_up = true;
+    wifi_conn_start(&conn, sim.now);
+    assert(sim.connect_cnt == connect_cnt + 1 && conn.attempt == 0);
+    assert(sim.fast_connect_cnt == 2 && sim.timer_time == WIFI_CONN_TIMER_OFF);
+    sim_run_until(sim.now + FAST_MS + DHCP_MS);
+    assert(conn.state == WIFI_CONN_CONNECTED);
+    assert(conn.stat.last_connect_ms == FAST_MS + DHCP_MS);
+}
+
+static void test_backoff(void)
+{
+    for (uint32_t attempt = 0; attempt < 100; ++attempt) {
+        uint32_t delay = WIFI_CONN_BACKOFF_MIN_MS << (attempt < 16 ? attempt : 16);
+        if (delay > WIFI_CONN_BACKOFF_MAX_MS) {
+            delay = WIFI_CONN_BACKOFF_MAX_MS;
+        }
+        assert(wifi_conn_backoff_ms(attempt, 0) == delay / 2);
+        assert(wifi_conn_backoff_ms(attempt, delay / 2) == delay);
+        assert(wifi_conn_backoff_ms(attempt, UINT32_MAX) <= delay);
+    }
+    assert(wifi_conn_backoff_ms(UINT32_MAX, 0) == WIFI_CONN_BACKOFF_MAX_MS / 2);
+}
+
+#define RUN(test) do { test(); printf("%s: PASS\n", #test); } while (0)
+
+int main(void)
+{
+    RUN(test_cold_boot);
+    RUN(test_warm_boot);
+    RUN(test_ap_moved);
+    RUN(test_ap_down);
+    RUN(test_no_ip);
+    RUN(test_link_lost);
+    RUN(test_credentials_changed);
+    RUN(test_stop_and_restart);
+    RUN(test_backoff);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "wifi_conn.h"
+
+#include <string.h>
+
+static void wifi_conn_attempt(wifi_conn_t *conn, uint32_t now)
+{
+    conn->fast = conn->ap.valid && !conn->fast_failed;
+    conn->attempt_time = now;
+    conn->state = WIFI_CONN_CONNECTING;
+    conn->driver.set_timer(conn->driver.ctx, WIFI_CONN_TIMER_OFF);
+    conn->driver.connect(conn->driver.ctx, conn->fast ? &conn->ap : NULL);
+}
+
+static void wifi_conn_failed(wifi_conn_t *conn, uint32_t now)
+{
+    conn->stat.fail_cnt++;
+    if (conn->fast) {
+        /* The AP may have moved to another channel, or another AP of the network is closer:
+         * scan at once instead of waiting */
+        conn->stat.fast_fail_cnt++;
+        conn->fast_failed = true;
+        wifi_conn_attempt(conn, now);
+        return;
+    }
+    conn->state = WIFI_CONN_BACKOFF;
+    conn->driver.set_timer(conn->driver.ctx,
+                           wifi_conn_backoff_ms(conn->attempt++, conn->driver.random(conn->driver.ctx)));
+}
+
+uint32_t wifi_conn_backoff_ms(uint32_t attempt, uint32_t random)
+{
+    uint32_t delay = WIFI_CONN_BACKOFF_MIN_MS << (attempt < 16 ? attempt : 16);
+    if (delay > WIFI_CONN_BACKOFF_MAX_MS) {
+        delay = WIFI_CONN_BACKOFF_MAX_MS;
+    }
+    /* Half of it is random, so the devices of a room don't retry at once after an AP restart */
+    return delay / 2 + random % (delay / 2 + 1);
+}
+
+void wifi_conn_init(wifi_conn_t *conn, const wifi_conn_driver_t *driver, const wifi_conn_ap_t *ap)
+{
+    memset(conn, 0, sizeof(*conn));
+    conn->driver = *driver;
+    if (ap && ap->valid && ap->channel) {
+        conn->ap = *ap;
+    }
+}
+
+void wifi_conn_start(wifi_conn_t *conn, uint32_t now)
+{
+    conn->attempt = 0;
+    conn->fast_failed = false;
+    conn->start_time = now;
+    wifi_conn_attempt(conn, now);
+}
+
+void wifi_conn_stop(wifi_conn_t *conn)
+{
+    conn->state = WIFI_CONN_IDLE;
+    conn->driver.set_timer(conn->driver.ctx, WIFI_CONN_TIMER_OFF);
+}
+
+void wifi_conn_forget_ap(wifi_conn_t *conn)
+{
+    if (conn->ap.valid) {
+        memset(&conn->ap, 0, sizeof(conn->ap));
+        conn->driver.save_ap(conn->driver.ctx, NULL);
+    }
+}
+
+void wifi_conn_associated(wifi_conn_t *conn, const uint8_t bssid[6], uint8_t channel, uint32_t now)
+{
+    if (conn->state != WIFI_CONN_CONNECTING) {
+        return;
+    }
+    memcpy(conn->assoc.bssid, bssid, sizeof(conn->assoc.bssid));
+    conn->assoc.channel = channel;
+    conn->assoc_time = now;
+    conn->state = WIFI_CONN_ASSOCIATED;
+    conn->driver.set_timer(conn->driver.ctx, WIFI_CONN_IP_TIMEOUT_MS);
+}
+
+void wifi_conn_got_ip(wifi_conn_t *conn, uint32_t ip, uint32_t now)
+{
+    if (conn->state != WIFI_CONN_ASSOCIATED) {
+        /* A new IP of the current connection */
+        if (conn->state == WIFI_CONN_CONNECTED && conn->ap.valid && conn->ap.ip != ip) {
+            conn->ap.ip = ip;
+            conn->driver.save_ap(conn->driver.ctx, &conn->ap);
+        }
+        return;
+    }
+    conn->driver.set_timer(conn->driver.ctx, WIFI_CONN_TIMER_OFF);
+    conn->state = WIFI_CONN_CONNECTED;
+
+    wifi_conn_stat_t *stat = &conn->stat;
+    stat->connect_cnt++;
+    stat->fast_cnt += conn->fast;
+    stat->ip_reused_cnt += conn->ap.valid && conn->ap.ip == ip;
+    stat->last_connect_ms = now - conn->start_time;
+    if (stat->last_connect_ms > stat->max_connect_ms) {
+        stat->max_connect_ms = stat->last_connect_ms;
+    }
+    stat->last_assoc_ms = conn->assoc_time - conn->attempt_time;
+    stat->last_ip_ms = now - conn->assoc_time;
+
+    conn->assoc.ip = ip;
+    conn->assoc.valid = true;
+    /* Only written when changed, to spare the flash */
+    if (memcmp(&conn->assoc, &conn->ap, sizeof(conn->ap)) != 0) {
+        conn->ap = conn->assoc;
+        conn->driver.save_ap(conn->driver.ctx, &conn->ap);
+    }
+    conn->attempt = 0;
+    conn->fast_failed = false;
+}
+
+void wifi_conn_disconnected(wifi_conn_t *conn, uint32_t now)
+{
+    switch (conn->state) {
+    case WIFI_CONN_CONNECTING:
+    case WIFI_CONN_ASSOCIATED:
+        wifi_conn_failed(conn, now);
+        break;
+    case WIFI_CONN_CONNECTED:
+        /* Retry at once after losing a working connection, the AP is most likely still there */
+        conn->start_time = now;
+        wifi_conn_attempt(conn, now);
+        break;
+    default:
+        break;
+    }
+}
+
+void wifi_conn_timeout(wifi_conn_t *conn, uint32_t now)
+{
+    switch (conn->state) {
+    case WIFI_CONN_BACKOFF:
+        wifi_conn_attempt(conn, now);
+        break;
+    case WIFI_CONN_ASSOCIATED:
+        /* No IP: the disconnection is reported as a failed attempt */
+        conn->driver.disconnect(conn->driver.ctx);
+        break;
+    default:
+        break;
+    }
+}
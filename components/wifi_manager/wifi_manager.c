@@ -5,15 +5,21 @@
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_random.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include "nvs_flash.h"
+#include "wifi_conn.h"
 
 #define WIFI_MANAGER_MAX_EVENT_HANDLERS 4
 #define WIFI_MANAGER_NVS_NAMESPACE      "wifi_mgr"
 #define WIFI_MANAGER_NVS_KEY_SSID       "ssid"
 #define WIFI_MANAGER_NVS_KEY_PASS       "pass"
+#define WIFI_MANAGER_NVS_KEY_AP         "ap"
+#define WIFI_MANAGER_AP_VERSION         1
 
 static const char *TAG = "wifi_mgr";
 
@@ -22,15 +28,31 @@ typedef struct {
     void *ctx;
 } wifi_manager_handler_entry_t;
 
+/* The AP of the last connection as stored in NVS */
+typedef struct {
+    uint8_t version;
+    char ssid[WIFI_MANAGER_MAX_SSID_LEN + 1];
+    wifi_conn_ap_t ap;
+} wifi_manager_ap_record_t;
+
 static struct {
     bool initialized;
+    bool nvs_ready;
     bool wifi_started;
     bool creds_valid;
     wifi_manager_credentials_t creds;
     nvs_handle_t nvs;
     wifi_manager_handler_entry_t handlers[WIFI_MANAGER_MAX_EVENT_HANDLERS];
+    SemaphoreHandle_t conn_lock;    /* Taken by the event loop and the timer task */
+    esp_timer_handle_t conn_timer;
+    wifi_conn_t conn;
 } s_wifi_mgr;
 
+static uint32_t wifi_manager_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
 static void wifi_manager_notify_handlers(wifi_manager_event_t event, const void *event_data)
 {
     for (size_t i = 0; i < WIFI_MANAGER_MAX_EVENT_HANDLERS; ++i) {
@@ -66,7 +88,19 @@ static void wifi_manager_save_credentials_to_nvs(void)
     nvs_commit(s_wifi_mgr.nvs);
 }
 
-static void wifi_manager_config_apply(void)
+static void wifi_manager_load_ap_from_nvs(wifi_conn_ap_t *ap)
+{
+    wifi_manager_ap_record_t record;
+    size_t len = sizeof(record);
+    memset(ap, 0, sizeof(*ap));
+    if (nvs_get_blob(s_wifi_mgr.nvs, WIFI_MANAGER_NVS_KEY_AP, &record, &len) == ESP_OK &&
+        len == sizeof(record) && record.version == WIFI_MANAGER_AP_VERSION &&
+        s_wifi_mgr.creds_valid && strncmp(record.ssid, s_wifi_mgr.creds.ssid, sizeof(record.ssid)) == 0) {
+        *ap = record.ap;
+    }
+}
+
+static void wifi_manager_config_apply(const wifi_conn_ap_t *ap)
 {
     if (!s_wifi_mgr.creds_valid) {
         return;
@@ -74,34 +108,147 @@ static void wifi_manager_config_apply(void)
     wifi_config_t cfg = { 0 };
     strlcpy((char *)cfg.sta.ssid, s_wifi_mgr.creds.ssid, sizeof(cfg.sta.ssid));
     strlcpy((char *)cfg.sta.password, s_wifi_mgr.creds.password, sizeof(cfg.sta.password));
-    cfg.sta.threshold.authmode = WIFI_AUTH_OPEN;
+    /* Ignore the APs weaker than the network's security, with a password it's at least WPA2 */
+    cfg.sta.threshold.authmode = s_wifi_mgr.creds.password[0] ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
     cfg.sta.pmf_cfg.capable = true;
     cfg.sta.pmf_cfg.required = false;
+    if (ap) {
+        /* Probe only the cached AP on its channel */
+        cfg.sta.bssid_set = true;
+        memcpy(cfg.sta.bssid, ap->bssid, sizeof(cfg.sta.bssid));
+        cfg.sta.channel = ap->channel;
+        cfg.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        /* Scan every channel and take the strongest AP of the network */
+        cfg.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        cfg.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
     esp_wifi_set_config(WIFI_IF_STA, &cfg);
 }
 
+static void wifi_manager_conn_connect(void *ctx, const wifi_conn_ap_t *ap)
+{
+    (void)ctx;
+    wifi_manager_config_apply(ap);
+    esp_err_t err = esp_wifi_connect();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Connect failed: %s", esp_err_to_name(err));
+    }
+}
+
+static void wifi_manager_conn_disconnect(void *ctx)
+{
+    (void)ctx;
+    esp_wifi_disconnect();
+}
+
+static void wifi_manager_conn_set_timer(void *ctx, uint32_t delay_ms)
+{
+    (void)ctx;
+    esp_timer_stop(s_wifi_mgr.conn_timer);
+    if (delay_ms != WIFI_CONN_TIMER_OFF) {
+        esp_timer_start_once(s_wifi_mgr.conn_timer, (uint64_t)delay_ms * 1000);
+    }
+}
+
+static void wifi_manager_conn_save_ap(void *ctx, const wifi_conn_ap_t *ap)
+{
+    (void)ctx;
+    if (!s_wifi_mgr.nvs) {
+        return;
+    }
+    if (ap) {
+        wifi_manager_ap_record_t record = {
+            .version = WIFI_MANAGER_AP_VERSION,
+            .ap = *ap,
+        };
+        strlcpy(record.ssid, s_wifi_mgr.creds.ssid, sizeof(record.ssid));
+        nvs_set_blob(s_wifi_mgr.nvs, WIFI_MANAGER_NVS_KEY_AP, &record, sizeof(record));
+    } else {
+        nvs_erase_key(s_wifi_mgr.nvs, WIFI_MANAGER_NVS_KEY_AP);
+    }
+    nvs_commit(s_wifi_mgr.nvs);
+}
+
+static uint32_t wifi_manager_conn_random(void *ctx)
+{
+    (void)ctx;
+    return esp_random();
+}
+
+static void wifi_manager_conn_timer_cb(void *arg)
+{
+    (void)arg;
+    xSemaphoreTake(s_wifi_mgr.conn_lock, portMAX_DELAY);
+    wifi_conn_timeout(&s_wifi_mgr.conn, wifi_manager_now_ms());
+    xSemaphoreGive(s_wifi_mgr.conn_lock);
+}
+
+static esp_err_t wifi_manager_conn_init(void)
+{
+    s_wifi_mgr.conn_lock = xSemaphoreCreateMutex();
+    if (!s_wifi_mgr.conn_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    const esp_timer_create_args_t timer_args = {
+        .callback = wifi_manager_conn_timer_cb,
+        .name = "wifi_conn",
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_wifi_mgr.conn_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const wifi_conn_driver_t driver = {
+        .connect = wifi_manager_conn_connect,
+        .disconnect = wifi_manager_conn_disconnect,
+        .set_timer = wifi_manager_conn_set_timer,
+        .save_ap = wifi_manager_conn_save_ap,
+        .random = wifi_manager_conn_random,
+    };
+    wifi_conn_ap_t ap;
+    wifi_manager_load_ap_from_nvs(&ap);
+    wifi_conn_init(&s_wifi_mgr.conn, &driver, &ap);
+    if (ap.valid) {
+        ESP_LOGI(TAG, "Cached AP on channel %u", ap.channel);
+    }
+    return ESP_OK;
+}
+
 static void wifi_event_handler(void *arg,
                                esp_event_base_t event_base,
                                int32_t event_id,
                                void *event_data)
 {
+    /* The handlers are notified without the lock, they may call back */
+    uint32_t now = wifi_manager_now_ms();
     if (event_base == WIFI_EVENT) {
         switch (event_id) {
         case WIFI_EVENT_STA_START:
             wifi_manager_notify_handlers(WIFI_MANAGER_EVENT_STARTED, NULL);
             if (s_wifi_mgr.creds_valid) {
-                esp_wifi_connect();
+                xSemaphoreTake(s_wifi_mgr.conn_lock, portMAX_DELAY);
+                wifi_conn_start(&s_wifi_mgr.conn, now);
+                xSemaphoreGive(s_wifi_mgr.conn_lock);
             }
             break;
-        case WIFI_EVENT_STA_CONNECTED:
+        case WIFI_EVENT_STA_CONNECTED: {
+            const wifi_event_sta_connected_t *event = (const wifi_event_sta_connected_t *)event_data;
+            xSemaphoreTake(s_wifi_mgr.conn_lock, portMAX_DELAY);
+            wifi_conn_associated(&s_wifi_mgr.conn, event->bssid, event->channel, now);
+            xSemaphoreGive(s_wifi_mgr.conn_lock);
             wifi_manager_notify_handlers(WIFI_MANAGER_EVENT_CONNECTED, NULL);
             break;
-        case WIFI_EVENT_STA_DISCONNECTED:
+        }
+        case WIFI_EVENT_STA_DISCONNECTED: {
+            const wifi_event_sta_disconnected_t *event = (const wifi_event_sta_disconnected_t *)event_data;
+            ESP_LOGD(TAG, "Disconnected, reason %u", event->reason);
             wifi_manager_notify_handlers(WIFI_MANAGER_EVENT_DISCONNECTED, NULL);
-            if (s_wifi_mgr.creds_valid) {
-                esp_wifi_connect();
-            }
+            xSemaphoreTake(s_wifi_mgr.conn_lock, portMAX_DELAY);
+            wifi_conn_disconnected(&s_wifi_mgr.conn, now);
+            xSemaphoreGive(s_wifi_mgr.conn_lock);
             break;
+        }
         default:
             break;
         }
@@ -110,21 +257,21 @@ static void wifi_event_handler(void *arg,
         wifi_manager_ip_info_t info = {
             .ip = event->ip_info.ip,
         };
+        xSemaphoreTake(s_wifi_mgr.conn_lock, portMAX_DELAY);
+        wifi_conn_got_ip(&s_wifi_mgr.conn, event->ip_info.ip.addr, now);
+        const wifi_conn_stat_t *stat = &s_wifi_mgr.conn.stat;
+        ESP_LOGI(TAG, "Connected in %u ms (association %u ms, IP %u ms)%s",
+                 (unsigned)stat->last_connect_ms, (unsigned)stat->last_assoc_ms, (unsigned)stat->last_ip_ms,
+                 s_wifi_mgr.conn.fast ? " to the cached AP" : "");
+        xSemaphoreGive(s_wifi_mgr.conn_lock);
         wifi_manager_notify_handlers(WIFI_MANAGER_EVENT_GOT_IP, &info);
     }
 }
 
 static esp_err_t wifi_manager_ensure_system_init(void)
 {
-    esp_err_t err = nvs_flash_init();
-    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
-        err = nvs_flash_init();
-    }
-    ESP_ERROR_CHECK(err);
-
     ESP_ERROR_CHECK(esp_netif_init());
-    err = esp_event_loop_create_default();
+    esp_err_t err = esp_event_loop_create_default();
     if (err != ESP_ERR_INVALID_STATE) {
         ESP_ERROR_CHECK(err);
     }
@@ -132,12 +279,42 @@ static esp_err_t wifi_manager_ensure_system_init(void)
     return ESP_OK;
 }
 
+esp_err_t wifi_manager_nvs_init(void)
+{
+    if (s_wifi_mgr.nvs_ready) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        err = nvs_flash_erase();
+        if (err == ESP_OK) {
+            err = nvs_flash_init();
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_open(WIFI_MANAGER_NVS_NAMESPACE, NVS_READWRITE, &s_wifi_mgr.nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    wifi_manager_load_credentials_from_nvs();
+    s_wifi_mgr.nvs_ready = true;
+    return ESP_OK;
+}
+
 esp_err_t wifi_manager_init(const wifi_manager_credentials_t *initial_creds)
 {
     if (s_wifi_mgr.initialized) {
         return ESP_OK;
     }
 
+    ESP_ERROR_CHECK(wifi_manager_nvs_init());
     ESP_ERROR_CHECK(wifi_manager_ensure_system_init());
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
@@ -152,21 +329,16 @@ esp_err_t wifi_manager_init(const wifi_manager_credentials_t *initial_creds)
                                                &wifi_event_handler,
                                                NULL));
 
-    esp_err_t err = nvs_open(WIFI_MANAGER_NVS_NAMESPACE, NVS_READWRITE, &s_wifi_mgr.nvs);
-    ESP_ERROR_CHECK(err);
-
     if (initial_creds) {
         s_wifi_mgr.creds = *initial_creds;
         s_wifi_mgr.creds_valid = (initial_creds->ssid[0] != '\0');
         if (s_wifi_mgr.creds_valid) {
             wifi_manager_save_credentials_to_nvs();
         }
-    } else {
-        wifi_manager_load_credentials_from_nvs();
     }
 
+    ESP_ERROR_CHECK(wifi_manager_conn_init());
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    wifi_manager_config_apply();
     ESP_ERROR_CHECK(esp_wifi_start());
     s_wifi_mgr.wifi_started = true;
     s_wifi_mgr.initialized = true;
@@ -194,6 +366,11 @@ esp_err_t wifi_manager_set_credentials(const wifi_manager_credentials_t *creds,
     if (!creds) {
         return ESP_ERR_INVALID_ARG;
     }
+    if (s_wifi_mgr.conn_lock && strncmp(creds->ssid, s_wifi_mgr.creds.ssid, sizeof(s_wifi_mgr.creds.ssid)) != 0) {
+        xSemaphoreTake(s_wifi_mgr.conn_lock, portMAX_DELAY);
+        wifi_conn_forget_ap(&s_wifi_mgr.conn);
+        xSemaphoreGive(s_wifi_mgr.conn_lock);
+    }
     memset(&s_wifi_mgr.creds, 0, sizeof(s_wifi_mgr.creds));
     strlcpy(s_wifi_mgr.creds.ssid, creds->ssid, sizeof(s_wifi_mgr.creds.ssid));
     strlcpy(s_wifi_mgr.creds.password, creds->password, sizeof(s_wifi_mgr.creds.password));
@@ -201,19 +378,36 @@ esp_err_t wifi_manager_set_credentials(const wifi_manager_credentials_t *creds,
     if (persist && s_wifi_mgr.creds_valid) {
         wifi_manager_save_credentials_to_nvs();
     }
-    if (s_wifi_mgr.wifi_started) {
-        wifi_manager_config_apply();
+    if (s_wifi_mgr.wifi_started && s_wifi_mgr.creds_valid) {
+        wifi_manager_connect();
+    } else if (s_wifi_mgr.conn_lock && !s_wifi_mgr.creds_valid) {
+        /* Cleared: no more retries, the disconnection that follows is ignored once stopped */
+        xSemaphoreTake(s_wifi_mgr.conn_lock, portMAX_DELAY);
+        wifi_conn_stop(&s_wifi_mgr.conn);
+        xSemaphoreGive(s_wifi_mgr.conn_lock);
+        if (s_wifi_mgr.wifi_started) {
+            esp_wifi_disconnect();
+        }
     }
     return s_wifi_mgr.creds_valid ? ESP_OK : ESP_ERR_INVALID_STATE;
 }
 
 esp_err_t wifi_manager_connect(void)
 {
-    if (!s_wifi_mgr.creds_valid) {
+    if (!s_wifi_mgr.creds_valid || !s_wifi_mgr.wifi_started) {
         return ESP_ERR_INVALID_STATE;
     }
-    wifi_manager_config_apply();
-    return esp_wifi_connect();
+    esp_err_t err = ESP_OK;
+    xSemaphoreTake(s_wifi_mgr.conn_lock, portMAX_DELAY);
+    wifi_conn_state_t state = s_wifi_mgr.conn.state;
+    if (state == WIFI_CONN_IDLE || state == WIFI_CONN_BACKOFF) {
+        wifi_conn_start(&s_wifi_mgr.conn, wifi_manager_now_ms());
+    } else {
+        /* Reconnected with the current credentials when the disconnection is reported */
+        err = esp_wifi_disconnect();
+    }
+    xSemaphoreGive(s_wifi_mgr.conn_lock);
+    return err;
 }
 
 const wifi_manager_credentials_t *wifi_manager_get_credentials(void)
@@ -228,3 +422,17 @@ bool wifi_manager_has_credentials(void)
 {
     return s_wifi_mgr.creds_valid;
 }
+
+void wifi_manager_get_connect_stat(wifi_manager_connect_stat_t *stat)
+{
+    if (!stat) {
+        return;
+    }
+    if (!s_wifi_mgr.conn_lock) {
+        memset(stat, 0, sizeof(*stat));
+        return;
+    }
+    xSemaphoreTake(s_wifi_mgr.conn_lock, portMAX_DELAY);
+    *stat = s_wifi_mgr.conn.stat;
+    xSemaphoreGive(s_wifi_mgr.conn_lock);
+}
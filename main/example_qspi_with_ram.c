@@ -13,6 +13,7 @@
 #include "driver/spi_master.h"
 #include "esp_heap_caps.h"
 #include "esp_timer.h"
+#include "esp_cpu.h"
 #include "esp_netif_ip_addr.h"
 #include "esp_netif.h"
 #include "esp_lcd_panel_io.h"
@@ -28,6 +29,11 @@
 #include "read_lcd_id_bsp.h"
 #include "wifi_manager.h"
 #include "mqtt_manager.h"
+#include "boot_manager.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "metrics_manager.h"
+#include "mirror_manager.h"
 #include "ui/ui.h"
 static const char *TAG = "example";
 static SemaphoreHandle_t lvgl_mux = NULL;
@@ -41,71 +47,215 @@ static lv_obj_t *ssid_input = NULL;
 static lv_obj_t *password_input = NULL;
 static lv_obj_t *settings_keyboard = NULL;
 static QueueHandle_t ui_event_queue = NULL;
+static telemetry_store_t telemetry_store;
 static lv_obj_t * scr_squareline = NULL;
-static lv_obj_t *registered_screens[4] = {0};
-static size_t registered_screen_count = 0;
+static lv_pager_t *screen_pager = NULL;
 static bool is_playing = false;
 static lv_obj_t *current_screen = NULL;
 static lv_timer_t *splash_timer = NULL;
 static lv_obj_t *splash_screen = NULL;
+static esp_lcd_panel_handle_t panel_handle = NULL;
+static lv_disp_draw_buf_t disp_buf; // contains internal graphic buffer(s) called draw buffer(s)
+static lv_disp_drv_t disp_drv;      // contains callback functions
+static lv_indev_t *touch_indev = NULL;
 static void splash_show_main(lv_timer_t *timer);
 
-#define MQTT_BUTTON_MEDIA_PLAY       "media/play"
-#define MQTT_BUTTON_MEDIA_VOLUME_UP  "media/volume_up"
-#define MQTT_BUTTON_MEDIA_VOLUME_DOWN "media/volume_down"
-#define MQTT_BUTTON_MEDIA_PREV       "media/previous"
-#define MQTT_BUTTON_MEDIA_NEXT       "media/next"
-#define MQTT_BUTTON_HVAC_TEMP_UP     "hvac/temp_up"
-#define MQTT_BUTTON_HVAC_TEMP_DOWN   "hvac/temp_down"
-#define MQTT_BUTTON_HVAC_POWER       "hvac/power"
-#define MQTT_BUTTON_HVAC_INTENSITY   "hvac/intensity"
-#define MQTT_BUTTON_HVAC_TEMP_SET    "hvac/temp_set"
+#define MQTT_TOPIC_TEMP_OUT          "TempOut"
+#define MQTT_TOPIC_TELEMETRY         "Telemetry"
+#define MQTT_TOPIC_TRACE_DUMP        "trace/dump"
+#define MQTT_TOPIC_TRACE_JSON        "trace/json"
+#define TRACE_JSON_BUF_SIZE          (64 * 1024)
+#define TRACE_FLUSH_TIMEOUT_US       (1000 * 1000)
+#define MQTT_TOPIC_METRICS           "esp32lvgl/metrics"
+#define MQTT_TOPIC_MIRROR            "esp32lvgl/mirror"
+#define MQTT_TOPIC_MIRROR_CTL        "esp32lvgl/mirror/ctl"
+#define MQTT_TEMP_SET_INTERVAL_MS    200
 #define SPLASH_DISPLAY_TIME_MS       4000
 #define SPLASH_FADE_TIME_MS          500
 
 typedef enum {
-    UI_EVENT_TEMPERATURE,
     UI_EVENT_WIFI_STATUS,
     UI_EVENT_MQTT_STATUS,
-    UI_EVENT_TEMP_OUT,
 } ui_event_type_t;
 
 typedef struct {
     ui_event_type_t type;
-    float temperature;
     char message[64];
 } ui_event_t;
 
-static void gesture_event_cb(lv_event_t * e);
+/* Signal ids of the telemetry frames */
+typedef enum {
+    TELEMETRY_SIGNAL_TEMP_OUT = 0,
+} telemetry_signal_t;
+
+/* Label showing the latest value of a signal */
+typedef struct {
+    uint8_t signal;
+    lv_obj_t **label;
+    const char *unit;
+} ui_telemetry_binding_t;
+
+static const ui_telemetry_binding_t ui_telemetry_bindings[] = {
+    { TELEMETRY_SIGNAL_TEMP_OUT, &ui_TempOut, "" },
+    { TELEMETRY_SIGNAL_TEMP_OUT, &temperature_value_label, "°C" },
+};
+
+/* Stages of a received value on its way to the panel */
+typedef enum {
+    TRACE_STAGE_MQTT_RX,
+    TRACE_STAGE_DECODED,
+    TRACE_STAGE_UI_APPLY,
+    TRACE_STAGE_FLUSH,
+    TRACE_STAGE_DMA_DONE,
+    TRACE_STAGE_CNT,
+} trace_stage_t;
+
+static const char *const trace_stage_names[TRACE_STAGE_CNT] = {
+    [TRACE_STAGE_MQTT_RX] = "mqtt_rx",
+    [TRACE_STAGE_DECODED] = "decoded",
+    [TRACE_STAGE_UI_APPLY] = "ui_apply",
+    [TRACE_STAGE_FLUSH] = "flush",
+    [TRACE_STAGE_DMA_DONE] = "dma_done",
+};
+
+/* Trace id of the latest value of every signal, set before the value is stored */
+static uint16_t telemetry_trace_ids[TELEMETRY_MAX_SIGNALS];
+
+typedef enum {
+    TRACE_FLUSH_FREE = 0,
+    TRACE_FLUSH_PENDING,        // Label changed, not drawn yet
+    TRACE_FLUSH_IN_FLUSH,       // Label's last rows are being sent to the panel
+} trace_flush_state_t;
+
+/* Changed label waiting for its pixels to reach the panel */
+typedef struct {
+    uint16_t id;
+    uint8_t state;              // trace_flush_state_t, changed by the DMA interrupt too
+    lv_obj_t *label;
+    int64_t applied_us;
+} trace_flush_t;
+
+static trace_flush_t trace_flushes[4];
+
+typedef enum {
+    METRIC_FRAME_US,            // Refresh from the start of rendering to the last flush
+    METRIC_RENDER_US,           // Part of the refresh not spent in flush_cb or waiting for the panel
+    METRIC_FLUSH_US,            // From flush_cb to the end of the transfer, per flushed area
+    METRIC_FRAME_PX,            // Pixels redrawn by a refresh
+    METRIC_UI_EVENTS,
+    METRIC_MQTT_RX,
+    METRIC_MQTT_RTT_MS,
+    METRIC_HEAP_INTERNAL,       // Free bytes, sampled at the end of the window
+    METRIC_HEAP_INTERNAL_MIN,
+    METRIC_HEAP_PSRAM,
+    METRIC_HEAP_DMA,
+    METRIC_UI_QUEUE,            // Waiting entries, sampled at the end of the window
+    METRIC_MQTT_OUTBOX,
+    METRIC_CNT,
+} metric_id_t;
+
+static const metrics_def_t metric_defs[METRIC_CNT] = {
+    [METRIC_FRAME_US] = { "frame_us", METRICS_HIST },
+    [METRIC_RENDER_US] = { "render_us", METRICS_HIST },
+    [METRIC_FLUSH_US] = { "flush_us", METRICS_HIST },
+    [METRIC_FRAME_PX] = { "frame_px", METRICS_HIST },
+    [METRIC_UI_EVENTS] = { "ui_events", METRICS_COUNTER },
+    [METRIC_MQTT_RX] = { "mqtt_rx", METRICS_COUNTER },
+    [METRIC_MQTT_RTT_MS] = { "mqtt_rtt_ms", METRICS_HIST },
+    [METRIC_HEAP_INTERNAL] = { "heap_int", METRICS_GAUGE },
+    [METRIC_HEAP_INTERNAL_MIN] = { "heap_int_min", METRICS_GAUGE },
+    [METRIC_HEAP_PSRAM] = { "heap_psram", METRICS_GAUGE },
+    [METRIC_HEAP_DMA] = { "heap_dma", METRICS_GAUGE },
+    [METRIC_UI_QUEUE] = { "ui_queue", METRICS_GAUGE },
+    [METRIC_MQTT_OUTBOX] = { "mqtt_outbox", METRICS_GAUGE },
+};
+
+/* Buttons publishing their events, see button_defs */
+typedef enum {
+    BUTTON_MEDIA_PLAY,
+    BUTTON_MEDIA_VOLUME_UP,
+    BUTTON_MEDIA_VOLUME_DOWN,
+    BUTTON_MEDIA_PREV,
+    BUTTON_MEDIA_NEXT,
+    BUTTON_HVAC_TEMP_UP,
+    BUTTON_HVAC_TEMP_DOWN,
+    BUTTON_HVAC_POWER,
+    BUTTON_HVAC_INTENSITY,
+    BUTTON_HVAC_TEMP_SET,
+    BUTTON_CNT,
+} button_id_t;
+
+typedef struct {
+    const char *id;             // Last levels of the topic
+    uint32_t min_interval_ms;   // 0: every event is published
+} button_def_t;
+
+static const button_def_t button_defs[BUTTON_CNT] = {
+    [BUTTON_MEDIA_PLAY] = { "media/play", 0 },
+    [BUTTON_MEDIA_VOLUME_UP] = { "media/volume_up", 0 },
+    [BUTTON_MEDIA_VOLUME_DOWN] = { "media/volume_down", 0 },
+    [BUTTON_MEDIA_PREV] = { "media/previous", 0 },
+    [BUTTON_MEDIA_NEXT] = { "media/next", 0 },
+    [BUTTON_HVAC_TEMP_UP] = { "hvac/temp_up", 0 },
+    [BUTTON_HVAC_TEMP_DOWN] = { "hvac/temp_down", 0 },
+    [BUTTON_HVAC_POWER] = { "hvac/power", 0 },
+    [BUTTON_HVAC_INTENSITY] = { "hvac/intensity", 0 },
+    // Dragging the temperature arc changes the value every frame
+    [BUTTON_HVAC_TEMP_SET] = { "hvac/temp_set", MQTT_TEMP_SET_INTERVAL_MS },
+};
+
+/* Topics of the buttons, added by boot_mqtt_init_stage() before the UI can publish */
+static mqtt_manager_button_t buttons[BUTTON_CNT];
+
+/* Timing of the refresh in progress, used by the LVGL task only */
+static struct {
+    int64_t start_us;
+    int64_t flush_cb_us;        // Spent in flush_cb
+    int64_t wait_us;            // Spent waiting for the panel to take the next buffer
+} frame_timing;
+static int64_t flush_start_us;  // Read by the transfer interrupt
+
+typedef enum {
+    BOOT_STAGE_PANEL,
+    BOOT_STAGE_LVGL,
+    BOOT_STAGE_FIRST_FRAME,
+    BOOT_STAGE_TOUCH,
+    BOOT_STAGE_NVS,
+    BOOT_STAGE_MQTT_INIT,
+    BOOT_STAGE_UI,
+    BOOT_STAGE_WIFI,
+    BOOT_STAGE_MQTT,
+    BOOT_STAGE_CNT,
+} boot_stage_id_t;
+
 static void splash_timer_cb(lv_timer_t *timer);
 static void splash_show_main(lv_timer_t *timer);
 
 static void register_screen(lv_obj_t *screen)
 {
-    if (registered_screen_count < (sizeof(registered_screens) / sizeof(registered_screens[0]))) {
-        registered_screens[registered_screen_count++] = screen;
-        lv_obj_add_event_cb(screen, gesture_event_cb, LV_EVENT_GESTURE, NULL);
+    if (screen_pager) {
+        lv_pager_add_screen(screen_pager, screen);
     }
 }
 
-static size_t get_screen_index(lv_obj_t *screen)
+static void pager_change_cb(lv_pager_t *pager, lv_obj_t *screen)
 {
-    for (size_t i = 0; i < registered_screen_count; ++i) {
-        if (registered_screens[i] == screen) {
-            return i;
-        }
-    }
-    return 0;
+    current_screen = screen;
+
+    lv_pager_stat_t stat;
+    lv_pager_get_stat(pager, &stat);
+    ESP_LOGI(TAG, "Swipe %u: latency avg %u ms, max %u ms, %u frames, %u dropped",
+             (unsigned)stat.swipe_cnt, (unsigned)stat.latency_avg, (unsigned)stat.latency_max,
+             (unsigned)stat.frame_cnt, (unsigned)stat.frame_drop_cnt);
 }
 
-static void enqueue_ui_event(ui_event_type_t type, const char *message, float temperature)
+static void enqueue_ui_event(ui_event_type_t type, const char *message)
 {
     if (!ui_event_queue) {
         return;
     }
     ui_event_t evt = {
         .type = type,
-        .temperature = temperature,
     };
     if (message) {
         strlcpy(evt.message, message, sizeof(evt.message));
@@ -113,6 +263,7 @@ static void enqueue_ui_event(ui_event_type_t type, const char *message, float te
         evt.message[0] = '\0';
     }
     xQueueSend(ui_event_queue, &evt, 0);
+    metrics_manager_add(METRIC_UI_EVENTS, 1);
 }
 
 static void handle_ui_event(const ui_event_t *event)
@@ -120,14 +271,7 @@ static void handle_ui_event(const ui_event_t *event)
     if (!event) {
         return;
     }
-    char buffer[64];
     switch (event->type) {
-    case UI_EVENT_TEMPERATURE:
-        if (temperature_value_label) {
-            snprintf(buffer, sizeof(buffer), "%.1f°C", event->temperature);
-            lv_label_set_text(temperature_value_label, buffer);
-        }
-        break;
     case UI_EVENT_WIFI_STATUS:
         if (wifi_status_value_label) {
             lv_label_set_text(wifi_status_value_label, event->message);
@@ -138,16 +282,117 @@ static void handle_ui_event(const ui_event_t *event)
             lv_label_set_text(mqtt_status_value_label, event->message);
         }
         break;
-    case UI_EVENT_TEMP_OUT:
-        if (ui_TempOut && event->message[0] != '\0') {
-            lv_label_set_text(ui_TempOut, event->message);
-        }
+    default:
+        break;
+    }
+}
+
+static void set_telemetry_label(lv_obj_t *label, const telemetry_value_t *value, const char *unit)
+{
+    switch (value->type) {
+    case TELEMETRY_TYPE_F32: {
+        // Formatted straight into the label's fixed buffer. lv_printf has no float support.
+        int tenths = (int)(value->f32 * 10.0f + (value->f32 < 0 ? -0.5f : 0.5f));
+        lv_label_set_text_fmt(label, "%s%d.%d%s", tenths < 0 ? "-" : "", abs(tenths) / 10, abs(tenths) % 10, unit);
+        break;
+    }
+    case TELEMETRY_TYPE_I32:
+        lv_label_set_text_fmt(label, "%d%s", (int)value->i32, unit);
+        break;
+    case TELEMETRY_TYPE_BOOL:
+        lv_label_set_text(label, value->b ? "On" : "Off");
         break;
     default:
         break;
     }
 }
 
+/* Follow a changed label until its pixels are on the panel */
+static void trace_label_applied(lv_obj_t *label, uint16_t id)
+{
+    if (id == TRACE_ID_NONE) {
+        return;
+    }
+    trace_point(id, TRACE_STAGE_UI_APPLY);
+    // Labels of hidden screens aren't drawn. Ones scrolled out of view are given up after a while.
+    if (lv_obj_get_screen(label) != lv_scr_act()) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    trace_flush_t *free_flush = NULL;
+    for (size_t i = 0; i < sizeof(trace_flushes) / sizeof(trace_flushes[0]); ++i) {
+        trace_flush_t *flush = &trace_flushes[i];
+        uint8_t state = __atomic_load_n(&flush->state, __ATOMIC_ACQUIRE);
+        // Another label of the same value already ends the value's trace
+        if (state != TRACE_FLUSH_FREE && flush->id == id) {
+            return;
+        }
+        if (state == TRACE_FLUSH_PENDING &&
+            (flush->label == label || now - flush->applied_us > TRACE_FLUSH_TIMEOUT_US)) {
+            __atomic_store_n(&flush->state, TRACE_FLUSH_FREE, __ATOMIC_RELAXED);
+            state = TRACE_FLUSH_FREE;
+        }
+        if (state == TRACE_FLUSH_FREE && !free_flush) {
+            free_flush = flush;
+        }
+    }
+    if (!free_flush) {
+        return;
+    }
+    free_flush->id = id;
+    free_flush->label = label;
+    free_flush->applied_us = now;
+    __atomic_store_n(&free_flush->state, TRACE_FLUSH_PENDING, __ATOMIC_RELEASE);
+}
+
+/* Called with every flushed area. LVGL draws from top to bottom, so a label is
+ * on the panel once the area with its last row is sent. */
+static void trace_flush_area(const lv_area_t *area)
+{
+    for (size_t i = 0; i < sizeof(trace_flushes) / sizeof(trace_flushes[0]); ++i) {
+        trace_flush_t *flush = &trace_flushes[i];
+        if (__atomic_load_n(&flush->state, __ATOMIC_ACQUIRE) != TRACE_FLUSH_PENDING) {
+            continue;
+        }
+        lv_area_t coords;
+        lv_obj_get_coords(flush->label, &coords);
+        if (area->y1 <= coords.y2 && coords.y2 <= area->y2 && area->x1 <= coords.x2 && coords.x1 <= area->x2) {
+            trace_point(flush->id, TRACE_STAGE_FLUSH);
+            __atomic_store_n(&flush->state, TRACE_FLUSH_IN_FLUSH, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/* Called from the interrupt of the finished transfer */
+static void trace_flush_done(void)
+{
+    for (size_t i = 0; i < sizeof(trace_flushes) / sizeof(trace_flushes[0]); ++i) {
+        trace_flush_t *flush = &trace_flushes[i];
+        if (__atomic_load_n(&flush->state, __ATOMIC_ACQUIRE) == TRACE_FLUSH_IN_FLUSH) {
+            trace_point(flush->id, TRACE_STAGE_DMA_DONE);
+            __atomic_store_n(&flush->state, TRACE_FLUSH_FREE, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/* Show the signals received since the last frame, only the latest value of each */
+static void apply_telemetry(void)
+{
+    uint32_t changed = telemetry_store_take_changed(&telemetry_store);
+    if (!changed) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof(ui_telemetry_bindings) / sizeof(ui_telemetry_bindings[0]); ++i) {
+        const ui_telemetry_binding_t *binding = &ui_telemetry_bindings[i];
+        if ((changed & (1UL << binding->signal)) && *binding->label) {
+            set_telemetry_label(*binding->label, telemetry_store_get(&telemetry_store, binding->signal),
+                                binding->unit);
+            trace_label_applied(*binding->label,
+                                __atomic_load_n(&telemetry_trace_ids[binding->signal], __ATOMIC_RELAXED));
+        }
+    }
+}
+
 #define LCD_HOST    SPI2_HOST
 
 #define EXAMPLE_Rotate_90
@@ -213,12 +458,39 @@ static const sh8601_lcd_init_cmd_t co5300_lcd_init_cmds[] =
 static bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
     lv_disp_drv_t *disp_driver = (lv_disp_drv_t *)user_ctx;
+    trace_flush_done();
+    metrics_manager_record(METRIC_FLUSH_US, (uint32_t)(esp_timer_get_time() - flush_start_us));
     lv_disp_flush_ready(disp_driver);
     return false;
 }
 
+static void example_lvgl_render_start_cb(lv_disp_drv_t *drv)
+{
+    frame_timing.start_us = esp_timer_get_time();
+    frame_timing.flush_cb_us = 0;
+    frame_timing.wait_us = 0;
+}
+
+// Called by LVGL in a loop while the previous buffer is flushed: waits here to time it
+static void example_lvgl_wait_cb(lv_disp_drv_t *drv)
+{
+    int64_t start_us = esp_timer_get_time();
+    while (drv->draw_buf->flushing) {
+    }
+    frame_timing.wait_us += esp_timer_get_time() - start_us;
+}
+
+static void example_lvgl_monitor_cb(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px)
+{
+    int64_t frame_us = esp_timer_get_time() - frame_timing.start_us;
+    metrics_manager_record(METRIC_FRAME_US, (uint32_t)frame_us);
+    metrics_manager_record(METRIC_RENDER_US, (uint32_t)(frame_us - frame_timing.flush_cb_us - frame_timing.wait_us));
+    metrics_manager_record(METRIC_FRAME_PX, px);
+}
+
 static void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
 {
+    flush_start_us = esp_timer_get_time();
     esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t) drv->user_data;
     const int offsetx1 = (READ_LCD_ID == SH8601_ID) ? area->x1 : area->x1 + 0x06;
     const int offsetx2 = (READ_LCD_ID == SH8601_ID) ? area->x2 : area->x2 + 0x06;
@@ -242,8 +514,14 @@ static void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_
     }
 #endif
 
+    trace_flush_area(area);
+#if LCD_BIT_PER_PIXEL == 16
+    mirror_manager_capture(area->x1, area->y1, area->x2 - area->x1 + 1, area->y2 - area->y1 + 1,
+                           (const uint16_t *)color_map);
+#endif
     // copy a buffer's content to a specific area of the display
     esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, color_map);
+    frame_timing.flush_cb_us += esp_timer_get_time() - flush_start_us;
 }
 
 void example_lvgl_rounder_cb(struct _lv_disp_drv_t *disp_drv, lv_area_t *area)
@@ -313,6 +591,7 @@ static void example_lvgl_port_task(void *arg)
                     handle_ui_event(&evt);
                 }
             }
+            apply_telemetry();
             // Release the mutex
             example_lvgl_unlock();
         }
@@ -325,19 +604,6 @@ static void example_lvgl_port_task(void *arg)
     }
 }
 
-static void gesture_event_cb(lv_event_t * e) {
-    lv_obj_t * scr = lv_event_get_target(e);
-    lv_dir_t dir = lv_indev_get_gesture_dir(lv_indev_get_act());
-    size_t index = get_screen_index(scr);
-    if (dir == LV_DIR_LEFT && index + 1 < registered_screen_count) {
-        current_screen = registered_screens[index + 1];
-        lv_scr_load(current_screen);
-    } else if (dir == LV_DIR_RIGHT && index > 0) {
-        current_screen = registered_screens[index - 1];
-        lv_scr_load(current_screen);
-    }
-}
-
 static void splash_show_main(lv_timer_t *timer)
 {
     (void)timer;
@@ -345,6 +611,14 @@ static void splash_show_main(lv_timer_t *timer)
         lv_scr_load(current_screen);
     }
     if (splash_screen) {
+#if LV_USE_RLE
+        lv_rle_stat_t stat;
+        lv_rle_get_stat(&stat);
+        ESP_LOGI(TAG, "Splash: %u bytes of flash instead of %u, %u draws decoded %u lines from %u bytes",
+                 (unsigned)ui_img_logo_de_audi__png.data_size,
+                 (unsigned)lv_rle_get_raw_size(&ui_img_logo_de_audi__png),
+                 (unsigned)stat.open_cnt, (unsigned)stat.line_cnt, (unsigned)stat.in_size);
+#endif
         ui_Screen4_screen_destroy();
         splash_screen = NULL;
     }
@@ -372,26 +646,32 @@ static void splash_timer_cb(lv_timer_t *timer)
     }
 }
 
+static void publish_button_event(button_id_t button, const char *state)
+{
+    esp_err_t err = mqtt_manager_publish_button_event(buttons[button], state);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Can't publish %s of %s: %s", state, button_defs[button].id, esp_err_to_name(err));
+    }
+}
+
 static void play_pause_event_cb(lv_event_t * e) {
     lv_obj_t * btn = lv_event_get_target(e);
     lv_obj_t * label = lv_obj_get_child(btn, 0);
     if (is_playing) {
         lv_label_set_text(label, "Stop");
         is_playing = false;
-        mqtt_manager_publish_button_event(MQTT_BUTTON_MEDIA_PLAY, "stop");
+        publish_button_event(BUTTON_MEDIA_PLAY, "stop");
     } else {
         lv_label_set_text(label, "Play");
         is_playing = true;
-        mqtt_manager_publish_button_event(MQTT_BUTTON_MEDIA_PLAY, "play");
+        publish_button_event(BUTTON_MEDIA_PLAY, "play");
     }
 }
 
 static void action_button_event_cb(lv_event_t * e)
 {
-    const char *button_id = (const char *)lv_event_get_user_data(e);
-    if (button_id) {
-        mqtt_manager_publish_button_event(button_id, "pressed");
-    }
+    button_id_t button = (button_id_t)(intptr_t)lv_event_get_user_data(e);
+    publish_button_event(button, "pressed");
 }
 
 static void connect_button_event_cb(lv_event_t * e)
@@ -412,14 +692,14 @@ static void connect_button_event_cb(lv_event_t * e)
         creds.password[WIFI_MANAGER_MAX_PASSWORD_LEN] = '\0';
     }
     if (creds.ssid[0] == '\0') {
-        enqueue_ui_event(UI_EVENT_WIFI_STATUS, "SSID is required", 0);
+        enqueue_ui_event(UI_EVENT_WIFI_STATUS, "SSID is required");
         return;
     }
+    // Reconnects with the new credentials
     if (wifi_manager_set_credentials(&creds, true) == ESP_OK) {
-        enqueue_ui_event(UI_EVENT_WIFI_STATUS, "Connecting...", 0);
-        wifi_manager_connect();
+        enqueue_ui_event(UI_EVENT_WIFI_STATUS, "Connecting...");
     } else {
-        enqueue_ui_event(UI_EVENT_WIFI_STATUS, "Invalid credentials", 0);
+        enqueue_ui_event(UI_EVENT_WIFI_STATUS, "Invalid credentials");
     }
 }
 
@@ -472,26 +752,184 @@ static void app_wifi_event_handler(wifi_manager_event_t event, void *ctx, const
         break;
     }
     if (message[0] != '\0') {
-        enqueue_ui_event(UI_EVENT_WIFI_STATUS, message, 0);
+        enqueue_ui_event(UI_EVENT_WIFI_STATUS, message);
+    }
+}
+
+/* Text payload of the senders not publishing telemetry frames yet */
+static void mqtt_temp_out_handler(mqtt_router_view_t topic, mqtt_router_view_t payload, void *ctx)
+{
+    (void)topic;
+    (void)ctx;
+    uint16_t trace_id = trace_new_id();
+    trace_point(trace_id, TRACE_STAGE_MQTT_RX);
+    metrics_manager_add(METRIC_MQTT_RX, 1);
+    char text[16];
+    size_t len = payload.len < sizeof(text) - 1 ? payload.len : sizeof(text) - 1;
+    memcpy(text, payload.ptr, len);
+    text[len] = '\0';
+    telemetry_value_t value = {
+        .signal = TELEMETRY_SIGNAL_TEMP_OUT,
+        .type = TELEMETRY_TYPE_F32,
+        .f32 = strtof(text, NULL),
+    };
+    __atomic_store_n(&telemetry_trace_ids[TELEMETRY_SIGNAL_TEMP_OUT], trace_id, __ATOMIC_RELAXED);
+    telemetry_store_put(&value, &telemetry_store);
+    trace_point(trace_id, TRACE_STAGE_DECODED);
+}
+
+static void set_telemetry_trace_id(const telemetry_value_t *value, void *ctx)
+{
+    if (value->signal < TELEMETRY_MAX_SIGNALS) {
+        __atomic_store_n(&telemetry_trace_ids[value->signal], *(const uint16_t *)ctx, __ATOMIC_RELAXED);
     }
 }
 
-static void mqtt_message_handler(const char *topic, const char *payload, void *ctx)
+/* Decoded in place from the client's buffer */
+static void mqtt_telemetry_handler(mqtt_router_view_t topic, mqtt_router_view_t payload, void *ctx)
 {
     (void)topic;
     (void)ctx;
-    const char *text = payload ? payload : "";
-    enqueue_ui_event(UI_EVENT_TEMP_OUT, text, 0);
-    float value = strtof(text, NULL);
-    enqueue_ui_event(UI_EVENT_TEMPERATURE, NULL, value);
+    uint16_t trace_id = trace_new_id();
+    trace_point(trace_id, TRACE_STAGE_MQTT_RX);
+    metrics_manager_add(METRIC_MQTT_RX, 1);
+    // The frame's signals carry its trace id to the labels. A few bytes, so scanned twice.
+    telemetry_decode(payload.ptr, payload.len, NULL, set_telemetry_trace_id, &trace_id);
+    if (!telemetry_store_decode(&telemetry_store, payload.ptr, payload.len)) {
+        ESP_LOGW(TAG, "Invalid telemetry frame of %u bytes", (unsigned)payload.len);
+        return;
+    }
+    trace_point(trace_id, TRACE_STAGE_DECODED);
+}
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} trace_json_buf_t;
+
+static bool write_trace_serial(const char *data, size_t len, void *ctx)
+{
+    (void)ctx;
+    return fwrite(data, 1, len, stdout) == len;
+}
+
+static bool write_trace_buf(const char *data, size_t len, void *ctx)
+{
+    trace_json_buf_t *json = ctx;
+    if (json->size - json->len < len) {
+        return false;
+    }
+    memcpy(&json->buf[json->len], data, len);
+    json->len += len;
+    return true;
+}
+
+/* Export the trace rings as Chrome trace JSON, to the console with the payload
+ * "serial", published otherwise. Open it in Perfetto or chrome://tracing. */
+static void mqtt_trace_dump_handler(mqtt_router_view_t topic, mqtt_router_view_t payload, void *ctx)
+{
+    (void)topic;
+    (void)ctx;
+    if (payload.len == strlen("serial") && memcmp(payload.ptr, "serial", payload.len) == 0) {
+        trace_export_json(trace_stage_names, TRACE_STAGE_CNT, write_trace_serial, NULL);
+        fflush(stdout);
+        return;
+    }
+    trace_json_buf_t json = {
+        .buf = heap_caps_malloc(TRACE_JSON_BUF_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT),
+        .size = TRACE_JSON_BUF_SIZE,
+    };
+    if (!json.buf) {
+        ESP_LOGW(TAG, "No memory for the trace");
+        return;
+    }
+    if (trace_export_json(trace_stage_names, TRACE_STAGE_CNT, write_trace_buf, &json)) {
+        esp_err_t err = mqtt_manager_publish(MQTT_TOPIC_TRACE_JSON, json.buf, json.len, 0);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Trace not published: %s", esp_err_to_name(err));
+        }
+    } else {
+        ESP_LOGW(TAG, "Trace longer than %u bytes", (unsigned)TRACE_JSON_BUF_SIZE);
+    }
+    heap_caps_free(json.buf);
+}
+
+static bool send_mirror(const uint8_t *data, size_t len, void *ctx)
+{
+    (void)ctx;
+    // QoS0: a lost message is followed by a key frame, resending an old one would be late anyway
+    return mqtt_manager_publish(MQTT_TOPIC_MIRROR, data, len, 0) == ESP_OK;
+}
+
+/* Mirror the screen to MQTT_TOPIC_MIRROR with the payload "on", until "off".
+ * "key" sends the whole screen again for a viewer joining. */
+static void mqtt_mirror_ctl_handler(mqtt_router_view_t topic, mqtt_router_view_t payload, void *ctx)
+{
+    (void)topic;
+    (void)ctx;
+    if (payload.len == strlen("on") && memcmp(payload.ptr, "on", payload.len) == 0) {
+        mirror_manager_start();
+    } else if (payload.len == strlen("off") && memcmp(payload.ptr, "off", payload.len) == 0) {
+        mirror_manager_stop();
+        mirror_manager_stat_t stat;
+        mirror_manager_get_stat(&stat);
+        ESP_LOGI(TAG, "Mirror: %u frames, %u skipped, %u of %u bytes sent, capture %u us max, encode %u us max",
+                 (unsigned)stat.mirror.frame_cnt, (unsigned)stat.mirror.skipped_cnt,
+                 (unsigned)stat.mirror.sent_bytes, (unsigned)stat.mirror.raw_bytes,
+                 (unsigned)stat.capture_us_max, (unsigned)stat.encode_us_max);
+    } else if (payload.len == strlen("key") && memcmp(payload.ptr, "key", payload.len) == 0) {
+        mirror_manager_request_key();
+    }
 }
 
 static void mqtt_status_handler(bool connected, void *ctx)
 {
     (void)ctx;
-    enqueue_ui_event(UI_EVENT_MQTT_STATUS,
-                     connected ? "MQTT connected" : "MQTT disconnected",
-                     0);
+    mqtt_manager_connect_stat_t connect;
+    mqtt_manager_get_connect_stat(&connect);
+    if (connected) {
+        ESP_LOGI(TAG, "MQTT connect #%u: %u ms (%u ms max), handshake %u ms, %u sessions kept, %u TLS tickets",
+                 (unsigned)connect.connect_cnt, (unsigned)connect.last_reconnect_ms,
+                 (unsigned)connect.max_reconnect_ms, (unsigned)connect.last_handshake_ms,
+                 (unsigned)connect.session_present_cnt, (unsigned)connect.tls_ticket_cnt);
+    } else {
+        ESP_LOGI(TAG, "MQTT first message after the last reconnect: %u ms", (unsigned)connect.last_first_msg_ms);
+        const telemetry_stat_t *telemetry = &telemetry_store.stat;
+        ESP_LOGI(TAG, "Telemetry: %u frames, %u values, %u invalid, %u lost",
+                 (unsigned)telemetry->frame_cnt, (unsigned)telemetry->value_cnt,
+                 (unsigned)telemetry->invalid_cnt, (unsigned)telemetry->lost_cnt);
+        mqtt_manager_publish_stat_t stat;
+        mqtt_manager_get_publish_stat(&stat);
+        ESP_LOGI(TAG, "MQTT publishes: %u sent, %u coalesced, %u dropped",
+                 (unsigned)stat.sent_cnt, (unsigned)stat.coalesced_cnt, (unsigned)stat.dropped_cnt);
+        mqtt_manager_outbox_stat_t outbox;
+        mqtt_manager_get_outbox_stat(&outbox);
+        ESP_LOGI(TAG, "MQTT outbox: %u delivered in %u ms avg, %u ms max, %u waiting, %u dropped",
+                 (unsigned)outbox.delivered_cnt, (unsigned)outbox.latency_avg, (unsigned)outbox.latency_max,
+                 (unsigned)(outbox.queued_cnt + outbox.in_flight_cnt), (unsigned)outbox.dropped_cnt);
+    }
+    enqueue_ui_event(UI_EVENT_MQTT_STATUS, connected ? "MQTT connected" : "MQTT disconnected");
+}
+
+static void mqtt_rtt_handler(uint32_t rtt_ms, void *ctx)
+{
+    (void)ctx;
+    metrics_manager_record(METRIC_MQTT_RTT_MS, rtt_ms);
+}
+
+/* Gauges of the ending metrics window */
+static void sample_metrics(void *ctx)
+{
+    (void)ctx;
+    metrics_manager_set(METRIC_HEAP_INTERNAL, (int32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    metrics_manager_set(METRIC_HEAP_INTERNAL_MIN, (int32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    metrics_manager_set(METRIC_HEAP_PSRAM, (int32_t)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    metrics_manager_set(METRIC_HEAP_DMA, (int32_t)heap_caps_get_free_size(MALLOC_CAP_DMA));
+    metrics_manager_set(METRIC_UI_QUEUE, ui_event_queue ? (int32_t)uxQueueMessagesWaiting(ui_event_queue) : 0);
+    mqtt_manager_outbox_stat_t outbox;
+    mqtt_manager_get_outbox_stat(&outbox);
+    metrics_manager_set(METRIC_MQTT_OUTBOX, (int32_t)(outbox.queued_cnt + outbox.in_flight_cnt));
 }
 
 static void publish_squareline_temperature(int position)
@@ -509,7 +947,7 @@ static void publish_squareline_temperature(int position)
             snprintf(payload, sizeof(payload), "%d.%d", temp_tenths / 10, temp_tenths % 10);
         }
     }
-    mqtt_manager_publish_button_event(MQTT_BUTTON_HVAC_TEMP_SET, payload);
+    publish_button_event(BUTTON_HVAC_TEMP_SET, payload);
 }
 
 static void squareline_temp_event_cb(lv_event_t * e)
@@ -521,23 +959,10 @@ static void squareline_temp_event_cb(lv_event_t * e)
     publish_squareline_temperature(lv_arc_get_value(slider));
 }
 
-void app_main(void)
+static esp_err_t boot_panel_stage(void *ctx)
 {
+    (void)ctx;
     READ_LCD_ID = read_lcd_id();
-    ui_event_queue = xQueueCreate(10, sizeof(ui_event_t));
-    assert(ui_event_queue);
-
-    ESP_ERROR_CHECK(wifi_manager_init(NULL));
-    ESP_ERROR_CHECK(wifi_manager_register_event_handler(app_wifi_event_handler, NULL));
-    mqtt_manager_config_t mqtt_cfg = { 0 };
-    strlcpy(mqtt_cfg.temperature_sub_topic, "TempOut", sizeof(mqtt_cfg.temperature_sub_topic));
-    ESP_ERROR_CHECK(mqtt_manager_init(&mqtt_cfg,
-                                      mqtt_message_handler,
-                                      NULL,
-                                      mqtt_status_handler,
-                                      NULL));
-    static lv_disp_draw_buf_t disp_buf; // contains internal graphic buffer(s) called draw buffer(s)
-    static lv_disp_drv_t disp_drv;      // contains callback functions
 
 #if EXAMPLE_PIN_NUM_BK_LIGHT >= 0
     ESP_LOGI(TAG, "Turn off LCD backlight");
@@ -570,7 +995,6 @@ void app_main(void)
     // Attach the LCD to the SPI bus
     ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)LCD_HOST, &io_config, &io_handle));
 
-    esp_lcd_panel_handle_t panel_handle = NULL;
     const esp_lcd_panel_dev_config_t panel_config = {
         .reset_gpio_num = EXAMPLE_PIN_NUM_LCD_RST,
         .rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB,
@@ -586,13 +1010,16 @@ void app_main(void)
     // user can flush pre-defined pattern to the screen before we turn on the screen or backlight
     ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel_handle, true));
 
-    Touch_Init(); //Touch initialization
-
 #if EXAMPLE_PIN_NUM_BK_LIGHT >= 0
     ESP_LOGI(TAG, "Turn on LCD backlight");
     gpio_set_level(EXAMPLE_PIN_NUM_BK_LIGHT, EXAMPLE_LCD_BK_LIGHT_ON_LEVEL);
 #endif
+    return ESP_OK;
+}
 
+static esp_err_t boot_lvgl_stage(void *ctx)
+{
+    (void)ctx;
     ESP_LOGI(TAG, "Initialize LVGL library");
     lv_init();
     // alloc draw buffers used by LVGL
@@ -623,6 +1050,9 @@ void app_main(void)
     disp_drv.ver_res = EXAMPLE_LCD_V_RES;
     disp_drv.flush_cb = example_lvgl_flush_cb;
     disp_drv.rounder_cb = example_lvgl_rounder_cb;
+    disp_drv.render_start_cb = example_lvgl_render_start_cb;
+    disp_drv.wait_cb = example_lvgl_wait_cb;
+    disp_drv.monitor_cb = example_lvgl_monitor_cb;
     disp_drv.draw_buf = &disp_buf;
     disp_drv.user_data = panel_handle;
 #ifdef EXAMPLE_Rotate_90
@@ -643,33 +1073,59 @@ void app_main(void)
     ESP_ERROR_CHECK(esp_timer_create(&lvgl_tick_timer_args, &lvgl_tick_timer));
     ESP_ERROR_CHECK(esp_timer_start_periodic(lvgl_tick_timer, EXAMPLE_LVGL_TICK_PERIOD_MS * 1000));
 
-    static lv_indev_drv_t indev_drv;    // Input device driver (Touch)
-    lv_indev_drv_init(&indev_drv);
-    indev_drv.type = LV_INDEV_TYPE_POINTER;
-    indev_drv.disp = disp;
-    indev_drv.read_cb = example_lvgl_touch_cb;
-    lv_indev_drv_register(&indev_drv);
-
-
     lvgl_mux = xSemaphoreCreateMutex();
     assert(lvgl_mux);
     xTaskCreate(example_lvgl_port_task, "LVGL", EXAMPLE_LVGL_TASK_STACK_SIZE, NULL, EXAMPLE_LVGL_TASK_PRIORITY, NULL);
+    return ESP_OK;
+}
 
+static esp_err_t boot_first_frame_stage(void *ctx)
+{
+    (void)ctx;
+    ESP_LOGI(TAG, "Display splash screen");
+    // Lock the mutex due to the LVGL APIs are not thread-safe
+    if (!example_lvgl_lock(-1)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (!ui_Screen4) {
+        ui_Screen4_screen_init();
+    }
+    splash_screen = ui_Screen4;
+    if (splash_screen) {
+#if LV_USE_RLE
+        lv_rle_reset_stat();
+#endif
+        lv_scr_load(splash_screen);
+        lv_obj_set_style_opa(splash_screen, LV_OPA_TRANSP, LV_PART_MAIN);
+        lv_obj_fade_in(splash_screen, SPLASH_FADE_TIME_MS, 0);
+    }
+    // Flush the first frame now instead of waiting for the LVGL task
+    lv_refr_now(NULL);
+    example_lvgl_unlock();
+    ESP_LOGI(TAG, "First frame at %lld ms", esp_timer_get_time() / 1000);
+    return ESP_OK;
+}
+
+static esp_err_t boot_touch_stage(void *ctx)
+{
+    (void)ctx;
+    Touch_Init(); //Touch initialization
+    return ESP_OK;
+}
+
+static esp_err_t boot_ui_stage(void *ctx)
+{
+    (void)ctx;
     ESP_LOGI(TAG, "Display custom UI");
     // Lock the mutex due to the LVGL APIs are not thread-safe
     if (example_lvgl_lock(-1)) {
-        
-        bool splash_loaded = false;
-        if (!ui_Screen4) {
-            ui_Screen4_screen_init();
-        }
-        splash_screen = ui_Screen4;
-        if (splash_screen) {
-            lv_scr_load(splash_screen);
-            lv_obj_set_style_opa(splash_screen, LV_OPA_TRANSP, LV_PART_MAIN);
-            lv_obj_fade_in(splash_screen, SPLASH_FADE_TIME_MS, 0);
-            splash_loaded = true;
-        }
+        static lv_indev_drv_t indev_drv;    // Input device driver (Touch)
+        lv_indev_drv_init(&indev_drv);
+        indev_drv.type = LV_INDEV_TYPE_POINTER;
+        indev_drv.disp = lv_disp_get_default();
+        indev_drv.read_cb = example_lvgl_touch_cb;
+        touch_indev = lv_indev_drv_register(&indev_drv);
+
         // Create screens for swipe navigation while splash is visible
         scr1 = lv_obj_create(NULL); // First screen
         scr2 = lv_obj_create(NULL); // Second screen (steering wheel style)
@@ -678,10 +1134,16 @@ void app_main(void)
         scr_squareline = ui_Screen2;
         if (ui_TempSlider) {
             lv_obj_add_event_cb(ui_TempSlider, squareline_temp_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+            // Keep horizontal drags on the arc for the arc instead of swiping the screen
+            lv_obj_clear_flag(ui_TempSlider, LV_OBJ_FLAG_GESTURE_BUBBLE);
             publish_squareline_temperature(lv_arc_get_value(ui_TempSlider));
         }
 
-        registered_screen_count = 0;
+        // Screens follow the finger while swiping between them
+        screen_pager = lv_pager_create(touch_indev);
+        if (screen_pager) {
+            lv_pager_set_change_cb(screen_pager, pager_change_cb);
+        }
         if (scr_squareline) {
             register_screen(scr_squareline);
         }
@@ -738,7 +1200,7 @@ void app_main(void)
         lv_label_set_text(label_top1, "Volume +");
         lv_obj_center(label_top1);
         lv_obj_set_style_text_font(label_top1, &lv_font_montserrat_16, 0);
-        lv_obj_add_event_cb(btn_top1, action_button_event_cb, LV_EVENT_CLICKED, (void *)MQTT_BUTTON_MEDIA_VOLUME_UP);
+        lv_obj_add_event_cb(btn_top1, action_button_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)BUTTON_MEDIA_VOLUME_UP);
 
         // Bottom button: Volume -
         lv_obj_t * btn_bottom1 = lv_btn_create(scr1);
@@ -748,7 +1210,7 @@ void app_main(void)
         lv_label_set_text(label_bottom1, "Volume -");
         lv_obj_center(label_bottom1);
         lv_obj_set_style_text_font(label_bottom1, &lv_font_montserrat_16, 0);
-        lv_obj_add_event_cb(btn_bottom1, action_button_event_cb, LV_EVENT_CLICKED, (void *)MQTT_BUTTON_MEDIA_VOLUME_DOWN);
+        lv_obj_add_event_cb(btn_bottom1, action_button_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)BUTTON_MEDIA_VOLUME_DOWN);
 
         // Left button: <<
         lv_obj_t * btn_left1 = lv_btn_create(scr1);
@@ -758,7 +1220,7 @@ void app_main(void)
         lv_label_set_text(label_left1, "<<");
         lv_obj_center(label_left1);
         lv_obj_set_style_text_font(label_left1, &lv_font_montserrat_16, 0);
-        lv_obj_add_event_cb(btn_left1, action_button_event_cb, LV_EVENT_CLICKED, (void *)MQTT_BUTTON_MEDIA_PREV);
+        lv_obj_add_event_cb(btn_left1, action_button_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)BUTTON_MEDIA_PREV);
 
         // Right button: >>
         lv_obj_t * btn_right1 = lv_btn_create(scr1);
@@ -768,7 +1230,7 @@ void app_main(void)
         lv_label_set_text(label_right1, ">>");
         lv_obj_center(label_right1);
         lv_obj_set_style_text_font(label_right1, &lv_font_montserrat_16, 0);
-        lv_obj_add_event_cb(btn_right1, action_button_event_cb, LV_EVENT_CLICKED, (void *)MQTT_BUTTON_MEDIA_NEXT);
+        lv_obj_add_event_cb(btn_right1, action_button_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)BUTTON_MEDIA_NEXT);
 
         // Second screen: Steering wheel style
         // Center button for temperature
@@ -776,6 +1238,7 @@ void app_main(void)
         lv_obj_set_size(btn_center2, 120, 80);
         lv_obj_align(btn_center2, LV_ALIGN_CENTER, 0, 0);
         lv_obj_t * label_center2 = lv_label_create(btn_center2);
+        lv_label_set_text_capacity(label_center2, UI_TEMP_LABEL_CAPACITY);
         lv_label_set_text(label_center2, "--");
         lv_obj_center(label_center2);
         lv_obj_set_style_text_font(label_center2, &lv_font_montserrat_16, 0);
@@ -789,7 +1252,7 @@ void app_main(void)
         lv_label_set_text(label_top2, "+");
         lv_obj_center(label_top2);
         lv_obj_set_style_text_font(label_top2, &lv_font_montserrat_16, 0);
-        lv_obj_add_event_cb(btn_top2, action_button_event_cb, LV_EVENT_CLICKED, (void *)MQTT_BUTTON_HVAC_TEMP_UP);
+        lv_obj_add_event_cb(btn_top2, action_button_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)BUTTON_HVAC_TEMP_UP);
 
         // Bottom button: -
         lv_obj_t * btn_bottom2 = lv_btn_create(scr2);
@@ -799,7 +1262,7 @@ void app_main(void)
         lv_label_set_text(label_bottom2, "-");
         lv_obj_center(label_bottom2);
         lv_obj_set_style_text_font(label_bottom2, &lv_font_montserrat_16, 0);
-        lv_obj_add_event_cb(btn_bottom2, action_button_event_cb, LV_EVENT_CLICKED, (void *)MQTT_BUTTON_HVAC_TEMP_DOWN);
+        lv_obj_add_event_cb(btn_bottom2, action_button_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)BUTTON_HVAC_TEMP_DOWN);
 
         // Right button: Intensity
         lv_obj_t * btn_right2 = lv_btn_create(scr2);
@@ -809,7 +1272,7 @@ void app_main(void)
         lv_label_set_text(label_right2, "Intensity");
         lv_obj_center(label_right2);
         lv_obj_set_style_text_font(label_right2, &lv_font_montserrat_16, 0);
-        lv_obj_add_event_cb(btn_right2, action_button_event_cb, LV_EVENT_CLICKED, (void *)MQTT_BUTTON_HVAC_INTENSITY);
+        lv_obj_add_event_cb(btn_right2, action_button_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)BUTTON_HVAC_INTENSITY);
 
         // Left button: (I) power
         lv_obj_t * btn_left2 = lv_btn_create(scr2);
@@ -819,7 +1282,7 @@ void app_main(void)
         lv_label_set_text(label_left2, "(I)");
         lv_obj_center(label_left2);
         lv_obj_set_style_text_font(label_left2, &lv_font_montserrat_16, 0);
-        lv_obj_add_event_cb(btn_left2, action_button_event_cb, LV_EVENT_CLICKED, (void *)MQTT_BUTTON_HVAC_POWER);
+        lv_obj_add_event_cb(btn_left2, action_button_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)BUTTON_HVAC_POWER);
 
         // Third screen: Wi-Fi & MQTT settings
         lv_obj_t * settings_title = lv_label_create(scr_settings);
@@ -887,7 +1350,7 @@ void app_main(void)
 
         // Load splash screen first, then transition to main UI
         current_screen = scr_squareline ? scr_squareline : scr1;
-        if (splash_screen && splash_loaded) {
+        if (splash_screen) {
             if (splash_timer) {
                 lv_timer_del(splash_timer);
                 splash_timer = NULL;
@@ -905,4 +1368,123 @@ void app_main(void)
         // Release the mutex
         example_lvgl_unlock();
     }
+    return ESP_OK;
+}
+
+static esp_err_t boot_nvs_stage(void *ctx)
+{
+    (void)ctx;
+    return wifi_manager_nvs_init();
+}
+
+static esp_err_t boot_wifi_stage(void *ctx)
+{
+    (void)ctx;
+    esp_err_t err = wifi_manager_init(NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return wifi_manager_register_event_handler(app_wifi_event_handler, NULL);
+}
+
+/* The button topics and the outbox don't need the network: presses made before
+ * Wi-Fi is up, or when it never comes up, wait in the outbox.
+ * Never fails, as the UI waits for it and has to come up without MQTT too. */
+static esp_err_t boot_mqtt_init_stage(void *ctx)
+{
+    (void)ctx;
+    esp_err_t err = mqtt_manager_init(NULL, mqtt_status_handler, NULL);
+    if (err == ESP_OK) {
+        mqtt_manager_set_rtt_cb(mqtt_rtt_handler, NULL);
+    }
+    for (int i = 0; i < BUTTON_CNT && err == ESP_OK; ++i) {
+        err = mqtt_manager_add_button_topic(button_defs[i].id, button_defs[i].min_interval_ms, &buttons[i]);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Buttons won't be published: %s", esp_err_to_name(err));
+    }
+    return ESP_OK;
+}
+
+static esp_err_t boot_mqtt_stage(void *ctx)
+{
+    (void)ctx;
+    esp_err_t err = mqtt_manager_subscribe(MQTT_TOPIC_TEMP_OUT, 1, mqtt_temp_out_handler, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = mqtt_manager_subscribe(MQTT_TOPIC_TELEMETRY, 1, mqtt_telemetry_handler, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = mqtt_manager_subscribe(MQTT_TOPIC_TRACE_DUMP, 0, mqtt_trace_dump_handler, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // The flushed areas are in the panel's orientation, after the rotation
+    const mirror_manager_config_t mirror_config = {
+        .width = EXAMPLE_LCD_H_RES,
+        .height = EXAMPLE_LCD_V_RES,
+#if LV_COLOR_16_SWAP
+        .flags = MIRROR_FLAG_SWAPPED,
+#endif
+        .send_cb = send_mirror,
+    };
+    err = mirror_manager_init(&mirror_config);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = mqtt_manager_subscribe(MQTT_TOPIC_MIRROR_CTL, 1, mqtt_mirror_ctl_handler, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+    const metrics_manager_config_t metrics_config = {
+        .defs = metric_defs,
+        .cnt = METRIC_CNT,
+        .topic = MQTT_TOPIC_METRICS,
+        .sample_cb = sample_metrics,
+    };
+    return metrics_manager_init(&metrics_config);
+}
+
+static uint64_t trace_now(void)
+{
+    return (uint64_t)esp_timer_get_time();
+}
+
+static uint32_t trace_core(void)
+{
+    return (uint32_t)esp_cpu_get_core_id();
+}
+
+void app_main(void)
+{
+    ui_event_queue = xQueueCreate(10, sizeof(ui_event_t));
+    assert(ui_event_queue);
+    telemetry_store_init(&telemetry_store);
+    trace_init(trace_now, trace_core);
+
+    // The splash is drawn as soon as the panel and LVGL are up.
+    // NVS, Wi-Fi and MQTT come up in parallel with the display.
+    // The UI publishes from its first frame, so it waits for the button topics but not for Wi-Fi.
+    static boot_manager_stage_t boot_stages[BOOT_STAGE_CNT] = {
+        [BOOT_STAGE_PANEL] = { .name = "panel", .fn = boot_panel_stage },
+        [BOOT_STAGE_LVGL] = { .name = "lvgl", .fn = boot_lvgl_stage,
+                              .deps = BOOT_STAGE_BIT(BOOT_STAGE_PANEL) },
+        [BOOT_STAGE_FIRST_FRAME] = { .name = "first frame", .fn = boot_first_frame_stage,
+                                     .deps = BOOT_STAGE_BIT(BOOT_STAGE_LVGL) },
+        [BOOT_STAGE_TOUCH] = { .name = "touch", .fn = boot_touch_stage },
+        [BOOT_STAGE_NVS] = { .name = "nvs", .fn = boot_nvs_stage },
+        [BOOT_STAGE_MQTT_INIT] = { .name = "mqtt init", .fn = boot_mqtt_init_stage },
+        [BOOT_STAGE_UI] = { .name = "ui", .fn = boot_ui_stage,
+                            .deps = BOOT_STAGE_BIT(BOOT_STAGE_FIRST_FRAME) | BOOT_STAGE_BIT(BOOT_STAGE_TOUCH) |
+                                    BOOT_STAGE_BIT(BOOT_STAGE_NVS) | BOOT_STAGE_BIT(BOOT_STAGE_MQTT_INIT) },
+        [BOOT_STAGE_WIFI] = { .name = "wifi", .fn = boot_wifi_stage,
+                              .deps = BOOT_STAGE_BIT(BOOT_STAGE_NVS) },
+        [BOOT_STAGE_MQTT] = { .name = "mqtt", .fn = boot_mqtt_stage,
+                              .deps = BOOT_STAGE_BIT(BOOT_STAGE_WIFI) },
+    };
+    if (boot_manager_run(boot_stages, BOOT_STAGE_CNT) != ESP_OK) {
+        ESP_LOGE(TAG, "Boot finished with errors, see the boot timeline");
+    }
 }
@@ -20,13 +20,11 @@ static void temp_slider_update_label(int position)
     }
 
     int temp_tenths = UI_TEMP_MIN_TENTHS + position * UI_TEMP_STEP_TENTHS;
-    char buf[8];
     if (temp_tenths % 10 == 0) {
-        lv_snprintf(buf, sizeof(buf), "%d°", temp_tenths / 10);
+        lv_label_set_text_fmt(ui_TempIn, "%d°", temp_tenths / 10);
     } else {
-        lv_snprintf(buf, sizeof(buf), "%d.%d°", temp_tenths / 10, temp_tenths % 10);
+        lv_label_set_text_fmt(ui_TempIn, "%d.%d°", temp_tenths / 10, temp_tenths % 10);
     }
-    lv_label_set_text(ui_TempIn, buf);
 }
 
 static void temp_slider_event_cb(lv_event_t * e)
@@ -59,6 +57,7 @@ lv_arc_set_value(ui_TempSlider, (UI_TEMP_DEFAULT_TENTHS - UI_TEMP_MIN_TENTHS) /
 lv_obj_add_event_cb(ui_TempSlider, temp_slider_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
 
 ui_TempIn = lv_label_create(ui_Screen2);
+lv_label_set_text_capacity(ui_TempIn, UI_TEMP_LABEL_CAPACITY);
 lv_obj_set_width( ui_TempIn, LV_SIZE_CONTENT);  /// 1
 lv_obj_set_height( ui_TempIn, LV_SIZE_CONTENT);   /// 1
 lv_obj_set_align( ui_TempIn, LV_ALIGN_CENTER );
@@ -79,6 +78,7 @@ lv_obj_set_style_text_opa(ui_Outside, 255, LV_PART_MAIN| LV_STATE_DEFAULT);
 lv_obj_set_style_text_font(ui_Outside, &ui_font_FontLarge, LV_PART_MAIN| LV_STATE_DEFAULT);
 
 ui_TempOut = lv_label_create(ui_Screen2);
+lv_label_set_text_capacity(ui_TempOut, UI_TEMP_LABEL_CAPACITY);
 lv_obj_set_width( ui_TempOut, LV_SIZE_CONTENT);  /// 1
 lv_obj_set_height( ui_TempOut, LV_SIZE_CONTENT);   /// 1
 lv_obj_set_x( ui_TempOut, 7 );
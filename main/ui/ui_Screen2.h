@@ -16,6 +16,7 @@ extern "C" {
 #define UI_TEMP_STEP_TENTHS  5    // 0.5°C steps
 #define UI_TEMP_ARC_STEPS    ((UI_TEMP_MAX_TENTHS - UI_TEMP_MIN_TENTHS) / UI_TEMP_STEP_TENTHS)
 #define UI_TEMP_DEFAULT_TENTHS 210 // 21.0°C
+#define UI_TEMP_LABEL_CAPACITY 16  // Bytes of the fixed text buffer of the temperature labels
 
 // SCREEN: ui_Screen2
 extern void ui_Screen2_screen_init(void);